@@ -23,41 +23,38 @@
 #include <memory>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <algorithm>
 #include <poll.h>
 #include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
 
 namespace md = mir::dispatch;
 
+namespace
+{
 class TestDispatchable : public md::Dispatchable
 {
 public:
-    TestDispatchable(uint64_t limit)
-        : dispatch_limit{limit}
+    TestDispatchable(std::atomic<int64_t>& remaining)
+        : remaining{remaining},
+          fd{eventfd(1, EFD_CLOEXEC)}
     {
-        int pipefds[2];
-        if (pipe(pipefds) < 0)
-        {
-            throw std::system_error{errno, std::system_category(), "Failed to create pipe"};
-        }
-
-        read_fd = mir::Fd{pipefds[0]};
-        write_fd = mir::Fd{pipefds[1]};
-
-        char dummy{0};
-        if (::write(write_fd, &dummy, sizeof(dummy)) != sizeof(dummy))
+        // The eventfd counter is never read, so it stays readable until the source is removed
+        if (fd == mir::Fd::invalid)
         {
-            throw std::system_error{errno, std::system_category(), "Failed to mark dispatchable"};
+            throw std::system_error{errno, std::system_category(), "Failed to create eventfd"};
         }
     }
 
     mir::Fd watch_fd() const override
     {
-        return read_fd;
+        return fd;
     }
     bool dispatch(md::FdEvents) override
     {
-        ++dispatch_count;
-        return (dispatch_count < dispatch_limit);
+        return remaining.fetch_sub(1) > 1;
     }
     md::FdEvents relevant_events() const override
     {
@@ -65,13 +62,10 @@ public:
     }
 
 private:
-    static thread_local uint64_t dispatch_count;
-    uint64_t const dispatch_limit;
-    mir::Fd read_fd, write_fd;
+    std::atomic<int64_t>& remaining;
+    mir::Fd const fd;
 };
 
-thread_local uint64_t TestDispatchable::dispatch_count = 0;
-
 bool fd_is_readable(int fd)
 {
     struct pollfd poller {
@@ -82,19 +76,27 @@ bool fd_is_readable(int fd)
     return poll(&poller, 1, 0);
 }
 
-int main(int argc, char** argv)
+void raise_fd_limit(int source_count)
 {
-    if (argc != 3)
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < static_cast<rlim_t>(source_count) + 64)
     {
-        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count>"<<std::endl;
-        exit(1);
+        limit.rlim_cur = std::min(limit.rlim_max, static_cast<rlim_t>(source_count) + 64);
+        setrlimit(RLIMIT_NOFILE, &limit);
     }
+}
 
-    int const thread_count = std::atoi(argv[1]);
-    uint64_t const dispatch_count = std::atoll(argv[2]);
+void run(int thread_count, uint64_t dispatch_count, int source_count)
+{
+    raise_fd_limit(source_count);
+
+    std::atomic<int64_t> remaining{static_cast<int64_t>(dispatch_count)};
 
     auto dispatcher = std::make_shared<md::MultiplexingDispatchable>();
-    dispatcher->add_watch(std::make_shared<TestDispatchable>(dispatch_count / thread_count), md::DispatchReentrancy::reentrant);
+    for (int i = 0; i < source_count; ++i)
+    {
+        dispatcher->add_watch(std::make_shared<TestDispatchable>(remaining), md::DispatchReentrancy::reentrant);
+    }
 
     auto start = std::chrono::steady_clock::now();
 
@@ -116,6 +118,35 @@ int main(int argc, char** argv)
     }
 
     auto duration = std::chrono::steady_clock::now() - start;
-    std::cout<<"Dispatching "<<dispatch_count<<" times took "<<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()<<"ns"<<std::endl;
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    std::cout<<"Dispatching "<<dispatch_count<<" times across "<<source_count<<" sources took "<<ns<<"ns ("
+             <<static_cast<double>(ns)/dispatch_count<<"ns per dispatch)"<<std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count> [<number of sources>]"<<std::endl;
+        std::cout<<"    Without a source count, runs with 1, 10, 100 and 1000 sources"<<std::endl;
+        exit(1);
+    }
+
+    int const thread_count = std::atoi(argv[1]);
+    uint64_t const dispatch_count = std::atoll(argv[2]);
+
+    if (argc == 4)
+    {
+        run(thread_count, dispatch_count, std::atoi(argv[3]));
+    }
+    else
+    {
+        for (int const source_count : {1, 10, 100, 1000})
+        {
+            run(thread_count, dispatch_count, source_count);
+        }
+    }
+
     exit(0);
 }
@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/thread/basic_thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace mt = mir::thread;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Several threads hammer the pool with short tasks, each pinned to one of a
+// handful of ids, and wait for them all to finish.
+void stress(int submitter_count, int tasks_per_submitter)
+{
+    mt::BasicThreadPool pool{1};
+    std::atomic<int> executed{0};
+    int ids[4];
+
+    auto const start = Clock::now();
+
+    std::vector<std::thread> submitters;
+    for (int s = 0; s < submitter_count; ++s)
+    {
+        submitters.emplace_back([&, s]
+        {
+            std::vector<std::future<void>> futures;
+            futures.reserve(tasks_per_submitter);
+            for (int i = 0; i < tasks_per_submitter; ++i)
+            {
+                futures.push_back(pool.run([&]{ ++executed; }, &ids[(s + i) % 4]));
+            }
+            for (auto& future : futures)
+                future.wait();
+        });
+    }
+
+    for (auto& submitter : submitters)
+        submitter.join();
+
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    std::cout<<"stress: "<<executed<<" tasks from "<<submitter_count<<" threads took "<<ns<<"ns ("
+             <<static_cast<double>(ns)/executed<<"ns per task)"<<std::endl;
+}
+
+// Measures the time from run() to the task starting while a long running
+// pinned task (like a compositing loop) occupies one of the workers.
+void latency(int samples)
+{
+    mt::BasicThreadPool pool{2};
+    std::atomic<bool> stop{false};
+    int const long_running_id{0};
+
+    auto long_running = pool.run([&]{ while (!stop) std::this_thread::yield(); }, &long_running_id);
+
+    std::vector<std::chrono::nanoseconds> delays;
+    delays.reserve(samples);
+
+    for (int i = 0; i < samples; ++i)
+    {
+        Clock::time_point started;
+        auto const submitted = Clock::now();
+        pool.run([&]{ started = Clock::now(); }).wait();
+        delays.push_back(started - submitted);
+    }
+
+    stop = true;
+    long_running.wait();
+
+    std::sort(delays.begin(), delays.end());
+    auto const percentile = [&](int p) { return delays[(delays.size() - 1) * p / 100].count(); };
+
+    std::cout<<"latency: "<<samples<<" samples, p50 "<<percentile(50)<<"ns, p90 "<<percentile(90)
+             <<"ns, p99 "<<percentile(99)<<"ns, max "<<delays.back().count()<<"ns"<<std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of submitting threads> <tasks per thread>"<<std::endl;
+        exit(1);
+    }
+
+    int const submitter_count = std::atoi(argv[1]);
+    int const tasks_per_submitter = std::atoi(argv[2]);
+
+    stress(submitter_count, tasks_per_submitter);
+    latency(tasks_per_submitter);
+
+    exit(0);
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "options.h"
+
+#include <sstream>
+
+namespace mb = mir::benchmark;
+
+auto mb::parse_size(std::string const& size, int& width, int& height) -> bool
+{
+    char x{0};
+    std::istringstream in{size};
+    return (in >> width >> x >> height) && x == 'x' && width > 0 && height > 0;
+}
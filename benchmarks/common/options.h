@@ -0,0 +1,31 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_COMMON_OPTIONS_H_
+#define MIR_BENCHMARKS_COMMON_OPTIONS_H_
+
+#include <string>
+
+namespace mir
+{
+namespace benchmark
+{
+/// Parses a "<width>x<height>" option value; both must be positive
+auto parse_size(std::string const& size, int& width, int& height) -> bool;
+}
+}
+
+#endif // MIR_BENCHMARKS_COMMON_OPTIONS_H_
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_buffers.h"
+
+#include "mir/fd.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <wayland-client.h>
+
+#include <system_error>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mb = mir::benchmark;
+
+namespace
+{
+auto create_shm_file(size_t size) -> mir::Fd
+{
+    char path[] = "/dev/shm/mir-benchmark-XXXXXX";
+    mir::Fd fd{mkostemp(path, O_CLOEXEC)};
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create shm file"}));
+    unlink(path);
+
+    if (auto const error = posix_fallocate(fd, 0, size))
+        BOOST_THROW_EXCEPTION((std::system_error{error, std::system_category(), "Failed to allocate shm buffer"}));
+
+    return fd;
+}
+}
+
+mb::ShmBuffers::ShmBuffers(wl_shm* shm, int width, int height, uint32_t format, int count)
+    : count{count},
+      buffers{new Buffer[count]}
+{
+    static wl_buffer_listener const buffer_listener{&released};
+
+    auto const stride = width * 4;
+    auto const buffer_size = static_cast<size_t>(stride) * height;
+    content_size = buffer_size * count;
+
+    auto const fd = create_shm_file(content_size);
+    content = mmap(nullptr, content_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (content == MAP_FAILED)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to map shm buffer"}));
+
+    auto const pool = wl_shm_create_pool(shm, fd, content_size);
+    for (auto b = 0; b != count; ++b)
+    {
+        auto& buffer = buffers[b];
+        buffer.buffer = wl_shm_pool_create_buffer(pool, b * buffer_size, width, height, stride, format);
+        buffer.pixels = reinterpret_cast<uint32_t*>(static_cast<char*>(content) + b * buffer_size);
+        wl_buffer_add_listener(buffer.buffer, &buffer_listener, &buffer);
+    }
+    wl_shm_pool_destroy(pool);
+}
+
+mb::ShmBuffers::~ShmBuffers()
+{
+    for (auto b = 0; b != count; ++b)
+        wl_buffer_destroy(buffers[b].buffer);
+    munmap(content, content_size);
+}
+
+auto mb::ShmBuffers::free_buffer() -> Buffer*
+{
+    for (auto b = 0; b != count; ++b)
+    {
+        if (!buffers[b].busy)
+            return &buffers[b];
+    }
+    return nullptr;
+}
+
+void mb::ShmBuffers::released(void* data, wl_buffer*)
+{
+    static_cast<Buffer*>(data)->busy = false;
+}
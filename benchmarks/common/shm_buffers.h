@@ -0,0 +1,66 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_COMMON_SHM_BUFFERS_H_
+#define MIR_BENCHMARKS_COMMON_SHM_BUFFERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct wl_buffer;
+struct wl_shm;
+
+namespace mir
+{
+namespace benchmark
+{
+/**
+ * A surface's wl_shm buffers: \a count buffers of one size and format, in a
+ * shared memory file of their own, each knowing whether the server holds it.
+ */
+class ShmBuffers
+{
+public:
+    struct Buffer
+    {
+        wl_buffer* buffer{nullptr};
+        uint32_t* pixels{nullptr};
+        /// Attached and not yet released by the server
+        bool busy{false};
+    };
+
+    ShmBuffers(wl_shm* shm, int width, int height, uint32_t format, int count = 2);
+    ~ShmBuffers();
+
+    /// A buffer the server doesn't hold, or nullptr if it holds them all
+    auto free_buffer() -> Buffer*;
+
+private:
+    ShmBuffers(ShmBuffers const&) = delete;
+    ShmBuffers& operator=(ShmBuffers const&) = delete;
+
+    static void released(void* data, wl_buffer*);
+
+    int const count;
+    std::unique_ptr<Buffer[]> const buffers;
+    void* content;
+    size_t content_size;
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_COMMON_SHM_BUFFERS_H_
@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_COMMON_WAYLAND_GLOBALS_H_
+#define MIR_BENCHMARKS_COMMON_WAYLAND_GLOBALS_H_
+
+#include <wayland-client.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace mir
+{
+namespace benchmark
+{
+/**
+ * Binds \a proxy to a global the registry announces, if it is of \a wanted
+ * and \a proxy isn't bound yet. Binds \a version, or the server's version if
+ * that is older.
+ * \return whether \a proxy was bound
+ */
+template<typename Proxy>
+auto bind_global(
+    Proxy*& proxy,
+    wl_interface const& wanted,
+    uint32_t version,
+    wl_registry* registry,
+    uint32_t name,
+    char const* interface,
+    uint32_t server_version) -> bool
+{
+    if (proxy || strcmp(interface, wanted.name) != 0)
+        return false;
+
+    proxy = static_cast<Proxy*>(wl_registry_bind(registry, name, &wanted, std::min(version, server_version)));
+    return true;
+}
+}
+}
+
+#endif // MIR_BENCHMARKS_COMMON_WAYLAND_GLOBALS_H_
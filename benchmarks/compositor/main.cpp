@@ -0,0 +1,366 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Boots the server on the offscreen display, loads it with wl_shm clients
+ * and internal clients, and reports what compositing cost as JSON:
+ *
+ *   mir_compositor_benchmark --offscreen-outputs=1920x1080,1920x1080 \
+ *       --shm-clients=4 --surfaces-per-client=2 --surface-size=800x600 \
+ *       --update-rate=60 --overlap=0.5 --transparent --duration=10
+ *
+ * Rendering uses whatever EGL the graphics platform provides; set
+ * LIBGL_ALWAYS_SOFTWARE=0 to not force llvmpipe.
+ */
+
+#include "options.h"
+#include "shm_client.h"
+#include "timing_compositor.h"
+
+#include <miral/command_line_option.h>
+#include <miral/display_configuration_option.h>
+#include <miral/internal_client.h>
+#include <miral/minimal_window_manager.h>
+#include <miral/output.h>
+#include <miral/runner.h>
+#include <miral/set_window_management_policy.h>
+#include <miral/window_specification.h>
+
+#include <mir/geometry/rectangles.h>
+#include <mir/server.h>
+
+#include <wayland-client.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace mb = mir::benchmark;
+namespace geom = mir::geometry;
+using namespace std::chrono;
+
+namespace
+{
+struct Config
+{
+    int shm_clients{1};
+    int surfaces_per_client{4};
+    int internal_surfaces{0};
+    mb::SurfaceLoad load{512, 512, false, 60};
+    double overlap{0.5};
+    double warmup{2};
+    double duration{10};
+};
+
+/// Tiles new windows over the outputs, each overlapping the last by the configured fraction
+class BenchmarkWindowManager : public miral::MinimalWindowManager
+{
+public:
+    BenchmarkWindowManager(miral::WindowManagerTools const& tools, Config const& config)
+        : MinimalWindowManager{tools},
+          config{config}
+    {
+    }
+
+    auto place_new_window(miral::ApplicationInfo const& app_info, miral::WindowSpecification const& requested)
+        -> miral::WindowSpecification override
+    {
+        auto spec = MinimalWindowManager::place_new_window(app_info, requested);
+
+        auto const area = outputs.bounding_rectangle();
+        auto const width = config.load.width;
+        auto const height = config.load.height;
+        auto const step_x = static_cast<int>(width * (1 - config.overlap));
+        auto const step_y = static_cast<int>(height * (1 - config.overlap));
+        auto const columns = step_x > 0 ? std::max(1, (area.size.width.as_int() - width) / step_x + 1) : 1;
+        auto const rows = step_y > 0 ? std::max(1, (area.size.height.as_int() - height) / step_y + 1) : 1;
+
+        auto const column = placed % columns;
+        auto const row = (placed / columns) % rows;
+        ++placed;
+
+        spec.top_left() = area.top_left + geom::Displacement{column * step_x, row * step_y};
+        spec.size() = geom::Size{width, height};
+        return spec;
+    }
+
+    void advise_output_create(miral::Output const& output) override
+    {
+        outputs.add(output.extents());
+    }
+
+private:
+    Config const& config;
+    geom::Rectangles outputs;
+    int placed{0};
+};
+
+struct OutputResult
+{
+    std::string name;
+    std::vector<mb::FrameSample> frames;
+};
+
+auto percentile(std::vector<double> values, int p) -> double
+{
+    if (values.empty())
+        return 0;
+
+    std::sort(values.begin(), values.end());
+    return values[(values.size() - 1) * p / 100];
+}
+
+auto ms(nanoseconds t) -> double
+{
+    return duration<double, std::milli>(t).count();
+}
+
+void write_distribution(std::ostream& out, std::vector<double> const& values)
+{
+    out << "{\"p50\": " << percentile(values, 50)
+        << ", \"p90\": " << percentile(values, 90)
+        << ", \"p99\": " << percentile(values, 99)
+        << ", \"max\": " << percentile(values, 100) << "}";
+}
+
+auto process_cpu_time() -> nanoseconds
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return seconds{usage.ru_utime.tv_sec + usage.ru_stime.tv_sec} +
+           microseconds{usage.ru_utime.tv_usec + usage.ru_stime.tv_usec};
+}
+
+auto client_cpu_time(std::vector<mb::ShmClient*> const& clients) -> nanoseconds
+{
+    nanoseconds total{0};
+    for (auto const& client : clients)
+        total += client->cpu_time();
+    return total;
+}
+}
+
+int main(int argc, char const* argv[])
+{
+    // Render with llvmpipe unless told otherwise
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    std::vector<char const*> args{argv, argv + argc};
+    args.insert(args.begin() + 1, "--offscreen");
+    if (std::none_of(argv + 1, argv + argc,
+        [](char const* arg) { return strncmp(arg, "--offscreen-outputs", strlen("--offscreen-outputs")) == 0; }))
+    {
+        args.insert(args.begin() + 1, "--offscreen-outputs=1920x1080");
+    }
+
+    Config config;
+    std::shared_ptr<mb::TimingCompositorFactory> timing;
+
+    miral::MirRunner runner{static_cast<int>(args.size()), args.data()};
+
+    mb::ShmClient internal_client;
+    std::vector<std::unique_ptr<mb::ShmClient>> shm_clients;
+
+    std::vector<std::thread> client_threads;
+    std::thread controller;
+
+    std::vector<OutputResult> results;
+    uint64_t updates_submitted{0};
+    uint64_t updates_skipped{0};
+    nanoseconds server_cpu{0};
+    std::atomic<bool> failed{false};
+
+    auto const run_client = [&](mb::ShmClient& client, wl_display* display, int surfaces)
+        {
+            try
+            {
+                client.run(display, config.load, surfaces);
+            }
+            catch (std::exception const& error)
+            {
+                std::cerr << "Client failed: " << error.what() << std::endl;
+                failed = true;
+            }
+        };
+
+    auto const measure = [&]
+        {
+            auto const wayland_display = runner.wayland_display();
+            if (!wayland_display.is_set())
+            {
+                std::cerr << "Server has no Wayland endpoint" << std::endl;
+                failed = true;
+                runner.stop();
+                return;
+            }
+
+            for (auto i = 0; i != config.shm_clients; ++i)
+                shm_clients.push_back(std::make_unique<mb::ShmClient>());
+
+            std::vector<mb::ShmClient*> clients{&internal_client};
+            for (auto const& client : shm_clients)
+            {
+                clients.push_back(client.get());
+                client_threads.emplace_back([&, client = client.get(), name = wayland_display.value()]
+                    {
+                        if (auto const display = wl_display_connect(name.c_str()))
+                        {
+                            run_client(*client, display, config.surfaces_per_client);
+                            wl_display_disconnect(display);
+                        }
+                        else
+                        {
+                            std::cerr << "Failed to connect to " << name << std::endl;
+                            failed = true;
+                        }
+                    });
+            }
+
+            std::this_thread::sleep_for(duration<double>{config.warmup});
+
+            timing->reset();
+            for (auto const& client : clients)
+                client->reset_counts();
+            auto const process_cpu_before = process_cpu_time();
+            auto const client_cpu_before = client_cpu_time(clients);
+
+            std::this_thread::sleep_for(duration<double>{config.duration});
+
+            for (auto const& output : timing->samples())
+                results.push_back({output.first, output.second});
+            for (auto const& client : clients)
+            {
+                updates_submitted += client->updates_submitted();
+                updates_skipped += client->updates_skipped();
+            }
+            server_cpu = (process_cpu_time() - process_cpu_before) - (client_cpu_time(clients) - client_cpu_before);
+
+            for (auto const& client : clients)
+                client->stop();
+            for (auto& thread : client_threads)
+                thread.join();
+
+            runner.stop();
+        };
+
+    runner.add_start_callback([&] { controller = std::thread{measure}; });
+
+    auto const exit_code = runner.run_with(
+        {
+            [&](mir::Server& server)
+            {
+                server.wrap_display_buffer_compositor_factory(
+                    [&](std::shared_ptr<mir::compositor::DisplayBufferCompositorFactory> const& wrapped)
+                    {
+                        return timing = std::make_shared<mb::TimingCompositorFactory>(wrapped);
+                    });
+            },
+            miral::display_configuration_options,
+            miral::set_window_management_policy<BenchmarkWindowManager>(config),
+            miral::StartupInternalClient{
+                [&](wl_display* display) { run_client(internal_client, display, config.internal_surfaces); },
+                [](std::weak_ptr<mir::scene::Session> const&) {}},
+            miral::CommandLineOption{[&](int value) { config.shm_clients = value; },
+                "shm-clients", "Number of wl_shm clients", config.shm_clients},
+            miral::CommandLineOption{[&](int value) { config.surfaces_per_client = value; },
+                "surfaces-per-client", "Number of surfaces each wl_shm client shows", config.surfaces_per_client},
+            miral::CommandLineOption{[&](int value) { config.internal_surfaces = value; },
+                "internal-surfaces", "Number of surfaces shown by an internal client", config.internal_surfaces},
+            miral::CommandLineOption{[&](std::string const& value)
+                {
+                    if (!mb::parse_size(value, config.load.width, config.load.height))
+                        throw std::runtime_error{"Invalid --surface-size: " + value};
+                },
+                "surface-size", "Size of every surface, <width>x<height>", "512x512"},
+            miral::CommandLineOption{[&](double value) { config.load.updates_per_second = value; },
+                "update-rate", "Updates per second of every surface (0 for static surfaces)",
+                config.load.updates_per_second},
+            miral::CommandLineOption{[&](bool value) { config.load.transparent = value; },
+                "transparent", "Surfaces have a translucent alpha channel", config.load.transparent},
+            miral::CommandLineOption{[&](double value) { config.overlap = std::min(std::max(value, 0.0), 1.0); },
+                "overlap", "Fraction of each surface that the next covers [0, 1]", config.overlap},
+            miral::CommandLineOption{[&](double value) { config.warmup = value; },
+                "warmup", "Seconds to run before measuring", config.warmup},
+            miral::CommandLineOption{[&](double value) { config.duration = value; },
+                "duration", "Seconds to measure for", config.duration},
+        });
+
+    if (controller.joinable())
+        controller.join();
+
+    if (exit_code != EXIT_SUCCESS || failed)
+        return EXIT_FAILURE;
+
+    uint64_t total_frames{0};
+    for (auto const& output : results)
+        total_frames += output.frames.size();
+
+    std::ostringstream json;
+    json.imbue(std::locale::classic());
+    json << std::fixed << std::setprecision(3);
+
+    json << "{\n  \"config\": {"
+         << "\"shm_clients\": " << config.shm_clients
+         << ", \"surfaces_per_client\": " << config.surfaces_per_client
+         << ", \"internal_surfaces\": " << config.internal_surfaces
+         << ", \"surface_width\": " << config.load.width
+         << ", \"surface_height\": " << config.load.height
+         << ", \"update_rate\": " << config.load.updates_per_second
+         << ", \"transparent\": " << (config.load.transparent ? "true" : "false")
+         << ", \"overlap\": " << config.overlap
+         << ", \"duration_s\": " << config.duration << "},\n";
+
+    json << "  \"outputs\": [";
+    for (auto const& output : results)
+    {
+        std::vector<double> wall, cpu, allocations;
+        for (auto const& frame : output.frames)
+        {
+            wall.push_back(ms(frame.wall_time));
+            cpu.push_back(ms(frame.cpu_time));
+            allocations.push_back(frame.allocations);
+        }
+
+        json << (&output == &results.front() ? "\n" : ",\n")
+             << "    {\"name\": \"" << output.name << "\""
+             << ", \"frames\": " << output.frames.size()
+             << ", \"fps\": " << output.frames.size() / config.duration
+             << ",\n     \"frame_time_ms\": ";
+        write_distribution(json, wall);
+        json << ",\n     \"cpu_time_ms\": ";
+        write_distribution(json, cpu);
+        json << ",\n     \"allocations_per_frame\": ";
+        write_distribution(json, allocations);
+        json << "}";
+    }
+    json << "\n  ],\n";
+
+    json << "  \"server_cpu_ms_per_frame\": " << (total_frames ? ms(server_cpu) / total_frames : 0.0) << ",\n"
+         << "  \"updates_submitted\": " << updates_submitted << ",\n"
+         << "  \"updates_skipped\": " << updates_skipped << "\n}\n";
+
+    std::cout << json.str();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_client.h"
+#include "shm_buffers.h"
+#include "wayland_globals.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <wayland-client.h>
+
+#include <algorithm>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace mb = mir::benchmark;
+
+namespace
+{
+auto create_stop_event() -> mir::Fd
+{
+    mir::Fd fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)};
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create stop event"}));
+    return fd;
+}
+
+auto create_update_timer(double updates_per_second) -> mir::Fd
+{
+    mir::Fd fd{timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)};
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create update timer"}));
+
+    if (updates_per_second > 0)
+    {
+        auto const nsec = static_cast<long long>(1e9 / updates_per_second);
+        timespec const period{static_cast<time_t>(nsec / 1000000000), static_cast<long>(nsec % 1000000000)};
+        itimerspec const spec{period, period};
+        if (timerfd_settime(fd, 0, &spec, nullptr) < 0)
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to set update timer"}));
+    }
+
+    return fd;
+}
+}
+
+struct mb::ShmClient::Globals
+{
+    wl_compositor* compositor{nullptr};
+    wl_shm* shm{nullptr};
+    wl_shell* shell{nullptr};
+
+    static void new_global(void* data, wl_registry* registry, uint32_t id, char const* interface, uint32_t version)
+    {
+        auto const self = static_cast<Globals*>(data);
+
+        bind_global(self->compositor, wl_compositor_interface, 3, registry, id, interface, version);
+        bind_global(self->shm, wl_shm_interface, 1, registry, id, interface, version);
+        bind_global(self->shell, wl_shell_interface, 1, registry, id, interface, version);
+    }
+
+    static void global_removed(void*, wl_registry*, uint32_t)
+    {
+    }
+};
+
+struct mb::ShmClient::Surface
+{
+    SurfaceLoad load;
+    wl_surface* surface{nullptr};
+    wl_shell_surface* shell_surface{nullptr};
+    std::unique_ptr<ShmBuffers> buffers;
+    uint32_t frame{0};
+
+    static void ping(void*, wl_shell_surface* shell_surface, uint32_t serial)
+    {
+        wl_shell_surface_pong(shell_surface, serial);
+    }
+
+    static void configure(void*, wl_shell_surface*, uint32_t, int32_t, int32_t)
+    {
+    }
+
+    static void popup_done(void*, wl_shell_surface*)
+    {
+    }
+};
+
+mb::ShmClient::ShmClient()
+    : stop_event{create_stop_event()}
+{
+}
+
+mb::ShmClient::~ShmClient() = default;
+
+void mb::ShmClient::stop()
+{
+    uint64_t const one{1};
+    if (write(stop_event, &one, sizeof one) != sizeof one)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to stop client"}));
+}
+
+void mb::ShmClient::reset_counts()
+{
+    submitted = 0;
+    skipped = 0;
+}
+
+void mb::ShmClient::run(wl_display* display, SurfaceLoad const& load, int surface_count)
+{
+    static wl_registry_listener const registry_listener{&Globals::new_global, &Globals::global_removed};
+    static wl_shell_surface_listener const shell_surface_listener{
+        &Surface::ping, &Surface::configure, &Surface::popup_done};
+
+    Globals globals;
+    auto const registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &registry_listener, &globals);
+    wl_display_roundtrip(display);
+
+    if (!globals.compositor || !globals.shm || !globals.shell)
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Server lacks wl_compositor, wl_shm or wl_shell"});
+
+    auto const format = load.transparent ? WL_SHM_FORMAT_ARGB8888 : WL_SHM_FORMAT_XRGB8888;
+
+    std::vector<std::unique_ptr<Surface>> surfaces;
+    for (auto i = 0; i != surface_count; ++i)
+    {
+        auto surface = std::make_unique<Surface>();
+        surface->load = load;
+        surface->buffers = std::make_unique<ShmBuffers>(globals.shm, load.width, load.height, format);
+
+        surface->surface = wl_compositor_create_surface(globals.compositor);
+        surface->shell_surface = wl_shell_get_shell_surface(globals.shell, surface->surface);
+        wl_shell_surface_add_listener(surface->shell_surface, &shell_surface_listener, surface.get());
+        wl_shell_surface_set_toplevel(surface->shell_surface);
+
+        update(*surface);
+        surfaces.push_back(std::move(surface));
+    }
+
+    auto const timer = create_update_timer(load.updates_per_second);
+
+    enum { display_fd, timer_fd, stop_fd };
+    pollfd fds[] = {
+        {wl_display_get_fd(display), POLLIN, 0},
+        {timer, POLLIN, 0},
+        {stop_event, POLLIN, 0}};
+
+    for (;;)
+    {
+        while (wl_display_prepare_read(display) != 0)
+            wl_display_dispatch_pending(display);
+        wl_display_flush(display);
+
+        if (poll(fds, sizeof fds / sizeof fds[0], -1) < 0 && errno != EINTR)
+        {
+            wl_display_cancel_read(display);
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to wait for events"}));
+        }
+
+        if (fds[display_fd].revents & POLLIN)
+            wl_display_read_events(display);
+        else
+            wl_display_cancel_read(display);
+
+        wl_display_dispatch_pending(display);
+
+        if (fds[stop_fd].revents & POLLIN)
+            break;
+
+        if (fds[timer_fd].revents & POLLIN)
+        {
+            uint64_t expirations;
+            if (read(timer, &expirations, sizeof expirations) == sizeof expirations)
+            {
+                for (auto const& surface : surfaces)
+                    update(*surface);
+            }
+        }
+
+        timespec cpu;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+        cpu_ns = static_cast<int64_t>(cpu.tv_sec) * 1000000000 + cpu.tv_nsec;
+    }
+
+    for (auto const& surface : surfaces)
+    {
+        wl_shell_surface_destroy(surface->shell_surface);
+        wl_surface_destroy(surface->surface);
+        surface->buffers.reset();
+    }
+
+    wl_shell_destroy(globals.shell);
+    wl_shm_destroy(globals.shm);
+    wl_compositor_destroy(globals.compositor);
+    wl_registry_destroy(registry);
+    wl_display_roundtrip(display);
+}
+
+void mb::ShmClient::update(Surface& surface)
+{
+    auto const buffer = surface.buffers->free_buffer();
+    if (!buffer)
+    {
+        ++skipped;
+        return;
+    }
+
+    // A new colour every frame, so that every update changes every pixel.
+    // Transparent surfaces are half opaque (and premultiplied)
+    auto const shade = static_cast<uint8_t>(surface.frame++ * 8);
+    uint32_t const pixel = surface.load.transparent ?
+        0x80000000u | ((shade / 2u) << 16) | (0x40u << 8) | (0x7fu - shade / 2u) :
+        0xff000000u | (uint32_t{shade} << 16) | (0x80u << 8) | (0xffu - shade);
+    std::fill(buffer->pixels, buffer->pixels + surface.load.width * surface.load.height, pixel);
+
+    buffer->busy = true;
+    wl_surface_attach(surface.surface, buffer->buffer, 0, 0);
+    wl_surface_damage(surface.surface, 0, 0, surface.load.width, surface.load.height);
+    wl_surface_commit(surface.surface);
+    ++submitted;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_COMPOSITOR_SHM_CLIENT_H_
+#define MIR_BENCHMARKS_COMPOSITOR_SHM_CLIENT_H_
+
+#include "mir/fd.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+struct wl_display;
+
+namespace mir
+{
+namespace benchmark
+{
+struct SurfaceLoad
+{
+    int width;
+    int height;
+    bool transparent;
+    /// Zero means draw once and never update
+    double updates_per_second;
+};
+
+/// A Wayland client that shows some wl_shm surfaces and redraws them at a fixed rate
+class ShmClient
+{
+public:
+    ShmClient();
+    ~ShmClient();
+
+    /// Shows \a surface_count surfaces on \a display until stop() is called
+    void run(wl_display* display, SurfaceLoad const& load, int surface_count);
+    void stop();
+
+    /// Buffers committed to the server
+    auto updates_submitted() const -> uint64_t { return submitted; }
+    /// Updates not drawn because the server still held every buffer of the surface
+    auto updates_skipped() const -> uint64_t { return skipped; }
+    void reset_counts();
+    /// CPU time used by the thread running the client
+    auto cpu_time() const -> std::chrono::nanoseconds { return std::chrono::nanoseconds{cpu_ns}; }
+
+private:
+    struct Globals;
+    struct Surface;
+
+    void update(Surface& surface);
+
+    Fd const stop_event;
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<int64_t> cpu_ns{0};
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_COMPOSITOR_SHM_CLIENT_H_
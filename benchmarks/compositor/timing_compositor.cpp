@@ -0,0 +1,149 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timing_compositor.h"
+
+#include "mir/compositor/display_buffer_compositor.h"
+#include "mir/graphics/display_buffer.h"
+
+#include <cstdlib>
+#include <new>
+
+#include <time.h>
+
+namespace mb = mir::benchmark;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+
+namespace
+{
+thread_local uint64_t allocations{0};
+
+auto thread_cpu_time() -> std::chrono::nanoseconds
+{
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds{now.tv_sec} + std::chrono::nanoseconds{now.tv_nsec};
+}
+
+auto name_of(mir::geometry::Rectangle const& area) -> std::string
+{
+    return std::to_string(area.size.width.as_int()) + "x" + std::to_string(area.size.height.as_int()) +
+           "+" + std::to_string(area.top_left.x.as_int()) + "+" + std::to_string(area.top_left.y.as_int());
+}
+}
+
+// Count every allocation made through operator new (allocations libraries
+// make with malloc() directly are not seen)
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (auto const p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+auto mb::thread_allocation_count() -> uint64_t
+{
+    return allocations;
+}
+
+class mb::TimingCompositorFactory::Compositor : public mc::DisplayBufferCompositor
+{
+public:
+    Compositor(
+        std::unique_ptr<mc::DisplayBufferCompositor> wrapped,
+        TimingCompositorFactory& factory,
+        std::string const& output)
+        : wrapped{std::move(wrapped)},
+          factory{factory},
+          output{output}
+    {
+    }
+
+    void composite(mc::SceneElementSequence&& scene_sequence) override
+    {
+        auto const allocations_before = allocations;
+        auto const cpu_before = thread_cpu_time();
+        auto const wall_before = std::chrono::steady_clock::now();
+
+        wrapped->composite(std::move(scene_sequence));
+
+        FrameSample const sample{
+            std::chrono::steady_clock::now() - wall_before,
+            thread_cpu_time() - cpu_before,
+            allocations - allocations_before};
+
+        std::lock_guard<std::mutex> lock{factory.mutex};
+        factory.frames[output].push_back(sample);
+    }
+
+private:
+    std::unique_ptr<mc::DisplayBufferCompositor> const wrapped;
+    TimingCompositorFactory& factory;
+    std::string const output;
+};
+
+mb::TimingCompositorFactory::TimingCompositorFactory(
+    std::shared_ptr<mc::DisplayBufferCompositorFactory> const& wrapped)
+    : wrapped{wrapped}
+{
+}
+
+auto mb::TimingCompositorFactory::create_compositor_for(mg::DisplayBuffer& display_buffer)
+    -> std::unique_ptr<mc::DisplayBufferCompositor>
+{
+    return std::make_unique<Compositor>(
+        wrapped->create_compositor_for(display_buffer), *this, name_of(display_buffer.view_area()));
+}
+
+void mb::TimingCompositorFactory::reset()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    for (auto& output : frames)
+        output.second.clear();
+}
+
+auto mb::TimingCompositorFactory::samples() const -> std::map<std::string, std::vector<FrameSample>>
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return frames;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_COMPOSITOR_TIMING_COMPOSITOR_H_
+#define MIR_BENCHMARKS_COMPOSITOR_TIMING_COMPOSITOR_H_
+
+#include "mir/compositor/display_buffer_compositor_factory.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace benchmark
+{
+/// What it cost to composite one frame of one output
+struct FrameSample
+{
+    std::chrono::nanoseconds wall_time;
+    /// CPU time of the compositing thread (llvmpipe's rendering threads are not included)
+    std::chrono::nanoseconds cpu_time;
+    /// Calls to operator new made by the compositing thread
+    uint64_t allocations;
+};
+
+/// Operator new calls made so far by the calling thread
+auto thread_allocation_count() -> uint64_t;
+
+/**
+ * Wraps the server's DisplayBufferCompositorFactory to measure every
+ * composite() call, keyed by output.
+ */
+class TimingCompositorFactory : public compositor::DisplayBufferCompositorFactory
+{
+public:
+    explicit TimingCompositorFactory(std::shared_ptr<compositor::DisplayBufferCompositorFactory> const& wrapped);
+
+    auto create_compositor_for(graphics::DisplayBuffer& display_buffer)
+        -> std::unique_ptr<compositor::DisplayBufferCompositor> override;
+
+    /// Discard the samples taken so far
+    void reset();
+
+    /// The samples taken since reset(), keyed by output (e.g. "1920x1080+0+0")
+    auto samples() const -> std::map<std::string, std::vector<FrameSample>>;
+
+private:
+    class Compositor;
+
+    std::shared_ptr<compositor::DisplayBufferCompositorFactory> const wrapped;
+
+    std::mutex mutable mutex;
+    std::map<std::string, std::vector<FrameSample>> frames;
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_COMPOSITOR_TIMING_COMPOSITOR_H_
@@ -0,0 +1,144 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene_layout.h"
+
+#include "mir/events/event_builders.h"
+#include "mir/events/event.h"
+
+namespace mb = mir::benchmark;
+namespace mev = mir::events;
+
+namespace
+{
+MirInputDeviceId const device_id{1};
+std::vector<uint8_t> const no_cookie;
+
+/// Touch events carry at most 16 contacts
+void touch_counts(benchmark::internal::Benchmark* b)
+{
+    b->RangeMultiplier(2)->Range(1, 16);
+}
+
+auto pointer_motion(int n) -> mir::EventUPtr
+{
+    auto const position = mb::window_placement(n).top_left;
+    return mev::make_event(
+        device_id, std::chrono::nanoseconds{n}, no_cookie,
+        mir_input_event_modifier_none, mir_pointer_action_motion, 0,
+        position.x.as_int(), position.y.as_int(),
+        0, 0, 1, 1);
+}
+
+auto key_press(int n) -> mir::EventUPtr
+{
+    return mev::make_event(
+        device_id, std::chrono::nanoseconds{n}, no_cookie,
+        mir_keyboard_action_down, 0, 30 + n % 26, mir_input_event_modifier_none);
+}
+
+auto touch(int contacts) -> mir::EventUPtr
+{
+    auto event = mev::make_event(device_id, std::chrono::nanoseconds{0}, no_cookie, mir_input_event_modifier_none);
+
+    for (auto i = 0; i != contacts; ++i)
+    {
+        auto const position = mb::window_placement(i).top_left;
+        mev::add_touch(
+            *event, i, mir_touch_action_change, mir_touch_tooltype_finger,
+            position.x.as_int(), position.y.as_int(), 1, 10, 10, 10);
+    }
+
+    return event;
+}
+
+// The argument is the number of events built, as for one frame's worth of
+// input across a scene with that many windows
+void BM_make_pointer_events(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        for (auto i = 0; i != state.range(0); ++i)
+            benchmark::DoNotOptimize(pointer_motion(i));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_make_key_events(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        for (auto i = 0; i != state.range(0); ++i)
+            benchmark::DoNotOptimize(key_press(i));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_clone_pointer_events(benchmark::State& state)
+{
+    auto const event = pointer_motion(0);
+
+    for (auto _ : state)
+    {
+        for (auto i = 0; i != state.range(0); ++i)
+            benchmark::DoNotOptimize(mev::clone_event(*event));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_make_touch_event(benchmark::State& state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(touch(state.range(0)));
+}
+
+void BM_clone_touch_event(benchmark::State& state)
+{
+    auto const event = touch(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(mev::clone_event(*event));
+}
+
+void BM_serialize_touch_event(benchmark::State& state)
+{
+    auto const event = touch(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(MirEvent::serialize(event.get()));
+}
+
+void BM_deserialize_touch_event(benchmark::State& state)
+{
+    auto const bytes = MirEvent::serialize(touch(state.range(0)).get());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(MirEvent::deserialize(bytes));
+
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+}
+
+BENCHMARK(BM_make_pointer_events)->Apply(mb::scene_sizes);
+BENCHMARK(BM_make_key_events)->Apply(mb::scene_sizes);
+BENCHMARK(BM_clone_pointer_events)->Apply(mb::scene_sizes);
+BENCHMARK(BM_make_touch_event)->Apply(touch_counts);
+BENCHMARK(BM_clone_touch_event)->Apply(touch_counts);
+BENCHMARK(BM_serialize_touch_event)->Apply(touch_counts);
+BENCHMARK(BM_deserialize_touch_event)->Apply(touch_counts);
@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene_layout.h"
+
+#include "src/server/compositor/occlusion.h"
+
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_scene_element.h"
+
+namespace mb = mir::benchmark;
+namespace mc = mir::compositor;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+auto make_scene(int windows, float alpha) -> mc::SceneElementSequence
+{
+    mc::SceneElementSequence scene;
+    for (auto i = 0; i != windows; ++i)
+    {
+        scene.push_back(std::make_shared<mtd::StubSceneElement>(
+            std::make_shared<mtd::FakeRenderable>(mb::window_placement(i), alpha)));
+    }
+    return scene;
+}
+
+// The compositor filters a freshly generated sequence each frame, so
+// copying the scene is part of what is measured
+void filter_occlusions(benchmark::State& state, float alpha)
+{
+    auto const scene = make_scene(state.range(0), alpha);
+
+    for (auto _ : state)
+    {
+        auto elements = scene;
+        auto occluded = mc::filter_occlusions_from(elements, mb::output);
+        benchmark::DoNotOptimize(occluded);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_filter_occlusions_opaque(benchmark::State& state)
+{
+    filter_occlusions(state, 1.0f);
+}
+
+void BM_filter_occlusions_translucent(benchmark::State& state)
+{
+    filter_occlusions(state, 0.5f);
+}
+}
+
+BENCHMARK(BM_filter_occlusions_opaque)->Apply(mb::scene_sizes);
+BENCHMARK(BM_filter_occlusions_translucent)->Apply(mb::scene_sizes);
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_conversion.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Size const frame_size{1920, 1080};
+
+/// The kernel sets to compare, as benchmark arguments
+void kernel_sets(benchmark::internal::Benchmark* benchmark)
+{
+    for (auto const kernels : {mg::PixelKernels::scalar, mg::PixelKernels::sse2, mg::PixelKernels::avx2, mg::PixelKernels::neon})
+    {
+        if (mg::available_pixel_kernels(kernels))
+            benchmark->Arg(static_cast<int>(kernels));
+    }
+}
+
+/// Converts a whole frame from \a from to \a to with the kernels given by the benchmark argument
+void convert_frame(benchmark::State& state, MirPixelFormat from, MirPixelFormat to)
+{
+    auto const kernels = static_cast<mg::PixelKernels>(state.range(0));
+    auto const source_stride = frame_size.width.as_int() * MIR_BYTES_PER_PIXEL(from);
+    auto const dest_stride = frame_size.width.as_int() * MIR_BYTES_PER_PIXEL(to);
+    std::vector<unsigned char> const source(source_stride * frame_size.height.as_int(), 0x5a);
+    std::vector<unsigned char> dest(dest_stride * frame_size.height.as_int());
+
+    for (auto _ : state)
+    {
+        mg::convert_pixels(kernels, frame_size, from, source.data(), source_stride, to, dest.data(), dest_stride);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * dest.size());
+}
+
+void BM_convert_abgr_to_argb(benchmark::State& state)
+{
+    convert_frame(state, mir_pixel_format_abgr_8888, mir_pixel_format_argb_8888);
+}
+
+void BM_convert_xrgb_to_argb(benchmark::State& state)
+{
+    convert_frame(state, mir_pixel_format_xrgb_8888, mir_pixel_format_argb_8888);
+}
+
+void BM_convert_xbgr_to_argb(benchmark::State& state)
+{
+    convert_frame(state, mir_pixel_format_xbgr_8888, mir_pixel_format_argb_8888);
+}
+
+void BM_convert_rgb_888_to_abgr(benchmark::State& state)
+{
+    convert_frame(state, mir_pixel_format_rgb_888, mir_pixel_format_abgr_8888);
+}
+
+void BM_convert_bgr_888_to_abgr(benchmark::State& state)
+{
+    convert_frame(state, mir_pixel_format_bgr_888, mir_pixel_format_abgr_8888);
+}
+
+void BM_convert_rgb_565_to_abgr(benchmark::State& state)
+{
+    convert_frame(state, mir_pixel_format_rgb_565, mir_pixel_format_abgr_8888);
+}
+
+void BM_fill_pixels(benchmark::State& state)
+{
+    auto const kernels = static_cast<mg::PixelKernels>(state.range(0));
+    std::vector<uint32_t> pixels(frame_size.width.as_int() * frame_size.height.as_int());
+
+    for (auto _ : state)
+    {
+        mg::fill_pixels(kernels, pixels.data(), pixels.size(), 0xff336699);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * pixels.size() * sizeof(uint32_t));
+}
+}
+
+BENCHMARK(BM_convert_abgr_to_argb)->Apply(kernel_sets);
+BENCHMARK(BM_convert_xrgb_to_argb)->Apply(kernel_sets);
+BENCHMARK(BM_convert_xbgr_to_argb)->Apply(kernel_sets);
+BENCHMARK(BM_convert_rgb_888_to_abgr)->Apply(kernel_sets);
+BENCHMARK(BM_convert_bgr_888_to_abgr)->Apply(kernel_sets);
+BENCHMARK(BM_convert_rgb_565_to_abgr)->Apply(kernel_sets);
+BENCHMARK(BM_fill_pixels)->Apply(kernel_sets);
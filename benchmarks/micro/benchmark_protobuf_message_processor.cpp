@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/protobuf_message_processor.h"
+#include "src/server/report/null_report_factory.h"
+
+#include "mir/frontend/protobuf_message_sender.h"
+#include "mir/protobuf/protocol_version.h"
+#include "mir_protobuf_wire.pb.h"
+
+#include "mir/test/doubles/stub_display_server.h"
+
+#include <benchmark/benchmark.h>
+
+namespace mfd = mir::frontend::detail;
+namespace mr = mir::report;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+/// Serialises responses as the socket sender would, but goes no further
+struct SerialisingSender : mfd::ProtobufMessageSender
+{
+    void send_response(
+        google::protobuf::uint32 /*call_id*/,
+        google::protobuf::MessageLite* message,
+        mir::frontend::FdSets const& /*fd_sets*/) override
+    {
+        message->SerializeToString(&buffer);
+    }
+
+    std::string buffer;
+};
+
+/// Replies straight away to the requests the benchmarks make
+struct RespondingDisplayServer : mtd::StubDisplayServer
+{
+    void connect(
+        mir::protobuf::ConnectParameters const* /*request*/,
+        mir::protobuf::Connection* /*response*/,
+        google::protobuf::Closure* done) override
+    {
+        done->Run();
+    }
+
+    void release_surface(
+        mir::protobuf::SurfaceId const* /*request*/,
+        mir::protobuf::Void* /*response*/,
+        google::protobuf::Closure* done) override
+    {
+        done->Run();
+    }
+
+    void pong(
+        mir::protobuf::PingEvent const* /*request*/,
+        mir::protobuf::Void* /*response*/,
+        google::protobuf::Closure* done) override
+    {
+        done->Run();
+    }
+
+    void set_base_input_configuration(
+        mir::protobuf::InputConfigurationRequest const* /*request*/,
+        mir::protobuf::Void* /*response*/,
+        google::protobuf::Closure* done) override
+    {
+        done->Run();
+    }
+};
+
+auto parameters_for(std::string const& method) -> std::string
+{
+    if (method == "connect")
+    {
+        mir::protobuf::ConnectParameters parameters;
+        parameters.set_application_name("benchmark");
+        return parameters.SerializeAsString();
+    }
+    else if (method == "release_surface")
+    {
+        mir::protobuf::SurfaceId parameters;
+        parameters.set_value(1);
+        return parameters.SerializeAsString();
+    }
+    else if (method == "pong")
+    {
+        mir::protobuf::PingEvent parameters;
+        parameters.set_serial(1);
+        return parameters.SerializeAsString();
+    }
+    else
+    {
+        mir::protobuf::InputConfigurationRequest parameters;
+        parameters.set_input_configuration("");
+        return parameters.SerializeAsString();
+    }
+}
+
+/*
+ * dispatch() finds the handler by comparing the method name against each it
+ * knows in turn, so the cost depends on where the method comes in that list.
+ * The methods benchmarked are the first, two further along and the last.
+ */
+void BM_protobuf_message_processor_dispatch(benchmark::State& state, char const* method)
+{
+    auto const processor = std::make_shared<mfd::ProtobufMessageProcessor>(
+        std::make_shared<SerialisingSender>(),
+        std::make_shared<RespondingDisplayServer>(),
+        mr::null_message_processor_report());
+    mfd::MessageProcessor& message_processor = *processor;
+
+    mir::protobuf::wire::Invocation wire_invocation;
+    wire_invocation.set_method_name(method);
+    wire_invocation.set_parameters(parameters_for(method));
+    wire_invocation.set_protocol_version(mir::protobuf::current_protocol_version());
+    std::vector<mir::Fd> const no_fds;
+
+    google::protobuf::uint32 id{0};
+    for (auto _ : state)
+    {
+        wire_invocation.set_id(++id);
+        benchmark::DoNotOptimize(message_processor.dispatch(mfd::Invocation{wire_invocation}, no_fds));
+    }
+}
+}
+
+BENCHMARK_CAPTURE(BM_protobuf_message_processor_dispatch, connect, "connect");
+BENCHMARK_CAPTURE(BM_protobuf_message_processor_dispatch, release_surface, "release_surface");
+BENCHMARK_CAPTURE(BM_protobuf_message_processor_dispatch, pong, "pong");
+BENCHMARK_CAPTURE(BM_protobuf_message_processor_dispatch, set_base_input_configuration, "set_base_input_configuration");
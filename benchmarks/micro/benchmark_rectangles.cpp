@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene_layout.h"
+
+#include "mir/geometry/rectangles.h"
+
+namespace mb = mir::benchmark;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto make_rectangles(int count) -> geom::Rectangles
+{
+    geom::Rectangles rectangles;
+    for (auto i = 0; i != count; ++i)
+        rectangles.add(mb::window_placement(i));
+    return rectangles;
+}
+
+void BM_rectangles_add_remove(benchmark::State& state)
+{
+    auto rectangles = make_rectangles(state.range(0));
+    geom::Rectangle const extra{{1, 1}, {1, 1}};
+
+    for (auto _ : state)
+    {
+        rectangles.add(extra);
+        rectangles.remove(extra);
+    }
+}
+
+void BM_rectangles_bounding_rectangle(benchmark::State& state)
+{
+    auto const rectangles = make_rectangles(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(rectangles.bounding_rectangle());
+}
+
+// Confining a point outside every rectangle is the worst case (as when
+// the cursor is pushed off the edge of the outputs)
+void BM_rectangles_confine(benchmark::State& state)
+{
+    auto const rectangles = make_rectangles(state.range(0));
+
+    for (auto _ : state)
+    {
+        geom::Point point{5000, 5000};
+        rectangles.confine(point);
+        benchmark::DoNotOptimize(point);
+    }
+}
+
+void BM_rectangle_intersection(benchmark::State& state)
+{
+    auto const rectangles = make_rectangles(state.range(0));
+
+    for (auto _ : state)
+    {
+        for (auto const& rectangle : rectangles)
+            benchmark::DoNotOptimize(rectangle.intersection_with(mb::output));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(BM_rectangles_add_remove)->Apply(mb::scene_sizes);
+BENCHMARK(BM_rectangles_bounding_rectangle)->Apply(mb::scene_sizes);
+BENCHMARK(BM_rectangles_confine)->Apply(mb::scene_sizes);
+BENCHMARK(BM_rectangle_intersection)->Apply(mb::scene_sizes);
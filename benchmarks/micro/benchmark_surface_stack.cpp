@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene_layout.h"
+
+#include "src/server/scene/surface_stack.h"
+#include "src/server/scene/basic_surface.h"
+#include "src/server/input/surface_input_dispatcher.h"
+#include "src/server/report/null_report_factory.h"
+
+#include "mir/events/event_builders.h"
+#include "mir/input/input_reception_mode.h"
+#include "mir/time/steady_clock.h"
+
+#include "mir/test/doubles/stub_buffer_stream.h"
+
+namespace mb = mir::benchmark;
+namespace ms = mir::scene;
+namespace mi = mir::input;
+namespace mev = mir::events;
+namespace mr = mir::report;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+/// A point that lies outside every window, so lookups have to visit the whole stack
+geom::Point const empty_space{1900, 1070};
+
+struct Scene
+{
+    explicit Scene(int windows)
+        : windows{windows}
+    {
+        for (auto i = 0; i != windows; ++i)
+        {
+            auto const surface = std::make_shared<ms::BasicSurface>(
+                nullptr,
+                "window",
+                mb::window_placement(i),
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo>{{std::make_shared<mtd::StubBufferStream>(), {}, {}}},
+                std::shared_ptr<mir::graphics::CursorImage>{},
+                report);
+
+            stack->add_surface(surface, mi::InputReceptionMode::normal);
+        }
+    }
+
+    /// A point inside the topmost window, which lookups should find straight away
+    auto topmost_point() const -> geom::Point
+    {
+        return mb::window_placement(windows - 1).top_left + geom::Displacement{1, 1};
+    }
+
+    int const windows;
+    std::shared_ptr<ms::SceneReport> const report = mr::null_scene_report();
+    std::shared_ptr<ms::SurfaceStack> const stack = std::make_shared<ms::SurfaceStack>(report);
+};
+
+void BM_surface_stack_scene_elements_for(benchmark::State& state)
+{
+    Scene const scene{static_cast<int>(state.range(0))};
+    void const* const compositor_id{&scene};
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scene.stack->scene_elements_for(compositor_id));
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_surface_stack_surface_at_topmost(benchmark::State& state)
+{
+    Scene const scene{static_cast<int>(state.range(0))};
+    auto const point = scene.topmost_point();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scene.stack->surface_at(point));
+}
+
+void BM_surface_stack_surface_at_miss(benchmark::State& state)
+{
+    Scene const scene{static_cast<int>(state.range(0))};
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scene.stack->surface_at(empty_space));
+}
+
+auto pointer_motion(geom::Point const& location) -> std::shared_ptr<MirEvent const>
+{
+    return mev::make_event(
+        MirInputDeviceId{1}, std::chrono::nanoseconds{0}, std::vector<uint8_t>{},
+        mir_input_event_modifier_none, mir_pointer_action_motion, 0,
+        location.x.as_int(), location.y.as_int(),
+        0, 0, 0, 0);
+}
+
+// Moving between a window and empty space each time means every dispatch
+// looks the target up afresh and sends enter or leave events
+void BM_surface_input_dispatcher_pointer_motion(benchmark::State& state)
+{
+    Scene const scene{static_cast<int>(state.range(0))};
+    mi::SurfaceInputDispatcher dispatcher{scene.stack, std::make_shared<mir::time::SteadyClock>()};
+    dispatcher.start();
+
+    std::shared_ptr<MirEvent const> const motion[] = {
+        pointer_motion(scene.topmost_point()),
+        pointer_motion(empty_space)};
+
+    auto n = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(dispatcher.dispatch(motion[n++ % 2]));
+
+    dispatcher.stop();
+}
+}
+
+BENCHMARK(BM_surface_stack_scene_elements_for)->Apply(mb::scene_sizes);
+BENCHMARK(BM_surface_stack_surface_at_topmost)->Apply(mb::scene_sizes);
+BENCHMARK(BM_surface_stack_surface_at_miss)->Apply(mb::scene_sizes);
+BENCHMARK(BM_surface_input_dispatcher_pointer_motion)->Apply(mb::scene_sizes);
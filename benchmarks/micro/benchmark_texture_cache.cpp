@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene_layout.h"
+
+#include "src/gl/recently_used_cache.h"
+
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/stub_gl_buffer.h"
+
+#include <vector>
+
+namespace mb = mir::benchmark;
+namespace mgl = mir::gl;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+/**
+ * One frame's worth of texture lookups for a scene of \a windows.
+ *
+ * The GL calls the cache makes go to the same mock GL the unit tests
+ * link against, so absolute times include its overhead; it's how they
+ * scale with the scene that matters.
+ */
+struct TextureCacheFrames
+{
+    explicit TextureCacheFrames(int windows)
+    {
+        for (auto i = 0; i != windows; ++i)
+        {
+            auto const renderable = std::make_shared<mtd::FakeRenderable>(mb::window_placement(i));
+            renderable->set_buffer(std::make_shared<mtd::StubGLBuffer>());
+            renderables.push_back(renderable);
+        }
+    }
+
+    void composite_frame()
+    {
+        for (auto const& renderable : renderables)
+            benchmark::DoNotOptimize(cache.load(*renderable));
+
+        cache.drop_unused();
+    }
+
+    /// Give each window a new buffer, as when every client posts a frame
+    void post_new_buffers()
+    {
+        for (auto const& renderable : renderables)
+            renderable->set_buffer(std::make_shared<mtd::StubGLBuffer>());
+    }
+
+    testing::NiceMock<mtd::MockGL> gl;
+    mgl::RecentlyUsedCache cache;
+    std::vector<std::shared_ptr<mtd::FakeRenderable>> renderables;
+};
+
+void BM_recently_used_cache_unchanged_scene(benchmark::State& state)
+{
+    TextureCacheFrames frames{static_cast<int>(state.range(0))};
+    frames.composite_frame();
+
+    for (auto _ : state)
+        frames.composite_frame();
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_recently_used_cache_all_windows_updated(benchmark::State& state)
+{
+    TextureCacheFrames frames{static_cast<int>(state.range(0))};
+    frames.composite_frame();
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        frames.post_new_buffers();
+        state.ResumeTiming();
+
+        frames.composite_frame();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(BM_recently_used_cache_unchanged_scene)->Apply(mb::scene_sizes);
+BENCHMARK(BM_recently_used_cache_all_windows_updated)->Apply(mb::scene_sizes);
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene_layout.h"
+
+#include "src/server/frontend_wayland/wayland_executor.h"
+
+#include <wayland-server-core.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace mb = mir::benchmark;
+namespace mf = mir::frontend;
+
+namespace
+{
+/**
+ * A Wayland event loop dispatched on its own thread, as the Wayland frontend's is.
+ *
+ * Work spawned from the Wayland thread runs inline, so the benchmark has to
+ * spawn from a different thread to measure the queue.
+ */
+class WaylandThread
+{
+public:
+    WaylandThread() = default;
+
+    ~WaylandThread()
+    {
+        executor->spawn([this] { running = false; });
+        thread.join();
+        executor.reset();
+        wl_event_loop_destroy(loop);
+    }
+
+    /// Spawns \a count work items and waits for the Wayland thread to run them all
+    void spawn_and_drain(int count)
+    {
+        std::atomic<int> remaining{count};
+        bool drained{false};
+
+        for (auto i = 0; i != count; ++i)
+        {
+            executor->spawn(
+                [&]
+                {
+                    if (--remaining == 0)
+                    {
+                        std::lock_guard<std::mutex> lock{mutex};
+                        drained = true;
+                        cv.notify_one();
+                    }
+                });
+        }
+
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [&] { return drained; });
+    }
+
+private:
+    wl_event_loop* const loop{wl_event_loop_create()};
+    std::unique_ptr<mf::WaylandExecutor> executor{std::make_unique<mf::WaylandExecutor>(loop)};
+    std::atomic<bool> running{true};
+    std::thread thread{[this] { while (running) wl_event_loop_dispatch(loop, -1); }};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+// The argument is the number of work items spawned at once, as when a
+// batch of surfaces all have something to send their clients
+void BM_wayland_executor_spawn_and_drain(benchmark::State& state)
+{
+    WaylandThread wayland_thread;
+
+    for (auto _ : state)
+        wayland_thread.spawn_and_drain(state.range(0));
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(BM_wayland_executor_spawn_and_drain)->Apply(mb::scene_sizes)->UseRealTime();
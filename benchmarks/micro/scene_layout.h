@@ -0,0 +1,49 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_MICRO_SCENE_LAYOUT_H_
+#define MIR_BENCHMARKS_MICRO_SCENE_LAYOUT_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <benchmark/benchmark.h>
+
+namespace mir
+{
+namespace benchmark
+{
+/// The output every scene is laid out on
+geometry::Rectangle const output{{0, 0}, {1920, 1080}};
+
+/**
+ * Where the index'th of a scene's windows goes: 640x480 windows tiled
+ * 8 across and 6 down, each overlapping its neighbours. Past 48 windows
+ * they start stacking exactly on top of earlier ones.
+ */
+inline auto window_placement(int index) -> geometry::Rectangle
+{
+    return {{(index % 8) * 160, ((index / 8) % 6) * 100}, {640, 480}};
+}
+
+/// Scene sizes (window counts) that every scene benchmark is run with
+inline void scene_sizes(::benchmark::internal::Benchmark* b)
+{
+    b->RangeMultiplier(4)->Range(1, 1024);
+}
+}
+}
+
+#endif // MIR_BENCHMARKS_MICRO_SCENE_LAYOUT_H_
@@ -0,0 +1,315 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "commit_latency.h"
+
+#include "mir/compositor/buffer_stream.h"
+#include "mir/compositor/display_buffer_compositor.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/scene/null_surface_observer.h"
+#include "mir/scene/surface.h"
+
+#include <functional>
+
+namespace mb = mir::benchmark;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace ms = mir::scene;
+namespace msh = mir::shell;
+
+namespace
+{
+class CommitObserver : public ms::NullSurfaceObserver
+{
+public:
+    CommitObserver(std::function<void(ms::Surface const*)> const& committed)
+        : committed{committed}
+    {
+    }
+
+    void frame_posted(ms::Surface const* surface, int, mir::geometry::Size const&) override
+    {
+        committed(surface);
+    }
+
+private:
+    std::function<void(ms::Surface const*)> const committed;
+};
+
+/// Notes the renderables the compositor actually rendered, rather than found occluded
+class RenderedElement : public mc::SceneElement
+{
+public:
+    RenderedElement(std::shared_ptr<mc::SceneElement> const& wrapped, std::vector<mg::Renderable::ID>& rendered_ids)
+        : wrapped{wrapped},
+          rendered_ids(rendered_ids)
+    {
+    }
+
+    auto renderable() const -> std::shared_ptr<mg::Renderable> override
+    {
+        return wrapped->renderable();
+    }
+
+    void rendered() override
+    {
+        wrapped->rendered();
+        rendered_ids.push_back(wrapped->renderable()->id());
+    }
+
+    void occluded() override
+    {
+        wrapped->occluded();
+    }
+
+private:
+    std::shared_ptr<mc::SceneElement> const wrapped;
+    std::vector<mg::Renderable::ID>& rendered_ids;
+};
+}
+
+struct mb::CommitLatencyTracker::TrackedSurface
+{
+    TrackedSurface(std::shared_ptr<ms::Surface> const& surface, std::shared_ptr<ms::SurfaceObserver> const& observer)
+        : surface{surface},
+          observer{observer}
+    {
+    }
+
+    std::weak_ptr<ms::Surface> const surface;
+    std::shared_ptr<ms::SurfaceObserver> const observer;
+    mg::Renderable::ID stream{nullptr};
+
+    // The earliest commit not yet presented
+    Clock::time_point committed;
+};
+
+class mb::CommitLatencyTracker::SurfaceStack : public msh::SurfaceStack
+{
+public:
+    SurfaceStack(std::shared_ptr<msh::SurfaceStack> const& wrapped, CommitLatencyTracker& tracker)
+        : wrapped{wrapped},
+          tracker{tracker}
+    {
+    }
+
+    void add_surface(std::shared_ptr<ms::Surface> const& surface, mir::input::InputReceptionMode new_mode) override
+    {
+        tracker.track(surface);
+        wrapped->add_surface(surface, new_mode);
+    }
+
+    void raise(std::weak_ptr<ms::Surface> const& surface) override
+    {
+        wrapped->raise(surface);
+    }
+
+    void raise(ms::SurfaceSet const& surfaces) override
+    {
+        wrapped->raise(surfaces);
+    }
+
+    void remove_surface(std::weak_ptr<ms::Surface> const& surface) override
+    {
+        if (auto const locked = surface.lock())
+            tracker.untrack(locked);
+        wrapped->remove_surface(surface);
+    }
+
+    auto surface_at(mir::geometry::Point point) const -> std::shared_ptr<ms::Surface> override
+    {
+        return wrapped->surface_at(point);
+    }
+
+private:
+    std::shared_ptr<msh::SurfaceStack> const wrapped;
+    CommitLatencyTracker& tracker;
+};
+
+class mb::CommitLatencyTracker::Compositor : public mc::DisplayBufferCompositor
+{
+public:
+    Compositor(std::unique_ptr<mc::DisplayBufferCompositor> wrapped, CommitLatencyTracker& tracker)
+        : wrapped{std::move(wrapped)},
+          tracker{tracker}
+    {
+    }
+
+    void composite(mc::SceneElementSequence&& scene_sequence) override
+    {
+        auto const began = Clock::now();
+
+        rendered.clear();
+        for (auto& element : scene_sequence)
+            element = std::make_shared<RenderedElement>(element, rendered);
+
+        wrapped->composite(std::move(scene_sequence));
+
+        tracker.frame_posted(began, rendered);
+    }
+
+private:
+    std::unique_ptr<mc::DisplayBufferCompositor> const wrapped;
+    CommitLatencyTracker& tracker;
+    std::vector<mg::Renderable::ID> rendered;
+};
+
+class mb::CommitLatencyTracker::CompositorFactory : public mc::DisplayBufferCompositorFactory
+{
+public:
+    CompositorFactory(std::shared_ptr<mc::DisplayBufferCompositorFactory> const& wrapped, CommitLatencyTracker& tracker)
+        : wrapped{wrapped},
+          tracker{tracker}
+    {
+    }
+
+    auto create_compositor_for(mg::DisplayBuffer& display_buffer)
+        -> std::unique_ptr<mc::DisplayBufferCompositor> override
+    {
+        return std::make_unique<Compositor>(wrapped->create_compositor_for(display_buffer), tracker);
+    }
+
+private:
+    std::shared_ptr<mc::DisplayBufferCompositorFactory> const wrapped;
+    CommitLatencyTracker& tracker;
+};
+
+mb::CommitLatencyTracker::CommitLatencyTracker() = default;
+
+mb::CommitLatencyTracker::~CommitLatencyTracker()
+{
+    for (auto const& entry : surfaces)
+    {
+        if (auto const surface = entry.second->surface.lock())
+            surface->remove_observer(entry.second->observer);
+    }
+}
+
+auto mb::CommitLatencyTracker::wrap(std::shared_ptr<msh::SurfaceStack> const& wrapped)
+    -> std::shared_ptr<msh::SurfaceStack>
+{
+    return std::make_shared<SurfaceStack>(wrapped, *this);
+}
+
+auto mb::CommitLatencyTracker::wrap(std::shared_ptr<mc::DisplayBufferCompositorFactory> const& wrapped)
+    -> std::shared_ptr<mc::DisplayBufferCompositorFactory>
+{
+    return std::make_shared<CompositorFactory>(wrapped, *this);
+}
+
+void mb::CommitLatencyTracker::track(std::shared_ptr<ms::Surface> const& surface)
+{
+    auto const observer = std::make_shared<CommitObserver>([this](ms::Surface const* surface) { committed(surface); });
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto tracked = std::make_unique<TrackedSurface>(surface, observer);
+
+        // Renderables are identified by the stream they show
+        if (auto const stream = std::dynamic_pointer_cast<mc::BufferStream>(surface->primary_buffer_stream()))
+        {
+            tracked->stream = stream.get();
+            streams[tracked->stream] = tracked.get();
+        }
+
+        surfaces[surface.get()] = std::move(tracked);
+    }
+
+    surface->add_observer(observer);
+}
+
+void mb::CommitLatencyTracker::untrack(std::shared_ptr<ms::Surface> const& surface)
+{
+    std::unique_ptr<TrackedSurface> removed;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const i = surfaces.find(surface.get());
+        if (i == surfaces.end())
+            return;
+
+        removed = std::move(i->second);
+        surfaces.erase(i);
+        streams.erase(removed->stream);
+    }
+
+    surface->remove_observer(removed->observer);
+}
+
+void mb::CommitLatencyTracker::committed(ms::Surface const* surface)
+{
+    auto const now = Clock::now();
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    ++commit_count;
+
+    auto const i = surfaces.find(surface);
+    if (i != surfaces.end() && i->second->committed == Clock::time_point{})
+        i->second->committed = now;
+}
+
+void mb::CommitLatencyTracker::frame_posted(
+    Clock::time_point began,
+    std::vector<mg::Renderable::ID> const& renderables)
+{
+    auto const now = Clock::now();
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (auto const id : renderables)
+    {
+        auto const i = streams.find(id);
+        if (i == streams.end())
+            continue;
+
+        auto& tracked = *i->second;
+
+        // The frame may have been composited from an earlier buffer
+        if (tracked.committed == Clock::time_point{} || tracked.committed > began)
+            continue;
+
+        samples.push_back(now - tracked.committed);
+        tracked.committed = Clock::time_point{};
+    }
+}
+
+void mb::CommitLatencyTracker::reset()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    samples.clear();
+    commit_count = 0;
+}
+
+auto mb::CommitLatencyTracker::latencies() const -> std::vector<Clock::duration>
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return samples;
+}
+
+auto mb::CommitLatencyTracker::commits() const -> uint64_t
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return commit_count;
+}
+
+auto mb::CommitLatencyTracker::presented() const -> uint64_t
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return samples.size();
+}
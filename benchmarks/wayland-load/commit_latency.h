@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_WAYLAND_LOAD_COMMIT_LATENCY_H_
+#define MIR_BENCHMARKS_WAYLAND_LOAD_COMMIT_LATENCY_H_
+
+#include "mir/compositor/display_buffer_compositor_factory.h"
+#include "mir/graphics/renderable.h"
+#include "mir/shell/surface_stack.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+class SurfaceObserver;
+}
+namespace benchmark
+{
+/**
+ * Measures, in the server, the time from a client committing a new buffer to
+ * the compositor having rendered a frame that includes it.
+ *
+ * Every surface added to the stack is observed. For each, the tracker keeps
+ * the earliest commit not yet presented; once a composite() that began after
+ * that commit and rendered the surface returns, the commit is presented and
+ * its latency is sampled. Later commits to a surface before it is presented
+ * are counted but not sampled, as they are presented by the same frame. A
+ * surface the compositor finds occluded isn't rendered, so its commits wait.
+ *
+ * A subsurface's commits are posted to its parent surface, so they are
+ * counted as presented when the parent is rendered.
+ */
+class CommitLatencyTracker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CommitLatencyTracker();
+    ~CommitLatencyTracker();
+
+    /// Installs the tracker in the server's surface stack (see Server::wrap_surface_stack())
+    auto wrap(std::shared_ptr<shell::SurfaceStack> const& wrapped) -> std::shared_ptr<shell::SurfaceStack>;
+
+    /// Installs the tracker in the server's compositors (see Server::wrap_display_buffer_compositor_factory())
+    auto wrap(std::shared_ptr<compositor::DisplayBufferCompositorFactory> const& wrapped)
+        -> std::shared_ptr<compositor::DisplayBufferCompositorFactory>;
+
+    /// Discards the samples and counts so far
+    void reset();
+
+    /// The commit-to-present latency of each commit sampled since reset()
+    auto latencies() const -> std::vector<Clock::duration>;
+    /// Commits the server has received since reset()
+    auto commits() const -> uint64_t;
+    /// Commits sampled since reset()
+    auto presented() const -> uint64_t;
+
+private:
+    class SurfaceStack;
+    class CompositorFactory;
+    class Compositor;
+    struct TrackedSurface;
+
+    void track(std::shared_ptr<scene::Surface> const& surface);
+    void untrack(std::shared_ptr<scene::Surface> const& surface);
+    void committed(scene::Surface const* surface);
+    void frame_posted(Clock::time_point began, std::vector<graphics::Renderable::ID> const& renderables);
+
+    std::mutex mutable mutex;
+    std::unordered_map<scene::Surface const*, std::unique_ptr<TrackedSurface>> surfaces;
+    std::unordered_map<graphics::Renderable::ID, TrackedSurface*> streams;
+
+    std::vector<Clock::duration> samples;
+    uint64_t commit_count{0};
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_WAYLAND_LOAD_COMMIT_LATENCY_H_
@@ -0,0 +1,510 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "load_client.h"
+#include "shm_buffers.h"
+#include "wayland_globals.h"
+
+#include "xdg-shell-client-protocol.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <wayland-client.h>
+
+#include <algorithm>
+#include <system_error>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace mb = mir::benchmark;
+
+namespace
+{
+auto create_commit_timer(double commits_per_second, std::chrono::nanoseconds phase) -> mir::Fd
+{
+    mir::Fd fd{timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)};
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create commit timer"}));
+
+    if (commits_per_second > 0)
+    {
+        auto const to_timespec = [](long long nsec)
+            {
+                return timespec{static_cast<time_t>(nsec / 1000000000), static_cast<long>(nsec % 1000000000)};
+            };
+
+        // A zero first expiry would disarm the timer
+        auto const period = static_cast<long long>(1e9 / commits_per_second);
+        itimerspec const spec{to_timespec(period), to_timespec(std::max<long long>(phase.count(), 1))};
+        if (timerfd_settime(fd, 0, &spec, nullptr) < 0)
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to set commit timer"}));
+    }
+
+    return fd;
+}
+
+struct Rect
+{
+    int x, y, width, height;
+};
+
+/// The rectangles of a width x height surface that its frame'th commit damages
+auto damage_for(mb::Damage damage, int width, int height, uint32_t frame) -> std::vector<Rect>
+{
+    switch (damage)
+    {
+    case mb::Damage::full:
+        break;
+
+    case mb::Damage::partial:
+    {
+        auto const band = std::max(height / 8, 1);
+        auto const y = static_cast<int>((frame * 8) % static_cast<uint32_t>(height - band + 1));
+        return {{0, y, width, band}};
+    }
+
+    case mb::Damage::scattered:
+    {
+        std::vector<Rect> rects;
+        auto const size = std::min({32, width, height});
+        auto seed = frame * 2654435761u;
+        for (auto i = 0; i != 8; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            auto const x = static_cast<int>((seed >> 8) % static_cast<uint32_t>(width - size + 1));
+            seed = seed * 1664525u + 1013904223u;
+            auto const y = static_cast<int>((seed >> 8) % static_cast<uint32_t>(height - size + 1));
+            rects.push_back({x, y, size, size});
+        }
+        return rects;
+    }
+    }
+
+    return {{0, 0, width, height}};
+}
+}
+
+auto mb::ClientCounts::operator+=(ClientCounts const& other) -> ClientCounts&
+{
+    requests += other.requests;
+    commits += other.commits;
+    skipped += other.skipped;
+    input_events += other.input_events;
+    return *this;
+}
+
+struct mb::LoadClient::Globals
+{
+    explicit Globals(wl_display* display)
+        : registry{wl_display_get_registry(display)}
+    {
+        static wl_registry_listener const registry_listener{&new_global, &global_removed};
+        wl_registry_add_listener(registry, &registry_listener, this);
+    }
+
+    ~Globals()
+    {
+        if (seat) wl_seat_destroy(seat);
+        if (wm_base) xdg_wm_base_destroy(wm_base);
+        if (subcompositor) wl_subcompositor_destroy(subcompositor);
+        if (shm) wl_shm_destroy(shm);
+        if (compositor) wl_compositor_destroy(compositor);
+        wl_registry_destroy(registry);
+    }
+
+    wl_registry* const registry;
+    wl_compositor* compositor{nullptr};
+    wl_subcompositor* subcompositor{nullptr};
+    wl_shm* shm{nullptr};
+    xdg_wm_base* wm_base{nullptr};
+    wl_seat* seat{nullptr};
+
+    static void new_global(void* data, wl_registry* registry, uint32_t id, char const* interface, uint32_t version)
+    {
+        static xdg_wm_base_listener const wm_base_listener{&ping};
+        auto const self = static_cast<Globals*>(data);
+
+        bind_global(self->compositor, wl_compositor_interface, 3, registry, id, interface, version);
+        bind_global(self->subcompositor, wl_subcompositor_interface, 1, registry, id, interface, version);
+        bind_global(self->shm, wl_shm_interface, 1, registry, id, interface, version);
+        bind_global(self->seat, wl_seat_interface, 5, registry, id, interface, version);
+
+        if (bind_global(self->wm_base, xdg_wm_base_interface, 1, registry, id, interface, version))
+            xdg_wm_base_add_listener(self->wm_base, &wm_base_listener, nullptr);
+    }
+
+    static void global_removed(void*, wl_registry*, uint32_t)
+    {
+    }
+
+    static void ping(void*, xdg_wm_base* wm_base, uint32_t serial)
+    {
+        xdg_wm_base_pong(wm_base, serial);
+    }
+};
+
+/// Takes the input devices the client is interested in, and counts their events
+struct mb::LoadClient::Seat
+{
+    Seat(InputInterest const& interest, std::atomic<uint64_t>& events)
+        : interest{interest},
+          events{events}
+    {
+    }
+
+    ~Seat()
+    {
+        if (pointer) wl_pointer_destroy(pointer);
+        if (keyboard) wl_keyboard_destroy(keyboard);
+        if (touch) wl_touch_destroy(touch);
+    }
+
+    void listen_to(wl_seat* seat)
+    {
+        static wl_seat_listener const seat_listener = []
+            {
+                wl_seat_listener listener{};
+                listener.capabilities = &capabilities;
+                listener.name = [](void*, wl_seat*, char const*) {};
+                return listener;
+            }();
+
+        wl_seat_add_listener(seat, &seat_listener, this);
+    }
+
+    static void capabilities(void* data, wl_seat* seat, uint32_t capabilities)
+    {
+        // Listeners are filled in member by member as newer protocol headers
+        // add events; only events of the version bound are ever sent.
+        static auto const count = [](void* data, auto...) { ++static_cast<Seat*>(data)->events; };
+
+        static wl_pointer_listener const pointer_listener = []
+            {
+                wl_pointer_listener listener{};
+                listener.enter = count;
+                listener.leave = count;
+                listener.motion = count;
+                listener.button = count;
+                listener.axis = count;
+                listener.frame = count;
+                listener.axis_source = count;
+                listener.axis_stop = count;
+                listener.axis_discrete = count;
+                return listener;
+            }();
+
+        static wl_keyboard_listener const keyboard_listener = []
+            {
+                wl_keyboard_listener listener{};
+                listener.keymap = [](void*, wl_keyboard*, uint32_t, int32_t fd, uint32_t) { close(fd); };
+                listener.enter = count;
+                listener.leave = count;
+                listener.key = count;
+                listener.modifiers = count;
+                listener.repeat_info = count;
+                return listener;
+            }();
+
+        static wl_touch_listener const touch_listener = []
+            {
+                wl_touch_listener listener{};
+                listener.down = count;
+                listener.up = count;
+                listener.motion = count;
+                listener.frame = count;
+                listener.cancel = count;
+                listener.shape = count;
+                listener.orientation = count;
+                return listener;
+            }();
+
+        auto const self = static_cast<Seat*>(data);
+
+        if (self->interest.pointer && (capabilities & WL_SEAT_CAPABILITY_POINTER) && !self->pointer)
+        {
+            self->pointer = wl_seat_get_pointer(seat);
+            wl_pointer_add_listener(self->pointer, &pointer_listener, self);
+        }
+
+        if (self->interest.keyboard && (capabilities & WL_SEAT_CAPABILITY_KEYBOARD) && !self->keyboard)
+        {
+            self->keyboard = wl_seat_get_keyboard(seat);
+            wl_keyboard_add_listener(self->keyboard, &keyboard_listener, self);
+        }
+
+        if (self->interest.touch && (capabilities & WL_SEAT_CAPABILITY_TOUCH) && !self->touch)
+        {
+            self->touch = wl_seat_get_touch(seat);
+            wl_touch_add_listener(self->touch, &touch_listener, self);
+        }
+    }
+
+    InputInterest const interest;
+    std::atomic<uint64_t>& events;
+    wl_pointer* pointer{nullptr};
+    wl_keyboard* keyboard{nullptr};
+    wl_touch* touch{nullptr};
+};
+
+struct mb::LoadClient::Surface
+{
+    Surface(Globals const& globals, int width, int height, uint32_t format)
+        : width{width},
+          height{height},
+          surface{wl_compositor_create_surface(globals.compositor)},
+          buffers{globals.shm, width, height, format}
+    {
+    }
+
+    ~Surface()
+    {
+        if (frame_callback) wl_callback_destroy(frame_callback);
+        if (subsurface) wl_subsurface_destroy(subsurface);
+        if (toplevel) xdg_toplevel_destroy(toplevel);
+        if (xdg) xdg_surface_destroy(xdg);
+        wl_surface_destroy(surface);
+    }
+
+    void make_toplevel(xdg_wm_base* wm_base)
+    {
+        static xdg_surface_listener const xdg_surface_listener{&xdg_configure};
+        static xdg_toplevel_listener const toplevel_listener = []
+            {
+                xdg_toplevel_listener listener{};
+                listener.configure = [](void*, xdg_toplevel*, int32_t, int32_t, wl_array*) {};
+                listener.close = [](void*, xdg_toplevel*) {};
+                return listener;
+            }();
+
+        xdg = xdg_wm_base_get_xdg_surface(wm_base, surface);
+        xdg_surface_add_listener(xdg, &xdg_surface_listener, this);
+        toplevel = xdg_surface_get_toplevel(xdg);
+        xdg_toplevel_add_listener(toplevel, &toplevel_listener, this);
+        xdg_toplevel_set_title(toplevel, "wayland-load");
+        wl_surface_commit(surface);
+    }
+
+    void make_subsurface(wl_subcompositor* subcompositor, Surface const& parent, int x, int y)
+    {
+        subsurface = wl_subcompositor_get_subsurface(subcompositor, surface, parent.surface);
+        wl_subsurface_set_position(subsurface, x, y);
+        wl_subsurface_set_desync(subsurface);
+        configured = true;
+    }
+
+    static void xdg_configure(void* data, xdg_surface* xdg, uint32_t serial)
+    {
+        xdg_surface_ack_configure(xdg, serial);
+        static_cast<Surface*>(data)->configured = true;
+    }
+
+    static void frame_done(void* data, wl_callback* callback, uint32_t)
+    {
+        wl_callback_destroy(callback);
+        static_cast<Surface*>(data)->frame_callback = nullptr;
+    }
+
+    int const width;
+    int const height;
+    wl_surface* const surface;
+    xdg_surface* xdg{nullptr};
+    xdg_toplevel* toplevel{nullptr};
+    wl_subsurface* subsurface{nullptr};
+    wl_callback* frame_callback{nullptr};
+    bool configured{false};
+
+    ShmBuffers buffers;
+    uint32_t frame{0};
+};
+
+mb::LoadClient::LoadClient(std::string const& display_name, ClientLoad const& load, std::chrono::nanoseconds phase)
+    : load{load},
+      display{wl_display_connect(display_name.c_str()), &wl_display_disconnect},
+      globals{display ? std::make_unique<Globals>(display.get()) : nullptr},
+      seat{std::make_unique<Seat>(load.input, input_events)},
+      timer{create_commit_timer(load.commits_per_second, phase)}
+{
+    if (!display)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to connect to " + display_name}));
+
+    wl_display_roundtrip(display.get());
+
+    if (!globals->compositor || !globals->shm || !globals->wm_base)
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Server lacks wl_compositor, wl_shm or xdg_wm_base"});
+    if (load.subsurface_depth > 0 && !globals->subcompositor)
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Server lacks wl_subcompositor"});
+
+    auto const& input = load.input;
+    if ((input.pointer || input.keyboard || input.touch) && globals->seat)
+        seat->listen_to(globals->seat);
+
+    for (auto i = 0; i != load.toplevels; ++i)
+    {
+        surfaces.push_back(std::make_unique<Surface>(*globals, load.width, load.height, WL_SHM_FORMAT_XRGB8888));
+        auto& toplevel = *surfaces.back();
+        toplevel.make_toplevel(globals->wm_base);
+        create_tree(toplevel, load.subsurface_depth);
+    }
+
+    // Wait to be told to show the toplevels (and for the seat's capabilities)
+    wl_display_roundtrip(display.get());
+    check_connection();
+
+    for (auto const& surface : surfaces)
+        update(*surface);
+    flush();
+}
+
+mb::LoadClient::~LoadClient()
+{
+    // Children before their parents
+    while (!surfaces.empty())
+        surfaces.pop_back();
+}
+
+void mb::LoadClient::create_tree(Surface& parent, int depth)
+{
+    if (depth <= 0)
+        return;
+
+    auto const width = std::max(parent.width / 2, 16);
+    auto const height = std::max(parent.height / 2, 16);
+
+    for (auto i = 0; i != load.subsurface_fanout; ++i)
+    {
+        // Translucent, so that every level of the tree has to be blended
+        surfaces.push_back(std::make_unique<Surface>(*globals, width, height, WL_SHM_FORMAT_ARGB8888));
+        auto& child = *surfaces.back();
+
+        auto const x = (i + 1) * parent.width / (load.subsurface_fanout + 1) - width / 2;
+        child.make_subsurface(globals->subcompositor, parent, x, parent.height / 4);
+        requests += 3;
+
+        create_tree(child, depth - 1);
+    }
+}
+
+auto mb::LoadClient::display_fd() const -> int
+{
+    return wl_display_get_fd(display.get());
+}
+
+auto mb::LoadClient::timer_fd() const -> int
+{
+    return timer;
+}
+
+void mb::LoadClient::dispatch()
+{
+    if (wl_display_dispatch(display.get()) < 0)
+        check_connection();
+}
+
+void mb::LoadClient::tick()
+{
+    uint64_t expirations;
+    if (read(timer, &expirations, sizeof expirations) != sizeof expirations)
+        return;
+
+    for (auto const& surface : surfaces)
+    {
+        if (!surface->configured)
+            continue;
+
+        if (load.throttle && surface->frame_callback)
+            ++skipped;
+        else
+            update(*surface);
+    }
+}
+
+void mb::LoadClient::flush()
+{
+    if (wl_display_dispatch_pending(display.get()) < 0)
+        check_connection();
+
+    // If the socket is full what's left is sent on a later flush
+    wl_display_flush(display.get());
+}
+
+void mb::LoadClient::update(Surface& surface)
+{
+    static wl_callback_listener const frame_listener{&Surface::frame_done};
+
+    auto const buffer = surface.buffers.free_buffer();
+    if (!buffer)
+    {
+        ++skipped;
+        return;
+    }
+
+    // Draw only what is damaged; the rest of the buffer keeps whatever the
+    // last commit using it left there, as with a client tracking buffer age
+    auto const shade = static_cast<uint8_t>(surface.frame * 8);
+    uint32_t const pixel = 0x80000000u | (uint32_t{shade} << 16) | (0x40u << 8) | (0xffu - shade);
+    auto const damage = damage_for(load.damage, surface.width, surface.height, surface.frame++);
+
+    for (auto const& rect : damage)
+    {
+        for (auto y = rect.y; y != rect.y + rect.height; ++y)
+        {
+            auto const row = buffer->pixels + y * surface.width;
+            std::fill(row + rect.x, row + rect.x + rect.width, pixel);
+        }
+    }
+
+    buffer->busy = true;
+    wl_surface_attach(surface.surface, buffer->buffer, 0, 0);
+    for (auto const& rect : damage)
+        wl_surface_damage(surface.surface, rect.x, rect.y, rect.width, rect.height);
+
+    if (load.throttle)
+    {
+        surface.frame_callback = wl_surface_frame(surface.surface);
+        wl_callback_add_listener(surface.frame_callback, &frame_listener, &surface);
+        ++requests;
+    }
+
+    wl_surface_commit(surface.surface);
+
+    requests += 2 + damage.size();
+    ++commits;
+}
+
+void mb::LoadClient::check_connection() const
+{
+    if (auto const error = wl_display_get_error(display.get()))
+        BOOST_THROW_EXCEPTION((std::system_error{error, std::system_category(), "Wayland connection failed"}));
+}
+
+auto mb::LoadClient::counts() const -> ClientCounts
+{
+    ClientCounts result;
+    result.requests = requests;
+    result.commits = commits;
+    result.skipped = skipped;
+    result.input_events = input_events;
+    return result;
+}
+
+void mb::LoadClient::reset_counts()
+{
+    requests = 0;
+    commits = 0;
+    skipped = 0;
+    input_events = 0;
+}
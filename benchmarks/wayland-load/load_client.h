@@ -0,0 +1,139 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_WAYLAND_LOAD_LOAD_CLIENT_H_
+#define MIR_BENCHMARKS_WAYLAND_LOAD_LOAD_CLIENT_H_
+
+#include "mir/fd.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct wl_display;
+
+namespace mir
+{
+namespace benchmark
+{
+/// Which part of a surface each commit damages
+enum class Damage
+{
+    /// The whole surface
+    full,
+    /// A band an eighth of the surface high, moving down a little each commit
+    partial,
+    /// Eight small rectangles spread over the surface
+    scattered
+};
+
+/// The input devices a client listens to
+struct InputInterest
+{
+    bool pointer{false};
+    bool keyboard{false};
+    bool touch{false};
+};
+
+/// What one client does
+struct ClientLoad
+{
+    int width{256};
+    int height{256};
+    /// xdg_toplevels the client shows
+    int toplevels{1};
+    /// Zero means commit once and never again
+    double commits_per_second{60};
+    Damage damage{Damage::full};
+    /// Levels of subsurfaces under each toplevel (zero for none)
+    int subsurface_depth{0};
+    /// Subsurfaces under each surface in the tree
+    int subsurface_fanout{1};
+    InputInterest input;
+    /// Wait for the frame callback of a surface's last commit before committing again
+    bool throttle{true};
+};
+
+/// What a client has done, as seen from the client side
+struct ClientCounts
+{
+    /// Wayland requests sent
+    uint64_t requests{0};
+    /// wl_surface.commits that attached a new buffer
+    uint64_t commits{0};
+    /// Commits not made because the last frame callback or a free buffer hadn't arrived
+    uint64_t skipped{0};
+    /// Pointer, keyboard and touch events received
+    uint64_t input_events{0};
+
+    auto operator+=(ClientCounts const& other) -> ClientCounts&;
+};
+
+/**
+ * A lightweight Wayland client: one connection showing wl_shm xdg_toplevels,
+ * each possibly with a tree of subsurfaces, that commit on a timer.
+ *
+ * The client does no waiting of its own. Whoever owns it polls display_fd()
+ * and timer_fd() and calls dispatch() and tick() when they are readable; many
+ * clients can then share a thread. All calls must be made on one thread.
+ */
+class LoadClient
+{
+public:
+    /// Connects to \a display_name and shows the surfaces; the first tick comes after \a phase
+    LoadClient(std::string const& display_name, ClientLoad const& load, std::chrono::nanoseconds phase);
+    ~LoadClient();
+
+    auto display_fd() const -> int;
+    auto timer_fd() const -> int;
+
+    /// Reads and handles the events waiting on display_fd()
+    void dispatch();
+    /// Handles the commit timer on timer_fd() expiring
+    void tick();
+    /// Sends the requests made since the last flush
+    void flush();
+
+    auto counts() const -> ClientCounts;
+    void reset_counts();
+
+private:
+    struct Globals;
+    struct Seat;
+    struct Surface;
+
+    void create_tree(Surface& parent, int depth);
+    void update(Surface& surface);
+    void check_connection() const;
+
+    ClientLoad const load;
+    std::unique_ptr<wl_display, void(*)(wl_display*)> const display;
+    std::unique_ptr<Globals> const globals;
+    std::unique_ptr<Seat> const seat;
+    std::vector<std::unique_ptr<Surface>> surfaces;
+    Fd const timer;
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> commits{0};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<uint64_t> input_events{0};
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_WAYLAND_LOAD_LOAD_CLIENT_H_
@@ -0,0 +1,260 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "load_generator.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <condition_variable>
+#include <iostream>
+#include <system_error>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace mb = mir::benchmark;
+
+namespace
+{
+uint64_t const stop_key{~uint64_t{0}};
+
+auto key_for_display(size_t client) -> uint64_t { return client * 2; }
+auto key_for_timer(size_t client) -> uint64_t { return client * 2 + 1; }
+
+auto create_epoll() -> mir::Fd
+{
+    mir::Fd fd{epoll_create1(EPOLL_CLOEXEC)};
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create epoll fd"}));
+    return fd;
+}
+
+void watch(int epoll, int fd, uint64_t key)
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = key;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to watch fd"}));
+}
+}
+
+class mb::LoadGenerator::Worker
+{
+public:
+    struct Assignment
+    {
+        ClientLoad load;
+        std::chrono::nanoseconds phase;
+    };
+
+    Worker(std::string const& display_name, std::vector<Assignment> const& assignments, std::atomic<int>& failures)
+        : display_name{display_name},
+          assignments{assignments},
+          failures{failures},
+          epoll{create_epoll()},
+          stop_event{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)},
+          thread{[this] { run(); }}
+    {
+    }
+
+    ~Worker()
+    {
+        uint64_t const one{1};
+        if (write(stop_event, &one, sizeof one) != sizeof one)
+            std::cerr << "Failed to stop load generator thread" << std::endl;
+        thread.join();
+    }
+
+    auto wait_until_connected() -> int
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [this] { return connecting_done; });
+        return static_cast<int>(clients.size());
+    }
+
+    auto counts() const -> ClientCounts
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        ClientCounts result;
+        for (auto const& client : clients)
+            result += client->counts();
+        return result;
+    }
+
+    void reset_counts()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        for (auto const& client : clients)
+            client->reset_counts();
+    }
+
+private:
+    void fail(std::exception const& error)
+    {
+        std::cerr << "Load client failed: " << error.what() << std::endl;
+        ++failures;
+    }
+
+    void run()
+    {
+        for (auto const& assignment : assignments)
+        {
+            try
+            {
+                auto client = std::make_unique<LoadClient>(display_name, assignment.load, assignment.phase);
+
+                std::lock_guard<std::mutex> lock{mutex};
+                watch(epoll, client->display_fd(), key_for_display(clients.size()));
+                watch(epoll, client->timer_fd(), key_for_timer(clients.size()));
+                clients.push_back(std::move(client));
+            }
+            catch (std::exception const& error)
+            {
+                fail(error);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            connecting_done = true;
+        }
+        cv.notify_all();
+
+        try
+        {
+            watch(epoll, stop_event, stop_key);
+            dispatch_until_stopped();
+        }
+        catch (std::exception const& error)
+        {
+            fail(error);
+        }
+    }
+
+    void dispatch_until_stopped()
+    {
+        std::vector<bool> live(clients.size(), true);
+        std::vector<size_t> touched;
+        epoll_event events[64];
+
+        for (;;)
+        {
+            auto const ready = epoll_wait(epoll, events, sizeof events / sizeof events[0], -1);
+            if (ready < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to wait for events"}));
+            }
+
+            touched.clear();
+            for (auto i = 0; i != ready; ++i)
+            {
+                auto const key = events[i].data.u64;
+                if (key == stop_key)
+                    return;
+
+                auto const index = key / 2;
+                if (!live[index])
+                    continue;
+
+                try
+                {
+                    if (key == key_for_display(index))
+                        clients[index]->dispatch();
+                    else
+                        clients[index]->tick();
+                    touched.push_back(index);
+                }
+                catch (std::exception const& error)
+                {
+                    fail(error);
+                    live[index] = false;
+                    epoll_ctl(epoll, EPOLL_CTL_DEL, clients[index]->display_fd(), nullptr);
+                    epoll_ctl(epoll, EPOLL_CTL_DEL, clients[index]->timer_fd(), nullptr);
+                }
+            }
+
+            // Handling events and ticks queues requests (e.g. pongs and commits)
+            for (auto const index : touched)
+            {
+                if (live[index])
+                    clients[index]->flush();
+            }
+        }
+    }
+
+    std::string const display_name;
+    std::vector<Assignment> const assignments;
+    std::atomic<int>& failures;
+    Fd const epoll;
+    Fd const stop_event;
+
+    std::mutex mutable mutex;
+    std::condition_variable cv;
+    bool connecting_done{false};
+    std::vector<std::unique_ptr<LoadClient>> clients;
+
+    std::thread thread;
+};
+
+mb::LoadGenerator::LoadGenerator(std::string const& display_name, std::vector<ClientLoad> const& loads, int threads)
+{
+    threads = std::max(1, std::min<int>(threads, loads.size()));
+
+    // Spread each client's first commit over its commit period, so clients
+    // with the same rate don't all commit at once
+    std::vector<std::vector<Worker::Assignment>> assignments(threads);
+    for (size_t i = 0; i != loads.size(); ++i)
+    {
+        auto const rate = loads[i].commits_per_second;
+        auto const phase = rate > 0 ?
+            std::chrono::nanoseconds{static_cast<int64_t>(1e9 / rate * i / loads.size())} :
+            std::chrono::nanoseconds{0};
+        assignments[i % threads].push_back({loads[i], phase});
+    }
+
+    for (auto const& share : assignments)
+        workers.push_back(std::make_unique<Worker>(display_name, share, failures));
+}
+
+mb::LoadGenerator::~LoadGenerator() = default;
+
+auto mb::LoadGenerator::wait_until_connected() -> int
+{
+    auto connected = 0;
+    for (auto const& worker : workers)
+        connected += worker->wait_until_connected();
+    return connected;
+}
+
+auto mb::LoadGenerator::counts() const -> ClientCounts
+{
+    ClientCounts result;
+    for (auto const& worker : workers)
+        result += worker->counts();
+    return result;
+}
+
+void mb::LoadGenerator::reset_counts()
+{
+    for (auto const& worker : workers)
+        worker->reset_counts();
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_BENCHMARKS_WAYLAND_LOAD_LOAD_GENERATOR_H_
+#define MIR_BENCHMARKS_WAYLAND_LOAD_LOAD_GENERATOR_H_
+
+#include "load_client.h"
+
+#include "mir/fd.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mir
+{
+namespace benchmark
+{
+/**
+ * Runs many LoadClients in a handful of threads.
+ *
+ * Each thread connects its share of the clients and then multiplexes their
+ * connections and commit timers with epoll until stopped.
+ */
+class LoadGenerator
+{
+public:
+    /// Starts a client for each of \a loads, connected to \a display_name
+    LoadGenerator(std::string const& display_name, std::vector<ClientLoad> const& loads, int threads);
+    /// Stops and disconnects every client
+    ~LoadGenerator();
+
+    /// Waits until every client has connected (or failed to); returns the number connected
+    auto wait_until_connected() -> int;
+
+    /// Whether any client has failed
+    auto failed() const -> bool { return failures > 0; }
+
+    auto counts() const -> ClientCounts;
+    void reset_counts();
+
+private:
+    class Worker;
+
+    std::atomic<int> failures{0};
+    std::vector<std::unique_ptr<Worker>> workers;
+};
+}
+}
+
+#endif // MIR_BENCHMARKS_WAYLAND_LOAD_LOAD_GENERATOR_H_
@@ -0,0 +1,362 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Boots the server on the offscreen display, connects many synthetic Wayland
+ * clients to it and reports how well it kept up as JSON:
+ *
+ *   mir_wayland_load --clients=200 --toplevels-per-client=2 \
+ *       --surface-size=320x240 --commit-rates=60,30,144 \
+ *       --damage=full,partial,scattered --subsurface-depth=1 \
+ *       --input=pointer,keyboard --duration=10
+ *
+ * Lists are handed out to the clients round-robin, so the example gives a
+ * third of the clients each commit rate and damage pattern.
+ *
+ * The clients only see input if the server has input devices; the replay
+ * input platform can provide them.
+ */
+
+#include "commit_latency.h"
+#include "load_generator.h"
+#include "options.h"
+
+#include <miral/command_line_option.h>
+#include <miral/minimal_window_manager.h>
+#include <miral/runner.h>
+#include <miral/set_window_management_policy.h>
+
+#include <mir/server.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace mb = mir::benchmark;
+using namespace std::chrono;
+
+namespace
+{
+struct Config
+{
+    int clients{100};
+    int toplevels_per_client{1};
+    int width{256};
+    int height{256};
+    std::vector<double> commit_rates{60};
+    std::vector<mb::Damage> damage{mb::Damage::full};
+    int subsurface_depth{0};
+    int subsurface_fanout{1};
+    mb::InputInterest input;
+    bool throttle{true};
+    int client_threads{4};
+    double warmup{2};
+    double duration{10};
+};
+
+auto split(std::string const& list) -> std::vector<std::string>
+{
+    std::vector<std::string> items;
+    std::istringstream in{list};
+    for (std::string item; std::getline(in, item, ',');)
+    {
+        if (!item.empty())
+            items.push_back(item);
+    }
+    return items;
+}
+
+auto parse_rates(std::string const& list) -> std::vector<double>
+{
+    std::vector<double> rates;
+    for (auto const& item : split(list))
+    {
+        std::istringstream in{item};
+        in.imbue(std::locale::classic());
+        double rate;
+        if (!(in >> rate) || rate < 0)
+            throw std::runtime_error{"Invalid --commit-rates: " + list};
+        rates.push_back(rate);
+    }
+
+    if (rates.empty())
+        throw std::runtime_error{"Invalid --commit-rates: " + list};
+    return rates;
+}
+
+auto parse_damage(std::string const& list) -> std::vector<mb::Damage>
+{
+    std::vector<mb::Damage> damage;
+    for (auto const& item : split(list))
+    {
+        if (item == "full")
+            damage.push_back(mb::Damage::full);
+        else if (item == "partial")
+            damage.push_back(mb::Damage::partial);
+        else if (item == "scattered")
+            damage.push_back(mb::Damage::scattered);
+        else
+            throw std::runtime_error{"Invalid --damage: " + list};
+    }
+
+    if (damage.empty())
+        throw std::runtime_error{"Invalid --damage: " + list};
+    return damage;
+}
+
+auto parse_input(std::string const& list) -> mb::InputInterest
+{
+    mb::InputInterest input;
+    if (list == "none")
+        return input;
+
+    for (auto const& item : split(list))
+    {
+        if (item == "pointer")
+            input.pointer = true;
+        else if (item == "keyboard")
+            input.keyboard = true;
+        else if (item == "touch")
+            input.touch = true;
+        else
+            throw std::runtime_error{"Invalid --input: " + list};
+    }
+    return input;
+}
+
+auto name_of(mb::Damage damage) -> char const*
+{
+    switch (damage)
+    {
+    case mb::Damage::full: return "full";
+    case mb::Damage::partial: return "partial";
+    case mb::Damage::scattered: return "scattered";
+    }
+    return "unknown";
+}
+
+auto loads_for(Config const& config) -> std::vector<mb::ClientLoad>
+{
+    std::vector<mb::ClientLoad> loads;
+    for (auto i = 0; i != config.clients; ++i)
+    {
+        mb::ClientLoad load;
+        load.width = config.width;
+        load.height = config.height;
+        load.toplevels = config.toplevels_per_client;
+        load.commits_per_second = config.commit_rates[i % config.commit_rates.size()];
+        load.damage = config.damage[i % config.damage.size()];
+        load.subsurface_depth = config.subsurface_depth;
+        load.subsurface_fanout = config.subsurface_fanout;
+        load.input = config.input;
+        load.throttle = config.throttle;
+        loads.push_back(load);
+    }
+    return loads;
+}
+
+auto percentile(std::vector<double> values, int p) -> double
+{
+    if (values.empty())
+        return 0;
+
+    std::sort(values.begin(), values.end());
+    return values[(values.size() - 1) * p / 100];
+}
+
+void write_distribution(std::ostream& out, std::vector<double> const& values)
+{
+    out << "{\"p50\": " << percentile(values, 50)
+        << ", \"p90\": " << percentile(values, 90)
+        << ", \"p99\": " << percentile(values, 99)
+        << ", \"max\": " << percentile(values, 100) << "}";
+}
+
+template<typename T>
+void write_list(std::ostream& out, std::vector<T> const& values)
+{
+    out << "[";
+    for (auto const& value : values)
+        out << (&value == &values.front() ? "" : ", ") << value;
+    out << "]";
+}
+}
+
+int main(int argc, char const* argv[])
+{
+    // Render with llvmpipe unless told otherwise
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    std::vector<char const*> args{argv, argv + argc};
+    args.insert(args.begin() + 1, "--offscreen");
+    if (std::none_of(argv + 1, argv + argc,
+        [](char const* arg) { return strncmp(arg, "--offscreen-outputs", strlen("--offscreen-outputs")) == 0; }))
+    {
+        args.insert(args.begin() + 1, "--offscreen-outputs=1920x1080");
+    }
+
+    Config config;
+    mb::CommitLatencyTracker tracker;
+
+    miral::MirRunner runner{static_cast<int>(args.size()), args.data()};
+
+    std::thread controller;
+
+    int connected{0};
+    std::vector<double> latencies;
+    uint64_t server_commits{0};
+    uint64_t presented{0};
+    mb::ClientCounts client_counts;
+    bool failed{false};
+
+    auto const measure = [&]
+        {
+            auto const wayland_display = runner.wayland_display();
+            if (!wayland_display.is_set())
+            {
+                std::cerr << "Server has no Wayland endpoint" << std::endl;
+                failed = true;
+                runner.stop();
+                return;
+            }
+
+            {
+                mb::LoadGenerator generator{wayland_display.value(), loads_for(config), config.client_threads};
+                connected = generator.wait_until_connected();
+
+                std::this_thread::sleep_for(duration<double>{config.warmup});
+
+                tracker.reset();
+                generator.reset_counts();
+
+                std::this_thread::sleep_for(duration<double>{config.duration});
+
+                for (auto const latency : tracker.latencies())
+                    latencies.push_back(duration<double, std::milli>(latency).count());
+                server_commits = tracker.commits();
+                presented = tracker.presented();
+                client_counts = generator.counts();
+                failed = generator.failed();
+            }
+
+            runner.stop();
+        };
+
+    runner.add_start_callback([&] { controller = std::thread{measure}; });
+
+    auto const exit_code = runner.run_with(
+        {
+            [&](mir::Server& server)
+            {
+                server.wrap_surface_stack(
+                    [&](std::shared_ptr<mir::shell::SurfaceStack> const& wrapped)
+                    {
+                        return tracker.wrap(wrapped);
+                    });
+                server.wrap_display_buffer_compositor_factory(
+                    [&](std::shared_ptr<mir::compositor::DisplayBufferCompositorFactory> const& wrapped)
+                    {
+                        return tracker.wrap(wrapped);
+                    });
+            },
+            miral::set_window_management_policy<miral::MinimalWindowManager>(),
+            miral::CommandLineOption{[&](int value) { config.clients = std::max(value, 0); },
+                "clients", "Number of Wayland clients", config.clients},
+            miral::CommandLineOption{[&](int value) { config.toplevels_per_client = std::max(value, 1); },
+                "toplevels-per-client", "Number of xdg_toplevels each client shows", config.toplevels_per_client},
+            miral::CommandLineOption{[&](std::string const& value)
+                {
+                    if (!mb::parse_size(value, config.width, config.height))
+                        throw std::runtime_error{"Invalid --surface-size: " + value};
+                },
+                "surface-size", "Size of every surface, <width>x<height>", "256x256"},
+            miral::CommandLineOption{[&](std::string const& value) { config.commit_rates = parse_rates(value); },
+                "commit-rates", "Commits per second of each client's surfaces, as a comma separated list "
+                "handed out round-robin (0 for static surfaces)", "60"},
+            miral::CommandLineOption{[&](std::string const& value) { config.damage = parse_damage(value); },
+                "damage", "Damage each commit makes, as a comma separated list of full, partial and scattered "
+                "handed out round-robin", "full"},
+            miral::CommandLineOption{[&](int value) { config.subsurface_depth = std::max(value, 0); },
+                "subsurface-depth", "Levels of subsurfaces under each toplevel", config.subsurface_depth},
+            miral::CommandLineOption{[&](int value) { config.subsurface_fanout = std::max(value, 1); },
+                "subsurface-fanout", "Subsurfaces under each surface with subsurfaces", config.subsurface_fanout},
+            miral::CommandLineOption{[&](std::string const& value) { config.input = parse_input(value); },
+                "input", "Input each client listens to: none or a comma separated list of pointer, keyboard "
+                "and touch", "none"},
+            miral::CommandLineOption{[&](bool value) { config.throttle = value; },
+                "throttle", "Wait for each frame callback before committing again", config.throttle},
+            miral::CommandLineOption{[&](int value) { config.client_threads = std::max(value, 1); },
+                "client-threads", "Threads the clients are spread over", config.client_threads},
+            miral::CommandLineOption{[&](double value) { config.warmup = value; },
+                "warmup", "Seconds to run before measuring", config.warmup},
+            miral::CommandLineOption{[&](double value) { config.duration = value; },
+                "duration", "Seconds to measure for", config.duration},
+        });
+
+    if (controller.joinable())
+        controller.join();
+
+    if (exit_code != EXIT_SUCCESS || failed)
+        return EXIT_FAILURE;
+
+    std::vector<char const*> damage;
+    for (auto const pattern : config.damage)
+        damage.push_back(name_of(pattern));
+
+    std::ostringstream json;
+    json.imbue(std::locale::classic());
+    json << std::fixed << std::setprecision(3);
+
+    json << "{\n  \"config\": {"
+         << "\"clients\": " << config.clients
+         << ", \"toplevels_per_client\": " << config.toplevels_per_client
+         << ", \"surface_width\": " << config.width
+         << ", \"surface_height\": " << config.height
+         << ", \"commit_rates\": ";
+    write_list(json, config.commit_rates);
+    json << ", \"damage\": [";
+    for (auto const& pattern : damage)
+        json << (&pattern == &damage.front() ? "\"" : ", \"") << pattern << "\"";
+    json << "]"
+         << ", \"subsurface_depth\": " << config.subsurface_depth
+         << ", \"subsurface_fanout\": " << config.subsurface_fanout
+         << ", \"input\": {\"pointer\": " << std::boolalpha << config.input.pointer
+         << ", \"keyboard\": " << config.input.keyboard
+         << ", \"touch\": " << config.input.touch << "}"
+         << ", \"throttle\": " << config.throttle
+         << ", \"client_threads\": " << config.client_threads
+         << ", \"duration_s\": " << config.duration << "},\n";
+
+    json << "  \"clients_connected\": " << connected << ",\n"
+         << "  \"commit_to_present_ms\": ";
+    write_distribution(json, latencies);
+    json << ",\n"
+         << "  \"server_commits_per_second\": " << server_commits / config.duration << ",\n"
+         << "  \"commits_presented\": " << presented << ",\n"
+         << "  \"client_requests_per_second\": " << client_counts.requests / config.duration << ",\n"
+         << "  \"client_commits_per_second\": " << client_counts.commits / config.duration << ",\n"
+         << "  \"commits_skipped\": " << client_counts.skipped << ",\n"
+         << "  \"input_events\": " << client_counts.input_events << "\n}\n";
+
+    std::cout << json.str();
+    return EXIT_SUCCESS;
+}
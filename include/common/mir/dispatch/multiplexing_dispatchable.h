@@ -22,6 +22,7 @@
 #include "mir/dispatch/dispatchable.h"
 #include "mir/posix_rw_mutex.h"
 
+#include <atomic>
 #include <functional>
 #include <initializer_list>
 #include <list>
@@ -95,8 +96,13 @@ public:
      */
     void remove_watch(Fd const& fd);
 private:
+    /// Upper bound on the number of ready sources serviced by a single dispatch()
+    static int const max_events_per_dispatch{32};
+
     PosixRWMutex lifetime_mutex;
     std::list<std::pair<std::shared_ptr<Dispatchable>, bool>> dispatchee_holder;
+    std::atomic<uint64_t> removal_count{0};
+    std::atomic<int> dispatching_threads{0};
 
     Fd epoll_fd;
 };
@@ -115,6 +115,12 @@ public:
     /// Allows clients to retrieve additional information about outputs
     /// \remark Since MirAL 2.6
     static char const* const zxdg_output_manager_v1;
+
+    /// Allows clients to capture the contents of outputs. As this exposes
+    /// everything on screen, it is recommended to use this in conjunction
+    /// with set_filter().
+    /// \remark Since MirAL 3.1
+    static char const* const zwlr_screencopy_manager_v1;
     /** @} */
 
     /// Add a bespoke Wayland extension both to "supported" and "enabled by default".
@@ -22,6 +22,7 @@
 #include <experimental/optional>
 #include <mir/geometry/rectangle.h>
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -49,6 +50,13 @@ public:
      */
     virtual std::shared_ptr<Buffer> buffer() const = 0;
 
+    /**
+     * The serial of the client submission buffer() came from, or 0 if it is
+     * not known. Clients may submit a buffer again, drawn afresh, so this
+     * tells apart contents that the buffer's ID alone does not.
+     */
+    virtual uint64_t submission() const { return 0; }
+
     virtual geometry::Rectangle screen_position() const = 0;
     virtual std::experimental::optional<geometry::Rectangle> clip_area() const = 0;
 
@@ -43,10 +43,22 @@ extern char const* const connector_report_opt;
 extern char const* const scene_report_opt;
 extern char const* const input_report_opt;
 extern char const* const seat_report_opt;
+extern char const* const metrics_socket_opt;
+extern char const* const trace_opt;
+extern char const* const trace_dir_opt;
+extern char const* const track_input_latency_opt;
+extern char const* const gpu_timing_opt;
+extern char const* const texture_cache_budget_opt;
+extern char const* const software_compositing_opt;
+extern char const* const session_memory_limit_opt;
+extern char const* const record_input_opt;
+extern char const* const replay_input_opt;
+extern char const* const replay_input_speed_opt;
 extern char const* const touchspots_opt;
 extern char const* const cursor_opt;
 extern char const* const fatal_except_opt;
 extern char const* const debug_opt;
+extern char const* const async_logging_opt;
 extern char const* const composite_delay_opt;
 extern char const* const enable_key_repeat_opt;
 extern char const* const x11_display_opt;
@@ -54,12 +66,17 @@ extern char const* const wayland_extensions_opt;
 extern char const* const enable_mirclient_opt;
 
 extern char const* const offscreen_opt;
+extern char const* const offscreen_outputs_opt;
+extern char const* const offscreen_refresh_rate_opt;
+extern char const* const virtual_time_opt;
 
 extern char const* const enable_key_repeat_opt;
 
 extern char const* const off_opt_value;
 extern char const* const log_opt_value;
 extern char const* const lttng_opt_value;
+extern char const* const metrics_opt_value;
+extern char const* const trace_opt_value;
 
 extern char const* const platform_graphics_lib;
 extern char const* const platform_input_lib;
@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GPU_TIMING_H_
+#define MIR_RENDERER_GPU_TIMING_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace mir
+{
+namespace renderer
+{
+
+/**
+ * How long the GPU spent on a rendered frame.
+ *
+ * GPU work completes some time after it is submitted, so these are only
+ * available a frame or more after the frame was rendered.
+ */
+struct GPUTiming
+{
+    /// The kinds of work a frame's GPU time is split between
+    enum class Class
+    {
+        clear,      ///< Clearing the frame
+        opaque,     ///< Drawing renderables with blending disabled
+        blended     ///< Drawing renderables blended over what's below
+    };
+    static constexpr std::size_t class_count = 3;
+
+    enum class Method
+    {
+        /// Measured on the GPU by timer queries
+        timer_query,
+        /**
+         * Timed from the frame being submitted until a fence after it was
+         * seen to signal: an upper bound, and class_time is all zero
+         */
+        fence
+    };
+
+    Method method;
+    std::chrono::nanoseconds frame_time;
+    std::array<std::chrono::nanoseconds, class_count> class_time;
+
+    auto time_in(Class c) const -> std::chrono::nanoseconds
+    {
+        return class_time[static_cast<std::size_t>(c)];
+    }
+};
+
+}
+}
+
+#endif // MIR_RENDERER_GPU_TIMING_H_
@@ -20,15 +20,44 @@
 #define MIR_RENDERER_RENDERER_H_
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/geometry/dimensions.h"
 #include "mir/graphics/renderable.h"
+#include "mir/renderer/gpu_timing.h"
+#include "mir/renderer/texture_cache_usage.h"
 #include "mir_toolkit/common.h"
 #include <glm/glm.hpp>
 
+#include <memory>
+
 namespace mir
 {
 namespace renderer
 {
 
+/**
+ * A request to read back parts of a rendered frame.
+ */
+class Readback
+{
+public:
+    virtual ~Readback() = default;
+
+    /// The areas to read, in the coordinates of the renderer's viewport
+    virtual auto regions() const -> geometry::Rectangles = 0;
+
+    /// The pixels of \a region, as RGBA bytes (mir_pixel_format_abgr_8888), top row first
+    virtual void deliver(geometry::Rectangle const& region, unsigned char const* pixels, geometry::Stride stride) = 0;
+
+    /// Every region has been delivered or, if not \a complete, the frame could not be read
+    virtual void finished(bool complete) = 0;
+
+protected:
+    Readback() = default;
+    Readback(Readback const&) = delete;
+    Readback& operator=(Readback const&) = delete;
+};
+
 class Renderer
 {
 public:
@@ -39,6 +68,26 @@ public:
     virtual void render(graphics::RenderableList const&) const = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
+    /**
+     * GPU timings of earlier frames that have completed since this was last
+     * called, oldest first. Called with a valid GL context, after render().
+     * Renderers that don't measure GPU time have none.
+     */
+    virtual auto completed_gpu_timings() -> std::vector<GPUTiming> { return {}; }
+
+    /**
+     * How the renderer's texture cache has fared since this was last called.
+     * Called without a GL context. Renderers without a cache report nothing.
+     */
+    virtual auto texture_cache_usage() -> TextureCacheUsage { return {0, 0, 0, 0, 0}; }
+
+    /**
+     * Reads \a readback from the next frame rendered. The pixels may arrive
+     * during a later render(), once the GPU has finished the frame, but always
+     * on the thread calling render(). Renderers that cannot read back fail it.
+     */
+    virtual void read_back(std::shared_ptr<Readback> const& readback) { readback->finished(false); }
+
 protected:
     Renderer() = default;
     Renderer(const Renderer&) = delete;
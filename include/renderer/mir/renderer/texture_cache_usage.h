@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_TEXTURE_CACHE_USAGE_H_
+#define MIR_RENDERER_TEXTURE_CACHE_USAGE_H_
+
+#include <cstddef>
+
+namespace mir
+{
+namespace renderer
+{
+
+/**
+ * How a renderer's cache of the textures of renderables has fared.
+ *
+ * The counts are of the frames since usage was last asked for; the sizes are
+ * of what the cache holds now.
+ */
+struct TextureCacheUsage
+{
+    /// Textures drawn as they were left, with no need to load their buffer
+    std::size_t hits;
+    /// Textures that had to be loaded from their buffer
+    std::size_t misses;
+    /// Textures of renderables no longer drawn that were freed to keep to the budget
+    std::size_t evictions;
+    /// Bytes of texture held, for renderables drawn or not
+    std::size_t resident_bytes;
+    /// Bytes of texture the cache may hold before freeing those of renderables not drawn
+    std::size_t budget_bytes;
+};
+
+}
+}
+
+#endif // MIR_RENDERER_TEXTURE_CACHE_USAGE_H_
@@ -98,6 +98,9 @@ public:
     MOCK_METHOD9(glTexImage2D,
                  void(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum,
                       GLenum,const GLvoid*));
+    MOCK_METHOD9(glTexSubImage2D,
+                 void(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum,
+                      GLenum, const GLvoid*));
     MOCK_METHOD3(glTexParameteri, void(GLenum, GLenum, GLenum));
     MOCK_METHOD2(glUniform1f, void(GLint, GLfloat));
     MOCK_METHOD3(glUniform2f, void(GLint, GLfloat, GLfloat));
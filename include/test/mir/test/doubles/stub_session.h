@@ -38,6 +38,8 @@ struct StubSession : scene::Session
 
     void take_snapshot(scene::SnapshotCallback const& snapshot_taken) override;
 
+    void take_thumbnail(geometry::Size const& max_size, scene::SnapshotCallback const& thumbnail_taken) override;
+
     std::shared_ptr<scene::Surface> default_surface() const override;
 
     void set_lifecycle_state(MirLifecycleState state) override;
@@ -77,6 +79,8 @@ struct StubSession : scene::Session
 
     void send_input_config(MirInputConfig const& config) override;
 
+    auto memory_account() const -> std::shared_ptr<scene::MemoryAccount> override;
+
     pid_t pid;
 };
 }
@@ -31,6 +31,7 @@
 #include <string.h>
 #include <system_error>
 #include <algorithm>
+#include <array>
 
 namespace md = mir::dispatch;
 
@@ -108,43 +109,119 @@ bool md::MultiplexingDispatchable::dispatch(md::FdEvents events)
         return false;
     }
 
-    std::shared_ptr<md::Dispatchable> source;
-    bool rearm_source{false};
-    epoll_event event;
+    // Collect as many ready sources as we can in one go: this amortises the epoll_wait()
+    // syscall and the lifetime_mutex round-trip across the whole batch.
+    //
+    // epoll hands back its ready list in FIFO order and requeues level-triggered sources
+    // at the tail, so a source that is always readable can't starve the others.
+    //
+    // When other threads are dispatching concurrently batching would just serialise work
+    // they could be doing, so take a single event and hand back the remainder of any
+    // batch already in progress.
+    auto const counting = mir::raii::paired_calls(
+        [this]{ ++dispatching_threads; },
+        [this]{ --dispatching_threads; });
+    int const batch_size = dispatching_threads > 1 ? 1 : max_events_per_dispatch;
+
+    std::array<epoll_event, max_events_per_dispatch> ready;
+    std::array<std::shared_ptr<md::Dispatchable>, max_events_per_dispatch> sources;
+    std::array<bool, max_events_per_dispatch> rearm_source;
+    int ready_count{0};
+    uint64_t removals_seen{0};
 
     {
         std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
 
-        auto result = epoll_wait(epoll_fd, &event, 1, 0);
+        ready_count = epoll_wait(epoll_fd, ready.data(), batch_size, 0);
 
-        if (result < 0)
+        if (ready_count < 0)
         {
             BOOST_THROW_EXCEPTION((std::system_error{errno,
                                                      std::system_category(),
                                                      "Failed to wait on fds"}));
         }
 
-        if (result == 0)
+        if (ready_count == 0)
         {
             // Some other thread must have stolen the event we were woken for;
             // that's ok, just return.
             return true;
         }
 
-        auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(event.data.ptr);
+        for (int i = 0; i != ready_count; ++i)
+        {
+            auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(ready[i].data.ptr);
 
-        source = event_source->first;
-        rearm_source = event_source->second;
-    }
+            sources[i] = event_source->first;
+            rearm_source[i] = event_source->second;
+        }
 
-    if (!source->dispatch(epoll_to_fd_event(event)))
-    {
-        remove_watch(source);
+        removals_seen = removal_count;
     }
-    else if (rearm_source)
+
+    auto const rearm = [this](md::Dispatchable& source, epoll_event& event)
+        {
+            event.events = fd_event_to_epoll(source.relevant_events()) | EPOLLONESHOT;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source.watch_fd(), &event);
+        };
+
+    auto const rearm_from = [&](int first)
+        {
+            for (int j = first; j != ready_count; ++j)
+            {
+                if (rearm_source[j])
+                    rearm(*sources[j], ready[j]);
+            }
+        };
+
+    for (int i = 0; i != ready_count; ++i)
     {
-        event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
-        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        auto& source = sources[i];
+
+        if (i != 0 && dispatching_threads > 1)
+        {
+            rearm_from(i);
+            break;
+        }
+
+        // An earlier dispatch in this batch (or another thread) may have removed this source
+        if (removal_count != removals_seen)
+        {
+            std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+
+            removals_seen = removal_count;
+            auto const still_watched = std::any_of(
+                dispatchee_holder.begin(),
+                dispatchee_holder.end(),
+                [&source](std::pair<std::shared_ptr<Dispatchable>,bool> const& candidate)
+                {
+                    return candidate.first == source;
+                });
+
+            if (!still_watched)
+                continue;
+        }
+
+        bool keep_source;
+        try
+        {
+            keep_source = source->dispatch(epoll_to_fd_event(ready[i]));
+        }
+        catch (...)
+        {
+            // Don't leave the rest of the batch disarmed just because this one threw
+            rearm_from(i + 1);
+            throw;
+        }
+
+        if (!keep_source)
+        {
+            remove_watch(source);
+        }
+        else if (rearm_source[i])
+        {
+            rearm(*source, ready[i]);
+        }
     }
 
     return true;
@@ -223,6 +300,7 @@ void md::MultiplexingDispatchable::remove_watch(Fd const& fd)
     }
 
     std::unique_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+    ++removal_count;
     dispatchee_holder.remove_if([&fd](std::pair<std::shared_ptr<Dispatchable>,bool> const& candidate)
     {
         return candidate.first->watch_fd() == fd;
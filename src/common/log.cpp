@@ -19,6 +19,7 @@
 #include "mir/log.h"
 #include "mir/logging/logger.h"
 #include <cstdio>
+#include <cstdarg>
 
 #include <exception>
 #include <boost/exception/diagnostic_information.hpp>
@@ -28,15 +29,26 @@ namespace mir {
 void logv(logging::Severity sev, char const* component,
           char const* fmt, va_list va)
 {
+    va_list va_retry;
+    va_copy(va_retry, va);
+
     char message[1024];
-    int max = sizeof(message) - 1;
-    int len = vsnprintf(message, max, fmt, va);
-    if (len > max)
-        len = max;
-    message[len] = '\0';
+    int const len = vsnprintf(message, sizeof message, fmt, va);
 
-    // Suboptimal: Constructing a std::string for message/component.
-    logging::log(sev, message, component);
+    if (len < 0 || static_cast<size_t>(len) < sizeof message)
+    {
+        va_end(va_retry);
+        // Suboptimal: Constructing a std::string for message/component.
+        logging::log(sev, len < 0 ? "" : message, component);
+        return;
+    }
+
+    // Too long for the stack buffer: format it again at full length rather than truncating
+    std::string long_message(len, '\0');
+    vsnprintf(&long_message[0], len + 1, fmt, va_retry);
+    va_end(va_retry);
+
+    logging::log(sev, long_message, component);
 }
 
 void log(logging::Severity sev, char const* component,
@@ -0,0 +1,359 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+#include "mir/thread_name.h"
+#include "console_format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <time.h>
+
+namespace ml = mir::logging;
+
+namespace
+{
+std::atomic<uint64_t> next_logger_id{1};
+
+auto const idle_wakeup = std::chrono::milliseconds{100};
+}
+
+/// A single-producer, single-consumer ring of log lines.
+///
+/// Slots are reused rather than reallocated, so once a thread's lines have
+/// warmed up the string capacity logging doesn't touch the heap.
+class ml::AsyncLogger::Ring
+{
+public:
+    struct Line
+    {
+        Severity severity;
+        timespec when;
+        std::string message;
+        std::string component;
+    };
+
+    explicit Ring(size_t capacity)
+        : slots(capacity)
+    {
+    }
+
+    /// Called only by the owning thread
+    auto push(Severity severity, timespec const& when, std::string const& message, std::string const& component)
+        -> bool
+    {
+        auto const tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - head.load(std::memory_order_acquire) == slots.size())
+            return false;
+
+        auto& slot = slots[tail % slots.size()];
+        slot.severity = severity;
+        slot.when = when;
+        slot.message.assign(message);
+        slot.component.assign(component);
+
+        // seq_cst (rather than release) pairs with the writer's check before sleeping
+        this->tail.store(tail + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    /// Called only by the writer thread: hands the oldest line to \p consume
+    /// and releases its slot once that returns
+    template<typename Consume>
+    auto pop(Consume const& consume) -> bool
+    {
+        auto const head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire))
+            return false;
+
+        consume(slots[head % slots.size()]);
+
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    auto empty() const -> bool
+    {
+        return head.load() == tail.load();
+    }
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> orphaned{false};
+
+    /// Writer thread state used to collapse repeated lines
+    /// @{
+    Line last{};
+    bool has_last{false};
+    uint64_t repeats{0};
+    /// @}
+
+private:
+    std::vector<Line> slots;
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+};
+
+ml::AsyncLogger::AsyncLogger()
+    : AsyncLogger(std::cout, std::cerr, 1024)
+{
+}
+
+ml::AsyncLogger::AsyncLogger(std::ostream& out, std::ostream& err, size_t lines_per_thread)
+    : out(out),
+      err(err),
+      lines_per_thread{lines_per_thread},
+      id{next_logger_id++},
+      writer{[this] { run_writer(); }}
+{
+}
+
+ml::AsyncLogger::~AsyncLogger() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        stopping = true;
+        writer_cv.notify_one();
+    }
+
+    writer.join();
+}
+
+void ml::AsyncLogger::log(Severity severity, std::string const& message, std::string const& component)
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    auto& ring = ring_for_this_thread();
+
+    bool pushed = ring.push(severity, now, message, component);
+
+    if (!pushed && severity == Severity::critical)
+    {
+        // A critical message is worth waiting for
+        flush();
+        pushed = ring.push(severity, now, message, component);
+    }
+
+    if (!pushed)
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+
+    wake_writer();
+
+    // Critical messages usually come just before we fall over, so make sure they're out
+    if (severity == Severity::critical)
+        flush();
+}
+
+void ml::AsyncLogger::flush()
+{
+    std::unique_lock<std::mutex> lock{writer_mutex};
+
+    auto const target = passes_started + 1;
+    flush_requested = true;
+    writer_cv.notify_one();
+
+    flushed_cv.wait(lock, [&] { return passes_completed >= target; });
+}
+
+auto ml::AsyncLogger::stats() const -> Stats
+{
+    uint64_t pending_drops{0};
+    {
+        std::lock_guard<std::mutex> lock{rings_mutex};
+        for (auto const& ring : rings)
+            pending_drops += ring->dropped.load(std::memory_order_relaxed);
+    }
+
+    return {written.load(), dropped.load() + pending_drops, suppressed.load()};
+}
+
+auto ml::AsyncLogger::ring_for_this_thread() -> Ring&
+{
+    struct ThreadRing
+    {
+        uint64_t logger_id{0};
+        std::shared_ptr<Ring> ring;
+
+        ~ThreadRing()
+        {
+            if (ring)
+                ring->orphaned = true;
+        }
+    };
+
+    thread_local ThreadRing thread_ring;
+
+    if (thread_ring.logger_id != id)
+    {
+        if (thread_ring.ring)
+            thread_ring.ring->orphaned = true;
+
+        thread_ring.ring = std::make_shared<Ring>(lines_per_thread);
+        thread_ring.logger_id = id;
+
+        std::lock_guard<std::mutex> lock{rings_mutex};
+        rings.push_back(thread_ring.ring);
+        rings_changed = true;
+    }
+
+    return *thread_ring.ring;
+}
+
+void ml::AsyncLogger::wake_writer()
+{
+    // Either we see the writer is about to sleep, or it sees our line before it
+    // does. We only pay for the mutex when it is asleep.
+    if (writer_waiting.load())
+    {
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        work_pending = true;
+        writer_cv.notify_one();
+    }
+}
+
+void ml::AsyncLogger::run_writer()
+{
+    mir::set_thread_name("Mir/Logger");
+
+    std::vector<std::shared_ptr<Ring>> local_rings;
+
+    std::unique_lock<std::mutex> lock{writer_mutex};
+    for (;;)
+    {
+        flush_requested = false;
+        work_pending = false;
+        ++passes_started;
+        lock.unlock();
+
+        if (rings_changed.exchange(false))
+        {
+            std::lock_guard<std::mutex> rings_lock{rings_mutex};
+            local_rings = rings;
+        }
+
+        bool wrote{false};
+        for (auto const& ring : local_rings)
+            wrote |= drain(*ring);
+
+        if (wrote)
+        {
+            out.flush();
+            err.flush();
+        }
+
+        // Rings whose thread has gone away can go once they're empty
+        auto const finished = [](std::shared_ptr<Ring> const& ring) { return ring->orphaned && ring->empty(); };
+        if (std::any_of(local_rings.begin(), local_rings.end(), finished))
+        {
+            std::lock_guard<std::mutex> rings_lock{rings_mutex};
+            rings.erase(std::remove_if(rings.begin(), rings.end(), finished), rings.end());
+            local_rings = rings;
+        }
+
+        lock.lock();
+        ++passes_completed;
+        flushed_cv.notify_all();
+
+        if (wrote || flush_requested)
+            continue;
+
+        if (stopping)
+            break;
+
+        writer_waiting = true;
+
+        auto const pending = rings_changed ||
+            std::any_of(local_rings.begin(), local_rings.end(), [](auto const& ring) { return !ring->empty(); });
+
+        if (!pending)
+            writer_cv.wait_for(lock, idle_wakeup, [this] { return stopping || flush_requested || work_pending; });
+
+        writer_waiting = false;
+    }
+}
+
+auto ml::AsyncLogger::drain(Ring& ring) -> bool
+{
+    bool wrote{false};
+
+    auto const stream_for = [this](Severity severity) -> std::ostream&
+        {
+            return severity < Severity::informational ? err : out;
+        };
+
+    auto const write_repeats = [&]
+        {
+            if (ring.repeats)
+            {
+                write_console_line(
+                    stream_for(ring.last.severity),
+                    ring.last.severity,
+                    "(previous message repeated " + std::to_string(ring.repeats) + " times)",
+                    ring.last.component,
+                    ring.last.when);
+                ring.repeats = 0;
+                wrote = true;
+            }
+        };
+
+    while (ring.pop([&](Ring::Line const& line)
+        {
+            if (ring.has_last &&
+                line.severity == ring.last.severity &&
+                line.message == ring.last.message &&
+                line.component == ring.last.component)
+            {
+                ++ring.repeats;
+                ring.last.when = line.when;
+                suppressed.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            write_repeats();
+            write_console_line(stream_for(line.severity), line.severity, line.message, line.component, line.when);
+            written.fetch_add(1, std::memory_order_relaxed);
+            wrote = true;
+
+            ring.last.severity = line.severity;
+            ring.last.when = line.when;
+            ring.last.message.assign(line.message);
+            ring.last.component.assign(line.component);
+            ring.has_last = true;
+        }))
+    {
+    }
+
+    // At most one "repeated" note per pass, however fast the line is repeated
+    write_repeats();
+
+    if (auto const lost = ring.dropped.exchange(0, std::memory_order_relaxed))
+    {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        write_console_line(
+            err,
+            Severity::warning,
+            std::to_string(lost) + " log lines dropped: the logging thread's buffer was full",
+            "logging",
+            now);
+        dropped.fetch_add(lost, std::memory_order_relaxed);
+        wrote = true;
+    }
+
+    return wrote;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_LOGGING_CONSOLE_FORMAT_H_
+#define MIR_LOGGING_CONSOLE_FORMAT_H_
+
+#include "mir/logging/logger.h"
+
+#include <ostream>
+#include <string>
+#include <time.h>
+
+namespace mir
+{
+namespace logging
+{
+/// Writes (without flushing) a line in the format used by DumbConsoleLogger
+/// \param [in] when    CLOCK_REALTIME timestamp of the message
+void write_console_line(
+    std::ostream& out,
+    Severity severity,
+    std::string const& message,
+    std::string const& component,
+    timespec const& when);
+}
+}
+
+#endif // MIR_LOGGING_CONSOLE_FORMAT_H_
@@ -17,6 +17,7 @@
  */
 
 #include "mir/logging/dumb_console_logger.h"
+#include "console_format.h"
 
 #include <iostream>
 #include <ctime>
@@ -24,11 +25,13 @@
 
 namespace ml = mir::logging;
 
-void ml::DumbConsoleLogger::log(ml::Severity severity,
-                                const std::string& message,
-                                const std::string& component)
+void ml::write_console_line(
+    std::ostream& out,
+    Severity severity,
+    std::string const& message,
+    std::string const& component,
+    timespec const& when)
 {
-
     static const char* lut[5] =
     {
         "< CRITICAL! > ",
@@ -38,13 +41,10 @@ void ml::DumbConsoleLogger::log(ml::Severity severity,
         "< - debug - > "
     };
 
-    std::ostream& out = severity < ml::Severity::informational ? std::cerr : std::cout;
-
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
+    struct tm local;
     char now[32];
-    auto offset = strftime(now, sizeof(now), "%F %T", localtime(&ts.tv_sec));
-    snprintf(now+offset, sizeof(now)-offset, ".%06ld", ts.tv_nsec / 1000);
+    auto offset = strftime(now, sizeof(now), "%F %T", localtime_r(&when.tv_sec, &local));
+    snprintf(now+offset, sizeof(now)-offset, ".%06ld", when.tv_nsec / 1000);
 
     out << "["
         << now
@@ -53,5 +53,18 @@ void ml::DumbConsoleLogger::log(ml::Severity severity,
         << component
         << ": "
         << message
-        << std::endl;
+        << '\n';
+}
+
+void ml::DumbConsoleLogger::log(ml::Severity severity,
+                                const std::string& message,
+                                const std::string& component)
+{
+    std::ostream& out = severity < ml::Severity::informational ? std::cerr : std::cout;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    write_console_line(out, severity, message, component, ts);
+    out.flush();
 }
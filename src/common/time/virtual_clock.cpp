@@ -0,0 +1,92 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/virtual_clock.h"
+
+namespace mt = mir::time;
+
+namespace
+{
+// How often something that doesn't know time can jump should look again
+mt::Duration const polling_interval{std::chrono::milliseconds{100}};
+}
+
+mt::VirtualClock::VirtualClock(Timestamp start)
+    : current{start}
+{
+}
+
+mt::Timestamp mt::VirtualClock::now() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return current;
+}
+
+mt::Duration mt::VirtualClock::min_wait_until(Timestamp t) const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return t <= current ? Duration{0} : polling_interval;
+}
+
+void mt::VirtualClock::advance_by(Duration step)
+{
+    if (step <= Duration{0})
+        return;
+
+    Timestamp t;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        t = current + step;
+    }
+    set(t);
+}
+
+void mt::VirtualClock::advance_to(Timestamp t)
+{
+    set(t);
+}
+
+void mt::VirtualClock::set(Timestamp t)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (t <= current)
+            return;
+        current = t;
+    }
+    changed.notify_all();
+
+    std::lock_guard<std::mutex> lock{callbacks_mutex};
+    for (auto callback = callbacks.begin(); callback != callbacks.end();)
+    {
+        if ((*callback)(t))
+            ++callback;
+        else
+            callback = callbacks.erase(callback);
+    }
+}
+
+bool mt::VirtualClock::wait_until(Timestamp t, std::chrono::steady_clock::duration timeout) const
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    return changed.wait_for(lock, timeout, [&] { return current >= t; });
+}
+
+void mt::VirtualClock::register_time_change_callback(std::function<bool(Timestamp)> const& callback)
+{
+    std::lock_guard<std::mutex> lock{callbacks_mutex};
+    callbacks.push_back(callback);
+}
@@ -23,6 +23,14 @@
 
 namespace mgl = mir::gl;
 
+mgl::DefaultProgramFactory::DefaultProgramFactory(
+    ChargeTextureMemory const& charge_texture_memory,
+    std::size_t texture_cache_budget)
+    : charge_texture_memory{charge_texture_memory},
+      texture_cache_budget{texture_cache_budget}
+{
+}
+
 std::unique_ptr<mgl::Program>
 mgl::DefaultProgramFactory::create_gl_program(
     std::string const& vertex_shader,
@@ -35,5 +43,5 @@ mgl::DefaultProgramFactory::create_gl_program(
 
 std::unique_ptr<mgl::TextureCache> mgl::DefaultProgramFactory::create_texture_cache() const
 {
-    return std::make_unique<RecentlyUsedCache>();
+    return std::make_unique<RecentlyUsedCache>(charge_texture_memory, texture_cache_budget);
 }
@@ -0,0 +1,185 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/gl/pixel_pack_reader.h"
+#include "mir/gl/proc_address.h"
+
+#include <cstdio>
+
+namespace mgl = mir::gl;
+namespace geom = mir::geometry;
+
+namespace
+{
+// GLES 3 and GL 3.2 names; the GLES 2 headers we build against lack them
+GLenum const pixel_pack_buffer{0x88EB};          // GL_PIXEL_PACK_BUFFER
+GLenum const stream_read{0x88E1};                // GL_STREAM_READ
+GLbitfield const map_read_bit{0x0001};           // GL_MAP_READ_BIT
+GLenum const sync_gpu_commands_complete{0x9117}; // GL_SYNC_GPU_COMMANDS_COMPLETE
+GLenum const already_signaled{0x911A};           // GL_ALREADY_SIGNALED
+GLenum const condition_satisfied{0x911C};        // GL_CONDITION_SATISFIED
+GLbitfield const sync_flush_commands_bit{0x1};   // GL_SYNC_FLUSH_COMMANDS_BIT
+std::uint64_t const timeout_ignored{~0ull};      // GL_TIMEOUT_IGNORED
+
+GLsizeiptr const bytes_per_pixel{4};
+
+/// Pixel-pack buffers and fence syncs are core in GLES 3.0 and GL 3.2
+bool supports_pixel_pack_buffers()
+{
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    if (!version)
+        return false;
+
+    int major{0}, minor{0};
+    if (std::sscanf(version, "OpenGL ES %d.%d", &major, &minor) == 2)
+        return major >= 3;
+
+    if (std::sscanf(version, "%d.%d", &major, &minor) == 2)
+        return major > 3 || (major == 3 && minor >= 2);
+
+    return false;
+}
+}
+
+auto mgl::PixelPackReader::create(std::size_t max_pending) -> std::unique_ptr<PixelPackReader>
+{
+    if (!supports_pixel_pack_buffers())
+        return nullptr;
+
+    std::unique_ptr<PixelPackReader> reader{new PixelPackReader{max_pending}};
+    if (!reader->usable())
+        return nullptr;
+
+    return reader;
+}
+
+mgl::PixelPackReader::PixelPackReader(std::size_t max_pending) :
+    max_pending{max_pending},
+    map_buffer_range{proc_address<decltype(map_buffer_range)>("glMapBufferRange")},
+    unmap_buffer{proc_address<decltype(unmap_buffer)>("glUnmapBuffer")},
+    fence_sync{proc_address<decltype(fence_sync)>("glFenceSync")},
+    client_wait_sync{proc_address<decltype(client_wait_sync)>("glClientWaitSync")},
+    delete_sync{proc_address<decltype(delete_sync)>("glDeleteSync")}
+{
+}
+
+mgl::PixelPackReader::~PixelPackReader()
+{
+    for (auto const& read : pending)
+    {
+        delete_sync(read.fence);
+        for (auto const& buffer : read.buffers)
+            free_buffers.push_back(buffer.first);
+
+        read.deliver(std::vector<unsigned char const*>(read.buffers.size(), nullptr));
+    }
+
+    if (!free_buffers.empty())
+        glDeleteBuffers(free_buffers.size(), free_buffers.data());
+}
+
+bool mgl::PixelPackReader::usable() const
+{
+    return map_buffer_range && unmap_buffer && fence_sync && client_wait_sync && delete_sync;
+}
+
+void mgl::PixelPackReader::read(std::vector<geom::Rectangle> const& rects, Deliver const& deliver)
+{
+    Read read{{}, nullptr, deliver};
+    for (auto const& rect : rects)
+    {
+        auto const buffer = allocate();
+        GLsizeiptr const size{rect.size.width.as_int() * rect.size.height.as_int() * bytes_per_pixel};
+
+        glBindBuffer(pixel_pack_buffer, buffer);
+        glBufferData(pixel_pack_buffer, size, nullptr, stream_read);
+        glReadPixels(
+            rect.top_left.x.as_int(), rect.top_left.y.as_int(),
+            rect.size.width.as_int(), rect.size.height.as_int(),
+            GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        read.buffers.emplace_back(buffer, size);
+    }
+    glBindBuffer(pixel_pack_buffer, 0);
+
+    read.fence = fence_sync(sync_gpu_commands_complete, 0);
+    pending.push_back(std::move(read));
+
+    if (pending.size() > max_pending)
+        deliver_oldest(timeout_ignored);
+}
+
+bool mgl::PixelPackReader::collect(std::uint64_t timeout_ns)
+{
+    while (!pending.empty() && deliver_oldest(timeout_ns))
+        timeout_ns = 0;
+
+    return !pending.empty();
+}
+
+bool mgl::PixelPackReader::reading() const
+{
+    return !pending.empty();
+}
+
+bool mgl::PixelPackReader::deliver_oldest(std::uint64_t timeout_ns)
+{
+    auto const status = client_wait_sync(pending.front().fence, sync_flush_commands_bit, timeout_ns);
+    if (status != already_signaled && status != condition_satisfied)
+        return false;
+
+    // Delivering may start reads of its own
+    auto const read = std::move(pending.front());
+    pending.pop_front();
+    delete_sync(read.fence);
+
+    std::vector<unsigned char const*> rows;
+    for (auto const& buffer : read.buffers)
+    {
+        glBindBuffer(pixel_pack_buffer, buffer.first);
+        rows.push_back(static_cast<unsigned char const*>(
+            map_buffer_range(pixel_pack_buffer, 0, buffer.second, map_read_bit)));
+    }
+
+    read.deliver(rows);
+
+    for (std::size_t i = 0; i != read.buffers.size(); ++i)
+    {
+        if (rows[i])
+        {
+            glBindBuffer(pixel_pack_buffer, read.buffers[i].first);
+            unmap_buffer(pixel_pack_buffer);
+        }
+        free_buffers.push_back(read.buffers[i].first);
+    }
+    glBindBuffer(pixel_pack_buffer, 0);
+
+    return true;
+}
+
+auto mgl::PixelPackReader::allocate() -> GLuint
+{
+    if (free_buffers.empty())
+    {
+        GLuint buffer{0};
+        glGenBuffers(1, &buffer);
+        return buffer;
+    }
+
+    auto const buffer = free_buffers.back();
+    free_buffers.pop_back();
+    return buffer;
+}
@@ -21,7 +21,9 @@
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/gl/texture_source.h"
 
+#include <algorithm>
 #include <stdexcept>
+#include <vector>
 #include <boost/throw_exception.hpp>
 
 namespace mg = mir::graphics;
@@ -29,27 +31,67 @@ namespace mgl = mir::gl;
 namespace geom = mir::geometry;
 namespace mrgl = mir::renderer::gl;
 
+namespace
+{
+auto texture_size(mg::Buffer const& buffer) -> std::size_t
+{
+    // Formats we know nothing of are most likely 32bpp
+    std::size_t const bytes_per_pixel = MIR_BYTES_PER_PIXEL(buffer.pixel_format());
+    auto const size = buffer.size();
+    return std::size_t{size.width.as_uint32_t()} * size.height.as_uint32_t() *
+        (bytes_per_pixel ? bytes_per_pixel : 4);
+}
+}
+
+mgl::RecentlyUsedCache::RecentlyUsedCache(ChargeTextureMemory const& charge, std::size_t budget)
+    : charge_memory{charge},
+      budget{budget}
+{
+}
+
 std::shared_ptr<mgl::Texture> mgl::RecentlyUsedCache::load(mg::Renderable const& renderable)
 {
     auto const& buffer = renderable.buffer();
     auto buffer_id = buffer->id();
+    auto const submission = renderable.submission();
     auto& texture = textures[renderable.id()];
+
+    // Clients may submit the same buffer again, drawn afresh: only the submission
+    // tells that apart, so without it, textures not drawn last frame are stale
+    bool const resubmitted = submission ?
+        texture.last_bound_submission != submission :
+        texture.last_used + 1 < frame;
+    texture.last_used = frame;
     texture.texture->bind();
 
     auto const texture_source = dynamic_cast<mrgl::TextureSource*>(buffer->native_buffer_base());
     if (!texture_source)
         BOOST_THROW_EXCEPTION(std::logic_error("Buffer does not support GL rendering"));
 
-    if ((texture.last_bound_buffer != buffer_id) || (!texture.valid_binding))
+    if ((texture.last_bound_buffer != buffer_id) || (!texture.valid_binding) || resubmitted)
     {
         texture_source->bind();
         texture.resource = buffer;
         texture.last_bound_buffer = buffer_id;
+        texture.last_bound_submission = submission;
+
+        // Release the old charge first, so as not to count both at once
+        texture.memory_charge.reset();
+        if (charge_memory)
+            texture.memory_charge = charge_memory(renderable.id(), texture_size(*buffer));
+
+        resident_bytes.fetch_sub(texture.bytes, std::memory_order_relaxed);
+        texture.bytes = texture_size(*buffer);
+        resident_bytes.fetch_add(texture.bytes, std::memory_order_relaxed);
+        misses.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        hits.fetch_add(1, std::memory_order_relaxed);
     }
     texture_source->secure_for_render();
 
     texture.valid_binding = true;
-    texture.used = true;
 
     return texture.texture;
 }
@@ -62,19 +104,56 @@ void mgl::RecentlyUsedCache::invalidate()
 
 void mgl::RecentlyUsedCache::drop_unused()
 {
-    auto t = textures.begin();
-    while (t != textures.end())
-    {
-        auto& tex = t->second;
-        tex.resource.reset();
-        if (tex.used)
+    for (auto& t : textures)
+        t.second.resource.reset();
+
+    evict_to_budget();
+    ++frame;
+}
+
+auto mgl::RecentlyUsedCache::usage() -> renderer::TextureCacheUsage
+{
+    return {
+        hits.exchange(0, std::memory_order_relaxed),
+        misses.exchange(0, std::memory_order_relaxed),
+        evictions.exchange(0, std::memory_order_relaxed),
+        resident_bytes.load(std::memory_order_relaxed),
+        budget};
+}
+
+void mgl::RecentlyUsedCache::evict_to_budget()
+{
+    auto evict = [this](decltype(textures)::iterator t)
         {
-            tex.used = false;
+            resident_bytes.fetch_sub(t->second.bytes, std::memory_order_relaxed);
+            evictions.fetch_add(1, std::memory_order_relaxed);
+            return textures.erase(t);
+        };
+
+    // Invalidated textures not drawn since would have to be loaded again anyway
+    std::vector<decltype(textures)::iterator> hidden;
+    for (auto t = textures.begin(); t != textures.end();)
+    {
+        if (t->second.last_used == frame)
             ++t;
-        }
+        else if (!t->second.valid_binding)
+            t = evict(t);
         else
+            hidden.push_back(t++);
+    }
+
+    if (resident_bytes.load(std::memory_order_relaxed) <= budget)
+        return;
+
+    std::sort(hidden.begin(), hidden.end(), [](auto const& a, auto const& b)
         {
-            t = textures.erase(t);
-        }
+            return a->second.last_used < b->second.last_used;
+        });
+
+    for (auto const& t : hidden)
+    {
+        if (resident_bytes.load(std::memory_order_relaxed) <= budget)
+            break;
+        evict(t);
     }
 }
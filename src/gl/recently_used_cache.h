@@ -24,6 +24,9 @@
 #include "mir/gl/texture.h"
 #include "mir/graphics/buffer_id.h"
 #include "mir/graphics/renderable.h"
+
+#include <atomic>
+#include <cstdint>
 #include <unordered_map>
 
 namespace mir
@@ -31,12 +34,31 @@ namespace mir
 namespace graphics { class Buffer; }
 namespace gl
 {
+/**
+ * Keeps the textures of the renderables drawn in each frame and, within a
+ * budget, of those recently drawn: a window that is occluded, minimised or
+ * otherwise not drawn for a while need not be loaded again when it is
+ * shown, unless its buffer changed meanwhile. A buffer submitted again is a
+ * change, so for renderables that don't know their submission() the
+ * textures of those not drawn in the previous frame are loaded again.
+ *
+ * Textures of renderables that weren't drawn in a frame are freed least
+ * recently drawn first until all the textures held fit the budget. Those
+ * drawn in the frame are never freed for it.
+ */
 class RecentlyUsedCache : public TextureCache
 {
 public:
+    /**
+     * \param charge  charges the memory of the textures bound to renderables' buffers
+     * \param budget  bytes of texture to keep before freeing those of renderables not drawn
+     */
+    explicit RecentlyUsedCache(ChargeTextureMemory const& charge = {}, std::size_t budget = 0);
+
     std::shared_ptr<Texture> load(graphics::Renderable const& renderable) override;
     void invalidate() override;
     void drop_unused() override;
+    auto usage() -> renderer::TextureCacheUsage override;
 
 private:
     struct Entry
@@ -46,12 +68,28 @@ private:
         {}
         std::shared_ptr<Texture> texture;
         graphics::BufferID last_bound_buffer;
-        bool used{true};
+        /// The client submission last bound, or 0 if that wasn't known
+        std::uint64_t last_bound_submission{0};
         bool valid_binding{false};
         std::shared_ptr<graphics::Buffer> resource;
+        std::shared_ptr<void> memory_charge;
+        std::size_t bytes{0};
+        /// The frame it was last loaded in
+        std::uint64_t last_used{0};
     };
 
+    void evict_to_budget();
+
+    ChargeTextureMemory const charge_memory;
+    std::size_t const budget;
     std::unordered_map<graphics::Renderable::ID, Entry> textures;
+    std::uint64_t frame{0};
+
+    // Read by usage() without the GL context
+    std::atomic<std::size_t> hits{0};
+    std::atomic<std::size_t> misses{0};
+    std::atomic<std::size_t> evictions{0};
+    std::atomic<std::size_t> resident_bytes{0};
 };
 }
 }
@@ -49,6 +49,11 @@ void mgl::Texture::bind() const
     glBindTexture(GL_TEXTURE_2D, id);
 }
 
+GLuint mgl::Texture::tex_id() const
+{
+    return id;
+}
+
 mgl::Texture::~Texture()
 {
     glDeleteTextures(1, &id);
@@ -0,0 +1,302 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/gl/texture_atlas.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/pixel_conversion.h"
+#include "mir/renderer/sw/pixel_source.h"
+
+#include <algorithm>
+
+namespace mg = mir::graphics;
+namespace mgl = mir::gl;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+/// One atlas texture, filled by shelves: rows of content no taller than the row
+struct mgl::TextureAtlas::Page
+{
+    Page();
+
+    /// Finds room for \a size, returning false if there is none
+    bool allocate(geom::Size size, geom::Rectangle& area);
+    void free(geom::Rectangle const& area);
+
+    struct Shelf
+    {
+        int top;
+        int height;
+        int used_width;
+    };
+
+    Texture const texture;
+    std::vector<Shelf> shelves;
+    /// Space freed within the shelves, for reuse by content that fits it
+    std::vector<geom::Rectangle> free_areas;
+    int live{0};
+};
+
+namespace
+{
+bool cheaply_readable(mg::Buffer& buffer)
+{
+    auto const native = buffer.native_buffer_base();
+    return dynamic_cast<mrs::ReadMappableBuffer*>(native) ||
+           dynamic_cast<mrs::ReadTransferableBuffer*>(native) ||
+           dynamic_cast<mrs::PixelSource*>(native);
+}
+
+/// Copies the outermost texels of the \a size content centred in \a texels into its 1 texel border
+void extrude_edges(std::vector<uint32_t>& texels, geom::Size size)
+{
+    auto const width = size.width.as_int();
+    auto const height = size.height.as_int();
+
+    for (auto y = 1; y != height - 1; ++y)
+    {
+        auto const row = texels.data() + y * width;
+        row[0] = row[1];
+        row[width - 1] = row[width - 2];
+    }
+
+    std::copy_n(texels.data() + width, width, texels.data());
+    std::copy_n(texels.data() + (height - 2) * width, width, texels.data() + (height - 1) * width);
+}
+}
+
+mgl::TextureAtlas::Page::Page()
+{
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page_size, page_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+}
+
+bool mgl::TextureAtlas::Page::allocate(geom::Size size, geom::Rectangle& area)
+{
+    auto const width = size.width.as_int();
+    auto const height = size.height.as_int();
+
+    // The smallest freed area it fits, so long as it would waste under half of it
+    auto best = free_areas.end();
+    for (auto a = free_areas.begin(); a != free_areas.end(); ++a)
+    {
+        if (a->size.width.as_int() >= width && a->size.height.as_int() >= height &&
+            2 * width * height > a->size.width.as_int() * a->size.height.as_int() &&
+            (best == free_areas.end() ||
+             a->size.width.as_int() * a->size.height.as_int() <
+                best->size.width.as_int() * best->size.height.as_int()))
+        {
+            best = a;
+        }
+    }
+
+    if (best != free_areas.end())
+    {
+        area = {best->top_left, size};
+        free_areas.erase(best);
+        ++live;
+        return true;
+    }
+
+    // The lowest shelf with room that it doesn't leave mostly empty
+    for (auto& shelf : shelves)
+    {
+        if (shelf.height >= height && 2 * height > shelf.height &&
+            page_size - shelf.used_width >= width)
+        {
+            area = {{shelf.used_width, shelf.top}, size};
+            shelf.used_width += width;
+            ++live;
+            return true;
+        }
+    }
+
+    auto const top = shelves.empty() ? 0 : shelves.back().top + shelves.back().height;
+    if (top + height > page_size || width > page_size)
+        return false;
+
+    shelves.push_back({top, height, width});
+    area = {{0, top}, size};
+    ++live;
+    return true;
+}
+
+void mgl::TextureAtlas::Page::free(geom::Rectangle const& area)
+{
+    if (--live == 0)
+    {
+        shelves.clear();
+        free_areas.clear();
+    }
+    else
+    {
+        free_areas.push_back(area);
+    }
+}
+
+int const mgl::TextureAtlas::page_size;
+int const mgl::TextureAtlas::max_content_size;
+std::size_t const mgl::TextureAtlas::max_pages;
+int const mgl::TextureAtlas::frames_before_packing;
+
+mgl::TextureAtlas::TextureAtlas(ChargeTextureMemory const& charge)
+    : charge_memory{charge}
+{
+}
+
+mgl::TextureAtlas::~TextureAtlas() = default;
+
+auto mgl::TextureAtlas::load(mg::Renderable const& renderable) -> Entry const*
+{
+    auto const& buffer = renderable.buffer();
+    auto const size = buffer->size();
+
+    auto const belongs =
+        size.width.as_int() > 0 && size.width.as_int() <= max_content_size &&
+        size.height.as_int() > 0 && size.height.as_int() <= max_content_size &&
+        cheaply_readable(*buffer);
+
+    auto const found = slots.find(renderable.id());
+    if (!belongs)
+    {
+        if (found != slots.end())
+        {
+            unpack(found->second);
+            slots.erase(found);
+        }
+        return nullptr;
+    }
+
+    auto& slot = found != slots.end() ? found->second : slots[renderable.id()];
+    slot.used = true;
+
+    if (slot.buffer != buffer->id())
+    {
+        unpack(slot);
+        slot.buffer = buffer->id();
+        slot.frames_shown = 0;
+    }
+
+    if (!slot.packed && (slot.frames_shown < frames_before_packing || !pack(renderable, slot)))
+        return nullptr;
+
+    return &slot.entry;
+}
+
+void mgl::TextureAtlas::invalidate()
+{
+    for (auto& slot : slots)
+        unpack(slot.second);
+}
+
+void mgl::TextureAtlas::drop_unused()
+{
+    for (auto s = slots.begin(); s != slots.end();)
+    {
+        auto& slot = s->second;
+        if (slot.used)
+        {
+            slot.used = false;
+            slot.frames_shown = std::min(slot.frames_shown + 1, frames_before_packing);
+            ++s;
+        }
+        else
+        {
+            unpack(slot);
+            s = slots.erase(s);
+        }
+    }
+
+    // Slots refer to pages by index, so only empty pages at the end can go
+    while (!pages.empty() && pages.back()->live == 0)
+        pages.pop_back();
+}
+
+bool mgl::TextureAtlas::pack(mg::Renderable const& renderable, Slot& slot)
+{
+    auto const& buffer = renderable.buffer();
+    auto const size = buffer->size();
+    auto const width = size.width.as_int();
+    auto const height = size.height.as_int();
+    geom::Size const padded{width + 2, height + 2};
+
+    geom::Rectangle area;
+    auto page = 0u;
+    while (page != pages.size() && !pages[page]->allocate(padded, area))
+        ++page;
+
+    if (page == pages.size())
+    {
+        if (pages.size() == max_pages)
+            return false;
+
+        pages.push_back(std::make_unique<Page>());
+        if (!pages.back()->allocate(padded, area))
+            return false;
+    }
+
+    std::vector<uint32_t> texels(padded.width.as_int() * padded.height.as_int());
+    try
+    {
+        auto const mapping = mrs::as_read_mappable_buffer(buffer)->map_readable();
+        if (!mg::convert_pixels(
+                size, mapping->format(), mapping->data(), mapping->stride().as_int(),
+                mir_pixel_format_abgr_8888, texels.data() + padded.width.as_int() + 1,
+                padded.width.as_int() * 4))
+        {
+            pages[page]->free(area);
+            return false;
+        }
+    }
+    catch (std::exception const&)
+    {
+        pages[page]->free(area);
+        return false;
+    }
+
+    // Bilinear filtering at the content's edges samples the border, not the neighbours
+    extrude_edges(texels, padded);
+
+    auto const& texture = pages[page]->texture;
+    texture.bind();
+    glTexSubImage2D(
+        GL_TEXTURE_2D, 0,
+        area.top_left.x.as_int(), area.top_left.y.as_int(),
+        padded.width.as_int(), padded.height.as_int(),
+        GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+
+    GLfloat const scale = 1.0f / page_size;
+    auto const left = area.top_left.x.as_int() + 1;
+    auto const top = area.top_left.y.as_int() + 1;
+
+    slot.entry = {&texture, left * scale, top * scale, (left + width) * scale, (top + height) * scale};
+    slot.page = page;
+    slot.area = area;
+    slot.packed = true;
+
+    if (charge_memory)
+        slot.memory_charge = charge_memory(renderable.id(), std::size_t(width) * height * 4);
+
+    return true;
+}
+
+void mgl::TextureAtlas::unpack(Slot& slot)
+{
+    if (!slot.packed)
+        return;
+
+    pages[slot.page]->free(slot.area);
+    slot.packed = false;
+    slot.memory_charge.reset();
+}
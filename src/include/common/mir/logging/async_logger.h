@@ -0,0 +1,105 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_LOGGING_ASYNC_LOGGER_H_
+#define MIR_LOGGING_ASYNC_LOGGER_H_
+
+#include "mir/logging/logger.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mir
+{
+namespace logging
+{
+/**
+ * \brief A console logger that keeps formatting and I/O off the calling thread
+ *
+ * Each logging thread gets its own fixed-size ring buffer; a background thread
+ * drains them, formats the lines as DumbConsoleLogger does and writes them out.
+ * If a ring is full the line is dropped (and counted) rather than blocking the
+ * caller. Consecutive identical lines from a thread are collapsed into a
+ * "repeated N times" note. Critical messages are flushed before log() returns.
+ */
+class AsyncLogger : public Logger
+{
+public:
+    struct Stats
+    {
+        uint64_t written;       ///< Lines written out
+        uint64_t dropped;       ///< Lines lost because a thread's ring was full
+        uint64_t suppressed;    ///< Repeated lines collapsed by rate limiting
+    };
+
+    /// Logs to std::cout and std::cerr
+    AsyncLogger();
+
+    /// \param [in] lines_per_thread    Capacity of each thread's ring buffer
+    AsyncLogger(std::ostream& out, std::ostream& err, size_t lines_per_thread);
+
+    ~AsyncLogger() noexcept;
+
+    void log(Severity severity, const std::string& message, const std::string& component) override;
+
+    /// Blocks until everything logged before the call has been written out
+    void flush();
+
+    auto stats() const -> Stats;
+
+private:
+    class Ring;
+
+    auto ring_for_this_thread() -> Ring&;
+    void wake_writer();
+    void run_writer();
+    auto drain(Ring& ring) -> bool;
+
+    std::ostream& out;
+    std::ostream& err;
+    size_t const lines_per_thread;
+    uint64_t const id;
+
+    std::mutex mutable rings_mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::atomic<bool> rings_changed{false};
+
+    std::mutex writer_mutex;
+    std::condition_variable writer_cv;
+    std::condition_variable flushed_cv;
+    std::atomic<bool> writer_waiting{false};
+    bool stopping{false};
+    bool flush_requested{false};
+    bool work_pending{false};   ///< Lines were logged since the writer's last pass started
+    uint64_t passes_started{0};
+    uint64_t passes_completed{0};
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> suppressed{0};
+
+    std::thread writer;
+};
+}
+}
+
+#endif // MIR_LOGGING_ASYNC_LOGGER_H_
@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TIME_VIRTUAL_CLOCK_H_
+#define MIR_TIME_VIRTUAL_CLOCK_H_
+
+#include "mir/time/clock.h"
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+
+namespace mir
+{
+namespace time
+{
+/**
+ * A clock that only moves when it is told to.
+ *
+ * Used in place of SteadyClock it lets a simulation run the server's timers
+ * (and anything else timed by the clock) faster than real time, and step
+ * through them in the same order on every run.
+ *
+ * Anything waiting on the clock should register a time change callback to be
+ * woken when time moves; min_wait_until() can only suggest a polling interval.
+ */
+class VirtualClock : public Clock
+{
+public:
+    /// Starts at \a start; by default at a fixed time, so that runs are repeatable
+    explicit VirtualClock(Timestamp start = Timestamp{std::chrono::seconds{1}});
+
+    Timestamp now() const override;
+
+    /**
+     * Zero once \a t has been reached. Before then there is no knowing how
+     * long that will take in real time, so this is a polling interval.
+     */
+    Duration min_wait_until(Timestamp t) const override;
+
+    /// Moves time forward by \a step (time never moves backward)
+    void advance_by(Duration step);
+
+    /// Moves time forward to \a t, if it is later than now()
+    void advance_to(Timestamp t);
+
+    /**
+     * Blocks until time reaches \a t, or \a timeout of real time has passed.
+     * \return whether \a t was reached
+     */
+    bool wait_until(Timestamp t, std::chrono::steady_clock::duration timeout) const;
+
+    /**
+     * \brief Register a callback for when time moves
+     * \param callback  Called, on the thread that moved time, with the new time.
+     *                  If it returns false it will not be called again.
+     *                  It must not register further callbacks.
+     */
+    void register_time_change_callback(std::function<bool(Timestamp)> const& callback);
+
+private:
+    void set(Timestamp t);
+
+    std::mutex mutable mutex;
+    std::condition_variable mutable changed;
+    Timestamp current;
+
+    std::mutex callbacks_mutex;
+    std::list<std::function<bool(Timestamp)>> callbacks;
+};
+}
+}
+
+#endif // MIR_TIME_VIRTUAL_CLOCK_H_
@@ -20,6 +20,7 @@
 #define MIR_GL_DEFAULT_PROGRAM_FACTORY_H_
 
 #include "program_factory.h"
+#include "texture_cache.h"
 #include <mutex>
 
 namespace mir
@@ -29,10 +30,22 @@ namespace gl
 class DefaultProgramFactory : public ProgramFactory
 {
 public:
+    /**
+     * \param charge_texture_memory  given to the texture caches created
+     * \param texture_cache_budget   bytes of texture each cache created may keep
+     *                               for renderables not drawn
+     */
+    explicit DefaultProgramFactory(
+        ChargeTextureMemory const& charge_texture_memory = {},
+        std::size_t texture_cache_budget = 0);
+
     std::unique_ptr<Program> create_gl_program(std::string const&, std::string const&) const override;
     std::unique_ptr<TextureCache> create_texture_cache() const override;
 
 private:
+    ChargeTextureMemory const charge_texture_memory;
+    std::size_t const texture_cache_budget;
+
     /*
      * We need to serialize renderer creation because some GL calls used
      * during renderer construction that create unique resource ids
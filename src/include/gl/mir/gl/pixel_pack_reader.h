@@ -0,0 +1,106 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GL_PIXEL_PACK_READER_H_
+#define MIR_GL_PIXEL_PACK_READER_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include MIR_SERVER_GL_H
+
+namespace mir
+{
+namespace gl
+{
+/**
+ * Reads rectangles of the framebuffer back to the CPU through pixel-pack
+ * buffers and a fence, so that reading needn't wait for the GPU to finish
+ * drawing. The buffers are recycled from read to read.
+ *
+ * All methods must be called with the same GL context current.
+ */
+class PixelPackReader
+{
+public:
+    /**
+     * Called once the GPU has finished a read with the RGBA rows (bottom row
+     * first) of each rectangle read, in order. Those that couldn't be mapped,
+     * or all of them if the read was abandoned, are null.
+     */
+    using Deliver = std::function<void(std::vector<unsigned char const*> const& rows)>;
+
+    /**
+     * A reader for the current context, or nullptr if it lacks pixel-pack
+     * buffers and fence syncs (core in GLES 3.0 and GL 3.2).
+     * \param max_pending  reads in flight before read() waits for the oldest
+     */
+    static auto create(std::size_t max_pending) -> std::unique_ptr<PixelPackReader>;
+
+    /// Abandons the reads still pending
+    ~PixelPackReader();
+
+    /// Starts reading \a rects, in GL window coordinates, of the bound framebuffer
+    void read(std::vector<geometry::Rectangle> const& rects, Deliver const& deliver);
+
+    /**
+     * Delivers the reads the GPU has finished, oldest first, waiting up to
+     * \a timeout_ns for the first.
+     * \return whether reads remain pending
+     */
+    bool collect(std::uint64_t timeout_ns);
+
+    /// Whether reads are pending
+    bool reading() const;
+
+private:
+    using GLsyncHandle = struct __GLsync*;
+
+    struct Read
+    {
+        std::vector<std::pair<GLuint, GLsizeiptr>> buffers;
+        GLsyncHandle fence;
+        Deliver deliver;
+    };
+
+    explicit PixelPackReader(std::size_t max_pending);
+    PixelPackReader(PixelPackReader const&) = delete;
+    PixelPackReader& operator=(PixelPackReader const&) = delete;
+
+    bool usable() const;
+    /// Delivers the oldest pending read if the GPU finishes it within \a timeout_ns
+    bool deliver_oldest(std::uint64_t timeout_ns);
+    auto allocate() -> GLuint;
+
+    std::size_t const max_pending;
+    void* (*const map_buffer_range)(GLenum, GLintptr, GLsizeiptr, GLbitfield);
+    GLboolean (*const unmap_buffer)(GLenum);
+    GLsyncHandle (*const fence_sync)(GLenum, GLbitfield);
+    GLenum (*const client_wait_sync)(GLsyncHandle, GLbitfield, std::uint64_t);
+    void (*const delete_sync)(GLsyncHandle);
+
+    std::deque<Read> pending;
+    std::vector<GLuint> free_buffers;
+};
+}
+}
+
+#endif /* MIR_GL_PIXEL_PACK_READER_H_ */
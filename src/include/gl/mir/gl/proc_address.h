@@ -0,0 +1,38 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GL_PROC_ADDRESS_H_
+#define MIR_GL_PROC_ADDRESS_H_
+
+#include <EGL/egl.h>
+
+namespace mir
+{
+namespace gl
+{
+/**
+ * Looks up the GL or EGL entry point \a name, for those the headers we build
+ * against lack or that are extensions. Null if the implementation lacks it.
+ */
+template<typename Function>
+auto proc_address(char const* name) -> Function
+{
+    return reinterpret_cast<Function>(eglGetProcAddress(name));
+}
+}
+}
+
+#endif /* MIR_GL_PROC_ADDRESS_H_ */
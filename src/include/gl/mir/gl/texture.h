@@ -31,6 +31,8 @@ public:
     Texture();
     ~Texture();
     void bind() const;
+    /// The GL name of the texture, for attaching it to framebuffers and the like
+    GLuint tex_id() const;
 
 private:
     Texture(Texture const&) = delete;
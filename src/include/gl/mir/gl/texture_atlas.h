@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GL_TEXTURE_ATLAS_H_
+#define MIR_GL_TEXTURE_ATLAS_H_
+
+#include "mir/gl/texture_cache.h"
+#include "mir/gl/texture.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/graphics/renderable.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace gl
+{
+/**
+ * Packs the content of small, rarely changing renderables (cursors, icons,
+ * decoration parts) into a few shared textures, so that runs of them can be
+ * drawn with one texture bind and one draw call.
+ *
+ * Only buffers the CPU can read are packed: their pixels are copied into the
+ * atlas once they have been shown unchanged for a few frames. A renderable's
+ * content is taken to change only when its buffer does.
+ */
+class TextureAtlas
+{
+public:
+    /// Where a renderable's content is in the atlas
+    struct Entry
+    {
+        /// The texture holding it, shared with other entries
+        Texture const* page;
+        /// Its texture coordinates in \a page
+        GLfloat left, top, right, bottom;
+    };
+
+    /// The width and height of each atlas texture
+    static int const page_size = 1024;
+    /// The largest width or height of content packed
+    static int const max_content_size = 128;
+    /// The most atlas textures there will be at once
+    static std::size_t const max_pages = 4;
+    /// How many frames a buffer must be shown unchanged before it is packed
+    static int const frames_before_packing = 3;
+
+    /// \param charge  charges the texture memory packed content takes
+    explicit TextureAtlas(ChargeTextureMemory const& charge = {});
+    ~TextureAtlas();
+
+    /**
+     * The renderable's content in the atlas, packing it if it belongs there.
+     * Must be called with a current GL context.
+     * \return null if it is not (yet) in the atlas; otherwise valid until
+     *         the next call to drop_unused() or invalidate()
+     */
+    auto load(graphics::Renderable const& renderable) -> Entry const*;
+
+    /// The atlas textures need filling again; doesn't need a GL context
+    void invalidate();
+
+    /**
+     * Ends a frame: frees the space of renderables not loaded since the last
+     * drop. Must be called with a current GL context.
+     */
+    void drop_unused();
+
+private:
+    struct Page;
+
+    struct Slot
+    {
+        Entry entry;
+        std::size_t page;
+        geometry::Rectangle area;
+        graphics::BufferID buffer;
+        int frames_shown{0};
+        bool packed{false};
+        bool used{true};
+        std::shared_ptr<void> memory_charge;
+    };
+
+    bool pack(graphics::Renderable const& renderable, Slot& slot);
+    void unpack(Slot& slot);
+
+    ChargeTextureMemory const charge_memory;
+    std::vector<std::unique_ptr<Page>> pages;
+    std::unordered_map<graphics::Renderable::ID, Slot> slots;
+};
+}
+}
+
+#endif /* MIR_GL_TEXTURE_ATLAS_H_ */
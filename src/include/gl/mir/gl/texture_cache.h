@@ -20,14 +20,27 @@
 #ifndef MIR_GL_TEXTURE_CACHE_H_
 #define MIR_GL_TEXTURE_CACHE_H_
 
+#include "mir/graphics/renderable.h"
+#include "mir/renderer/texture_cache_usage.h"
+
+#include <cstddef>
+#include <functional>
 #include <memory>
 
 namespace mir
 {
-namespace graphics { class Renderable; }
 namespace gl
 {
 class Texture;
+
+/**
+ * Charges \a bytes of texture memory, held for the renderable \a id, to
+ * whoever owns its content until the returned handle is released. The handle
+ * may be null if there is nobody to charge.
+ */
+using ChargeTextureMemory =
+    std::function<std::shared_ptr<void>(graphics::Renderable::ID id, std::size_t bytes)>;
+
 class TextureCache
 {
 public:
@@ -53,10 +66,17 @@ public:
 
     /**
      * Free textures that were not used (loaded) since the last
-     * drop/invalidate. Must be called with a current GL context.
+     * drop/invalidate, as far as the cache needs to. Must be called with a
+     * current GL context.
      */
     virtual void drop_unused() = 0;
 
+    /**
+     * Hits, misses and evictions since the last call, and the memory held.
+     * Doesn't need a GL context.
+     */
+    virtual auto usage() -> renderer::TextureCacheUsage = 0;
+
 protected:
     TextureCache() = default;
 private:
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_PIXEL_CONVERSION_H_
+#define MIR_GRAPHICS_PIXEL_CONVERSION_H_
+
+#include "mir_toolkit/common.h"
+#include "mir/geometry/size.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mir
+{
+namespace graphics
+{
+
+/// The implementations of the pixel conversions: portable, or for a CPU's vector instructions
+enum class PixelKernels
+{
+    scalar,
+    sse2,
+    avx2,
+    neon
+};
+
+/// Whether \a kernels can run on this CPU
+bool available_pixel_kernels(PixelKernels kernels);
+
+/// The fastest kernels that can run on this CPU; those convert_pixels() and fill_pixels() use
+auto fastest_pixel_kernels() -> PixelKernels;
+
+/**
+ * Converts \a size pixels at \a source, in \a source_format, to \a dest, in
+ * \a dest_format.
+ *
+ * The rows of each are the given stride apart; a negative \a dest_stride
+ * writes the rows bottom up, from the row \a dest points to. Formats without
+ * alpha are treated as opaque.
+ *
+ * \return false (converting nothing) if either format is invalid
+ */
+bool convert_pixels(
+    geometry::Size const& size,
+    MirPixelFormat source_format, void const* source, int source_stride,
+    MirPixelFormat dest_format, void* dest, int dest_stride);
+
+/// As convert_pixels(), using \a kernels (which must be available)
+bool convert_pixels(
+    PixelKernels kernels,
+    geometry::Size const& size,
+    MirPixelFormat source_format, void const* source, int source_stride,
+    MirPixelFormat dest_format, void* dest, int dest_stride);
+
+/// Sets \a count 32-bit pixels at \a dest to \a value
+void fill_pixels(uint32_t* dest, std::size_t count, uint32_t value);
+
+/// As fill_pixels(), using \a kernels (which must be available)
+void fill_pixels(PixelKernels kernels, uint32_t* dest, std::size_t count, uint32_t value);
+
+/**
+ * Composites \a size pixels at \a source, in \a source_format, over those at
+ * \a dest, in \a dest_format, as the GL renderer blends: the source is taken
+ * as premultiplied and scaled by \a alpha, so that each component becomes
+ * source * alpha + dest * (1 - source alpha * alpha). Formats without alpha
+ * are treated as opaque.
+ *
+ * \return false (blending nothing) unless both formats are 32-bit
+ */
+bool blend_pixels(
+    geometry::Size const& size,
+    MirPixelFormat source_format, void const* source, int source_stride,
+    MirPixelFormat dest_format, void* dest, int dest_stride,
+    uint8_t alpha);
+
+/// As blend_pixels(), using \a kernels (which must be available)
+bool blend_pixels(
+    PixelKernels kernels,
+    geometry::Size const& size,
+    MirPixelFormat source_format, void const* source, int source_stride,
+    MirPixelFormat dest_format, void* dest, int dest_stride,
+    uint8_t alpha);
+
+}
+}
+
+#endif // MIR_GRAPHICS_PIXEL_CONVERSION_H_
@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_YUV_CONVERSION_H_
+#define MIR_GRAPHICS_YUV_CONVERSION_H_
+
+#include "mir/geometry/size.h"
+
+#include <array>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gl
+{
+class Program;
+class ProgramFactory;
+}
+
+/// The YCbCr to RGB matrix of the standard content was encoded to
+enum class YUVMatrix
+{
+    bt601,
+    bt709,
+    bt2020
+};
+
+/// Whether Y and CbCr take [16, 235] and [16, 240] of [0, 255] (as video does), or all of it
+enum class YUVRange
+{
+    limited,
+    full
+};
+
+struct YUVEncoding
+{
+    YUVMatrix matrix;
+    YUVRange range;
+};
+
+/**
+ * The encoding to assume for YUV content of \a size when nothing says:
+ * limited range, BT.601 for standard definition and BT.709 beyond it.
+ */
+auto default_yuv_encoding(geometry::Size const& size) -> YUVEncoding;
+
+/// Rows giving R, G and B from (Y, U, V, 1), for components normalised to [0, 1]
+using YUVToRGB = std::array<std::array<float, 4>, 3>;
+
+auto yuv_to_rgb(YUVEncoding const& encoding) -> YUVToRGB;
+
+/// Where YUV content's components are sampled from: the textures bound to tex[0], tex[1], …
+enum class YUVPlanes
+{
+    y_u_v,                  ///< Y, U and V each in the red channel of a texture of its own
+    y_uv,                   ///< Y in red of tex[0]; U and V in red and green of tex[1]
+    y_uv_luminance_alpha,   ///< Y in red of tex[0]; U and V in luminance and alpha of tex[1]
+    y_xuxv                  ///< Y in red of tex[0]; U and V in green and alpha of tex[1]
+};
+
+/// The number of textures \a planes takes
+auto plane_count(YUVPlanes planes) -> int;
+
+/**
+ * The program drawing YUV content, laid out as \a planes and encoded as
+ * \a encoding, as opaque RGB.
+ */
+auto yuv_shader(gl::ProgramFactory& factory, YUVPlanes planes, YUVEncoding const& encoding) -> gl::Program&;
+}
+}
+
+#endif // MIR_GRAPHICS_YUV_CONVERSION_H_
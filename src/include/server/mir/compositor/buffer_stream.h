@@ -25,6 +25,8 @@
 #include "mir_toolkit/common.h"
 #include "mir/graphics/buffer_id.h"
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 
 namespace mir
@@ -49,6 +51,18 @@ public:
     virtual void drop_old_buffers() = 0;
     virtual auto has_submitted_buffer() const -> bool = 0;
     virtual auto framedropping() const -> bool = 0;
+
+    /**
+     * As with_most_recent_buffer_do(), also passing the serial of the
+     * submission the buffer came from, or 0 if that is no longer known.
+     *
+     * Serials are never reused, so they tell resubmissions of a buffer apart.
+     */
+    virtual void with_most_recent_submission_do(
+        std::function<void(graphics::Buffer&, uint64_t submission)> const& exec) = 0;
+
+    /// The serial of the latest submission of the buffer identified by \a id, or 0 if that is no longer known
+    virtual auto submission_of(graphics::BufferID id) const -> uint64_t = 0;
 };
 
 }
@@ -20,6 +20,8 @@
 #define MIR_COMPOSITOR_COMPOSITOR_REPORT_H_
 
 #include "mir/graphics/renderable.h"
+#include "mir/renderer/gpu_timing.h"
+#include "mir/renderer/texture_cache_usage.h"
 
 namespace mir
 {
@@ -35,6 +37,10 @@ public:
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// GPU time of a frame rendered earlier on display \p id, once known
+    virtual void gpu_timed_frame(SubCompositorId id, renderer::GPUTiming const& timing) = 0;
+    /// How the texture cache of display \p id's renderer fared in the frames since last reported
+    virtual void texture_cache_used(SubCompositorId id, renderer::TextureCacheUsage const& usage) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_DAMAGE_TRACKER_H_
+#define MIR_COMPOSITOR_DAMAGE_TRACKER_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/graphics/renderable.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+
+/// Adds \a area to \a damage, merging it all into one rectangle once there is too much to track
+void add_damage(geometry::Rectangles& damage, geometry::Rectangle const& area);
+
+/**
+ * Works out what changed between the consecutive frames of one output by
+ * comparing the renderables they are made of.
+ */
+class DamageTracker
+{
+public:
+    /**
+     * \return the parts of \a view_area that differ between the previous frame
+     *         and one made of \a renderables. All of it, if there was no
+     *         previous frame or it showed a different area.
+     */
+    auto damage_for(geometry::Rectangle const& view_area, graphics::RenderableList const& renderables)
+        -> geometry::Rectangles;
+
+    /// Forgets the previous frame, so that all of the next is damaged
+    void reset();
+
+private:
+    struct Drawn
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer;
+        geometry::Rectangle position;
+        geometry::Rectangle clip;
+        float alpha;
+        glm::mat4 transformation;
+
+        auto visible_area() const -> geometry::Rectangle;
+        bool looks_same_as(Drawn const& other) const;
+    };
+
+    bool have_previous{false};
+    geometry::Rectangle previous_view_area;
+    std::vector<Drawn> previous;
+};
+
+}
+}
+
+#endif // MIR_COMPOSITOR_DAMAGE_TRACKER_H_
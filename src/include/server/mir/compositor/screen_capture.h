@@ -0,0 +1,193 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_SCREEN_CAPTURE_H_
+#define MIR_COMPOSITOR_SCREEN_CAPTURE_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/geometry/displacement.h"
+#include "mir/geometry/dimensions.h"
+#include "mir_toolkit/common.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace renderer { class Readback; }
+namespace compositor
+{
+
+/**
+ * Where a capture is copied to: a client's buffer.
+ *
+ * Called on the compositor thread that read the frame.
+ */
+class CaptureTarget
+{
+public:
+    virtual ~CaptureTarget() = default;
+
+    /**
+     * Copies the pixels of \a region (relative to the captured area) into the
+     * buffer. They are RGBA bytes (mir_pixel_format_abgr_8888), top row first.
+     */
+    virtual void write(geometry::Rectangle const& region, unsigned char const* pixels, geometry::Stride stride) = 0;
+
+    /// All that changed since the buffer's last capture, \a damage, has been written
+    virtual void captured(geometry::Rectangles const& damage) = 0;
+
+    /// The frame could not be read: the buffer's contents are undefined
+    virtual void failed() = 0;
+
+protected:
+    CaptureTarget() = default;
+    CaptureTarget(CaptureTarget const&) = delete;
+    CaptureTarget& operator=(CaptureTarget const&) = delete;
+};
+
+/**
+ * Copies \a size captured \a pixels (as given to CaptureTarget::write()) to
+ * \a dest in \a format. A negative \a dest_stride writes the rows bottom up,
+ * from the row \a dest points to.
+ * \return false (copying nothing) if \a format is not a 32-bit RGB format
+ */
+bool copy_captured_pixels(
+    geometry::Size const& size,
+    unsigned char const* pixels,
+    geometry::Stride stride,
+    unsigned char* dest,
+    int dest_stride,
+    MirPixelFormat format);
+
+/**
+ * Copies composited frames into client buffers.
+ *
+ * Each capture session remembers what it last copied into each buffer, so
+ * that capturing into the same buffer again only copies what has been damaged
+ * since. The copying is done by the compositor, from the frame it has just
+ * rendered, so capture costs nothing while nothing is being captured. An area
+ * spanning outputs is read from the frame of each output it overlaps, and its
+ * capture completes once all of them have been read.
+ */
+class ScreenCapture
+{
+public:
+    /// Identifies a buffer captured into; unique within a session while the buffer lives
+    using BufferKey = std::uintptr_t;
+
+    class Session : public std::enable_shared_from_this<Session>
+    {
+    public:
+        Session(
+            geometry::Rectangle const& area,
+            std::function<void()> const& schedule_frame,
+            std::function<std::vector<geometry::Rectangle>()> const& outputs);
+
+        auto area() const -> geometry::Rectangle;
+
+        /**
+         * Captures the next frame into \a target, the buffer identified by \a key.
+         * If nothing has changed since it was last captured into and not
+         * \a wait_for_damage, completes at once without copying anything;
+         * with \a wait_for_damage, waits for a frame that changes something.
+         * Fails at once if the area is on no output.
+         */
+        void capture(BufferKey key, std::shared_ptr<CaptureTarget> const& target, bool wait_for_damage);
+
+        /// The buffer identified by \a key has gone (so its key may be reused)
+        void forget(BufferKey key);
+
+        /**
+         * Called by the compositor of \a view_area with the \a damage of its
+         * next frame.
+         * \return the readbacks of that frame to satisfy pending captures
+         */
+        auto frame(geometry::Rectangle const& view_area, geometry::Rectangles const& damage)
+            -> std::vector<std::shared_ptr<renderer::Readback>>;
+
+        /// Whether readbacks of earlier frames have yet to finish
+        bool reading_back() const;
+
+    private:
+        class Readback;
+        struct Capture;
+
+        /// The damage to the area on each output (by view area); outputs not listed are unknown
+        using OutputDamage = std::vector<std::pair<geometry::Rectangle, geometry::Rectangles>>;
+
+        /// Completes \a capture if every output has been read from; call without the mutex held
+        void complete_if_done(std::shared_ptr<Capture> const& capture);
+
+        geometry::Rectangle const area_;
+        std::function<void()> const schedule_frame;
+        std::function<std::vector<geometry::Rectangle>()> const outputs;
+
+        std::mutex mutable mutex;
+        std::vector<std::shared_ptr<Capture>> pending;
+        /// What has changed since each known buffer was last captured into
+        std::map<BufferKey, OutputDamage> damage_since_capture;
+        /// Readbacks the renderer has yet to finish; we need frames until it does
+        int readbacks_in_flight{0};
+    };
+
+    /**
+     * \param schedule_frame  composites a frame soon, even if nothing has changed
+     * \param outputs         the view areas of the outputs being composited
+     */
+    ScreenCapture(
+        std::function<void()> const& schedule_frame,
+        std::function<std::vector<geometry::Rectangle>()> const& outputs);
+
+    /// Starts capturing \a area (in scene coordinates) until the session is released
+    auto open_session(geometry::Rectangle const& area) -> std::shared_ptr<Session>;
+
+    /// Whether any session is open; if none is, compositors needn't track damage
+    bool active() const;
+
+    /**
+     * Called by the compositor of \a view_area for each frame, with the
+     * \a damage since its previous one.
+     * \return the readbacks of the frame that open sessions need
+     */
+    auto frame(geometry::Rectangle const& view_area, geometry::Rectangles const& damage)
+        -> std::vector<std::shared_ptr<renderer::Readback>>;
+
+    /**
+     * Whether any session has readbacks yet to finish. Renderers complete
+     * them only from frames they render, so compositors must render (rather
+     * than bypass) frames until they have.
+     */
+    bool reading_back() const;
+
+private:
+    std::function<void()> const schedule_frame;
+    std::function<std::vector<geometry::Rectangle>()> const outputs;
+
+    std::mutex mutable mutex;
+    std::vector<std::weak_ptr<Session>> sessions;
+};
+
+}
+}
+
+#endif // MIR_COMPOSITOR_SCREEN_CAPTURE_H_
@@ -56,6 +56,7 @@ class Drawer;
 class DisplayBufferCompositorFactory;
 class Compositor;
 class CompositorReport;
+class ScreenCapture;
 }
 namespace frontend
 {
@@ -110,6 +111,7 @@ class SceneReport;
 class PromptSessionListener;
 class PromptSessionManager;
 class CoordinateTranslator;
+class MemoryAccounting;
 }
 namespace graphics
 {
@@ -160,6 +162,7 @@ class Configuration;
 namespace report
 {
 class ReportFactory;
+namespace metrics { class Registry; }
 }
 
 namespace renderer
@@ -260,6 +263,12 @@ public:
     virtual std::shared_ptr<compositor::Scene>                  the_scene();
     /** @} */
 
+    /** @name compositor configuration - services
+     * services provided by compositor for the rest of Mir
+     *  @{ */
+    virtual std::shared_ptr<compositor::ScreenCapture> the_screen_capture();
+    /** @} */
+
     /** @name frontend configuration - dependencies
      * dependencies of frontend on the rest of the Mir
      *  @{ */
@@ -326,6 +335,7 @@ public:
      *  @{ */
     virtual std::shared_ptr<scene::SessionCoordinator>  the_session_coordinator();
     virtual std::shared_ptr<scene::CoordinateTranslator> the_coordinate_translator();
+    virtual std::shared_ptr<scene::MemoryAccounting> the_memory_accounting();
     /** @} */
 
 
@@ -363,6 +373,7 @@ public:
 
     virtual std::shared_ptr<ConsoleServices> the_console_services();
     auto default_reports() -> std::shared_ptr<void>;
+    auto the_metrics_registry() -> std::shared_ptr<report::metrics::Registry>;
 
 private:
     // We need to ensure the platform library is destroyed last as the
@@ -442,6 +453,8 @@ protected:
     CachedPtr<compositor::DisplayBufferCompositorFactory> display_buffer_compositor_factory;
     CachedPtr<compositor::Compositor> compositor;
     CachedPtr<compositor::CompositorReport> compositor_report;
+    CachedPtr<compositor::ScreenCapture> screen_capture;
+    CachedPtr<report::metrics::Registry> metrics_registry;
     CachedPtr<logging::Logger> logger;
     CachedPtr<graphics::DisplayReport> display_report;
     CachedPtr<time::Clock> clock;
@@ -455,6 +468,7 @@ protected:
     CachedPtr<scene::PromptSessionManager> prompt_session_manager;
     CachedPtr<scene::SessionCoordinator> session_coordinator;
     CachedPtr<scene::CoordinateTranslator> coordinate_translator;
+    CachedPtr<scene::MemoryAccounting> memory_accounting;
     CachedPtr<EmergencyCleanup> emergency_cleanup;
     CachedPtr<shell::HostLifecycleEventListener> host_lifecycle_event_listener;
     CachedPtr<shell::PersistentSurfaceStore> persistent_surface_store;
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_MEMORY_ACCOUNT_H_
+#define MIR_SCENE_MEMORY_ACCOUNT_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+
+namespace mir
+{
+namespace graphics { class Buffer; }
+namespace scene
+{
+class SceneReport;
+
+/**
+ * The memory a session is responsible for: the buffers it has been given or
+ * has handed us, the shared memory of its we have mapped and the textures the
+ * compositor holds of its content.
+ *
+ * Memory is charged to the account for as long as the handle returned by
+ * charge() lives, so releasing the resource is all it takes to refund it.
+ * Charges may be made and released on any thread.
+ */
+class MemoryAccount : public std::enable_shared_from_this<MemoryAccount>
+{
+public:
+    enum class Kind
+    {
+        buffers,    ///< Graphics buffers allocated for, or imported from, the session
+        shm,        ///< Shared memory of the session's mapped by the server
+        textures    ///< Textures the compositor holds of the session's content
+    };
+    static constexpr std::size_t kind_count = 3;
+
+    struct Usage
+    {
+        std::array<std::size_t, kind_count> current;
+        std::array<std::size_t, kind_count> peak;
+        std::size_t total;
+        std::size_t peak_total;
+
+        auto current_in(Kind k) const -> std::size_t { return current[static_cast<std::size_t>(k)]; }
+        auto peak_in(Kind k) const -> std::size_t { return peak[static_cast<std::size_t>(k)]; }
+    };
+
+    /**
+     * \param limit   bytes the session may hold before \a report is told it
+     *                is over its limit; zero for no limit
+     */
+    MemoryAccount(
+        std::string const& session_name,
+        pid_t pid,
+        std::size_t limit,
+        std::shared_ptr<SceneReport> const& report);
+
+    auto session_name() const -> std::string;
+    auto process_id() const -> pid_t;
+    auto limit() const -> std::size_t;
+
+    /// A snapshot of what is charged now, and the most that has been at once
+    auto usage() const -> Usage;
+
+    /**
+     * Charges \a bytes of \a kind until the returned handle is released.
+     * Only the first charge to take the account over its limit is reported;
+     * the account has to drop back under it before the next one is.
+     */
+    auto charge(Kind kind, std::size_t bytes) -> std::shared_ptr<void>;
+
+    /**
+     * \return \a buffer, charged as \a bytes of \a kind until the last copy
+     *         of the result is released. It points to the same buffer.
+     */
+    auto charged(std::shared_ptr<graphics::Buffer> const& buffer, Kind kind, std::size_t bytes)
+        -> std::shared_ptr<graphics::Buffer>;
+
+    /// An estimate of the memory behind \a buffer, from its size and format
+    static auto estimated_size(graphics::Buffer const& buffer) -> std::size_t;
+
+private:
+    MemoryAccount(MemoryAccount const&) = delete;
+    MemoryAccount& operator=(MemoryAccount const&) = delete;
+
+    void refund(Kind kind, std::size_t bytes);
+
+    std::string const name;
+    pid_t const pid;
+    std::size_t const limit_;
+    std::shared_ptr<SceneReport> const report;
+
+    std::array<std::atomic<std::size_t>, kind_count> current{};
+    std::array<std::atomic<std::size_t>, kind_count> peak{};
+    std::atomic<std::size_t> total{0};
+    std::atomic<std::size_t> peak_total{0};
+    std::atomic<bool> over_limit{false};
+};
+}
+}
+
+#endif // MIR_SCENE_MEMORY_ACCOUNT_H_
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_MEMORY_ACCOUNTING_H_
+#define MIR_SCENE_MEMORY_ACCOUNTING_H_
+
+#include "mir/scene/memory_account.h"
+#include "mir/graphics/renderable.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+/**
+ * The memory accounts of all sessions.
+ *
+ * Also maps the streams sessions create to their accounts, so that memory
+ * held for a stream's content (which only knows the renderable it came from)
+ * can be charged to the session owning it.
+ */
+class MemoryAccounting
+{
+public:
+    /// \param session_limit  bytes each session may hold; zero for no limit
+    MemoryAccounting(std::size_t session_limit, std::shared_ptr<SceneReport> const& report);
+
+    auto open_account(std::string const& session_name, pid_t pid) -> std::shared_ptr<MemoryAccount>;
+
+    /// The accounts of the sessions still open (or still holding memory)
+    auto accounts() const -> std::vector<std::shared_ptr<MemoryAccount>>;
+
+    /// Memory held for the content of \a stream is charged to \a account
+    void attribute(graphics::Renderable::ID stream, std::shared_ptr<MemoryAccount> const& account);
+    void forget(graphics::Renderable::ID stream);
+
+    /**
+     * Charges \a bytes of texture memory, held for the renderable \a id, to
+     * the account its stream is attributed to.
+     * \return the charge, or null if the stream is attributed to no account
+     */
+    auto charge_texture(graphics::Renderable::ID id, std::size_t bytes) -> std::shared_ptr<void>;
+
+private:
+    std::size_t const session_limit;
+    std::shared_ptr<SceneReport> const report;
+
+    std::mutex mutable mutex;
+    std::vector<std::weak_ptr<MemoryAccount>> mutable open;
+    std::unordered_map<graphics::Renderable::ID, std::weak_ptr<MemoryAccount>> streams;
+};
+}
+}
+
+#endif // MIR_SCENE_MEMORY_ACCOUNTING_H_
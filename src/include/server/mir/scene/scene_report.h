@@ -20,7 +20,9 @@
 #ifndef MIR_SCENE_SCENE_REPORT_H_
 #define MIR_SCENE_SCENE_REPORT_H_
 
+#include <cstddef>
 #include <memory>
+#include <string>
 
 namespace mir
 {
@@ -36,6 +38,10 @@ public:
     virtual void surface_removed(BasicSurfaceId id, std::string const& name) = 0;
     virtual void surface_deleted(BasicSurfaceId id, std::string const& name) = 0;
 
+    /// The session \a session_name has been charged \a bytes of memory, more than its \a limit
+    virtual void session_memory_over_limit(
+        std::string const& session_name, std::size_t bytes, std::size_t limit) = 0;
+
 protected:
     SceneReport() = default;
     virtual ~SceneReport() = default;
@@ -56,6 +56,7 @@ namespace scene
 {
 class Surface;
 class SurfaceObserver;
+class MemoryAccount;
 struct SurfaceCreationParameters;
 
 /// A single connection to a client application
@@ -72,6 +73,8 @@ public:
     virtual void send_input_config(MirInputConfig const& config) = 0;
 
     virtual void take_snapshot(SnapshotCallback const& snapshot_taken) = 0;
+    /// Takes a snapshot scaled down to fit within \a max_size
+    virtual void take_thumbnail(geometry::Size const& max_size, SnapshotCallback const& thumbnail_taken) = 0;
     virtual auto default_surface() const -> std::shared_ptr<Surface> = 0;
     virtual void set_lifecycle_state(MirLifecycleState state) = 0;
 
@@ -100,6 +103,9 @@ public:
     virtual void destroy_buffer_stream(std::shared_ptr<frontend::BufferStream> const& stream) = 0;
     virtual void configure_streams(Surface& surface, std::vector<shell::StreamSpecification> const& config) = 0;
 
+    /// The memory the session is responsible for (may be null if nothing is accounted)
+    virtual auto memory_account() const -> std::shared_ptr<MemoryAccount> = 0;
+
 protected:
     Session() = default;
     Session(Session const&) = delete;
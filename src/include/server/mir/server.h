@@ -39,6 +39,7 @@ namespace graphics { class Cursor; class Platform; class Display; class GLConfig
 namespace input { class CompositeEventFilter; class InputDispatcher; class CursorListener; class CursorImages; class TouchVisualizer; class InputDeviceHub;}
 namespace logging { class Logger; }
 namespace options { class Option; }
+namespace time { class Clock; }
 namespace frontend
 {
 class SessionAuthorizer;
@@ -72,6 +73,7 @@ class SessionCoordinator;
 class SurfaceFactory;
 class CoordinateTranslator;
 class Session;
+class MemoryAccounting;
 }
 namespace input
 {
@@ -360,6 +362,9 @@ public:
     /// \return the cursor
     auto the_cursor() const -> std::shared_ptr<graphics::Cursor>;
 
+    /// \return the clock (a time::VirtualClock with --virtual-time).
+    auto the_clock() const -> std::shared_ptr<time::Clock>;
+
     /// \return the focus controller.
     auto the_focus_controller() const -> std::shared_ptr<shell::FocusController>;
 
@@ -383,6 +388,9 @@ public:
     /// \return the main loop.
     auto the_main_loop() const -> std::shared_ptr<MainLoop>;
 
+    /// \return the memory accounts of the sessions (with their totals and high-water marks).
+    auto the_memory_accounting() const -> std::shared_ptr<scene::MemoryAccounting>;
+
     /// \return the prompt session listener.
     auto the_prompt_session_listener() const -> std::shared_ptr<scene::PromptSessionListener>;
 
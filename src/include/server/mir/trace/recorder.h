@@ -0,0 +1,124 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TRACE_RECORDER_H_
+#define MIR_TRACE_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace trace
+{
+/**
+ * \brief An in-memory flight recorder for trace events
+ *
+ * Each recording thread gets a fixed-size ring of binary events, so recording
+ * takes no locks and allocates nothing after a thread's first event; once a
+ * ring is full the oldest events are overwritten. While disabled, recording
+ * costs a single relaxed load.
+ *
+ * Category and name strings are stored by pointer, so they must outlive the
+ * recorder - in practice, string literals.
+ *
+ * write_chrome_json() snapshots the rings in the Trace Event Format, which
+ * both chrome://tracing and https://ui.perfetto.dev open.
+ */
+class Recorder
+{
+public:
+    /// The recorder that MIR_TRACE_SCOPE() and the "trace" reports use
+    static auto instance() -> Recorder&;
+
+    /// \param [in] events_per_thread   Capacity of each thread's ring (rounded up to a power of two)
+    explicit Recorder(size_t events_per_thread);
+    ~Recorder();
+
+    void enable();
+    void disable();
+
+    auto enabled() const -> bool
+    {
+        return is_enabled.load(std::memory_order_relaxed);
+    }
+
+    void begin(char const* category, char const* name);
+    void end(char const* category, char const* name);
+    void instant(char const* category, char const* name, int64_t value);
+    void counter(char const* category, char const* name, int64_t value);
+
+    /// Writes the events currently held by the rings, oldest first per thread
+    void write_chrome_json(std::ostream& out) const;
+
+private:
+    Recorder(Recorder const&) = delete;
+    Recorder& operator=(Recorder const&) = delete;
+
+    class Ring;
+
+    void record(char phase, char const* category, char const* name, int64_t value);
+    auto ring_for_this_thread() -> Ring&;
+
+    size_t const events_per_thread;
+    uint64_t const id;
+    std::atomic<bool> is_enabled{false};
+
+    std::mutex mutable rings_mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+};
+
+/// Records a begin event on construction and the matching end on destruction
+class ScopedSpan
+{
+public:
+    ScopedSpan(char const* category, char const* name)
+        : category{category},
+          name{Recorder::instance().enabled() ? name : nullptr}
+    {
+        if (this->name)
+            Recorder::instance().begin(category, name);
+    }
+
+    ~ScopedSpan()
+    {
+        if (name)
+            Recorder::instance().end(category, name);
+    }
+
+private:
+    ScopedSpan(ScopedSpan const&) = delete;
+    ScopedSpan& operator=(ScopedSpan const&) = delete;
+
+    char const* const category;
+    char const* const name;
+};
+}
+}
+
+#define MIR_TRACE_SCOPE_CONCAT_(a, b) a##b
+#define MIR_TRACE_SCOPE_CONCAT(a, b) MIR_TRACE_SCOPE_CONCAT_(a, b)
+
+/// Traces the rest of the enclosing scope as a span on the calling thread
+#define MIR_TRACE_SCOPE(category, name) \
+    ::mir::trace::ScopedSpan const MIR_TRACE_SCOPE_CONCAT(mir_trace_scope_, __LINE__){category, name}
+
+#endif // MIR_TRACE_RECORDER_H_
@@ -23,7 +23,9 @@
 #include <cstring>
 #include <memory>
 #include <mir/graphics/graphic_buffer_allocator.h>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 
 namespace mg = mir::graphics;
 namespace mrs = mir::renderer::software;
@@ -31,6 +33,77 @@ namespace geom = mir::geometry;
 
 namespace
 {
+/**
+ * Recycles the bounce buffers of CopyMaps.
+ *
+ * Most mappings are brief, and of the same few sizes (cursors, decorations),
+ * so keeping a few bounce buffers around saves allocating and faulting in a
+ * fresh one each time.
+ */
+class BouncePool
+{
+public:
+    auto acquire(size_t size) -> std::vector<unsigned char>
+    {
+        std::vector<unsigned char> buffer;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+
+            // The smallest that's big enough
+            auto best = free.end();
+            for (auto i = free.begin(); i != free.end(); ++i)
+            {
+                if (i->capacity() >= size && (best == free.end() || i->capacity() < best->capacity()))
+                    best = i;
+            }
+
+            if (best != free.end())
+            {
+                buffer = std::move(*best);
+                free.erase(best);
+            }
+        }
+
+        buffer.resize(size);
+        return buffer;
+    }
+
+    void release(std::vector<unsigned char>&& buffer)
+    {
+        if (buffer.capacity() > max_pooled_bytes)
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (free.size() < max_pooled_buffers)
+        {
+            free.push_back(std::move(buffer));
+            return;
+        }
+
+        // Keep the biggest buffers: they're the most expensive to allocate
+        auto const smallest = std::min_element(
+            free.begin(), free.end(),
+            [](auto const& a, auto const& b) { return a.capacity() < b.capacity(); });
+
+        if (smallest->capacity() < buffer.capacity())
+            *smallest = std::move(buffer);
+    }
+
+private:
+    static size_t const max_pooled_buffers = 4;
+    static size_t const max_pooled_bytes = 16 * 1024 * 1024;
+
+    std::mutex mutex;
+    std::vector<std::vector<unsigned char>> free;
+};
+
+auto bounce_pool() -> std::shared_ptr<BouncePool>
+{
+    static auto const pool = std::make_shared<BouncePool>();
+    return pool;
+}
+
 template<
     typename BufferType,
     typename DataType,
@@ -41,16 +114,17 @@ class CopyMap : public mrs::Mapping<DataType>
 public:
     CopyMap(std::shared_ptr<BufferType> buffer)
         : buffer{std::move(buffer)},
+          pool{bounce_pool()},
           bounce_buffer{
-              std::make_unique<unsigned char[]>(
-                  this->buffer->stride().as_uint32_t() * this->buffer->size().height.as_uint32_t())}
+              pool->acquire(this->buffer->stride().as_uint32_t() * this->buffer->size().height.as_uint32_t())}
     {
-        Initialise(*this->buffer, bounce_buffer.get());
+        Initialise(*this->buffer, bounce_buffer.data());
     }
 
     ~CopyMap()
     {
-        Finalise(*buffer, bounce_buffer.get());
+        Finalise(*buffer, bounce_buffer.data());
+        pool->release(std::move(bounce_buffer));
     }
 
     auto format() const -> MirPixelFormat override
@@ -70,7 +144,7 @@ public:
 
     auto data() -> DataType* override
     {
-        return bounce_buffer.get();
+        return bounce_buffer.data();
     }
 
     auto len() const -> size_t override
@@ -79,7 +153,8 @@ public:
     }
 private:
     std::shared_ptr<BufferType> const buffer;
-    std::unique_ptr<unsigned char[]> const bounce_buffer;
+    std::shared_ptr<BouncePool> const pool;
+    std::vector<unsigned char> bounce_buffer;
 };
 
 void read_from_buffer(mrs::ReadTransferableBuffer& buffer, unsigned char* scratch_buffer)
@@ -92,6 +167,12 @@ void write_to_buffer(mrs::WriteTransferableBuffer& buffer, unsigned char const*
     buffer.transfer_into_buffer(scratch_buffer);
 }
 
+void clear_bounce_buffer(mrs::WriteTransferableBuffer& buffer, unsigned char* scratch_buffer)
+{
+    // A recycled bounce buffer holds whatever was last mapped; don't let that leak into this buffer
+    ::memset(scratch_buffer, 0, buffer.stride().as_uint32_t() * buffer.size().height.as_uint32_t());
+}
+
 template<typename Buffer, typename DataType>
 void noop(Buffer&, DataType*)
 {
@@ -203,7 +284,7 @@ auto as_write_mappable_buffer(
                 CopyMap<
                     mrs::WriteTransferableBuffer,
                     unsigned char,
-                    &noop,
+                    &clear_bounce_buffer,
                     &write_to_buffer>>(buffer);
         }
 
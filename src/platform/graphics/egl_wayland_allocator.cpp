@@ -32,18 +32,21 @@
 #include "mir/executor.h"
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
+#include "mir/graphics/yuv_conversion.h"
 
 #include MIR_SERVER_GL_H
 
+#include <vector>
+
 namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
 namespace
 {
-GLuint get_tex_id()
+auto get_tex_ids(std::size_t count) -> std::vector<GLuint>
 {
-    GLuint tex;
-    glGenTextures(1, &tex);
+    std::vector<GLuint> tex(count);
+    glGenTextures(count, tex.data());
     return tex;
 }
 
@@ -101,6 +104,35 @@ EGLint get_wl_egl_format(wl_resource* resource, mg::EGLExtensions::WaylandExtens
     return format;
 }
 
+/// How the planes of a YUV buffer are sampled, each plane an EGLImage of its own
+auto yuv_planes_for(EGLint egl_format) -> mg::YUVPlanes
+{
+    switch (egl_format)
+    {
+    case EGL_TEXTURE_Y_U_V_WL:
+        return mg::YUVPlanes::y_u_v;
+    case EGL_TEXTURE_Y_UV_WL:
+        return mg::YUVPlanes::y_uv;
+    case EGL_TEXTURE_Y_XUXV_WL:
+        return mg::YUVPlanes::y_xuxv;
+    default:
+        BOOST_THROW_EXCEPTION((std::logic_error{"Not a YUV texture format"}));
+    }
+}
+
+auto plane_count_for(EGLint egl_format) -> std::size_t
+{
+    if (egl_format == EGL_TEXTURE_RGB || egl_format == EGL_TEXTURE_RGBA)
+    {
+        return 1;
+    }
+    if (egl_format == EGL_TEXTURE_EXTERNAL_WL)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"External textures unimplemented"}));
+    }
+    return mg::plane_count(yuv_planes_for(egl_format));
+}
+
 class WaylandTexBuffer :
     public mg::BufferBasic,
     public mg::NativeBufferBase,
@@ -116,47 +148,50 @@ public:
         std::function<void()>&& on_release,
         std::shared_ptr<mir::Executor> wayland_executor)
         : ctx{std::move(ctx)},
-          tex{get_tex_id()},
           on_consumed{std::move(on_consumed)},
           on_release{std::move(on_release)},
           size_{get_wl_buffer_size(buffer, *extensions.wayland)},
           layout_{get_texture_layout(buffer, *extensions.wayland)},
           egl_format{get_wl_egl_format(buffer, *extensions.wayland)},
+          tex{get_tex_ids(plane_count_for(egl_format))},
           wayland_executor{std::move(wayland_executor)}
     {
-        if (egl_format != EGL_TEXTURE_RGB && egl_format != EGL_TEXTURE_RGBA)
-        {
-            BOOST_THROW_EXCEPTION((std::runtime_error{"YUV textures unimplemented"}));
-        }
         eglBindAPI(MIR_SERVER_EGL_OPENGL_API);
 
-        const EGLint image_attrs[] =
+        // YUV buffers are sampled plane by plane, and converted by the shader
+        for (auto plane = 0u; plane != tex.size(); ++plane)
+        {
+            const EGLint image_attrs[] =
+                {
+                    EGL_IMAGE_PRESERVED_KHR, EGL_TRUE,
+                    EGL_WAYLAND_PLANE_WL, static_cast<EGLint>(plane),
+                    EGL_NONE
+                };
+
+            auto egl_image = extensions.eglCreateImageKHR(
+                eglGetCurrentDisplay(),
+                EGL_NO_CONTEXT,
+                EGL_WAYLAND_BUFFER_WL,
+                buffer,
+                image_attrs);
+
+            if (egl_image == EGL_NO_IMAGE_KHR)
             {
-                EGL_IMAGE_PRESERVED_KHR, EGL_TRUE,
-                EGL_WAYLAND_PLANE_WL, 0,
-                EGL_NONE
-            };
-
-        auto egl_image = extensions.eglCreateImageKHR(
-            eglGetCurrentDisplay(),
-            EGL_NO_CONTEXT,
-            EGL_WAYLAND_BUFFER_WL,
-            buffer,
-            image_attrs);
-
-        if (egl_image == EGL_NO_IMAGE_KHR)
-            BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGLImage"));
-
-        glBindTexture(GL_TEXTURE_2D, tex);
-        extensions.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, egl_image);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // tex is now an EGLImage sibling, so we can free the EGLImage without
-        // freeing the backing data.
-        extensions.eglDestroyImageKHR(eglGetCurrentDisplay(), egl_image);
+                glDeleteTextures(tex.size(), tex.data());
+                BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGLImage"));
+            }
+
+            glBindTexture(GL_TEXTURE_2D, tex[plane]);
+            extensions.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, egl_image);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            // tex is now an EGLImage sibling, so we can free the EGLImage without
+            // freeing the backing data.
+            extensions.eglDestroyImageKHR(eglGetCurrentDisplay(), egl_image);
+        }
     }
 
     ~WaylandTexBuffer()
@@ -166,7 +201,7 @@ public:
             {
               context->make_current();
 
-              glDeleteTextures(1, &tex);
+              glDeleteTextures(tex.size(), tex.data());
 
               context->release_current();
             });
@@ -219,6 +254,11 @@ public:
 
     mir::graphics::gl::Program const& shader(mir::graphics::gl::ProgramFactory& cache) const override
     {
+        if (tex.size() > 1)
+        {
+            return mg::yuv_shader(cache, yuv_planes_for(egl_format), mg::default_yuv_encoding(size_));
+        }
+
         static int argb_shader{0};
         return cache.compile_fragment_shader(
             &argb_shader,
@@ -237,7 +277,11 @@ public:
 
     void bind() override
     {
-        glBindTexture(GL_TEXTURE_2D, tex);
+        for (auto plane = tex.size(); plane-- != 0;)
+        {
+            glActiveTexture(GL_TEXTURE0 + plane);
+            glBindTexture(GL_TEXTURE_2D, tex[plane]);
+        }
 
         std::lock_guard<decltype(consumed_mutex)> lock(consumed_mutex);
         on_consumed();
@@ -249,7 +293,6 @@ public:
     }
 private:
     std::shared_ptr<mir::renderer::gl::Context> const ctx;
-    GLuint const tex;
 
     std::mutex consumed_mutex;
     std::function<void()> on_consumed;
@@ -258,6 +301,8 @@ private:
     geom::Size const size_;
     Layout const layout_;
     EGLint const egl_format;
+    /// One texture per plane
+    std::vector<GLuint> const tex;
 
     std::shared_ptr<mir::Executor> const wayland_executor;
 };
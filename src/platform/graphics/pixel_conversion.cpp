@@ -0,0 +1,783 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_conversion.h"
+#include "mir/graphics/pixel_format_utils.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MIR_PIXEL_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MIR_PIXEL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+/*
+ * The kernels convert rows of the common formats. 32-bit pixels are values
+ * 0xAABBGGRR (abgr/xbgr) or 0xAARRGGBB (argb/xrgb); 24-bit pixels are bytes
+ * R,G,B (rgb_888) or B,G,R (bgr_888).
+ */
+struct RowKernels
+{
+    /// Copies 32-bit pixels, swapping red with blue and/or making them opaque
+    void (*convert_32)(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque);
+
+    /// Expands rgb_888 pixels to opaque abgr_8888 (or bgr_888 to argb_8888); \a swap reverses one of those
+    void (*expand_24)(uint8_t const* from, uint32_t* to, std::size_t count, bool swap);
+
+    void (*fill)(uint32_t* to, std::size_t count, uint32_t value);
+
+    /**
+     * Composites premultiplied 32-bit pixels, scaled by \a alpha, over those
+     * at \a to; swapping red with blue and/or making them opaque first
+     */
+    void (*over_32)(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque, uint8_t alpha);
+};
+
+uint32_t const opaque_alpha = 0xff000000;
+
+inline uint32_t swap_red_blue(uint32_t pixel)
+{
+    return (pixel & 0xff00ff00) | ((pixel << 16) & 0x00ff0000) | ((pixel >> 16) & 0x000000ff);
+}
+
+void convert_32_scalar(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque)
+{
+    auto const alpha = opaque ? opaque_alpha : 0;
+
+    if (swap)
+    {
+        for (std::size_t i = 0; i != count; ++i)
+            to[i] = swap_red_blue(from[i]) | alpha;
+    }
+    else
+    {
+        for (std::size_t i = 0; i != count; ++i)
+            to[i] = from[i] | alpha;
+    }
+}
+
+void expand_24_scalar(uint8_t const* from, uint32_t* to, std::size_t count, bool swap)
+{
+    for (std::size_t i = 0; i != count; ++i, from += 3)
+    {
+        to[i] = swap ?
+            opaque_alpha | from[0] << 16 | from[1] << 8 | from[2] :
+            opaque_alpha | from[2] << 16 | from[1] << 8 | from[0];
+    }
+}
+
+void fill_scalar(uint32_t* to, std::size_t count, uint32_t value)
+{
+    std::fill_n(to, count, value);
+}
+
+/// \a a * \a b / 255, rounded
+inline uint32_t multiply_255(uint32_t a, uint32_t b)
+{
+    auto const t = a * b + 0x80;
+    return (t + (t >> 8)) >> 8;
+}
+
+void over_32_scalar(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque, uint8_t alpha)
+{
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        auto const source = (swap ? swap_red_blue(from[i]) : from[i]) | (opaque ? opaque_alpha : 0);
+        auto const dest = to[i];
+        auto const keep = 0xff - multiply_255(source >> 24, alpha);
+
+        uint32_t result{0};
+        for (auto shift = 0; shift != 32; shift += 8)
+        {
+            auto const component =
+                multiply_255((source >> shift) & 0xff, alpha) + multiply_255((dest >> shift) & 0xff, keep);
+            result |= std::min(component, 0xffu) << shift;
+        }
+        to[i] = result;
+    }
+}
+
+RowKernels const scalar_kernels{&convert_32_scalar, &expand_24_scalar, &fill_scalar, &over_32_scalar};
+
+#ifdef MIR_PIXEL_KERNELS_X86
+__attribute__((target("sse2")))
+void convert_32_sse2(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque)
+{
+    auto const green_alpha = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+    auto const red_blue = _mm_set1_epi32(0x00ff00ff);
+    auto const alpha = _mm_set1_epi32(static_cast<int>(opaque ? opaque_alpha : 0));
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(from + i));
+
+        if (swap)
+        {
+            auto const rb = _mm_and_si128(pixels, red_blue);
+            pixels = _mm_or_si128(
+                _mm_and_si128(pixels, green_alpha),
+                _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i), _mm_or_si128(pixels, alpha));
+    }
+
+    convert_32_scalar(from + i, to + i, count - i, swap, opaque);
+}
+
+__attribute__((target("sse2")))
+void fill_sse2(uint32_t* to, std::size_t count, uint32_t value)
+{
+    auto const pixels = _mm_set1_epi32(static_cast<int>(value));
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i), pixels);
+
+    fill_scalar(to + i, count - i, value);
+}
+
+__attribute__((target("sse2")))
+inline __m128i multiply_255_sse2(__m128i a, __m128i b)
+{
+    auto const t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(0x80));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/// Composites the two pixels of 16-bit components in \a source over those in \a dest
+__attribute__((target("sse2")))
+inline __m128i over_sse2(__m128i source, __m128i dest, __m128i alpha)
+{
+    auto const scaled = multiply_255_sse2(source, alpha);
+    // Alpha is the last component of each pixel
+    auto const scaled_alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(scaled, 0xff), 0xff);
+    auto const keep = _mm_sub_epi16(_mm_set1_epi16(0xff), scaled_alpha);
+    return _mm_add_epi16(scaled, multiply_255_sse2(dest, keep));
+}
+
+__attribute__((target("sse2")))
+void over_32_sse2(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque, uint8_t alpha)
+{
+    auto const green_alpha = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+    auto const red_blue = _mm_set1_epi32(0x00ff00ff);
+    auto const source_alpha = _mm_set1_epi32(static_cast<int>(opaque ? opaque_alpha : 0));
+    auto const global_alpha = _mm_set1_epi16(alpha);
+    auto const zero = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto source = _mm_loadu_si128(reinterpret_cast<__m128i const*>(from + i));
+        auto const dest = _mm_loadu_si128(reinterpret_cast<__m128i const*>(to + i));
+
+        if (swap)
+        {
+            auto const rb = _mm_and_si128(source, red_blue);
+            source = _mm_or_si128(
+                _mm_and_si128(source, green_alpha),
+                _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+        }
+        source = _mm_or_si128(source, source_alpha);
+
+        auto const low = over_sse2(
+            _mm_unpacklo_epi8(source, zero), _mm_unpacklo_epi8(dest, zero), global_alpha);
+        auto const high = over_sse2(
+            _mm_unpackhi_epi8(source, zero), _mm_unpackhi_epi8(dest, zero), global_alpha);
+
+        // Packing saturates what non-premultiplied content overflows
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i), _mm_packus_epi16(low, high));
+    }
+
+    over_32_scalar(from + i, to + i, count - i, swap, opaque, alpha);
+}
+
+// SSE2 has no byte shuffle, so there's nothing to gain over the scalar expansion
+RowKernels const sse2_kernels{&convert_32_sse2, &expand_24_scalar, &fill_sse2, &over_32_sse2};
+
+__attribute__((target("avx2")))
+void convert_32_avx2(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque)
+{
+    auto const green_alpha = _mm256_set1_epi32(static_cast<int>(0xff00ff00));
+    auto const red_blue = _mm256_set1_epi32(0x00ff00ff);
+    auto const alpha = _mm256_set1_epi32(static_cast<int>(opaque ? opaque_alpha : 0));
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto pixels = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(from + i));
+
+        if (swap)
+        {
+            auto const rb = _mm256_and_si256(pixels, red_blue);
+            pixels = _mm256_or_si256(
+                _mm256_and_si256(pixels, green_alpha),
+                _mm256_or_si256(_mm256_slli_epi32(rb, 16), _mm256_srli_epi32(rb, 16)));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), _mm256_or_si256(pixels, alpha));
+    }
+
+    convert_32_sse2(from + i, to + i, count - i, swap, opaque);
+}
+
+__attribute__((target("avx2")))
+void expand_24_avx2(uint8_t const* from, uint32_t* to, std::size_t count, bool swap)
+{
+    // Each 128-bit lane takes four pixels from the first 12 bytes loaded into it
+    auto const shuffle = swap ?
+        _mm256_setr_epi8(
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1) :
+        _mm256_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    auto const alpha = _mm256_set1_epi32(static_cast<int>(opaque_alpha));
+
+    std::size_t i = 0;
+    // The 16-byte loads read past the eight pixels used, so stop short of the end of the row
+    for (; i + 10 <= count; i += 8)
+    {
+        auto const low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(from + 3 * i));
+        auto const high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(from + 3 * (i + 4)));
+        auto const pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(to + i),
+            _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+    }
+
+    expand_24_scalar(from + 3 * i, to + i, count - i, swap);
+}
+
+__attribute__((target("avx2")))
+void fill_avx2(uint32_t* to, std::size_t count, uint32_t value)
+{
+    auto const pixels = _mm256_set1_epi32(static_cast<int>(value));
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), pixels);
+
+    fill_sse2(to + i, count - i, value);
+}
+
+__attribute__((target("avx2")))
+inline __m256i multiply_255_avx2(__m256i a, __m256i b)
+{
+    auto const t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(0x80));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+inline __m256i over_avx2(__m256i source, __m256i dest, __m256i alpha)
+{
+    auto const scaled = multiply_255_avx2(source, alpha);
+    auto const scaled_alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(scaled, 0xff), 0xff);
+    auto const keep = _mm256_sub_epi16(_mm256_set1_epi16(0xff), scaled_alpha);
+    return _mm256_add_epi16(scaled, multiply_255_avx2(dest, keep));
+}
+
+__attribute__((target("avx2")))
+void over_32_avx2(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque, uint8_t alpha)
+{
+    auto const green_alpha = _mm256_set1_epi32(static_cast<int>(0xff00ff00));
+    auto const red_blue = _mm256_set1_epi32(0x00ff00ff);
+    auto const source_alpha = _mm256_set1_epi32(static_cast<int>(opaque ? opaque_alpha : 0));
+    auto const global_alpha = _mm256_set1_epi16(alpha);
+    auto const zero = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto source = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(from + i));
+        auto const dest = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(to + i));
+
+        if (swap)
+        {
+            auto const rb = _mm256_and_si256(source, red_blue);
+            source = _mm256_or_si256(
+                _mm256_and_si256(source, green_alpha),
+                _mm256_or_si256(_mm256_slli_epi32(rb, 16), _mm256_srli_epi32(rb, 16)));
+        }
+        source = _mm256_or_si256(source, source_alpha);
+
+        // Unpacking and packing both work within 128-bit lanes, so the pixels keep their order
+        auto const low = over_avx2(
+            _mm256_unpacklo_epi8(source, zero), _mm256_unpacklo_epi8(dest, zero), global_alpha);
+        auto const high = over_avx2(
+            _mm256_unpackhi_epi8(source, zero), _mm256_unpackhi_epi8(dest, zero), global_alpha);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), _mm256_packus_epi16(low, high));
+    }
+
+    over_32_sse2(from + i, to + i, count - i, swap, opaque, alpha);
+}
+
+RowKernels const avx2_kernels{&convert_32_avx2, &expand_24_avx2, &fill_avx2, &over_32_avx2};
+#endif
+
+#ifdef MIR_PIXEL_KERNELS_NEON
+void convert_32_neon(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        // De-interleaves the bytes, so val[0] holds the low byte of each pixel
+        auto pixels = vld4q_u8(reinterpret_cast<uint8_t const*>(from + i));
+
+        if (swap)
+        {
+            auto const low = pixels.val[0];
+            pixels.val[0] = pixels.val[2];
+            pixels.val[2] = low;
+        }
+
+        if (opaque)
+            pixels.val[3] = vdupq_n_u8(0xff);
+
+        vst4q_u8(reinterpret_cast<uint8_t*>(to + i), pixels);
+    }
+
+    convert_32_scalar(from + i, to + i, count - i, swap, opaque);
+}
+
+void expand_24_neon(uint8_t const* from, uint32_t* to, std::size_t count, bool swap)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        auto const pixels = vld3q_u8(from + 3 * i);
+
+        uint8x16x4_t expanded;
+        expanded.val[0] = swap ? pixels.val[2] : pixels.val[0];
+        expanded.val[1] = pixels.val[1];
+        expanded.val[2] = swap ? pixels.val[0] : pixels.val[2];
+        expanded.val[3] = vdupq_n_u8(0xff);
+
+        vst4q_u8(reinterpret_cast<uint8_t*>(to + i), expanded);
+    }
+
+    expand_24_scalar(from + 3 * i, to + i, count - i, swap);
+}
+
+void fill_neon(uint32_t* to, std::size_t count, uint32_t value)
+{
+    auto const pixels = vdupq_n_u32(value);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        vst1q_u32(to + i, pixels);
+
+    fill_scalar(to + i, count - i, value);
+}
+
+/// \a a * \a b / 255, rounded
+inline uint8x16_t multiply_255_neon(uint8x16_t a, uint8x16_t b)
+{
+    auto const low = vmull_u8(vget_low_u8(a), vget_low_u8(b));
+    auto const high = vmull_u8(vget_high_u8(a), vget_high_u8(b));
+    return vcombine_u8(
+        vrshrn_n_u16(vrsraq_n_u16(low, low, 8), 8),
+        vrshrn_n_u16(vrsraq_n_u16(high, high, 8), 8));
+}
+
+void over_32_neon(uint32_t const* from, uint32_t* to, std::size_t count, bool swap, bool opaque, uint8_t alpha)
+{
+    auto const global_alpha = vdupq_n_u8(alpha);
+
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        auto source = vld4q_u8(reinterpret_cast<uint8_t const*>(from + i));
+        auto dest = vld4q_u8(reinterpret_cast<uint8_t const*>(to + i));
+
+        if (swap)
+        {
+            auto const low = source.val[0];
+            source.val[0] = source.val[2];
+            source.val[2] = low;
+        }
+
+        if (opaque)
+            source.val[3] = vdupq_n_u8(0xff);
+
+        auto const keep = vmvnq_u8(multiply_255_neon(source.val[3], global_alpha));
+        for (auto c = 0; c != 4; ++c)
+        {
+            dest.val[c] = vqaddq_u8(
+                multiply_255_neon(source.val[c], global_alpha),
+                multiply_255_neon(dest.val[c], keep));
+        }
+
+        vst4q_u8(reinterpret_cast<uint8_t*>(to + i), dest);
+    }
+
+    over_32_scalar(from + i, to + i, count - i, swap, opaque, alpha);
+}
+
+RowKernels const neon_kernels{&convert_32_neon, &expand_24_neon, &fill_neon, &over_32_neon};
+#endif
+
+auto kernels_for(mg::PixelKernels kernels) -> RowKernels const&
+{
+    if (!mg::available_pixel_kernels(kernels))
+        BOOST_THROW_EXCEPTION(std::logic_error("Pixel conversion kernels are not available on this CPU"));
+
+    switch (kernels)
+    {
+#ifdef MIR_PIXEL_KERNELS_X86
+    case mg::PixelKernels::sse2:
+        return sse2_kernels;
+
+    case mg::PixelKernels::avx2:
+        return avx2_kernels;
+#endif
+
+#ifdef MIR_PIXEL_KERNELS_NEON
+    case mg::PixelKernels::neon:
+        return neon_kernels;
+#endif
+
+    default:
+        return scalar_kernels;
+    }
+}
+
+bool is_32_bit(MirPixelFormat format)
+{
+    switch (format)
+    {
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool is_24_bit(MirPixelFormat format)
+{
+    return format == mir_pixel_format_rgb_888 || format == mir_pixel_format_bgr_888;
+}
+
+/// Whether red is the least significant component (abgr/xbgr) or the first byte (rgb_888)
+bool red_first(MirPixelFormat format)
+{
+    switch (format)
+    {
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+    case mir_pixel_format_rgb_888:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+inline uint32_t expand_bits(uint32_t value, int bits)
+{
+    switch (bits)
+    {
+    case 4: return value * 0x11;
+    case 5: return (value << 3) | (value >> 2);
+    case 6: return (value << 2) | (value >> 4);
+    default: return value;
+    }
+}
+
+inline uint32_t abgr(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha)
+{
+    return alpha << 24 | blue << 16 | green << 8 | red;
+}
+
+/// Unpacks a row of any format to abgr_8888, for the conversions without a kernel
+void unpack_row(MirPixelFormat format, uint8_t const* from, uint32_t* to, std::size_t count)
+{
+    auto const from_16 = reinterpret_cast<uint16_t const*>(from);
+
+    switch (format)
+    {
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+        convert_32_scalar(
+            reinterpret_cast<uint32_t const*>(from), to, count,
+            !red_first(format), !mg::contains_alpha(format));
+        break;
+
+    case mir_pixel_format_rgb_888:
+    case mir_pixel_format_bgr_888:
+        expand_24_scalar(from, to, count, !red_first(format));
+        break;
+
+    case mir_pixel_format_rgb_565:
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            uint32_t const p = from_16[i];
+            to[i] = abgr(expand_bits(p >> 11, 5), expand_bits((p >> 5) & 0x3f, 6), expand_bits(p & 0x1f, 5), 0xff);
+        }
+        break;
+
+    case mir_pixel_format_rgba_5551:
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            uint32_t const p = from_16[i];
+            to[i] = abgr(
+                expand_bits(p >> 11, 5), expand_bits((p >> 6) & 0x1f, 5), expand_bits((p >> 1) & 0x1f, 5),
+                (p & 1) ? 0xff : 0);
+        }
+        break;
+
+    case mir_pixel_format_rgba_4444:
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            uint32_t const p = from_16[i];
+            to[i] = abgr(
+                expand_bits(p >> 12, 4), expand_bits((p >> 8) & 0xf, 4), expand_bits((p >> 4) & 0xf, 4),
+                expand_bits(p & 0xf, 4));
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/// Packs a row of abgr_8888 to any format
+void pack_row(uint32_t const* from, MirPixelFormat format, uint8_t* to, std::size_t count)
+{
+    auto const to_16 = reinterpret_cast<uint16_t*>(to);
+
+    switch (format)
+    {
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+        convert_32_scalar(from, reinterpret_cast<uint32_t*>(to), count, !red_first(format), false);
+        break;
+
+    case mir_pixel_format_rgb_888:
+    case mir_pixel_format_bgr_888:
+    {
+        auto const first = red_first(format) ? 0 : 16;
+        auto const last = red_first(format) ? 16 : 0;
+        for (std::size_t i = 0; i != count; ++i, to += 3)
+        {
+            to[0] = from[i] >> first;
+            to[1] = from[i] >> 8;
+            to[2] = from[i] >> last;
+        }
+        break;
+    }
+
+    case mir_pixel_format_rgb_565:
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            auto const p = from[i];
+            to_16[i] = ((p >> 3) & 0x1f) << 11 | ((p >> 10) & 0x3f) << 5 | ((p >> 19) & 0x1f);
+        }
+        break;
+
+    case mir_pixel_format_rgba_5551:
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            auto const p = from[i];
+            to_16[i] = ((p >> 3) & 0x1f) << 11 | ((p >> 11) & 0x1f) << 6 | ((p >> 19) & 0x1f) << 1 | (p >> 31);
+        }
+        break;
+
+    case mir_pixel_format_rgba_4444:
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            auto const p = from[i];
+            to_16[i] = ((p >> 4) & 0xf) << 12 | ((p >> 12) & 0xf) << 8 | ((p >> 20) & 0xf) << 4 | (p >> 28);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+}
+
+bool mg::available_pixel_kernels(PixelKernels kernels)
+{
+    switch (kernels)
+    {
+    case PixelKernels::scalar:
+        return true;
+
+#ifdef MIR_PIXEL_KERNELS_X86
+    case PixelKernels::sse2:
+        return __builtin_cpu_supports("sse2");
+
+    case PixelKernels::avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+
+#ifdef MIR_PIXEL_KERNELS_NEON
+    case PixelKernels::neon:
+        return true;
+#endif
+
+    default:
+        return false;
+    }
+}
+
+auto mg::fastest_pixel_kernels() -> PixelKernels
+{
+    static auto const fastest = []
+        {
+            for (auto const kernels : {PixelKernels::avx2, PixelKernels::sse2, PixelKernels::neon})
+            {
+                if (available_pixel_kernels(kernels))
+                    return kernels;
+            }
+            return PixelKernels::scalar;
+        }();
+
+    return fastest;
+}
+
+bool mg::convert_pixels(
+    geom::Size const& size,
+    MirPixelFormat source_format, void const* source, int source_stride,
+    MirPixelFormat dest_format, void* dest, int dest_stride)
+{
+    return convert_pixels(
+        fastest_pixel_kernels(), size, source_format, source, source_stride, dest_format, dest, dest_stride);
+}
+
+bool mg::convert_pixels(
+    PixelKernels kernels,
+    geom::Size const& size,
+    MirPixelFormat source_format, void const* source, int source_stride,
+    MirPixelFormat dest_format, void* dest, int dest_stride)
+{
+    if (!valid_pixel_format(source_format) || !valid_pixel_format(dest_format))
+        return false;
+
+    auto const& k = kernels_for(kernels);
+    auto const width = size.width.as_uint32_t();
+    auto const height = size.height.as_uint32_t();
+    auto const swap = red_first(source_format) != red_first(dest_format);
+    auto const opaque = !contains_alpha(source_format) && contains_alpha(dest_format);
+
+    // Only the conversions without a kernel need an intermediate row
+    std::vector<uint32_t> row;
+    auto const copy = source_format == dest_format ||
+        (is_32_bit(source_format) && is_32_bit(dest_format) && !swap && !opaque);
+    auto const by_kernel = copy || (is_32_bit(dest_format) && (is_32_bit(source_format) || is_24_bit(source_format)));
+    if (!by_kernel)
+        row.resize(width);
+
+    for (auto y = 0u; y != height; ++y)
+    {
+        auto const from = static_cast<uint8_t const*>(source) + static_cast<std::ptrdiff_t>(y) * source_stride;
+        auto const to = static_cast<uint8_t*>(dest) + static_cast<std::ptrdiff_t>(y) * dest_stride;
+
+        if (copy)
+        {
+            std::memcpy(to, from, width * MIR_BYTES_PER_PIXEL(source_format));
+        }
+        else if (!by_kernel)
+        {
+            unpack_row(source_format, from, row.data(), width);
+            pack_row(row.data(), dest_format, to, width);
+        }
+        else if (is_32_bit(source_format))
+        {
+            k.convert_32(
+                reinterpret_cast<uint32_t const*>(from), reinterpret_cast<uint32_t*>(to), width, swap, opaque);
+        }
+        else
+        {
+            k.expand_24(from, reinterpret_cast<uint32_t*>(to), width, swap);
+        }
+    }
+
+    return true;
+}
+
+void mg::fill_pixels(uint32_t* dest, std::size_t count, uint32_t value)
+{
+    fill_pixels(fastest_pixel_kernels(), dest, count, value);
+}
+
+void mg::fill_pixels(PixelKernels kernels, uint32_t* dest, std::size_t count, uint32_t value)
+{
+    kernels_for(kernels).fill(dest, count, value);
+}
+
+bool mg::blend_pixels(
+    geom::Size const& size,
+    MirPixelFormat source_format, void const* source, int source_stride,
+    MirPixelFormat dest_format, void* dest, int dest_stride,
+    uint8_t alpha)
+{
+    return blend_pixels(
+        fastest_pixel_kernels(), size, source_format, source, source_stride, dest_format, dest, dest_stride, alpha);
+}
+
+bool mg::blend_pixels(
+    PixelKernels kernels,
+    geom::Size const& size,
+    MirPixelFormat source_format, void const* source, int source_stride,
+    MirPixelFormat dest_format, void* dest, int dest_stride,
+    uint8_t alpha)
+{
+    if (!is_32_bit(source_format) || !is_32_bit(dest_format))
+        return false;
+
+    auto const& k = kernels_for(kernels);
+    auto const width = size.width.as_uint32_t();
+    auto const height = size.height.as_uint32_t();
+    auto const swap = red_first(source_format) != red_first(dest_format);
+    auto const opaque = !contains_alpha(source_format);
+
+    for (auto y = 0u; y != height; ++y)
+    {
+        auto const from = static_cast<uint8_t const*>(source) + static_cast<std::ptrdiff_t>(y) * source_stride;
+        auto const to = static_cast<uint8_t*>(dest) + static_cast<std::ptrdiff_t>(y) * dest_stride;
+
+        k.over_32(reinterpret_cast<uint32_t const*>(from), reinterpret_cast<uint32_t*>(to), width, swap, opaque, alpha);
+    }
+
+    return true;
+}
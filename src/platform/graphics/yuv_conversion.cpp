@@ -0,0 +1,177 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/yuv_conversion.h"
+#include "mir/graphics/program_factory.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The luma weights of red and blue
+struct LumaWeights
+{
+    float red;
+    float blue;
+};
+
+auto luma_weights(mg::YUVMatrix matrix) -> LumaWeights
+{
+    switch (matrix)
+    {
+    case mg::YUVMatrix::bt601:  return {0.299f, 0.114f};
+    case mg::YUVMatrix::bt709:  return {0.2126f, 0.0722f};
+    case mg::YUVMatrix::bt2020: return {0.2627f, 0.0593f};
+    }
+
+    BOOST_THROW_EXCEPTION(std::invalid_argument{"Unknown YUV matrix"});
+}
+
+/// GLSL expressions for the Y, U and V of the content at texcoord
+struct Sampling
+{
+    char const* samplers;
+    char const* y;
+    char const* u;
+    char const* v;
+};
+
+auto sampling(mg::YUVPlanes planes) -> Sampling
+{
+    switch (planes)
+    {
+    case mg::YUVPlanes::y_u_v:
+        return {
+            "uniform sampler2D tex[3];\n",
+            "texture2D(tex[0], texcoord).r",
+            "texture2D(tex[1], texcoord).r",
+            "texture2D(tex[2], texcoord).r"};
+
+    case mg::YUVPlanes::y_uv:
+        return {
+            "uniform sampler2D tex[2];\n",
+            "texture2D(tex[0], texcoord).r",
+            "uv.r",
+            "uv.g"};
+
+    case mg::YUVPlanes::y_uv_luminance_alpha:
+        return {
+            "uniform sampler2D tex[2];\n",
+            "texture2D(tex[0], texcoord).r",
+            "uv.r",
+            "uv.a"};
+
+    case mg::YUVPlanes::y_xuxv:
+        return {
+            "uniform sampler2D tex[2];\n",
+            "texture2D(tex[0], texcoord).r",
+            "uv.g",
+            "uv.a"};
+    }
+
+    BOOST_THROW_EXCEPTION(std::invalid_argument{"Unknown YUV plane layout"});
+}
+
+auto fragment_for(mg::YUVPlanes planes, mg::YUVEncoding const& encoding) -> std::string
+{
+    auto const m = mg::yuv_to_rgb(encoding);
+    auto const s = sampling(planes);
+
+    std::ostringstream fragment;
+    // GLSL wants float literals such as "0.5" and "0.000000", whatever the locale
+    fragment.imbue(std::locale::classic());
+    fragment.precision(7);
+    fragment << std::showpoint;
+
+    fragment
+        << s.samplers
+        << "vec4 sample_to_rgba(in vec2 texcoord)\n"
+           "{\n";
+    if (plane_count(planes) == 2)
+        fragment << "    vec4 uv = texture2D(tex[1], texcoord);\n";
+    fragment
+        << "    vec3 yuv = vec3(" << s.y << ", " << s.u << ", " << s.v << ");\n"
+        << "    mat3 to_rgb = mat3(\n";
+    // GLSL matrices are given column by column
+    for (auto column = 0; column != 3; ++column)
+    {
+        fragment
+            << "        " << m[0][column] << ", " << m[1][column] << ", " << m[2][column]
+            << (column != 2 ? ",\n" : ");\n");
+    }
+    fragment
+        << "    vec3 offset = vec3(" << m[0][3] << ", " << m[1][3] << ", " << m[2][3] << ");\n"
+           "    return vec4(clamp(to_rgb * yuv + offset, 0.0, 1.0), 1.0);\n"
+           "}\n";
+
+    return fragment.str();
+}
+}
+
+auto mg::default_yuv_encoding(geom::Size const& size) -> YUVEncoding
+{
+    auto const high_definition = size.width.as_int() > 1024 || size.height.as_int() > 576;
+    return {high_definition ? YUVMatrix::bt709 : YUVMatrix::bt601, YUVRange::limited};
+}
+
+auto mg::yuv_to_rgb(YUVEncoding const& encoding) -> YUVToRGB
+{
+    auto const weights = luma_weights(encoding.matrix);
+    auto const green = 1.0f - weights.red - weights.blue;
+
+    // Normalises Y to [0, 1] and U and V to [-0.5, 0.5]
+    auto const limited = encoding.range == YUVRange::limited;
+    auto const y_scale = limited ? 255.0f / 219.0f : 1.0f;
+    auto const y_offset = limited ? 16.0f / 255.0f : 0.0f;
+    auto const c_scale = limited ? 255.0f / 224.0f : 1.0f;
+    auto const c_offset = 128.0f / 255.0f;
+
+    auto const r_from_v = 2.0f * (1.0f - weights.red);
+    auto const g_from_u = 2.0f * weights.blue * (1.0f - weights.blue) / green;
+    auto const g_from_v = 2.0f * weights.red * (1.0f - weights.red) / green;
+    auto const b_from_u = 2.0f * (1.0f - weights.blue);
+
+    auto const y_constant = -y_scale * y_offset;
+
+    return {{
+        {{y_scale, 0.0f, c_scale * r_from_v, y_constant - c_scale * r_from_v * c_offset}},
+        {{y_scale, -c_scale * g_from_u, -c_scale * g_from_v,
+          y_constant + c_scale * (g_from_u + g_from_v) * c_offset}},
+        {{y_scale, c_scale * b_from_u, 0.0f, y_constant - c_scale * b_from_u * c_offset}}}};
+}
+
+auto mg::plane_count(YUVPlanes planes) -> int
+{
+    return planes == YUVPlanes::y_u_v ? 3 : 2;
+}
+
+auto mg::yuv_shader(gl::ProgramFactory& factory, YUVPlanes planes, YUVEncoding const& encoding) -> gl::Program&
+{
+    // One program ID for each combination
+    static char ids[4][3][2];
+
+    return factory.compile_fragment_shader(
+        &ids[static_cast<int>(planes)][static_cast<int>(encoding.matrix)][static_cast<int>(encoding.range)],
+        "",
+        fragment_for(planes, encoding).c_str());
+}
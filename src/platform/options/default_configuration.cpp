@@ -42,11 +42,26 @@ char const* const mo::input_report_opt            = "input-report";
 char const* const mo::seat_report_opt            = "seat-report";
 char const* const mo::shared_library_prober_report_opt = "shared-library-prober-report";
 char const* const mo::shell_report_opt            = "shell-report";
+char const* const mo::metrics_socket_opt          = "metrics-socket";
+char const* const mo::trace_opt                   = "trace";
+char const* const mo::trace_dir_opt               = "trace-dir";
+char const* const mo::track_input_latency_opt     = "track-input-latency";
+char const* const mo::gpu_timing_opt              = "gpu-timing";
+char const* const mo::texture_cache_budget_opt    = "texture-cache-budget";
+char const* const mo::software_compositing_opt    = "software-compositing";
+char const* const mo::session_memory_limit_opt    = "session-memory-limit";
+char const* const mo::record_input_opt            = "record-input";
+char const* const mo::replay_input_opt            = "replay-input";
+char const* const mo::replay_input_speed_opt      = "replay-input-speed";
 char const* const mo::offscreen_opt               = "offscreen";
+char const* const mo::offscreen_outputs_opt       = "offscreen-outputs";
+char const* const mo::offscreen_refresh_rate_opt  = "offscreen-refresh-rate";
+char const* const mo::virtual_time_opt            = "virtual-time";
 char const* const mo::touchspots_opt              = "enable-touchspots";
 char const* const mo::cursor_opt                  = "cursor";
 char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
+char const* const mo::async_logging_opt           = "async-logging";
 char const* const mo::composite_delay_opt         = "composite-delay";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
 char const* const mo::x11_display_opt             = "enable-x11";
@@ -56,6 +71,8 @@ char const* const mo::enable_mirclient_opt        = "enable-mirclient";
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
 char const* const mo::lttng_opt_value = "lttng";
+char const* const mo::metrics_opt_value = "metrics";
+char const* const mo::trace_opt_value = "trace";
 
 char const* const mo::platform_graphics_lib = "platform-graphics-lib";
 char const* const mo::platform_input_lib = "platform-input-lib";
@@ -156,27 +173,55 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (enable_input_opt, po::value<bool>()->default_value(enable_input_default),
             "Enable input.")
         (compositor_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "Compositor reporting [{log,lttng,off}]")
+            "Compositor reporting [{log,lttng,metrics,trace,off}]")
         (connector_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle the Connector report. [{log,lttng,off}]")
+            "How to handle the Connector report. [{log,lttng,metrics,off}]")
         (display_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle the Display report. [{log,lttng,off}]")
+            "How to handle the Display report. [{log,lttng,metrics,trace,off}]")
         (input_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle to Input report. [{log,lttng,off}]")
+            "How to handle to Input report. [{log,lttng,metrics,trace,off}]")
         (legacy_input_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the Legacy Input report. [{log,off}]")
         (seat_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle to Seat report. [{log,off}]")
+            "How to handle to Seat report. [{log,metrics,off}]")
         (session_mediator_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the SessionMediator report. [{log,lttng,off}]")
         (msg_processor_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the MessageProcessor report. [{log,lttng,off}]")
         (scene_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle the scene report. [{log,lttng,off}]")
+            "How to handle the scene report. [{log,lttng,metrics,trace,off}]")
         (shared_library_prober_report_opt, po::value<std::string>()->default_value(log_opt_value),
             "How to handle the SharedLibraryProber report. [{log,lttng,off}]")
         (shell_report_opt, po::value<std::string>()->default_value(off_opt_value),
-         "How to handle the Shell report. [{log,off}]")
+         "How to handle the Shell report. [{log,metrics,off}]")
+        (metrics_socket_opt, po::value<std::string>(),
+            "Socket on which to serve metrics from reports set to \"metrics\", in the "
+            "Prometheus text format (default: $XDG_RUNTIME_DIR/mir_metrics)")
+        (trace_opt, "Record trace events (from reports set to \"trace\" and from the compositor, "
+            "input and Wayland threads) into in-memory ring buffers. Sending SIGUSR2 writes "
+            "the recent events to a file that chrome://tracing or ui.perfetto.dev can open.")
+        (trace_dir_opt, po::value<std::string>(),
+            "Directory in which to write trace snapshots (default: $XDG_RUNTIME_DIR)")
+        (track_input_latency_opt, "Follow input events through to the frames clients post in "
+            "response, and serve the latency of each stage per client on the metrics socket.")
+        (gpu_timing_opt, "Measure how long the GPU spends on each frame, and report it through "
+            "the compositor report. Uses timer queries where supported, otherwise fences.")
+        (texture_cache_budget_opt, po::value<int>()->default_value(64),
+            "Texture memory, in MiB, each output's renderer may hold before freeing the textures "
+            "of windows it isn't drawing (those hidden or minimised), least recently drawn first. "
+            "0 frees them as soon as they aren't drawn.")
+        (software_compositing_opt, "Composite on the CPU into the outputs that can be mapped, "
+            "falling back to GL for frames the CPU can't draw. Other outputs are unaffected.")
+        (session_memory_limit_opt, po::value<int>()->default_value(0),
+            "Memory, in MiB, of buffers, shared memory and textures each client may hold "
+            "before it is reported through the scene report. 0 for no limit.")
+        (record_input_opt, po::value<std::string>(),
+            "Record the events from all input devices, with their timing, to this file.")
+        (replay_input_opt, po::value<std::string>(),
+            "Replay a file written by --record-input instead of using the input platform.")
+        (replay_input_speed_opt, po::value<double>()->default_value(1.0),
+            "Speed at which to replay input: 1 is the recorded timing, "
+            "0 is as fast as possible.")
         (composite_delay_opt, po::value<int>()->default_value(0),
             "Compositor frame delay in milliseconds (how long to wait for new "
             "frames from clients before compositing). Higher values result in "
@@ -184,6 +229,16 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Default: A negative value means decide automatically.")
         (offscreen_opt,
             "Render to offscreen buffers instead of the real outputs.")
+        (offscreen_outputs_opt, po::value<std::string>()->default_value("1024x768"),
+            "Sizes of the outputs to create with --offscreen, as a comma separated "
+            "list of <width>x<height>.")
+        (offscreen_refresh_rate_opt, po::value<double>()->default_value(0),
+            "Refresh rate to simulate on the outputs created with --offscreen, in Hz: "
+            "each frame is posted at the next vblank by the server's clock. "
+            "0 posts frames as soon as they are rendered.")
+        (virtual_time_opt,
+            "Time the server by a virtual clock that only moves when stepped (through "
+            "Server::the_clock()), rather than by the system clock. For simulations.")
         (touchspots_opt,
             "Display visualization of touchspots (e.g. for screencasting).")
         (cursor_opt,
@@ -195,6 +250,8 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
             "This is only interesting for people doing Mir server or client development.")
+        (async_logging_opt, "Format and write log messages on a background thread, "
+            "so that logging (e.g. from verbose reports) doesn't stall the calling thread.")
         (console_provider,
             po::value<std::string>()->default_value("auto"),
             "Console device handling\n"
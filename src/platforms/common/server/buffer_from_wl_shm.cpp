@@ -19,8 +19,10 @@
 
 #include "buffer_from_wl_shm.h"
 #include "shm_buffer.h"
+#include "egl_context_executor.h"
 
 #include "mir/renderer/sw/pixel_source.h"
+#include "mir/graphics/yuv_conversion.h"
 #include "mir/executor.h"
 #include "mir/renderer/gl/context.h"
 
@@ -28,6 +30,7 @@
 #include "mir/log.h"
 
 #include <boost/throw_exception.hpp>
+#include <array>
 #include <mutex>
 #include <atomic>
 
@@ -388,6 +391,194 @@ private:
     mir::geometry::Stride const stride_;
 };
 
+/**
+ * A wl_shm buffer of planar YUV (NV12 or YUV420), uploaded plane by plane
+ * and converted to RGB as it is drawn.
+ *
+ * The CPU can't read it as pixels, so it is not a PixelSource.
+ */
+class WlShmYUVBuffer :
+    public mg::BufferBasic,
+    public mg::NativeBufferBase,
+    public mg::gl::Texture
+{
+public:
+    WlShmYUVBuffer(
+        SharedWlBuffer buffer,
+        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+        mir::geometry::Size const& size,
+        mir::geometry::Stride stride,
+        uint32_t format,
+        std::function<void()>&& on_consumed)
+        : egl_delegate{std::move(egl_delegate)},
+          on_consumed{std::move(on_consumed)},
+          buffer{std::move(buffer)},
+          size_{size},
+          stride_{stride},
+          planes{format == WL_SHM_FORMAT_NV12 ? mg::YUVPlanes::y_uv_luminance_alpha : mg::YUVPlanes::y_u_v}
+    {
+    }
+
+    ~WlShmYUVBuffer() noexcept
+    {
+        if (tex[0] != 0)
+        {
+            egl_delegate->spawn(
+                [tex = tex]()
+                {
+                    glDeleteTextures(tex.size(), tex.data());
+                });
+        }
+    }
+
+    static bool supports(uint32_t format)
+    {
+        return format == WL_SHM_FORMAT_NV12 || format == WL_SHM_FORMAT_YUV420;
+    }
+
+    std::shared_ptr<mg::NativeBuffer> native_buffer_handle() const override
+    {
+        BOOST_THROW_EXCEPTION((std::logic_error{"Attempt to get mirclient handle for Wayland Shm buffer"}));
+    }
+
+    mir::geometry::Size size() const override
+    {
+        return size_;
+    }
+
+    MirPixelFormat pixel_format() const override
+    {
+        /* There is no MirPixelFormat for YUV; external code only uses this
+         * to tell whether there's an alpha channel, and there isn't.
+         */
+        return mir_pixel_format_xrgb_8888;
+    }
+
+    NativeBufferBase* native_buffer_base() override
+    {
+        return this;
+    }
+
+    mg::gl::Program const& shader(mg::gl::ProgramFactory& cache) const override
+    {
+        return mg::yuv_shader(cache, planes, mg::default_yuv_encoding(size_));
+    }
+
+    Layout layout() const override
+    {
+        return Layout::GL;
+    }
+
+    void bind() override
+    {
+        std::lock_guard<std::mutex> lock{upload_mutex};
+
+        auto const count = mg::plane_count(planes);
+        bool const needs_initialisation = tex[0] == 0;
+        if (needs_initialisation)
+        {
+            glGenTextures(count, tex.data());
+        }
+
+        for (auto plane = count; plane-- != 0;)
+        {
+            glActiveTexture(GL_TEXTURE0 + plane);
+            glBindTexture(GL_TEXTURE_2D, tex[plane]);
+            if (needs_initialisation)
+            {
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            }
+        }
+
+        if (!uploaded)
+        {
+            upload();
+            on_consumed();
+            on_consumed = [](){};
+            uploaded = true;
+        }
+    }
+
+    void add_syncpoint() override
+    {
+    }
+
+private:
+    /// Uploads the planes, leaving GL_TEXTURE0 active
+    void upload()
+    {
+        auto const locked_buffer = buffer.lock();
+        if (!locked_buffer)
+        {
+            mir::log_debug("Wayland buffer destroyed before use; rendering will be incomplete");
+            return;
+        }
+
+        auto const width = size_.width.as_int();
+        auto const height = size_.height.as_int();
+        auto const stride = stride_.as_int();
+        mir::geometry::Size const chroma_size{(width + 1) / 2, (height + 1) / 2};
+
+        /* Following the usual wl_shm convention, the chroma planes follow the
+         * luma plane, each row of NV12's interleaved chroma taking the luma
+         * stride and each row of YUV420's separate planes half of it.
+         *
+         * libwayland only checks that the luma plane lies within the pool;
+         * the frontend refuses buffers whose chroma planes don't.
+         */
+        auto const shm_buffer = wl_shm_buffer_get(locked_buffer);
+        wl_shm_buffer_begin_access(shm_buffer);
+        auto const pixels = static_cast<unsigned char const*>(wl_shm_buffer_get_data(shm_buffer));
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        upload_plane(0, GL_LUMINANCE, size_, stride, pixels);
+        if (planes == mg::YUVPlanes::y_uv_luminance_alpha)
+        {
+            upload_plane(1, GL_LUMINANCE_ALPHA, chroma_size, stride / 2, pixels + stride * height);
+        }
+        else
+        {
+            auto const chroma_stride = stride / 2;
+            auto const u = pixels + stride * height;
+            upload_plane(1, GL_LUMINANCE, chroma_size, chroma_stride, u);
+            upload_plane(2, GL_LUMINANCE, chroma_size, chroma_stride, u + chroma_stride * chroma_size.height.as_int());
+        }
+        // Be nice to other users of the GL context by reverting our changes to shared state
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glActiveTexture(GL_TEXTURE0);
+
+        wl_shm_buffer_end_access(shm_buffer);
+    }
+
+    void upload_plane(
+        int plane,
+        GLenum format,
+        mir::geometry::Size const& size,
+        int stride_in_px,
+        unsigned char const* data)
+    {
+        glActiveTexture(GL_TEXTURE0 + plane);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, format, size.width.as_int(), size.height.as_int(), 0,
+            format, GL_UNSIGNED_BYTE, data);
+    }
+
+    std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
+    std::mutex upload_mutex;
+    bool uploaded{false};
+    std::array<GLuint, 3> tex{{0, 0, 0}};
+    std::function<void()> on_consumed;
+    SharedWlBuffer const buffer;
+    mir::geometry::Size const size_;
+    mir::geometry::Stride const stride_;
+    mg::YUVPlanes const planes;
+};
+
 auto mg::wayland::buffer_from_wl_shm(
     wl_resource* buffer,
     std::shared_ptr<Executor> executor,
@@ -399,6 +590,22 @@ auto mg::wayland::buffer_from_wl_shm(
     {
         BOOST_THROW_EXCEPTION((std::logic_error{"Attempt to import a non-SHM buffer as a SHM buffer"}));
     }
+
+    auto const format = wl_shm_buffer_get_format(shm_buffer);
+    if (WlShmYUVBuffer::supports(format))
+    {
+        return std::make_shared<WlShmYUVBuffer>(
+            SharedWlBuffer{buffer, std::move(executor)},
+            std::move(egl_delegate),
+            mir::geometry::Size{
+                wl_shm_buffer_get_width(shm_buffer),
+                wl_shm_buffer_get_height(shm_buffer)
+            },
+            mir::geometry::Stride{wl_shm_buffer_get_stride(shm_buffer)},
+            format,
+            std::move(on_consumed));
+    }
+
     return std::make_shared<WlShmBuffer>(
         SharedWlBuffer{buffer, std::move(executor)},
         std::move(egl_delegate),
@@ -407,6 +614,6 @@ auto mg::wayland::buffer_from_wl_shm(
             wl_shm_buffer_get_height(shm_buffer)
         },
         mir::geometry::Stride{wl_shm_buffer_get_stride(shm_buffer)},
-        wl_format_to_mir_format(wl_shm_buffer_get_format(shm_buffer)),
+        wl_format_to_mir_format(format),
         std::move(on_consumed));
 }
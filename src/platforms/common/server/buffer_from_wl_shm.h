@@ -43,8 +43,8 @@ namespace wayland
 /**
  * Get a mir::graphics::Buffer with the content of the shm buffer.
  *
- * The returned buffer will support the mg::gl::Texture and
- * mir::renderer::sw::PixelSource interfaces.
+ * The returned buffer will support the mg::gl::Texture interface, and (unless
+ * it is in a planar YUV format) the mir::renderer::sw::PixelSource interface.
  *
  * \note This must be called on the Wayland thread, with a current GL context
  *
@@ -52,7 +52,7 @@ namespace wayland
  * \param executor      [in]    An Executor that will defer work to the Wayland event loop
  * \param egl_delegate  [in]    An EGL-context-thread delegator
  * \param on_consumed   [in]    Closure to call when the compositor has consumed this buffer
- * \return                      An mg::Buffer supporting being rendered from in GL and read by the CPU.
+ * \return                      An mg::Buffer supporting being rendered from in GL.
  */
 auto buffer_from_wl_shm(
     wl_resource* buffer,
@@ -21,6 +21,8 @@
 #include "shm_buffer.h"
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
+#include "mir/graphics/pixel_conversion.h"
+#include "mir/graphics/pixel_format_utils.h"
 #include "egl_context_executor.h"
 
 #define MIR_LOG_COMPONENT "gfx-common"
@@ -32,12 +34,14 @@
 #include <boost/throw_exception.hpp>
 
 #include <stdexcept>
+#include <vector>
 
 #include <string.h>
 #include <endian.h>
 
 namespace mg=mir::graphics;
 namespace mgc = mir::graphics::common;
+namespace mrs = mir::renderer::software;
 namespace geom = mir::geometry;
 
 bool mg::get_gl_pixel_format(MirPixelFormat mir_format,
@@ -88,10 +92,93 @@ bool mg::get_gl_pixel_format(MirPixelFormat mir_format,
     return gl_format != GL_INVALID_ENUM && gl_type != GL_INVALID_ENUM;
 }
 
+namespace
+{
+void tex_image(geom::Size const& size, int stride_in_px, GLenum format, GLenum type, void const* pixels)
+{
+    glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glTexImage2D(
+        GL_TEXTURE_2D,
+        0,
+        format,
+        size.width.as_int(), size.height.as_int(),
+        0,
+        format,
+        type,
+        pixels);
+
+    // Be nice to other users of the GL context by reverting our changes to shared state
+    glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
+}
+
+/// A view of a MemoryBackedShmBuffer's pixels, calling \a on_unmap when done with
+template<typename T>
+class PixelsMapping : public mrs::Mapping<T>
+{
+public:
+    PixelsMapping(
+        MirPixelFormat format,
+        geom::Size const& size,
+        geom::Stride stride,
+        T* pixels,
+        std::function<void()>&& on_unmap)
+        : format_{format},
+          size_{size},
+          stride_{stride},
+          pixels{pixels},
+          on_unmap{std::move(on_unmap)}
+    {
+    }
+
+    ~PixelsMapping()
+    {
+        on_unmap();
+    }
+
+    auto format() const -> MirPixelFormat override
+    {
+        return format_;
+    }
+
+    auto stride() const -> geom::Stride override
+    {
+        return stride_;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+    auto data() -> T* override
+    {
+        return pixels;
+    }
+
+    auto len() const -> size_t override
+    {
+        return stride_.as_uint32_t() * size_.height.as_uint32_t();
+    }
+
+private:
+    MirPixelFormat const format_;
+    geom::Size const size_;
+    geom::Stride const stride_;
+    T* const pixels;
+    std::function<void()> const on_unmap;
+};
+}
+
 bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
 {
     GLenum gl_format, gl_type;
-    return mg::get_gl_pixel_format(mir_format, gl_format, gl_type);
+    // Formats GL can't take as they are get converted to abgr_8888 on upload
+    return mg::get_gl_pixel_format(mir_format, gl_format, gl_type) ||
+        (mg::valid_pixel_format(mir_format) &&
+         mg::get_gl_pixel_format(mir_pixel_format_abgr_8888, gl_format, gl_type));
 }
 
 mgc::ShmBuffer::ShmBuffer(
@@ -158,22 +245,21 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
          * to match the size of the partial-pixel-stride().
          */
 
-        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            format,
-            size().width.as_int(), size().height.as_int(),
-            0,
-            format,
-            type,
-            pixels);
-
-        // Be nice to other users of the GL context by reverting our changes to shared state
-        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
+        tex_image(size(), stride_in_px, format, type, pixels);
+    }
+    else if (mg::valid_pixel_format(pixel_format_) &&
+             mg::get_gl_pixel_format(mir_pixel_format_abgr_8888, format, type))
+    {
+        // There's no GL format for this one (bgr_888, for instance), so convert it to one there is
+        auto const width = size().width.as_int();
+        std::vector<uint32_t> converted(width * size().height.as_int());
+
+        mg::convert_pixels(
+            size(),
+            pixel_format_, pixels, stride.as_int(),
+            mir_pixel_format_abgr_8888, converted.data(), 4 * width);
+
+        tex_image(size(), width, format, type, converted.data());
     }
     else
     {
@@ -196,6 +282,29 @@ void mgc::MemoryBackedShmBuffer::read(std::function<void(unsigned char const*)>
     do_with_pixels(static_cast<unsigned char const*>(pixels.get()));
 }
 
+auto mgc::MemoryBackedShmBuffer::map_readable() -> std::unique_ptr<mrs::Mapping<unsigned char const>>
+{
+    return std::make_unique<PixelsMapping<unsigned char const>>(
+        pixel_format(), size(), stride_, pixels.get(), []{});
+}
+
+auto mgc::MemoryBackedShmBuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>>
+{
+    return map_rw();
+}
+
+auto mgc::MemoryBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsigned char>>
+{
+    return std::make_unique<PixelsMapping<unsigned char>>(
+        pixel_format(), size(), stride_, pixels.get(), [this]{ pixels_changed(); });
+}
+
+void mgc::MemoryBackedShmBuffer::pixels_changed()
+{
+    std::lock_guard<decltype(uploaded_mutex)> lock{uploaded_mutex};
+    uploaded = false;
+}
+
 mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
 {
     return this;
@@ -77,9 +77,16 @@ private:
     GLuint tex_id{0};
 };
 
+/**
+ * A ShmBuffer in server memory.
+ *
+ * Its CPU mappings are views of that memory rather than copies of it; they
+ * must not outlive the buffer.
+ */
 class MemoryBackedShmBuffer :
     public ShmBuffer,
-    public renderer::software::PixelSource
+    public renderer::software::PixelSource,
+    public renderer::software::RWMappableBuffer
 {
 public:
     MemoryBackedShmBuffer(
@@ -91,6 +98,10 @@ public:
     void read(std::function<void(unsigned char const*)> const& do_with_pixels) override;
     geometry::Stride stride() const override;
 
+    auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
+    auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
+    auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
+
     std::shared_ptr<NativeBuffer> native_buffer_handle() const override;
 
     void bind() override;
@@ -98,6 +109,9 @@ public:
     MemoryBackedShmBuffer(MemoryBackedShmBuffer const&) = delete;
     MemoryBackedShmBuffer& operator=(MemoryBackedShmBuffer const&) = delete;
 private:
+    /// The pixels have been written to: the texture needs uploading again
+    void pixels_changed();
+
     geometry::Stride const stride_;
     std::unique_ptr<unsigned char[]> const pixels;
     std::mutex uploaded_mutex;
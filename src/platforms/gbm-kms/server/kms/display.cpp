@@ -423,35 +423,6 @@ mg::Frame mgg::Display::last_frame_on(unsigned output_id) const
     return output->last_frame();
 }
 
-namespace
-{
-/*
- * Add output to the grouping, maintaining the invariant that each vector of outputs
- * is a single GPU memory domain.
- */
-void add_to_drm_device_group(
-    std::vector<std::vector<std::shared_ptr<mgg::KMSOutput>>>& grouping,
-    std::shared_ptr<mgg::KMSOutput>&& output)
-{
-    for (auto &group : grouping)
-    {
-        /*
-         * We could be smarter about this, but being on the same DRM device is guaranteed
-         * to be in the same GPU memory domain :).
-         */
-        if (group.front()->drm_fd() == output->drm_fd())
-        {
-            group.push_back(std::move(output));
-            break;
-        }
-    }
-    if (output)
-    {
-        grouping.push_back(std::vector<std::shared_ptr<mgg::KMSOutput>>{std::move(output)});
-    }
-}
-}
-
 void mgg::Display::configure_locked(
     mgg::RealKMSDisplayConfiguration const& kms_conf,
     std::lock_guard<std::mutex> const&)
@@ -494,8 +465,7 @@ void mgg::Display::configure_locked(
         [&](OverlappingOutputGroup const& group)
         {
             auto bounding_rect = group.bounding_rectangle();
-            // Each vector<KMSOutput> is a single GPU memory domain
-            std::vector<std::vector<std::shared_ptr<KMSOutput>>> kms_output_groups;
+            std::vector<std::shared_ptr<KMSOutput>> kms_outputs;
             glm::mat2 transformation;
             geom::Size current_mode_resolution;
 
@@ -511,7 +481,7 @@ void mgg::Display::configure_locked(
                     {
                         kms_output->set_power_mode(conf_output.power_mode);
                         kms_output->set_gamma(conf_output.gamma);
-                        add_to_drm_device_group(kms_output_groups, std::move(kms_output));
+                        kms_outputs.push_back(std::move(kms_output));
                     }
 
                     /*
@@ -533,38 +503,39 @@ void mgg::Display::configure_locked(
                 uint32_t const width  = current_mode_resolution.width.as_uint32_t();
                 uint32_t const height = current_mode_resolution.height.as_uint32_t();
 
-                for (auto const& group : kms_output_groups)
-                {
-                    /*
-                     * In a hybrid setup a scanout surface needs to be allocated differently if it
-                     * needs to be able to be shared across GPUs. This likely reduces performance.
-                     *
-                     * As a first cut, assume every scanout buffer in a hybrid setup might need
-                     * to be shared.
-                     */
-                    auto surface = gbm->create_scanout_surface(width, height, drm.size() != 1);
-                    auto const raw_surface = surface.get();
-
-                    auto db = std::make_unique<DisplayBuffer>(
-                        bypass_option,
-                        listener,
-                        group,
-                        GBMOutputSurface{
-                            group.front()->drm_fd(),
-                            std::move(surface),
-                            width, height,
-                            helpers::EGLHelper{
-                                *gl_config,
-                                *gbm,
-                                raw_surface,
-                                shared_egl.context()
-                            }
-                        },
-                        bounding_rect,
-                        transformation);
-
-                    display_buffers_new.push_back(std::move(db));
-                }
+                /*
+                 * Clones on every DRM device share the one rendering: outputs the
+                 * rendering GPU cannot scan out to get copies of it rather than their
+                 * own DisplayBuffer compositing the scene again.
+                 *
+                 * In a hybrid setup a scanout surface needs to be allocated differently if it
+                 * needs to be able to be shared across GPUs. This likely reduces performance.
+                 *
+                 * As a first cut, assume every scanout buffer in a hybrid setup might need
+                 * to be shared.
+                 */
+                auto surface = gbm->create_scanout_surface(width, height, drm.size() != 1);
+                auto const raw_surface = surface.get();
+
+                auto db = std::make_unique<DisplayBuffer>(
+                    bypass_option,
+                    listener,
+                    kms_outputs,
+                    GBMOutputSurface{
+                        kms_outputs.front()->drm_fd(),
+                        std::move(surface),
+                        width, height,
+                        helpers::EGLHelper{
+                            *gl_config,
+                            *gbm,
+                            raw_surface,
+                            shared_egl.context()
+                        }
+                    },
+                    bounding_rect,
+                    transformation);
+
+                display_buffers_new.push_back(std::move(db));
             }
         });
 
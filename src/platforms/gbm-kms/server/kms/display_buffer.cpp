@@ -352,7 +352,7 @@ public:
         tex_data = nullptr;
     }
 
-    mgg::GBMOutputSurface::FrontBuffer copy_front_buffer_from(mgg::GBMOutputSurface::FrontBuffer&& from)
+    mgg::GBMOutputSurface::FrontBuffer copy_front_buffer_from(gbm_bo* from)
     {
         egl.make_current();
         mir::Fd const dma_buf{gbm_bo_get_fd(from)};
@@ -457,40 +457,65 @@ mgg::DisplayBuffer::DisplayBuffer(
     if (!temporary_front)
         fatal_error("Failed to get frontbuffer");
 
-    if (needs_bounce_buffer(*outputs.front(), temporary_front))
+    /*
+     * Being on the same DRM device is guaranteed to be in the same GPU
+     * memory domain, so each device's outputs can share its scanout buffers.
+     */
+    for (auto const& output : outputs)
     {
-        mir::log_info("Hybrid GPU setup detected; DisplayBuffer using EGL buffer copies for migration");
-        get_front_buffer = std::bind(
-            std::mem_fn(&EGLBufferCopier::copy_front_buffer_from),
-            std::make_shared<EGLBufferCopier>(
-                mir::Fd{mir::IntOwnedFd{outputs.front()->drm_fd()}},
-                surface.size().width.as_int(),
-                surface.size().height.as_int(),
-                GBM_FORMAT_XRGB8888),
-            std::placeholders::_1);
+        auto const scanout = std::find_if(
+            scanouts.begin(), scanouts.end(),
+            [&output](Scanout const& s) { return s.outputs.front()->drm_fd() == output->drm_fd(); });
+
+        if (scanout != scanouts.end())
+        {
+            scanout->outputs.push_back(output);
+        }
+        else
+        {
+            scanouts.emplace_back();
+            scanouts.back().outputs.push_back(output);
+        }
     }
-    else
+
+    for (auto& scanout : scanouts)
     {
-        mir::log_info("Detected single-GPU DisplayBuffer. Rendering will be sent directly to output");
-        get_front_buffer = [](auto&& fb) { return std::move(fb); };
-    }
+        if (needs_bounce_buffer(*scanout.outputs.front(), temporary_front))
+        {
+            mir::log_info("Hybrid GPU setup detected; DisplayBuffer using EGL buffer copies for migration");
+            scanout.copy = std::bind(
+                std::mem_fn(&EGLBufferCopier::copy_front_buffer_from),
+                std::make_shared<EGLBufferCopier>(
+                    mir::Fd{mir::IntOwnedFd{scanout.outputs.front()->drm_fd()}},
+                    surface.size().width.as_int(),
+                    surface.size().height.as_int(),
+                    GBM_FORMAT_XRGB8888),
+                std::placeholders::_1);
+        }
+        else
+        {
+            mir::log_info("Detected single-GPU DisplayBuffer. Rendering will be sent directly to output");
+        }
 
-    visible_composite_frame = get_front_buffer(std::move(temporary_front));
+        auto const bufobj = fb_for(scanout, scanout.visible_copy, temporary_front);
 
-    /*
-     * Check that our (possibly bounced) front buffer is usable on *all* the
-     * outputs we've been asked to output on.
-     */
-    for (auto const& output : outputs)
-    {
-        if (output->buffer_requires_migration(visible_composite_frame))
+        /*
+         * Check that our (possibly bounced) front buffer is usable on *all* the
+         * outputs of the device.
+         */
+        for (auto const& output : scanout.outputs)
         {
-            BOOST_THROW_EXCEPTION(std::invalid_argument(
-                "Attempted to create a DisplayBuffer spanning multiple GPU memory domains"));
+            if (output->buffer_requires_migration(scanout.copy ? scanout.visible_copy : temporary_front))
+            {
+                BOOST_THROW_EXCEPTION(std::invalid_argument(
+                    "Attempted to scan out of a DisplayBuffer across GPU memory domains"));
+            }
         }
+
+        set_crtc(scanout, *bufobj);
     }
 
-    set_crtc(*outputs.front()->fb_for(visible_composite_frame));
+    visible_composite_frame = std::move(temporary_front);
 
     release_current();
 
@@ -537,6 +562,7 @@ bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
             auto native = std::dynamic_pointer_cast<mgg::NativeBuffer>(bypass_buffer->native_buffer_handle());
             if (native && native->flags & mir_buffer_flag_can_scanout &&
                 bypass_buffer->size() == surface.size() &&
+                scanouts.size() == 1 &&
                 !needs_bounce_buffer(*outputs.front(), native->bo))
             {
                 if (auto bufobj = outputs.front()->fb_for(native->bo))
@@ -567,9 +593,9 @@ void mgg::DisplayBuffer::swap_buffers()
     bypass_bufobj = nullptr;
 }
 
-void mgg::DisplayBuffer::set_crtc(FBHandle const& forced_frame)
+void mgg::DisplayBuffer::set_crtc(Scanout& scanout, FBHandle const& forced_frame)
 {
-    for (auto& output : outputs)
+    for (auto& output : scanout.outputs)
     {
         /*
          * Note that failure to set the CRTC is not a fatal error. This can
@@ -595,35 +621,28 @@ void mgg::DisplayBuffer::post()
      */
     wait_for_page_flip();
 
-    mgg::FBHandle *bufobj;
-    if (bypass_buf)
-    {
-        bufobj = bypass_bufobj;
-    }
-    else
+    if (!bypass_buf)
+        scheduled_composite_frame = surface.lock_front();
+
+    for (auto& scanout : scanouts)
     {
-        scheduled_composite_frame = get_front_buffer(surface.lock_front());
-        bufobj = outputs.front()->fb_for(scheduled_composite_frame);
+        auto const bufobj = bypass_buf ?
+            bypass_bufobj :
+            fb_for(scanout, scanout.scheduled_copy, scheduled_composite_frame);
         if (!bufobj)
             fatal_error("Failed to get front buffer object");
-    }
 
-    /*
-     * Try to schedule a page flip as first preference to avoid tearing.
-     * [will complete in a background thread]
-     */
-    if (!needs_set_crtc && !schedule_page_flip(*bufobj))
-        needs_set_crtc = true;
-
-    /*
-     * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
-     * to need to do this on every frame. [will complete in this thread]
-     */
-    if (needs_set_crtc)
-    {
-        set_crtc(*bufobj);
-        needs_set_crtc = false;
+        /*
+         * Try to schedule a page flip as first preference to avoid tearing.
+         * [will complete in a background thread]
+         *
+         * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
+         * to need to do this on every frame. [will complete in this thread]
+         */
+        if (needs_set_crtc || !schedule_page_flip(scanout, *bufobj))
+            set_crtc(scanout, *bufobj);
     }
+    needs_set_crtc = false;
 
     using namespace std;  // For operator""ms()
 
@@ -686,19 +705,35 @@ std::chrono::milliseconds mgg::DisplayBuffer::recommended_sleep() const
     return recommend_sleep;
 }
 
-bool mgg::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
+bool mgg::DisplayBuffer::schedule_page_flip(Scanout& scanout, FBHandle const& bufobj)
 {
     /*
      * Schedule the current front buffer object for display. Note that
      * the page flip is asynchronous and synchronized with vertical refresh.
      */
-    for (auto& output : outputs)
+    auto flipped = false;
+    for (auto& output : scanout.outputs)
     {
         if (output->schedule_page_flip(bufobj))
-            page_flips_pending = true;
+            flipped = true;
+    }
+
+    page_flips_pending = page_flips_pending || flipped;
+    return flipped;
+}
+
+mgg::FBHandle* mgg::DisplayBuffer::fb_for(
+    Scanout& scanout,
+    GBMOutputSurface::FrontBuffer& copy,
+    gbm_bo* rendered)
+{
+    if (scanout.copy)
+    {
+        copy = scanout.copy(rendered);
+        return scanout.outputs.front()->fb_for(copy);
     }
 
-    return page_flips_pending;
+    return scanout.outputs.front()->fb_for(rendered);
 }
 
 void mgg::DisplayBuffer::wait_for_page_flip()
@@ -721,6 +756,12 @@ void mgg::DisplayBuffer::wait_for_page_flip()
 
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
+
+        for (auto& scanout : scanouts)
+        {
+            scanout.visible_copy = std::move(scanout.scheduled_copy);
+            scanout.scheduled_copy = nullptr;
+        }
     }
 }
 
@@ -127,8 +127,25 @@ public:
     void wait_for_page_flip();
 
 private:
-    bool schedule_page_flip(FBHandle const& bufobj);
-    void set_crtc(FBHandle const&);
+    /// The outputs on one DRM device, and how it gets to scan out what is rendered
+    struct Scanout
+    {
+        std::vector<std::shared_ptr<KMSOutput>> outputs;
+
+        /*
+         * Copies a rendered frame into a buffer the device can scan out;
+         * empty if it can scan out the rendered buffers themselves.
+         * The copies depend on the EGLBufferCopier hidden inside.
+         */
+        std::function<GBMOutputSurface::FrontBuffer(gbm_bo*)> copy;
+        GBMOutputSurface::FrontBuffer visible_copy;
+        GBMOutputSurface::FrontBuffer scheduled_copy;
+    };
+
+    bool schedule_page_flip(Scanout& scanout, FBHandle const& bufobj);
+    void set_crtc(Scanout& scanout, FBHandle const&);
+    /// The \a rendered frame for \a scanout, copying it into \a copy if need be
+    static FBHandle* fb_for(Scanout& scanout, GBMOutputSurface::FrontBuffer& copy, gbm_bo* rendered);
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
@@ -137,14 +154,16 @@ private:
     BypassOption bypass_option;
 
     std::vector<std::shared_ptr<KMSOutput>> outputs;
+    /*
+     * Clones on other DRM devices share the one rendering, copied for
+     * those that cannot scan it out, rather than each rendering the scene.
+     */
+    std::vector<Scanout> scanouts;
 
     /*
      * Destruction order is important here:
-     *  - The GBMFrontBuffers depend on *either*:
-     *  i)  The GBMOutputSurface, or
-     *  ii) The EGLBufferCopier hidden inside get_front_buffer
+     *  - The rendered GBMFrontBuffers depend on the GBMOutputSurface
      */
-    std::function<GBMOutputSurface::FrontBuffer(GBMOutputSurface::FrontBuffer&&)> get_front_buffer;
     GBMOutputSurface surface;
 
     GBMOutputSurface::FrontBuffer visible_composite_frame;
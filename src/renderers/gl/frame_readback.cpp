@@ -0,0 +1,171 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "GLRenderer"
+
+#include "frame_readback.h"
+#include "mir/renderer/renderer.h"
+#include "mir/gl/pixel_pack_reader.h"
+#include "mir/log.h"
+
+#include MIR_SERVER_GL_H
+
+#include <cstring>
+#include <vector>
+
+namespace mrg = mir::renderer::gl;
+namespace geom = mir::geometry;
+
+namespace
+{
+std::size_t const bytes_per_pixel{4};
+
+// Readbacks in flight before we wait for the oldest. The GPU normally
+// finishes a frame long before this many more have been submitted.
+std::size_t const max_pending_frames{4};
+
+/// Where, in GL window coordinates, \a region of \a viewport was drawn
+auto gl_rect_of(geom::Rectangle const& region, geom::Rectangle const& viewport, GLint const (&gl_viewport)[4])
+    -> geom::Rectangle
+{
+    auto const offset = region.top_left - viewport.top_left;
+    return {
+        {gl_viewport[0] + offset.dx.as_int(),
+         gl_viewport[1] + viewport.size.height.as_int() - offset.dy.as_int() - region.size.height.as_int()},
+        region.size};
+}
+
+/// Whether the frame is drawn unscaled, so its regions can be read pixel for pixel
+bool readable(std::shared_ptr<mir::renderer::Readback> const& readback, geom::Rectangle const& viewport,
+    GLint (&gl_viewport)[4])
+{
+    glGetIntegerv(GL_VIEWPORT, gl_viewport);
+    if (gl_viewport[2] != viewport.size.width.as_int() || gl_viewport[3] != viewport.size.height.as_int())
+    {
+        readback->finished(false);
+        return false;
+    }
+    return true;
+}
+
+/// Delivers \a region, read bottom row first into \a rows, the right way up
+void deliver_flipped(
+    mir::renderer::Readback& readback,
+    geom::Rectangle const& region,
+    unsigned char const* rows,
+    std::vector<unsigned char>& scratch)
+{
+    auto const stride = region.size.width.as_uint32_t() * bytes_per_pixel;
+    auto const height = region.size.height.as_uint32_t();
+
+    scratch.resize(stride * height);
+    for (std::size_t y = 0; y != height; ++y)
+        std::memcpy(scratch.data() + y * stride, rows + (height - 1 - y) * stride, stride);
+
+    readback.deliver(region, scratch.data(), geom::Stride{stride});
+}
+
+class SynchronousReadback : public mrg::FrameReadback
+{
+public:
+    void read(std::shared_ptr<mir::renderer::Readback> const& readback, geom::Rectangle const& viewport) override
+    {
+        GLint gl_viewport[4];
+        if (!readable(readback, viewport, gl_viewport))
+            return;
+
+        for (auto const& region : readback->regions())
+        {
+            auto const gl_rect = gl_rect_of(region, viewport, gl_viewport);
+            pixels.resize(region.size.width.as_uint32_t() * region.size.height.as_uint32_t() * bytes_per_pixel);
+            glReadPixels(
+                gl_rect.top_left.x.as_int(), gl_rect.top_left.y.as_int(),
+                gl_rect.size.width.as_int(), gl_rect.size.height.as_int(),
+                GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+            deliver_flipped(*readback, region, pixels.data(), scratch);
+        }
+
+        readback->finished(true);
+    }
+
+    void collect() override
+    {
+    }
+
+private:
+    std::vector<unsigned char> pixels;
+    std::vector<unsigned char> scratch;
+};
+
+class PixelPackReadback : public mrg::FrameReadback
+{
+public:
+    explicit PixelPackReadback(std::unique_ptr<mir::gl::PixelPackReader> reader) :
+        reader{std::move(reader)}
+    {
+    }
+
+    void read(std::shared_ptr<mir::renderer::Readback> const& readback, geom::Rectangle const& viewport) override
+    {
+        GLint gl_viewport[4];
+        if (!readable(readback, viewport, gl_viewport))
+            return;
+
+        auto const regions = readback->regions();
+
+        std::vector<geom::Rectangle> gl_rects;
+        for (auto const& region : regions)
+            gl_rects.push_back(gl_rect_of(region, viewport, gl_viewport));
+
+        reader->read(
+            gl_rects,
+            [this, readback, regions](std::vector<unsigned char const*> const& rows)
+            {
+                bool complete{true};
+                auto region = regions.begin();
+                for (auto const region_rows : rows)
+                {
+                    if (region_rows)
+                        deliver_flipped(*readback, *region, region_rows, scratch);
+                    else
+                        complete = false;
+                    ++region;
+                }
+
+                readback->finished(complete);
+            });
+    }
+
+    void collect() override
+    {
+        reader->collect(0);
+    }
+
+private:
+    std::vector<unsigned char> scratch;
+    std::unique_ptr<mir::gl::PixelPackReader> const reader;
+};
+}
+
+auto mrg::FrameReadback::create() -> std::unique_ptr<FrameReadback>
+{
+    if (auto reader = mir::gl::PixelPackReader::create(max_pending_frames))
+        return std::make_unique<PixelPackReadback>(std::move(reader));
+
+    mir::log_info("Reading back frames synchronously (pixel-pack buffers are unsupported)");
+    return std::make_unique<SynchronousReadback>();
+}
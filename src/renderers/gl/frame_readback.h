@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_FRAME_READBACK_H_
+#define MIR_RENDERER_GL_FRAME_READBACK_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/displacement.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace renderer
+{
+class Readback;
+namespace gl
+{
+
+/**
+ * Reads regions of the frames rendered in the current GL context back to
+ * the CPU.
+ *
+ * All methods must be called with the same GL context current.
+ */
+class FrameReadback
+{
+public:
+    /**
+     * Reads through pixel-pack buffers and fences where the context supports
+     * them (GLES 3 or GL 3.2), so that the next frame needn't wait for this
+     * one to finish; otherwise reads synchronously.
+     */
+    static auto create() -> std::unique_ptr<FrameReadback>;
+
+    virtual ~FrameReadback() = default;
+
+    /**
+     * Starts reading \a readback from the frame just drawn into the GL viewport
+     * showing \a viewport. Call after the frame's last GL command, before
+     * swapping buffers.
+     */
+    virtual void read(std::shared_ptr<Readback> const& readback, geometry::Rectangle const& viewport) = 0;
+
+    /// Delivers the readbacks the GPU has finished since the last call
+    virtual void collect() = 0;
+
+protected:
+    FrameReadback() = default;
+    FrameReadback(FrameReadback const&) = delete;
+    FrameReadback& operator=(FrameReadback const&) = delete;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_GL_FRAME_READBACK_H_
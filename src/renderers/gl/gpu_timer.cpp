@@ -0,0 +1,336 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "GLRenderer"
+
+#include "gpu_timer.h"
+#include "mir/graphics/gl_extensions_base.h"
+#include "mir/gl/proc_address.h"
+#include "mir/log.h"
+
+#include MIR_SERVER_GL_H
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+namespace mrg = mir::renderer::gl;
+using mir::renderer::GPUTiming;
+
+namespace
+{
+// The core, ARB and EXT enums share values; GL headers only define some of them
+GLenum const time_elapsed{0x88BF};             // GL_TIME_ELAPSED
+GLenum const query_result{0x8866};             // GL_QUERY_RESULT
+GLenum const query_result_available{0x8867};   // GL_QUERY_RESULT_AVAILABLE
+GLenum const gpu_disjoint{0x8FBB};             // GL_GPU_DISJOINT_EXT
+
+// Frames in flight before we give up on the oldest. Results normally arrive
+// within a frame or two; this only bounds the queries used if they don't.
+std::size_t const max_pending_frames{8};
+
+class GLExtensions : public mir::graphics::GLExtensionsBase
+{
+public:
+    GLExtensions() :
+        mir::graphics::GLExtensionsBase{
+            reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS))}
+    {
+    }
+};
+
+/// Looks up the variant of entry point \a name with \a suffix
+template<typename Function>
+auto gl_function(std::string const& name, char const* suffix) -> Function
+{
+    return mir::gl::proc_address<Function>((name + suffix).c_str());
+}
+
+class TimerQueryGPUTimer : public mrg::GPUTimer
+{
+public:
+    /// \a suffix is that of the extension's entry points ("EXT" or "" for ARB)
+    TimerQueryGPUTimer(char const* suffix, bool can_be_disjoint) :
+        gen_queries{gl_function<decltype(gen_queries)>("glGenQueries", suffix)},
+        delete_queries{gl_function<decltype(delete_queries)>("glDeleteQueries", suffix)},
+        begin_query{gl_function<decltype(begin_query)>("glBeginQuery", suffix)},
+        end_query{gl_function<decltype(end_query)>("glEndQuery", suffix)},
+        get_query_objectuiv{gl_function<decltype(get_query_objectuiv)>("glGetQueryObjectuiv", suffix)},
+        get_query_objectui64v{gl_function<decltype(get_query_objectui64v)>("glGetQueryObjectui64v", suffix)},
+        can_be_disjoint{can_be_disjoint}
+    {
+    }
+
+    ~TimerQueryGPUTimer()
+    {
+        if (active)
+            end_query(time_elapsed);
+
+        for (auto const& frame : pending)
+            recycle(frame);
+        recycle(current);
+
+        if (!free_queries.empty())
+            delete_queries(free_queries.size(), free_queries.data());
+    }
+
+    bool usable() const
+    {
+        return gen_queries && delete_queries && begin_query && end_query &&
+               get_query_objectuiv && get_query_objectui64v;
+    }
+
+    void begin(GPUTiming::Class c) override
+    {
+        if (active && current.back().first == c)
+            return;
+
+        if (active)
+            end_query(time_elapsed);
+
+        auto const query = allocate();
+        begin_query(time_elapsed, query);
+        current.emplace_back(c, query);
+        active = true;
+    }
+
+    void end_frame() override
+    {
+        if (!active)
+            return;
+
+        end_query(time_elapsed);
+        active = false;
+
+        pending.push_back(std::move(current));
+        current.clear();
+
+        if (pending.size() > max_pending_frames)
+        {
+            recycle(pending.front());
+            pending.pop_front();
+        }
+    }
+
+    auto completed() -> std::vector<GPUTiming> override
+    {
+        std::vector<GPUTiming> timings;
+
+        // Something (a clock change, power management) may have made the
+        // timer queries meaningless; if so, drop everything measured so far
+        if (can_be_disjoint)
+        {
+            GLint disjoint{GL_FALSE};
+            glGetIntegerv(gpu_disjoint, &disjoint);
+            if (disjoint)
+            {
+                for (auto const& frame : pending)
+                    recycle(frame);
+                pending.clear();
+                return timings;
+            }
+        }
+
+        while (!pending.empty() && available(pending.front()))
+        {
+            GPUTiming timing{GPUTiming::Method::timer_query, {}, {}};
+            for (auto const& span : pending.front())
+            {
+                std::uint64_t elapsed{0};
+                get_query_objectui64v(span.second, query_result, &elapsed);
+
+                std::chrono::nanoseconds const time{elapsed};
+                timing.frame_time += time;
+                timing.class_time[static_cast<std::size_t>(span.first)] += time;
+            }
+            timings.push_back(timing);
+
+            recycle(pending.front());
+            pending.pop_front();
+        }
+
+        return timings;
+    }
+
+private:
+    using Frame = std::vector<std::pair<GPUTiming::Class, GLuint>>;
+
+    auto allocate() -> GLuint
+    {
+        if (free_queries.empty())
+        {
+            GLuint query{0};
+            gen_queries(1, &query);
+            return query;
+        }
+
+        auto const query = free_queries.back();
+        free_queries.pop_back();
+        return query;
+    }
+
+    void recycle(Frame const& frame)
+    {
+        for (auto const& span : frame)
+            free_queries.push_back(span.second);
+    }
+
+    bool available(Frame const& frame) const
+    {
+        for (auto const& span : frame)
+        {
+            GLuint result{GL_FALSE};
+            get_query_objectuiv(span.second, query_result_available, &result);
+            if (!result)
+                return false;
+        }
+        return true;
+    }
+
+    void (*const gen_queries)(GLsizei, GLuint*);
+    void (*const delete_queries)(GLsizei, GLuint const*);
+    void (*const begin_query)(GLenum, GLuint);
+    void (*const end_query)(GLenum);
+    void (*const get_query_objectuiv)(GLuint, GLenum, GLuint*);
+    void (*const get_query_objectui64v)(GLuint, GLenum, std::uint64_t*);
+    bool const can_be_disjoint;
+
+    Frame current;
+    bool active{false};
+    std::deque<Frame> pending;
+    std::vector<GLuint> free_queries;
+};
+
+class FenceGPUTimer : public mrg::GPUTimer
+{
+public:
+    FenceGPUTimer(EGLDisplay display) :
+        display{display},
+        create_sync{mir::gl::proc_address<PFNEGLCREATESYNCKHRPROC>("eglCreateSyncKHR")},
+        destroy_sync{mir::gl::proc_address<PFNEGLDESTROYSYNCKHRPROC>("eglDestroySyncKHR")},
+        client_wait_sync{mir::gl::proc_address<PFNEGLCLIENTWAITSYNCKHRPROC>("eglClientWaitSyncKHR")}
+    {
+    }
+
+    ~FenceGPUTimer()
+    {
+        for (auto const& frame : pending)
+            destroy_sync(display, frame.fence);
+    }
+
+    bool usable() const
+    {
+        return create_sync && destroy_sync && client_wait_sync;
+    }
+
+    void begin(GPUTiming::Class) override
+    {
+        in_frame = true;
+    }
+
+    void end_frame() override
+    {
+        if (!in_frame)
+            return;
+        in_frame = false;
+
+        auto const fence = create_sync(display, EGL_SYNC_FENCE_KHR, nullptr);
+        if (fence == EGL_NO_SYNC_KHR)
+            return;
+
+        pending.push_back({fence, std::chrono::steady_clock::now()});
+
+        if (pending.size() > max_pending_frames)
+        {
+            destroy_sync(display, pending.front().fence);
+            pending.pop_front();
+        }
+    }
+
+    auto completed() -> std::vector<GPUTiming> override
+    {
+        std::vector<GPUTiming> timings;
+
+        auto const now = std::chrono::steady_clock::now();
+        while (!pending.empty() &&
+               client_wait_sync(display, pending.front().fence, 0, 0) == EGL_CONDITION_SATISFIED_KHR)
+        {
+            timings.push_back({
+                GPUTiming::Method::fence,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - pending.front().submitted),
+                {}});
+
+            destroy_sync(display, pending.front().fence);
+            pending.pop_front();
+        }
+
+        return timings;
+    }
+
+private:
+    struct Frame
+    {
+        EGLSyncKHR fence;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    EGLDisplay const display;
+    PFNEGLCREATESYNCKHRPROC const create_sync;
+    PFNEGLDESTROYSYNCKHRPROC const destroy_sync;
+    PFNEGLCLIENTWAITSYNCKHRPROC const client_wait_sync;
+
+    bool in_frame{false};
+    std::deque<Frame> pending;
+};
+}
+
+auto mrg::GPUTimer::create() -> std::unique_ptr<GPUTimer>
+{
+    GLExtensions const extensions;
+
+    std::unique_ptr<TimerQueryGPUTimer> timer_query;
+    if (extensions.support("GL_EXT_disjoint_timer_query"))
+        timer_query = std::make_unique<TimerQueryGPUTimer>("EXT", true);
+    else if (extensions.support("GL_ARB_timer_query"))
+        timer_query = std::make_unique<TimerQueryGPUTimer>("", false);
+
+    if (timer_query && timer_query->usable())
+    {
+        mir::log_info("Measuring GPU time with timer queries");
+        return timer_query;
+    }
+
+    auto const display = eglGetCurrentDisplay();
+    if (display != EGL_NO_DISPLAY)
+    {
+        auto const egl_extensions = eglQueryString(display, EGL_EXTENSIONS);
+        if (egl_extensions && mir::graphics::GLExtensionsBase{egl_extensions}.support("EGL_KHR_fence_sync"))
+        {
+            auto fence = std::make_unique<FenceGPUTimer>(display);
+            if (fence->usable())
+            {
+                mir::log_info("Measuring GPU time with fences (timer queries are unsupported)");
+                return fence;
+            }
+        }
+    }
+
+    mir::log_warning("Cannot measure GPU time: neither timer queries nor fences are supported");
+    return nullptr;
+}
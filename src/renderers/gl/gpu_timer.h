@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_GPU_TIMER_H_
+#define MIR_RENDERER_GL_GPU_TIMER_H_
+
+#include "mir/renderer/gpu_timing.h"
+
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+namespace gl
+{
+
+/**
+ * Times the GPU work of the frames rendered in the current GL context,
+ * without stalling the pipeline to wait for results.
+ *
+ * A frame's work is split into spans by calling begin() with the class of
+ * what follows; consecutive spans of the same class are timed together.
+ * All methods must be called with the same GL context current.
+ */
+class GPUTimer
+{
+public:
+    /**
+     * Uses timer queries (GL_EXT_disjoint_timer_query or GL_ARB_timer_query)
+     * where available, otherwise EGL_KHR_fence_sync fences.
+     * \return null if the context supports neither
+     */
+    static auto create() -> std::unique_ptr<GPUTimer>;
+
+    virtual ~GPUTimer() = default;
+
+    /// Starts a span of work of class \a c, starting the frame if need be
+    virtual void begin(GPUTiming::Class c) = 0;
+
+    /// Ends the frame. Call after its last GL command, before swapping buffers.
+    virtual void end_frame() = 0;
+
+    /// Timings of frames whose results became available since the last call
+    virtual auto completed() -> std::vector<GPUTiming> = 0;
+
+protected:
+    GPUTimer() = default;
+    GPUTimer(GPUTimer const&) = delete;
+    GPUTimer& operator=(GPUTimer const&) = delete;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_GL_GPU_TIMER_H_
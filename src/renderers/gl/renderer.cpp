@@ -19,12 +19,15 @@
 #define MIR_LOG_COMPONENT "GLRenderer"
 
 #include "renderer.h"
+#include "gpu_timer.h"
+#include "frame_readback.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/gl/default_program_factory.h"
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/display_buffer.h"
 #include "mir/gl/tessellation_helpers.h"
+#include "mir/gl/texture_atlas.h"
 #include "mir/gl/texture_cache.h"
 #include "mir/gl/texture.h"
 #include "mir/log.h"
@@ -40,6 +43,7 @@
 #include <EGL/egl.h>
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
 #include <sstream>
@@ -49,6 +53,114 @@ namespace mgl = mir::gl;
 namespace mrg = mir::renderer::gl;
 namespace geom = mir::geometry;
 
+namespace
+{
+// As draw() blends them
+auto gpu_timing_class_of(mg::Renderable const& renderable) -> mir::renderer::GPUTiming::Class
+{
+    if (renderable.shaped() || renderable.alpha() < 1.0f)
+        return mir::renderer::GPUTiming::Class::blended;
+
+    return mir::renderer::GPUTiming::Class::opaque;
+}
+
+struct BlendSeparate  // Represents parameters of glBlendFuncSeparate()
+{
+    GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+};
+
+auto client_blend_of(mg::Renderable const& renderable) -> BlendSeparate
+{
+    // These renderable method names could be better (see LP: #1236224)
+    if (renderable.shaped())  // Client is RGBA:
+    {
+        return {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
+    }
+    else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
+    {
+        return {GL_ONE,  GL_ZERO,
+                GL_ZERO, GL_ONE};  // Avoid using src_alpha!
+    }
+    else
+    {   // Client is RGBX but we also have window translucency.
+        // The texture alpha channel is possibly uninitialized so we must be
+        // careful and avoid using SRC_ALPHA (LP: #1423462).
+        glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
+        return {GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
+                GL_ZERO, GL_ONE};
+    }
+}
+
+void apply(BlendSeparate const& blend)
+{
+    if (blend.dst_rgb == GL_ZERO)
+    {
+        glDisable(GL_BLEND);
+    }
+    else
+    {
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
+                            blend.src_alpha, blend.dst_alpha);
+    }
+}
+
+auto max_texture_size() -> int
+{
+    GLint size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+    return size;
+}
+
+/*
+ * Here we provide a 3D perspective projection with a default 30 degrees
+ * vertical field of view. This projection matrix is carefully designed
+ * such that any vertices at depth z=0 will fit the screen coordinates. So
+ * client texels will fit screen pixels perfectly as long as the surface is
+ * at depth zero. But if you want to do anything fancy, you can also choose
+ * a different depth and it will appear to come out of or go into the
+ * screen.
+ */
+auto screen_to_gl_coords_for(geom::Rectangle const& rect) -> glm::mat4
+{
+    auto screen_to_gl_coords = glm::translate(glm::mat4(1.0f), glm::vec3{-1.0f, 1.0f, 0.0f});
+
+    /*
+     * Perspective division is one thing that can't be done in a matrix
+     * multiplication. It happens after the matrix multiplications. GL just
+     * scales {x,y} by 1/w. So modify the final part of the projection matrix
+     * to set w ([3]) to be the incoming z coordinate ([2]).
+     */
+    screen_to_gl_coords[2][3] = -1.0f;
+
+    float const vertical_fov_degrees = 30.0f;
+    float const near =
+        (rect.size.height.as_int() / 2.0f) /
+        std::tan((vertical_fov_degrees * M_PI / 180.0f) / 2.0f);
+    float const far = -near;
+
+    screen_to_gl_coords = glm::scale(screen_to_gl_coords,
+            glm::vec3{2.0f / rect.size.width.as_int(),
+                      -2.0f / rect.size.height.as_int(),
+                      2.0f / (near - far)});
+    screen_to_gl_coords = glm::translate(screen_to_gl_coords,
+            glm::vec3{-rect.top_left.x.as_int(),
+                      -rect.top_left.y.as_int(),
+                      0.0f});
+
+    return screen_to_gl_coords;
+}
+
+/// Whether draw_atlas_batch() can draw the renderable's primitives from the atlas
+bool is_atlas_quad(std::vector<mir::gl::Primitive> const& primitives)
+{
+    return primitives.size() == 1 &&
+           primitives[0].type == GL_TRIANGLE_STRIP &&
+           primitives[0].nvertices == 4;
+}
+}
+
 mrg::CurrentRenderTarget::CurrentRenderTarget(mg::DisplayBuffer* display_buffer)
     : render_target{
         dynamic_cast<renderer::gl::RenderTarget*>(display_buffer->native_display_buffer())}
@@ -350,14 +462,21 @@ mrg::Renderer::Program::Program(GLuint program_id)
     alpha_uniform = glGetUniformLocation(id, "alpha");
 }
 
-mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
+mrg::Renderer::Renderer(
+    graphics::DisplayBuffer& display_buffer,
+    bool measure_gpu_time,
+    mgl::ChargeTextureMemory const& charge_texture_memory,
+    std::size_t texture_cache_budget)
     : render_target(&display_buffer),
       clear_color{0.0f, 0.0f, 0.0f, 0.0f},
       default_program(family.add_program(vshader, default_fshader)),
       alpha_program(family.add_program(vshader, alpha_fshader)),
       program_factory{std::make_unique<ProgramFactory>()},
-      texture_cache(mgl::DefaultProgramFactory().create_texture_cache()),
-      display_transform(1)
+      texture_cache(mgl::DefaultProgramFactory(charge_texture_memory, texture_cache_budget).create_texture_cache()),
+      texture_atlas{std::make_unique<mgl::TextureAtlas>(charge_texture_memory)},
+      static_groups{std::make_unique<StaticGroups>(max_texture_size(), charge_texture_memory)},
+      display_transform(1),
+      gpu_timer{measure_gpu_time ? GPUTimer::create() : nullptr}
 {
     eglBindAPI(MIR_SERVER_EGL_OPENGL_API);
     EGLDisplay disp = eglGetCurrentDisplay();
@@ -414,6 +533,10 @@ mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
 mrg::Renderer::~Renderer()
 {
     render_target.ensure_current();
+
+    frame_readback.reset();
+    for (auto const& readback : requested_readbacks)
+        readback->finished(false);
 }
 
 void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
@@ -427,26 +550,89 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 {
     render_target.bind();
 
+    if (frame_readback)
+        frame_readback->collect();
+
+    auto const& groups = static_groups->find(renderables);
+    flatten(groups);
+
+    if (gpu_timer)
+        gpu_timer->begin(GPUTiming::Class::clear);
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
+    auto group = groups.begin();
+    for (auto r = renderables.begin(); r != renderables.end();)
     {
-        draw(*r);
+        if (gpu_timer)
+            gpu_timer->begin(gpu_timing_class_of(**r));
+
+        if (group != groups.end() && group->begin == r)
+        {
+            draw_group(*group);
+            r = group++->end;
+            continue;
+        }
+
+        auto const batch_end = draw_atlas_batch(r, renderables.end());
+        if (batch_end != r)
+            r = batch_end;
+        else
+            draw(**r++);
     }
 
+    if (gpu_timer)
+        gpu_timer->end_frame();
+
+    if (!requested_readbacks.empty())
+        read_back_frame();
+
     render_target.swap_buffers();
 
     // Deleting unused textures only requires the GL context. This clean-up
     // does not affect screen contents so can happen after swap_buffers...
     texture_cache->drop_unused();
+    texture_atlas->drop_unused();
+    static_groups->drop_unused();
 
     while (auto const gl_error = glGetError())
         mir::log_debug("GL error: %d", gl_error);
 }
 
+auto mrg::Renderer::completed_gpu_timings() -> std::vector<GPUTiming>
+{
+    if (!gpu_timer)
+        return {};
+
+    render_target.ensure_current();
+    return gpu_timer->completed();
+}
+
+void mrg::Renderer::read_back(std::shared_ptr<Readback> const& readback)
+{
+    requested_readbacks.push_back(readback);
+}
+
+void mrg::Renderer::read_back_frame() const
+{
+    if (!frame_readback)
+        frame_readback = FrameReadback::create();
+
+    for (auto const& readback : requested_readbacks)
+    {
+        // Rotated outputs are drawn rotated; we don't undo that
+        if (display_transform == glm::mat4(1))
+            frame_readback->read(readback, viewport);
+        else
+            readback->finished(false);
+    }
+
+    requested_readbacks.clear();
+}
+
 void mrg::Renderer::draw(mg::Renderable const& renderable) const
 {
     auto const clip_area = renderable.clip_area();
@@ -514,23 +700,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
 
     auto const& prog = *maybe_prog;
 
-    glUseProgram(prog.id);
-    if (prog.last_used_frameno != frameno)
-    {   // Avoid reloading the screen-global uniforms on every renderable
-        // TODO: We actually only need to bind these *once*, right? Not once per frame?
-        prog.last_used_frameno = frameno;
-        for (auto i = 0u; i < prog.tex_uniforms.size(); ++i)
-        {
-            if (prog.tex_uniforms[i] != -1)
-            {
-                glUniform1i(prog.tex_uniforms[i], i);
-            }
-        }
-        glUniformMatrix4fv(prog.display_transform_uniform, 1, GL_FALSE,
-                           glm::value_ptr(display_transform));
-        glUniformMatrix4fv(prog.screen_to_gl_coords_uniform, 1, GL_FALSE,
-                           glm::value_ptr(screen_to_gl_coords));
-    }
+    use_program(prog);
 
     glActiveTexture(GL_TEXTURE0);
 
@@ -569,38 +739,10 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
     {
-        typedef struct  // Represents parameters of glBlendFuncSeparate()
-        {
-            GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
-        } BlendSeparate;
-
-        BlendSeparate client_blend;
-
-        // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped())  // Client is RGBA:
-        {
-            client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
-                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
-        }
-        else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
-        {
-            client_blend = {GL_ONE,  GL_ZERO,
-                            GL_ZERO, GL_ONE};  // Avoid using src_alpha!
-        }
-        else
-        {   // Client is RGBX but we also have window translucency.
-            // The texture alpha channel is possibly uninitialized so we must be
-            // careful and avoid using SRC_ALPHA (LP: #1423462).
-            client_blend = {GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
-                            GL_ZERO, GL_ONE};
-            glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
-        }
+        auto const client_blend = client_blend_of(renderable);
 
         for (auto const& p : primitives)
         {
-            BlendSeparate blend;
-
-            blend = client_blend;
             if (surface_tex)
             {
                 surface_tex->bind();
@@ -617,16 +759,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
                                   GL_FALSE, sizeof(mgl::Vertex),
                                   &p.vertices[0].texcoord);
 
-            if (blend.dst_rgb == GL_ZERO)
-            {
-                glDisable(GL_BLEND);
-            }
-            else
-            {
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
-                                    blend.src_alpha, blend.dst_alpha);
-            }
+            apply(client_blend);
 
             glDrawArrays(p.type, 0, p.nvertices);
 
@@ -650,50 +783,190 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     }
 }
 
-void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
+void mrg::Renderer::use_program(Program const& prog) const
 {
-    if (rect == viewport)
+    glUseProgram(prog.id);
+    if (prog.last_used_frameno != frameno)
+    {   // Avoid reloading the screen-global uniforms on every renderable
+        // TODO: We actually only need to bind these *once*, right? Not once per frame?
+        prog.last_used_frameno = frameno;
+        for (auto i = 0u; i < prog.tex_uniforms.size(); ++i)
+        {
+            if (prog.tex_uniforms[i] != -1)
+            {
+                glUniform1i(prog.tex_uniforms[i], i);
+            }
+        }
+        glUniformMatrix4fv(prog.display_transform_uniform, 1, GL_FALSE,
+                           glm::value_ptr(display_transform));
+        glUniformMatrix4fv(prog.screen_to_gl_coords_uniform, 1, GL_FALSE,
+                           glm::value_ptr(screen_to_gl_coords));
+    }
+}
+
+auto mrg::Renderer::draw_atlas_batch(
+    mg::RenderableList::const_iterator first,
+    mg::RenderableList::const_iterator last) const -> mg::RenderableList::const_iterator
+{
+    batch_vertices.clear();
+    mgl::Texture const* page = nullptr;
+
+    auto r = first;
+    for (; r != last; ++r)
+    {
+        auto const& renderable = **r;
+
+        // Batched vertices are in screen coordinates, so can't be transformed or clipped
+        if (renderable.clip_area() || renderable.transformation() != glm::mat4(1))
+            break;
+
+        auto const entry = texture_atlas->load(renderable);
+        if (!entry)
+            break;
+
+        if (page &&
+            (entry->page != page ||
+             renderable.alpha() != (**first).alpha() ||
+             renderable.shaped() != (**first).shaped()))
+        {
+            break;
+        }
+
+        primitives.clear();
+        tessellate(primitives, renderable);
+        if (!is_atlas_quad(primitives))
+            break;
+
+        page = entry->page;
+
+        // The strip's texcoords span the whole texture; map them onto the entry
+        mgl::Vertex quad[4];
+        for (auto i = 0; i != 4; ++i)
+        {
+            auto const& v = primitives[0].vertices[i];
+            quad[i] = v;
+            quad[i].texcoord[0] = entry->left + v.texcoord[0] * (entry->right - entry->left);
+            quad[i].texcoord[1] = entry->top + v.texcoord[1] * (entry->bottom - entry->top);
+        }
+
+        // As two separate triangles, so that all the quads can be drawn at once
+        for (auto i : {0, 1, 2, 2, 1, 3})
+            batch_vertices.push_back(quad[i]);
+    }
+
+    if (r - first < 2)
+        return first;
+
+    draw_from_texture(*page, batch_vertices, **first);
+
+    return r;
+}
+
+void mrg::Renderer::draw_from_texture(
+    mgl::Texture const& texture,
+    std::vector<mgl::Vertex> const& triangles,
+    mg::Renderable const& like) const
+{
+    auto const& prog = like.alpha() < 1.0f ? alpha_program : default_program;
+
+    use_program(prog);
+
+    glActiveTexture(GL_TEXTURE0);
+    glUniform2f(prog.centre_uniform, 0.0f, 0.0f);
+    glUniformMatrix4fv(prog.transform_uniform, 1, GL_FALSE, glm::value_ptr(glm::mat4(1)));
+
+    if (prog.alpha_uniform >= 0)
+        glUniform1f(prog.alpha_uniform, like.alpha());
+
+    texture.bind();
+
+    glEnableVertexAttribArray(prog.position_attr);
+    glEnableVertexAttribArray(prog.texcoord_attr);
+    glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
+                          GL_FALSE, sizeof(mgl::Vertex),
+                          &triangles[0].position);
+    glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
+                          GL_FALSE, sizeof(mgl::Vertex),
+                          &triangles[0].texcoord);
+
+    apply(client_blend_of(like));
+
+    glDrawArrays(GL_TRIANGLES, 0, triangles.size());
+
+    glDisableVertexAttribArray(prog.texcoord_attr);
+    glDisableVertexAttribArray(prog.position_attr);
+}
+
+void mrg::Renderer::flatten(std::vector<StaticGroups::Group> const& groups) const
+{
+    auto const stale = [](StaticGroups::Group const& group) { return group.stale; };
+    if (std::none_of(groups.begin(), groups.end(), stale))
         return;
 
-    /*
-     * Here we provide a 3D perspective projection with a default 30 degrees
-     * vertical field of view. This projection matrix is carefully designed
-     * such that any vertices at depth z=0 will fit the screen coordinates. So
-     * client texels will fit screen pixels perfectly as long as the surface is
-     * at depth zero. But if you want to do anything fancy, you can also choose
-     * a different depth and it will appear to come out of or go into the
-     * screen.
-     */
-    screen_to_gl_coords = glm::translate(glm::mat4(1.0f), glm::vec3{-1.0f, 1.0f, 0.0f});
+    if (gpu_timer)
+        gpu_timer->begin(GPUTiming::Class::blended);
 
-    /*
-     * Perspective division is one thing that can't be done in a matrix
-     * multiplication. It happens after the matrix multiplications. GL just
-     * scales {x,y} by 1/w. So modify the final part of the projection matrix
-     * to set w ([3]) to be the incoming z coordinate ([2]).
-     */
-    screen_to_gl_coords[2][3] = -1.0f;
+    auto const screen_to_gl_coords_of_output = screen_to_gl_coords;
+    auto const display_transform_of_output = display_transform;
+    display_transform = glm::mat4(1);
 
-    float const vertical_fov_degrees = 30.0f;
-    float const near =
-        (rect.size.height.as_int() / 2.0f) /
-        std::tan((vertical_fov_degrees * M_PI / 180.0f) / 2.0f);
-    float const far = -near;
+    for (auto const& group : groups)
+    {
+        if (!stale(group))
+            continue;
 
-    screen_to_gl_coords = glm::scale(screen_to_gl_coords,
-            glm::vec3{2.0f / rect.size.width.as_int(),
-                      -2.0f / rect.size.height.as_int(),
-                      2.0f / (near - far)});
-    screen_to_gl_coords = glm::translate(screen_to_gl_coords,
-            glm::vec3{-rect.top_left.x.as_int(),
-                      -rect.top_left.y.as_int(),
-                      0.0f});
+        glBindFramebuffer(GL_FRAMEBUFFER, group.framebuffer);
+        glViewport(0, 0, group.area.size.width.as_int(), group.area.size.height.as_int());
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        screen_to_gl_coords = screen_to_gl_coords_for(group.area);
+        ++frameno;  // So that draw() loads the screen-global uniforms for the group
+
+        for (auto r = group.begin; r != group.end; ++r)
+            draw(**r);
+    }
 
+    screen_to_gl_coords = screen_to_gl_coords_of_output;
+    display_transform = display_transform_of_output;
+
+    render_target.bind();
+    update_gl_viewport();
+}
+
+void mrg::Renderer::draw_group(StaticGroups::Group const& group) const
+{
+    GLfloat const left = group.area.top_left.x.as_int();
+    GLfloat const right = left + group.area.size.width.as_int();
+    GLfloat const top = group.area.top_left.y.as_int();
+    GLfloat const bottom = top + group.area.size.height.as_int();
+
+    // The texture was drawn bottom row first
+    mgl::Vertex const quad[]{
+        {{left,  top,    0.0f}, {0.0f, 1.0f}},
+        {{left,  bottom, 0.0f}, {0.0f, 0.0f}},
+        {{right, top,    0.0f}, {1.0f, 1.0f}},
+        {{right, bottom, 0.0f}, {1.0f, 0.0f}}};
+
+    batch_vertices.clear();
+    for (auto i : {0, 1, 2, 2, 1, 3})
+        batch_vertices.push_back(quad[i]);
+
+    // It blends as its first renderable does
+    draw_from_texture(*group.texture, batch_vertices, **group.begin);
+}
+
+void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
+{
+    if (rect == viewport)
+        return;
+
+    screen_to_gl_coords = screen_to_gl_coords_for(rect);
     viewport = rect;
     update_gl_viewport();
 }
 
-void mrg::Renderer::update_gl_viewport()
+void mrg::Renderer::update_gl_viewport() const
 {
     /*
      * Letterboxing: Move the glViewport to add black bars in the case that
@@ -742,5 +1015,12 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
 void mrg::Renderer::suspend()
 {
     texture_cache->invalidate();
+    texture_atlas->invalidate();
+    static_groups->invalidate();
+}
+
+auto mrg::Renderer::texture_cache_usage() -> TextureCacheUsage
+{
+    return texture_cache->usage();
 }
 
@@ -20,12 +20,14 @@
 #define MIR_RENDERER_GL_RENDERER_H_
 
 #include "program_family.h"
+#include "static_groups.h"
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
+#include <mir/gl/texture_cache.h>
 #include "mir/renderer/gl/render_target.h"
 
 #include MIR_SERVER_GL_H
@@ -35,12 +37,14 @@
 
 namespace mir
 {
-namespace gl { class TextureCache; }
 namespace graphics { class DisplayBuffer; }
+namespace gl { class TextureAtlas; }
 namespace renderer
 {
 namespace gl
 {
+class GPUTimer;
+class FrameReadback;
 
 class CurrentRenderTarget
 {
@@ -59,16 +63,28 @@ private:
 class Renderer : public renderer::Renderer
 {
 public:
-    Renderer(graphics::DisplayBuffer& display_buffer);
+    /**
+     * With \a measure_gpu_time, times frames on the GPU (see completed_gpu_timings()).
+     * The memory of the textures made of renderables is charged by \a charge_texture_memory.
+     * Up to \a texture_cache_budget bytes of them are kept for renderables not drawn.
+     */
+    Renderer(
+        graphics::DisplayBuffer& display_buffer,
+        bool measure_gpu_time = false,
+        mir::gl::ChargeTextureMemory const& charge_texture_memory = {},
+        std::size_t texture_cache_budget = 0);
     virtual ~Renderer();
 
     // These are called with a valid GL context:
     void set_viewport(geometry::Rectangle const& rect) override;
     void set_output_transform(glm::mat2 const&) override;
     void render(graphics::RenderableList const&) const override;
+    auto completed_gpu_timings() -> std::vector<GPUTiming> override;
+    void read_back(std::shared_ptr<Readback> const& readback) override;
 
-    // This is called _without_ a GL context:
+    // These are called _without_ a GL context:
     void suspend() override;
+    auto texture_cache_usage() -> TextureCacheUsage override;
 
     struct Program
     {
@@ -126,15 +142,43 @@ protected:
     virtual void draw(graphics::Renderable const& renderable) const;
 
 private:
-    void update_gl_viewport();
+    void update_gl_viewport() const;
+    void read_back_frame() const;
+    void use_program(Program const& prog) const;
+
+    /// Draws \a triangles, textured from \a texture, as \a like would be drawn
+    void draw_from_texture(
+        mir::gl::Texture const& texture,
+        std::vector<mir::gl::Vertex> const& triangles,
+        graphics::Renderable const& like) const;
+
+    /// Draws the stale \a groups into their textures
+    void flatten(std::vector<StaticGroups::Group> const& groups) const;
+    void draw_group(StaticGroups::Group const& group) const;
+
+    /**
+     * Draws the renderables from \a first that are all in one page of the
+     * texture atlas with a single draw call.
+     * \return the end of those drawn; \a first if too few could be drawn together
+     */
+    auto draw_atlas_batch(
+        graphics::RenderableList::const_iterator first,
+        graphics::RenderableList::const_iterator last) const -> graphics::RenderableList::const_iterator;
 
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
     std::unique_ptr<mir::gl::TextureCache> const texture_cache;
+    std::unique_ptr<mir::gl::TextureAtlas> const texture_atlas;
+    std::unique_ptr<StaticGroups> const static_groups;
     geometry::Rectangle viewport;
-    glm::mat4 screen_to_gl_coords;
-    glm::mat4 display_transform;
+    // Changed while flattening groups, to draw into their textures
+    glm::mat4 mutable screen_to_gl_coords;
+    glm::mat4 mutable display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+    std::vector<mir::gl::Vertex> mutable batch_vertices;
+    std::unique_ptr<GPUTimer> const gpu_timer;
+    std::unique_ptr<FrameReadback> mutable frame_readback;
+    std::vector<std::shared_ptr<Readback>> mutable requested_readbacks;
 };
 
 }
@@ -22,9 +22,20 @@
 
 namespace mrg = mir::renderer::gl;
 
+mrg::RendererFactory::RendererFactory(
+    bool measure_gpu_time,
+    ChargeTextureMemory const& charge_texture_memory,
+    std::size_t texture_cache_budget)
+    : measure_gpu_time{measure_gpu_time},
+      charge_texture_memory{charge_texture_memory},
+      texture_cache_budget{texture_cache_budget}
+{
+}
+
 std::unique_ptr<mir::renderer::Renderer>
 mrg::RendererFactory::create_renderer_for(
     graphics::DisplayBuffer& display_buffer)
 {
-    return std::make_unique<Renderer>(display_buffer);
+    return std::make_unique<Renderer>(
+        display_buffer, measure_gpu_time, charge_texture_memory, texture_cache_budget);
 }
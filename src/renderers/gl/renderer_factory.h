@@ -20,6 +20,10 @@
 #define MIR_RENDERER_GL_RENDERER_FACTORY_H_
 
 #include "mir/renderer/renderer_factory.h"
+#include "mir/graphics/renderable.h"
+
+#include <cstddef>
+#include <functional>
 
 namespace mir
 {
@@ -31,8 +35,28 @@ namespace gl
 class RendererFactory : public renderer::RendererFactory
 {
 public:
+    /// Charges \a bytes of texture memory held for the renderable \a id (see mir::gl::ChargeTextureMemory)
+    using ChargeTextureMemory =
+        std::function<std::shared_ptr<void>(graphics::Renderable::ID id, std::size_t bytes)>;
+
+    /**
+     * With \a measure_gpu_time, the renderers time their frames on the GPU.
+     * They charge the memory of the textures they make by \a charge_texture_memory,
+     * and each keeps up to \a texture_cache_budget bytes of texture for
+     * renderables that aren't being drawn.
+     */
+    explicit RendererFactory(
+        bool measure_gpu_time = false,
+        ChargeTextureMemory const& charge_texture_memory = {},
+        std::size_t texture_cache_budget = 0);
+
     std::unique_ptr<renderer::Renderer> create_renderer_for(
         graphics::DisplayBuffer& display_buffer) override;
+
+private:
+    bool const measure_gpu_time;
+    ChargeTextureMemory const charge_texture_memory;
+    std::size_t const texture_cache_budget;
 };
 
 }
@@ -0,0 +1,222 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "GLRenderer"
+
+#include "static_groups.h"
+#include "mir/gl/texture.h"
+#include "mir/graphics/buffer.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace mgl = mir::gl;
+namespace mrg = mir::renderer::gl;
+namespace geom = mir::geometry;
+
+struct mrg::StaticGroups::Target
+{
+    explicit Target(geom::Size const& size);
+    ~Target();
+
+    mgl::Texture const texture;
+    GLuint framebuffer{0};
+    geom::Size const size;
+};
+
+namespace
+{
+/// Whether the renderable can be drawn into a group's texture as it would be to the screen
+bool groupable(mg::Renderable const& renderable)
+{
+    return !renderable.clip_area() &&
+           renderable.alpha() == 1.0f &&
+           renderable.transformation() == glm::mat4(1);
+}
+}
+
+mrg::StaticGroups::Target::Target(geom::Size const& size)
+    : size{size}
+{
+    // The texture is left bound by its construction
+    glTexImage2D(
+        GL_TEXTURE_2D, 0, GL_RGBA, size.width.as_int(), size.height.as_int(), 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    GLint previous_framebuffer{0};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_framebuffer);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.tex_id(), 0);
+    auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, previous_framebuffer);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to set up FBO for a group of renderables"));
+    }
+}
+
+mrg::StaticGroups::Target::~Target()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+bool mrg::StaticGroups::Member::operator==(Member const& that) const
+{
+    return id == that.id && buffer == that.buffer && position == that.position && shaped == that.shaped;
+}
+
+std::size_t const mrg::StaticGroups::min_group_size;
+int const mrg::StaticGroups::frames_before_flattening;
+
+mrg::StaticGroups::StaticGroups(int max_texture_size, mgl::ChargeTextureMemory const& charge)
+    : max_texture_size{max_texture_size},
+      charge_memory{charge}
+{
+}
+
+mrg::StaticGroups::~StaticGroups() = default;
+
+auto mrg::StaticGroups::find(mg::RenderableList const& renderables) -> std::vector<Group> const&
+{
+    groups.clear();
+
+    for (auto r = renderables.begin(); r != renderables.end();)
+    {
+        auto const end = group_from(r, renderables.end());
+        if (end == r)
+        {
+            ++r;
+            continue;
+        }
+
+        members.clear();
+        for (auto m = r; m != end; ++m)
+        {
+            auto const& renderable = **m;
+            members.push_back(
+                {renderable.id(), renderable.buffer()->id(), renderable.screen_position(), renderable.shaped()});
+        }
+
+        auto& entry = entries[(*r)->id()];
+        entry.used = true;
+
+        if (entry.members == members)
+        {
+            entry.frames_unchanged = std::min(entry.frames_unchanged + 1, frames_before_flattening);
+        }
+        else
+        {
+            entry.members = members;
+            entry.frames_unchanged = 0;
+            entry.drawn = false;
+        }
+
+        auto const area = (*r)->screen_position();
+        if (entry.frames_unchanged == frames_before_flattening && !entry.unsupported)
+        {
+            if (!entry.target || entry.target->size != area.size)
+            {
+                entry.memory_charge.reset();
+                entry.target.reset();
+
+                try
+                {
+                    entry.target = std::make_unique<Target>(area.size);
+                }
+                catch (std::exception const& error)
+                {
+                    mir::log_warning("Cannot flatten unchanging renderables: %s", error.what());
+                    entry.unsupported = true;
+                }
+
+                if (entry.target && charge_memory)
+                {
+                    entry.memory_charge = charge_memory(
+                        (*r)->id(), std::size_t{area.size.width.as_uint32_t()} * area.size.height.as_uint32_t() * 4);
+                }
+            }
+
+            if (entry.target)
+            {
+                groups.push_back({r, end, area, &entry.target->texture, entry.target->framebuffer, !entry.drawn});
+                entry.drawn = true;
+            }
+        }
+
+        r = end;
+    }
+
+    return groups;
+}
+
+void mrg::StaticGroups::drop_unused()
+{
+    for (auto e = entries.begin(); e != entries.end();)
+    {
+        if (e->second.used)
+        {
+            e->second.used = false;
+            ++e;
+        }
+        else
+        {
+            e = entries.erase(e);
+        }
+    }
+}
+
+void mrg::StaticGroups::invalidate()
+{
+    for (auto& entry : entries)
+        entry.second.drawn = false;
+}
+
+auto mrg::StaticGroups::group_from(
+    mg::RenderableList::const_iterator first,
+    mg::RenderableList::const_iterator last) const -> mg::RenderableList::const_iterator
+{
+    auto const& head = **first;
+    auto const area = head.screen_position();
+
+    if (!groupable(head) ||
+        area.size.width.as_int() <= 0 || area.size.width.as_int() > max_texture_size ||
+        area.size.height.as_int() <= 0 || area.size.height.as_int() > max_texture_size)
+    {
+        return first;
+    }
+
+    auto end = std::next(first);
+    while (end != last && groupable(**end) && area.contains((*end)->screen_position()))
+        ++end;
+
+    if (std::size_t(end - first) < min_group_size)
+        return first;
+
+    // Drawn on an opaque first renderable anything blends as it would on
+    // screen; on a shaped one only premultiplied (shaped) content does.
+    if (head.shaped())
+        end = std::find_if(std::next(first), end, [](auto const& r) { return !r->shaped(); });
+
+    return std::size_t(end - first) >= min_group_size ? end : first;
+}
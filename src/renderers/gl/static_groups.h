@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_STATIC_GROUPS_H_
+#define MIR_RENDERER_GL_STATIC_GROUPS_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/graphics/renderable.h"
+#include "mir/gl/texture_cache.h"
+
+#include MIR_SERVER_GL_H
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace gl { class Texture; }
+namespace renderer
+{
+namespace gl
+{
+
+/**
+ * Finds runs of renderables that stay the same from frame to frame (such as
+ * an idle window and its subsurfaces) and keeps each flattened into a
+ * texture, so that it can be drawn as one.
+ *
+ * A group is a renderable followed by those drawn within its screen area,
+ * all untransformed, unclipped and not translucent, so that the group blends
+ * like its first renderable. Any of them showing a new buffer, moving or
+ * changing makes the group be drawn renderable by renderable again until
+ * it has settled.
+ *
+ * All methods but invalidate() must be called with the same GL context
+ * current.
+ */
+class StaticGroups
+{
+public:
+    /// The fewest renderables worth flattening together
+    static std::size_t const min_group_size = 3;
+    /// How many frames a group must be unchanged for before it is flattened
+    static int const frames_before_flattening = 2;
+
+    struct Group
+    {
+        /// The renderables in the group
+        graphics::RenderableList::const_iterator begin, end;
+        /// The screen area they cover: that of the first
+        geometry::Rectangle area;
+        /// Holds the group drawn (bottom row first) once \a stale is false
+        mir::gl::Texture const* texture;
+        /// Attaches \a texture, for drawing the group into
+        GLuint framebuffer;
+        /// Whether the group must be drawn into \a texture before it is used
+        bool stale;
+    };
+
+    /**
+     * \param max_texture_size  the GL implementation's largest texture size
+     * \param charge            charges the memory of the groups' textures
+     */
+    StaticGroups(int max_texture_size, mir::gl::ChargeTextureMemory const& charge);
+    ~StaticGroups();
+
+    /**
+     * The groups among this frame's \a renderables that are flattened, or
+     * to be, in order. Valid until the next call.
+     */
+    auto find(graphics::RenderableList const& renderables) -> std::vector<Group> const&;
+
+    /// Frees the textures of groups not found since the last drop
+    void drop_unused();
+
+    /// The groups' textures need drawing again; doesn't need a GL context
+    void invalidate();
+
+private:
+    struct Target;
+
+    struct Member
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer;
+        geometry::Rectangle position;
+        bool shaped;
+
+        bool operator==(Member const& that) const;
+    };
+
+    struct Entry
+    {
+        std::vector<Member> members;
+        int frames_unchanged{0};
+        std::unique_ptr<Target> target;
+        bool drawn{false};
+        bool unsupported{false};
+        bool used{true};
+        std::shared_ptr<void> memory_charge;
+    };
+
+    /// The end of the group starting at \a first; \a first if it doesn't start one
+    auto group_from(
+        graphics::RenderableList::const_iterator first,
+        graphics::RenderableList::const_iterator last) const -> graphics::RenderableList::const_iterator;
+
+    int const max_texture_size;
+    mir::gl::ChargeTextureMemory const charge_memory;
+    std::unordered_map<graphics::Renderable::ID, Entry> entries;
+    std::vector<Member> members;
+    std::vector<Group> groups;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_GL_STATIC_GROUPS_H_
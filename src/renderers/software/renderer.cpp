@@ -0,0 +1,371 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "SoftwareRenderer"
+
+#include "renderer.h"
+#include "mir/geometry/displacement.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/display_buffer.h"
+#include "mir/graphics/pixel_conversion.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The shadow framebuffer always holds 32-bit pixels, which is all blend_pixels() takes
+int const shadow_bytes_per_pixel{4};
+
+bool cpu_readable(mg::Buffer& buffer)
+{
+    auto const native = buffer.native_buffer_base();
+    return dynamic_cast<mrs::ReadMappableBuffer*>(native) ||
+           dynamic_cast<mrs::ReadTransferableBuffer*>(native) ||
+           dynamic_cast<mrs::PixelSource*>(native);
+}
+
+/// Whether \a renderable is drawn pixel for pixel from a buffer we can read
+bool drawable_as_is(mg::Renderable const& renderable)
+{
+    auto const buffer = renderable.buffer();
+    return buffer &&
+           renderable.transformation() == glm::mat4(1) &&
+           buffer->size() == renderable.screen_position().size &&
+           cpu_readable(*buffer);
+}
+
+/// \a format, with any alpha it has ignored
+auto without_alpha(MirPixelFormat format) -> MirPixelFormat
+{
+    switch (format)
+    {
+    case mir_pixel_format_abgr_8888: return mir_pixel_format_xbgr_8888;
+    case mir_pixel_format_argb_8888: return mir_pixel_format_xrgb_8888;
+    default: return format;
+    }
+}
+
+/// The offset, in bytes, of \a point in pixels with \a origin at their start
+auto offset_of(geom::Point const& point, geom::Point const& origin, int stride, int bytes_per_pixel)
+    -> std::ptrdiff_t
+{
+    auto const offset = point - origin;
+    return static_cast<std::ptrdiff_t>(offset.dy.as_int()) * stride + offset.dx.as_int() * bytes_per_pixel;
+}
+}
+
+/// A renderable of the frame being composited, with its pixels mapped once they are needed
+class mrs::Renderer::Layer
+{
+public:
+    explicit Layer(mg::Renderable const& renderable)
+        : renderable{renderable},
+          visible_area{
+              renderable.clip_area() ?
+                  renderable.screen_position().intersection_with(renderable.clip_area().value()) :
+                  renderable.screen_position()},
+          drawable{drawable_as_is(renderable)},
+          opaque{!renderable.shaped() && renderable.alpha() >= 1.0f}
+    {
+    }
+
+    auto pixels() -> Mapping<unsigned char const>&
+    {
+        if (!mapping)
+            mapping = as_read_mappable_buffer(renderable.buffer())->map_readable();
+        return *mapping;
+    }
+
+    mg::Renderable const& renderable;
+    geom::Rectangle const visible_area;
+    bool const drawable;
+    bool const opaque;
+
+private:
+    std::unique_ptr<Mapping<unsigned char const>> mapping;
+};
+
+mrs::Renderer::Renderer(
+    mg::DisplayBuffer& display_buffer,
+    WriteMappableBuffer& target,
+    std::unique_ptr<renderer::Renderer> fallback)
+    : target{target},
+      rw_target{dynamic_cast<RWMappableBuffer*>(&target)},
+      fallback{std::move(fallback)},
+      viewport{display_buffer.view_area()}
+{
+}
+
+mrs::Renderer::~Renderer()
+{
+    for (auto const& readback : requested_readbacks)
+        readback->finished(false);
+}
+
+void mrs::Renderer::set_viewport(geom::Rectangle const& rect)
+{
+    viewport = rect;
+
+    if (fallback)
+        fallback->set_viewport(rect);
+}
+
+void mrs::Renderer::set_output_transform(glm::mat2 const& transform)
+{
+    output_transform = transform;
+
+    if (fallback)
+        fallback->set_output_transform(transform);
+}
+
+void mrs::Renderer::render(mg::RenderableList const& renderables) const
+{
+    // Only a mapping that can be read holds the previous frame; those merely written are undefined
+    auto mapping = rw_target ? rw_target->map_rw() : target.map_writeable();
+    auto const drawable = drawable_in_software(renderables, mapping->size());
+
+    if (!drawable && fallback)
+    {
+        mapping.reset();
+
+        for (auto const& readback : requested_readbacks)
+            fallback->read_back(readback);
+        requested_readbacks.clear();
+
+        fallback->render(renderables);
+
+        // The shadow framebuffer missed this frame, so needs redrawing in full
+        damage_tracker.reset();
+        target_stale = true;
+        return;
+    }
+
+    if (!drawable && !warned_of_undrawable)
+    {
+        mir::log_warning("Cannot composite scaled, transformed or GPU-only content without GL; leaving it out");
+        warned_of_undrawable = true;
+    }
+
+    auto const format = MIR_BYTES_PER_PIXEL(mapping->format()) == shadow_bytes_per_pixel ?
+        mapping->format() : mir_pixel_format_argb_8888;
+    auto const pixel_count =
+        std::size_t{viewport.size.width.as_uint32_t()} * viewport.size.height.as_uint32_t();
+
+    if (format != shadow_format || shadow.size() != pixel_count)
+    {
+        shadow_format = format;
+        shadow.assign(pixel_count, 0);
+        damage_tracker.reset();
+        target_stale = true;
+    }
+
+    std::vector<Layer> layers;
+    layers.reserve(renderables.size());
+    for (auto const& renderable : renderables)
+        layers.emplace_back(*renderable);
+
+    auto const damage = damage_tracker.damage_for(viewport, renderables);
+    for (auto const& area : damage)
+        composite(layers, area);
+
+    if (target_stale || !rw_target)
+    {
+        // What the shadow doesn't cover is cleared
+        if (mapping->size() != viewport.size)
+            std::memset(mapping->data(), 0, mapping->len());
+
+        copy_to(*mapping, viewport);
+        target_stale = false;
+    }
+    else
+    {
+        // The target still holds the rest of the previous frame
+        for (auto const& area : damage)
+            copy_to(*mapping, area);
+    }
+
+    if (!requested_readbacks.empty())
+        read_back_frame();
+}
+
+void mrs::Renderer::suspend()
+{
+    // The shadow framebuffer holds the last frame composited, whatever is shown
+    // meanwhile; the display buffer might not
+    target_stale = true;
+
+    if (fallback)
+        fallback->suspend();
+}
+
+auto mrs::Renderer::completed_gpu_timings() -> std::vector<GPUTiming>
+{
+    return fallback ? fallback->completed_gpu_timings() : std::vector<GPUTiming>{};
+}
+
+auto mrs::Renderer::texture_cache_usage() -> TextureCacheUsage
+{
+    return fallback ? fallback->texture_cache_usage() : renderer::Renderer::texture_cache_usage();
+}
+
+void mrs::Renderer::read_back(std::shared_ptr<Readback> const& readback)
+{
+    requested_readbacks.push_back(readback);
+}
+
+bool mrs::Renderer::drawable_in_software(mg::RenderableList const& renderables, geom::Size const& size) const
+{
+    return output_transform == glm::mat2(1) &&
+           size == viewport.size &&
+           std::all_of(renderables.begin(), renderables.end(), [](auto const& r) { return drawable_as_is(*r); });
+}
+
+void mrs::Renderer::composite(std::vector<Layer>& layers, geom::Rectangle const& area) const
+{
+    // Nothing below the topmost layer to cover all of the area opaquely shows
+    auto const covering = std::find_if(layers.rbegin(), layers.rend(), [&area](Layer const& layer)
+        {
+            return layer.drawable && layer.opaque && layer.visible_area.contains(area);
+        });
+
+    if (covering == layers.rend())
+    {
+        auto const shadow_width = viewport.size.width.as_uint32_t();
+        auto const offset = area.top_left - viewport.top_left;
+
+        for (auto y = 0; y != area.size.height.as_int(); ++y)
+        {
+            auto const row = std::size_t{shadow_width} * (offset.dy.as_int() + y) + offset.dx.as_int();
+            mg::fill_pixels(shadow.data() + row, area.size.width.as_uint32_t(), 0);
+        }
+    }
+
+    auto const first = covering == layers.rend() ? layers.begin() : std::prev(covering.base());
+    for (auto layer = first; layer != layers.end(); ++layer)
+        draw(*layer, area);
+}
+
+void mrs::Renderer::draw(Layer& layer, geom::Rectangle const& area) const
+{
+    auto const drawn = layer.visible_area.intersection_with(area);
+    if (!layer.drawable || drawn.size.width.as_int() <= 0 || drawn.size.height.as_int() <= 0)
+        return;
+
+    auto& pixels = layer.pixels();
+    auto source_format = pixels.format();
+    auto source_stride = pixels.stride().as_int();
+    void const* source = pixels.data() + offset_of(
+        drawn.top_left, layer.renderable.screen_position().top_left,
+        source_stride, MIR_BYTES_PER_PIXEL(source_format));
+
+    auto const shadow_stride = viewport.size.width.as_int() * shadow_bytes_per_pixel;
+    auto const dest = reinterpret_cast<unsigned char*>(shadow.data()) + offset_of(
+        drawn.top_left, viewport.top_left, shadow_stride, shadow_bytes_per_pixel);
+
+    if (layer.opaque)
+    {
+        mg::convert_pixels(drawn.size, source_format, source, source_stride, shadow_format, dest, shadow_stride);
+        return;
+    }
+
+    if (MIR_BYTES_PER_PIXEL(source_format) != shadow_bytes_per_pixel)
+    {
+        // Only 32-bit pixels blend, so others are converted to those first
+        scratch.resize(std::size_t{drawn.size.width.as_uint32_t()} * drawn.size.height.as_uint32_t());
+        auto const scratch_stride = drawn.size.width.as_int() * shadow_bytes_per_pixel;
+        mg::convert_pixels(
+            drawn.size, source_format, source, source_stride,
+            mir_pixel_format_abgr_8888, scratch.data(), scratch_stride);
+
+        source_format = mir_pixel_format_abgr_8888;
+        source = scratch.data();
+        source_stride = scratch_stride;
+    }
+
+    // As GL draws them, unshaped renderables are opaque however they are faded
+    auto const alpha = std::lround(std::min(std::max(layer.renderable.alpha(), 0.0f), 1.0f) * 255);
+    mg::blend_pixels(
+        drawn.size,
+        layer.renderable.shaped() ? source_format : without_alpha(source_format), source, source_stride,
+        shadow_format, dest, shadow_stride,
+        static_cast<uint8_t>(alpha));
+}
+
+void mrs::Renderer::copy_to(Mapping<unsigned char>& mapping, geom::Rectangle const& area) const
+{
+    auto const copied = area.intersection_with({viewport.top_left, mapping.size()});
+    if (copied.size.width.as_int() <= 0 || copied.size.height.as_int() <= 0)
+        return;
+
+    auto const shadow_stride = viewport.size.width.as_int() * shadow_bytes_per_pixel;
+    auto const target_stride = mapping.stride().as_int();
+
+    mg::convert_pixels(
+        copied.size,
+        shadow_format,
+        reinterpret_cast<unsigned char const*>(shadow.data()) +
+            offset_of(copied.top_left, viewport.top_left, shadow_stride, shadow_bytes_per_pixel),
+        shadow_stride,
+        mapping.format(),
+        mapping.data() +
+            offset_of(copied.top_left, viewport.top_left, target_stride, MIR_BYTES_PER_PIXEL(mapping.format())),
+        target_stride);
+}
+
+void mrs::Renderer::read_back_frame() const
+{
+    auto const shadow_stride = viewport.size.width.as_int() * shadow_bytes_per_pixel;
+
+    for (auto const& readback : requested_readbacks)
+    {
+        auto const regions = readback->regions();
+        if (!std::all_of(regions.begin(), regions.end(), [this](auto const& r) { return viewport.contains(r); }))
+        {
+            readback->finished(false);
+            continue;
+        }
+
+        for (auto const& region : regions)
+        {
+            auto const stride = region.size.width.as_int() * shadow_bytes_per_pixel;
+            scratch.resize(std::size_t{region.size.width.as_uint32_t()} * region.size.height.as_uint32_t());
+
+            mg::convert_pixels(
+                region.size,
+                shadow_format,
+                reinterpret_cast<unsigned char const*>(shadow.data()) +
+                    offset_of(region.top_left, viewport.top_left, shadow_stride, shadow_bytes_per_pixel),
+                shadow_stride,
+                mir_pixel_format_abgr_8888, scratch.data(), stride);
+
+            readback->deliver(
+                region, reinterpret_cast<unsigned char const*>(scratch.data()), geom::Stride{stride});
+        }
+
+        readback->finished(true);
+    }
+
+    requested_readbacks.clear();
+}
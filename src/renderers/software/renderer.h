@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SOFTWARE_RENDERER_H_
+#define MIR_RENDERER_SOFTWARE_RENDERER_H_
+
+#include "mir/renderer/renderer.h"
+#include "mir/compositor/damage_tracker.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics { class DisplayBuffer; }
+namespace renderer
+{
+namespace software
+{
+class WriteMappableBuffer;
+class RWMappableBuffer;
+template<typename T> class Mapping;
+
+/**
+ * Composites on the CPU, into display buffers that can be mapped.
+ *
+ * Frames are composited into a shadow framebuffer, redrawing only what the
+ * renderables changed and, within that, only from the topmost renderable
+ * that covers it opaquely. The shadow is then copied to the display buffer:
+ * only what was redrawn if the display buffer can be mapped for reading and
+ * writing (so its mapping holds the previous frame), otherwise all of it.
+ *
+ * Frames that need scaling or transforming are drawn by \a fallback (a GL
+ * renderer, where the display buffer supports GL). Without one, the parts
+ * of them that can't be drawn are left out.
+ */
+class Renderer : public renderer::Renderer
+{
+public:
+    Renderer(
+        graphics::DisplayBuffer& display_buffer,
+        WriteMappableBuffer& target,
+        std::unique_ptr<renderer::Renderer> fallback = {});
+    ~Renderer();
+
+    void set_viewport(geometry::Rectangle const& rect) override;
+    void set_output_transform(glm::mat2 const& transform) override;
+    void render(graphics::RenderableList const& renderables) const override;
+    void suspend() override;
+
+    auto completed_gpu_timings() -> std::vector<GPUTiming> override;
+    auto texture_cache_usage() -> TextureCacheUsage override;
+    void read_back(std::shared_ptr<Readback> const& readback) override;
+
+private:
+    class Layer;
+
+    /// Whether \a renderables can be composited unscaled and untransformed into a target of \a size
+    bool drawable_in_software(graphics::RenderableList const& renderables, geometry::Size const& size) const;
+    void composite(std::vector<Layer>& layers, geometry::Rectangle const& area) const;
+    void draw(Layer& layer, geometry::Rectangle const& area) const;
+    void read_back_frame() const;
+    /// Copies \a area of the shadow framebuffer to the same place in \a mapping
+    void copy_to(Mapping<unsigned char>& mapping, geometry::Rectangle const& area) const;
+
+    WriteMappableBuffer& target;
+    /// \a target, if it can be mapped with its content
+    RWMappableBuffer* const rw_target;
+    std::unique_ptr<renderer::Renderer> const fallback;
+
+    geometry::Rectangle viewport;
+    glm::mat2 output_transform{1};
+
+    mutable compositor::DamageTracker damage_tracker;
+    mutable MirPixelFormat shadow_format{mir_pixel_format_invalid};
+    mutable std::vector<uint32_t> shadow;
+    mutable std::vector<uint32_t> scratch;
+    /// Whether the target may hold other than the shadow as it was last copied
+    mutable bool target_stale{true};
+    mutable bool warned_of_undrawable{false};
+    mutable std::vector<std::shared_ptr<Readback>> requested_readbacks;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_SOFTWARE_RENDERER_H_
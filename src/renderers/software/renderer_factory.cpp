@@ -0,0 +1,44 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer_factory.h"
+#include "renderer.h"
+#include "mir/graphics/display_buffer.h"
+#include "mir/renderer/gl/render_target.h"
+#include "mir/renderer/sw/pixel_source.h"
+
+namespace mrs = mir::renderer::software;
+
+mrs::RendererFactory::RendererFactory(std::shared_ptr<renderer::RendererFactory> const& gl_factory)
+    : gl_factory{gl_factory}
+{
+}
+
+std::unique_ptr<mir::renderer::Renderer>
+mrs::RendererFactory::create_renderer_for(graphics::DisplayBuffer& display_buffer)
+{
+    auto const native = display_buffer.native_display_buffer();
+
+    auto const target = dynamic_cast<WriteMappableBuffer*>(native);
+    if (!target)
+        return gl_factory->create_renderer_for(display_buffer);
+
+    std::unique_ptr<renderer::Renderer> fallback;
+    if (dynamic_cast<gl::RenderTarget*>(native))
+        fallback = gl_factory->create_renderer_for(display_buffer);
+
+    return std::make_unique<Renderer>(display_buffer, *target, std::move(fallback));
+}
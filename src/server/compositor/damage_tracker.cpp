@@ -0,0 +1,153 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/damage_tracker.h"
+#include "mir/graphics/buffer.h"
+
+#include <unordered_map>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Past this, copying the odd extra pixel is cheaper than tracking each rectangle
+std::size_t const max_damage_rectangles{16};
+}
+
+void mc::add_damage(geom::Rectangles& damage, geom::Rectangle const& area)
+{
+    if (area.size.width == geom::Width{0} || area.size.height == geom::Height{0})
+        return;
+
+    geom::Rectangles merged;
+    for (auto const& rect : damage)
+    {
+        if (rect.contains(area))
+            return;
+
+        if (!area.contains(rect))
+            merged.add(rect);
+    }
+    merged.add(area);
+
+    if (merged.size() > max_damage_rectangles)
+        merged = geom::Rectangles{merged.bounding_rectangle()};
+
+    damage = merged;
+}
+
+auto mc::DamageTracker::Drawn::visible_area() const -> geom::Rectangle
+{
+    return position.intersection_with(clip);
+}
+
+bool mc::DamageTracker::Drawn::looks_same_as(Drawn const& other) const
+{
+    return buffer == other.buffer &&
+           position == other.position &&
+           clip == other.clip &&
+           alpha == other.alpha &&
+           transformation == other.transformation;
+}
+
+auto mc::DamageTracker::damage_for(geom::Rectangle const& view_area, mg::RenderableList const& renderables)
+    -> geom::Rectangles
+{
+    std::vector<Drawn> current;
+    current.reserve(renderables.size());
+    for (auto const& renderable : renderables)
+    {
+        auto const buffer = renderable->buffer();
+        auto const position = renderable->screen_position();
+        auto const clip = renderable->clip_area();
+
+        current.push_back({
+            renderable->id(),
+            buffer ? buffer->id() : mg::BufferID{},
+            position,
+            clip ? clip.value() : position,
+            renderable->alpha(),
+            renderable->transformation()});
+    }
+
+    geom::Rectangles damage;
+    bool all_damaged{!have_previous || view_area != previous_view_area};
+
+    if (!all_damaged)
+    {
+        std::unordered_map<mg::Renderable::ID, std::size_t> previous_index;
+        for (std::size_t i = 0; i != previous.size(); ++i)
+            previous_index[previous[i].id] = i;
+
+        std::vector<bool> still_drawn(previous.size(), false);
+        std::size_t stacked_above{0};
+
+        auto const damage_area_of = [&](Drawn const& drawn)
+            {
+                // Transformed renderables may be drawn outside their position
+                if (drawn.transformation != glm::mat4(1))
+                    all_damaged = true;
+                else
+                    add_damage(damage, drawn.visible_area().intersection_with(view_area));
+            };
+
+        for (auto const& drawn : current)
+        {
+            auto const found = previous_index.find(drawn.id);
+            if (found == previous_index.end())
+            {
+                damage_area_of(drawn);
+                continue;
+            }
+
+            auto const& before = previous[found->second];
+            still_drawn[found->second] = true;
+
+            // Restacked renderables change what they overlap
+            bool const restacked = found->second < stacked_above;
+            stacked_above = std::max(stacked_above, found->second);
+
+            if (restacked || !drawn.looks_same_as(before))
+            {
+                damage_area_of(before);
+                damage_area_of(drawn);
+            }
+        }
+
+        for (std::size_t i = 0; i != previous.size(); ++i)
+        {
+            if (!still_drawn[i])
+                damage_area_of(previous[i]);
+        }
+    }
+
+    if (all_damaged)
+        damage = geom::Rectangles{view_area};
+
+    have_previous = true;
+    previous_view_area = view_area;
+    previous = std::move(current);
+
+    return damage;
+}
+
+void mc::DamageTracker::reset()
+{
+    have_previous = false;
+    previous.clear();
+}
@@ -22,14 +22,24 @@
 #include "buffer_stream_factory.h"
 #include "default_display_buffer_compositor_factory.h"
 #include "multi_threaded_compositor.h"
+#include "input_latency_tracker.h"
 #include "gl/renderer_factory.h"
+#include "software/renderer_factory.h"
 #include "mir/main_loop.h"
+#include "mir/scene/memory_accounting.h"
+#include "mir/compositor/screen_capture.h"
+#include "mir/input/scene.h"
+#include "mir/graphics/display.h"
+#include "mir/graphics/display_configuration.h"
 
 #include "mir/options/configuration.h"
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+
 namespace mc = mir::compositor;
+namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace mf = mir::frontend;
 
@@ -50,7 +60,31 @@ mir::DefaultServerConfiguration::the_display_buffer_compositor_factory()
         [this]()
         {
             return wrap_display_buffer_compositor_factory(std::make_shared<mc::DefaultDisplayBufferCompositorFactory>(
-                the_renderer_factory(), the_compositor_report()));
+                the_renderer_factory(), the_compositor_report(), the_screen_capture()));
+        });
+}
+
+std::shared_ptr<mc::ScreenCapture>
+mir::DefaultServerConfiguration::the_screen_capture()
+{
+    return screen_capture(
+        [this]()
+        {
+            auto const scene = the_input_scene();
+            auto const display = the_display();
+            return std::make_shared<mc::ScreenCapture>(
+                [scene] { scene->emit_scene_changed(); },
+                [display]
+                {
+                    std::vector<mir::geometry::Rectangle> outputs;
+                    display->configuration()->for_each_output(
+                        [&outputs](mg::DisplayConfigurationOutput const& output)
+                        {
+                            if (output.used)
+                                outputs.push_back(output.extents());
+                        });
+                    return outputs;
+                });
         });
 }
 
@@ -70,6 +104,10 @@ mir::DefaultServerConfiguration::the_compositor()
             std::chrono::milliseconds const composite_delay(
                 the_options()->get<int>(options::composite_delay_opt));
 
+            std::shared_ptr<mc::InputLatencyTracker> input_latency;
+            if (the_options()->is_set(options::track_input_latency_opt))
+                input_latency = std::make_shared<mc::InputLatencyTracker>(the_metrics_registry(), the_clock());
+
             return std::make_shared<mc::MultiThreadedCompositor>(
                 the_display(),
                 the_scene(),
@@ -77,15 +115,33 @@ mir::DefaultServerConfiguration::the_compositor()
                 the_shell(),
                 the_compositor_report(),
                 composite_delay,
-                true);
+                true,
+                input_latency);
         });
 }
 
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
-        []()
+        [this]()
         {
-            return std::make_shared<mir::renderer::gl::RendererFactory>();
+            auto const memory_accounting = the_memory_accounting();
+            auto const texture_cache_budget_mib =
+                std::max(the_options()->get<int>(options::texture_cache_budget_opt), 0);
+
+            auto const gl_factory = std::make_shared<mir::renderer::gl::RendererFactory>(
+                the_options()->is_set(options::gpu_timing_opt),
+                [memory_accounting](mir::graphics::Renderable::ID id, std::size_t bytes)
+                {
+                    return memory_accounting->charge_texture(id, bytes);
+                },
+                std::size_t(texture_cache_budget_mib) * 1024 * 1024);
+
+            if (!the_options()->is_set(options::software_compositing_opt))
+                return std::shared_ptr<mir::renderer::RendererFactory>{gl_factory};
+
+            // Display buffers that can be mapped are composited on the CPU
+            return std::shared_ptr<mir::renderer::RendererFactory>{
+                std::make_shared<mir::renderer::software::RendererFactory>(gl_factory)};
         });
 }
@@ -25,6 +25,7 @@
 #include "mir/graphics/display_buffer.h"
 #include "mir/graphics/buffer.h"
 #include "mir/compositor/buffer_stream.h"
+#include "mir/compositor/screen_capture.h"
 #include "mir/renderer/renderer.h"
 #include "occlusion.h"
 #include <mutex>
@@ -37,10 +38,12 @@ namespace mg = mir::graphics;
 mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     mg::DisplayBuffer& display_buffer,
     std::shared_ptr<mir::renderer::Renderer> const& renderer,
-    std::shared_ptr<mc::CompositorReport> const& report) :
+    std::shared_ptr<mc::CompositorReport> const& report,
+    std::shared_ptr<ScreenCapture> const& screen_capture) :
     display_buffer(display_buffer),
     renderer(renderer),
-    report(report)
+    report(report),
+    screen_capture(screen_capture)
 {
 }
 
@@ -72,7 +75,21 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      */
     scene_elements.clear();  // Those in use are still in renderable_list
 
-    if (display_buffer.overlay(renderable_list))
+    std::vector<std::shared_ptr<mir::renderer::Readback>> readbacks;
+    if (screen_capture && screen_capture->active())
+    {
+        readbacks = screen_capture->frame(view_area, damage_tracker.damage_for(view_area, renderable_list));
+    }
+    else
+    {
+        damage_tracker.reset();
+    }
+
+    // Captures are read from what the renderer draws, so it has to draw them. Those
+    // it started reading in earlier frames only complete in frames it draws too.
+    bool const reading_back = !readbacks.empty() || (screen_capture && screen_capture->reading_back());
+
+    if (!reading_back && display_buffer.overlay(renderable_list))
     {
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
@@ -81,11 +98,17 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     {
         renderer->set_output_transform(display_buffer.transformation());
         renderer->set_viewport(view_area);
+        for (auto const& readback : readbacks)
+            renderer->read_back(readback);
         renderer->render(renderable_list);
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
 
+        for (auto const& timing : renderer->completed_gpu_timings())
+            report->gpu_timed_frame(this, timing);
+        report->texture_cache_used(this, renderer->texture_cache_usage());
+
         /*
          * This is used for the 'early release' optimization to release buffers
          * we did use back to clients before starting on the potentially slow
@@ -21,6 +21,7 @@
 
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/compositor_report.h"
+#include "mir/compositor/damage_tracker.h"
 #include <memory>
 
 namespace mir
@@ -37,6 +38,7 @@ namespace compositor
 {
 
 class Scene;
+class ScreenCapture;
 
 class DefaultDisplayBufferCompositor : public DisplayBufferCompositor
 {
@@ -44,7 +46,8 @@ public:
     DefaultDisplayBufferCompositor(
         graphics::DisplayBuffer& display_buffer,
         std::shared_ptr<renderer::Renderer> const& renderer,
-        std::shared_ptr<CompositorReport> const& report);
+        std::shared_ptr<CompositorReport> const& report,
+        std::shared_ptr<ScreenCapture> const& screen_capture = nullptr);
 
     void composite(SceneElementSequence&& scene_sequence) override;
 
@@ -52,6 +55,8 @@ private:
     graphics::DisplayBuffer& display_buffer;
     std::shared_ptr<renderer::Renderer> const renderer;
     std::shared_ptr<CompositorReport> const report;
+    std::shared_ptr<ScreenCapture> const screen_capture;
+    DamageTracker damage_tracker;
 };
 
 }
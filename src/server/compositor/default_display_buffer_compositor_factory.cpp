@@ -28,9 +28,11 @@ namespace mg = mir::graphics;
 
 mc::DefaultDisplayBufferCompositorFactory::DefaultDisplayBufferCompositorFactory(
     std::shared_ptr<mir::renderer::RendererFactory> const& renderer_factory,
-    std::shared_ptr<mc::CompositorReport> const& report) :
+    std::shared_ptr<mc::CompositorReport> const& report,
+    std::shared_ptr<ScreenCapture> const& screen_capture) :
     renderer_factory{renderer_factory},
-    report{report}
+    report{report},
+    screen_capture{screen_capture}
 {
 }
 
@@ -40,5 +42,5 @@ mc::DefaultDisplayBufferCompositorFactory::create_compositor_for(
 {
     auto renderer = renderer_factory->create_renderer_for(display_buffer);
     return std::make_unique<DefaultDisplayBufferCompositor>(
-         display_buffer, std::move(renderer), report);
+         display_buffer, std::move(renderer), report, screen_capture);
 }
@@ -0,0 +1,286 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_latency_tracker.h"
+#include "../report/metrics/registry.h"
+
+#include "mir/compositor/buffer_stream.h"
+#include "mir/scene/null_surface_observer.h"
+#include "mir/scene/session.h"
+#include "mir/scene/surface.h"
+#include "mir/time/clock.h"
+
+namespace mc = mir::compositor;
+namespace ms = mir::scene;
+namespace mrm = mir::report::metrics;
+using mir::time::Timestamp;
+
+namespace
+{
+class SurfaceObserver : public ms::NullSurfaceObserver
+{
+public:
+    SurfaceObserver(mc::InputLatencyTracker& tracker)
+        : tracker{tracker}
+    {
+    }
+
+    void input_consumed(ms::Surface const* surface, MirEvent const* event) override
+    {
+        tracker.input_delivered(surface, *event);
+    }
+
+    void frame_posted(ms::Surface const* surface, int, mir::geometry::Size const&) override
+    {
+        tracker.frame_submitted(surface);
+    }
+
+private:
+    mc::InputLatencyTracker& tracker;
+};
+
+auto client_name(ms::Surface const& surface) -> std::string
+{
+    if (auto const session = surface.session().lock())
+        return session->name();
+
+    return surface.name();
+}
+}
+
+struct mc::InputLatencyTracker::Client
+{
+    Client(mrm::Registry& registry, std::string const& name)
+        : dispatch{registry.histogram(
+              "mir_input_dispatch_seconds",
+              "Time from an input event being read until it is sent to a surface",
+              {{"client", name}})},
+          response{registry.histogram(
+              "mir_input_response_seconds",
+              "Time from an input event being sent to a surface until the client submits a frame",
+              {{"client", name}})},
+          present{registry.histogram(
+              "mir_input_present_seconds",
+              "Time from a client submitting a frame in response to input until it is posted",
+              {{"client", name}})},
+          total{registry.histogram(
+              "mir_input_to_present_seconds",
+              "Time from an input event being read until a frame responding to it is posted",
+              {{"client", name}})}
+    {
+    }
+
+    mrm::Histogram& dispatch;
+    mrm::Histogram& response;
+    mrm::Histogram& present;
+    mrm::Histogram& total;
+};
+
+struct mc::InputLatencyTracker::TrackedSurface
+{
+    TrackedSurface(
+        mrm::Registry& registry,
+        std::shared_ptr<ms::Surface> const& surface,
+        std::shared_ptr<ms::SurfaceObserver> const& observer)
+        : client{registry, client_name(*surface)},
+          surface{surface},
+          observer{observer}
+    {
+    }
+
+    Client client;
+    std::weak_ptr<ms::Surface> const surface;
+    std::shared_ptr<ms::SurfaceObserver> const observer;
+    graphics::Renderable::ID stream{nullptr};
+
+    // The earliest input the client has not answered
+    Timestamp acquired;
+    Timestamp delivered;
+
+    // Input answered by a frame that has not yet been posted
+    Timestamp answered;
+    Timestamp submitted;
+};
+
+mc::InputLatencyTracker::InputLatencyTracker(
+    std::shared_ptr<mrm::Registry> const& registry,
+    std::shared_ptr<time::Clock> const& clock)
+    : registry{registry},
+      clock{clock}
+{
+}
+
+mc::InputLatencyTracker::~InputLatencyTracker()
+{
+    end_observation();
+}
+
+void mc::InputLatencyTracker::track(std::shared_ptr<ms::Surface> const& surface)
+{
+    auto const observer = std::make_shared<SurfaceObserver>(*this);
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto tracked = std::make_unique<TrackedSurface>(*registry, surface, observer);
+
+        // Renderables are identified by the stream they show
+        if (auto const stream = std::dynamic_pointer_cast<BufferStream>(surface->primary_buffer_stream()))
+        {
+            tracked->stream = stream.get();
+            streams[tracked->stream] = tracked.get();
+        }
+
+        surfaces[surface.get()] = std::move(tracked);
+    }
+
+    surface->add_observer(observer);
+}
+
+void mc::InputLatencyTracker::surface_added(std::shared_ptr<ms::Surface> const& surface)
+{
+    track(surface);
+}
+
+void mc::InputLatencyTracker::surface_exists(std::shared_ptr<ms::Surface> const& surface)
+{
+    track(surface);
+}
+
+void mc::InputLatencyTracker::surface_removed(std::shared_ptr<ms::Surface> const& surface)
+{
+    std::unique_ptr<TrackedSurface> removed;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const i = surfaces.find(surface.get());
+        if (i == surfaces.end())
+            return;
+
+        removed = std::move(i->second);
+        surfaces.erase(i);
+        streams.erase(removed->stream);
+    }
+
+    surface->remove_observer(removed->observer);
+}
+
+void mc::InputLatencyTracker::surfaces_reordered(ms::SurfaceSet const&)
+{
+}
+
+void mc::InputLatencyTracker::scene_changed()
+{
+}
+
+void mc::InputLatencyTracker::end_observation()
+{
+    decltype(surfaces) removed;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        removed.swap(surfaces);
+        streams.clear();
+    }
+
+    for (auto const& entry : removed)
+    {
+        if (auto const surface = entry.second->surface.lock())
+            surface->remove_observer(entry.second->observer);
+    }
+}
+
+void mc::InputLatencyTracker::input_delivered(ms::Surface const* surface, MirEvent const& event)
+{
+    if (mir_event_get_type(&event) != mir_event_type_input)
+        return;
+
+    auto const now = clock->now();
+    auto const acquired = Timestamp{} + std::chrono::duration_cast<time::Duration>(
+        std::chrono::nanoseconds{mir_input_event_get_event_time(mir_event_get_input_event(&event))});
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const i = surfaces.find(surface);
+    if (i == surfaces.end())
+        return;
+
+    auto& tracked = *i->second;
+    tracked.client.dispatch.record(now - acquired);
+
+    if (tracked.acquired == Timestamp{})
+    {
+        tracked.acquired = acquired;
+        tracked.delivered = now;
+    }
+}
+
+void mc::InputLatencyTracker::frame_submitted(ms::Surface const* surface)
+{
+    auto const now = clock->now();
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const i = surfaces.find(surface);
+    if (i == surfaces.end())
+        return;
+
+    auto& tracked = *i->second;
+    if (tracked.acquired == Timestamp{})
+        return;
+
+    tracked.client.response.record(now - tracked.delivered);
+
+    // If an earlier answer is still waiting to be posted it is measured from
+    // its own input; this frame will be posted no earlier than that one.
+    if (tracked.answered == Timestamp{})
+    {
+        tracked.answered = tracked.acquired;
+        tracked.submitted = now;
+    }
+
+    tracked.acquired = Timestamp{};
+}
+
+auto mc::InputLatencyTracker::frame_began() const -> time::Timestamp
+{
+    return clock->now();
+}
+
+void mc::InputLatencyTracker::frame_posted(
+    time::Timestamp began,
+    std::vector<graphics::Renderable::ID> const& renderables)
+{
+    auto const now = clock->now();
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (auto const id : renderables)
+    {
+        auto const i = streams.find(id);
+        if (i == streams.end())
+            continue;
+
+        auto& tracked = *i->second;
+
+        // The frame may have been composited from an earlier buffer
+        if (tracked.answered == Timestamp{} || tracked.submitted > began)
+            continue;
+
+        tracked.client.present.record(now - tracked.submitted);
+        tracked.client.total.record(now - tracked.answered);
+        tracked.answered = Timestamp{};
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_INPUT_LATENCY_TRACKER_H_
+#define MIR_COMPOSITOR_INPUT_LATENCY_TRACKER_H_
+
+#include "mir/scene/observer.h"
+#include "mir/graphics/renderable.h"
+#include "mir/time/types.h"
+#include "mir_toolkit/event.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace report
+{
+namespace metrics
+{
+class Registry;
+}
+}
+namespace scene
+{
+class SurfaceObserver;
+}
+namespace time
+{
+class Clock;
+}
+namespace compositor
+{
+/**
+ * \brief Follows input events through to the frames that answer them
+ *
+ * For each surface the tracker remembers the earliest input event it has been
+ * sent that the client has not yet answered. The client's next frame answers
+ * it, and once a compositor has posted that frame the latency of each stage
+ * is published, per client, to the metrics registry:
+ *  - mir_input_dispatch_seconds: from acquisition by the input platform to
+ *    delivery to the surface
+ *  - mir_input_response_seconds: from delivery to the client submitting a frame
+ *  - mir_input_present_seconds: from the frame being submitted to it being posted
+ *  - mir_input_to_present_seconds: the whole pipeline
+ *
+ * A client that submits frames regardless of input (e.g. an animation) is
+ * credited with answering input sooner than it may have done.
+ */
+class InputLatencyTracker : public scene::Observer
+{
+public:
+    InputLatencyTracker(
+        std::shared_ptr<report::metrics::Registry> const& registry,
+        std::shared_ptr<time::Clock> const& clock);
+    ~InputLatencyTracker();
+
+    void surface_added(std::shared_ptr<scene::Surface> const& surface) override;
+    void surface_removed(std::shared_ptr<scene::Surface> const& surface) override;
+    void surfaces_reordered(scene::SurfaceSet const& affected_surfaces) override;
+    void scene_changed() override;
+    void surface_exists(std::shared_ptr<scene::Surface> const& surface) override;
+    void end_observation() override;
+
+    void input_delivered(scene::Surface const* surface, MirEvent const& event);
+    void frame_submitted(scene::Surface const* surface);
+
+    /// Notes the start of compositing a frame, to pass to frame_posted()
+    auto frame_began() const -> time::Timestamp;
+    /// A frame begun at began, that rendered the renderables, has been posted
+    void frame_posted(time::Timestamp began, std::vector<graphics::Renderable::ID> const& renderables);
+
+private:
+    struct Client;
+    struct TrackedSurface;
+
+    void track(std::shared_ptr<scene::Surface> const& surface);
+
+    std::shared_ptr<report::metrics::Registry> const registry;
+    std::shared_ptr<time::Clock> const clock;
+
+    std::mutex mutex;
+    std::unordered_map<scene::Surface const*, std::unique_ptr<TrackedSurface>> surfaces;
+    std::unordered_map<graphics::Renderable::ID, TrackedSurface*> streams;
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_INPUT_LATENCY_TRACKER_H_
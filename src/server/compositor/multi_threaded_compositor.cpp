@@ -17,12 +17,14 @@
  */
 
 #include "multi_threaded_compositor.h"
+#include "input_latency_tracker.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_buffer.h"
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
 #include "mir/compositor/display_listener.h"
 #include "mir/compositor/scene.h"
+#include "mir/compositor/scene_element.h"
 #include "mir/compositor/compositor_report.h"
 #include "mir/scene/legacy_scene_change_notification.h"
 #include "mir/scene/surface_observer.h"
@@ -31,6 +33,7 @@
 #include "mir/raii.h"
 #include "mir/unwind_helpers.h"
 #include "mir/thread_name.h"
+#include "mir/trace/recorder.h"
 
 #include <thread>
 #include <chrono>
@@ -48,6 +51,39 @@ namespace mir
 namespace compositor
 {
 
+/// Notes which renderables a display buffer compositor actually rendered
+class LatencyTrackingElement : public SceneElement
+{
+public:
+    LatencyTrackingElement(
+        std::shared_ptr<SceneElement> const& wrapped,
+        std::vector<mg::Renderable::ID>& rendered_ids) :
+        wrapped{wrapped},
+        rendered_ids(rendered_ids)
+    {
+    }
+
+    std::shared_ptr<mg::Renderable> renderable() const override
+    {
+        return wrapped->renderable();
+    }
+
+    void rendered() override
+    {
+        wrapped->rendered();
+        rendered_ids.push_back(wrapped->renderable()->id());
+    }
+
+    void occluded() override
+    {
+        wrapped->occluded();
+    }
+
+private:
+    std::shared_ptr<SceneElement> const wrapped;
+    std::vector<mg::Renderable::ID>& rendered_ids;
+};
+
 class CompositingFunctor
 {
 public:
@@ -57,7 +93,8 @@ public:
         std::shared_ptr<mc::Scene> const& scene,
         std::shared_ptr<DisplayListener> const& display_listener,
         std::chrono::milliseconds fixed_composite_delay,
-        std::shared_ptr<CompositorReport> const& report) :
+        std::shared_ptr<CompositorReport> const& report,
+        std::shared_ptr<InputLatencyTracker> const& input_latency) :
         compositor_factory{db_compositor_factory},
         group(group),
         scene(scene),
@@ -66,6 +103,7 @@ public:
         force_sleep{fixed_composite_delay},
         display_listener{display_listener},
         report{report},
+        input_latency{input_latency},
         started_future{started.get_future()}
     {
     }
@@ -135,12 +173,36 @@ public:
                     not_posted_yet = false;
                     lock.unlock();
 
-                    for (auto& tuple : compositors)
+                    time::Timestamp frame_began;
+                    if (input_latency)
+                        frame_began = input_latency->frame_began();
+
+                    {
+                        MIR_TRACE_SCOPE("compositor", "composite");
+                        for (auto& tuple : compositors)
+                        {
+                            auto& compositor = std::get<1>(tuple);
+                            auto elements = scene->scene_elements_for(compositor.get());
+
+                            if (input_latency)
+                            {
+                                for (auto& element : elements)
+                                    element = std::make_shared<LatencyTrackingElement>(element, rendered_ids);
+                            }
+
+                            compositor->composite(std::move(elements));
+                        }
+                    }
+                    {
+                        MIR_TRACE_SCOPE("compositor", "post");
+                        group.post();
+                    }
+
+                    if (input_latency)
                     {
-                        auto& compositor = std::get<1>(tuple);
-                        compositor->composite(scene->scene_elements_for(compositor.get()));
+                        input_latency->frame_posted(frame_began, rendered_ids);
+                        rendered_ids.clear();
                     }
-                    group.post();
 
                     /*
                      * "Predictive bypass" optimization: If the last frame was
@@ -241,6 +303,8 @@ private:
     std::condition_variable run_cv;
     std::shared_ptr<DisplayListener> const display_listener;
     std::shared_ptr<CompositorReport> const report;
+    std::shared_ptr<InputLatencyTracker> const input_latency;
+    std::vector<mg::Renderable::ID> rendered_ids;
     std::promise<void> started;
     std::future<void> started_future;
     bool not_posted_yet = true;
@@ -256,12 +320,14 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
     std::shared_ptr<DisplayListener> const& display_listener,
     std::shared_ptr<CompositorReport> const& compositor_report,
     std::chrono::milliseconds fixed_composite_delay,
-    bool compose_on_start)
+    bool compose_on_start,
+    std::shared_ptr<InputLatencyTracker> const& input_latency)
     : display{display},
       scene{scene},
       display_buffer_compositor_factory{db_compositor_factory},
       display_listener{display_listener},
       report{compositor_report},
+      input_latency{input_latency},
       state{CompositorState::stopped},
       fixed_composite_delay{fixed_composite_delay},
       compose_on_start{compose_on_start},
@@ -321,6 +387,8 @@ void mc::MultiThreadedCompositor::start()
 
     /* Add the observer after we have created the compositing threads */
     scene->add_observer(observer);
+    if (input_latency)
+        scene->add_observer(input_latency);
 
     /* Optional first render */
     if (compose_on_start)
@@ -349,6 +417,8 @@ void mc::MultiThreadedCompositor::stop()
 
     /* Remove the observer before destroying the compositing threads */
     scene->remove_observer(observer);
+    if (input_latency)
+        scene->remove_observer(input_latency);
 
     destroy_compositing_threads();
 
@@ -368,7 +438,7 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
     {
         auto thread_functor = std::make_unique<mc::CompositingFunctor>(
             display_buffer_compositor_factory, group, scene, display_listener,
-            fixed_composite_delay, report);
+            fixed_composite_delay, report, input_latency);
 
         futures.push_back(thread_pool.run(std::ref(*thread_functor), &group));
         thread_functors.push_back(std::move(thread_functor));
@@ -49,6 +49,7 @@ class DisplayListener;
 class CompositingFunctor;
 class Scene;
 class CompositorReport;
+class InputLatencyTracker;
 
 enum class CompositorState
 {
@@ -68,7 +69,8 @@ public:
         std::shared_ptr<DisplayListener> const& display_listener,
         std::shared_ptr<CompositorReport> const& compositor_report,
         std::chrono::milliseconds fixed_composite_delay,  // -1 = automatic
-        bool compose_on_start);
+        bool compose_on_start,
+        std::shared_ptr<InputLatencyTracker> const& input_latency = nullptr);
     ~MultiThreadedCompositor();
 
     void start();
@@ -83,6 +85,7 @@ private:
     std::shared_ptr<DisplayBufferCompositorFactory> const display_buffer_compositor_factory;
     std::shared_ptr<DisplayListener> const display_listener;
     std::shared_ptr<CompositorReport> const report;
+    std::shared_ptr<InputLatencyTracker> const input_latency;
 
     std::vector<std::unique_ptr<CompositingFunctor>> thread_functors;
     std::vector<std::future<void>> futures;
@@ -0,0 +1,402 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/screen_capture.h"
+#include "mir/graphics/pixel_conversion.h"
+#include "mir/renderer/renderer.h"
+#include "mir/compositor/damage_tracker.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+bool mc::copy_captured_pixels(
+    geom::Size const& size,
+    unsigned char const* pixels,
+    geom::Stride stride,
+    unsigned char* dest,
+    int dest_stride,
+    MirPixelFormat format)
+{
+    switch (format)
+    {
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+        return mg::convert_pixels(
+            size, mir_pixel_format_abgr_8888, pixels, stride.as_int(), format, dest, dest_stride);
+
+    default:
+        return false;
+    }
+}
+
+namespace
+{
+using OutputDamage = std::vector<std::pair<geom::Rectangle, geom::Rectangles>>;
+
+/// The damage known on the output showing \a view_area, or nullptr if it is unknown
+auto damage_on(OutputDamage& damage, geom::Rectangle const& view_area) -> geom::Rectangles*
+{
+    auto const output = std::find_if(
+        damage.begin(), damage.end(),
+        [&view_area](OutputDamage::value_type const& output) { return output.first == view_area; });
+
+    return output != damage.end() ? &output->second : nullptr;
+}
+}
+
+struct mc::ScreenCapture::Session::Capture
+{
+    Capture(BufferKey key, std::shared_ptr<CaptureTarget> const& target, bool wait_for_damage) :
+        key{key},
+        target{target},
+        waiting{wait_for_damage}
+    {
+    }
+
+    BufferKey const key;
+    std::shared_ptr<CaptureTarget> const target;
+
+    /// Read nothing until some output has damage
+    bool waiting;
+    /// The view areas of the outputs yet to be read from
+    std::vector<geom::Rectangle> outputs;
+    /// Readbacks yet to finish
+    int reading{0};
+    /// What has been written (relative to the area)
+    geom::Rectangles damage;
+    bool failed{false};
+    bool done{false};
+
+    /// Serialises the writes of the compositors of different outputs
+    std::mutex writing;
+};
+
+class mc::ScreenCapture::Session::Readback : public mir::renderer::Readback
+{
+public:
+    Readback(
+        std::shared_ptr<Session> const& session,
+        std::shared_ptr<Capture> const& capture,
+        geom::Rectangles const& regions) :
+        session{session},
+        capture{capture},
+        regions_{regions}
+    {
+    }
+
+    auto regions() const -> geom::Rectangles override
+    {
+        return regions_;
+    }
+
+    void deliver(geom::Rectangle const& region, unsigned char const* pixels, geom::Stride stride) override
+    {
+        std::lock_guard<std::mutex> lock{capture->writing};
+        capture->target->write(relative(region), pixels, stride);
+    }
+
+    void finished(bool complete) override
+    {
+        {
+            std::lock_guard<std::mutex> lock{session->mutex};
+            --session->readbacks_in_flight;
+            --capture->reading;
+
+            if (complete)
+            {
+                for (auto const& region : regions_)
+                    capture->damage.add(relative(region));
+            }
+            else
+            {
+                // We no longer know what the buffer holds
+                capture->failed = true;
+                session->damage_since_capture.erase(capture->key);
+            }
+        }
+
+        session->complete_if_done(capture);
+    }
+
+private:
+    auto relative(geom::Rectangle const& region) const -> geom::Rectangle
+    {
+        return {geom::Point{} + (region.top_left - session->area_.top_left), region.size};
+    }
+
+    std::shared_ptr<Session> const session;
+    std::shared_ptr<Capture> const capture;
+    geom::Rectangles const regions_;
+};
+
+mc::ScreenCapture::Session::Session(
+    geom::Rectangle const& area,
+    std::function<void()> const& schedule_frame,
+    std::function<std::vector<geom::Rectangle>()> const& outputs) :
+    area_{area},
+    schedule_frame{schedule_frame},
+    outputs{outputs}
+{
+}
+
+auto mc::ScreenCapture::Session::area() const -> geom::Rectangle
+{
+    return area_;
+}
+
+void mc::ScreenCapture::Session::capture(
+    BufferKey key,
+    std::shared_ptr<CaptureTarget> const& target,
+    bool wait_for_damage)
+{
+    auto const capture = std::make_shared<Capture>(key, target, wait_for_damage);
+
+    for (auto const& output : outputs())
+    {
+        // Clones show the same view area, and one of them is enough
+        if (output.overlaps(area_) &&
+            std::find(capture->outputs.begin(), capture->outputs.end(), output) == capture->outputs.end())
+        {
+            capture->outputs.push_back(output);
+        }
+    }
+
+    if (capture->outputs.empty())
+    {
+        target->failed();
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+
+        auto const known = damage_since_capture.find(key);
+        bool const unchanged = known != damage_since_capture.end() && std::all_of(
+            capture->outputs.begin(), capture->outputs.end(),
+            [&known](geom::Rectangle const& output)
+            {
+                auto const damage = damage_on(known->second, output);
+                return damage && damage->size() == 0;
+            });
+
+        if (unchanged && !wait_for_damage)
+        {
+            lock.unlock();
+            target->captured({});
+            return;
+        }
+
+        pending.push_back(capture);
+
+        if (unchanged)
+            return;
+    }
+
+    schedule_frame();
+}
+
+void mc::ScreenCapture::Session::forget(BufferKey key)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    damage_since_capture.erase(key);
+    pending.erase(
+        std::remove_if(pending.begin(), pending.end(),
+            [key](std::shared_ptr<Capture> const& capture) { return capture->key == key; }),
+        pending.end());
+}
+
+auto mc::ScreenCapture::Session::frame(geom::Rectangle const& view_area, geom::Rectangles const& damage)
+    -> std::vector<std::shared_ptr<renderer::Readback>>
+{
+    if (!view_area.overlaps(area_))
+        return {};
+
+    std::vector<std::shared_ptr<renderer::Readback>> readbacks;
+    std::vector<std::shared_ptr<Capture>> all_read;
+    bool need_frame{false};
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const readable = area_.intersection_with(view_area);
+
+        geom::Rectangles frame_damage;
+        for (auto const& rect : damage)
+            add_damage(frame_damage, rect.intersection_with(readable));
+
+        for (auto& known : damage_since_capture)
+        {
+            if (auto const output_damage = damage_on(known.second, view_area))
+            {
+                for (auto const& rect : frame_damage)
+                    add_damage(*output_damage, rect);
+            }
+        }
+
+        std::vector<std::shared_ptr<Capture>> still_pending;
+        for (auto const& capture : pending)
+        {
+            auto const output = std::find(capture->outputs.begin(), capture->outputs.end(), view_area);
+            if (output == capture->outputs.end())
+            {
+                still_pending.push_back(capture);
+                continue;
+            }
+
+            auto& known = damage_since_capture[capture->key];
+            auto output_damage = damage_on(known, view_area);
+            auto const regions = output_damage ? *output_damage : geom::Rectangles{readable};
+
+            if (capture->waiting)
+            {
+                if (regions.size() == 0)
+                {
+                    still_pending.push_back(capture);
+                    continue;
+                }
+
+                // The other outputs may have nothing new to composite
+                capture->waiting = false;
+                need_frame = true;
+            }
+
+            if (output_damage)
+                output_damage->clear();
+            else
+                known.emplace_back(view_area, geom::Rectangles{});
+
+            if (regions.size() != 0)
+            {
+                ++capture->reading;
+                readbacks.push_back(std::make_shared<Readback>(shared_from_this(), capture, regions));
+            }
+
+            capture->outputs.erase(output);
+            if (capture->outputs.empty())
+                all_read.push_back(capture);
+            else
+                still_pending.push_back(capture);
+        }
+        pending = std::move(still_pending);
+
+        // Readbacks from earlier frames may only complete during a later one
+        need_frame = need_frame || readbacks_in_flight > 0;
+        readbacks_in_flight += readbacks.size();
+    }
+
+    for (auto const& capture : all_read)
+        complete_if_done(capture);
+
+    if (need_frame)
+        schedule_frame();
+
+    return readbacks;
+}
+
+void mc::ScreenCapture::Session::complete_if_done(std::shared_ptr<Capture> const& capture)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (capture->done || !capture->outputs.empty() || capture->reading > 0)
+            return;
+
+        capture->done = true;
+    }
+
+    if (capture->failed)
+        capture->target->failed();
+    else
+        capture->target->captured(capture->damage);
+}
+
+bool mc::ScreenCapture::Session::reading_back() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return readbacks_in_flight > 0;
+}
+
+mc::ScreenCapture::ScreenCapture(
+    std::function<void()> const& schedule_frame,
+    std::function<std::vector<geom::Rectangle>()> const& outputs) :
+    schedule_frame{schedule_frame},
+    outputs{outputs}
+{
+}
+
+auto mc::ScreenCapture::open_session(geom::Rectangle const& area) -> std::shared_ptr<Session>
+{
+    auto const session = std::make_shared<Session>(area, schedule_frame, outputs);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    sessions.push_back(session);
+    return session;
+}
+
+bool mc::ScreenCapture::active() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    return std::any_of(
+        sessions.begin(), sessions.end(),
+        [](std::weak_ptr<Session> const& session) { return !session.expired(); });
+}
+
+auto mc::ScreenCapture::frame(geom::Rectangle const& view_area, geom::Rectangles const& damage)
+    -> std::vector<std::shared_ptr<renderer::Readback>>
+{
+    std::vector<std::shared_ptr<Session>> live;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        sessions.erase(
+            std::remove_if(sessions.begin(), sessions.end(),
+                [&live](std::weak_ptr<Session> const& weak)
+                {
+                    auto const session = weak.lock();
+                    if (session)
+                        live.push_back(session);
+                    return !session;
+                }),
+            sessions.end());
+    }
+
+    std::vector<std::shared_ptr<renderer::Readback>> readbacks;
+    for (auto const& session : live)
+    {
+        auto const session_readbacks = session->frame(view_area, damage);
+        readbacks.insert(readbacks.end(), session_readbacks.begin(), session_readbacks.end());
+    }
+    return readbacks;
+}
+
+bool mc::ScreenCapture::reading_back() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    return std::any_of(
+        sessions.begin(), sessions.end(),
+        [](std::weak_ptr<Session> const& weak)
+        {
+            auto const session = weak.lock();
+            return session && session->reading_back();
+        });
+}
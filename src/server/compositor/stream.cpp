@@ -23,12 +23,23 @@
 #include "mir/graphics/buffer.h"
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+#include <atomic>
+
 namespace mc = mir::compositor;
 namespace geom = mir::geometry;
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
 
+namespace
+{
+std::atomic<uint64_t> next_submission{1};
+
+// More than the buffers a client keeps in flight, so those still queued keep theirs
+std::size_t const max_recent_submissions{8};
+}
+
 enum class mc::Stream::ScheduleMode {
     Queueing,
     Dropping
@@ -58,6 +69,17 @@ void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
         first_frame_posted = true;
         pf = buffer->pixel_format();
         latest_buffer_size = buffer->size();
+
+        // Clients may submit the same buffer again, drawn afresh
+        auto const id = buffer->id();
+        recent_submissions.erase(
+            std::remove_if(recent_submissions.begin(), recent_submissions.end(),
+                [id](auto const& submission) { return submission.first == id; }),
+            recent_submissions.end());
+        recent_submissions.emplace_front(id, next_submission++);
+        if (recent_submissions.size() > max_recent_submissions)
+            recent_submissions.pop_back();
+
         schedule->schedule(buffer);
     }
     {
@@ -72,6 +94,29 @@ void mc::Stream::with_most_recent_buffer_do(std::function<void(mg::Buffer&)> con
     fn(*arbiter->snapshot_acquire());
 }
 
+void mc::Stream::with_most_recent_submission_do(std::function<void(mg::Buffer&, uint64_t)> const& fn)
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    auto const buffer = arbiter->snapshot_acquire();
+
+    // A buffer can't be submitted again while it's shown, so its latest submission is the one shown
+    fn(*buffer, latest_submission_of(buffer->id()));
+}
+
+auto mc::Stream::submission_of(mg::BufferID id) const -> uint64_t
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    return latest_submission_of(id);
+}
+
+auto mc::Stream::latest_submission_of(mg::BufferID id) const -> uint64_t
+{
+    auto const submission = std::find_if(recent_submissions.begin(), recent_submissions.end(),
+        [id](auto const& submission) { return submission.first == id; });
+
+    return submission != recent_submissions.end() ? submission->second : 0;
+}
+
 MirPixelFormat mc::Stream::pixel_format() const
 {
     std::lock_guard<decltype(mutex)> lk(mutex);
@@ -26,6 +26,7 @@
 #include "mir/lockable_callback.h"
 #include "mir/geometry/size.h"
 #include "multi_monitor_arbiter.h"
+#include <deque>
 #include <mutex>
 #include <memory>
 #include <set>
@@ -44,6 +45,9 @@ public:
 
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) override;
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec) override;
+    void with_most_recent_submission_do(
+        std::function<void(graphics::Buffer&, uint64_t submission)> const& exec) override;
+    auto submission_of(graphics::BufferID id) const -> uint64_t override;
     MirPixelFormat pixel_format() const override;
     void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) override;
@@ -60,6 +64,8 @@ public:
 private:
     enum class ScheduleMode;
     void transition_schedule(std::shared_ptr<Schedule>&& new_schedule, std::lock_guard<std::mutex> const&);
+    /// Call with the mutex held
+    auto latest_submission_of(graphics::BufferID id) const -> uint64_t;
 
     std::mutex mutable mutex;
     ScheduleMode schedule_mode;
@@ -69,6 +75,8 @@ private:
     float scale_{1.0f};
     MirPixelFormat pf;
     bool first_frame_posted;
+    /// The serials of the latest submissions, newest first
+    std::deque<std::pair<graphics::BufferID, uint64_t>> recent_submissions;
 
     std::mutex callback_mutex;
     std::function<void(geometry::Size const&)> frame_callback;
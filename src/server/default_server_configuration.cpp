@@ -28,6 +28,7 @@
 #include "mir/frontend/wayland.h"
 
 #include "mir/logging/dumb_console_logger.h"
+#include "mir/logging/async_logger.h"
 #include "mir/options/program_option.h"
 #include "mir/frontend/session_credentials.h"
 #include "mir/frontend/session_authorizer.h"
@@ -38,6 +39,7 @@
 #include "mir/input/vt_filter.h"
 #include "mir/input/input_manager.h"
 #include "mir/time/steady_clock.h"
+#include "mir/time/virtual_clock.h"
 #include "mir/geometry/rectangles.h"
 #include "mir/default_configuration.h"
 #include "mir/scene/null_prompt_session_listener.h"
@@ -158,8 +160,11 @@ mir::DefaultServerConfiguration::the_session_authorizer()
 std::shared_ptr<mir::time::Clock> mir::DefaultServerConfiguration::the_clock()
 {
     return clock(
-        []()
+        [this]() -> std::shared_ptr<mir::time::Clock>
         {
+            if (the_options()->is_set(options::virtual_time_opt))
+                return std::make_shared<mir::time::VirtualClock>();
+
             return std::make_shared<mir::time::SteadyClock>();
         });
 }
@@ -169,7 +174,26 @@ std::shared_ptr<mir::MainLoop> mir::DefaultServerConfiguration::the_main_loop()
     return main_loop(
         [this]() -> std::shared_ptr<mir::MainLoop>
         {
-            return std::make_shared<mir::GLibMainLoop>(the_clock());
+            auto const clock = the_clock();
+            auto const main_loop = std::make_shared<mir::GLibMainLoop>(clock);
+
+            // Alarms fall due when virtual time is stepped, not as real time passes
+            if (auto const virtual_clock = std::dynamic_pointer_cast<mir::time::VirtualClock>(clock))
+            {
+                std::weak_ptr<mir::GLibMainLoop> const weak_main_loop{main_loop};
+                virtual_clock->register_time_change_callback(
+                    [weak_main_loop](mir::time::Timestamp)
+                    {
+                        auto const main_loop = weak_main_loop.lock();
+                        if (!main_loop)
+                            return false;
+
+                        main_loop->enqueue(main_loop.get(), []{});
+                        return true;
+                    });
+            }
+
+            return main_loop;
         });
 }
 
@@ -226,8 +250,11 @@ auto mir::DefaultServerConfiguration::the_logger()
     -> std::shared_ptr<ml::Logger>
 {
     return logger(
-        []() -> std::shared_ptr<ml::Logger>
+        [this]() -> std::shared_ptr<ml::Logger>
         {
+            if (the_options()->is_set(options::async_logging_opt))
+                return std::make_shared<ml::AsyncLogger>();
+
             return std::make_shared<ml::DumbConsoleLogger>();
         });
 }
@@ -0,0 +1,279 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "composited_screencast.h"
+
+#include "mir/compositor/screen_capture.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/renderer/sw/pixel_source.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+// A capture needs the compositor to render a frame; if it hasn't in this
+// long, it isn't going to.
+std::chrono::seconds const capture_timeout{2};
+
+bool is_capturable(MirPixelFormat format)
+{
+    switch (format)
+    {
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Writes captured regions into a software buffer.
+ *
+ * Buffers we can only write whole (PixelSource) are patched in a shadow copy
+ * of their content, which is written back once the capture is complete.
+ */
+class BufferTarget : public mc::CaptureTarget
+{
+public:
+    BufferTarget(std::shared_ptr<mg::Buffer> const& buffer, bool flip) :
+        buffer{buffer},
+        flip{flip}
+    {
+    }
+
+    static bool can_write(mg::Buffer& buffer)
+    {
+        auto const native = buffer.native_buffer_base();
+        return dynamic_cast<mrs::RWMappableBuffer*>(native) || dynamic_cast<mrs::PixelSource*>(native);
+    }
+
+    void write(geom::Rectangle const& region, unsigned char const* pixels, geom::Stride stride) override
+    {
+        if (!base)
+            open();
+
+        auto const dest_row = flip ?
+            buffer->size().height.as_int() - 1 - region.top_left.y.as_int() :
+            region.top_left.y.as_int();
+
+        mc::copy_captured_pixels(
+            region.size,
+            pixels,
+            stride,
+            base + dest_row * dest_stride + region.top_left.x.as_int() * 4,
+            flip ? -dest_stride : dest_stride,
+            buffer->pixel_format());
+    }
+
+    void captured(geom::Rectangles const&) override
+    {
+        close();
+        done.set_value();
+    }
+
+    void failed() override
+    {
+        mapping.reset();
+        shadow.clear();
+        done.set_exception(std::make_exception_ptr(std::runtime_error{"Failed to capture screencast frame"}));
+    }
+
+    auto result() -> std::future<void>
+    {
+        return done.get_future();
+    }
+
+private:
+    void open()
+    {
+        auto const native = buffer->native_buffer_base();
+
+        if (auto const mappable = dynamic_cast<mrs::RWMappableBuffer*>(native))
+        {
+            mapping = mappable->map_rw();
+            base = mapping->data();
+            dest_stride = mapping->stride().as_int();
+        }
+        else if (auto const pixel_source = dynamic_cast<mrs::PixelSource*>(native))
+        {
+            dest_stride = pixel_source->stride().as_int();
+            shadow.resize(dest_stride * buffer->size().height.as_int());
+            pixel_source->read([this](unsigned char const* pixels)
+                { std::memcpy(shadow.data(), pixels, shadow.size()); });
+            base = shadow.data();
+        }
+    }
+
+    void close()
+    {
+        if (!mapping && !shadow.empty())
+        {
+            dynamic_cast<mrs::PixelSource*>(buffer->native_buffer_base())->write(shadow.data(), shadow.size());
+            shadow.clear();
+        }
+        mapping.reset();
+    }
+
+    std::shared_ptr<mg::Buffer> const buffer;
+    bool const flip;
+
+    std::unique_ptr<mrs::Mapping<unsigned char>> mapping;
+    std::vector<unsigned char> shadow;
+    unsigned char* base{nullptr};
+    int dest_stride{0};
+
+    std::promise<void> done;
+};
+}
+
+struct mf::CompositedScreencast::Session
+{
+    Session(
+        std::shared_ptr<mc::ScreenCapture::Session> const& capture,
+        bool flip,
+        std::vector<std::shared_ptr<mg::Buffer>> buffers) :
+        capture{capture},
+        flip{flip},
+        buffers{std::move(buffers)}
+    {
+    }
+
+    std::shared_ptr<mc::ScreenCapture::Session> const capture;
+    bool const flip;
+    std::vector<std::shared_ptr<mg::Buffer>> const buffers;
+
+    std::mutex mutex;
+    std::size_t next_buffer{0};
+};
+
+mf::CompositedScreencast::CompositedScreencast(
+    std::shared_ptr<mc::ScreenCapture> const& screen_capture,
+    std::shared_ptr<mg::GraphicBufferAllocator> const& allocator) :
+    screen_capture{screen_capture},
+    allocator{allocator}
+{
+}
+
+mf::ScreencastSessionId mf::CompositedScreencast::create_session(
+    geom::Rectangle const& region,
+    geom::Size const& size,
+    MirPixelFormat pixel_format,
+    int nbuffers,
+    MirMirrorMode mirror_mode)
+{
+    if (size != region.size || size.width == geom::Width{} || size.height == geom::Height{})
+        BOOST_THROW_EXCEPTION(std::runtime_error("Screencast size must match its (non-empty) region"));
+
+    if (!is_capturable(pixel_format))
+        BOOST_THROW_EXCEPTION(std::runtime_error("Unsupported screencast pixel format"));
+
+    if (mirror_mode != mir_mirror_mode_none && mirror_mode != mir_mirror_mode_vertical)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Unsupported screencast mirror mode"));
+
+    if (nbuffers < 1)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Screencast needs at least one buffer"));
+
+    std::vector<std::shared_ptr<mg::Buffer>> buffers;
+    for (auto i = 0; i != nbuffers; ++i)
+        buffers.push_back(allocator->alloc_software_buffer(size, pixel_format));
+
+    auto const session = std::make_shared<Session>(
+        screen_capture->open_session(region),
+        mirror_mode == mir_mirror_mode_vertical,
+        std::move(buffers));
+
+    std::lock_guard<std::mutex> lock{mutex};
+    ScreencastSessionId const id{++next_id};
+    sessions[id] = session;
+    return id;
+}
+
+void mf::CompositedScreencast::destroy_session(ScreencastSessionId id)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    if (!sessions.erase(id))
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid screencast session"));
+}
+
+std::shared_ptr<mg::Buffer> mf::CompositedScreencast::capture(ScreencastSessionId id)
+{
+    auto const session = this->session(id);
+
+    std::lock_guard<std::mutex> lock{session->mutex};
+    auto const buffer = session->buffers[session->next_buffer];
+    session->next_buffer = (session->next_buffer + 1) % session->buffers.size();
+
+    capture_into(*session, buffer);
+    return buffer;
+}
+
+void mf::CompositedScreencast::capture(ScreencastSessionId id, std::shared_ptr<mg::Buffer> const& buffer)
+{
+    auto const session = this->session(id);
+
+    if (buffer->size() != session->capture->area().size)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Screencast buffer does not match the screencast size"));
+
+    if (!is_capturable(buffer->pixel_format()) || !BufferTarget::can_write(*buffer))
+        BOOST_THROW_EXCEPTION(std::runtime_error("Cannot capture a screencast into this buffer"));
+
+    std::lock_guard<std::mutex> lock{session->mutex};
+    capture_into(*session, buffer);
+}
+
+auto mf::CompositedScreencast::session(ScreencastSessionId id) -> std::shared_ptr<Session>
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const found = sessions.find(id);
+    if (found == sessions.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid screencast session"));
+
+    return found->second;
+}
+
+void mf::CompositedScreencast::capture_into(Session& session, std::shared_ptr<mg::Buffer> const& buffer)
+{
+    auto const target = std::make_shared<BufferTarget>(buffer, session.flip);
+    auto result = target->result();
+
+    session.capture->capture(buffer->id().as_value(), target, false);
+
+    if (result.wait_for(capture_timeout) != std::future_status::ready)
+    {
+        session.capture->forget(buffer->id().as_value());
+        BOOST_THROW_EXCEPTION(std::runtime_error("Timed out capturing screencast frame"));
+    }
+
+    result.get();
+}
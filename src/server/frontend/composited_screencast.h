@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_COMPOSITED_SCREENCAST_H_
+#define MIR_FRONTEND_COMPOSITED_SCREENCAST_H_
+
+#include "mir/frontend/screencast.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace mir
+{
+namespace compositor { class ScreenCapture; }
+namespace graphics { class GraphicBufferAllocator; }
+namespace frontend
+{
+
+/// Screencasts copied from the composited frames by the compositor
+class CompositedScreencast : public Screencast
+{
+public:
+    CompositedScreencast(
+        std::shared_ptr<compositor::ScreenCapture> const& screen_capture,
+        std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
+
+    ScreencastSessionId create_session(
+        mir::geometry::Rectangle const& region,
+        mir::geometry::Size const& size,
+        MirPixelFormat pixel_format,
+        int nbuffers,
+        MirMirrorMode mirror_mode) override;
+    void destroy_session(ScreencastSessionId id) override;
+    std::shared_ptr<graphics::Buffer> capture(ScreencastSessionId id) override;
+    void capture(ScreencastSessionId id, std::shared_ptr<graphics::Buffer> const& buffer) override;
+
+private:
+    struct Session;
+
+    auto session(ScreencastSessionId id) -> std::shared_ptr<Session>;
+    void capture_into(Session& session, std::shared_ptr<graphics::Buffer> const& buffer);
+
+    std::shared_ptr<compositor::ScreenCapture> const screen_capture;
+    std::shared_ptr<graphics::GraphicBufferAllocator> const allocator;
+
+    std::mutex mutex;
+    uint32_t next_id{0};
+    std::unordered_map<ScreencastSessionId, std::shared_ptr<Session>> sessions;
+};
+
+}
+}
+
+#endif /* MIR_FRONTEND_COMPOSITED_SCREENCAST_H_ */
@@ -20,6 +20,7 @@
 #include "mir/emergency_cleanup.h"
 
 #include "default_ipc_factory.h"
+#include "composited_screencast.h"
 #include "published_socket_connector.h"
 #include "session_mediator_observer_multiplexer.h"
 
@@ -193,6 +194,7 @@ mir::DefaultServerConfiguration::new_ipc_factory(
                 the_session_mediator_observer(),
                 the_frontend_display_changer(),
                 the_buffer_allocator(),
+                std::make_shared<mf::CompositedScreencast>(the_screen_capture(), the_buffer_allocator()),
                 session_authorizer,
                 the_cursor_images(),
                 the_coordinate_translator(),
@@ -226,6 +226,7 @@ mf::DefaultIpcFactory::DefaultIpcFactory(
     std::shared_ptr<SessionMediatorObserver> const& sm_observer,
     std::shared_ptr<DisplayChanger> const& display_changer,
     std::shared_ptr<mg::GraphicBufferAllocator> const& buffer_allocator,
+    std::shared_ptr<Screencast> const& screencast,
     std::shared_ptr<SessionAuthorizer> const& session_authorizer,
     std::shared_ptr<mi::CursorImages> const& cursor_images,
     std::shared_ptr<scene::CoordinateTranslator> const& translator,
@@ -239,6 +240,7 @@ mf::DefaultIpcFactory::DefaultIpcFactory(
     cache(std::make_shared<ResourceCache>()),
     display_changer(display_changer),
     buffer_allocator(buffer_allocator),
+    screencast(screencast),
     session_authorizer(session_authorizer),
     cursor_images(cursor_images),
     translator{translator},
@@ -275,6 +277,11 @@ std::shared_ptr<mf::detail::DisplayServer> mf::DefaultIpcFactory::make_ipc_serve
 
     auto const effective_shell = allow_prompt_session ? shell : no_prompt_shell;
 
+    std::shared_ptr<Screencast> const effective_screencast =
+        session_authorizer->screencast_is_allowed(creds) ?
+            screencast :
+            std::make_shared<UnauthorizedScreencast>();
+
     return make_mediator(
         effective_shell,
         changer,
@@ -282,6 +289,7 @@ std::shared_ptr<mf::detail::DisplayServer> mf::DefaultIpcFactory::make_ipc_serve
         sm_observer,
         sink_factory,
         message_sender,
+        effective_screencast,
         connection_context,
         cursor_images,
         input_config_changer);
@@ -299,6 +307,7 @@ std::shared_ptr<mf::detail::DisplayServer> mf::DefaultIpcFactory::make_mediator(
     std::shared_ptr<SessionMediatorObserver> const& sm_observer,
     std::shared_ptr<mf::EventSinkFactory> const& sink_factory,
     std::shared_ptr<mf::MessageSender> const& message_sender,
+    std::shared_ptr<Screencast> const& effective_screencast,
     ConnectionContext const& connection_context,
     std::shared_ptr<mi::CursorImages> const& cursor_images,
     std::shared_ptr<InputConfigurationChanger> const& input_changer)
@@ -311,6 +320,7 @@ std::shared_ptr<mf::detail::DisplayServer> mf::DefaultIpcFactory::make_mediator(
         sink_factory,
         message_sender,
         resource_cache(),
+        effective_screencast,
         connection_context,
         cursor_images,
         translator,
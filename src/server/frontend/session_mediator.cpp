@@ -28,6 +28,7 @@
 #include "mir/scene/coordinate_translator.h"
 #include "mir/scene/application_not_responding_detector.h"
 #include "mir/scene/session.h"
+#include "mir/scene/memory_account.h"
 #include "mir/frontend/display_changer.h"
 #include "resource_cache.h"
 #include "mir_toolkit/common.h"
@@ -92,6 +93,14 @@ mg::GammaCurve convert_string_to_gamma_curve(std::string const& str_bytes)
     std::copy(std::begin(str_bytes), std::end(str_bytes), reinterpret_cast<char*>(out.data()));
     return out;
 }
+
+/// Screencast buffers are software buffers the client maps by id, as for allocate_buffers()
+void pack_screencast_buffer(mir::protobuf::Buffer& protobuf_buffer, mg::Buffer const& buffer)
+{
+    protobuf_buffer.set_buffer_id(buffer.id().as_value());
+    protobuf_buffer.set_width(buffer.size().width.as_int());
+    protobuf_buffer.set_height(buffer.size().height.as_int());
+}
 }
 
 mf::SessionMediator::SessionMediator(
@@ -102,6 +111,7 @@ mf::SessionMediator::SessionMediator(
     std::shared_ptr<mf::EventSinkFactory> const& sink_factory,
     std::shared_ptr<mf::MessageSender> const& message_sender,
     std::shared_ptr<MessageResourceCache> const& resource_cache,
+    std::shared_ptr<mf::Screencast> const& screencast,
     ConnectionContext const& connection_context,
     std::shared_ptr<mi::CursorImages> const& cursor_images,
     std::shared_ptr<scene::CoordinateTranslator> const& translator,
@@ -120,6 +130,7 @@ mf::SessionMediator::SessionMediator(
     event_sink{sink_factory->create_sink(message_sender)},
     message_sender{message_sender},
     resource_cache(resource_cache),
+    screencast(screencast),
     connection_context(connection_context),
     cursor_images(cursor_images),
     translator{translator},
@@ -134,6 +145,18 @@ mf::SessionMediator::SessionMediator(
 
 mf::SessionMediator::~SessionMediator() noexcept
 {
+    screencast_buffer_tracker.for_each_session(
+        [this](ScreencastSessionId id)
+        {
+            try
+            {
+                screencast->destroy_session(id);
+            }
+            catch (...)
+            {
+            }
+        });
+
     if (auto mir_client_session = weak_mir_client_session.lock())
     {
         observer->session_error(mir_client_session->name(), __PRETTY_FUNCTION__, "connection dropped without disconnect");
@@ -507,6 +530,15 @@ void mf::SessionMediator::allocate_buffers(
                 if (usage == mg::BufferUsage::software)
                 {
                     buffer = allocator->alloc_software_buffer(size, pf);
+
+                    auto const scene_session = weak_scene_session.lock();
+                    if (auto const account = scene_session ? scene_session->memory_account() : nullptr)
+                    {
+                        buffer = account->charged(
+                            buffer,
+                            ms::MemoryAccount::Kind::buffers,
+                            ms::MemoryAccount::estimated_size(*buffer));
+                    }
                 }
                 else
                 {
@@ -889,35 +921,77 @@ void mf::SessionMediator::cancel_base_display_configuration_preview(
 }
 
 void mf::SessionMediator::create_screencast(
-    const mir::protobuf::ScreencastParameters*,
-    mir::protobuf::Screencast*,
-    google::protobuf::Closure*)
+    const mir::protobuf::ScreencastParameters* parameters,
+    mir::protobuf::Screencast* protobuf_screencast,
+    google::protobuf::Closure* done)
 {
-    BOOST_THROW_EXCEPTION((std::runtime_error{"Screencast unsupported"}));
+    auto const& region = parameters->region();
+    geom::Rectangle const rect{
+        {region.left(), region.top()},
+        {region.width(), region.height()}};
+    geom::Size const size{parameters->width(), parameters->height()};
+    auto const pixel_format = static_cast<MirPixelFormat>(parameters->pixel_format());
+    auto const nbuffers = parameters->has_num_buffers() ? parameters->num_buffers() : 1;
+    auto const mirror_mode = parameters->has_mirror_mode() ?
+        static_cast<MirMirrorMode>(parameters->mirror_mode()) : mir_mirror_mode_none;
+
+    auto const screencast_session_id =
+        screencast->create_session(rect, size, pixel_format, nbuffers, mirror_mode);
+
+    auto const buffer = screencast->capture(screencast_session_id);
+    screencast_buffer_tracker.track_buffer(screencast_session_id, buffer.get());
+
+    protobuf_screencast->mutable_screencast_id()->set_value(screencast_session_id.as_value());
+
+    auto const stream = protobuf_screencast->mutable_buffer_stream();
+    stream->mutable_id()->set_value(screencast_session_id.as_value());
+    stream->set_pixel_format(pixel_format);
+    stream->set_buffer_usage(mir_buffer_usage_software);
+    pack_screencast_buffer(*stream->mutable_buffer(), *buffer);
+
+    done->Run();
 }
 
 void mf::SessionMediator::release_screencast(
-    const mir::protobuf::ScreencastId*,
+    const mir::protobuf::ScreencastId* protobuf_screencast_id,
     mir::protobuf::Void*,
-    google::protobuf::Closure*)
+    google::protobuf::Closure* done)
 {
-    BOOST_THROW_EXCEPTION((std::runtime_error{"Screencast unsupported"}));
+    ScreencastSessionId const screencast_session_id{protobuf_screencast_id->value()};
+
+    screencast->destroy_session(screencast_session_id);
+    screencast_buffer_tracker.remove_session(screencast_session_id);
+
+    done->Run();
 }
 
 void mf::SessionMediator::screencast_buffer(
-    const mir::protobuf::ScreencastId*,
-    mir::protobuf::Buffer*,
-    google::protobuf::Closure*)
+    const mir::protobuf::ScreencastId* protobuf_screencast_id,
+    mir::protobuf::Buffer* protobuf_buffer,
+    google::protobuf::Closure* done)
 {
-    BOOST_THROW_EXCEPTION((std::runtime_error{"Screencast unsupported"}));
+    ScreencastSessionId const screencast_session_id{protobuf_screencast_id->value()};
+
+    auto const buffer = screencast->capture(screencast_session_id);
+    screencast_buffer_tracker.track_buffer(screencast_session_id, buffer.get());
+
+    pack_screencast_buffer(*protobuf_buffer, *buffer);
+
+    done->Run();
 }
 
 void mf::SessionMediator::screencast_to_buffer(
-    mir::protobuf::ScreencastRequest const*,
+    mir::protobuf::ScreencastRequest const* request,
     mir::protobuf::Void*,
-    google::protobuf::Closure*)
+    google::protobuf::Closure* done)
 {
-    BOOST_THROW_EXCEPTION((std::runtime_error{"Screencast unsupported"}));
+    auto const buffer = buffer_cache.find(mg::BufferID{request->buffer_id()});
+    if (buffer == buffer_cache.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid buffer for screencast"));
+
+    screencast->capture(ScreencastSessionId{request->id().value()}, buffer->second);
+
+    done->Run();
 }
 
 void mf::SessionMediator::create_buffer_stream(
@@ -0,0 +1,215 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_pool_tracker.h"
+
+#include <wayland-server-protocol.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#if (WAYLAND_VERSION_MAJOR == 1) && (WAYLAND_VERSION_MINOR < 14)
+#define MIR_NO_WAYLAND_PROTOCOL_LOGGER
+#endif
+
+namespace mf = mir::frontend;
+
+namespace
+{
+/// The pools, and the buffers created from them, of one client
+struct ClientPools
+{
+    std::unordered_map<uint32_t, std::size_t> pool_sizes;
+    /// The bytes from each buffer's offset to the end of its pool, as it was when the buffer was created
+    std::unordered_map<uint32_t, std::size_t> buffer_extents;
+};
+
+struct ClientPoolsListener
+{
+    wl_listener destroyed;
+    ClientPools* pools;
+};
+
+static_assert(
+    std::is_standard_layout<ClientPoolsListener>::value,
+    "ClientPoolsListener must be Standard Layout for wl_container_of to be defined behaviour");
+
+void on_client_destroyed(wl_listener* listener, void*)
+{
+    ClientPoolsListener* self;
+    self = wl_container_of(listener, self, destroyed);
+    delete self->pools;
+    delete self;
+}
+
+auto existing_pools_of(wl_client* client) -> ClientPools*
+{
+    if (auto const listener = wl_client_get_destroy_listener(client, &on_client_destroyed))
+    {
+        ClientPoolsListener* self;
+        self = wl_container_of(listener, self, destroyed);
+        return self->pools;
+    }
+    return nullptr;
+}
+
+#ifndef MIR_NO_WAYLAND_PROTOCOL_LOGGER
+auto pools_of(wl_client* client) -> ClientPools&
+{
+    if (auto const pools = existing_pools_of(client))
+        return *pools;
+
+    auto const self = new ClientPoolsListener{{}, new ClientPools};
+    self->destroyed.notify = &on_client_destroyed;
+    wl_client_add_destroy_listener(client, &self->destroyed);
+    return *self->pools;
+}
+
+bool is(wl_resource* resource, wl_interface const& interface)
+{
+    return std::strcmp(wl_resource_get_class(resource), interface.name) == 0;
+}
+
+bool is(wl_protocol_logger_message const* message, char const* request)
+{
+    return std::strcmp(message->message->name, request) == 0;
+}
+
+void on_request(
+    void* /*context*/,
+    wl_protocol_logger_type type,
+    wl_protocol_logger_message const* message)
+{
+    if (type != WL_PROTOCOL_LOGGER_REQUEST)
+        return;
+
+    auto const resource = message->resource;
+    auto const args = message->arguments;
+
+    if (is(resource, wl_shm_interface) && is(message, "create_pool"))
+    {
+        // create_pool(new_id, fd, size)
+        pools_of(wl_resource_get_client(resource)).pool_sizes[args[0].n] = args[2].i;
+    }
+    else if (is(resource, wl_shm_pool_interface))
+    {
+        auto& pools = pools_of(wl_resource_get_client(resource));
+        auto const pool = wl_resource_get_id(resource);
+
+        if (is(message, "create_buffer"))
+        {
+            // create_buffer(new_id, offset, width, height, stride, format)
+            // Pools only grow, so the bytes after the offset now remain available to the buffer
+            auto const size = pools.pool_sizes.find(pool);
+            auto const offset = args[1].i;
+            if (size != pools.pool_sizes.end() && offset >= 0 && std::size_t(offset) <= size->second)
+                pools.buffer_extents[args[0].n] = size->second - offset;
+            else
+                pools.buffer_extents.erase(args[0].n);
+        }
+        else if (is(message, "resize"))
+        {
+            pools.pool_sizes[pool] = args[0].i;
+        }
+        else if (is(message, "destroy"))
+        {
+            pools.pool_sizes.erase(pool);
+        }
+    }
+    else if (is(resource, wl_buffer_interface) && is(message, "destroy"))
+    {
+        if (auto const pools = existing_pools_of(wl_resource_get_client(resource)))
+            pools->buffer_extents.erase(wl_resource_get_id(resource));
+    }
+}
+#endif
+}
+
+#ifndef MIR_NO_WAYLAND_PROTOCOL_LOGGER
+mf::ShmPoolTracker::ShmPoolTracker(wl_display* display)
+    : logger{wl_display_add_protocol_logger(display, &on_request, nullptr)}
+{
+    if (!logger)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to follow wl_shm pools"}));
+    }
+}
+
+mf::ShmPoolTracker::~ShmPoolTracker()
+{
+    wl_protocol_logger_destroy(logger);
+}
+#else
+mf::ShmPoolTracker::ShmPoolTracker(wl_display* /*display*/)
+    : logger{nullptr}
+{
+    BOOST_THROW_EXCEPTION((std::runtime_error{"Following wl_shm pools needs libwayland 1.14 or later"}));
+}
+
+mf::ShmPoolTracker::~ShmPoolTracker() = default;
+#endif
+
+auto mf::shm_buffer_extent(uint32_t format, int32_t width, int32_t height, int32_t stride) -> std::size_t
+{
+    // These follow how the planes are read by WlShmYUVBuffer, up to the last byte of each
+    std::size_t const luma = std::size_t(stride) * height;
+    std::size_t const chroma_width = (width + 1) / 2;
+    std::size_t const chroma_height = (height + 1) / 2;
+
+    switch (format)
+    {
+    case WL_SHM_FORMAT_NV12:
+        // Interleaved UV rows, each as long as a luma row
+        return luma + 2 * std::size_t(stride / 2) * (chroma_height - 1) + 2 * chroma_width;
+
+    case WL_SHM_FORMAT_YUV420:
+    {
+        // A U plane, then a V plane, each with rows half as long as a luma row
+        std::size_t const chroma_stride = stride / 2;
+        return luma + chroma_stride * chroma_height + chroma_stride * (chroma_height - 1) + chroma_width;
+    }
+
+    default:
+        return luma;
+    }
+}
+
+bool mf::shm_planes_fit(wl_resource* buffer)
+{
+    auto const shm_buffer = wl_shm_buffer_get(buffer);
+    if (!shm_buffer)
+        return false;
+
+    auto const height = wl_shm_buffer_get_height(shm_buffer);
+    auto const stride = wl_shm_buffer_get_stride(shm_buffer);
+    auto const extent = shm_buffer_extent(
+        wl_shm_buffer_get_format(shm_buffer), wl_shm_buffer_get_width(shm_buffer), height, stride);
+
+    // libwayland has already checked this much lies within the pool
+    if (extent <= std::size_t(stride) * height)
+        return true;
+
+    auto const pools = existing_pools_of(wl_resource_get_client(buffer));
+    if (!pools)
+        return false;
+
+    auto const available = pools->buffer_extents.find(wl_resource_get_id(buffer));
+    return available != pools->buffer_extents.end() && extent <= available->second;
+}
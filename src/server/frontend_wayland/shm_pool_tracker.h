@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_SHM_POOL_TRACKER_H_
+#define MIR_FRONTEND_SHM_POOL_TRACKER_H_
+
+#include <wayland-server-core.h>
+
+#include <cstddef>
+#include <cstdint>
+
+struct wl_protocol_logger;
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * Follows the wl_shm pools the clients of a display create, and the buffers
+ * they create from them, so that shm_planes_fit() can check buffers whose
+ * planes extend past what libwayland validates.
+ *
+ * libwayland only checks that stride × height bytes from a buffer's offset
+ * lie within its pool, and doesn't expose the pool's size.
+ *
+ * What is followed belongs to each client, and goes with it, so clients
+ * may outlive the tracker. The tracker must not outlive the display.
+ *
+ * Following requests needs libwayland 1.14 or later; with older versions
+ * construction throws.
+ */
+class ShmPoolTracker
+{
+public:
+    explicit ShmPoolTracker(wl_display* display);
+    ~ShmPoolTracker();
+
+    ShmPoolTracker(ShmPoolTracker const&) = delete;
+    ShmPoolTracker& operator=(ShmPoolTracker const&) = delete;
+
+private:
+    wl_protocol_logger* const logger;
+};
+
+/**
+ * The bytes, from its offset, that a wl_shm buffer of \a format is read
+ * from; more than \a stride × \a height for planar YUV formats.
+ */
+auto shm_buffer_extent(uint32_t format, int32_t width, int32_t height, int32_t stride) -> std::size_t;
+
+/**
+ * Whether all the planes of the wl_shm \a buffer lie within its pool.
+ *
+ * Buffers of a single plane always do, as libwayland has checked them.
+ * Those of more fit only if a ShmPoolTracker followed their creation.
+ */
+bool shm_planes_fit(wl_resource* buffer);
+}
+}
+
+#endif // MIR_FRONTEND_SHM_POOL_TRACKER_H_
@@ -30,6 +30,7 @@
 #include "null_event_sink.h"
 #include "output_manager.h"
 #include "wayland_executor.h"
+#include "shm_pool_tracker.h"
 
 #include "wayland_wrapper.h"
 
@@ -614,6 +615,7 @@ mf::WaylandConnector::WaylandConnector(
     std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
     std::shared_ptr<mf::SessionAuthorizer> const& session_authorizer,
     std::shared_ptr<SurfaceStack> const& surface_stack,
+    std::shared_ptr<compositor::ScreenCapture> const& screen_capture,
     bool arw_socket,
     std::unique_ptr<WaylandExtensions> extensions_,
     WaylandProtocolExtensionFilter const& extension_filter)
@@ -678,9 +680,22 @@ mf::WaylandConnector::WaylandConnector(
         shell,
         seat_global.get(),
         output_manager.get(),
-        surface_stack});
+        surface_stack,
+        executor,
+        screen_capture});
 
     wl_display_init_shm(display.get());
+#ifndef MIR_NO_WAYLAND_FILTER
+    // Planar YUV, for video, is sampled as it is by the renderer. Its chroma planes
+    // extend past what libwayland validates, so are checked against the pools followed.
+    shm_pool_tracker = std::make_unique<mf::ShmPoolTracker>(display.get());
+    wl_display_add_shm_format(display.get(), mw::Shm::Format::nv12);
+    wl_display_add_shm_format(display.get(), mw::Shm::Format::yuv420);
+#else
+    log_warning("Cannot offer planar YUV wl_shm formats: "
+        "wl_display_add_protocol_logger() is unavailable in libwayland-dev "
+        WAYLAND_VERSION);
+#endif
 
     char const* wayland_display = nullptr;
 
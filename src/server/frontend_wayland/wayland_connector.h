@@ -42,6 +42,10 @@ namespace graphics
 {
 class GraphicBufferAllocator;
 }
+namespace compositor
+{
+class ScreenCapture;
+}
 namespace geometry
 {
 struct Size;
@@ -65,6 +69,7 @@ class MirDisplay;
 class SessionAuthorizer;
 class DataDeviceManager;
 class WlSurface;
+class ShmPoolTracker;
 class SurfaceStack;
 
 class WaylandExtensions
@@ -78,6 +83,8 @@ public:
         WlSeat* seat;
         OutputManager* output_manager;
         std::shared_ptr<SurfaceStack> surface_stack;
+        std::shared_ptr<Executor> wayland_executor;
+        std::shared_ptr<compositor::ScreenCapture> screen_capture;
     };
 
     WaylandExtensions() = default;
@@ -113,6 +120,7 @@ public:
         std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
         std::shared_ptr<SessionAuthorizer> const& session_authorizer,
         std::shared_ptr<SurfaceStack> const& surface_stack,
+        std::shared_ptr<compositor::ScreenCapture> const& screen_capture,
         bool arw_socket,
         std::unique_ptr<WaylandExtensions> extensions,
         WaylandProtocolExtensionFilter const& extension_filter);
@@ -142,6 +150,7 @@ private:
     static bool wl_display_global_filter_func_thunk(wl_client const* client, wl_global const* global, void* data);
 
     std::unique_ptr<wl_display, void(*)(wl_display*)> const display;
+    std::unique_ptr<ShmPoolTracker> shm_pool_tracker;
     mir::Fd const pause_signal;
     std::unique_ptr<WlCompositor> compositor_global;
     std::unique_ptr<WlSubcompositor> subcompositor_global;
@@ -24,10 +24,12 @@
 #include "xdg_shell_stable.h"
 #include "xdg_output_v1.h"
 #include "layer_shell_v1.h"
+#include "wlr_screencopy_v1.h"
 #include "xwayland_wm_shell.h"
 #include "mir_display.h"
 #include "wl_seat.h"
 #include "xdg-output-unstable-v1_wrapper.h"
+#include "wlr-screencopy-unstable-v1_wrapper.h"
 
 #include "mir/graphics/platform.h"
 #include "mir/options/default_configuration.h"
@@ -71,6 +73,13 @@ std::vector<ExtensionBuilder> const internal_extension_builders = {
         mw::XdgOutputManagerV1::interface_name, [](auto const& ctx) -> std::shared_ptr<void>
             { return create_xdg_output_manager_v1(ctx.display, ctx.output_manager); }
     },
+    {
+        mw::ScreencopyManagerV1::interface_name, [](auto const& ctx) -> std::shared_ptr<void>
+            {
+                return create_wlr_screencopy_manager_v1(
+                    ctx.display, ctx.output_manager, ctx.wayland_executor, ctx.screen_capture);
+            }
+    },
 };
 
 ExtensionBuilder const xwayland_builder {
@@ -195,6 +204,7 @@ std::shared_ptr<mf::Connector>
                 the_buffer_allocator(),
                 the_session_authorizer(),
                 the_frontend_surface_stack(),
+                the_screen_capture(),
                 arw_socket,
                 configure_wayland_extensions(
                     wayland_extensions,
@@ -20,6 +20,7 @@
 
 #include "mir/fd.h"
 #include "mir/log.h"
+#include "mir/trace/recorder.h"
 
 #include <sys/eventfd.h>
 
@@ -237,6 +238,7 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
     {
         try
         {
+            MIR_TRACE_SCOPE("wayland", "work_item");
             work();
         }
         catch (...)
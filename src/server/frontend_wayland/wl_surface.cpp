@@ -23,6 +23,7 @@
 #include "wl_subcompositor.h"
 #include "wl_region.h"
 #include "deleted_for_resource.h"
+#include "shm_pool_tracker.h"
 
 #include "wayland_wrapper.h"
 
@@ -30,6 +31,7 @@
 
 #include "mir/graphics/buffer_properties.h"
 #include "mir/scene/session.h"
+#include "mir/scene/memory_account.h"
 #include "mir/frontend/wayland.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/executor.h"
@@ -400,10 +402,26 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     BOOST_THROW_EXCEPTION((
                                               std::runtime_error{"Buffer has invalid stride"}));
                 }
+                if (!shm_planes_fit(buffer))
+                {
+                    wl_resource_post_error(
+                        buffer,
+                        WL_SHM_ERROR_INVALID_STRIDE,
+                        "Buffer's planes extend past the end of its pool");
+
+                    BOOST_THROW_EXCEPTION((std::runtime_error{"Buffer's planes extend past its pool"}));
+                }
                 mir_buffer = allocator->buffer_from_shm(
                     buffer,
                     executor,
                     std::move(executor_send_frame_callbacks));
+
+                // libwayland doesn't tell us the size of the pool, only the part the buffer spans
+                if (auto const account = session->memory_account())
+                {
+                    auto const bytes = std::size_t(stride) * wl_shm_buffer_get_height(shm_buffer);
+                    mir_buffer = account->charged(mir_buffer, scene::MemoryAccount::Kind::shm, bytes);
+                }
                 tracepoint(
                     mir_server_wayland,
                     sw_buffer_committed,
@@ -425,6 +443,14 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     buffer,
                     std::move(executor_send_frame_callbacks),
                     std::move(release_buffer));
+
+                if (auto const account = session->memory_account())
+                {
+                    mir_buffer = account->charged(
+                        mir_buffer,
+                        scene::MemoryAccount::Kind::buffers,
+                        scene::MemoryAccount::estimated_size(*mir_buffer));
+                }
                 tracepoint(
                     mir_server_wayland,
                     hw_buffer_committed,
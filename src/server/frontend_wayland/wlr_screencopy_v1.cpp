@@ -0,0 +1,552 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "wlr_screencopy_v1.h"
+
+#include "wlr-screencopy-unstable-v1_wrapper.h"
+#include "deleted_for_resource.h"
+#include "output_manager.h"
+
+#include "mir/compositor/screen_capture.h"
+#include "mir/executor.h"
+
+#include <wayland-server-core.h>
+#include <wayland-server-protocol.h>
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <time.h>
+#include <unordered_map>
+
+namespace mf = mir::frontend;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace mw = mir::wayland;
+
+namespace mir
+{
+namespace frontend
+{
+
+class WlrScreencopyManagerV1 : public wayland::ScreencopyManagerV1::Global
+{
+public:
+    WlrScreencopyManagerV1(
+        struct wl_display* display,
+        OutputManager* const output_manager,
+        std::shared_ptr<Executor> const& wayland_executor,
+        std::shared_ptr<compositor::ScreenCapture> const& screen_capture);
+
+private:
+    class Instance;
+
+    void bind(wl_resource* new_resource) override;
+
+    OutputManager* const output_manager;
+    std::shared_ptr<Executor> const wayland_executor;
+    std::shared_ptr<compositor::ScreenCapture> const screen_capture;
+};
+
+}
+}
+
+namespace
+{
+/// A capture session and the buffers a client has captured into through it
+class TrackedSession
+{
+public:
+    explicit TrackedSession(std::shared_ptr<mc::ScreenCapture::Session> const& session) :
+        session{session}
+    {
+    }
+
+    auto area() const -> geom::Rectangle
+    {
+        return session->area();
+    }
+
+    void capture(wl_resource* buffer, std::shared_ptr<mc::CaptureTarget> const& target, bool wait_for_damage)
+    {
+        forget_destroyed_buffers();
+
+        if (buffers.find(buffer) == buffers.end())
+            buffers.emplace(buffer, mf::deleted_flag_for_resource(buffer));
+
+        session->capture(key_of(buffer), target, wait_for_damage);
+    }
+
+    /// The capture into \a buffer ended without the client seeing its result
+    void abandon(wl_resource* buffer)
+    {
+        session->forget(key_of(buffer));
+    }
+
+private:
+    static auto key_of(wl_resource* buffer) -> mc::ScreenCapture::BufferKey
+    {
+        return reinterpret_cast<mc::ScreenCapture::BufferKey>(buffer);
+    }
+
+    /// A new buffer may be allocated where a destroyed one was, so must not inherit its key
+    void forget_destroyed_buffers()
+    {
+        for (auto i = buffers.begin(); i != buffers.end();)
+        {
+            if (*i->second)
+            {
+                session->forget(key_of(i->first));
+                i = buffers.erase(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    std::shared_ptr<mc::ScreenCapture::Session> const session;
+    std::unordered_map<wl_resource*, std::shared_ptr<bool>> buffers;
+};
+
+/**
+ * A client's wl_shm buffer, as written to by the compositor thread.
+ *
+ * Only the Wayland thread may destroy the buffer, so it detaches us first;
+ * our mutex keeps it from doing so while we are writing.
+ */
+class BufferAccess
+{
+public:
+    explicit BufferAccess(wl_resource* buffer) :
+        buffer{buffer},
+        shim{{}, this}
+    {
+        shim.destruction_listener.notify = &on_destroyed;
+        wl_resource_add_destroy_listener(buffer, &shim.destruction_listener);
+    }
+
+    ~BufferAccess()
+    {
+        detach();
+    }
+
+    /// Must be called on the Wayland thread
+    void detach()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (buffer)
+        {
+            wl_list_remove(&shim.destruction_listener.link);
+            buffer = nullptr;
+        }
+    }
+
+    void write(geom::Rectangle const& region, unsigned char const* pixels, geom::Stride stride)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!buffer)
+            return;
+
+        auto const shm_buffer = wl_shm_buffer_get(buffer);
+        auto const dest_stride = wl_shm_buffer_get_stride(shm_buffer);
+
+        wl_shm_buffer_begin_access(shm_buffer);
+        auto const dest = static_cast<unsigned char*>(wl_shm_buffer_get_data(shm_buffer)) +
+                          region.top_left.y.as_int() * dest_stride +
+                          region.top_left.x.as_int() * 4;
+        mc::copy_captured_pixels(region.size, pixels, stride, dest, dest_stride, mir_pixel_format_xrgb_8888);
+        wl_shm_buffer_end_access(shm_buffer);
+    }
+
+private:
+    struct DestructionShim
+    {
+        wl_listener destruction_listener;
+        BufferAccess* owner;
+    };
+    static_assert(
+        std::is_standard_layout<DestructionShim>::value,
+        "DestructionShim must be Standard Layout for wl_container_of to be defined behaviour");
+
+    static void on_destroyed(wl_listener* listener, void*)
+    {
+        DestructionShim* shim;
+        shim = wl_container_of(listener, shim, destruction_listener);
+        shim->owner->detach();
+    }
+
+    std::mutex mutex;
+    wl_resource* buffer;
+    DestructionShim shim;
+};
+
+class WlrScreencopyFrameV1 : public mw::ScreencopyFrameV1
+{
+public:
+    WlrScreencopyFrameV1(
+        wl_resource* new_resource,
+        std::shared_ptr<mir::Executor> const& wayland_executor,
+        std::shared_ptr<TrackedSession> const& session);
+
+    ~WlrScreencopyFrameV1();
+
+    /// Fails the frame of an output or region there is nothing of to capture
+    static void fail(wl_resource* new_resource);
+
+private:
+    class Target;
+
+    void copy(wl_resource* buffer) override;
+    void copy_with_damage(wl_resource* buffer) override;
+    void destroy() override;
+
+    void start_copy(wl_resource* buffer, bool with_damage);
+    void ready(geom::Rectangles const& damage);
+    void failed();
+
+    std::shared_ptr<mir::Executor> const wayland_executor;
+    std::shared_ptr<TrackedSession> const session;
+    geom::Size const size;
+
+    wl_resource* copied_buffer{nullptr};
+    std::shared_ptr<BufferAccess> buffer_access;
+    bool send_damage{false};
+    bool finished{false};
+};
+
+class WlrScreencopyFrameV1::Target : public mc::CaptureTarget
+{
+public:
+    Target(
+        std::shared_ptr<BufferAccess> const& buffer_access,
+        std::shared_ptr<mir::Executor> const& wayland_executor,
+        mw::Weak<WlrScreencopyFrameV1> const& frame) :
+        buffer_access{buffer_access},
+        wayland_executor{wayland_executor},
+        frame{frame}
+    {
+    }
+
+    void write(geom::Rectangle const& region, unsigned char const* pixels, geom::Stride stride) override
+    {
+        buffer_access->write(region, pixels, stride);
+    }
+
+    void captured(geom::Rectangles const& damage) override
+    {
+        wayland_executor->spawn([frame = frame, damage]()
+            {
+                if (frame)
+                    frame.value().ready(damage);
+            });
+    }
+
+    void failed() override
+    {
+        wayland_executor->spawn([frame = frame]()
+            {
+                if (frame)
+                    frame.value().failed();
+            });
+    }
+
+private:
+    std::shared_ptr<BufferAccess> const buffer_access;
+    std::shared_ptr<mir::Executor> const wayland_executor;
+    mw::Weak<WlrScreencopyFrameV1> const frame;
+};
+
+WlrScreencopyFrameV1::WlrScreencopyFrameV1(
+    wl_resource* new_resource,
+    std::shared_ptr<mir::Executor> const& wayland_executor,
+    std::shared_ptr<TrackedSession> const& session) :
+    mw::ScreencopyFrameV1{new_resource, Version<2>()},
+    wayland_executor{wayland_executor},
+    session{session},
+    size{session->area().size}
+{
+    send_buffer_event(
+        WL_SHM_FORMAT_XRGB8888,
+        size.width.as_uint32_t(),
+        size.height.as_uint32_t(),
+        size.width.as_uint32_t() * 4);
+}
+
+WlrScreencopyFrameV1::~WlrScreencopyFrameV1()
+{
+    if (buffer_access)
+    {
+        buffer_access->detach();
+
+        // The client may never know what was written to the buffer
+        if (!finished)
+            session->abandon(copied_buffer);
+    }
+}
+
+void WlrScreencopyFrameV1::fail(wl_resource* new_resource)
+{
+    class FailedFrame : public mw::ScreencopyFrameV1
+    {
+    public:
+        explicit FailedFrame(wl_resource* new_resource) :
+            mw::ScreencopyFrameV1{new_resource, Version<2>()}
+        {
+            send_failed_event();
+        }
+
+    private:
+        void copy(wl_resource*) override {}
+        void copy_with_damage(wl_resource*) override {}
+        void destroy() override { destroy_wayland_object(); }
+    };
+
+    new FailedFrame{new_resource};
+}
+
+void WlrScreencopyFrameV1::copy(wl_resource* buffer)
+{
+    start_copy(buffer, false);
+}
+
+void WlrScreencopyFrameV1::copy_with_damage(wl_resource* buffer)
+{
+    start_copy(buffer, true);
+}
+
+void WlrScreencopyFrameV1::destroy()
+{
+    destroy_wayland_object();
+}
+
+void WlrScreencopyFrameV1::start_copy(wl_resource* buffer, bool with_damage)
+{
+    if (copied_buffer)
+    {
+        wl_resource_post_error(resource, Error::already_used, "Frame has already been copied");
+        return;
+    }
+
+    auto const shm_buffer = wl_shm_buffer_get(buffer);
+    if (!shm_buffer ||
+        wl_shm_buffer_get_format(shm_buffer) != WL_SHM_FORMAT_XRGB8888 ||
+        wl_shm_buffer_get_width(shm_buffer) != size.width.as_int() ||
+        wl_shm_buffer_get_height(shm_buffer) != size.height.as_int() ||
+        wl_shm_buffer_get_stride(shm_buffer) < size.width.as_int() * 4)
+    {
+        wl_resource_post_error(resource, Error::invalid_buffer, "Buffer does not match the advertised shm buffer");
+        return;
+    }
+
+    copied_buffer = buffer;
+    buffer_access = std::make_shared<BufferAccess>(buffer);
+    send_damage = with_damage;
+
+    session->capture(
+        buffer,
+        std::make_shared<Target>(buffer_access, wayland_executor, mw::make_weak(this)),
+        with_damage);
+}
+
+void WlrScreencopyFrameV1::ready(geom::Rectangles const& damage)
+{
+    finished = true;
+    buffer_access->detach();
+
+    send_flags_event(0);
+
+    if (send_damage && version_supports_damage())
+    {
+        for (auto const& rect : damage)
+        {
+            send_damage_event(
+                rect.top_left.x.as_uint32_t(),
+                rect.top_left.y.as_uint32_t(),
+                rect.size.width.as_uint32_t(),
+                rect.size.height.as_uint32_t());
+        }
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    auto const seconds = static_cast<uint64_t>(now.tv_sec);
+    send_ready_event(seconds >> 32, seconds & 0xffffffff, now.tv_nsec);
+}
+
+void WlrScreencopyFrameV1::failed()
+{
+    finished = true;
+    buffer_access->detach();
+
+    send_failed_event();
+}
+}
+
+class mf::WlrScreencopyManagerV1::Instance : public wayland::ScreencopyManagerV1
+{
+public:
+    Instance(
+        wl_resource* new_resource,
+        OutputManager* const output_manager,
+        std::shared_ptr<Executor> const& wayland_executor,
+        std::shared_ptr<compositor::ScreenCapture> const& screen_capture);
+
+private:
+    void capture_output(wl_resource* frame, int32_t overlay_cursor, wl_resource* output) override;
+    void capture_output_region(
+        wl_resource* frame,
+        int32_t overlay_cursor,
+        wl_resource* output,
+        int32_t x, int32_t y,
+        int32_t width, int32_t height) override;
+    void destroy() override;
+
+    void capture(wl_resource* frame, geom::Rectangle const& area);
+    auto extents_of(wl_resource* output) const -> geom::Rectangle;
+    auto session_for(geom::Rectangle const& area) -> std::shared_ptr<TrackedSession>;
+
+    OutputManager* const output_manager;
+    std::shared_ptr<Executor> const wayland_executor;
+    std::shared_ptr<compositor::ScreenCapture> const screen_capture;
+
+    /**
+     * Clients capture the same areas repeatedly, so sessions are kept for the
+     * areas most recently captured (most recent first) to track their damage.
+     * Others live only as long as their frames.
+     */
+    std::deque<std::shared_ptr<TrackedSession>> recent_sessions;
+    static std::size_t const max_recent_sessions{4};
+};
+
+auto mf::create_wlr_screencopy_manager_v1(
+    struct wl_display* display,
+    OutputManager* const output_manager,
+    std::shared_ptr<Executor> const& wayland_executor,
+    std::shared_ptr<compositor::ScreenCapture> const& screen_capture)
+    -> std::shared_ptr<WlrScreencopyManagerV1>
+{
+    return std::make_shared<WlrScreencopyManagerV1>(display, output_manager, wayland_executor, screen_capture);
+}
+
+mf::WlrScreencopyManagerV1::WlrScreencopyManagerV1(
+    struct wl_display* display,
+    OutputManager* const output_manager,
+    std::shared_ptr<Executor> const& wayland_executor,
+    std::shared_ptr<compositor::ScreenCapture> const& screen_capture)
+    : Global(display, Version<2>()),
+      output_manager{output_manager},
+      wayland_executor{wayland_executor},
+      screen_capture{screen_capture}
+{
+}
+
+void mf::WlrScreencopyManagerV1::bind(wl_resource* new_resource)
+{
+    new Instance{new_resource, output_manager, wayland_executor, screen_capture};
+}
+
+mf::WlrScreencopyManagerV1::Instance::Instance(
+    wl_resource* new_resource,
+    OutputManager* const output_manager,
+    std::shared_ptr<Executor> const& wayland_executor,
+    std::shared_ptr<compositor::ScreenCapture> const& screen_capture)
+    : ScreencopyManagerV1{new_resource, Version<2>()},
+      output_manager{output_manager},
+      wayland_executor{wayland_executor},
+      screen_capture{screen_capture}
+{
+}
+
+void mf::WlrScreencopyManagerV1::Instance::capture_output(
+    wl_resource* frame,
+    int32_t /*overlay_cursor*/,
+    wl_resource* output)
+{
+    capture(frame, extents_of(output));
+}
+
+void mf::WlrScreencopyManagerV1::Instance::capture_output_region(
+    wl_resource* frame,
+    int32_t /*overlay_cursor*/,
+    wl_resource* output,
+    int32_t x, int32_t y,
+    int32_t width, int32_t height)
+{
+    auto const extents = extents_of(output);
+
+    // The region is in output-local coordinates, and may extend beyond the output
+    geom::Rectangle const region{
+        extents.top_left + geom::Displacement{x, y},
+        geom::Size{std::max(width, 0), std::max(height, 0)}};
+
+    capture(frame, region.intersection_with(extents));
+}
+
+void mf::WlrScreencopyManagerV1::Instance::destroy()
+{
+    destroy_wayland_object();
+}
+
+void mf::WlrScreencopyManagerV1::Instance::capture(wl_resource* frame, geom::Rectangle const& area)
+{
+    if (area.size.width == geom::Width{} || area.size.height == geom::Height{})
+    {
+        WlrScreencopyFrameV1::fail(frame);
+        return;
+    }
+
+    new WlrScreencopyFrameV1{frame, wayland_executor, session_for(area)};
+}
+
+auto mf::WlrScreencopyManagerV1::Instance::extents_of(wl_resource* output) const -> geom::Rectangle
+{
+    geom::Rectangle extents;
+
+    if (auto const output_id = output_manager->output_id_for(client, output))
+    {
+        output_manager->display_config()->for_each_output(
+            [&](mg::DisplayConfigurationOutput const& config)
+            {
+                if (config.id == output_id.value())
+                    extents = config.extents();
+            });
+    }
+
+    return extents;
+}
+
+auto mf::WlrScreencopyManagerV1::Instance::session_for(geom::Rectangle const& area)
+    -> std::shared_ptr<TrackedSession>
+{
+    auto const existing = std::find_if(
+        recent_sessions.begin(), recent_sessions.end(),
+        [&area](std::shared_ptr<TrackedSession> const& session) { return session->area() == area; });
+
+    auto const session = existing != recent_sessions.end() ?
+        *existing : std::make_shared<TrackedSession>(screen_capture->open_session(area));
+
+    if (existing != recent_sessions.end())
+        recent_sessions.erase(existing);
+    recent_sessions.push_front(session);
+
+    if (recent_sessions.size() > max_recent_sessions)
+        recent_sessions.pop_back();
+
+    return session;
+}
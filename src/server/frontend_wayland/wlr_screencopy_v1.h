@@ -0,0 +1,46 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_WLR_SCREENCOPY_V1_H
+#define MIR_FRONTEND_WLR_SCREENCOPY_V1_H
+
+#include <memory>
+
+struct wl_display;
+
+namespace mir
+{
+class Executor;
+namespace compositor
+{
+class ScreenCapture;
+}
+namespace frontend
+{
+class WlrScreencopyManagerV1;
+class OutputManager;
+
+auto create_wlr_screencopy_manager_v1(
+    struct wl_display* display,
+    OutputManager* const output_manager,
+    std::shared_ptr<Executor> const& wayland_executor,
+    std::shared_ptr<compositor::ScreenCapture> const& screen_capture)
+    -> std::shared_ptr<WlrScreencopyManagerV1>;
+
+}
+}
+
+#endif // MIR_FRONTEND_WLR_SCREENCOPY_V1_H
@@ -58,6 +58,9 @@ public:
 
     void send_configure();
 
+    /// True between sending a configure and the client acking it
+    auto awaiting_ack() const -> bool { return static_cast<bool>(unacked_serial); }
+
     mw::Weak<WindowWlSurfaceRole> const& window_role();
 
     using mw::XdgSurface::client;
@@ -68,6 +71,7 @@ private:
 
     mw::Weak<WindowWlSurfaceRole> window_role_;
     WlSurface* const surface;
+    std::experimental::optional<uint32_t> unacked_serial;
 
 public:
     XdgShellStable const& xdg_shell;
@@ -103,11 +107,18 @@ public:
                        geometry::Size const& new_size) override;
     void handle_close_request() override;
 
+    /// Called when the client acks the outstanding configure
+    void handle_configure_acked();
+
 private:
     static XdgToplevelStable* from(wl_resource* surface);
     void send_toplevel_configure();
 
     XdgSurfaceStable* const xdg_surface;
+
+    /// Set when a configure was requested while the previous one was unacked. The state sent once the client catches
+    /// up is whatever is current at that point, so any number of intermediate resizes collapse into one configure.
+    bool configure_pending{false};
 };
 
 class XdgPositionerStable : public mw::XdgPositioner, public shell::SurfaceSpecification
@@ -251,13 +262,23 @@ void mf::XdgSurfaceStable::set_window_geometry(int32_t x, int32_t y, int32_t wid
 
 void mf::XdgSurfaceStable::ack_configure(uint32_t serial)
 {
-    (void)serial;
-    // TODO
+    // Only the most recent configure is ever outstanding, so an ack for anything else is stale
+    if (!unacked_serial || unacked_serial.value() != serial)
+        return;
+
+    unacked_serial = std::experimental::nullopt;
+
+    if (window_role_)
+    {
+        if (auto const toplevel = dynamic_cast<XdgToplevelStable*>(&window_role_.value()))
+            toplevel->handle_configure_acked();
+    }
 }
 
 void mf::XdgSurfaceStable::send_configure()
 {
     auto const serial = wl_display_next_serial(wl_client_get_display(mw::XdgSurface::client));
+    unacked_serial = serial;
     send_configure_event(serial);
 }
 
@@ -517,8 +538,24 @@ void mf::XdgToplevelStable::handle_close_request()
     send_close_event();
 }
 
+void mf::XdgToplevelStable::handle_configure_acked()
+{
+    if (configure_pending)
+        send_toplevel_configure();
+}
+
 void mf::XdgToplevelStable::send_toplevel_configure()
 {
+    // During an interactive resize the shell changes the size on every pointer motion. Sending each of those to a
+    // client that is still busy with an earlier configure just queues up stale work, so hold back until it acks.
+    if (xdg_surface->awaiting_ack())
+    {
+        configure_pending = true;
+        return;
+    }
+
+    configure_pending = false;
+
     wl_array states;
     wl_array_init(&states);
 
@@ -51,6 +51,37 @@
 namespace mg = mir::graphics;
 namespace ml = mir::logging;
 namespace mgn = mir::graphics::nested;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto parse_output_sizes(std::string const& sizes) -> std::vector<geom::Size>
+{
+    std::vector<geom::Size> result;
+    std::istringstream in{sizes};
+
+    for (std::string size; std::getline(in, size, ',');)
+    {
+        std::istringstream size_in{size};
+        int width{0}, height{0};
+        char x{0};
+
+        if (!(size_in >> width >> x >> height) || x != 'x' || width <= 0 || height <= 0 || !size_in.eof())
+        {
+            BOOST_THROW_EXCEPTION(mir::AbnormalExit(
+                "Invalid output size \"" + size + "\" in --" +
+                mir::options::offscreen_outputs_opt + " (expected <width>x<height>)"));
+        }
+
+        result.emplace_back(width, height);
+    }
+
+    if (result.empty())
+        BOOST_THROW_EXCEPTION(mir::AbnormalExit(std::string{"No outputs given in --"} + mir::options::offscreen_outputs_opt));
+
+    return result;
+}
+}
 
 std::shared_ptr<mg::DisplayConfigurationPolicy>
 mir::DefaultServerConfiguration::the_display_configuration_policy()
@@ -160,8 +191,11 @@ mir::DefaultServerConfiguration::the_display()
                 {
                     return std::make_shared<mg::offscreen::Display>(
                         egl_access->egl_native_display(),
+                        parse_output_sizes(the_options()->get<std::string>(options::offscreen_outputs_opt)),
                         the_display_configuration_policy(),
-                        the_display_report());
+                        the_display_report(),
+                        the_clock(),
+                        the_options()->get<double>(options::offscreen_refresh_rate_opt));
                 }
                 else
                 {
@@ -22,16 +22,34 @@
 #include "mir/graphics/egl_error.h"
 #include "mir/graphics/virtual_output.h"
 #include "mir/geometry/size.h"
+#include "mir/time/steady_clock.h"
+#include "mir/time/virtual_clock.h"
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
+#include <thread>
 
 namespace mg = mir::graphics;
 namespace mgo = mg::offscreen;
 namespace geom = mir::geometry;
+namespace mt = mir::time;
 
 namespace
 {
+// How long, in real time, to wait for a virtual clock to reach a vblank
+// before posting anyway: nothing may be left to step the clock.
+std::chrono::seconds const virtual_vblank_timeout{1};
+
+mt::Duration frame_period_for(double refresh_rate)
+{
+    if (refresh_rate < 0)
+        BOOST_THROW_EXCEPTION(std::invalid_argument{"Refresh rate must not be negative"});
+
+    if (refresh_rate == 0)
+        return mt::Duration::zero();
+
+    return std::chrono::duration_cast<mt::Duration>(std::chrono::duration<double>{1.0 / refresh_rate});
+}
 
 mgo::detail::EGLDisplayHandle
 create_and_initialize_display(EGLNativeDisplayType egl_native_display)
@@ -82,8 +100,14 @@ mgo::detail::EGLDisplayHandle::~EGLDisplayHandle() noexcept
         eglTerminate(egl_display);
 }
 
-mgo::detail::DisplaySyncGroup::DisplaySyncGroup(std::unique_ptr<mg::DisplayBuffer> output) :
-    output(std::move(output))
+mgo::detail::DisplaySyncGroup::DisplaySyncGroup(
+    std::unique_ptr<mg::DisplayBuffer> output,
+    std::shared_ptr<mt::Clock> const& clock,
+    mt::Duration frame_period) :
+    output(std::move(output)),
+    clock{clock},
+    frame_period{frame_period},
+    last_vblank{clock->now()}
 {
 }
 
@@ -95,6 +119,21 @@ void mgo::detail::DisplaySyncGroup::for_each_display_buffer(
 
 void mgo::detail::DisplaySyncGroup::post()
 {
+    if (frame_period == mt::Duration::zero())
+        return;
+
+    // Post at the first vblank we haven't already posted at or missed
+    auto const now = clock->now();
+    auto next_vblank = last_vblank + frame_period;
+    if (next_vblank < now)
+        next_vblank += ((now - next_vblank) / frame_period + 1) * frame_period;
+
+    if (auto const virtual_clock = std::dynamic_pointer_cast<mt::VirtualClock>(clock))
+        virtual_clock->wait_until(next_vblank, virtual_vblank_timeout);
+    else
+        std::this_thread::sleep_for(clock->min_wait_until(next_vblank));
+
+    last_vblank = next_vblank;
 }
 
 std::chrono::milliseconds
@@ -105,11 +144,31 @@ mgo::detail::DisplaySyncGroup::recommended_sleep() const
 
 mgo::Display::Display(
     EGLNativeDisplayType egl_native_display,
+    std::vector<geom::Size> const& output_sizes,
+    std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+    std::shared_ptr<DisplayReport> const& listener)
+    : Display(
+        egl_native_display,
+        output_sizes,
+        initial_conf_policy,
+        listener,
+        std::make_shared<mt::SteadyClock>(),
+        0)
+{
+}
+
+mgo::Display::Display(
+    EGLNativeDisplayType egl_native_display,
+    std::vector<geom::Size> const& output_sizes,
     std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
-    std::shared_ptr<DisplayReport> const&)
+    std::shared_ptr<DisplayReport> const&,
+    std::shared_ptr<mt::Clock> const& clock,
+    double refresh_rate)
     : egl_display{create_and_initialize_display(egl_native_display)},
       egl_context_shared{egl_display, EGL_NO_CONTEXT},
-      current_display_configuration{geom::Size{1024,768}}
+      current_display_configuration{output_sizes},
+      clock{clock},
+      frame_period{frame_period_for(refresh_rate)}
 {
     /*
      * Make the shared context current. This needs to be done before we configure()
@@ -165,7 +224,8 @@ void mgo::Display::configure(mg::DisplayConfiguration const& conf)
                     output.extents()};
 
                 display_sync_groups.emplace_back(
-                    new mgo::detail::DisplaySyncGroup(std::unique_ptr<mg::DisplayBuffer>(raw_db)));
+                    new mgo::detail::DisplaySyncGroup(
+                        std::unique_ptr<mg::DisplayBuffer>(raw_db), clock, frame_period));
             }
         });
 }
@@ -23,6 +23,7 @@
 #include "display_configuration.h"
 #include "mir/graphics/surfaceless_egl_context.h"
 #include "mir/renderer/gl/context_source.h"
+#include "mir/time/clock.h"
 
 #include <mutex>
 #include <vector>
@@ -62,12 +63,18 @@ private:
 class DisplaySyncGroup : public graphics::DisplaySyncGroup
 {
 public:
-    DisplaySyncGroup(std::unique_ptr<DisplayBuffer> output);
+    DisplaySyncGroup(
+        std::unique_ptr<DisplayBuffer> output,
+        std::shared_ptr<time::Clock> const& clock,
+        time::Duration frame_period);
     void for_each_display_buffer(std::function<void(DisplayBuffer&)> const&) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
 private:
     std::unique_ptr<DisplayBuffer> const output;
+    std::shared_ptr<time::Clock> const clock;
+    time::Duration const frame_period;
+    time::Timestamp last_vblank;
 };
 
 }
@@ -78,8 +85,20 @@ class Display : public graphics::Display,
 {
 public:
     Display(EGLNativeDisplayType egl_native_display,
+            std::vector<geometry::Size> const& output_sizes,
             std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
             std::shared_ptr<DisplayReport> const& listener);
+    /**
+     * As above, but simulating vsync: each output posts its frames at the next
+     * vblank of a \a refresh_rate (in Hz) display, as timed by \a clock.
+     * A refresh_rate of 0 posts frames as soon as they are rendered.
+     */
+    Display(EGLNativeDisplayType egl_native_display,
+            std::vector<geometry::Size> const& output_sizes,
+            std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+            std::shared_ptr<DisplayReport> const& listener,
+            std::shared_ptr<time::Clock> const& clock,
+            double refresh_rate);
     ~Display() noexcept;
 
     void for_each_display_sync_group(std::function<void(DisplaySyncGroup&)> const& f) override;
@@ -112,6 +131,8 @@ private:
     SurfacelessEGLContext const egl_context_shared;
     mutable std::mutex configuration_mutex;
     DisplayConfiguration current_display_configuration;
+    std::shared_ptr<time::Clock> const clock;
+    time::Duration const frame_period;
     std::vector<std::unique_ptr<DisplaySyncGroup>> display_sync_groups;
 };
 
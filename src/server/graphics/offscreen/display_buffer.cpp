@@ -28,10 +28,31 @@
 
 namespace mg = mir::graphics;
 namespace mgo = mg::offscreen;
+namespace mrs = mir::renderer::software;
 namespace geom = mir::geometry;
 
 namespace
 {
+template<typename T>
+class PixelMapping : public mrs::Mapping<T>
+{
+public:
+    PixelMapping(T* data, geom::Size const& size)
+        : data_{data},
+          size_{size}
+    {
+    }
+
+    MirPixelFormat format() const override { return mir_pixel_format_xrgb_8888; }
+    geom::Stride stride() const override { return geom::Stride{size_.width.as_int() * 4}; }
+    geom::Size size() const override { return size_; }
+    T* data() override { return data_; }
+    size_t len() const override { return stride().as_uint32_t() * size_.height.as_uint32_t(); }
+
+private:
+    T* const data_;
+    geom::Size const size_;
+};
 
 class GLExtensions : public mg::GLExtensionsBase
 {
@@ -120,7 +141,8 @@ mgo::DisplayBuffer::DisplayBuffer(SurfacelessEGLContext egl_context,
                                   geom::Rectangle const& area)
     : egl_context{std::move(egl_context)},
       fbo{area.size},
-      area(area)
+      area(area),
+      pixels(std::size_t{area.size.width.as_uint32_t()} * area.size.height.as_uint32_t())
 {
 }
 
@@ -164,3 +186,19 @@ mg::NativeDisplayBuffer* mgo::DisplayBuffer::native_display_buffer()
 {
     return this;
 }
+
+auto mgo::DisplayBuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>>
+{
+    return map_rw();
+}
+
+auto mgo::DisplayBuffer::map_readable() -> std::unique_ptr<mrs::Mapping<unsigned char const>>
+{
+    return std::make_unique<PixelMapping<unsigned char const>>(
+        reinterpret_cast<unsigned char const*>(pixels.data()), area.size);
+}
+
+auto mgo::DisplayBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsigned char>>
+{
+    return std::make_unique<PixelMapping<unsigned char>>(reinterpret_cast<unsigned char*>(pixels.data()), area.size);
+}
@@ -25,9 +25,13 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/renderer/gl/render_target.h"
+#include "mir/renderer/sw/pixel_source.h"
 
 #include <EGL/egl.h>
 
+#include <cstdint>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -57,9 +61,14 @@ private:
 
 }
 
+/**
+ * An output drawn into an FBO by GL or, when composited in software (with
+ * --software-compositing), into memory that can be mapped.
+ */
 class DisplayBuffer : public graphics::DisplayBuffer,
                       public graphics::NativeDisplayBuffer,
-                      public renderer::gl::RenderTarget
+                      public renderer::gl::RenderTarget,
+                      public renderer::software::RWMappableBuffer
 {
 public:
     DisplayBuffer(SurfacelessEGLContext egl_context,
@@ -73,10 +82,17 @@ public:
     void bind() override;
     void release_current() override;
     void swap_buffers() override;
+
+    auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
+    auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
+    auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
+
 private:
     SurfacelessEGLContext const egl_context;
     detail::GLFramebufferObject const fbo;
     geometry::Rectangle const area;
+    /// Frames composited in software, as xrgb_8888
+    std::vector<uint32_t> pixels;
 };
 
 }
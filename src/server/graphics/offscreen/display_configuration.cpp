@@ -21,34 +21,46 @@ namespace mgo = mg::offscreen;
 namespace geom = mir::geometry;
 
 mgo::DisplayConfiguration::DisplayConfiguration(geom::Size const& display_size)
-        : output{mg::DisplayConfigurationOutputId{1},
-                 mg::DisplayConfigurationCardId{0},
-                 mg::DisplayConfigurationOutputType::lvds,
-                 {mir_pixel_format_xrgb_8888},
-                 {mg::DisplayConfigurationMode{display_size,0.0f}},
-                 0,
-                 geom::Size{0,0},
-                 true,
-                 true,
-                 geom::Point{0,0},
-                 0,
-                 mir_pixel_format_xrgb_8888,
-                 mir_power_mode_on,
-                 mir_orientation_normal,
-                 1.0f,
-                 mir_form_factor_monitor,
-                 mir_subpixel_arrangement_unknown,
-                 {},
-                 mir_output_gamma_unsupported,
-                 {},
-                 {}},
-          card{mg::DisplayConfigurationCardId{0}, 1}
+    : DisplayConfiguration{std::vector<geom::Size>{display_size}}
 {
 }
 
+mgo::DisplayConfiguration::DisplayConfiguration(std::vector<geom::Size> const& output_sizes)
+    : card{mg::DisplayConfigurationCardId{0}, output_sizes.size()}
+{
+    geom::X x{0};
+    for (auto const& size : output_sizes)
+    {
+        outputs.push_back({
+            mg::DisplayConfigurationOutputId{static_cast<int>(outputs.size()) + 1},
+            mg::DisplayConfigurationCardId{0},
+            mg::DisplayConfigurationOutputType::lvds,
+            {mir_pixel_format_xrgb_8888},
+            {mg::DisplayConfigurationMode{size,0.0f}},
+            0,
+            geom::Size{0,0},
+            true,
+            true,
+            geom::Point{x,0},
+            0,
+            mir_pixel_format_xrgb_8888,
+            mir_power_mode_on,
+            mir_orientation_normal,
+            1.0f,
+            mir_form_factor_monitor,
+            mir_subpixel_arrangement_unknown,
+            {},
+            mir_output_gamma_unsupported,
+            {},
+            {}});
+
+        x += as_delta(size.width);
+    }
+}
+
 mgo::DisplayConfiguration::DisplayConfiguration(DisplayConfiguration const& other)
     : mg::DisplayConfiguration(),
-      output(other.output),
+      outputs(other.outputs),
       card(other.card)
 {
 }
@@ -58,7 +70,7 @@ mgo::DisplayConfiguration::operator=(DisplayConfiguration const& other)
 {
     if (&other != this)
     {
-        output = other.output;
+        outputs = other.outputs;
         card = other.card;
     }
     return *this;
@@ -73,14 +85,18 @@ void mgo::DisplayConfiguration::for_each_card(
 void mgo::DisplayConfiguration::for_each_output(
     std::function<void(mg::DisplayConfigurationOutput const&)> f) const
 {
-    f(output);
+    for (auto const& output : outputs)
+        f(output);
 }
 
 void mgo::DisplayConfiguration::for_each_output(
     std::function<void(mg::UserDisplayConfigurationOutput&)> f)
 {
-    mg::UserDisplayConfigurationOutput user(output);
-    f(user);
+    for (auto& output : outputs)
+    {
+        mg::UserDisplayConfigurationOutput user(output);
+        f(user);
+    }
 }
 
 std::unique_ptr<mg::DisplayConfiguration> mgo::DisplayConfiguration::clone() const
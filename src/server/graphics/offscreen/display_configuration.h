@@ -19,6 +19,8 @@
 
 #include "mir/graphics/display_configuration.h"
 
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -30,6 +32,8 @@ class DisplayConfiguration : public graphics::DisplayConfiguration
 {
 public:
     DisplayConfiguration(geometry::Size const& display_size);
+    /// Outputs of the given sizes, left to right
+    explicit DisplayConfiguration(std::vector<geometry::Size> const& output_sizes);
     DisplayConfiguration(DisplayConfiguration const& other);
     DisplayConfiguration& operator=(DisplayConfiguration const& other);
 
@@ -39,7 +43,7 @@ public:
     std::unique_ptr<graphics::DisplayConfiguration> clone() const override;
 
 private:
-    DisplayConfigurationOutput output;
+    std::vector<DisplayConfigurationOutput> outputs;
     DisplayConfigurationCard card;
 };
 
@@ -26,6 +26,7 @@
 #include "mir/geometry/rectangle.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/size.h"
+#include "mir/trace/recorder.h"
 #include "mir_toolkit/common.h"
 
 #include <algorithm>
@@ -201,6 +202,7 @@ void mi::BasicSeat::remove_device(input::Device const& device)
 
 void mi::BasicSeat::dispatch_event(std::shared_ptr<MirEvent> const& event)
 {
+    MIR_TRACE_SCOPE("input", "dispatch_event");
     input_state_tracker.dispatch(event);
 }
 
@@ -29,6 +29,8 @@
 #include "builtin_cursor_images.h"
 #include "default_input_device_hub.h"
 #include "default_input_manager.h"
+#include "input_recorder.h"
+#include "replay_input_platform.h"
 #include "surface_input_dispatcher.h"
 #include "basic_seat.h"
 #include "seat_observer_multiplexer.h"
@@ -123,7 +125,7 @@ mir::DefaultServerConfiguration::the_surface_input_dispatcher()
     return surface_input_dispatcher(
         [this]()
         {
-            return std::make_shared<mi::SurfaceInputDispatcher>(the_input_scene());
+            return std::make_shared<mi::SurfaceInputDispatcher>(the_input_scene(), the_clock());
         });
 }
 
@@ -141,7 +143,7 @@ mir::DefaultServerConfiguration::the_input_dispatcher()
             auto enable_repeat = options->get<bool>(options::enable_key_repeat_opt);
 
             return std::make_shared<mi::KeyRepeatDispatcher>(
-                the_event_filter_chain_dispatcher(), the_main_loop(), the_cookie_authority(),
+                the_event_filter_chain_dispatcher(), the_main_loop(), the_clock(), the_cookie_authority(),
                 enable_repeat, key_repeat_timeout, key_repeat_delay, false);
         });
 }
@@ -223,8 +225,26 @@ mir::DefaultServerConfiguration::the_input_manager()
             }
             else
             {
+                std::shared_ptr<mi::InputDeviceRegistry> device_registry = the_input_device_registry();
+                if (options->is_set(options::record_input_opt))
+                {
+                    device_registry = std::make_shared<mi::RecordingInputDeviceRegistry>(
+                        device_registry,
+                        std::make_shared<mi::InputRecorder>(options->get<std::string>(options::record_input_opt)));
+                }
+
+                // A replayed session stands in for the real devices
+                if (options->is_set(options::replay_input_opt))
+                {
+                    return std::make_shared<mi::DefaultInputManager>(
+                        the_input_reading_multiplexer(),
+                        std::make_shared<mi::ReplayPlatform>(
+                            options->get<std::string>(options::replay_input_opt),
+                            device_registry,
+                            options->get<double>(options::replay_input_speed_opt)));
+                }
+
                 auto const emergency_cleanup = the_emergency_cleanup();
-                auto const device_registry = the_input_device_registry();
                 auto const input_report = the_input_report();
 
                 // Maybe the graphics platform also supplies input (e.g. x11 or wayland)
@@ -0,0 +1,289 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_recorder.h"
+
+#include "mir/input/input_device.h"
+#include "mir/input/input_device_info.h"
+#include "mir/input/input_sink.h"
+#include "mir/input/pointer_settings.h"
+#include "mir/input/touchpad_settings.h"
+#include "mir/input/touchscreen_settings.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <locale>
+#include <system_error>
+
+namespace mi = mir::input;
+
+namespace
+{
+// Buffered, but a crash shouldn't lose more than this much of the session
+std::chrono::seconds const flush_interval{1};
+}
+
+mi::InputRecorder::InputRecorder(std::string const& path)
+    : out{path},
+      start{std::chrono::steady_clock::now()},
+      last_flush{start}
+{
+    if (!out)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to open input recording " + path}));
+
+    out.imbue(std::locale::classic());
+    out << std::setprecision(std::numeric_limits<float>::max_digits10);
+    out << "mir-input-recording 1\n";
+}
+
+mi::InputRecorder::~InputRecorder() = default;
+
+auto mi::InputRecorder::device_added(InputDeviceInfo const& info) -> int
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const device = next_device++;
+    start_record("device", device)
+        << ' ' << info.capabilities.value()
+        << ' ' << std::quoted(info.name)
+        << ' ' << std::quoted(info.unique_id);
+    end_record();
+
+    return device;
+}
+
+void mi::InputRecorder::device_removed(int device)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    start_record("removed", device);
+    end_record();
+}
+
+void mi::InputRecorder::event_received(int device, MirEvent const& event)
+{
+    // Device state events are derived from the input events, so don't need recording
+    if (mir_event_get_type(&event) != mir_event_type_input)
+        return;
+
+    auto const input_event = mir_event_get_input_event(&event);
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    switch (mir_input_event_get_type(input_event))
+    {
+    case mir_input_event_type_key:
+    {
+        auto const key = mir_input_event_get_keyboard_event(input_event);
+        start_record("key", device)
+            << ' ' << mir_keyboard_event_action(key)
+            << ' ' << mir_keyboard_event_key_code(key)
+            << ' ' << mir_keyboard_event_scan_code(key);
+        break;
+    }
+
+    case mir_input_event_type_pointer:
+    {
+        auto const pointer = mir_input_event_get_pointer_event(input_event);
+        auto& record = start_record("pointer", device)
+            << ' ' << mir_pointer_event_action(pointer)
+            << ' ' << mir_pointer_event_buttons(pointer);
+        for (auto const axis : {mir_pointer_axis_x, mir_pointer_axis_y,
+                                mir_pointer_axis_hscroll, mir_pointer_axis_vscroll,
+                                mir_pointer_axis_relative_x, mir_pointer_axis_relative_y})
+        {
+            record << ' ' << mir_pointer_event_axis_value(pointer, axis);
+        }
+        break;
+    }
+
+    case mir_input_event_type_touch:
+    {
+        auto const touch = mir_input_event_get_touch_event(input_event);
+        auto const count = mir_touch_event_point_count(touch);
+        auto& record = start_record("touch", device) << ' ' << count;
+        for (auto i = 0u; i != count; ++i)
+        {
+            record << ' ' << mir_touch_event_id(touch, i)
+                   << ' ' << mir_touch_event_action(touch, i)
+                   << ' ' << mir_touch_event_tooltype(touch, i);
+            // Orientation isn't available through the event API (nor used by the server)
+            for (auto const axis : {mir_touch_axis_x, mir_touch_axis_y, mir_touch_axis_pressure,
+                                    mir_touch_axis_touch_major, mir_touch_axis_touch_minor})
+            {
+                record << ' ' << mir_touch_event_axis_value(touch, i, axis);
+            }
+        }
+        break;
+    }
+
+    default:
+        return;
+    }
+
+    end_record();
+}
+
+auto mi::InputRecorder::start_record(char const* type, int device) -> std::ostream&
+{
+    auto const t = std::chrono::steady_clock::now() - start;
+    return out << std::chrono::duration_cast<std::chrono::nanoseconds>(t).count() << ' ' << type << ' ' << device;
+}
+
+void mi::InputRecorder::end_record()
+{
+    out << '\n';
+
+    auto const now = std::chrono::steady_clock::now();
+    if (now - last_flush >= flush_interval)
+    {
+        out.flush();
+        last_flush = now;
+    }
+}
+
+/// Forwards everything to the real device, but sees the events it sends
+class mi::RecordingInputDeviceRegistry::RecordingDevice : public InputDevice, public InputSink
+{
+public:
+    RecordingDevice(std::shared_ptr<InputDevice> const& device, std::shared_ptr<InputRecorder> const& recorder)
+        : device{device},
+          recorder{recorder},
+          id{recorder->device_added(device->get_device_info())}
+    {
+    }
+
+    std::shared_ptr<InputDevice> const device;
+    std::shared_ptr<InputRecorder> const recorder;
+    int const id;
+
+    void start(InputSink* destination, EventBuilder* builder) override
+    {
+        sink = destination;
+        device->start(this, builder);
+    }
+
+    void stop() override
+    {
+        device->stop();
+        sink = nullptr;
+    }
+
+    auto get_device_info() -> InputDeviceInfo override
+    {
+        return device->get_device_info();
+    }
+
+    auto get_pointer_settings() const -> optional_value<PointerSettings> override
+    {
+        return device->get_pointer_settings();
+    }
+
+    void apply_settings(PointerSettings const& settings) override
+    {
+        device->apply_settings(settings);
+    }
+
+    auto get_touchpad_settings() const -> optional_value<TouchpadSettings> override
+    {
+        return device->get_touchpad_settings();
+    }
+
+    void apply_settings(TouchpadSettings const& settings) override
+    {
+        device->apply_settings(settings);
+    }
+
+    auto get_touchscreen_settings() const -> optional_value<TouchscreenSettings> override
+    {
+        return device->get_touchscreen_settings();
+    }
+
+    void apply_settings(TouchscreenSettings const& settings) override
+    {
+        device->apply_settings(settings);
+    }
+
+    void handle_input(std::shared_ptr<MirEvent> const& event) override
+    {
+        recorder->event_received(id, *event);
+        sink->handle_input(event);
+    }
+
+    auto bounding_rectangle() const -> geometry::Rectangle override
+    {
+        return sink->bounding_rectangle();
+    }
+
+    auto output_info(uint32_t output_id) const -> OutputInfo override
+    {
+        return sink->output_info(output_id);
+    }
+
+    void key_state(std::vector<uint32_t> const& scan_codes) override
+    {
+        sink->key_state(scan_codes);
+    }
+
+    void pointer_state(MirPointerButtons buttons) override
+    {
+        sink->pointer_state(buttons);
+    }
+
+private:
+    InputSink* sink{nullptr};
+};
+
+mi::RecordingInputDeviceRegistry::RecordingInputDeviceRegistry(
+    std::shared_ptr<InputDeviceRegistry> const& registry,
+    std::shared_ptr<InputRecorder> const& recorder)
+    : registry{registry},
+      recorder{recorder}
+{
+}
+
+void mi::RecordingInputDeviceRegistry::add_device(std::shared_ptr<InputDevice> const& device)
+{
+    auto const recording_device = std::make_shared<RecordingDevice>(device, recorder);
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        devices.push_back(recording_device);
+    }
+
+    registry->add_device(recording_device);
+}
+
+void mi::RecordingInputDeviceRegistry::remove_device(std::shared_ptr<InputDevice> const& device)
+{
+    std::shared_ptr<RecordingDevice> recording_device;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto const i = std::find_if(devices.begin(), devices.end(),
+            [&](std::shared_ptr<RecordingDevice> const& candidate) { return candidate->device == device; });
+
+        if (i == devices.end())
+            BOOST_THROW_EXCEPTION(std::logic_error("Input device not managed by server"));
+
+        recording_device = *i;
+        devices.erase(i);
+    }
+
+    recorder->device_removed(recording_device->id);
+    registry->remove_device(recording_device);
+}
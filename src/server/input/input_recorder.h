@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_INPUT_RECORDER_H_
+#define MIR_INPUT_INPUT_RECORDER_H_
+
+#include "mir/input/input_device_registry.h"
+#include "mir_toolkit/event.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace input
+{
+struct InputDeviceInfo;
+
+/**
+ * Writes the events input devices hand to the server to a file that
+ * ReplayPlatform can play back.
+ *
+ * The file is text, one record per line, each starting with the nanoseconds
+ * since recording started and the record type:
+ *
+ *     mir-input-recording 1
+ *     <t> device <device> <capabilities> "<name>" "<unique id>"
+ *     <t> removed <device>
+ *     <t> key <device> <action> <keysym> <scan code>
+ *     <t> pointer <device> <action> <buttons> <x> <y> <hscroll> <vscroll> <dx> <dy>
+ *     <t> touch <device> <count> {<id> <action> <tooltype> <x> <y> <pressure> <major> <minor>}...
+ *
+ * Devices are numbered by the recording, as the ids the server gives them
+ * need not be the same on replay.
+ */
+class InputRecorder
+{
+public:
+    explicit InputRecorder(std::string const& path);
+    ~InputRecorder();
+
+    /// \returns the number identifying the device in the recording
+    auto device_added(InputDeviceInfo const& info) -> int;
+    void device_removed(int device);
+    void event_received(int device, MirEvent const& event);
+
+private:
+    InputRecorder(InputRecorder const&) = delete;
+    InputRecorder& operator=(InputRecorder const&) = delete;
+
+    auto start_record(char const* type, int device) -> std::ostream&;
+    void end_record();
+
+    std::mutex mutex;
+    std::ofstream out;
+    std::chrono::steady_clock::time_point const start;
+    std::chrono::steady_clock::time_point last_flush;
+    int next_device{0};
+};
+
+/**
+ * Interposes between an input platform and the server's InputDeviceRegistry
+ * so that the events from every device the platform adds are recorded.
+ */
+class RecordingInputDeviceRegistry : public InputDeviceRegistry
+{
+public:
+    RecordingInputDeviceRegistry(
+        std::shared_ptr<InputDeviceRegistry> const& registry,
+        std::shared_ptr<InputRecorder> const& recorder);
+
+    void add_device(std::shared_ptr<InputDevice> const& device) override;
+    void remove_device(std::shared_ptr<InputDevice> const& device) override;
+
+private:
+    class RecordingDevice;
+
+    std::shared_ptr<InputDeviceRegistry> const registry;
+    std::shared_ptr<InputRecorder> const recorder;
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<RecordingDevice>> devices;
+};
+}
+}
+
+#endif // MIR_INPUT_INPUT_RECORDER_H_
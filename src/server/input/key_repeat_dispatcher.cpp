@@ -22,6 +22,7 @@
 #include "mir/input/input_device_hub.h"
 #include "mir/time/alarm_factory.h"
 #include "mir/time/alarm.h"
+#include "mir/time/clock.h"
 #include "mir/events/event_builders.h"
 #include "mir/cookie/authority.h"
 
@@ -91,6 +92,7 @@ auto is_meta_key(MirKeyboardEvent const* event) -> bool
 mi::KeyRepeatDispatcher::KeyRepeatDispatcher(
     std::shared_ptr<mi::InputDispatcher> const& next_dispatcher,
     std::shared_ptr<mir::time::AlarmFactory> const& factory,
+    std::shared_ptr<mir::time::Clock> const& clock,
     std::shared_ptr<mir::cookie::Authority> const& cookie_authority,
     bool repeat_enabled,
     std::chrono::milliseconds repeat_timeout,
@@ -98,6 +100,7 @@ mi::KeyRepeatDispatcher::KeyRepeatDispatcher(
     bool disable_repeat_on_touchscreen)
     : next_dispatcher(next_dispatcher),
       alarm_factory(factory),
+      clock(clock),
       cookie_authority(cookie_authority),
       repeat_enabled(repeat_enabled),
       repeat_timeout(repeat_timeout),
@@ -190,12 +193,13 @@ bool mi::KeyRepeatDispatcher::handle_key_input(MirInputDeviceId id, MirKeyboardE
         }
 
         auto clone_event = [scan_code, id,
+             clock=clock,
              cookie_authority=cookie_authority,
              next_dispatcher=next_dispatcher,
              key_code = mir_keyboard_event_key_code(kev),
              modifiers = mir_keyboard_event_modifiers(kev)]()
              {
-                 auto const now = std::chrono::steady_clock::now().time_since_epoch();
+                 auto const now = clock->now().time_since_epoch();
                  auto const cookie = cookie_authority->make_cookie(now.count());
                  auto new_event = mev::make_event(
                      id,
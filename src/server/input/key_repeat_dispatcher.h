@@ -38,6 +38,7 @@ namespace time
 {
 class AlarmFactory;
 class Alarm;
+class Clock;
 }
 namespace input
 {
@@ -47,6 +48,7 @@ class KeyRepeatDispatcher : public InputDispatcher
 public:
     KeyRepeatDispatcher(std::shared_ptr<InputDispatcher> const& next_dispatcher,
                         std::shared_ptr<time::AlarmFactory> const& factory,
+                        std::shared_ptr<time::Clock> const& clock, /* timestamps the repeats */
                         std::shared_ptr<cookie::Authority> const& cookie_authority,
                         bool repeat_enabled,
                         std::chrono::milliseconds repeat_timeout, /* timeout before sending first repeat */
@@ -67,6 +69,7 @@ private:
 
     std::shared_ptr<InputDispatcher> const next_dispatcher;
     std::shared_ptr<time::AlarmFactory> const alarm_factory;
+    std::shared_ptr<time::Clock> const clock;
     std::shared_ptr<cookie::Authority> const cookie_authority;
     bool const repeat_enabled;
     std::chrono::milliseconds const repeat_timeout;
@@ -0,0 +1,454 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "input-replay"
+
+#include "replay_input_platform.h"
+
+#include "mir/dispatch/readable_fd.h"
+#include "mir/events/contact_state.h"
+#include "mir/input/event_builder.h"
+#include "mir/input/input_device.h"
+#include "mir/input/input_device_info.h"
+#include "mir/input/input_device_registry.h"
+#include "mir/input/input_sink.h"
+#include "mir/input/pointer_settings.h"
+#include "mir/input/touchpad_settings.h"
+#include "mir/input/touchscreen_settings.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+#include <system_error>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace mi = mir::input;
+namespace md = mir::dispatch;
+
+namespace
+{
+// When replaying as fast as possible, let the rest of the input thread's work in between batches
+size_t const records_per_batch = 64;
+
+auto constexpr header = "mir-input-recording 1";
+}
+
+struct mi::ReplayPlatform::Record
+{
+    enum class Type { device, removed, key, pointer, touch };
+
+    std::chrono::nanoseconds time{0};
+    Type type{Type::device};
+    int device{0};
+
+    InputDeviceInfo info;
+
+    MirKeyboardAction key_action{mir_keyboard_action_up};
+    xkb_keysym_t keysym{0};
+    int scan_code{0};
+
+    MirPointerAction pointer_action{mir_pointer_action_motion};
+    MirPointerButtons buttons{0};
+    float x{0}, y{0}, hscroll{0}, vscroll{0}, dx{0}, dy{0};
+
+    std::vector<events::ContactState> contacts;
+};
+
+/// A device that sends whatever the recording says it did
+class mi::ReplayPlatform::Device : public InputDevice
+{
+public:
+    explicit Device(InputDeviceInfo const& info)
+        : info{info}
+    {
+    }
+
+    void start(InputSink* destination, EventBuilder* event_builder) override
+    {
+        sink = destination;
+        builder = event_builder;
+    }
+
+    void stop() override
+    {
+        sink = nullptr;
+        builder = nullptr;
+    }
+
+    auto get_device_info() -> InputDeviceInfo override
+    {
+        return info;
+    }
+
+    // The recorded events already have the original device's settings applied
+    auto get_pointer_settings() const -> optional_value<PointerSettings> override
+    {
+        optional_value<PointerSettings> settings;
+        if (contains(info.capabilities, DeviceCapability::pointer))
+            settings = PointerSettings{};
+        return settings;
+    }
+
+    void apply_settings(PointerSettings const&) override
+    {
+    }
+
+    auto get_touchpad_settings() const -> optional_value<TouchpadSettings> override
+    {
+        optional_value<TouchpadSettings> settings;
+        if (contains(info.capabilities, DeviceCapability::touchpad))
+            settings = TouchpadSettings{};
+        return settings;
+    }
+
+    void apply_settings(TouchpadSettings const&) override
+    {
+    }
+
+    auto get_touchscreen_settings() const -> optional_value<TouchscreenSettings> override
+    {
+        optional_value<TouchscreenSettings> settings;
+        if (contains(info.capabilities, DeviceCapability::touchscreen))
+            settings = TouchscreenSettings{};
+        return settings;
+    }
+
+    void apply_settings(TouchscreenSettings const&) override
+    {
+    }
+
+    void replay(Record const& record)
+    {
+        if (!sink)
+            return;
+
+        auto const now = std::chrono::duration_cast<EventBuilder::Timestamp>(Clock::now().time_since_epoch());
+
+        switch (record.type)
+        {
+        case Record::Type::key:
+            sink->handle_input(builder->key_event(now, record.key_action, record.keysym, record.scan_code));
+            break;
+
+        case Record::Type::pointer:
+            sink->handle_input(builder->pointer_event(
+                now, record.pointer_action, record.buttons,
+                record.x, record.y, record.hscroll, record.vscroll, record.dx, record.dy));
+            break;
+
+        case Record::Type::touch:
+            sink->handle_input(builder->touch_event(now, record.contacts));
+            break;
+
+        default:
+            break;
+        }
+    }
+
+private:
+    InputDeviceInfo const info;
+    InputSink* sink{nullptr};
+    EventBuilder* builder{nullptr};
+};
+
+namespace
+{
+template<typename Enum>
+auto read_enum(std::istream& in) -> Enum
+{
+    int value{0};
+    in >> value;
+    return static_cast<Enum>(value);
+}
+
+auto parse_record(std::string const& line) -> mi::ReplayPlatform::Record
+{
+    using Record = mi::ReplayPlatform::Record;
+
+    std::istringstream in{line};
+    in.imbue(std::locale::classic());
+
+    Record record;
+    int64_t nsec{0};
+    std::string type;
+    in >> nsec >> type >> record.device;
+    record.time = std::chrono::nanoseconds{nsec};
+
+    if (type == "device")
+    {
+        record.type = Record::Type::device;
+        uint32_t capabilities{0};
+        in >> capabilities >> std::quoted(record.info.name) >> std::quoted(record.info.unique_id);
+        record.info.capabilities = mi::DeviceCapabilities{capabilities};
+    }
+    else if (type == "removed")
+    {
+        record.type = Record::Type::removed;
+    }
+    else if (type == "key")
+    {
+        record.type = Record::Type::key;
+        record.key_action = read_enum<MirKeyboardAction>(in);
+        in >> record.keysym >> record.scan_code;
+    }
+    else if (type == "pointer")
+    {
+        record.type = Record::Type::pointer;
+        record.pointer_action = read_enum<MirPointerAction>(in);
+        in >> record.buttons
+           >> record.x >> record.y
+           >> record.hscroll >> record.vscroll
+           >> record.dx >> record.dy;
+    }
+    else if (type == "touch")
+    {
+        record.type = Record::Type::touch;
+        unsigned count{0};
+        in >> count;
+        for (auto i = 0u; in && i != count; ++i)
+        {
+            mir::events::ContactState contact{};
+            in >> contact.touch_id;
+            contact.action = read_enum<MirTouchAction>(in);
+            contact.tooltype = read_enum<MirTouchTooltype>(in);
+            in >> contact.x >> contact.y >> contact.pressure >> contact.touch_major >> contact.touch_minor;
+            record.contacts.push_back(contact);
+        }
+    }
+    else
+    {
+        in.setstate(std::ios::failbit);
+    }
+
+    if (!in)
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Malformed record"});
+
+    return record;
+}
+
+auto read_recording(std::string const& path) -> std::vector<mi::ReplayPlatform::Record>
+{
+    std::ifstream in{path};
+    if (!in)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to open input recording " + path}));
+
+    std::string line;
+    if (!std::getline(in, line) || line != header)
+        BOOST_THROW_EXCEPTION(std::runtime_error{path + " is not an input recording"});
+
+    std::vector<mi::ReplayPlatform::Record> records;
+    for (auto line_number = 2; std::getline(in, line); ++line_number)
+    {
+        if (line.empty())
+            continue;
+
+        try
+        {
+            records.push_back(parse_record(line));
+        }
+        catch (std::runtime_error const&)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error{
+                "Malformed input recording " + path + " at line " + std::to_string(line_number)});
+        }
+    }
+
+    return records;
+}
+
+auto create_timer() -> mir::Fd
+{
+    mir::Fd fd{timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)};
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create input replay timer"}));
+    return fd;
+}
+
+void set_timer(mir::Fd const& timer, timespec const& when, int flags)
+{
+    itimerspec const spec{{0, 0}, when};
+    if (timerfd_settime(timer, flags, &spec, nullptr) < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to set input replay timer"}));
+}
+}
+
+mi::ReplayPlatform::ReplayPlatform(
+    std::string const& path,
+    std::shared_ptr<InputDeviceRegistry> const& registry,
+    double speed)
+    : registry{registry},
+      speed{speed},
+      records{read_recording(path)},
+      timer{create_timer()},
+      timer_dispatchable{std::make_shared<md::ReadableFd>(timer, [this]
+          {
+              uint64_t expirations;
+              if (read(timer, &expirations, sizeof expirations) == sizeof expirations)
+                  replay_due();
+          })},
+      replay_start{Clock::now()},
+      paused_at{replay_start}
+{
+    if (speed < 0)
+        BOOST_THROW_EXCEPTION(std::invalid_argument{"Input replay speed must not be negative"});
+
+    mir::log_info("Replaying %zu input records from %s", records.size(), path.c_str());
+}
+
+mi::ReplayPlatform::~ReplayPlatform() = default;
+
+auto mi::ReplayPlatform::dispatchable() -> std::shared_ptr<dispatch::Dispatchable>
+{
+    return timer_dispatchable;
+}
+
+void mi::ReplayPlatform::start()
+{
+    for (auto const& device : devices)
+        registry->add_device(device.second);
+
+    resume();
+}
+
+void mi::ReplayPlatform::stop()
+{
+    pause();
+
+    for (auto const& device : devices)
+        registry->remove_device(device.second);
+}
+
+void mi::ReplayPlatform::pause_for_config()
+{
+    pause();
+}
+
+void mi::ReplayPlatform::continue_after_config()
+{
+    resume();
+}
+
+void mi::ReplayPlatform::pause()
+{
+    if (!running)
+        return;
+
+    running = false;
+    paused_at = Clock::now();
+    set_timer(timer, {0, 0}, 0);
+}
+
+void mi::ReplayPlatform::resume()
+{
+    if (running)
+        return;
+
+    // Carry on from where we were, rather than catching up on the time spent paused
+    running = true;
+    replay_start += Clock::now() - paused_at;
+    arm_timer();
+}
+
+void mi::ReplayPlatform::replay_due()
+{
+    if (!running)
+        return;
+
+    auto const batch_end = std::min(next_record + records_per_batch, records.size());
+
+    while (next_record != records.size())
+    {
+        auto const& record = records[next_record];
+
+        if (speed == 0)
+        {
+            if (next_record == batch_end)
+                break;
+        }
+        else if (replay_start + std::chrono::duration_cast<Clock::duration>(record.time / speed) > Clock::now())
+        {
+            break;
+        }
+
+        ++next_record;
+        replay(record);
+    }
+
+    if (next_record == records.size())
+    {
+        auto const elapsed = std::chrono::duration<double>(Clock::now() - replay_start);
+        mir::log_info("Finished replaying %zu input records in %.3fs", records.size(), elapsed.count());
+        return;
+    }
+
+    arm_timer();
+}
+
+void mi::ReplayPlatform::replay(Record const& record)
+{
+    switch (record.type)
+    {
+    case Record::Type::device:
+    {
+        auto const device = std::make_shared<Device>(record.info);
+        devices[record.device] = device;
+        registry->add_device(device);
+        break;
+    }
+
+    case Record::Type::removed:
+    {
+        auto const device = devices.find(record.device);
+        if (device != devices.end())
+        {
+            registry->remove_device(device->second);
+            devices.erase(device);
+        }
+        break;
+    }
+
+    default:
+    {
+        auto const device = devices.find(record.device);
+        if (device != devices.end())
+            device->second->replay(record);
+        break;
+    }
+    }
+}
+
+void mi::ReplayPlatform::arm_timer()
+{
+    if (next_record == records.size())
+        return;
+
+    if (speed == 0)
+    {
+        // Fire straight away (a zero it_value would disarm the timer)
+        set_timer(timer, {0, 1}, 0);
+        return;
+    }
+
+    auto const due = replay_start + std::chrono::duration_cast<Clock::duration>(records[next_record].time / speed);
+    auto const nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(due.time_since_epoch()).count();
+    set_timer(timer, {static_cast<time_t>(nsec / 1000000000), static_cast<long>(nsec % 1000000000)}, TFD_TIMER_ABSTIME);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_REPLAY_INPUT_PLATFORM_H_
+#define MIR_INPUT_REPLAY_INPUT_PLATFORM_H_
+
+#include "mir/input/platform.h"
+#include "mir/fd.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace dispatch
+{
+class ReadableFd;
+}
+namespace input
+{
+class InputDeviceRegistry;
+
+/**
+ * An input platform that plays back a file written by InputRecorder.
+ *
+ * Devices are added and removed, and events sent, at the recorded times
+ * divided by \a speed, or as quickly as the input thread can manage if
+ * \a speed is zero. Events are timestamped with the time they are replayed.
+ */
+class ReplayPlatform : public Platform
+{
+public:
+    ReplayPlatform(
+        std::string const& path,
+        std::shared_ptr<InputDeviceRegistry> const& registry,
+        double speed);
+    ~ReplayPlatform();
+
+    auto dispatchable() -> std::shared_ptr<dispatch::Dispatchable> override;
+    void start() override;
+    void stop() override;
+    void pause_for_config() override;
+    void continue_after_config() override;
+
+    /// A line of the recording
+    struct Record;
+
+private:
+    class Device;
+    using Clock = std::chrono::steady_clock;
+
+    void replay_due();
+    void replay(Record const& record);
+    void pause();
+    void resume();
+    void arm_timer();
+
+    std::shared_ptr<InputDeviceRegistry> const registry;
+    double const speed;
+    std::vector<Record> const records;
+    Fd const timer;
+    std::shared_ptr<dispatch::ReadableFd> const timer_dispatchable;
+
+    size_t next_record{0};
+    std::map<int, std::shared_ptr<Device>> devices;
+    bool running{false};
+    Clock::time_point replay_start;
+    Clock::time_point paused_at;
+};
+}
+}
+
+#endif // MIR_INPUT_REPLAY_INPUT_PLATFORM_H_
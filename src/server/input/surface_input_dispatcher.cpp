@@ -24,6 +24,7 @@
 #include "mir/scene/surface.h"
 #include "mir/scene/null_surface_observer.h"
 #include "mir/events/event_builders.h"
+#include "mir/time/clock.h"
 #include "mir_toolkit/mir_cookie.h"
 
 #include <string.h>
@@ -147,8 +148,11 @@ void deliver(
 
 }
 
-mi::SurfaceInputDispatcher::SurfaceInputDispatcher(std::shared_ptr<mi::Scene> const& scene)
+mi::SurfaceInputDispatcher::SurfaceInputDispatcher(
+    std::shared_ptr<mi::Scene> const& scene,
+    std::shared_ptr<time::Clock> const& clock)
     : scene(scene),
+      clock(clock),
       started(false)
 {
     scene_observer = std::make_shared<InputDispatcherSceneObserver>(
@@ -217,12 +221,15 @@ struct SceneChangeContext
     MirPointerEvent const* const pev;
     std::shared_ptr<mi::Surface>& current_target;
     std::shared_ptr<mi::Surface> const target_surface;
+    // For the events synthesized on a scene change
+    std::chrono::nanoseconds const event_time;
 };
 
 SceneChangeContext context_for_event(
     MirEvent const* last_pointer_event,
     std::function<std::shared_ptr<mi::Surface>*(MirInputDeviceId)> const& get_current_target,
-    std::function<std::shared_ptr<mi::Surface>(geom::Point const&)> const& surface_under_point)
+    std::function<std::shared_ptr<mi::Surface>(geom::Point const&)> const& surface_under_point,
+    std::chrono::nanoseconds event_time)
 {
     auto const iev = mir_event_get_input_event(last_pointer_event);
     auto const pev = mir_input_event_get_pointer_event(iev);
@@ -235,7 +242,8 @@ SceneChangeContext context_for_event(
         iev,
         pev,
         *get_current_target(mir_input_event_get_device_id(iev)),
-        surface_under_point(event_x_y)
+        surface_under_point(event_x_y),
+        event_time
     };
 }
 
@@ -260,7 +268,7 @@ bool dispatch_scene_change_enter_exit_events(
              */
             auto const event = mev::make_event(
                 mir_input_event_get_device_id(ctx.iev),
-                std::chrono::nanoseconds{std::chrono::steady_clock::now().time_since_epoch()},
+                ctx.event_time,
                 std::vector<uint8_t>{},
                 0, // TODO: We need the current keyboard state
                 mir_pointer_action_leave,
@@ -282,7 +290,7 @@ bool dispatch_scene_change_enter_exit_events(
              */
             auto const event = mev::make_event(
                 mir_input_event_get_device_id(ctx.iev),
-                std::chrono::nanoseconds{std::chrono::steady_clock::now().time_since_epoch()},
+                ctx.event_time,
                 std::vector<uint8_t>{},
                 0, // TODO: We need the current keyboard state
                 mir_pointer_action_enter,
@@ -316,7 +324,7 @@ void send_motion_event_to_moved_surface(
          */
         auto const event = mev::make_event(
             mir_input_event_get_device_id(ctx.iev),
-            std::chrono::nanoseconds{std::chrono::steady_clock::now().time_since_epoch()},
+            ctx.event_time,
             std::vector<uint8_t>{},
             0, // TODO: We need the current keyboard state
             mir_pointer_action_motion,
@@ -342,7 +350,8 @@ void mi::SurfaceInputDispatcher::surface_moved(ms::Surface const* moved_surface)
     auto ctx = context_for_event(
         last_pointer_event.get(),
         [this](auto id) { return &this->ensure_pointer_state(id).current_target; },
-        [this](auto point) { return this->find_target_surface(point); });
+        [this](auto point) { return this->find_target_surface(point); },
+        clock->now().time_since_epoch());
 
     // If we're in a move/resize gesture we don't need to synthesize an event
     if (ensure_pointer_state(mir_input_event_get_device_id(ctx.iev)).gesture_owner)
@@ -373,7 +382,8 @@ void mi::SurfaceInputDispatcher::surface_resized()
     auto ctx = context_for_event(
         last_pointer_event.get(),
         [this](auto id) { return &this->ensure_pointer_state(id).current_target; },
-        [this](auto point) { return this->find_target_surface(point); });
+        [this](auto point) { return this->find_target_surface(point); },
+        clock->now().time_since_epoch());
 
     auto const entered_surface_changed = dispatch_scene_change_enter_exit_events(
         ctx,
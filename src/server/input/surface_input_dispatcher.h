@@ -35,6 +35,10 @@ namespace scene
 class Observer;
 class Surface;
 }
+namespace time
+{
+class Clock;
+}
 namespace input
 {
 class Surface;
@@ -43,7 +47,7 @@ class Scene;
 class SurfaceInputDispatcher : public mir::input::InputDispatcher, public shell::InputTargeter
 {
 public:
-    SurfaceInputDispatcher(std::shared_ptr<input::Scene> const& scene);
+    SurfaceInputDispatcher(std::shared_ptr<input::Scene> const& scene, std::shared_ptr<time::Clock> const& clock);
     ~SurfaceInputDispatcher();
 
     // mir::input::InputDispatcher
@@ -93,6 +97,7 @@ private:
     TouchInputState& ensure_touch_state(MirInputDeviceId id);
     
     std::shared_ptr<input::Scene> const scene;
+    std::shared_ptr<time::Clock> const clock;
 
     std::shared_ptr<scene::Observer> scene_observer;
 
@@ -23,6 +23,10 @@
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
+#include "metrics_report_factory.h"
+#include "metrics/registry.h"
+#include "trace_report_factory.h"
+#include "mir/trace/recorder.h"
 
 #include "mir/abnormal_exit.h"
 
@@ -44,6 +48,14 @@ std::unique_ptr<mir::report::ReportFactory> mir::DefaultServerConfiguration::rep
     {
         return std::make_unique<report::LttngReportFactory>();
     }
+    else if (opt == options::metrics_opt_value)
+    {
+        return std::make_unique<report::MetricsReportFactory>(the_metrics_registry(), the_clock());
+    }
+    else if (opt == options::trace_opt_value)
+    {
+        return std::make_unique<report::TraceReportFactory>(trace::Recorder::instance());
+    }
     else if (opt == options::off_opt_value)
     {
         return std::make_unique<report::NullReportFactory>();
@@ -52,10 +64,21 @@ std::unique_ptr<mir::report::ReportFactory> mir::DefaultServerConfiguration::rep
     {
         throw AbnormalExit(std::string("Invalid ") + report_opt + " option: " + opt + " (valid options are: \"" +
             options::off_opt_value + "\" and \"" + options::log_opt_value +
-                           "\" and \"" + options::lttng_opt_value + "\")");
+                           "\" and \"" + options::lttng_opt_value +
+                           "\" and \"" + options::metrics_opt_value +
+                           "\" and \"" + options::trace_opt_value + "\")");
     }
 }
 
+auto mir::DefaultServerConfiguration::the_metrics_registry() -> std::shared_ptr<report::metrics::Registry>
+{
+    return metrics_registry(
+        []
+        {
+            return std::make_shared<report::metrics::Registry>();
+        });
+}
+
 std::shared_ptr<void> mir::DefaultServerConfiguration::default_reports()
 {
     return std::make_unique<report::Reports>(*this, *the_options());
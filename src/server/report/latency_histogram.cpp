@@ -0,0 +1,137 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mr = mir::report;
+
+constexpr unsigned mr::LatencyHistogram::sub_bucket_bits;
+constexpr unsigned mr::LatencyHistogram::bucket_count;
+
+namespace
+{
+unsigned const sub_buckets = 1u << mr::LatencyHistogram::sub_bucket_bits;
+uint64_t const max_recordable_usec = 0xffffffff;
+
+auto bucket_for(uint64_t usec) -> unsigned
+{
+    usec = std::min(usec, max_recordable_usec);
+
+    if (usec < 2 * sub_buckets)
+        return usec;
+
+    // Values in [2^n, 2^(n+1)) share a shift, keeping sub_bucket_bits + 1 significant bits
+    unsigned const msb = 63 - __builtin_clzll(usec);
+    unsigned const shift = msb - mr::LatencyHistogram::sub_bucket_bits;
+
+    return (shift << mr::LatencyHistogram::sub_bucket_bits) + (usec >> shift);
+}
+
+auto upper_bound_of(unsigned bucket) -> uint64_t
+{
+    if (bucket < 2 * sub_buckets)
+        return bucket;
+
+    unsigned const shift = (bucket >> mr::LatencyHistogram::sub_bucket_bits) - 1;
+    uint64_t const mantissa = bucket - (shift << mr::LatencyHistogram::sub_bucket_bits);
+
+    return ((mantissa + 1) << shift) - 1;
+}
+}
+
+void mr::LatencyHistogram::record(std::chrono::nanoseconds duration)
+{
+    auto const usec = static_cast<uint64_t>(
+        std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 0));
+
+    counts[bucket_for(usec)].fetch_add(1, std::memory_order_relaxed);
+
+    auto max = max_usec.load(std::memory_order_relaxed);
+    while (usec > max && !max_usec.compare_exchange_weak(max, usec, std::memory_order_relaxed))
+    {
+    }
+}
+
+auto mr::LatencyHistogram::snapshot() const -> Snapshot
+{
+    Snapshot result;
+
+    for (unsigned i = 0; i != bucket_count; ++i)
+        result.counts[i] = counts[i].load(std::memory_order_relaxed);
+
+    result.max_usec = max_usec.load(std::memory_order_relaxed);
+
+    return result;
+}
+
+auto mr::LatencyHistogram::Snapshot::count() const -> uint64_t
+{
+    uint64_t total{0};
+    for (auto const n : counts)
+        total += n;
+
+    return total;
+}
+
+auto mr::LatencyHistogram::Snapshot::percentile(double fraction) const -> std::chrono::microseconds
+{
+    auto const total = count();
+    if (!total)
+        return std::chrono::microseconds{0};
+
+    auto const rank = std::max<uint64_t>(std::ceil(fraction * total), 1);
+
+    uint64_t seen{0};
+    for (unsigned i = 0; i != bucket_count; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::chrono::microseconds{std::min(upper_bound_of(i), max_usec)};
+    }
+
+    return max();
+}
+
+auto mr::LatencyHistogram::Snapshot::max() const -> std::chrono::microseconds
+{
+    return std::chrono::microseconds{max_usec};
+}
+
+auto mr::LatencyHistogram::Snapshot::since(Snapshot const& earlier) const -> Snapshot
+{
+    Snapshot result;
+    unsigned highest{0};
+
+    for (unsigned i = 0; i != bucket_count; ++i)
+    {
+        result.counts[i] = counts[i] - earlier.counts[i];
+        if (result.counts[i])
+            highest = i;
+    }
+
+    // Only the all-time maximum is tracked exactly; otherwise the top of the
+    // highest occupied bucket is as close as we can get
+    if (result.counts[highest])
+    {
+        result.max_usec = bucket_for(max_usec) == highest ?
+            max_usec : upper_bound_of(highest);
+    }
+
+    return result;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_LATENCY_HISTOGRAM_H_
+#define MIR_REPORT_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace mir
+{
+namespace report
+{
+/**
+ * A fixed-size, log-linear histogram of durations.
+ *
+ * Durations are bucketed in microseconds with 32 buckets per power of two,
+ * so percentiles are accurate to about 3% from 1µs up to an hour. Recording
+ * is lock-free and allocation-free; reading takes a Snapshot, and the
+ * difference of two snapshots describes the samples recorded in between.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned sub_bucket_bits = 5;
+    static constexpr unsigned bucket_count = (32 - sub_bucket_bits + 1) << sub_bucket_bits;
+
+    class Snapshot
+    {
+    public:
+        auto count() const -> uint64_t;
+
+        /// The smallest bucket bound that at least \p fraction of samples fall within
+        auto percentile(double fraction) const -> std::chrono::microseconds;
+        auto max() const -> std::chrono::microseconds;
+
+        /// The samples in this snapshot that weren't in \p earlier
+        auto since(Snapshot const& earlier) const -> Snapshot;
+
+    private:
+        friend class LatencyHistogram;
+
+        std::array<uint64_t, bucket_count> counts{};
+        uint64_t max_usec{0};
+    };
+
+    LatencyHistogram() = default;
+
+    void record(std::chrono::nanoseconds duration);
+    auto snapshot() const -> Snapshot;
+
+private:
+    LatencyHistogram(LatencyHistogram const&) = delete;
+    LatencyHistogram& operator=(LatencyHistogram const&) = delete;
+
+    std::array<std::atomic<uint64_t>, bucket_count> counts{};
+    std::atomic<uint64_t> max_usec{0};
+};
+}
+}
+
+#endif // MIR_REPORT_LATENCY_HISTOGRAM_H_
@@ -19,6 +19,8 @@
 #include "compositor_report.h"
 #include "mir/logging/logger.h"
 
+#include <algorithm>
+
 using namespace mir::time;
 namespace ml = mir::logging;
 namespace mrl = mir::report::logging;
@@ -27,6 +29,45 @@ namespace
 {
     const char * const component = "compositor";
     const auto min_report_interval = std::chrono::seconds(1);
+
+    // Too few back-to-back frames to say anything about the refresh rate
+    const long min_interval_samples = 10;
+
+    int64_t to_nsec(Duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+    int64_t to_nsec(Timestamp t)
+    {
+        return to_nsec(t.time_since_epoch());
+    }
+
+    Timestamp from_nsec(int64_t nsec)
+    {
+        return Timestamp{} + std::chrono::duration_cast<Duration>(std::chrono::nanoseconds{nsec});
+    }
+
+    mrl::CompositorReport::Percentiles percentiles_of(mir::report::LatencyHistogram::Snapshot const& samples)
+    {
+        return {
+            samples.percentile(0.5),
+            samples.percentile(0.9),
+            samples.percentile(0.99),
+            samples.max()};
+    }
+
+    // "p50/p90/p99/max" in milliseconds
+    std::string format(mrl::CompositorReport::Percentiles const& p)
+    {
+        char buf[128];
+        snprintf(buf, sizeof buf, "%ld.%03ld/%ld.%03ld/%ld.%03ld/%ld.%03ld",
+                 static_cast<long>(p.p50.count() / 1000), static_cast<long>(p.p50.count() % 1000),
+                 static_cast<long>(p.p90.count() / 1000), static_cast<long>(p.p90.count() % 1000),
+                 static_cast<long>(p.p99.count() / 1000), static_cast<long>(p.p99.count() % 1000),
+                 static_cast<long>(p.max.count() / 1000), static_cast<long>(p.max.count() % 1000));
+        return buf;
+    }
 }
 
 mrl::CompositorReport::CompositorReport(
@@ -34,7 +75,7 @@ mrl::CompositorReport::CompositorReport(
     std::shared_ptr<Clock> const& clock)
     : logger(logger),
       clock(clock),
-      last_report(now())
+      last_report(to_nsec(now()))
 {
 }
 
@@ -43,6 +84,17 @@ mrl::CompositorReport::TimePoint mrl::CompositorReport::now() const
     return clock->now();
 }
 
+auto mrl::CompositorReport::instance_for(SubCompositorId id) -> Instance&
+{
+    return instance_cache.find(id, mutex, [&]
+        {
+            auto& inst = instance[id];
+            if (!inst)
+                inst = std::make_shared<Instance>();
+            return inst;
+        });
+}
+
 void mrl::CompositorReport::added_display(int width, int height, int x, int y, SubCompositorId id)
 {
     char msg[128];
@@ -53,12 +105,14 @@ void mrl::CompositorReport::added_display(int width, int height, int x, int y, S
 
 void mrl::CompositorReport::began_frame(SubCompositorId id)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    auto& inst = instance[id];
+    auto& inst = instance_for(id);
 
     auto t = now();
     inst.start_of_frame = t;
-    inst.latency_sum += t - last_scheduled;
+    inst.scheduled_at = from_nsec(last_scheduled.load(std::memory_order_relaxed));
+    inst.latency_sum.fetch_add(to_nsec(t - inst.scheduled_at), std::memory_order_relaxed);
+    if (inst.scheduled_at != TimePoint())
+        inst.latency.record(t - inst.scheduled_at);
     inst.bypassed = true;
 }
 
@@ -68,31 +122,44 @@ void mrl::CompositorReport::renderables_in_frame(SubCompositorId, mir::graphics:
 
 void mrl::CompositorReport::rendered_frame(SubCompositorId id)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    auto& inst = instance[id];
-    inst.render_time_sum += now() - inst.start_of_frame;
+    auto& inst = instance_for(id);
+
+    auto const render_time = now() - inst.start_of_frame;
+    inst.render_time_sum.fetch_add(to_nsec(render_time), std::memory_order_relaxed);
+    inst.render_time.record(render_time);
     inst.bypassed = false;
 }
 
 void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id)
 {
+    auto const total_time_sum = this->total_time_sum.load(std::memory_order_relaxed);
+    auto const render_time_sum = this->render_time_sum.load(std::memory_order_relaxed);
+    auto const latency_sum = this->latency_sum.load(std::memory_order_relaxed);
+    auto const nframes = this->nframes.load(std::memory_order_relaxed);
+    auto const nbypassed = this->nbypassed.load(std::memory_order_relaxed);
+    auto const missed_vblanks = this->missed_vblanks.load(std::memory_order_relaxed);
+    auto const texture_hits = this->texture_hits.load(std::memory_order_relaxed);
+    auto const texture_misses = this->texture_misses.load(std::memory_order_relaxed);
+    auto const texture_evictions = this->texture_evictions.load(std::memory_order_relaxed);
+
+    auto const frame_time = this->frame_time.snapshot();
+    auto const render_time = this->render_time.snapshot();
+    auto const latency = this->latency.snapshot();
+    auto const gpu_time = this->gpu_time.snapshot();
+    auto const interval = this->interval.snapshot();
+
+    auto const recent_intervals = interval.since(last_reported_interval);
+    if (recent_intervals.count() >= min_interval_samples)
+        refresh_estimate.store(to_nsec(recent_intervals.percentile(0.5)), std::memory_order_relaxed);
+
     // The first report is a valid sample, but don't log anything because
     // we need at least two samples for valid deltas.
-    if (last_reported_total_time_sum > TimePoint())
+    if (last_reported_total_time_sum > 0)
     {
-        long long dt =
-            std::chrono::duration_cast<std::chrono::microseconds>(
-                total_time_sum - last_reported_total_time_sum
-            ).count();
+        long long dt = (total_time_sum - last_reported_total_time_sum) / 1000;
         auto dn = nframes - last_reported_nframes;
-        long long dr =
-            std::chrono::duration_cast<std::chrono::microseconds>(
-                render_time_sum - last_reported_render_time_sum
-            ).count();
-        long long dl =
-            std::chrono::duration_cast<std::chrono::microseconds>(
-                latency_sum - last_reported_latency_sum
-            ).count();
+        long long dr = (render_time_sum - last_reported_render_time_sum) / 1000;
+        long long dl = (latency_sum - last_reported_latency_sum) / 1000;
 
         long bypass_percent = dn ? (nbypassed - last_reported_bypassed) * 100L / dn : 0;
 
@@ -103,7 +170,45 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
         long avg_latency_usec = dn ? dl / dn : 0;
         long dt_msec = dt / 1000L;
 
-        char msg[128];
+        char msg[512];
+        snprintf(msg, sizeof msg, "Display %p p50/p90/p99/max ms: "
+                 "frame %s, render %s, latency %s, "
+                 "%ld missed vblanks",
+                 id,
+                 format(percentiles_of(frame_time.since(last_reported_frame_time))).c_str(),
+                 format(percentiles_of(render_time.since(last_reported_render_time))).c_str(),
+                 format(percentiles_of(latency.since(last_reported_latency))).c_str(),
+                 missed_vblanks - last_reported_missed_vblanks
+                 );
+
+        logger.log(ml::Severity::informational, msg, component);
+
+        auto const recent_gpu_time = gpu_time.since(last_reported_gpu_time);
+        if (recent_gpu_time.count() > 0)
+        {
+            snprintf(msg, sizeof msg, "Display %p p50/p90/p99/max ms: gpu %s",
+                     id, format(percentiles_of(recent_gpu_time)).c_str());
+            logger.log(ml::Severity::informational, msg, component);
+        }
+
+        auto const dh = texture_hits - last_reported_texture_hits;
+        auto const dm = texture_misses - last_reported_texture_misses;
+        if (dh + dm > 0)
+        {
+            long const hit_permille = dh * 1000L / (dh + dm);
+            snprintf(msg, sizeof msg, "Display %p texture cache: %ld.%ld%% hits "
+                     "(%ld of %ld), %ld evicted, %zu KiB held of %zu KiB budget",
+                     id,
+                     hit_permille / 10,
+                     hit_permille % 10,
+                     dh,
+                     dh + dm,
+                     texture_evictions - last_reported_texture_evictions,
+                     texture_resident_bytes.load(std::memory_order_relaxed) / 1024,
+                     texture_budget_bytes.load(std::memory_order_relaxed) / 1024);
+            logger.log(ml::Severity::informational, msg, component);
+        }
+
         snprintf(msg, sizeof msg, "Display %p averaged %ld.%03ld FPS, "
                  "%ld.%03ld ms/frame, "
                  "latency %ld.%03ld ms, "
@@ -130,33 +235,65 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_latency_sum = latency_sum;
     last_reported_nframes = nframes;
     last_reported_bypassed = nbypassed;
+    last_reported_missed_vblanks = missed_vblanks;
+    last_reported_texture_hits = texture_hits;
+    last_reported_texture_misses = texture_misses;
+    last_reported_texture_evictions = texture_evictions;
+    last_reported_frame_time = frame_time;
+    last_reported_render_time = render_time;
+    last_reported_latency = latency;
+    last_reported_gpu_time = gpu_time;
+    last_reported_interval = interval;
 }
 
 void mrl::CompositorReport::finished_frame(SubCompositorId id)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    auto& inst = instance[id];
+    auto& inst = instance_for(id);
 
     auto t = now();
-    inst.total_time_sum += t - inst.end_of_frame;
+    inst.total_time_sum.fetch_add(to_nsec(t - inst.end_of_frame), std::memory_order_relaxed);
+
+    /*
+     * A frame is ready to draw from when it was scheduled or, if it was
+     * already waiting, from when the previous frame finished. Measuring from
+     * there keeps idle periods out of the frame times.
+     */
+    auto const ready = std::max(inst.end_of_frame, inst.scheduled_at);
+    if (ready != TimePoint())
+    {
+        auto const frame_time = t - ready;
+        inst.frame_time.record(frame_time);
+
+        if (inst.end_of_frame != TimePoint() && inst.scheduled_at <= inst.end_of_frame)
+            inst.interval.record(t - inst.end_of_frame);
+
+        auto const refresh = inst.refresh_estimate.load(std::memory_order_relaxed);
+        auto const frame_nsec = to_nsec(frame_time);
+        if (refresh > 0 && frame_nsec > refresh * 3 / 2)
+            inst.missed_vblanks.fetch_add((frame_nsec + refresh / 2) / refresh - 1, std::memory_order_relaxed);
+    }
+
     inst.end_of_frame = t;
-    inst.nframes++;
+    inst.nframes.fetch_add(1, std::memory_order_relaxed);
     if (inst.bypassed)
-        ++inst.nbypassed;
+        inst.nbypassed.fetch_add(1, std::memory_order_relaxed);
 
     /*
      * The exact reporting interval doesn't matter because we count everything
      * as a Reimann sum. Results will simply be the average over the interval.
      */
-    if ((t - last_report) >= min_report_interval)
+    auto const t_nsec = to_nsec(t);
+    auto last = last_report.load(std::memory_order_relaxed);
+    if (t_nsec - last >= to_nsec(min_report_interval) &&
+        last_report.compare_exchange_strong(last, t_nsec, std::memory_order_relaxed))
     {
-        last_report = t;
+        std::lock_guard<std::mutex> lock(mutex);
 
         for (auto& i : instance)
-            i.second.log(*logger, i.first);
+            i.second->log(*logger, i.first);
     }
 
-    if (inst.bypassed != inst.prev_bypassed || inst.nframes == 1)
+    if (inst.bypassed != inst.prev_bypassed || inst.nframes.load(std::memory_order_relaxed) == 1)
     {
         char msg[128];
         snprintf(msg, sizeof msg, "Display %p bypass %s",
@@ -166,6 +303,65 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::gpu_timed_frame(SubCompositorId id, mir::renderer::GPUTiming const& timing)
+{
+    instance_for(id).gpu_time.record(timing.frame_time);
+}
+
+void mrl::CompositorReport::texture_cache_used(SubCompositorId id, mir::renderer::TextureCacheUsage const& usage)
+{
+    auto& inst = instance_for(id);
+
+    inst.texture_hits.fetch_add(usage.hits, std::memory_order_relaxed);
+    inst.texture_misses.fetch_add(usage.misses, std::memory_order_relaxed);
+    inst.texture_evictions.fetch_add(usage.evictions, std::memory_order_relaxed);
+    inst.texture_resident_bytes.store(usage.resident_bytes, std::memory_order_relaxed);
+    inst.texture_budget_bytes.store(usage.budget_bytes, std::memory_order_relaxed);
+}
+
+auto mrl::CompositorReport::frame_timing(SubCompositorId id) const -> FrameTiming
+{
+    std::shared_ptr<Instance> inst;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto const i = instance.find(id);
+        if (i != instance.end())
+            inst = i->second;
+    }
+
+    if (!inst)
+        return {0, {}, {}, {}, 0, {}};
+
+    return {
+        inst->nframes.load(std::memory_order_relaxed),
+        percentiles_of(inst->frame_time.snapshot()),
+        percentiles_of(inst->render_time.snapshot()),
+        percentiles_of(inst->latency.snapshot()),
+        inst->missed_vblanks.load(std::memory_order_relaxed),
+        percentiles_of(inst->gpu_time.snapshot())};
+}
+
+auto mrl::CompositorReport::texture_cache_usage(SubCompositorId id) const -> mir::renderer::TextureCacheUsage
+{
+    std::shared_ptr<Instance> inst;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto const i = instance.find(id);
+        if (i != instance.end())
+            inst = i->second;
+    }
+
+    if (!inst)
+        return {0, 0, 0, 0, 0};
+
+    return {
+        static_cast<std::size_t>(inst->texture_hits.load(std::memory_order_relaxed)),
+        static_cast<std::size_t>(inst->texture_misses.load(std::memory_order_relaxed)),
+        static_cast<std::size_t>(inst->texture_evictions.load(std::memory_order_relaxed)),
+        inst->texture_resident_bytes.load(std::memory_order_relaxed),
+        inst->texture_budget_bytes.load(std::memory_order_relaxed)};
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
@@ -177,10 +373,10 @@ void mrl::CompositorReport::stopped()
 
     std::lock_guard<std::mutex> lock(mutex);
     instance.clear();
+    instance_cache.invalidate();
 }
 
 void mrl::CompositorReport::scheduled()
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    last_scheduled = now();
+    last_scheduled.store(to_nsec(now()), std::memory_order_relaxed);
 }
@@ -21,6 +21,10 @@
 
 #include "mir/compositor/compositor_report.h"
 #include "mir/time/clock.h"
+#include "../latency_histogram.h"
+#include "../per_thread_display_cache.h"
+
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -40,6 +44,24 @@ namespace logging
 class CompositorReport : public mir::compositor::CompositorReport
 {
 public:
+    struct Percentiles
+    {
+        std::chrono::microseconds p50;
+        std::chrono::microseconds p90;
+        std::chrono::microseconds p99;
+        std::chrono::microseconds max;
+    };
+
+    struct FrameTiming
+    {
+        long frames;
+        Percentiles frame_time;     ///< From having something to draw to the frame being finished
+        Percentiles render_time;    ///< Time spent rendering (bypassed frames aren't counted)
+        Percentiles latency;        ///< From compositing being scheduled to the frame starting
+        long missed_vblanks;        ///< Estimated refresh periods a frame overran by
+        Percentiles gpu_time;       ///< GPU time of a frame (only measured with --gpu-timing)
+    };
+
     CompositorReport(std::shared_ptr<mir::logging::Logger> const& logger,
                      std::shared_ptr<time::Clock> const& clock);
     void added_display(int width, int height, int x, int y, SubCompositorId id) override;
@@ -47,10 +69,18 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void gpu_timed_frame(SubCompositorId id, renderer::GPUTiming const& timing) override;
+    void texture_cache_used(SubCompositorId id, renderer::TextureCacheUsage const& usage) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
 
+    /// Timing of all the frames of display \p id since the compositor started
+    auto frame_timing(SubCompositorId id) const -> FrameTiming;
+
+    /// Use of display \p id's texture cache: counts since the compositor started, sizes as last reported
+    auto texture_cache_usage(SubCompositorId id) const -> renderer::TextureCacheUsage;
+
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
     std::shared_ptr<time::Clock> const clock;
@@ -58,31 +88,68 @@ private:
     typedef time::Timestamp TimePoint;
     TimePoint now() const;
 
+    /*
+     * Each display is composited by a single thread, which updates its
+     * Instance without locking. The atomic members are also read by
+     * whichever thread is logging the periodic summary.
+     */
     struct Instance
     {
+        // Owned by the compositing thread
         TimePoint start_of_frame;
         TimePoint end_of_frame;
-        TimePoint total_time_sum;
-        TimePoint render_time_sum;
-        TimePoint latency_sum;
-        long nframes = 0;
-        long nbypassed = 0;
+        TimePoint scheduled_at;
         bool bypassed = true;
         bool prev_bypassed = false;
 
-        TimePoint last_reported_total_time_sum;
-        TimePoint last_reported_render_time_sum;
-        TimePoint last_reported_latency_sum;
+        std::atomic<int64_t> total_time_sum{0};
+        std::atomic<int64_t> render_time_sum{0};
+        std::atomic<int64_t> latency_sum{0};
+        std::atomic<long> nframes{0};
+        std::atomic<long> nbypassed{0};
+        std::atomic<long> missed_vblanks{0};
+        std::atomic<long> texture_hits{0};
+        std::atomic<long> texture_misses{0};
+        std::atomic<long> texture_evictions{0};
+        std::atomic<std::size_t> texture_resident_bytes{0};
+        std::atomic<std::size_t> texture_budget_bytes{0};
+
+        LatencyHistogram frame_time;
+        LatencyHistogram render_time;
+        LatencyHistogram latency;
+        LatencyHistogram gpu_time;
+        /// Finished-to-finished intervals of frames drawn back-to-back,
+        /// whose median estimates the refresh period
+        LatencyHistogram interval;
+        std::atomic<int64_t> refresh_estimate{0};
+
+        // Owned by the thread logging the summary
+        int64_t last_reported_total_time_sum = 0;
+        int64_t last_reported_render_time_sum = 0;
+        int64_t last_reported_latency_sum = 0;
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
+        long last_reported_missed_vblanks = 0;
+        long last_reported_texture_hits = 0;
+        long last_reported_texture_misses = 0;
+        long last_reported_texture_evictions = 0;
+        LatencyHistogram::Snapshot last_reported_frame_time;
+        LatencyHistogram::Snapshot last_reported_render_time;
+        LatencyHistogram::Snapshot last_reported_latency;
+        LatencyHistogram::Snapshot last_reported_gpu_time;
+        LatencyHistogram::Snapshot last_reported_interval;
 
         void log(mir::logging::Logger& logger, SubCompositorId id);
     };
 
-    std::mutex mutex; // Protects the following...
-    std::unordered_map<SubCompositorId, Instance> instance;
-    TimePoint last_scheduled;
-    TimePoint last_report;
+    auto instance_for(SubCompositorId id) -> Instance&;
+
+    std::atomic<int64_t> last_scheduled{0};
+    std::atomic<int64_t> last_report;
+    PerThreadDisplayCache<Instance> instance_cache;
+
+    std::mutex mutable mutex; // Protects the following...
+    std::unordered_map<SubCompositorId, std::shared_ptr<Instance>> instance;
 };
 
 } // namespace logging
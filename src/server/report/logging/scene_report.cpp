@@ -117,3 +117,12 @@ void mrl::SceneReport::surface_deleted(BasicSurfaceId id, std::string const& nam
 
     logger->log(ml::Severity::informational, ss.str(), component);
 }
+
+void mrl::SceneReport::session_memory_over_limit(std::string const& session_name, std::size_t bytes, std::size_t limit)
+{
+    std::stringstream ss;
+    ss << "session_memory_over_limit(\"" << session_name << "\") - WARNING holding "
+       << bytes << " bytes of buffers, shared memory and textures, over its limit of " << limit;
+
+    logger->log(ml::Severity::warning, ss.str(), component);
+}
@@ -46,6 +46,7 @@ public:
     void surface_added(BasicSurfaceId id, std::string const& name);
     void surface_removed(BasicSurfaceId id, std::string const& name);
     void surface_deleted(BasicSurfaceId id, std::string const& name);
+    void session_memory_over_limit(std::string const& session_name, std::size_t bytes, std::size_t limit);
 
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
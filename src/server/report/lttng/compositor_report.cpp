@@ -62,3 +62,20 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::gpu_timed_frame(SubCompositorId id, renderer::GPUTiming const& timing)
+{
+    using Class = renderer::GPUTiming::Class;
+    mir_tracepoint(mir_server_compositor, gpu_timed_frame, id,
+                   timing.frame_time.count(),
+                   timing.time_in(Class::clear).count(),
+                   timing.time_in(Class::opaque).count(),
+                   timing.time_in(Class::blended).count());
+}
+
+void mir::report::lttng::CompositorReport::texture_cache_used(
+    SubCompositorId id, renderer::TextureCacheUsage const& usage)
+{
+    mir_tracepoint(mir_server_compositor, texture_cache_used, id,
+                   usage.hits, usage.misses, usage.evictions, usage.resident_bytes);
+}
@@ -40,6 +40,8 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void gpu_timed_frame(SubCompositorId id, renderer::GPUTiming const& timing) override;
+    void texture_cache_used(SubCompositorId id, renderer::TextureCacheUsage const& usage) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -90,6 +90,32 @@ TRACEPOINT_EVENT(
     )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    gpu_timed_frame,
+    TP_ARGS(void const*, id, int64_t, frame_ns, int64_t, clear_ns, int64_t, opaque_ns, int64_t, blended_ns),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int64_t, frame_ns, frame_ns)
+        ctf_integer(int64_t, clear_ns, clear_ns)
+        ctf_integer(int64_t, opaque_ns, opaque_ns)
+        ctf_integer(int64_t, blended_ns, blended_ns)
+    )
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    texture_cache_used,
+    TP_ARGS(void const*, id, uint64_t, hits, uint64_t, misses, uint64_t, evictions, uint64_t, resident_bytes),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(uint64_t, hits, hits)
+        ctf_integer(uint64_t, misses, misses)
+        ctf_integer(uint64_t, evictions, evictions)
+        ctf_integer(uint64_t, resident_bytes, resident_bytes)
+    )
+)
+
 #endif /* MIR_LTTNG_COMPOSITOR_REPORT_TP_H_ */
 
 #include <lttng/tracepoint-event.h>
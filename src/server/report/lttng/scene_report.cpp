@@ -42,3 +42,9 @@ void mir::report::lttng::SceneReport::surface_deleted(BasicSurfaceId, std::strin
 {
     mir_tracepoint(mir_server_scene, surface_deleted, name.c_str());
 }
+
+void mir::report::lttng::SceneReport::session_memory_over_limit(
+    std::string const& session_name, std::size_t bytes, std::size_t limit)
+{
+    mir_tracepoint(mir_server_scene, session_memory_over_limit, session_name.c_str(), bytes, limit);
+}
@@ -38,6 +38,7 @@ public:
     void surface_added(BasicSurfaceId id, std::string const& name) override;
     void surface_removed(BasicSurfaceId id, std::string const& name) override;
     void surface_deleted(BasicSurfaceId id, std::string const& name) override;
+    void session_memory_over_limit(std::string const& session_name, std::size_t bytes, std::size_t limit) override;
 private:
     ServerTracepointProvider tp_provider;
 };
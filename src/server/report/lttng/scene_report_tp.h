@@ -67,6 +67,17 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(char const*, name)
 )
 
+TRACEPOINT_EVENT(
+    mir_server_scene,
+    session_memory_over_limit,
+    TP_ARGS(char const*, name, uint64_t, bytes, uint64_t, limit),
+    TP_FIELDS(
+        ctf_string(name, name)
+        ctf_integer(uint64_t, bytes, bytes)
+        ctf_integer(uint64_t, limit, limit)
+    )
+)
+
 #endif /* MIR_LTTNG_SCENE_REPORT_TP_H_ */
 
 #include <lttng/tracepoint-event.h>
@@ -0,0 +1,238 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositor_report.h"
+#include "registry.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+namespace mrm = mir::report::metrics;
+using mir::time::Timestamp;
+
+namespace
+{
+auto to_nsec(Timestamp t) -> int64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+auto from_nsec(int64_t nsec) -> Timestamp
+{
+    return Timestamp{} + std::chrono::duration_cast<mir::time::Duration>(std::chrono::nanoseconds{nsec});
+}
+
+// Indexed by GPUTiming::Class
+char const* const gpu_class_names[mir::renderer::GPUTiming::class_count]{"clear", "opaque", "blended"};
+}
+
+/// Per-display metrics, plus state owned by the display's compositing thread
+struct mrm::CompositorReport::Output
+{
+    Output(Registry& registry, std::string const& name)
+        : frames{registry.counter(
+              "mir_compositor_frames_total", "Frames composited", {{"output", name}})},
+          bypassed_frames{registry.counter(
+              "mir_compositor_bypassed_frames_total", "Frames shown without compositing", {{"output", name}})},
+          frame_time{registry.histogram(
+              "mir_compositor_frame_seconds",
+              "Time from a frame being ready to draw until it is finished",
+              {{"output", name}})},
+          render_time{registry.histogram(
+              "mir_compositor_render_seconds", "Time spent rendering a frame", {{"output", name}})},
+          latency{registry.histogram(
+              "mir_compositor_schedule_latency_seconds",
+              "Time from compositing being scheduled until a frame starts",
+              {{"output", name}})},
+          gpu_time{registry.histogram(
+              "mir_compositor_gpu_seconds", "GPU time spent on a frame", {{"output", name}})},
+          gpu_class_time{
+              &gpu_class_histogram(registry, name, 0),
+              &gpu_class_histogram(registry, name, 1),
+              &gpu_class_histogram(registry, name, 2)},
+          texture_cache_hits{registry.counter(
+              "mir_compositor_texture_cache_hits_total",
+              "Textures of renderables drawn without loading their buffer",
+              {{"output", name}})},
+          texture_cache_misses{registry.counter(
+              "mir_compositor_texture_cache_misses_total",
+              "Textures of renderables loaded from their buffer",
+              {{"output", name}})},
+          texture_cache_evictions{registry.counter(
+              "mir_compositor_texture_cache_evictions_total",
+              "Textures of renderables not drawn freed to keep to the budget",
+              {{"output", name}})},
+          texture_cache_bytes{registry.gauge(
+              "mir_compositor_texture_cache_bytes", "Texture memory held by the renderer", {{"output", name}})},
+          texture_cache_budget_bytes{registry.gauge(
+              "mir_compositor_texture_cache_budget_bytes",
+              "Texture memory the renderer keeps for renderables not drawn",
+              {{"output", name}})}
+    {
+    }
+
+    static auto gpu_class_histogram(Registry& registry, std::string const& name, std::size_t c) -> Histogram&
+    {
+        return registry.histogram(
+            "mir_compositor_gpu_class_seconds",
+            "GPU time spent on a frame, by class of work",
+            {{"output", name}, {"class", gpu_class_names[c]}});
+    }
+
+    Counter& frames;
+    Counter& bypassed_frames;
+    Histogram& frame_time;
+    Histogram& render_time;
+    Histogram& latency;
+    Histogram& gpu_time;
+    std::array<Histogram*, renderer::GPUTiming::class_count> const gpu_class_time;
+    Counter& texture_cache_hits;
+    Counter& texture_cache_misses;
+    Counter& texture_cache_evictions;
+    Gauge& texture_cache_bytes;
+    Gauge& texture_cache_budget_bytes;
+
+    Timestamp start_of_frame;
+    Timestamp end_of_frame;
+    Timestamp scheduled_at;
+    bool bypassed{true};
+};
+
+mrm::CompositorReport::CompositorReport(
+    std::shared_ptr<Registry> const& registry,
+    std::shared_ptr<time::Clock> const& clock)
+    : registry{registry},
+      clock{clock},
+      scheduled_count{registry->counter("mir_compositor_scheduled_total", "Requests to composite")},
+      displays{registry->gauge("mir_compositor_displays", "Displays being composited")}
+{
+}
+
+auto mrm::CompositorReport::output_for(SubCompositorId id) -> Output&
+{
+    return output_cache.find(id, mutex, [&]
+        {
+            auto& output = outputs[id];
+            if (!output)
+            {
+                char name[32];
+                snprintf(name, sizeof name, "%p", id);
+                output = std::make_shared<Output>(*registry, name);
+            }
+            return output;
+        });
+}
+
+void mrm::CompositorReport::added_display(int width, int height, int x, int y, SubCompositorId id)
+{
+    // Name the display by its layout, which (unlike id) is stable across restarts
+    char name[64];
+    snprintf(name, sizeof name, "%dx%d%+d%+d", width, height, x, y);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& output = outputs[id];
+    if (!output)
+        displays.add(1);
+    output = std::make_shared<Output>(*registry, name);
+
+    // Compositing threads may have cached the output this replaces
+    output_cache.invalidate();
+}
+
+void mrm::CompositorReport::began_frame(SubCompositorId id)
+{
+    auto& output = output_for(id);
+
+    auto const t = clock->now();
+    output.start_of_frame = t;
+    output.scheduled_at = from_nsec(last_scheduled.load(std::memory_order_relaxed));
+    if (output.scheduled_at != Timestamp{})
+        output.latency.record(t - output.scheduled_at);
+    output.bypassed = true;
+}
+
+void mrm::CompositorReport::renderables_in_frame(SubCompositorId, graphics::RenderableList const&)
+{
+}
+
+void mrm::CompositorReport::rendered_frame(SubCompositorId id)
+{
+    auto& output = output_for(id);
+
+    output.render_time.record(clock->now() - output.start_of_frame);
+    output.bypassed = false;
+}
+
+void mrm::CompositorReport::finished_frame(SubCompositorId id)
+{
+    auto& output = output_for(id);
+
+    auto const t = clock->now();
+
+    // Measured from when the frame could start, so idle time isn't counted
+    auto const ready = std::max(output.end_of_frame, output.scheduled_at);
+    if (ready != Timestamp{})
+        output.frame_time.record(t - ready);
+
+    output.end_of_frame = t;
+    output.frames.increment();
+    if (output.bypassed)
+        output.bypassed_frames.increment();
+}
+
+void mrm::CompositorReport::gpu_timed_frame(SubCompositorId id, renderer::GPUTiming const& timing)
+{
+    auto& output = output_for(id);
+
+    output.gpu_time.record(timing.frame_time);
+
+    // Fences only time the whole frame
+    if (timing.method == renderer::GPUTiming::Method::timer_query)
+    {
+        for (auto c = 0u; c != timing.class_time.size(); ++c)
+            output.gpu_class_time[c]->record(timing.class_time[c]);
+    }
+}
+
+void mrm::CompositorReport::texture_cache_used(SubCompositorId id, renderer::TextureCacheUsage const& usage)
+{
+    auto& output = output_for(id);
+
+    output.texture_cache_hits.increment(usage.hits);
+    output.texture_cache_misses.increment(usage.misses);
+    output.texture_cache_evictions.increment(usage.evictions);
+    output.texture_cache_bytes.set(usage.resident_bytes);
+    output.texture_cache_budget_bytes.set(usage.budget_bytes);
+}
+
+void mrm::CompositorReport::started()
+{
+}
+
+void mrm::CompositorReport::stopped()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    outputs.clear();
+    displays.set(0);
+    output_cache.invalidate();
+}
+
+void mrm::CompositorReport::scheduled()
+{
+    scheduled_count.increment();
+    last_scheduled.store(to_nsec(clock->now()), std::memory_order_relaxed);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
+#define MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
+
+#include "mir/compositor/compositor_report.h"
+#include "mir/time/clock.h"
+#include "../per_thread_display_cache.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace mir
+{
+namespace report
+{
+namespace metrics
+{
+class Registry;
+class Counter;
+class Gauge;
+class Histogram;
+
+class CompositorReport : public compositor::CompositorReport
+{
+public:
+    CompositorReport(std::shared_ptr<Registry> const& registry, std::shared_ptr<time::Clock> const& clock);
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void finished_frame(SubCompositorId id) override;
+    void gpu_timed_frame(SubCompositorId id, renderer::GPUTiming const& timing) override;
+    void texture_cache_used(SubCompositorId id, renderer::TextureCacheUsage const& usage) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+
+private:
+    struct Output;
+    auto output_for(SubCompositorId id) -> Output&;
+
+    std::shared_ptr<Registry> const registry;
+    std::shared_ptr<time::Clock> const clock;
+
+    Counter& scheduled_count;
+    Gauge& displays;
+
+    std::atomic<int64_t> last_scheduled{0};
+    PerThreadDisplayCache<Output> output_cache;
+
+    std::mutex mutex;
+    std::unordered_map<SubCompositorId, std::shared_ptr<Output>> outputs;
+};
+}
+}
+}
+
+#endif // MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "connector_report.h"
+#include "registry.h"
+
+namespace mrm = mir::report::metrics;
+
+mrm::ConnectorReport::ConnectorReport(std::shared_ptr<Registry> const& registry)
+    : registry{registry},
+      threads{registry->gauge("mir_connector_threads", "Threads serving client connections")},
+      sessions{registry->counter("mir_connector_sessions_total", "Client connections accepted")},
+      errors{registry->counter("mir_connector_errors_total", "Errors handling client connections")},
+      warnings{registry->counter("mir_connector_warnings_total", "Warnings handling client connections")}
+{
+}
+
+void mrm::ConnectorReport::thread_start()
+{
+    threads.add(1);
+}
+
+void mrm::ConnectorReport::thread_end()
+{
+    threads.add(-1);
+}
+
+void mrm::ConnectorReport::creating_session_for(int)
+{
+    sessions.increment();
+}
+
+void mrm::ConnectorReport::creating_socket_pair(int, int)
+{
+}
+
+void mrm::ConnectorReport::listening_on(std::string const&)
+{
+}
+
+void mrm::ConnectorReport::error(std::exception const&)
+{
+    errors.increment();
+}
+
+void mrm::ConnectorReport::warning(std::string const&)
+{
+    warnings.increment();
+}
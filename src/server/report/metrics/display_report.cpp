@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "display_report.h"
+#include "registry.h"
+
+namespace mrm = mir::report::metrics;
+
+struct mrm::DisplayReport::Output
+{
+    Output(Registry& registry, unsigned int id)
+        : vsyncs{registry.counter(
+              "mir_display_vsyncs_total", "Vsyncs reported", {{"output", std::to_string(id)}})},
+          skipped_vblanks{registry.counter(
+              "mir_display_skipped_vblanks_total",
+              "Vblanks that passed without a new frame being shown",
+              {{"output", std::to_string(id)}})},
+          vsync_interval{registry.histogram(
+              "mir_display_vsync_interval_seconds",
+              "Time between vblanks",
+              {{"output", std::to_string(id)}})}
+    {
+    }
+
+    Counter& vsyncs;
+    Counter& skipped_vblanks;
+    Histogram& vsync_interval;
+
+    graphics::Frame last;
+};
+
+mrm::DisplayReport::DisplayReport(std::shared_ptr<Registry> const& registry)
+    : registry{registry},
+      drm_master_failures{registry->counter(
+          "mir_display_drm_master_failures_total", "Failures to acquire or drop DRM master")},
+      vt_switch_away_failures{registry->counter(
+          "mir_display_vt_switch_failures_total", "Failed VT switches", {{"direction", "away"}})},
+      vt_switch_back_failures{registry->counter(
+          "mir_display_vt_switch_failures_total", "Failed VT switches", {{"direction", "back"}})}
+{
+}
+
+void mrm::DisplayReport::report_successful_setup_of_native_resources()
+{
+}
+
+void mrm::DisplayReport::report_successful_egl_make_current_on_construction()
+{
+}
+
+void mrm::DisplayReport::report_successful_egl_buffer_swap_on_construction()
+{
+}
+
+void mrm::DisplayReport::report_successful_drm_mode_set_crtc_on_construction()
+{
+}
+
+void mrm::DisplayReport::report_successful_display_construction()
+{
+}
+
+void mrm::DisplayReport::report_drm_master_failure(int)
+{
+    drm_master_failures.increment();
+}
+
+void mrm::DisplayReport::report_vt_switch_away_failure()
+{
+    vt_switch_away_failures.increment();
+}
+
+void mrm::DisplayReport::report_vt_switch_back_failure()
+{
+    vt_switch_back_failures.increment();
+}
+
+void mrm::DisplayReport::report_egl_configuration(EGLDisplay, EGLConfig)
+{
+}
+
+void mrm::DisplayReport::report_vsync(unsigned int output_id, graphics::Frame const& frame)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& output = outputs[output_id];
+    if (!output)
+        output = std::make_shared<Output>(*registry, output_id);
+
+    output->vsyncs.increment();
+
+    auto const& last = output->last;
+    if (last.msc && frame.msc > last.msc && frame.ust.clock_id == last.ust.clock_id)
+    {
+        auto const vblanks = frame.msc - last.msc;
+        output->skipped_vblanks.increment(vblanks - 1);
+        output->vsync_interval.record((frame.ust.nanoseconds - last.ust.nanoseconds) / vblanks);
+    }
+
+    output->last = frame;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "input_report.h"
+#include "registry.h"
+
+namespace mrm = mir::report::metrics;
+
+mrm::InputReport::InputReport(std::shared_ptr<Registry> const& registry)
+    : registry{registry},
+      kernel_events{registry->counter("mir_input_kernel_events_total", "Events read from input devices")},
+      key_events{registry->counter(
+          "mir_input_published_events_total", "Events sent to clients", {{"type", "key"}})},
+      motion_events{registry->counter(
+          "mir_input_published_events_total", "Events sent to clients", {{"type", "motion"}})},
+      opened_devices{registry->counter("mir_input_devices_opened_total", "Input devices opened")},
+      failed_devices{registry->counter("mir_input_device_failures_total", "Input devices that failed to open")}
+{
+}
+
+void mrm::InputReport::received_event_from_kernel(int64_t, int, int, int)
+{
+    kernel_events.increment();
+}
+
+void mrm::InputReport::published_key_event(int, uint32_t, int64_t)
+{
+    key_events.increment();
+}
+
+void mrm::InputReport::published_motion_event(int, uint32_t, int64_t)
+{
+    motion_events.increment();
+}
+
+void mrm::InputReport::opened_input_device(char const*, char const*)
+{
+    opened_devices.increment();
+}
+
+void mrm::InputReport::failed_to_open_input_device(char const*, char const*)
+{
+    failed_devices.increment();
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../metrics_report_factory.h"
+#include "../null_report_factory.h"
+
+#include "compositor_report.h"
+#include "connector_report.h"
+#include "display_report.h"
+#include "input_report.h"
+#include "scene_report.h"
+#include "seat_report.h"
+#include "shell_report.h"
+
+namespace mr = mir::report;
+namespace mrm = mir::report::metrics;
+
+mr::MetricsReportFactory::MetricsReportFactory(
+    std::shared_ptr<metrics::Registry> const& registry,
+    std::shared_ptr<time::Clock> const& clock)
+    : registry(registry),
+      clock(clock)
+{
+}
+
+std::shared_ptr<mir::compositor::CompositorReport> mr::MetricsReportFactory::create_compositor_report()
+{
+    return std::make_shared<mrm::CompositorReport>(registry, clock);
+}
+
+std::shared_ptr<mir::graphics::DisplayReport> mr::MetricsReportFactory::create_display_report()
+{
+    return std::make_shared<mrm::DisplayReport>(registry);
+}
+
+std::shared_ptr<mir::scene::SceneReport> mr::MetricsReportFactory::create_scene_report()
+{
+    return std::make_shared<mrm::SceneReport>(registry);
+}
+
+std::shared_ptr<mir::frontend::ConnectorReport> mr::MetricsReportFactory::create_connector_report()
+{
+    return std::make_shared<mrm::ConnectorReport>(registry);
+}
+
+std::shared_ptr<mir::frontend::SessionMediatorObserver> mr::MetricsReportFactory::create_session_mediator_report()
+{
+    // Sessions are counted by the shell report, which also sees Wayland clients
+    return null_session_mediator_report();
+}
+
+std::shared_ptr<mir::frontend::MessageProcessorReport> mr::MetricsReportFactory::create_message_processor_report()
+{
+    return null_message_processor_report();
+}
+
+std::shared_ptr<mir::input::InputReport> mr::MetricsReportFactory::create_input_report()
+{
+    return std::make_shared<mrm::InputReport>(registry);
+}
+
+std::shared_ptr<mir::input::SeatObserver> mr::MetricsReportFactory::create_seat_report()
+{
+    return std::make_shared<mrm::SeatReport>(registry);
+}
+
+std::shared_ptr<mir::SharedLibraryProberReport> mr::MetricsReportFactory::create_shared_library_prober_report()
+{
+    return null_shared_library_prober_report();
+}
+
+std::shared_ptr<mir::shell::ShellReport> mr::MetricsReportFactory::create_shell_report()
+{
+    return std::make_shared<mrm::ShellReport>(registry);
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "registry.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <ostream>
+#include <stdexcept>
+
+namespace mrm = mir::report::metrics;
+
+namespace
+{
+char const* const counter_type = "counter";
+char const* const gauge_type = "gauge";
+char const* const summary_type = "summary";
+
+auto escape(std::string const& text, bool quotes) -> std::string
+{
+    std::string result;
+    result.reserve(text.size());
+
+    for (auto const c : text)
+    {
+        switch (c)
+        {
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '"':
+            result += quotes ? "\\\"" : "\"";
+            break;
+        default:
+            result += c;
+        }
+    }
+
+    return result;
+}
+
+/// The inside of a label set: a="x",b="y"
+auto label_list(mrm::Labels const& labels) -> std::string
+{
+    std::string result;
+
+    for (auto const& label : labels)
+    {
+        if (!result.empty())
+            result += ',';
+        result += label.first + "=\"" + escape(label.second, true) + '"';
+    }
+
+    return result;
+}
+
+auto braced(std::string const& list) -> std::string
+{
+    return list.empty() ? list : '{' + list + '}';
+}
+
+auto seconds(std::chrono::nanoseconds duration) -> double
+{
+    return std::chrono::duration<double>(duration).count();
+}
+}
+
+struct mrm::Registry::Family
+{
+    std::string help;
+    char const* type;
+
+    // Keyed by label list; only the map matching type is used
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+};
+
+void mrm::Histogram::record(std::chrono::nanoseconds duration)
+{
+    samples.record(duration);
+    sum_nsec.fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+auto mrm::Histogram::sum() const -> std::chrono::nanoseconds
+{
+    return std::chrono::nanoseconds{sum_nsec.load(std::memory_order_relaxed)};
+}
+
+mrm::Registry::Registry() = default;
+mrm::Registry::~Registry() = default;
+
+auto mrm::Registry::family(std::string const& name, std::string const& help, char const* type) -> Family&
+{
+    auto& family = families[name];
+
+    if (!family)
+    {
+        family = std::make_unique<Family>();
+        family->help = help;
+        family->type = type;
+    }
+    else if (family->type != type)
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error{
+            "Metric \"" + name + "\" is a " + family->type + ", not a " + type});
+    }
+
+    return *family;
+}
+
+auto mrm::Registry::counter(std::string const& name, std::string const& help, Labels const& labels) -> Counter&
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& counter = family(name, help, counter_type).counters[label_list(labels)];
+    if (!counter)
+        counter = std::make_unique<Counter>();
+
+    return *counter;
+}
+
+auto mrm::Registry::gauge(std::string const& name, std::string const& help, Labels const& labels) -> Gauge&
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& gauge = family(name, help, gauge_type).gauges[label_list(labels)];
+    if (!gauge)
+        gauge = std::make_unique<Gauge>();
+
+    return *gauge;
+}
+
+auto mrm::Registry::histogram(std::string const& name, std::string const& help, Labels const& labels) -> Histogram&
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& histogram = family(name, help, summary_type).histograms[label_list(labels)];
+    if (!histogram)
+        histogram = std::make_unique<Histogram>();
+
+    return *histogram;
+}
+
+void mrm::Registry::write(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (auto const& entry : families)
+    {
+        auto const& name = entry.first;
+        auto const& family = *entry.second;
+
+        out << "# HELP " << name << ' ' << escape(family.help, false) << '\n';
+        out << "# TYPE " << name << ' ' << family.type << '\n';
+
+        for (auto const& counter : family.counters)
+            out << name << braced(counter.first) << ' ' << counter.second->value() << '\n';
+
+        for (auto const& gauge : family.gauges)
+            out << name << braced(gauge.first) << ' ' << gauge.second->value() << '\n';
+
+        for (auto const& histogram : family.histograms)
+        {
+            auto const& labels = histogram.first;
+            auto const samples = histogram.second->snapshot();
+            auto const separator = labels.empty() ? "" : ",";
+
+            for (auto const quantile : {0.5, 0.9, 0.99})
+            {
+                out << name << '{' << labels << separator << "quantile=\"" << quantile << "\"} "
+                    << seconds(samples.percentile(quantile)) << '\n';
+            }
+
+            out << name << "_sum" << braced(labels) << ' ' << seconds(histogram.second->sum()) << '\n';
+            out << name << "_count" << braced(labels) << ' ' << samples.count() << '\n';
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_METRICS_REGISTRY_H_
+#define MIR_REPORT_METRICS_REGISTRY_H_
+
+#include "../latency_histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace mir
+{
+namespace report
+{
+namespace metrics
+{
+using Labels = std::map<std::string, std::string>;
+
+/// A value that only goes up
+class Counter
+{
+public:
+    void increment(uint64_t by = 1) { count.fetch_add(by, std::memory_order_relaxed); }
+    auto value() const -> uint64_t { return count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> count{0};
+};
+
+/// A value that goes up and down
+class Gauge
+{
+public:
+    void set(int64_t value) { current.store(value, std::memory_order_relaxed); }
+    void add(int64_t delta) { current.fetch_add(delta, std::memory_order_relaxed); }
+    auto value() const -> int64_t { return current.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> current{0};
+};
+
+/// A distribution of durations, exposed as p50/p90/p99 quantiles
+class Histogram
+{
+public:
+    void record(std::chrono::nanoseconds duration);
+
+    auto snapshot() const -> LatencyHistogram::Snapshot { return samples.snapshot(); }
+    auto sum() const -> std::chrono::nanoseconds;
+
+private:
+    LatencyHistogram samples;
+    std::atomic<int64_t> sum_nsec{0};
+};
+
+/**
+ * The metrics of a running server.
+ *
+ * Metrics are created on first use and live as long as the registry, so
+ * reports can look them up once and update them without locking. write()
+ * produces the Prometheus text exposition format.
+ */
+class Registry
+{
+public:
+    Registry();
+    ~Registry();
+
+    auto counter(std::string const& name, std::string const& help, Labels const& labels = {}) -> Counter&;
+    auto gauge(std::string const& name, std::string const& help, Labels const& labels = {}) -> Gauge&;
+    auto histogram(std::string const& name, std::string const& help, Labels const& labels = {}) -> Histogram&;
+
+    void write(std::ostream& out) const;
+
+private:
+    Registry(Registry const&) = delete;
+    Registry& operator=(Registry const&) = delete;
+
+    struct Family;
+    auto family(std::string const& name, std::string const& help, char const* type) -> Family&;
+
+    std::mutex mutable mutex;
+    std::map<std::string, std::unique_ptr<Family>> families;
+};
+}
+}
+}
+
+#endif // MIR_REPORT_METRICS_REGISTRY_H_
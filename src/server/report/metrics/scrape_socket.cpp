@@ -0,0 +1,175 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "metrics"
+
+#include "scrape_socket.h"
+#include "registry.h"
+
+#include "mir/dispatch/readable_fd.h"
+#include "mir/dispatch/threaded_dispatcher.h"
+#include "mir/fd.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <locale>
+#include <sstream>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mrm = mir::report::metrics;
+namespace md = mir::dispatch;
+
+namespace
+{
+// How long to wait to find out whether the client is speaking HTTP
+int const request_timeout_ms = 50;
+
+/// Removes a socket left at \a addr by a server that has gone, but not one still being served
+void remove_if_stale(sockaddr_un const& addr)
+{
+    struct stat statbuf;
+    if (stat(addr.sun_path, &statbuf) != 0 || (statbuf.st_mode & S_IFMT) != S_IFSOCK)
+        return;
+
+    mir::Fd const probe{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    if (probe < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create metrics socket"}));
+
+    if (connect(probe, reinterpret_cast<sockaddr const*>(&addr), sizeof addr) == 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error{std::string{"Metrics socket is already being served: "} + addr.sun_path});
+    }
+
+    if (errno == ECONNREFUSED)
+        unlink(addr.sun_path);
+}
+
+auto listen_on(std::string const& path) -> mir::Fd
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof addr.sun_path)
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Metrics socket path is too long: " + path});
+
+    strncpy(addr.sun_path, path.c_str(), sizeof addr.sun_path - 1);
+
+    mir::Fd fd{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create metrics socket"}));
+
+    remove_if_stale(addr);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to bind metrics socket " + path}));
+
+    // Only the user running the server gets to watch it
+    chmod(path.c_str(), S_IRUSR | S_IWUSR);
+
+    if (listen(fd, 4) < 0)
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to listen on metrics socket " + path}));
+
+    return fd;
+}
+
+auto is_http_request(mir::Fd const& client) -> bool
+{
+    pollfd pfd{client, POLLIN, 0};
+    if (poll(&pfd, 1, request_timeout_ms) <= 0)
+        return false;
+
+    // We don't care what was requested, only that a reply is expected in kind
+    char request[1024];
+    auto const received = recv(client, request, sizeof request, MSG_DONTWAIT);
+
+    return received >= 4 && strncmp(request, "GET ", 4) == 0;
+}
+
+void send_all(mir::Fd const& client, std::string const& data)
+{
+    size_t sent{0};
+    while (sent < data.size())
+    {
+        auto const result = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        sent += result;
+    }
+}
+
+void serve(mir::Fd const& listener, mrm::Registry const& registry)
+{
+    mir::Fd const client{accept4(listener, nullptr, nullptr, SOCK_CLOEXEC)};
+    if (client < 0)
+        return;
+
+    // Don't let a client that stops reading hold up the next scrape forever
+    timeval const send_timeout{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof send_timeout);
+
+    std::ostringstream body;
+    body.imbue(std::locale::classic());
+    registry.write(body);
+
+    if (is_http_request(client))
+    {
+        std::ostringstream header;
+        header << "HTTP/1.0 200 OK\r\n"
+               << "Content-Type: text/plain; version=0.0.4\r\n"
+               << "Content-Length: " << body.str().size() << "\r\n"
+               << "Connection: close\r\n\r\n";
+        send_all(client, header.str());
+    }
+
+    send_all(client, body.str());
+}
+}
+
+mrm::ScrapeSocket::ScrapeSocket(std::string const& path, std::shared_ptr<Registry> const& registry)
+    : socket_path{path},
+      dispatcher{[&]
+          {
+              auto const listener = listen_on(path);
+              return std::make_unique<md::ThreadedDispatcher>(
+                  "Mir/Metrics",
+                  std::make_shared<md::ReadableFd>(listener, [listener, registry] { serve(listener, *registry); }));
+          }()}
+{
+    mir::log_info("Serving metrics on %s", path.c_str());
+}
+
+mrm::ScrapeSocket::~ScrapeSocket()
+{
+    unlink(socket_path.c_str());
+}
+
+auto mrm::ScrapeSocket::path() const -> std::string const&
+{
+    return socket_path;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_METRICS_SCRAPE_SOCKET_H_
+#define MIR_REPORT_METRICS_SCRAPE_SOCKET_H_
+
+#include <memory>
+#include <string>
+
+namespace mir
+{
+namespace dispatch
+{
+class ThreadedDispatcher;
+}
+namespace report
+{
+namespace metrics
+{
+class Registry;
+
+/**
+ * Serves the registry's metrics on a UNIX socket.
+ *
+ * Each connection gets the current metrics in the Prometheus text format and
+ * is then closed, so "socat - UNIX-CONNECT:<path>" works. Clients that send
+ * an HTTP GET (e.g. "curl --unix-socket <path> http://localhost/metrics") get
+ * an HTTP response.
+ */
+class ScrapeSocket
+{
+public:
+    ScrapeSocket(std::string const& path, std::shared_ptr<Registry> const& registry);
+    ~ScrapeSocket();
+
+    auto path() const -> std::string const&;
+
+private:
+    ScrapeSocket(ScrapeSocket const&) = delete;
+    ScrapeSocket& operator=(ScrapeSocket const&) = delete;
+
+    std::string const socket_path;
+    std::unique_ptr<dispatch::ThreadedDispatcher> const dispatcher;
+};
+}
+}
+}
+
+#endif // MIR_REPORT_METRICS_SCRAPE_SOCKET_H_
@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "seat_report.h"
+#include "registry.h"
+
+namespace mrm = mir::report::metrics;
+
+mrm::SeatReport::SeatReport(std::shared_ptr<Registry> const& registry)
+    : registry{registry},
+      devices{registry->gauge("mir_seat_devices", "Input devices attached to the seat")},
+      dispatched_events{registry->counter("mir_seat_dispatched_events_total", "Input events dispatched by the seat")}
+{
+}
+
+void mrm::SeatReport::seat_add_device(uint64_t)
+{
+    devices.add(1);
+}
+
+void mrm::SeatReport::seat_remove_device(uint64_t)
+{
+    devices.add(-1);
+}
+
+void mrm::SeatReport::seat_dispatch_event(std::shared_ptr<MirEvent const> const&)
+{
+    dispatched_events.increment();
+}
+
+void mrm::SeatReport::seat_set_key_state(uint64_t, std::vector<uint32_t> const&)
+{
+}
+
+void mrm::SeatReport::seat_set_pointer_state(uint64_t, unsigned)
+{
+}
+
+void mrm::SeatReport::seat_set_cursor_position(float, float)
+{
+}
+
+void mrm::SeatReport::seat_set_confinement_region_called(geometry::Rectangles const&)
+{
+}
+
+void mrm::SeatReport::seat_reset_confinement_regions()
+{
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shell_report.h"
+#include "registry.h"
+
+namespace mrm = mir::report::metrics;
+
+mrm::ShellReport::ShellReport(std::shared_ptr<Registry> const& registry)
+    : registry{registry},
+      sessions_opened{registry->counter("mir_shell_sessions_opened_total", "Client sessions opened")},
+      sessions{registry->gauge("mir_shell_sessions", "Client sessions open")},
+      surfaces_created{registry->counter("mir_shell_surfaces_created_total", "Surfaces created by clients")},
+      surfaces{registry->gauge("mir_shell_surfaces", "Client surfaces")},
+      surface_updates{registry->counter("mir_shell_surface_updates_total", "Changes to surfaces requested")},
+      prompt_sessions{registry->gauge("mir_shell_prompt_sessions", "Prompt sessions running")},
+      displays{registry->gauge("mir_shell_displays", "Displays in the shell's layout")},
+      focus_changes{registry->counter("mir_shell_focus_changes_total", "Changes of input focus")}
+{
+}
+
+void mrm::ShellReport::opened_session(scene::Session const&)
+{
+    sessions_opened.increment();
+    sessions.add(1);
+}
+
+void mrm::ShellReport::closing_session(scene::Session const&)
+{
+    sessions.add(-1);
+}
+
+void mrm::ShellReport::created_surface(scene::Session const&, scene::Surface const&)
+{
+    surfaces_created.increment();
+    surfaces.add(1);
+}
+
+void mrm::ShellReport::update_surface(
+    scene::Session const&, scene::Surface const&, shell::SurfaceSpecification const&)
+{
+    surface_updates.increment();
+}
+
+void mrm::ShellReport::update_surface(scene::Session const&, scene::Surface const&, MirWindowAttrib, int)
+{
+    surface_updates.increment();
+}
+
+void mrm::ShellReport::destroying_surface(scene::Session const&, scene::Surface const&)
+{
+    surfaces.add(-1);
+}
+
+void mrm::ShellReport::started_prompt_session(scene::PromptSession const&, scene::Session const&)
+{
+    prompt_sessions.add(1);
+}
+
+void mrm::ShellReport::added_prompt_provider(scene::PromptSession const&, scene::Session const&)
+{
+}
+
+void mrm::ShellReport::stopping_prompt_session(scene::PromptSession const&)
+{
+    prompt_sessions.add(-1);
+}
+
+void mrm::ShellReport::adding_display(geometry::Rectangle const&)
+{
+    displays.add(1);
+}
+
+void mrm::ShellReport::removing_display(geometry::Rectangle const&)
+{
+    displays.add(-1);
+}
+
+void mrm::ShellReport::input_focus_set_to(scene::Session const*, scene::Surface const*)
+{
+    focus_changes.increment();
+}
+
+void mrm::ShellReport::surfaces_raised(shell::SurfaceSet const&)
+{
+}
@@ -40,6 +40,14 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::gpu_timed_frame(SubCompositorId, mir::renderer::GPUTiming const&)
+{
+}
+
+void mrn::CompositorReport::texture_cache_used(SubCompositorId, mir::renderer::TextureCacheUsage const&)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
@@ -33,4 +33,7 @@ void mrn::SceneReport::surface_removed(BasicSurfaceId /*id*/, std::string const&
 void mrn::SceneReport::surface_deleted(BasicSurfaceId /*id*/, std::string const& /*name*/)
 {
 }
-
+void mrn::SceneReport::session_memory_over_limit(
+    std::string const& /*session_name*/, std::size_t /*bytes*/, std::size_t /*limit*/)
+{
+}
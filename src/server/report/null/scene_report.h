@@ -39,6 +39,9 @@ public:
     virtual void surface_removed(BasicSurfaceId /*id*/, std::string const& /*name*/) override;
     virtual void surface_deleted(BasicSurfaceId /*id*/, std::string const& /*name*/) override;
 
+    virtual void session_memory_over_limit(
+        std::string const& /*session_name*/, std::size_t /*bytes*/, std::size_t /*limit*/) override;
+
     SceneReport() = default;
     virtual ~SceneReport() noexcept(true) = default;
 
@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_PER_THREAD_DISPLAY_CACHE_H_
+#define MIR_REPORT_PER_THREAD_DISPLAY_CACHE_H_
+
+#include "mir/compositor/compositor_report.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace report
+{
+/**
+ * Finds the per-display State of a compositor report without locking.
+ *
+ * Each display is composited by a single thread, which only ever sees a
+ * handful of displays, so each thread caches the State it has looked up.
+ * Reports invalidate() the caches whenever they replace or drop the State
+ * they keep for a display.
+ */
+template<typename State>
+class PerThreadDisplayCache
+{
+public:
+    using Id = compositor::CompositorReport::SubCompositorId;
+
+    /**
+     * The State of display \p id: from this thread's cache or, failing that,
+     * from \p lookup (returning a std::shared_ptr<State>), which is called
+     * with \p mutex locked.
+     */
+    template<typename Lookup>
+    auto find(Id id, std::mutex& mutex, Lookup const& lookup) -> State&
+    {
+        auto& cache = thread_cache();
+
+        auto const current_generation = generation.load(std::memory_order_acquire);
+        for (auto const& cached : cache)
+        {
+            if (cached.cache_serial == serial && cached.generation == current_generation && cached.id == id)
+                return *cached.state;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        std::shared_ptr<State> const state = lookup();
+
+        auto const locked_generation = generation.load(std::memory_order_relaxed);
+        cache.erase(
+            std::remove_if(cache.begin(), cache.end(), [&](Cached const& cached)
+                {
+                    return cached.cache_serial != serial || cached.generation != locked_generation || cached.id == id;
+                }),
+            cache.end());
+        cache.push_back({serial, locked_generation, id, state});
+
+        return *state;
+    }
+
+    /// Stops every thread using the State it has cached; call with the mutex given to find() locked
+    void invalidate()
+    {
+        generation.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    struct Cached
+    {
+        uint64_t cache_serial;
+        uint64_t generation;
+        Id id;
+        std::shared_ptr<State> state;
+    };
+
+    /// Each thread keeps the entries of every cache of State together
+    static auto thread_cache() -> std::vector<Cached>&
+    {
+        thread_local std::vector<Cached> cache;
+        return cache;
+    }
+
+    /// Distinguishes the caches whose entries are kept together
+    static std::atomic<uint64_t> next_serial;
+
+    uint64_t const serial{next_serial++};
+    std::atomic<uint64_t> generation{0};
+};
+
+template<typename State>
+std::atomic<uint64_t> PerThreadDisplayCache<State>::next_serial{1};
+}
+}
+
+#endif // MIR_REPORT_PER_THREAD_DISPLAY_CACHE_H_
@@ -16,6 +16,8 @@
  * Authored by: Christopher James Halse Rogers <christopher.halse.rogers@canonical.com>
  */
 
+#define MIR_LOG_COMPONENT "reports"
+
 #include "reports.h"
 
 #include "mir/default_server_configuration.h"
@@ -24,14 +26,27 @@
 #include "mir/observer_multiplexer.h"
 #include "mir/options/configuration.h"
 #include "mir/abnormal_exit.h"
+#include "mir/log.h"
+#include "mir/main_loop.h"
+#include "mir/trace/recorder.h"
 
 #include "report_factory.h"
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
+#include "metrics_report_factory.h"
+#include "metrics/scrape_socket.h"
+#include "trace_report_factory.h"
+
+#include <cstdlib>
+#include <csignal>
 
+#include <algorithm>
+#include <fstream>
 #include <string>
 
+#include <unistd.h>
+
 namespace mo = mir::options;
 namespace mr = mir::report;
 
@@ -41,7 +56,9 @@ enum class ReportOutput
 {
     Discarded,
     Log,
-    LTTNG
+    LTTNG,
+    Metrics,
+    Trace
 };
 
 std::unique_ptr<mr::ReportFactory> factory_for_type(
@@ -56,6 +73,10 @@ std::unique_ptr<mr::ReportFactory> factory_for_type(
         return std::make_unique<mr::LoggingReportFactory>(config.the_logger(), config.the_clock());
     case ReportOutput::LTTNG:
         return std::make_unique<mr::LttngReportFactory>();
+    case ReportOutput::Metrics:
+        return std::make_unique<mr::MetricsReportFactory>(config.the_metrics_registry(), config.the_clock());
+    case ReportOutput::Trace:
+        return std::make_unique<mr::TraceReportFactory>(mir::trace::Recorder::instance());
     }
 #ifndef __clang__
     /*
@@ -80,6 +101,14 @@ ReportOutput parse_report_option(std::string const& opt)
     {
         return ReportOutput::LTTNG;
     }
+    else if (opt == mo::metrics_opt_value)
+    {
+        return ReportOutput::Metrics;
+    }
+    else if (opt == mo::trace_opt_value)
+    {
+        return ReportOutput::Trace;
+    }
     else if (opt == mo::off_opt_value)
     {
         return ReportOutput::Discarded;
@@ -89,8 +118,91 @@ ReportOutput parse_report_option(std::string const& opt)
         throw mir::AbnormalExit(
             std::string("Invalid report option: ") + opt + " (valid options are: \"" +
             mo::off_opt_value + "\" and \"" + mo::log_opt_value +
-            "\" and \"" + mo::lttng_opt_value + "\")");
+            "\" and \"" + mo::lttng_opt_value + "\" and \"" + mo::metrics_opt_value +
+            "\" and \"" + mo::trace_opt_value + "\")");
+    }
+}
+
+auto any_report_is(mir::options::Option const& options, char const* value) -> bool
+{
+    auto const reports = {
+        mo::compositor_report_opt,
+        mo::connector_report_opt,
+        mo::display_report_opt,
+        mo::input_report_opt,
+        mo::scene_report_opt,
+        mo::seat_report_opt,
+        mo::session_mediator_report_opt,
+        mo::msg_processor_report_opt,
+        mo::shared_library_prober_report_opt,
+        mo::shell_report_opt};
+
+    return std::any_of(begin(reports), end(reports), [&](char const* report)
+        {
+            return options.get<std::string>(report) == value;
+        });
+}
+
+std::unique_ptr<mr::metrics::ScrapeSocket> create_metrics_socket(
+    mir::DefaultServerConfiguration& config,
+    mir::options::Option const& options)
+{
+    if (!any_report_is(options, mo::metrics_opt_value) && !options.is_set(mo::track_input_latency_opt))
+        return nullptr;
+
+    std::string path;
+    if (options.is_set(mo::metrics_socket_opt))
+    {
+        path = options.get<std::string>(mo::metrics_socket_opt);
     }
+    else
+    {
+        char const* dir = getenv("XDG_RUNTIME_DIR");
+        path = std::string{dir ? dir : "/tmp"} + "/mir_metrics";
+    }
+
+    return std::make_unique<mr::metrics::ScrapeSocket>(path, config.the_metrics_registry());
+}
+
+void write_trace_snapshot(std::string const& directory)
+{
+    static int snapshots{0};
+
+    auto const path = directory + "/mir-trace-" + std::to_string(getpid()) + "-" + std::to_string(++snapshots) + ".json";
+
+    std::ofstream out{path};
+    mir::trace::Recorder::instance().write_chrome_json(out);
+    out.close();
+
+    if (out)
+        mir::log_info("Wrote trace snapshot to %s", path.c_str());
+    else
+        mir::log_warning("Failed to write trace snapshot to %s", path.c_str());
+}
+
+void start_tracing(mir::DefaultServerConfiguration& config, mir::options::Option const& options)
+{
+    if (!options.is_set(mo::trace_opt) && !any_report_is(options, mo::trace_opt_value))
+        return;
+
+    std::string directory;
+    if (options.is_set(mo::trace_dir_opt))
+    {
+        directory = options.get<std::string>(mo::trace_dir_opt);
+    }
+    else
+    {
+        char const* dir = getenv("XDG_RUNTIME_DIR");
+        directory = dir ? dir : "/tmp";
+    }
+
+    mir::trace::Recorder::instance().enable();
+
+    config.the_main_loop()->register_signal_handler(
+        {SIGUSR2},
+        [directory](int) { write_trace_snapshot(directory); });
+
+    mir::log_info("Recording trace events: send SIGUSR2 to write them to %s", directory.c_str());
 }
 
 std::shared_ptr<mir::input::SeatObserver> create_seat_reports(
@@ -135,9 +247,14 @@ mir::report::Reports::Reports(
           create_session_mediator_reports(
               server,
               options.get<std::string>(mo::session_mediator_report_opt))},
-      session_mediator_observer_multiplexer{server.the_session_mediator_observer_registrar()}
+      session_mediator_observer_multiplexer{server.the_session_mediator_observer_registrar()},
+      metrics_socket{create_metrics_socket(server, options)}
 {
     display_configuration_multiplexer->register_interest(display_configuration_report);
     seat_observer_multiplexer->register_interest(seat_report);
     session_mediator_observer_multiplexer->register_interest(session_mediator_report);
+
+    start_tracing(server, options);
 }
+
+mir::report::Reports::~Reports() = default;
@@ -53,12 +53,18 @@ namespace logging
 class DisplayConfigurationReport;
 }
 
+namespace metrics
+{
+class ScrapeSocket;
+}
+
 class ReportFactory;
 
 class Reports
 {
 public:
     Reports(DefaultServerConfiguration& server, options::Option const& options);
+    ~Reports();
 
 private:
     std::shared_ptr<logging::DisplayConfigurationReport> const display_configuration_report;
@@ -68,6 +74,7 @@ private:
     std::shared_ptr<frontend::SessionMediatorObserver> const session_mediator_report;
     std::shared_ptr<ObserverRegistrar<frontend::SessionMediatorObserver>> const
         session_mediator_observer_multiplexer;
+    std::unique_ptr<metrics::ScrapeSocket> const metrics_socket;
 };
 }
 }
@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositor_report.h"
+
+#include "mir/graphics/renderable.h"
+#include "mir/trace/recorder.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "compositor";
+}
+
+mrt::CompositorReport::CompositorReport(mir::trace::Recorder& recorder)
+    : recorder(recorder)
+{
+}
+
+void mrt::CompositorReport::added_display(int, int, int, int, SubCompositorId)
+{
+    recorder.instant(category, "added_display", 0);
+}
+
+void mrt::CompositorReport::began_frame(SubCompositorId)
+{
+    recorder.begin(category, "frame");
+}
+
+void mrt::CompositorReport::renderables_in_frame(SubCompositorId, graphics::RenderableList const& renderables)
+{
+    recorder.counter(category, "renderables", renderables.size());
+}
+
+void mrt::CompositorReport::rendered_frame(SubCompositorId)
+{
+    recorder.instant(category, "rendered_frame", 0);
+}
+
+void mrt::CompositorReport::finished_frame(SubCompositorId)
+{
+    recorder.end(category, "frame");
+}
+
+void mrt::CompositorReport::gpu_timed_frame(SubCompositorId, renderer::GPUTiming const& timing)
+{
+    recorder.counter(category, "gpu_frame_us", timing.frame_time.count() / 1000);
+}
+
+void mrt::CompositorReport::texture_cache_used(SubCompositorId, renderer::TextureCacheUsage const& usage)
+{
+    recorder.counter(category, "texture_cache_misses", usage.misses);
+    recorder.counter(category, "texture_cache_kb", usage.resident_bytes / 1024);
+}
+
+void mrt::CompositorReport::started()
+{
+    recorder.instant(category, "started", 0);
+}
+
+void mrt::CompositorReport::stopped()
+{
+    recorder.instant(category, "stopped", 0);
+}
+
+void mrt::CompositorReport::scheduled()
+{
+    recorder.instant(category, "scheduled", 0);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_TRACE_COMPOSITOR_REPORT_H_
+#define MIR_REPORT_TRACE_COMPOSITOR_REPORT_H_
+
+#include "mir/compositor/compositor_report.h"
+
+namespace mir
+{
+namespace trace
+{
+class Recorder;
+}
+namespace report
+{
+namespace trace
+{
+/// Records each display's frames as spans on its compositing thread
+class CompositorReport : public compositor::CompositorReport
+{
+public:
+    CompositorReport(mir::trace::Recorder& recorder);
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void finished_frame(SubCompositorId id) override;
+    void gpu_timed_frame(SubCompositorId id, renderer::GPUTiming const& timing) override;
+    void texture_cache_used(SubCompositorId id, renderer::TextureCacheUsage const& usage) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+
+private:
+    mir::trace::Recorder& recorder;
+};
+}
+}
+}
+
+#endif // MIR_REPORT_TRACE_COMPOSITOR_REPORT_H_
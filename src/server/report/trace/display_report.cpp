@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display_report.h"
+
+#include "mir/graphics/frame.h"
+#include "mir/trace/recorder.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "display";
+}
+
+mrt::DisplayReport::DisplayReport(mir::trace::Recorder& recorder)
+    : recorder(recorder)
+{
+}
+
+void mrt::DisplayReport::report_successful_setup_of_native_resources()
+{
+}
+
+void mrt::DisplayReport::report_successful_egl_make_current_on_construction()
+{
+}
+
+void mrt::DisplayReport::report_successful_egl_buffer_swap_on_construction()
+{
+}
+
+void mrt::DisplayReport::report_successful_drm_mode_set_crtc_on_construction()
+{
+}
+
+void mrt::DisplayReport::report_successful_display_construction()
+{
+    recorder.instant(category, "display_constructed", 0);
+}
+
+void mrt::DisplayReport::report_drm_master_failure(int error)
+{
+    recorder.instant(category, "drm_master_failure", error);
+}
+
+void mrt::DisplayReport::report_vt_switch_away_failure()
+{
+    recorder.instant(category, "vt_switch_away_failure", 0);
+}
+
+void mrt::DisplayReport::report_vt_switch_back_failure()
+{
+    recorder.instant(category, "vt_switch_back_failure", 0);
+}
+
+void mrt::DisplayReport::report_egl_configuration(EGLDisplay, EGLConfig)
+{
+}
+
+void mrt::DisplayReport::report_vsync(unsigned int, graphics::Frame const& frame)
+{
+    // The MSC lines vsyncs up with the frames around them
+    recorder.instant(category, "vsync", frame.msc);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_report.h"
+
+#include "mir/trace/recorder.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "input";
+}
+
+mrt::InputReport::InputReport(mir::trace::Recorder& recorder)
+    : recorder(recorder)
+{
+}
+
+void mrt::InputReport::received_event_from_kernel(int64_t, int type, int, int)
+{
+    recorder.instant(category, "kernel_event", type);
+}
+
+void mrt::InputReport::published_key_event(int, uint32_t seq_id, int64_t)
+{
+    recorder.instant(category, "published_key_event", seq_id);
+}
+
+void mrt::InputReport::published_motion_event(int, uint32_t seq_id, int64_t)
+{
+    recorder.instant(category, "published_motion_event", seq_id);
+}
+
+void mrt::InputReport::opened_input_device(char const*, char const*)
+{
+    recorder.instant(category, "opened_input_device", 0);
+}
+
+void mrt::InputReport::failed_to_open_input_device(char const*, char const*)
+{
+    recorder.instant(category, "failed_to_open_input_device", 0);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_TRACE_INPUT_REPORT_H_
+#define MIR_REPORT_TRACE_INPUT_REPORT_H_
+
+#include "mir/input/input_report.h"
+
+namespace mir
+{
+namespace trace
+{
+class Recorder;
+}
+namespace report
+{
+namespace trace
+{
+class InputReport : public input::InputReport
+{
+public:
+    InputReport(mir::trace::Recorder& recorder);
+
+    void received_event_from_kernel(int64_t when, int type, int code, int value) override;
+
+    void published_key_event(int dest_fd, uint32_t seq_id, int64_t event_time) override;
+    void published_motion_event(int dest_fd, uint32_t seq_id, int64_t event_time) override;
+
+    void opened_input_device(char const* device_name, char const* input_platform) override;
+    void failed_to_open_input_device(char const* device_name, char const* input_platform) override;
+
+private:
+    mir::trace::Recorder& recorder;
+};
+}
+}
+}
+
+#endif // MIR_REPORT_TRACE_INPUT_REPORT_H_
@@ -0,0 +1,339 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/trace/recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace mt = mir::trace;
+
+namespace
+{
+// Enough for a few seconds of a busy compositor, at 48 bytes an event
+size_t const default_events_per_thread = 1 << 16;
+
+// Rings of threads that have exited are kept (they may hold the interesting
+// part of a trace) but not indefinitely.
+size_t const max_finished_rings = 8;
+
+std::atomic<uint64_t> next_id{1};
+
+auto round_up_to_power_of_two(size_t n) -> size_t
+{
+    size_t result{1};
+    while (result < n)
+        result <<= 1;
+    return result;
+}
+
+auto now() -> int64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+auto this_thread_name() -> std::string
+{
+    char name[16]{};
+    pthread_getname_np(pthread_self(), name, sizeof name);
+    return name;
+}
+
+void write_json_string(std::ostream& out, char const* text)
+{
+    out << '"';
+    for (auto c = text; *c; ++c)
+    {
+        switch (*c)
+        {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof escaped, "\\u%04x", *c);
+                out << escaped;
+            }
+            else
+            {
+                out << *c;
+            }
+        }
+    }
+    out << '"';
+}
+
+/// Trace Event Format timestamps are microseconds; keep the nanoseconds as decimals
+void write_timestamp(std::ostream& out, int64_t nsec)
+{
+    char ts[32];
+    snprintf(ts, sizeof ts, "%lld.%03lld",
+        static_cast<long long>(nsec / 1000), static_cast<long long>(nsec % 1000));
+    out << ts;
+}
+}
+
+/**
+ * A single-writer ring of events. Each slot is a seqlock: the owning thread
+ * marks the slot as being written, stores the fields and then publishes the
+ * sequence number of the event. A reader copies the fields and only keeps them
+ * if the sequence number was unchanged throughout.
+ */
+class mt::Recorder::Ring
+{
+public:
+    struct Event
+    {
+        int64_t timestamp;
+        char const* category;
+        char const* name;
+        int64_t value;
+        char phase;
+    };
+
+    Ring(size_t capacity, pid_t tid, std::string const& thread_name)
+        : tid{tid},
+          thread_name{thread_name},
+          mask{capacity - 1},
+          slots{new Slot[capacity]}
+    {
+    }
+
+    void push(Event const& event)
+    {
+        auto const index = head.load(std::memory_order_relaxed);
+        auto& slot = slots[index & mask];
+
+        slot.sequence.store(writing(index), std::memory_order_relaxed);
+        slot.timestamp.store(event.timestamp, std::memory_order_release);
+        slot.category.store(event.category, std::memory_order_release);
+        slot.name.store(event.name, std::memory_order_release);
+        slot.value.store(event.value, std::memory_order_release);
+        slot.phase.store(event.phase, std::memory_order_release);
+        slot.sequence.store(written(index), std::memory_order_release);
+
+        head.store(index + 1, std::memory_order_release);
+    }
+
+    template<typename Consume>
+    void for_each(Consume const& consume) const
+    {
+        auto const end = head.load(std::memory_order_acquire);
+        auto const capacity = mask + 1;
+
+        for (auto index = end > capacity ? end - capacity : 0; index != end; ++index)
+        {
+            auto const& slot = slots[index & mask];
+
+            if (slot.sequence.load(std::memory_order_acquire) != written(index))
+                continue;
+
+            Event const event{
+                slot.timestamp.load(std::memory_order_acquire),
+                slot.category.load(std::memory_order_acquire),
+                slot.name.load(std::memory_order_acquire),
+                slot.value.load(std::memory_order_acquire),
+                slot.phase.load(std::memory_order_acquire)};
+
+            // Overwritten while we were reading it
+            if (slot.sequence.load(std::memory_order_relaxed) != written(index))
+                continue;
+
+            consume(event);
+        }
+    }
+
+    pid_t const tid;
+    std::string const thread_name;
+    std::atomic<bool> finished{false};
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<int64_t> timestamp{0};
+        std::atomic<char const*> category{nullptr};
+        std::atomic<char const*> name{nullptr};
+        std::atomic<int64_t> value{0};
+        std::atomic<char> phase{0};
+    };
+
+    static auto writing(uint64_t index) -> uint64_t { return 2*index + 1; }
+    static auto written(uint64_t index) -> uint64_t { return 2*index + 2; }
+
+    size_t const mask;
+    std::unique_ptr<Slot[]> const slots;
+    std::atomic<uint64_t> head{0};
+};
+
+auto mt::Recorder::instance() -> Recorder&
+{
+    // Never destroyed: threads may still be recording as the process exits
+    static auto const recorder = new Recorder{default_events_per_thread};
+    return *recorder;
+}
+
+mt::Recorder::Recorder(size_t events_per_thread)
+    : events_per_thread{round_up_to_power_of_two(std::max<size_t>(events_per_thread, 2))},
+      id{next_id++}
+{
+}
+
+mt::Recorder::~Recorder() = default;
+
+void mt::Recorder::enable()
+{
+    is_enabled.store(true, std::memory_order_relaxed);
+}
+
+void mt::Recorder::disable()
+{
+    is_enabled.store(false, std::memory_order_relaxed);
+}
+
+void mt::Recorder::begin(char const* category, char const* name)
+{
+    record('B', category, name, 0);
+}
+
+void mt::Recorder::end(char const* category, char const* name)
+{
+    record('E', category, name, 0);
+}
+
+void mt::Recorder::instant(char const* category, char const* name, int64_t value)
+{
+    record('i', category, name, value);
+}
+
+void mt::Recorder::counter(char const* category, char const* name, int64_t value)
+{
+    record('C', category, name, value);
+}
+
+void mt::Recorder::record(char phase, char const* category, char const* name, int64_t value)
+{
+    if (!enabled())
+        return;
+
+    ring_for_this_thread().push({now(), category, name, value, phase});
+}
+
+auto mt::Recorder::ring_for_this_thread() -> Ring&
+{
+    struct ThreadRing
+    {
+        uint64_t recorder_id{0};
+        std::shared_ptr<Ring> ring;
+
+        ~ThreadRing()
+        {
+            if (ring)
+                ring->finished = true;
+        }
+    };
+
+    thread_local ThreadRing thread_ring;
+
+    if (thread_ring.recorder_id != id)
+    {
+        if (thread_ring.ring)
+            thread_ring.ring->finished = true;
+
+        thread_ring.ring = std::make_shared<Ring>(
+            events_per_thread, static_cast<pid_t>(syscall(SYS_gettid)), this_thread_name());
+        thread_ring.recorder_id = id;
+
+        std::lock_guard<std::mutex> lock{rings_mutex};
+
+        size_t const finished = std::count_if(rings.begin(), rings.end(),
+            [](std::shared_ptr<Ring> const& ring) { return ring->finished.load(); });
+
+        // Drop the oldest finished rings
+        auto excess = finished > max_finished_rings ? finished - max_finished_rings : 0;
+        rings.erase(
+            std::remove_if(rings.begin(), rings.end(), [&](std::shared_ptr<Ring> const& ring)
+                {
+                    if (excess && ring->finished.load())
+                    {
+                        --excess;
+                        return true;
+                    }
+                    return false;
+                }),
+            rings.end());
+
+        rings.push_back(thread_ring.ring);
+    }
+
+    return *thread_ring.ring;
+}
+
+void mt::Recorder::write_chrome_json(std::ostream& out) const
+{
+    std::vector<std::shared_ptr<Ring>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock{rings_mutex};
+        snapshot = rings;
+    }
+
+    auto const pid = getpid();
+    char const* separator = "\n";
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    for (auto const& ring : snapshot)
+    {
+        out << separator << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid
+            << ",\"tid\":" << ring->tid << ",\"args\":{\"name\":";
+        write_json_string(out, ring->thread_name.c_str());
+        out << "}}";
+        separator = ",\n";
+
+        ring->for_each([&](Ring::Event const& event)
+            {
+                out << separator << "{\"ph\":\"" << event.phase << "\",\"cat\":";
+                write_json_string(out, event.category);
+                out << ",\"name\":";
+                write_json_string(out, event.name);
+                out << ",\"ts\":";
+                write_timestamp(out, event.timestamp);
+                out << ",\"pid\":" << pid << ",\"tid\":" << ring->tid;
+
+                switch (event.phase)
+                {
+                case 'i':
+                    out << ",\"s\":\"t\",\"args\":{\"value\":" << event.value << "}";
+                    break;
+                case 'C':
+                    out << ",\"args\":{\"value\":" << event.value << "}";
+                    break;
+                }
+
+                out << "}";
+            });
+    }
+
+    out << "\n]}\n";
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene_report.h"
+
+#include "mir/trace/recorder.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "scene";
+}
+
+mrt::SceneReport::SceneReport(mir::trace::Recorder& recorder)
+    : recorder(recorder)
+{
+}
+
+void mrt::SceneReport::surface_created(BasicSurfaceId, std::string const&)
+{
+    recorder.instant(category, "surface_created", 0);
+}
+
+void mrt::SceneReport::surface_added(BasicSurfaceId, std::string const&)
+{
+    recorder.counter(category, "surfaces", ++surfaces);
+}
+
+void mrt::SceneReport::surface_removed(BasicSurfaceId, std::string const&)
+{
+    recorder.counter(category, "surfaces", --surfaces);
+}
+
+void mrt::SceneReport::surface_deleted(BasicSurfaceId, std::string const&)
+{
+    recorder.instant(category, "surface_deleted", 0);
+}
+
+void mrt::SceneReport::session_memory_over_limit(std::string const&, std::size_t bytes, std::size_t)
+{
+    recorder.instant(category, "session_memory_over_limit", bytes);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../trace_report_factory.h"
+#include "../null_report_factory.h"
+
+#include "compositor_report.h"
+#include "display_report.h"
+#include "input_report.h"
+#include "scene_report.h"
+
+namespace mr = mir::report;
+namespace mrt = mir::report::trace;
+
+mr::TraceReportFactory::TraceReportFactory(mir::trace::Recorder& recorder)
+    : recorder(recorder)
+{
+}
+
+std::shared_ptr<mir::compositor::CompositorReport> mr::TraceReportFactory::create_compositor_report()
+{
+    return std::make_shared<mrt::CompositorReport>(recorder);
+}
+
+std::shared_ptr<mir::graphics::DisplayReport> mr::TraceReportFactory::create_display_report()
+{
+    return std::make_shared<mrt::DisplayReport>(recorder);
+}
+
+std::shared_ptr<mir::scene::SceneReport> mr::TraceReportFactory::create_scene_report()
+{
+    return std::make_shared<mrt::SceneReport>(recorder);
+}
+
+std::shared_ptr<mir::frontend::ConnectorReport> mr::TraceReportFactory::create_connector_report()
+{
+    return null_connector_report();
+}
+
+std::shared_ptr<mir::frontend::SessionMediatorObserver> mr::TraceReportFactory::create_session_mediator_report()
+{
+    return null_session_mediator_report();
+}
+
+std::shared_ptr<mir::frontend::MessageProcessorReport> mr::TraceReportFactory::create_message_processor_report()
+{
+    return null_message_processor_report();
+}
+
+std::shared_ptr<mir::input::InputReport> mr::TraceReportFactory::create_input_report()
+{
+    return std::make_shared<mrt::InputReport>(recorder);
+}
+
+std::shared_ptr<mir::input::SeatObserver> mr::TraceReportFactory::create_seat_report()
+{
+    // Seat dispatch is already traced as a span by the seat itself
+    return null_seat_report();
+}
+
+std::shared_ptr<mir::SharedLibraryProberReport> mr::TraceReportFactory::create_shared_library_prober_report()
+{
+    return null_shared_library_prober_report();
+}
+
+std::shared_ptr<mir::shell::ShellReport> mr::TraceReportFactory::create_shell_report()
+{
+    return NullReportFactory{}.create_shell_report();
+}
@@ -25,6 +25,7 @@
 #include "mir/scene/session_listener.h"
 #include "mir/scene/surface_factory.h"
 #include "mir/scene/buffer_stream_factory.h"
+#include "mir/scene/memory_accounting.h"
 #include "mir/shell/surface_stack.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/events/event_builders.h"
@@ -56,7 +57,8 @@ ms::ApplicationSession::ApplicationSession(
     std::shared_ptr<SnapshotStrategy> const& snapshot_strategy,
     std::shared_ptr<SessionListener> const& session_listener,
     std::shared_ptr<mf::EventSink> const& sink,
-    std::shared_ptr<graphics::GraphicBufferAllocator> const& gralloc) :
+    std::shared_ptr<graphics::GraphicBufferAllocator> const& gralloc,
+    std::shared_ptr<MemoryAccounting> const& memory_accounting) :
     surface_stack(surface_stack),
     surface_factory(surface_factory),
     buffer_stream_factory(buffer_stream_factory),
@@ -65,7 +67,9 @@ ms::ApplicationSession::ApplicationSession(
     snapshot_strategy(snapshot_strategy),
     session_listener(session_listener),
     event_sink(sink),
-    gralloc(gralloc)
+    gralloc(gralloc),
+    memory_accounting(memory_accounting),
+    memory_account_(memory_accounting->open_account(session_name, pid))
 {
     assert(surface_stack);
 }
@@ -73,6 +77,9 @@ ms::ApplicationSession::ApplicationSession(
 ms::ApplicationSession::~ApplicationSession()
 {
     std::unique_lock<std::mutex> lock(surfaces_and_streams_mutex);
+    for (auto const& stream : streams)
+        memory_accounting->forget(stream.get());
+
     for (auto const& surface : surfaces)
     {
         session_listener->destroying_surface(*this, surface);
@@ -220,6 +227,22 @@ std::shared_ptr<ms::Surface> ms::ApplicationSession::surface_after(std::shared_p
 }
 
 void ms::ApplicationSession::take_snapshot(SnapshotCallback const& snapshot_taken)
+{
+    if (auto const content = default_content())
+        snapshot_strategy->take_snapshot_of(content, snapshot_taken);
+    else
+        snapshot_taken(Snapshot());
+}
+
+void ms::ApplicationSession::take_thumbnail(geometry::Size const& max_size, SnapshotCallback const& thumbnail_taken)
+{
+    if (auto const content = default_content())
+        snapshot_strategy->take_thumbnail_of(content, max_size, thumbnail_taken);
+    else
+        thumbnail_taken(Snapshot());
+}
+
+auto ms::ApplicationSession::default_content() -> std::shared_ptr<compositor::BufferStream>
 {
     //TODO: taking a snapshot of a session doesn't make much sense. Snapshots can be on surfaces
     //or bufferstreams, as those represent some content. A multi-surface session doesn't have enough
@@ -232,12 +255,11 @@ void ms::ApplicationSession::take_snapshot(SnapshotCallback const& snapshot_take
             if (!content)
                 BOOST_THROW_EXCEPTION(std::logic_error(
                     "Buffer was dropped without being removed from default_content_map"));
-            snapshot_strategy->take_snapshot_of(content, snapshot_taken);
-            return;
+            return content;
         }
     }
 
-    snapshot_taken(Snapshot());
+    return {};
 }
 
 std::shared_ptr<ms::Surface> ms::ApplicationSession::default_surface() const
@@ -315,6 +337,8 @@ auto ms::ApplicationSession::create_buffer_stream(mg::BufferProperties const& pr
     auto stream = buffer_stream_factory->create_buffer_stream(props);
     session_listener->buffer_stream_created(*this, stream);
 
+    memory_accounting->attribute(stream.get(), memory_account_);
+
     std::unique_lock<std::mutex> lock(surfaces_and_streams_mutex);
     streams.insert(stream);
     return stream;
@@ -328,6 +352,7 @@ void ms::ApplicationSession::destroy_buffer_stream(std::shared_ptr<frontend::Buf
         BOOST_THROW_EXCEPTION(std::runtime_error("cannot destroy stream: Invalid BufferStream"));
 
     session_listener->buffer_stream_destroyed(*this, *stream_it);
+    memory_accounting->forget(stream_it->get());
     streams.erase(stream_it);
 }
 
@@ -343,6 +368,11 @@ void ms::ApplicationSession::configure_streams(
     surface.set_streams(list); 
 }
 
+auto ms::ApplicationSession::memory_account() const -> std::shared_ptr<MemoryAccount>
+{
+    return memory_account_;
+}
+
 auto ms::ApplicationSession::has_buffer_stream(
     std::shared_ptr<mc::BufferStream> const& stream) -> bool
 {
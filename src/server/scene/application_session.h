@@ -47,6 +47,7 @@ class Surface;
 class SnapshotStrategy;
 class BufferStreamFactory;
 class SurfaceFactory;
+class MemoryAccounting;
 
 class ApplicationSession : public Session
 {
@@ -60,7 +61,8 @@ public:
         std::shared_ptr<SnapshotStrategy> const& snapshot_strategy,
         std::shared_ptr<SessionListener> const& session_listener,
         std::shared_ptr<frontend::EventSink> const& sink,
-        std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
+        std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+        std::shared_ptr<MemoryAccounting> const& memory_accounting);
 
     ~ApplicationSession();
 
@@ -72,6 +74,7 @@ public:
     auto surface_after(std::shared_ptr<Surface> const& sruface) const -> std::shared_ptr<Surface> override;
 
     void take_snapshot(SnapshotCallback const& snapshot_taken) override;
+    void take_thumbnail(geometry::Size const& max_size, SnapshotCallback const& thumbnail_taken) override;
     std::shared_ptr<Surface> default_surface() const override;
 
     std::string name() const override;
@@ -95,6 +98,8 @@ public:
     void destroy_buffer_stream(std::shared_ptr<frontend::BufferStream> const& stream) override;
     void configure_streams(Surface& surface, std::vector<shell::StreamSpecification> const& config) override;
 
+    auto memory_account() const -> std::shared_ptr<MemoryAccount> override;
+
     /// Returns if the application session knows about the given buffer stream
     auto has_buffer_stream(std::shared_ptr<compositor::BufferStream> const& stream) -> bool;
 
@@ -103,6 +108,9 @@ protected:
     ApplicationSession& operator=(ApplicationSession const&) = delete;
 
 private:
+    /// The content of the default surface, if there is one
+    auto default_content() -> std::shared_ptr<compositor::BufferStream>;
+
     std::shared_ptr<shell::SurfaceStack> const surface_stack;
     std::shared_ptr<SurfaceFactory> const surface_factory;
     std::shared_ptr<BufferStreamFactory> const buffer_stream_factory;
@@ -112,6 +120,8 @@ private:
     std::shared_ptr<SessionListener> const session_listener;
     std::shared_ptr<frontend::EventSink> const event_sink;
     std::shared_ptr<graphics::GraphicBufferAllocator> const gralloc;
+    std::shared_ptr<MemoryAccounting> const memory_accounting;
+    std::shared_ptr<MemoryAccount> const memory_account_;
 
     std::vector<std::shared_ptr<Surface>> surfaces;
     std::set<std::shared_ptr<compositor::BufferStream>> streams;
@@ -835,6 +835,11 @@ public:
         return compositor_buffer;
     }
 
+    uint64_t submission() const override
+    {
+        return underlying_buffer_stream->submission_of(buffer()->id());
+    }
+
     geom::Rectangle screen_position() const override
     { return screen_position_; }
 
@@ -26,6 +26,7 @@
 #include "mir/abnormal_exit.h"
 #include "mir/scene/session.h"
 #include "mir/scene/session_container.h"
+#include "mir/scene/memory_accounting.h"
 #include "mir/shell/display_configuration_controller.h"
 
 #include "broadcasting_session_event_sink.h"
@@ -182,7 +183,8 @@ mir::DefaultServerConfiguration::the_session_coordinator()
                 the_display(),
                 the_application_not_responding_detector(),
                 the_buffer_allocator(),
-                the_display_configuration_observer_registrar());
+                the_display_configuration_observer_registrar(),
+                the_memory_accounting());
         });
 }
 
@@ -242,6 +244,20 @@ mir::DefaultServerConfiguration::the_coordinate_translator()
         });
 }
 
+std::shared_ptr<ms::MemoryAccounting>
+mir::DefaultServerConfiguration::the_memory_accounting()
+{
+    return memory_accounting(
+        [this]()
+        {
+            std::size_t const mebibyte{1024 * 1024};
+            auto const limit = the_options()->get<int>(options::session_memory_limit_opt);
+            return std::make_shared<ms::MemoryAccounting>(
+                limit > 0 ? limit * mebibyte : 0,
+                the_scene_report());
+        });
+}
+
 auto mir::DefaultServerConfiguration::the_application_not_responding_detector()
 -> std::shared_ptr<scene::ApplicationNotRespondingDetector>
 {
@@ -20,8 +20,12 @@
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/gl/texture_source.h"
+#include "mir/gl/pixel_pack_reader.h"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
+#include <string>
 #include <boost/throw_exception.hpp>
 #include MIR_SERVER_GL_H
 #include MIR_SERVER_GLEXT_H
@@ -32,6 +36,38 @@ namespace geom = mir::geometry;
 
 namespace
 {
+// How long collect() waits for a fill, so that new requests aren't held up for long
+std::uint64_t const collect_wait_ns{2000000};
+
+// Fills in flight before we wait for the oldest
+std::size_t const max_pending_fills{32};
+
+GLchar const* const vertex_shader_src =
+{
+    "attribute vec2 position;\n"
+    "uniform float flip;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main() {\n"
+    "   gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+    "   v_texcoord = vec2(position.x, mix(position.y, 1.0 - position.y, flip));\n"
+    "}\n"
+};
+
+GLchar const* const fragment_shader_src =
+{
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform sampler2D tex;\n"
+    "uniform float swizzle;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main() {\n"
+    "   vec4 frag = texture2D(tex, v_texcoord);\n"
+    "   gl_FragColor = mix(frag, frag.bgra, swizzle);\n"
+    "}\n"
+};
+
+GLfloat const unit_square[] = {0, 0, 1, 0, 0, 1, 1, 1};
 
 bool is_big_endian()
 {
@@ -39,23 +75,52 @@ bool is_big_endian()
     return (*reinterpret_cast<char*>(&n) != 1);
 }
 
-inline uint32_t abgr_to_argb(uint32_t p)
+GLuint compile_shader(GLenum type, GLchar const* src)
 {
-    return ((p << 16) & 0x00ff0000) | /* Move R to new position */
-           ((p) & 0x0000ff00) |       /* G remains at same position */
-           ((p >> 16) & 0x000000ff) | /* Move B to new position */
-           ((p) & 0xff000000);        /* A remains at same position */
+    GLuint const id = glCreateShader(type);
+    glShaderSource(id, 1, &src, NULL);
+    glCompileShader(id);
+
+    GLint ok;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        GLchar log[1024];
+        glGetShaderInfoLog(id, sizeof log - 1, NULL, log);
+        log[sizeof log - 1] = '\0';
+        glDeleteShader(id);
+        BOOST_THROW_EXCEPTION(std::runtime_error(std::string("Compile failed: ") + log + " for:\n" + src));
+    }
+    return id;
 }
 
+/// \a size scaled down, if need be, to fit \a max_size
+auto fit(geom::Size const& size, geom::Size const& max_size) -> geom::Size
+{
+    if (max_size.width.as_int() <= 0 || max_size.height.as_int() <= 0 ||
+        (size.width <= max_size.width && size.height <= max_size.height))
+    {
+        return size;
+    }
+
+    auto const scale = std::min(
+        max_size.width.as_int() / double(size.width.as_int()),
+        max_size.height.as_int() / double(size.height.as_int()));
+
+    return {
+        std::max(1L, std::lround(size.width.as_int() * scale)),
+        std::max(1L, std::lround(size.height.as_int() * scale))};
+}
 }
 
 ms::GLPixelBuffer::GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_context)
     : gl_context{std::move(gl_context)},
-      tex{0}, fbo{0}, gl_pixel_format{0}, pixels_need_y_flip{false}
+      initialised{false}, tex{0}, fbo{0}, program{0},
+      position_attrib{0}, flip_uniform{0}, swizzle_uniform{0}, scratch{0, 0}
 {
     /*
-     * TODO: Handle systems that are big-endian, and therefore GL_BGRA doesn't
-     * give the 0xAARRGGBB pixel format we need.
+     * TODO: Handle systems that are big-endian, and therefore reading GL_RGBA
+     * doesn't give the 0xAARRGGBB pixel format we need.
      */
     if (is_big_endian())
     {
@@ -66,129 +131,175 @@ ms::GLPixelBuffer::GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_conte
 
 ms::GLPixelBuffer::~GLPixelBuffer() noexcept
 {
+    if (!initialised)
+        return;
+
     /*
      * This may be called from a different thread
      * than the one that called prepare
      */
-    if (tex != 0 || fbo != 0)
-        gl_context->make_current();
+    gl_context->make_current();
 
-    if (tex != 0)
-        glDeleteTextures(1, &tex);
-    if (fbo != 0)
-        glDeleteFramebuffers(1, &fbo);
+    reader.reset();
+
+    glDeleteTextures(1, &tex);
+    glDeleteTextures(2, scratch);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteProgram(program);
 }
 
 void ms::GLPixelBuffer::prepare()
 {
     gl_context->make_current();
 
-    if (tex == 0)
-        glGenTextures(1, &tex);
+    if (initialised)
+    {
+        glUseProgram(program);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        return;
+    }
 
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glActiveTexture(GL_TEXTURE0);
+    auto const vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_src);
+    auto const fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
 
-    if (fbo == 0)
-        glGenFramebuffers(1, &fbo);
+    program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-}
+    GLint ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        GLchar log[1024];
+        glGetProgramInfoLog(program, sizeof log - 1, NULL, log);
+        log[sizeof log - 1] = '\0';
+        glDeleteProgram(program);
+        BOOST_THROW_EXCEPTION(std::runtime_error(std::string("Linking GL shader failed: ") + log));
+    }
 
-void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
-{
-    auto width = buffer.size().width.as_uint32_t();
-    auto height = buffer.size().height.as_uint32_t();
+    glUseProgram(program);
+    position_attrib = glGetAttribLocation(program, "position");
+    flip_uniform = glGetUniformLocation(program, "flip");
+    swizzle_uniform = glGetUniformLocation(program, "swizzle");
+    glUniform1i(glGetUniformLocation(program, "tex"), 0);
 
-    pixels.resize(width * height * 4);
+    glVertexAttribPointer(position_attrib, 2, GL_FLOAT, GL_FALSE, 0, unit_square);
+    glEnableVertexAttribArray(position_attrib);
 
-    prepare();
+    glGenTextures(1, &tex);
+    glGenTextures(2, scratch);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    reader = mir::gl::PixelPackReader::create(max_pending_fills);
+
+    initialised = true;
+}
 
+void ms::GLPixelBuffer::fill_from(
+    graphics::Buffer& buffer,
+    geom::Size const& max_size,
+    SnapshotCallback const& pixels_read)
+{
     auto const texture_source =
         dynamic_cast<mir::renderer::gl::TextureSource*>(
             buffer.native_buffer_base());
     if (!texture_source)
         BOOST_THROW_EXCEPTION(std::logic_error("Buffer does not support GL rendering"));
-    texture_source->gl_bind_to_texture();
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
 
-    /* First try to get pixels as BGRA */
-    glGetError();
-    gl_pixel_format = GL_BGRA_EXT;
-    glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
-
-    /* If getting pixels as BGRA failed, fall back to RGBA */
-    if (glGetError() != GL_NO_ERROR)
+    auto current_size = buffer.size();
+    if (current_size.width.as_int() <= 0 || current_size.height.as_int() <= 0)
     {
-        gl_pixel_format = GL_RGBA;
-        glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
+        pixels_read(Snapshot{});
+        return;
     }
 
-    size_ = buffer.size();
-    pixels_need_y_flip = true;
-}
+    prepare();
 
-void const* ms::GLPixelBuffer::as_argb_8888()
-{
-    if (pixels_need_y_flip)
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    texture_source->gl_bind_to_texture();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    auto const size = fit(current_size, max_size);
+
+    // Linear filtering only samples 2x2 texels, so shrink by halves until the last step
+    GLuint from = tex;
+    int pass = 0;
+    while (current_size.width.as_int() > 2 * size.width.as_int() ||
+           current_size.height.as_int() > 2 * size.height.as_int())
     {
-        auto const stride_val = stride().as_uint32_t();
-        auto const height = size_.height.as_uint32_t();
-
-        std::vector<char> tmp(stride_val);
-
-        for (unsigned int i = 0; i < height / 2; i++)
-        {
-            /* Store line i */
-            tmp.assign(&pixels[i * stride_val], &pixels[(i + 1) * stride_val]);
-
-            /* Copy line height - i - 1 to line i */
-            copy_and_convert_pixel_line(&pixels[(height - i - 1) * stride_val],
-                                        &pixels[i * stride_val]);
+        current_size = geom::Size{
+            std::max(size.width.as_int(), (current_size.width.as_int() + 1) / 2),
+            std::max(size.height.as_int(), (current_size.height.as_int() + 1) / 2)};
 
-            /* Copy stored line (i) to height - i - 1 */
-            copy_and_convert_pixel_line(tmp.data(),
-                                        &pixels[(height - i - 1) * stride_val]);
-        }
-
-        /* Process middle line if there is one */
-        if (height % 2 == 1)
-        {
-            copy_and_convert_pixel_line(&pixels[(height / 2) * stride_val],
-                                        &pixels[(height / 2) * stride_val]);
-        }
-
-        pixels_need_y_flip = false;
+        draw(from, current_size, scratch[pass % 2], false);
+        from = scratch[pass++ % 2];
     }
+    draw(from, size, scratch[pass % 2], true);
 
-    return pixels.data();
+    read_back(size, pixels_read);
 }
 
-geom::Size ms::GLPixelBuffer::size() const
+void ms::GLPixelBuffer::draw(GLuint from, geom::Size const& size, GLuint into, bool final_pass)
 {
-    return size_;
+    glBindTexture(GL_TEXTURE_2D, into);
+    glTexImage2D(
+        GL_TEXTURE_2D, 0, GL_RGBA, size.width.as_int(), size.height.as_int(), 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, into, 0);
+
+    glViewport(0, 0, size.width.as_int(), size.height.as_int());
+    glBindTexture(GL_TEXTURE_2D, from);
+
+    // GL textures are bottom row first, and we want RGBA bytes read as 0xAARRGGBB
+    glUniform1f(flip_uniform, final_pass ? 1.0f : 0.0f);
+    glUniform1f(swizzle_uniform, final_pass ? 1.0f : 0.0f);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
-geom::Stride ms::GLPixelBuffer::stride() const
+void ms::GLPixelBuffer::read_back(geom::Size const& size, SnapshotCallback const& pixels_read)
 {
-    return geom::Stride{size_.width.as_uint32_t() * sizeof(uint32_t)};
+    auto const width = size.width.as_uint32_t();
+    auto const height = size.height.as_uint32_t();
+    geom::Stride const stride{width * sizeof(uint32_t)};
+
+    if (!reader)
+    {
+        pixels.resize(stride.as_uint32_t() * height);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        pixels_read(Snapshot{size, stride, pixels.data()});
+        return;
+    }
+
+    reader->read(
+        {{{0, 0}, size}},
+        [size, stride, pixels_read](std::vector<unsigned char const*> const& rows)
+        {
+            if (rows.front())
+                pixels_read(Snapshot{size, stride, rows.front()});
+            else
+                pixels_read(Snapshot{});
+        });
 }
 
-void ms::GLPixelBuffer::copy_and_convert_pixel_line(char* src, char* dst)
+bool ms::GLPixelBuffer::collect(bool wait)
 {
-    if (gl_pixel_format == GL_RGBA)
-    {
-        /* Convert from abgr_8888 to argb_8888 while copying */
-        auto pixels_src = reinterpret_cast<uint32_t*>(src);
-        auto pixels_dst = reinterpret_cast<uint32_t*>(dst);
-        auto const width = size_.width.as_uint32_t();
+    if (!reader || !reader->reading())
+        return false;
 
-        for (uint32_t n = 0; n < width; n++)
-            pixels_dst[n] = abgr_to_argb(pixels_src[n]);
-    }
-    else if (src != dst)
-    {
-        std::copy(src, src + stride().as_uint32_t(), dst);
-    }
+    gl_context->make_current();
+
+    return reader->collect(wait ? collect_wait_ns : 0);
 }
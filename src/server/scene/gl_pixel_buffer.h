@@ -32,6 +32,10 @@ namespace graphics
 {
 class Buffer;
 }
+namespace gl
+{
+class PixelPackReader;
+}
 namespace renderer
 {
 namespace gl
@@ -42,30 +46,45 @@ class Context;
 
 namespace scene
 {
-/** Extracts the pixels from a graphics::Buffer using GL facilities. */
+/**
+ * Extracts the pixels from a graphics::Buffer using GL facilities.
+ *
+ * The buffer is drawn into an offscreen texture, which flips it the right way
+ * up, converts it to 0xAARRGGBB and scales it down (halving at a time, for
+ * quality) on the GPU. Where GL 3.2 or GLES 3 is available, that is read
+ * back through pixel-pack buffers and fences, without waiting for the GPU to
+ * finish drawing; otherwise it is read synchronously.
+ */
 class GLPixelBuffer : public PixelBuffer
 {
 public:
     GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_context);
     ~GLPixelBuffer() noexcept;
 
-    void fill_from(graphics::Buffer& buffer);
-    void const* as_argb_8888();
-    geometry::Size size() const;
-    geometry::Stride stride() const;
+    void fill_from(
+        graphics::Buffer& buffer,
+        geometry::Size const& max_size,
+        SnapshotCallback const& pixels_read) override;
+    bool collect(bool wait) override;
 
 private:
     void prepare();
-    void copy_and_convert_pixel_line(char* src, char* dst);
+    void draw(GLuint from, geometry::Size const& size, GLuint into, bool final_pass);
+    void read_back(geometry::Size const& size, SnapshotCallback const& pixels_read);
 
     std::unique_ptr<renderer::gl::Context> const gl_context;
+    bool initialised;
     GLuint tex;
     GLuint fbo;
+    GLuint program;
+    GLint position_attrib;
+    GLint flip_uniform;
+    GLint swizzle_uniform;
+    GLuint scratch[2];
     std::vector<char> pixels;
-    GLuint gl_pixel_format;
-    bool pixels_need_y_flip;
-    geometry::Size size_;
-    geometry::Stride stride_;
+
+    /// Reads back without waiting for the GPU, where the context can
+    std::unique_ptr<gl::PixelPackReader> reader;
 };
 
 }
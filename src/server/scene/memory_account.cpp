@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/scene/memory_account.h"
+#include "mir/scene/scene_report.h"
+#include "mir/graphics/buffer.h"
+
+#include <functional>
+
+namespace ms = mir::scene;
+namespace mg = mir::graphics;
+
+namespace
+{
+void raise_to(std::atomic<std::size_t>& peak, std::size_t value)
+{
+    auto seen = peak.load();
+    while (seen < value && !peak.compare_exchange_weak(seen, value))
+    {
+    }
+}
+
+// Formats we know nothing of are most likely 32bpp
+std::size_t const default_bytes_per_pixel{4};
+
+struct Charge
+{
+    Charge(std::function<void()> const& refund) : refund{refund} {}
+    ~Charge() { refund(); }
+
+    std::function<void()> const refund;
+};
+
+struct ChargedBuffer
+{
+    std::shared_ptr<mg::Buffer> const buffer;
+    std::shared_ptr<void> const charge;
+};
+}
+
+ms::MemoryAccount::MemoryAccount(
+    std::string const& session_name,
+    pid_t pid,
+    std::size_t limit,
+    std::shared_ptr<SceneReport> const& report) :
+    name{session_name},
+    pid{pid},
+    limit_{limit},
+    report{report}
+{
+}
+
+auto ms::MemoryAccount::session_name() const -> std::string
+{
+    return name;
+}
+
+auto ms::MemoryAccount::process_id() const -> pid_t
+{
+    return pid;
+}
+
+auto ms::MemoryAccount::limit() const -> std::size_t
+{
+    return limit_;
+}
+
+auto ms::MemoryAccount::usage() const -> Usage
+{
+    Usage usage;
+    for (std::size_t k = 0; k != kind_count; ++k)
+    {
+        usage.current[k] = current[k].load();
+        usage.peak[k] = peak[k].load();
+    }
+    usage.total = total.load();
+    usage.peak_total = peak_total.load();
+    return usage;
+}
+
+auto ms::MemoryAccount::charge(Kind kind, std::size_t bytes) -> std::shared_ptr<void>
+{
+    auto const k = static_cast<std::size_t>(kind);
+    raise_to(peak[k], current[k] += bytes);
+
+    auto const new_total = total += bytes;
+    raise_to(peak_total, new_total);
+
+    if (limit_ && new_total > limit_ && !over_limit.exchange(true))
+        report->session_memory_over_limit(name, new_total, limit_);
+
+    return std::make_shared<Charge>(
+        [self = shared_from_this(), kind, bytes] { self->refund(kind, bytes); });
+}
+
+auto ms::MemoryAccount::charged(std::shared_ptr<mg::Buffer> const& buffer, Kind kind, std::size_t bytes)
+    -> std::shared_ptr<mg::Buffer>
+{
+    auto const holder = std::make_shared<ChargedBuffer>(ChargedBuffer{buffer, charge(kind, bytes)});
+    return {holder, holder->buffer.get()};
+}
+
+auto ms::MemoryAccount::estimated_size(mg::Buffer const& buffer) -> std::size_t
+{
+    std::size_t bytes_per_pixel = MIR_BYTES_PER_PIXEL(buffer.pixel_format());
+    if (!bytes_per_pixel)
+        bytes_per_pixel = default_bytes_per_pixel;
+
+    auto const size = buffer.size();
+    return std::size_t{size.width.as_uint32_t()} * size.height.as_uint32_t() * bytes_per_pixel;
+}
+
+void ms::MemoryAccount::refund(Kind kind, std::size_t bytes)
+{
+    current[static_cast<std::size_t>(kind)] -= bytes;
+
+    if ((total -= bytes) <= limit_)
+        over_limit = false;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/scene/memory_accounting.h"
+
+#include <algorithm>
+
+namespace ms = mir::scene;
+namespace mg = mir::graphics;
+
+ms::MemoryAccounting::MemoryAccounting(std::size_t session_limit, std::shared_ptr<SceneReport> const& report) :
+    session_limit{session_limit},
+    report{report}
+{
+}
+
+auto ms::MemoryAccounting::open_account(std::string const& session_name, pid_t pid)
+    -> std::shared_ptr<MemoryAccount>
+{
+    auto const account = std::make_shared<MemoryAccount>(session_name, pid, session_limit, report);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    open.erase(
+        std::remove_if(begin(open), end(open), [](auto const& a) { return a.expired(); }),
+        end(open));
+    open.push_back(account);
+
+    return account;
+}
+
+auto ms::MemoryAccounting::accounts() const -> std::vector<std::shared_ptr<MemoryAccount>>
+{
+    std::vector<std::shared_ptr<MemoryAccount>> result;
+
+    std::lock_guard<std::mutex> lock{mutex};
+    for (auto const& a : open)
+    {
+        if (auto const account = a.lock())
+            result.push_back(account);
+    }
+    return result;
+}
+
+void ms::MemoryAccounting::attribute(mg::Renderable::ID stream, std::shared_ptr<MemoryAccount> const& account)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    streams[stream] = account;
+}
+
+void ms::MemoryAccounting::forget(mg::Renderable::ID stream)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    streams.erase(stream);
+}
+
+auto ms::MemoryAccounting::charge_texture(mg::Renderable::ID id, std::size_t bytes) -> std::shared_ptr<void>
+{
+    std::shared_ptr<MemoryAccount> account;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto const i = streams.find(id);
+        if (i != streams.end())
+            account = i->second.lock();
+    }
+
+    if (!account)
+        return nullptr;
+
+    return account->charge(MemoryAccount::Kind::textures, bytes);
+}
@@ -19,8 +19,8 @@
 #ifndef MIR_SCENE_PIXEL_BUFFER_H_
 #define MIR_SCENE_PIXEL_BUFFER_H_
 
+#include "mir/scene/snapshot.h"
 #include "mir/geometry/size.h"
-#include "mir/geometry/dimensions.h"
 
 namespace mir
 {
@@ -32,6 +32,9 @@ namespace scene
 {
 /**
  * Interface for extracting the pixels from a graphics::Buffer.
+ *
+ * Extraction may be asynchronous: the pixels of a buffer may only become
+ * available after some later calls to collect().
  */
 class PixelBuffer
 {
@@ -39,31 +42,32 @@ public:
     virtual ~PixelBuffer() = default;
 
     /**
-     * Fills the PixelBuffer with the contents of a graphics::Buffer.
-     *
-     * \param [in] buffer the buffer to get the pixels of
-     */
-    virtual void fill_from(graphics::Buffer& buffer) = 0;
-
-    /**
-     * The pixels in 0xAARRGGBB format.
+     * Starts extracting the pixels of a graphics::Buffer, in 0xAARRGGBB
+     * format, top row first.
      *
-     * The pixel data is owned by the PixelBuffer object and is only valid
-     * until the next call to fill_from().
+     * The pixel data passed to \a pixels_read is owned by the PixelBuffer
+     * object and is only valid for the duration of the call.
      *
-     * This method may involve transformation of the extracted data.
+     * \param [in] buffer      the buffer to get the pixels of
+     * \param [in] max_size    if not empty, the size to scale the pixels
+     *                         down to fit (preserving their aspect ratio)
+     * \param [in] pixels_read called, from this or a later call to
+     *                         collect(), with the pixels; or with an empty
+     *                         Snapshot if they could not be extracted
      */
-    virtual void const* as_argb_8888() = 0;
+    virtual void fill_from(
+        graphics::Buffer& buffer,
+        geometry::Size const& max_size,
+        SnapshotCallback const& pixels_read) = 0;
 
     /**
-     * The size of the pixel buffer.
-     */
-    virtual geometry::Size size() const = 0;
-
-    /**
-     * The stride of the pixel buffer.
+     * Passes on the pixels of the fills that have completed.
+     *
+     * \param [in] wait  whether to wait (briefly) for a fill to complete if
+     *                   none has yet
+     * \return whether any fills are yet to complete
      */
-    virtual geometry::Stride stride() const = 0;
+    virtual bool collect(bool wait) = 0;
 
 protected:
     PixelBuffer() = default;
@@ -99,7 +99,8 @@ ms::SessionManager::SessionManager(
     std::shared_ptr<graphics::Display const> const& display,
     std::shared_ptr<ApplicationNotRespondingDetector> const& anr_detector,
     std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
-    std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> const& display_config_registrar) :
+    std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> const& display_config_registrar,
+    std::shared_ptr<MemoryAccounting> const& memory_accounting) :
     observers(std::make_shared<SessionObservers>()),
     surface_stack(surface_stack),
     surface_factory(surface_factory),
@@ -111,7 +112,8 @@ ms::SessionManager::SessionManager(
     display{display},
     anr_detector{anr_detector},
     allocator{allocator},
-    display_config_registrar{display_config_registrar}
+    display_config_registrar{display_config_registrar},
+    memory_accounting{memory_accounting}
 {
     observers->register_interest(session_listener);
 }
@@ -150,7 +152,8 @@ std::shared_ptr<ms::Session> ms::SessionManager::open_session(
             snapshot_strategy,
             observers,
             sender,
-            allocator);
+            allocator,
+            memory_accounting);
 
     app_container->insert_session(new_session);
 
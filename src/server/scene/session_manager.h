@@ -49,6 +49,7 @@ class PromptSessionManager;
 class BufferStreamFactory;
 class SurfaceFactory;
 class ApplicationNotRespondingDetector;
+class MemoryAccounting;
 
 class SessionManager : public SessionCoordinator
 {
@@ -64,7 +65,8 @@ public:
         std::shared_ptr<graphics::Display const> const& display,
         std::shared_ptr<ApplicationNotRespondingDetector> const& anr_detector,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
-        std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> const& display_config_registrar);
+        std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> const& display_config_registrar,
+        std::shared_ptr<MemoryAccounting> const& memory_accounting);
 
     virtual ~SessionManager() noexcept;
 
@@ -102,6 +104,7 @@ private:
     std::shared_ptr<ApplicationNotRespondingDetector> const anr_detector;
     std::shared_ptr<graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> display_config_registrar;
+    std::shared_ptr<MemoryAccounting> const memory_accounting;
 };
 
 }
@@ -19,15 +19,110 @@
 #include "threaded_snapshot_strategy.h"
 #include "pixel_buffer.h"
 #include "mir/compositor/buffer_stream.h"
+#include "mir/graphics/buffer.h"
 #include "mir/thread_name.h"
 
+#include <cstring>
 #include <deque>
+#include <list>
+#include <map>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 namespace geom = mir::geometry;
+namespace mg = mir::graphics;
 namespace ms = mir::scene;
 
+namespace
+{
+// Enough for plenty of thumbnails, or a few full-size snapshots
+std::size_t const cache_budget{64 * 1024 * 1024};
+
+struct CachedSnapshot
+{
+    explicit CachedSnapshot(ms::Snapshot const& snapshot) :
+        size{snapshot.size},
+        stride{snapshot.stride},
+        pixels(stride.as_uint32_t() * size.height.as_uint32_t())
+    {
+        std::memcpy(pixels.data(), snapshot.pixels, pixels.size());
+    }
+
+    auto snapshot() const -> ms::Snapshot
+    {
+        return {size, stride, pixels.data()};
+    }
+
+    geom::Size const size;
+    geom::Stride const stride;
+    std::vector<char> pixels;
+};
+
+struct SnapshotKey
+{
+    uint64_t submission;
+    geom::Size max_size;
+
+    bool operator<(SnapshotKey const& other) const
+    {
+        if (submission != other.submission)
+            return submission < other.submission;
+        if (max_size.width != other.max_size.width)
+            return max_size.width < other.max_size.width;
+        return max_size.height < other.max_size.height;
+    }
+};
+
+/**
+ * The most recently used snapshots, by the submission they were taken of.
+ *
+ * Clients may draw afresh in a buffer they submitted before (mirclient
+ * streams cycle through a few), but not in one they have submitted since
+ * it was shown, so the content of a submission doesn't change.
+ */
+class SnapshotCache
+{
+public:
+    auto find(SnapshotKey const& key) -> std::shared_ptr<CachedSnapshot const>
+    {
+        for (auto i = entries.begin(); i != entries.end(); ++i)
+        {
+            if (!(i->first < key) && !(key < i->first))
+            {
+                entries.splice(entries.begin(), entries, i);
+                return i->second;
+            }
+        }
+        return {};
+    }
+
+    auto insert(SnapshotKey const& key, ms::Snapshot const& snapshot) -> std::shared_ptr<CachedSnapshot const>
+    {
+        auto const cached = std::make_shared<CachedSnapshot const>(snapshot);
+        auto const size = cached->pixels.size();
+
+        if (size <= cache_budget)
+        {
+            entries.emplace_front(key, cached);
+            bytes += size;
+
+            while (bytes > cache_budget)
+            {
+                bytes -= entries.back().second->pixels.size();
+                entries.pop_back();
+            }
+        }
+
+        return cached;
+    }
+
+private:
+    std::list<std::pair<SnapshotKey, std::shared_ptr<CachedSnapshot const>>> entries;
+    std::size_t bytes{0};
+};
+}
+
 namespace mir
 {
 namespace scene
@@ -36,6 +131,7 @@ namespace scene
 struct WorkItem
 {
     std::shared_ptr<compositor::BufferStream> const stream;
+    geometry::Size const max_size;
     ms::SnapshotCallback const snapshot_taken;
 };
 
@@ -51,36 +147,79 @@ public:
     {
         mir::set_thread_name("Mir/Snapshot");
         std::unique_lock<std::mutex> lock{work_mutex};
+        bool reading{false};
 
         while (running)
         {
-            while (running && work.empty())
+            if (work.empty() && !reading)
+            {
                 work_cv.wait(lock);
+                continue;
+            }
 
-            if (running)
-            {
-                auto wi = work.front();
-                work.pop_front();
+            std::deque<WorkItem> items;
+            items.swap(work);
 
-                lock.unlock();
+            lock.unlock();
 
+            // Start reading everything asked for before waiting for any of it
+            for (auto const& wi : items)
                 take_snapshot(wi);
 
-                lock.lock();
-            }
+            reading = pixels->collect(items.empty());
+            notify();
+
+            lock.lock();
         }
+
+        lock.unlock();
+
+        // Don't leave snapshots we've started on untaken
+        while (pixels->collect(true))
+        {
+        }
+        notify();
     }
 
     void take_snapshot(WorkItem const& wi)
     {
-        wi.stream->with_most_recent_buffer_do([this](mir::graphics::Buffer& buffer) {
-            pixels->fill_from(buffer);
-        });
-
-        wi.snapshot_taken(
-            ms::Snapshot{pixels->size(),
-                     pixels->stride(),
-                     pixels->as_argb_8888()});
+        wi.stream->with_most_recent_submission_do([this, &wi](mir::graphics::Buffer& buffer, uint64_t submission)
+            {
+                if (!submission)
+                {
+                    // Without knowing which submission this is we can't tell whether it has been redrawn
+                    auto const snapshot_taken = wi.snapshot_taken;
+                    pixels->fill_from(buffer, wi.max_size, [this, snapshot_taken](ms::Snapshot const& snapshot)
+                        {
+                            ready.emplace_back(
+                                snapshot_taken,
+                                snapshot.pixels ? std::make_shared<CachedSnapshot const>(snapshot) : nullptr);
+                        });
+                    return;
+                }
+
+                SnapshotKey const key{submission, wi.max_size};
+
+                if (auto const cached = cache.find(key))
+                {
+                    ready.emplace_back(wi.snapshot_taken, cached);
+                    return;
+                }
+
+                // Snapshots of the same buffer can share a read
+                auto& waiting = in_flight[key];
+                waiting.push_back(wi.snapshot_taken);
+
+                if (waiting.size() == 1)
+                {
+                    pixels->fill_from(buffer, wi.max_size,
+                        [this, key](ms::Snapshot const& snapshot) { pixels_read(key, snapshot); });
+                }
+            });
+
+        // The stream may be locked while we're in with_most_recent_submission_do(),
+        // so leave calling back until we're out of it
+        notify();
     }
 
     void schedule_snapshot(WorkItem const& wi)
@@ -98,11 +237,37 @@ public:
     }
 
 private:
+    void pixels_read(SnapshotKey const& key, ms::Snapshot const& snapshot)
+    {
+        std::shared_ptr<CachedSnapshot const> cached;
+        if (snapshot.pixels)
+            cached = cache.insert(key, snapshot);
+
+        auto const waiting = in_flight.find(key);
+        for (auto const& snapshot_taken : waiting->second)
+            ready.emplace_back(snapshot_taken, cached);
+        in_flight.erase(waiting);
+    }
+
+    void notify()
+    {
+        decltype(ready) to_notify;
+        to_notify.swap(ready);
+
+        for (auto const& item : to_notify)
+            item.first(item.second ? item.second->snapshot() : ms::Snapshot{});
+    }
+
     bool running;
     std::shared_ptr<PixelBuffer> const pixels;
     std::mutex work_mutex;
     std::condition_variable work_cv;
     std::deque<WorkItem> work;
+
+    // Only used on the snapshot thread
+    SnapshotCache cache;
+    std::map<SnapshotKey, std::vector<ms::SnapshotCallback>> in_flight;
+    std::vector<std::pair<ms::SnapshotCallback, std::shared_ptr<CachedSnapshot const>>> ready;
 };
 
 }
@@ -126,5 +291,13 @@ void ms::ThreadedSnapshotStrategy::take_snapshot_of(
     std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
     SnapshotCallback const& snapshot_taken)
 {
-    functor->schedule_snapshot(WorkItem{surface_buffer_access, snapshot_taken});
+    functor->schedule_snapshot(WorkItem{surface_buffer_access, {}, snapshot_taken});
+}
+
+void ms::ThreadedSnapshotStrategy::take_thumbnail_of(
+    std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
+    geometry::Size const& max_size,
+    SnapshotCallback const& thumbnail_taken)
+{
+    functor->schedule_snapshot(WorkItem{surface_buffer_access, max_size, thumbnail_taken});
 }
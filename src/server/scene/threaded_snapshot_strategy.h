@@ -42,6 +42,11 @@ public:
         std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
         SnapshotCallback const& snapshot_taken);
 
+    void take_thumbnail_of(
+        std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
+        geometry::Size const& max_size,
+        SnapshotCallback const& thumbnail_taken);
+
 private:
     std::shared_ptr<PixelBuffer> const pixels;
     std::unique_ptr<SnapshottingFunctor> functor;
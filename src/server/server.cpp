@@ -110,6 +110,7 @@ struct TemporaryCompositeEventFilter : public mi::CompositeEventFilter
 
 #define FOREACH_ACCESSOR(MACRO)\
     MACRO(the_buffer_stream_factory)\
+    MACRO(the_clock)\
     MACRO(the_compositor)\
     MACRO(the_compositor_report)\
     MACRO(the_cursor_listener)\
@@ -122,6 +123,7 @@ struct TemporaryCompositeEventFilter : public mi::CompositeEventFilter
     MACRO(the_input_targeter)\
     MACRO(the_logger)\
     MACRO(the_main_loop)\
+    MACRO(the_memory_accounting)\
     MACRO(the_prompt_session_listener)\
     MACRO(the_session_authorizer)\
     MACRO(the_session_coordinator)\
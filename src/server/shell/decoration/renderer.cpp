@@ -22,6 +22,7 @@
 #include "input.h"
 
 #include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/graphics/pixel_conversion.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/geometry/displacement.h"
 #include "mir/log.h"
@@ -106,10 +107,10 @@ inline void render_row(
         return;
     geom::X const right = std::min(left.x + as_delta(length), as_x(buf_size.width));
     left.x = std::max(left.x, geom::X{});
+    if (right <= left.x)
+        return;
     uint32_t* const start = data + (left.y.as_int() * buf_size.width.as_int()) + left.x.as_int();
-    uint32_t* const end = start + right.as_int() - left.x.as_int();
-    for (uint32_t* i = start; i < end; i++)
-        *i = color;
+    mg::fill_pixels(start, right.as_int() - left.x.as_int(), color);
 }
 
 inline void render_close_icon(
@@ -540,13 +541,7 @@ auto msd::Renderer::render_titlebar() -> std::experimental::optional<std::shared
 
     if (needs_titlebar_redraw)
     {
-        for (geom::Y y{0}; y < as_y(titlebar_size.height); y += geom::DeltaY{1})
-        {
-            render_row(
-                titlebar_pixels.get(), titlebar_size,
-                {0, y}, titlebar_size.width,
-                current_theme->background_color);
-        }
+        mg::fill_pixels(titlebar_pixels.get(), area(titlebar_size), current_theme->background_color);
 
         text->render(
             titlebar_pixels.get(),
@@ -22,6 +22,7 @@
 #include <deque>
 #include <algorithm>
 #include <condition_variable>
+#include <thread>
 
 namespace mt = mir::thread;
 
@@ -43,6 +44,10 @@ public:
         {
             task_exception = std::current_exception();
         }
+
+        // Its captures may use the pool as they're destroyed, so drop them
+        // before the worker takes the pool's lock again
+        task = nullptr;
     }
 
     void notify_done()
@@ -59,115 +64,97 @@ public:
     }
 
 private:
-    std::function<void()> const task;
+    std::function<void()> task;
     std::promise<void> promise;
     std::exception_ptr task_exception;
 };
-
-class Worker
-{
-public:
-    Worker() : exiting{false}
-    {
-    }
-
-    ~Worker()
-    {
-        exit();
-    }
-
-    void operator()() noexcept
-    try
-    {
-       std::unique_lock<std::mutex> lock{state_mutex};
-       while (!exiting)
-       {
-           task_available_cv.wait(lock, [&]{ return exiting || !tasks.empty(); });
-
-           if (!exiting)
-           {
-               auto task = std::move(tasks.front());
-               lock.unlock();
-               task.execute();
-               lock.lock();
-               tasks.pop_front();
-               task.notify_done();
-           }
-       }
-    }
-    catch(...)
-    {
-        mir::terminate_with_current_exception();
-    }
-
-    void queue_task(Task task)
-    {
-        std::lock_guard<std::mutex> lock{state_mutex};
-        tasks.push_back(std::move(task));
-        task_available_cv.notify_one();
-    }
-
-    void exit()
-    {
-        std::lock_guard<std::mutex> lock{state_mutex};
-        exiting = true;
-        task_available_cv.notify_one();
-    }
-
-    bool is_idle() const
-    {
-        std::lock_guard<std::mutex> lock{state_mutex};
-        return tasks.empty();
-    }
-
-private:
-    std::deque<Task> tasks;
-    bool exiting;
-    std::mutex mutable state_mutex;
-    std::condition_variable task_available_cv;
-};
-
 }
 
 namespace mir
 {
 namespace thread
 {
+/// A worker's queue and state are guarded by the pool's mutex, so the pool can
+/// inspect and feed all its workers without taking a lock per worker.
 class WorkerThread
 {
 public:
-    WorkerThread(mt::BasicThreadPool::TaskId an_id)
-        : thread{std::ref(worker)},
-          id_{an_id}
+    WorkerThread(std::mutex& pool_mutex, mt::BasicThreadPool::TaskId an_id)
+        : pool_mutex(pool_mutex),
+          id_{an_id},
+          thread{[this] { run(); }}
     {}
 
     ~WorkerThread()
     {
-        worker.exit();
+        {
+            std::lock_guard<std::mutex> lock{pool_mutex};
+            exiting = true;
+            task_available_cv.notify_one();
+        }
+
         if (thread.joinable())
             thread.join();
     }
 
+    /// \pre the pool mutex is held
     void queue_task(Task task, mt::BasicThreadPool::TaskId the_id)
     {
-        worker.queue_task(std::move(task));
+        tasks.push_back(std::move(task));
         id_ = the_id;
+        task_available_cv.notify_one();
     }
 
+    /// \pre the pool mutex is held
     bool is_idle() const
     {
-        return worker.is_idle();
+        return !busy && tasks.empty();
     }
 
+    /// \pre the pool mutex is held
     mt::BasicThreadPool::TaskId current_id() const
     {
         return id_;
     }
 
 private:
-    ::Worker worker;
-    std::thread thread;
+    void run() noexcept
+    try
+    {
+        std::unique_lock<std::mutex> lock{pool_mutex};
+        while (!exiting)
+        {
+            task_available_cv.wait(lock, [&]{ return exiting || !tasks.empty(); });
+
+            if (!exiting)
+            {
+                auto task = std::move(tasks.front());
+                tasks.pop_front();
+                busy = true;
+
+                lock.unlock();
+                task.execute();
+                lock.lock();
+
+                // Only report completion once we're idle again, so a caller that
+                // waits on the future and then shrink()s sees this thread as idle
+                busy = false;
+                task.notify_done();
+            }
+        }
+    }
+    catch(...)
+    {
+        mir::terminate_with_current_exception();
+    }
+
+    std::mutex& pool_mutex;
+    std::deque<Task> tasks;
+    bool busy{false};
+    bool exiting{false};
+    std::condition_variable task_available_cv;
     mt::BasicThreadPool::TaskId id_;
+    std::thread thread;
 };
 }
 }
@@ -204,7 +191,7 @@ std::future<void> mt::BasicThreadPool::run(WorkerThread* worker_thread,
     if (worker_thread == nullptr)
     {
         // No idle threads available so create a new one
-        auto new_worker_thread = std::make_unique<WorkerThread>(id);
+        auto new_worker_thread = std::make_unique<WorkerThread>(mutex, id);
         threads.push_back(std::move(new_worker_thread));
         worker_thread = threads.back().get();
     }
@@ -218,19 +205,27 @@ std::future<void> mt::BasicThreadPool::run(WorkerThread* worker_thread,
 
 void mt::BasicThreadPool::shrink()
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
+    // Workers need the pool mutex to notice they are exiting, so they
+    // must be joined (destroyed) after we've released it
+    std::vector<std::unique_ptr<WorkerThread>> removed;
 
-    int max_threads_to_remove = threads.size() - min_threads;
-    auto it = std::remove_if(threads.begin(), threads.end(),
-        [&max_threads_to_remove](std::unique_ptr<WorkerThread> const& worker_thread)
-        {
-            bool remove = worker_thread->is_idle() && max_threads_to_remove > 0;
-            if (remove)
-                max_threads_to_remove--;
-            return remove;
-        }
-    );
-    threads.erase(it, threads.end());
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+
+        int max_threads_to_remove = threads.size() - min_threads;
+        auto it = std::stable_partition(threads.begin(), threads.end(),
+            [&max_threads_to_remove](std::unique_ptr<WorkerThread> const& worker_thread)
+            {
+                bool remove = worker_thread->is_idle() && max_threads_to_remove > 0;
+                if (remove)
+                    max_threads_to_remove--;
+                return !remove;
+            }
+        );
+
+        std::move(it, threads.end(), std::back_inserter(removed));
+        threads.erase(it, threads.end());
+    }
 }
 
 mt::WorkerThread* mt::BasicThreadPool::find_thread_by(TaskId id)
@@ -0,0 +1,368 @@
+/*
+ * AUTOGENERATED - DO NOT EDIT
+ *
+ * This file is generated from wlr-screencopy-unstable-v1.xml
+ * To regenerate, run the “refresh-wayland-wrapper” target.
+ */
+
+#include "wlr-screencopy-unstable-v1_wrapper.h"
+
+#include <boost/throw_exception.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include <wayland-server-core.h>
+
+#include "mir/log.h"
+
+namespace mir
+{
+namespace wayland
+{
+extern struct wl_interface const wl_buffer_interface_data;
+extern struct wl_interface const wl_output_interface_data;
+extern struct wl_interface const zwlr_screencopy_frame_v1_interface_data;
+extern struct wl_interface const zwlr_screencopy_manager_v1_interface_data;
+}
+}
+
+namespace mw = mir::wayland;
+
+namespace
+{
+struct wl_interface const* all_null_types [] {
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr};
+}
+
+// ScreencopyManagerV1
+
+mw::ScreencopyManagerV1* mw::ScreencopyManagerV1::from(struct wl_resource* resource)
+{
+    return static_cast<ScreencopyManagerV1*>(wl_resource_get_user_data(resource));
+}
+
+struct mw::ScreencopyManagerV1::Thunks
+{
+    static int const supported_version;
+
+    static void capture_output_thunk(struct wl_client* client, struct wl_resource* resource, uint32_t frame, int32_t overlay_cursor, struct wl_resource* output)
+    {
+        auto me = static_cast<ScreencopyManagerV1*>(wl_resource_get_user_data(resource));
+        wl_resource* frame_resolved{
+            wl_resource_create(client, &zwlr_screencopy_frame_v1_interface_data, wl_resource_get_version(resource), frame)};
+        if (frame_resolved == nullptr)
+        {
+            wl_client_post_no_memory(client);
+            BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+        }
+        try
+        {
+            me->capture_output(frame_resolved, overlay_cursor, output);
+        }
+        catch(...)
+        {
+            internal_error_processing_request(client, "ScreencopyManagerV1::capture_output()");
+        }
+    }
+
+    static void capture_output_region_thunk(struct wl_client* client, struct wl_resource* resource, uint32_t frame, int32_t overlay_cursor, struct wl_resource* output, int32_t x, int32_t y, int32_t width, int32_t height)
+    {
+        auto me = static_cast<ScreencopyManagerV1*>(wl_resource_get_user_data(resource));
+        wl_resource* frame_resolved{
+            wl_resource_create(client, &zwlr_screencopy_frame_v1_interface_data, wl_resource_get_version(resource), frame)};
+        if (frame_resolved == nullptr)
+        {
+            wl_client_post_no_memory(client);
+            BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+        }
+        try
+        {
+            me->capture_output_region(frame_resolved, overlay_cursor, output, x, y, width, height);
+        }
+        catch(...)
+        {
+            internal_error_processing_request(client, "ScreencopyManagerV1::capture_output_region()");
+        }
+    }
+
+    static void destroy_thunk(struct wl_client* client, struct wl_resource* resource)
+    {
+        auto me = static_cast<ScreencopyManagerV1*>(wl_resource_get_user_data(resource));
+        try
+        {
+            me->destroy();
+        }
+        catch(...)
+        {
+            internal_error_processing_request(client, "ScreencopyManagerV1::destroy()");
+        }
+    }
+
+    static void resource_destroyed_thunk(wl_resource* resource)
+    {
+        delete static_cast<ScreencopyManagerV1*>(wl_resource_get_user_data(resource));
+    }
+
+    static void bind_thunk(struct wl_client* client, void* data, uint32_t version, uint32_t id)
+    {
+        auto me = static_cast<ScreencopyManagerV1::Global*>(data);
+        auto resource = wl_resource_create(
+            client,
+            &zwlr_screencopy_manager_v1_interface_data,
+            std::min((int)version, Thunks::supported_version),
+            id);
+        if (resource == nullptr)
+        {
+            wl_client_post_no_memory(client);
+            BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+        }
+        try
+        {
+            me->bind(resource);
+        }
+        catch(...)
+        {
+            internal_error_processing_request(client, "ScreencopyManagerV1 global bind");
+        }
+    }
+
+    static struct wl_interface const* capture_output_types[];
+    static struct wl_interface const* capture_output_region_types[];
+    static struct wl_message const request_messages[];
+    static void const* request_vtable[];
+};
+
+int const mw::ScreencopyManagerV1::Thunks::supported_version = 2;
+
+mw::ScreencopyManagerV1::ScreencopyManagerV1(struct wl_resource* resource, Version<2>)
+    : client{wl_resource_get_client(resource)},
+      resource{resource}
+{
+    if (resource == nullptr)
+    {
+        BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+    }
+    wl_resource_set_implementation(resource, Thunks::request_vtable, this, &Thunks::resource_destroyed_thunk);
+}
+
+mw::ScreencopyManagerV1::~ScreencopyManagerV1()
+{
+    wl_resource_set_implementation(resource, nullptr, nullptr, nullptr);
+}
+
+bool mw::ScreencopyManagerV1::is_instance(wl_resource* resource)
+{
+    return wl_resource_instance_of(resource, &zwlr_screencopy_manager_v1_interface_data, Thunks::request_vtable);
+}
+
+void mw::ScreencopyManagerV1::destroy_wayland_object() const
+{
+    wl_resource_destroy(resource);
+}
+
+mw::ScreencopyManagerV1::Global::Global(wl_display* display, Version<2>)
+    : wayland::Global{
+          wl_global_create(
+              display,
+              &zwlr_screencopy_manager_v1_interface_data,
+              Thunks::supported_version,
+              this,
+              &Thunks::bind_thunk)}
+{
+}
+
+auto mw::ScreencopyManagerV1::Global::interface_name() const -> char const*
+{
+    return ScreencopyManagerV1::interface_name;
+}
+
+struct wl_interface const* mw::ScreencopyManagerV1::Thunks::capture_output_types[] {
+    &zwlr_screencopy_frame_v1_interface_data,
+    nullptr,
+    &wl_output_interface_data};
+
+struct wl_interface const* mw::ScreencopyManagerV1::Thunks::capture_output_region_types[] {
+    &zwlr_screencopy_frame_v1_interface_data,
+    nullptr,
+    &wl_output_interface_data,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr};
+
+struct wl_message const mw::ScreencopyManagerV1::Thunks::request_messages[] {
+    {"capture_output", "nio", capture_output_types},
+    {"capture_output_region", "nioiiii", capture_output_region_types},
+    {"destroy", "", all_null_types}};
+
+void const* mw::ScreencopyManagerV1::Thunks::request_vtable[] {
+    (void*)Thunks::capture_output_thunk,
+    (void*)Thunks::capture_output_region_thunk,
+    (void*)Thunks::destroy_thunk};
+
+// ScreencopyFrameV1
+
+mw::ScreencopyFrameV1* mw::ScreencopyFrameV1::from(struct wl_resource* resource)
+{
+    return static_cast<ScreencopyFrameV1*>(wl_resource_get_user_data(resource));
+}
+
+struct mw::ScreencopyFrameV1::Thunks
+{
+    static int const supported_version;
+
+    static void copy_thunk(struct wl_client* client, struct wl_resource* resource, struct wl_resource* buffer)
+    {
+        auto me = static_cast<ScreencopyFrameV1*>(wl_resource_get_user_data(resource));
+        try
+        {
+            me->copy(buffer);
+        }
+        catch(...)
+        {
+            internal_error_processing_request(client, "ScreencopyFrameV1::copy()");
+        }
+    }
+
+    static void destroy_thunk(struct wl_client* client, struct wl_resource* resource)
+    {
+        auto me = static_cast<ScreencopyFrameV1*>(wl_resource_get_user_data(resource));
+        try
+        {
+            me->destroy();
+        }
+        catch(...)
+        {
+            internal_error_processing_request(client, "ScreencopyFrameV1::destroy()");
+        }
+    }
+
+    static void copy_with_damage_thunk(struct wl_client* client, struct wl_resource* resource, struct wl_resource* buffer)
+    {
+        auto me = static_cast<ScreencopyFrameV1*>(wl_resource_get_user_data(resource));
+        try
+        {
+            me->copy_with_damage(buffer);
+        }
+        catch(...)
+        {
+            internal_error_processing_request(client, "ScreencopyFrameV1::copy_with_damage()");
+        }
+    }
+
+    static void resource_destroyed_thunk(wl_resource* resource)
+    {
+        delete static_cast<ScreencopyFrameV1*>(wl_resource_get_user_data(resource));
+    }
+
+    static struct wl_interface const* copy_types[];
+    static struct wl_interface const* copy_with_damage_types[];
+    static struct wl_message const request_messages[];
+    static struct wl_message const event_messages[];
+    static void const* request_vtable[];
+};
+
+int const mw::ScreencopyFrameV1::Thunks::supported_version = 2;
+
+mw::ScreencopyFrameV1::ScreencopyFrameV1(struct wl_resource* resource, Version<2>)
+    : client{wl_resource_get_client(resource)},
+      resource{resource}
+{
+    if (resource == nullptr)
+    {
+        BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+    }
+    wl_resource_set_implementation(resource, Thunks::request_vtable, this, &Thunks::resource_destroyed_thunk);
+}
+
+mw::ScreencopyFrameV1::~ScreencopyFrameV1()
+{
+    wl_resource_set_implementation(resource, nullptr, nullptr, nullptr);
+}
+
+void mw::ScreencopyFrameV1::send_buffer_event(uint32_t format, uint32_t width, uint32_t height, uint32_t stride) const
+{
+    wl_resource_post_event(resource, Opcode::buffer, format, width, height, stride);
+}
+
+void mw::ScreencopyFrameV1::send_flags_event(uint32_t flags) const
+{
+    wl_resource_post_event(resource, Opcode::flags, flags);
+}
+
+void mw::ScreencopyFrameV1::send_ready_event(uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec) const
+{
+    wl_resource_post_event(resource, Opcode::ready, tv_sec_hi, tv_sec_lo, tv_nsec);
+}
+
+void mw::ScreencopyFrameV1::send_failed_event() const
+{
+    wl_resource_post_event(resource, Opcode::failed);
+}
+
+bool mw::ScreencopyFrameV1::version_supports_damage()
+{
+    return wl_resource_get_version(resource) >= 2;
+}
+
+void mw::ScreencopyFrameV1::send_damage_event(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const
+{
+    wl_resource_post_event(resource, Opcode::damage, x, y, width, height);
+}
+
+bool mw::ScreencopyFrameV1::is_instance(wl_resource* resource)
+{
+    return wl_resource_instance_of(resource, &zwlr_screencopy_frame_v1_interface_data, Thunks::request_vtable);
+}
+
+void mw::ScreencopyFrameV1::destroy_wayland_object() const
+{
+    wl_resource_destroy(resource);
+}
+
+struct wl_interface const* mw::ScreencopyFrameV1::Thunks::copy_types[] {
+    &wl_buffer_interface_data};
+
+struct wl_interface const* mw::ScreencopyFrameV1::Thunks::copy_with_damage_types[] {
+    &wl_buffer_interface_data};
+
+struct wl_message const mw::ScreencopyFrameV1::Thunks::request_messages[] {
+    {"copy", "o", copy_types},
+    {"destroy", "", all_null_types},
+    {"copy_with_damage", "2o", copy_with_damage_types}};
+
+struct wl_message const mw::ScreencopyFrameV1::Thunks::event_messages[] {
+    {"buffer", "uuuu", all_null_types},
+    {"flags", "u", all_null_types},
+    {"ready", "uuu", all_null_types},
+    {"failed", "", all_null_types},
+    {"damage", "2uuuu", all_null_types}};
+
+void const* mw::ScreencopyFrameV1::Thunks::request_vtable[] {
+    (void*)Thunks::copy_thunk,
+    (void*)Thunks::destroy_thunk,
+    (void*)Thunks::copy_with_damage_thunk};
+
+namespace mir
+{
+namespace wayland
+{
+
+struct wl_interface const zwlr_screencopy_manager_v1_interface_data {
+    mw::ScreencopyManagerV1::interface_name,
+    mw::ScreencopyManagerV1::Thunks::supported_version,
+    3, mw::ScreencopyManagerV1::Thunks::request_messages,
+    0, nullptr};
+
+struct wl_interface const zwlr_screencopy_frame_v1_interface_data {
+    mw::ScreencopyFrameV1::interface_name,
+    mw::ScreencopyFrameV1::Thunks::supported_version,
+    3, mw::ScreencopyFrameV1::Thunks::request_messages,
+    5, mw::ScreencopyFrameV1::Thunks::event_messages};
+
+}
+}
@@ -45,6 +45,8 @@ struct MockBufferStream : public compositor::BufferStream
             .WillByDefault(testing::Invoke(this, &MockBufferStream::buffers_ready));
         ON_CALL(*this, with_most_recent_buffer_do(testing::_))
             .WillByDefault(testing::InvokeArgument<0>(testing::ByRef(*buffer)));
+        ON_CALL(*this, with_most_recent_submission_do(testing::_))
+            .WillByDefault(testing::InvokeArgument<0>(testing::ByRef(*buffer), uint64_t{0}));
         ON_CALL(*this, acquire_client_buffer(testing::_))
             .WillByDefault(testing::InvokeArgument<0>(nullptr));
         ON_CALL(*this, has_submitted_buffer())
@@ -73,6 +75,9 @@ struct MockBufferStream : public compositor::BufferStream
 
     MOCK_METHOD1(submit_buffer, void(std::shared_ptr<graphics::Buffer> const&));
     MOCK_METHOD1(with_most_recent_buffer_do, void(std::function<void(graphics::Buffer&)> const&));
+    MOCK_METHOD1(with_most_recent_submission_do,
+                 void(std::function<void(graphics::Buffer&, uint64_t)> const&));
+    MOCK_CONST_METHOD1(submission_of, uint64_t(graphics::BufferID));
     MOCK_CONST_METHOD0(pixel_format, MirPixelFormat());
     MOCK_CONST_METHOD0(has_submitted_buffer, bool());
     MOCK_METHOD1(disassociate_buffer, void(graphics::BufferID));
@@ -43,6 +43,10 @@ public:
                  void(compositor::CompositorReport::SubCompositorId));
     MOCK_METHOD1(finished_frame,
                  void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD2(gpu_timed_frame,
+                 void(compositor::CompositorReport::SubCompositorId, renderer::GPUTiming const&));
+    MOCK_METHOD2(texture_cache_used,
+                 void(compositor::CompositorReport::SubCompositorId, renderer::TextureCacheUsage const&));
     MOCK_METHOD0(started, void());
     MOCK_METHOD0(stopped, void());
     MOCK_METHOD0(scheduled, void());
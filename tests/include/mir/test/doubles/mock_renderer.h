@@ -35,6 +35,9 @@ struct MockRenderer : public renderer::Renderer
     MOCK_METHOD1(set_output_transform, void(glm::mat2 const&));
     MOCK_CONST_METHOD1(render, void(graphics::RenderableList const&));
     MOCK_METHOD0(suspend, void());
+    MOCK_METHOD0(completed_gpu_timings, std::vector<renderer::GPUTiming>());
+    MOCK_METHOD0(texture_cache_usage, renderer::TextureCacheUsage());
+    MOCK_METHOD1(read_back, void(std::shared_ptr<renderer::Readback> const&));
 
     ~MockRenderer() noexcept {}
 };
@@ -46,6 +46,7 @@ struct MockSceneSession : public scene::Session
     MOCK_CONST_METHOD1(surface_after, std::shared_ptr<scene::Surface>(std::shared_ptr<scene::Surface> const&));
 
     MOCK_METHOD1(take_snapshot, void(scene::SnapshotCallback const&));
+    MOCK_METHOD2(take_thumbnail, void(geometry::Size const&, scene::SnapshotCallback const&));
     MOCK_CONST_METHOD0(default_surface, std::shared_ptr<scene::Surface>());
 
     MOCK_CONST_METHOD0(name, std::string());
@@ -68,6 +69,7 @@ struct MockSceneSession : public scene::Session
     MOCK_METHOD1(destroy_buffer_stream, void(std::shared_ptr<frontend::BufferStream> const&));
     
     MOCK_METHOD2(configure_streams, void(scene::Surface&, std::vector<shell::StreamSpecification> const&));
+    MOCK_CONST_METHOD0(memory_account, std::shared_ptr<scene::MemoryAccount>());
     MOCK_METHOD1(destroy_surface, void (std::weak_ptr<scene::Surface> const&));
 };
 
@@ -30,10 +30,11 @@ namespace doubles
 
 struct NullPixelBuffer : public scene::PixelBuffer
 {
-    void fill_from(graphics::Buffer&) {}
-    void const* as_argb_8888() { return nullptr; }
-    geometry::Size size() const { return {}; }
-    geometry::Stride stride() const { return {}; }
+    void fill_from(graphics::Buffer&, geometry::Size const&, scene::SnapshotCallback const& pixels_read)
+    {
+        pixels_read(scene::Snapshot{});
+    }
+    bool collect(bool) { return false; }
 };
 
 }
@@ -69,6 +69,12 @@ public:
     {
         fn(*stub_compositor_buffer);
     }
+    void with_most_recent_submission_do(
+        std::function<void(graphics::Buffer&, uint64_t)> const& fn) override
+    {
+        fn(*stub_compositor_buffer, submission);
+    }
+    uint64_t submission_of(graphics::BufferID) const override { return submission; }
     MirPixelFormat pixel_format() const override { return mir_pixel_format_abgr_8888; }
     void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
     bool has_submitted_buffer() const override { return true; }
@@ -76,6 +82,7 @@ public:
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
     int nready = 0;
+    uint64_t submission = 1;
 };
 
 }
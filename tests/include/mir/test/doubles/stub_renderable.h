@@ -60,6 +60,13 @@ public:
     void set_buffer(std::shared_ptr<graphics::Buffer> const& buffer)
     {
         stub_buffer = buffer;
+        ++submission_;
+    }
+
+    /// As if the client submitted the same buffer again, drawn afresh
+    void resubmit()
+    {
+        ++submission_;
     }
 
     ID id() const override
@@ -70,6 +77,10 @@ public:
     {
         return stub_buffer;
     }
+    uint64_t submission() const override
+    {
+        return submission_;
+    }
     geometry::Rectangle screen_position() const override
     {
         return rect;
@@ -106,6 +117,7 @@ private:
     glm::mat4 trans;
     geometry::Rectangle const rect;
     std::shared_ptr<graphics::Buffer> stub_buffer;
+    uint64_t submission_{1};
 };
 
 struct StubTransformedRenderable : public StubRenderable
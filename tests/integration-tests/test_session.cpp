@@ -104,7 +104,8 @@ TEST(ApplicationSession, stress_test_take_snapshot)
         conf.the_snapshot_strategy(),
         std::make_shared<ms::NullSessionListener>(),
         std::make_shared<mtd::NullEventSink>(),
-        conf.the_buffer_allocator()
+        conf.the_buffer_allocator(),
+        conf.the_memory_accounting()
     };
 
     mg::BufferProperties properties(geom::Size{1,1}, mir_pixel_format_abgr_8888, mg::BufferUsage::software);
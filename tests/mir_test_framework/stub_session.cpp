@@ -42,6 +42,12 @@ void mtd::StubSession::take_snapshot(
 {
 }
 
+void mtd::StubSession::take_thumbnail(
+    mir::geometry::Size const& /*max_size*/,
+    mir::scene::SnapshotCallback const& /*thumbnail_taken*/)
+{
+}
+
 std::shared_ptr<mir::scene::Surface> mtd::StubSession::default_surface() const
 {
     return {};
@@ -118,6 +124,11 @@ void mtd::StubSession::send_input_config(MirInputConfig const& /*config*/)
 {
 }
 
+auto mtd::StubSession::memory_account() const -> std::shared_ptr<ms::MemoryAccount>
+{
+    return {};
+}
+
 namespace
 {
 // Ensure we don't accidentally have an abstract class
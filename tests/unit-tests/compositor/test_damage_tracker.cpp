@@ -0,0 +1,157 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/damage_tracker.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct MovableRenderable : mtd::FakeRenderable
+{
+    explicit MovableRenderable(geom::Rectangle const& position) :
+        mtd::FakeRenderable{position},
+        position{position}
+    {
+    }
+
+    geom::Rectangle screen_position() const override
+    {
+        return position;
+    }
+
+    geom::Rectangle position;
+};
+
+auto rects(std::initializer_list<geom::Rectangle> list) -> geom::Rectangles
+{
+    return geom::Rectangles{list};
+}
+
+struct DamageTracker : Test
+{
+    geom::Rectangle const view_area{{0, 0}, {800, 600}};
+    std::shared_ptr<MovableRenderable> const window{
+        std::make_shared<MovableRenderable>(geom::Rectangle{{10, 10}, {100, 100}})};
+    std::shared_ptr<MovableRenderable> const other{
+        std::make_shared<MovableRenderable>(geom::Rectangle{{200, 200}, {50, 50}})};
+    mc::DamageTracker tracker;
+};
+}
+
+TEST_F(DamageTracker, first_frame_is_all_damaged)
+{
+    EXPECT_THAT(tracker.damage_for(view_area, {window}), Eq(rects({view_area})));
+}
+
+TEST_F(DamageTracker, unchanged_frame_has_no_damage)
+{
+    tracker.damage_for(view_area, {window, other});
+
+    EXPECT_THAT(tracker.damage_for(view_area, {window, other}).size(), Eq(0u));
+}
+
+TEST_F(DamageTracker, new_buffer_damages_where_it_is_shown)
+{
+    tracker.damage_for(view_area, {window, other});
+
+    window->set_buffer(std::make_shared<mtd::StubBuffer>());
+
+    EXPECT_THAT(tracker.damage_for(view_area, {window, other}), Eq(rects({window->position})));
+}
+
+TEST_F(DamageTracker, moving_damages_where_it_was_and_is)
+{
+    tracker.damage_for(view_area, {window});
+    auto const was = window->position;
+
+    window->position.top_left = {300, 300};
+
+    EXPECT_THAT(tracker.damage_for(view_area, {window}), Eq(rects({was, window->position})));
+}
+
+TEST_F(DamageTracker, removing_damages_where_it_was)
+{
+    tracker.damage_for(view_area, {window, other});
+
+    EXPECT_THAT(tracker.damage_for(view_area, {window}), Eq(rects({other->position})));
+}
+
+TEST_F(DamageTracker, restacking_damages_what_moved_in_the_stack)
+{
+    tracker.damage_for(view_area, {window, other});
+
+    EXPECT_THAT(tracker.damage_for(view_area, {other, window}), Eq(rects({window->position})));
+}
+
+TEST_F(DamageTracker, damage_is_clipped_to_the_view)
+{
+    tracker.damage_for(view_area, {});
+
+    window->position = {{700, 500}, {200, 200}};
+
+    EXPECT_THAT(tracker.damage_for(view_area, {window}), Eq(rects({{{700, 500}, {100, 100}}})));
+}
+
+TEST_F(DamageTracker, reset_damages_all_of_next_frame)
+{
+    tracker.damage_for(view_area, {window});
+    tracker.reset();
+
+    EXPECT_THAT(tracker.damage_for(view_area, {window}), Eq(rects({view_area})));
+}
+
+TEST(AddDamage, ignores_what_is_already_damaged)
+{
+    geom::Rectangles damage{geom::Rectangle{{0, 0}, {100, 100}}};
+
+    mc::add_damage(damage, {{10, 10}, {10, 10}});
+
+    EXPECT_THAT(damage, Eq(rects({{{0, 0}, {100, 100}}})));
+}
+
+TEST(AddDamage, replaces_what_the_new_damage_covers)
+{
+    geom::Rectangles damage{geom::Rectangle{{10, 10}, {10, 10}}};
+
+    mc::add_damage(damage, {{0, 0}, {100, 100}});
+
+    EXPECT_THAT(damage, Eq(rects({{{0, 0}, {100, 100}}})));
+}
+
+TEST(AddDamage, collapses_to_bounds_when_there_is_too_much_to_track)
+{
+    geom::Rectangles damage;
+
+    for (int i = 0; i != 16; ++i)
+        mc::add_damage(damage, {{i * 10, 0}, {5, 5}});
+
+    ASSERT_THAT(damage.size(), Eq(16u));
+
+    mc::add_damage(damage, {{160, 0}, {5, 5}});
+
+    EXPECT_THAT(damage, Eq(rects({{{0, 0}, {165, 5}}})));
+}
@@ -20,6 +20,7 @@
 #include "mir/compositor/display_buffer_compositor.h"
 #include "src/server/report/null_report_factory.h"
 #include "mir/compositor/scene.h"
+#include "mir/compositor/screen_capture.h"
 #include "mir/renderer/renderer.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/test/doubles/mock_renderer.h"
@@ -184,6 +185,52 @@ TEST_F(DefaultDisplayBufferCompositor, rendering_reports_everything)
     compositor.composite(make_scene_elements({}));
 }
 
+TEST_F(DefaultDisplayBufferCompositor, reports_gpu_timings_of_earlier_frames)
+{
+    using namespace testing;
+    using namespace std::chrono_literals;
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    mir::renderer::GPUTiming const timing{mir::renderer::GPUTiming::Method::timer_query, 3ms, {{1ms, 2ms, 0ms}}};
+
+    Sequence seq;
+    EXPECT_CALL(mock_renderer, render(_))
+        .InSequence(seq);
+    EXPECT_CALL(mock_renderer, completed_gpu_timings())
+        .InSequence(seq)
+        .WillOnce(Return(std::vector<mir::renderer::GPUTiming>{timing, timing}));
+    EXPECT_CALL(*report, gpu_timed_frame(_, Field(&mir::renderer::GPUTiming::frame_time, Eq(3ms))))
+        .Times(2);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        report);
+    compositor.composite(make_scene_elements({}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, reports_texture_cache_usage_of_rendered_frames)
+{
+    using namespace testing;
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    mir::renderer::TextureCacheUsage const usage{5, 2, 1, 4096, 8192};
+
+    Sequence seq;
+    EXPECT_CALL(mock_renderer, render(_))
+        .InSequence(seq);
+    EXPECT_CALL(mock_renderer, texture_cache_usage())
+        .InSequence(seq)
+        .WillOnce(Return(usage));
+    EXPECT_CALL(*report, texture_cache_used(_, Field(&mir::renderer::TextureCacheUsage::hits, Eq(5u))));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        report);
+    compositor.composite(make_scene_elements({}));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, calls_renderer_in_sequence)
 {
     using namespace testing;
@@ -388,3 +435,63 @@ TEST_F(DefaultDisplayBufferCompositor, marks_occluded_scene_elements)
     compositor.composite({element0_occluded, element1_rendered, element2_occluded});
 }
 
+TEST_F(DefaultDisplayBufferCompositor, keeps_rendering_a_bypassed_surface_until_its_capture_is_read)
+{
+    using namespace testing;
+
+    struct MockCaptureTarget : mc::CaptureTarget
+    {
+        MOCK_METHOD3(write, void(geom::Rectangle const&, unsigned char const*, geom::Stride));
+        MOCK_METHOD1(captured, void(geom::Rectangles const&));
+        MOCK_METHOD0(failed, void());
+    };
+
+    auto const screen_capture = std::make_shared<mc::ScreenCapture>(
+        []{}, [this] { return std::vector<geom::Rectangle>{screen}; });
+    auto const session = screen_capture->open_session(screen);
+    auto const target = std::make_shared<NiceMock<MockCaptureTarget>>();
+
+    // As with pixel-pack buffers, readbacks only complete in a later frame than they're read from
+    std::vector<std::shared_ptr<mir::renderer::Readback>> requested, in_flight;
+    ON_CALL(mock_renderer, read_back(_))
+        .WillByDefault(Invoke([&](auto const& readback) { requested.push_back(readback); }));
+    ON_CALL(mock_renderer, render(_))
+        .WillByDefault(InvokeWithoutArgs([&]
+            {
+                for (auto const& readback : in_flight)
+                    readback->finished(true);
+                in_flight = std::move(requested);
+                requested.clear();
+            }));
+    ON_CALL(display_buffer, overlay(_))
+        .WillByDefault(Return(true));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        screen_capture);
+
+    session->capture(1, target, false);
+
+    // The frame captured is rendered, to be read back...
+    EXPECT_CALL(display_buffer, overlay(_))
+        .Times(0);
+    EXPECT_CALL(mock_renderer, read_back(_));
+    EXPECT_CALL(mock_renderer, render(_));
+    compositor.composite(make_scene_elements({fullscreen}));
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+
+    // ...and so is the next, rather than bypassed, so the readback completes...
+    EXPECT_CALL(mock_renderer, render(_));
+    EXPECT_CALL(*target, captured(_));
+    compositor.composite(make_scene_elements({fullscreen}));
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    Mock::VerifyAndClearExpectations(&display_buffer);
+
+    // ...after which the surface is bypassed again
+    EXPECT_CALL(display_buffer, overlay(_));
+    EXPECT_CALL(mock_renderer, render(_))
+        .Times(0);
+    compositor.composite(make_scene_elements({fullscreen}));
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/input_latency_tracker.h"
+#include "src/server/report/metrics/registry.h"
+
+#include "mir/events/event_builders.h"
+#include "mir/scene/surface_observer.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/stub_buffer_stream.h"
+#include "mir/test/doubles/stub_surface.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace mc = mir::compositor;
+namespace ms = mir::scene;
+namespace mrm = mir::report::metrics;
+namespace mev = mir::events;
+namespace mtd = mir::test::doubles;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct ClientSurface : mtd::StubSurface
+{
+    std::string name() const override
+    {
+        return "client";
+    }
+
+    std::shared_ptr<mir::frontend::BufferStream> primary_buffer_stream() const override
+    {
+        return stream;
+    }
+
+    void add_observer(std::shared_ptr<ms::SurfaceObserver> const& observer) override
+    {
+        observers.push_back(observer);
+    }
+
+    void remove_observer(std::weak_ptr<ms::SurfaceObserver> const& observer) override
+    {
+        auto const removed = observer.lock();
+        observers.erase(std::remove(observers.begin(), observers.end(), removed), observers.end());
+    }
+
+    void consume(MirEvent const* event) override
+    {
+        for (auto const& observer : observers)
+            observer->input_consumed(this, event);
+    }
+
+    void submit_frame()
+    {
+        for (auto const& observer : observers)
+            observer->frame_posted(this, 1, {});
+    }
+
+    auto renderable_id() const -> mir::graphics::Renderable::ID
+    {
+        return stream.get();
+    }
+
+    std::shared_ptr<mtd::StubBufferStream> const stream = std::make_shared<mtd::StubBufferStream>();
+    std::vector<std::shared_ptr<ms::SurfaceObserver>> observers;
+};
+
+struct InputLatencyTracker : Test
+{
+    std::shared_ptr<mrm::Registry> const registry = std::make_shared<mrm::Registry>();
+    std::shared_ptr<mtd::AdvanceableClock> const clock = std::make_shared<mtd::AdvanceableClock>();
+    std::shared_ptr<ClientSurface> const surface = std::make_shared<ClientSurface>();
+    mc::InputLatencyTracker tracker{registry, clock};
+
+    InputLatencyTracker()
+    {
+        tracker.surface_added(surface);
+    }
+
+    /// A key press acquired by the input platform now
+    void press_key()
+    {
+        auto const event = mev::make_event(
+            MirInputDeviceId(0), clock->now().time_since_epoch(), std::vector<uint8_t>{},
+            mir_keyboard_action_down, 0, 0, mir_input_event_modifier_none);
+        surface->consume(event.get());
+    }
+
+    void composite_and_post(std::vector<mir::graphics::Renderable::ID> const& rendered, mir::time::Duration duration)
+    {
+        auto const began = tracker.frame_began();
+        clock->advance_by(duration);
+        tracker.frame_posted(began, rendered);
+    }
+
+    auto metrics() const -> std::string
+    {
+        std::ostringstream out;
+        registry->write(out);
+        return out.str();
+    }
+};
+}
+
+TEST_F(InputLatencyTracker, records_each_stage_of_a_response_to_input)
+{
+    press_key();
+    clock->advance_by(20ms);
+    surface->submit_frame();
+    composite_and_post({surface->renderable_id()}, 10ms);
+
+    auto const text = metrics();
+
+    EXPECT_THAT(text, HasSubstr("mir_input_dispatch_seconds_count{client=\"client\"} 1\n"));
+    EXPECT_THAT(text, HasSubstr("mir_input_response_seconds_sum{client=\"client\"} 0.02\n"));
+    EXPECT_THAT(text, HasSubstr("mir_input_present_seconds_sum{client=\"client\"} 0.01\n"));
+    EXPECT_THAT(text, HasSubstr("mir_input_to_present_seconds_sum{client=\"client\"} 0.03\n"));
+    EXPECT_THAT(text, HasSubstr("mir_input_to_present_seconds_count{client=\"client\"} 1\n"));
+}
+
+TEST_F(InputLatencyTracker, measures_from_the_earliest_unanswered_input)
+{
+    press_key();
+    clock->advance_by(5ms);
+    press_key();
+    clock->advance_by(5ms);
+    surface->submit_frame();
+    composite_and_post({surface->renderable_id()}, 0ms);
+
+    auto const text = metrics();
+
+    EXPECT_THAT(text, HasSubstr("mir_input_dispatch_seconds_count{client=\"client\"} 2\n"));
+    EXPECT_THAT(text, HasSubstr("mir_input_to_present_seconds_sum{client=\"client\"} 0.01\n"));
+    EXPECT_THAT(text, HasSubstr("mir_input_to_present_seconds_count{client=\"client\"} 1\n"));
+}
+
+TEST_F(InputLatencyTracker, ignores_frames_not_answering_input)
+{
+    surface->submit_frame();
+    composite_and_post({surface->renderable_id()}, 10ms);
+
+    EXPECT_THAT(metrics(), Not(HasSubstr("mir_input_to_present_seconds_count{client=\"client\"} 1")));
+}
+
+TEST_F(InputLatencyTracker, waits_for_a_frame_composited_after_the_response)
+{
+    press_key();
+
+    // A frame that began before the client answered can't contain the answer
+    auto const began = tracker.frame_began();
+    clock->advance_by(5ms);
+    surface->submit_frame();
+    tracker.frame_posted(began, {surface->renderable_id()});
+
+    EXPECT_THAT(metrics(), HasSubstr("mir_input_to_present_seconds_count{client=\"client\"} 0\n"));
+
+    composite_and_post({surface->renderable_id()}, 10ms);
+
+    EXPECT_THAT(metrics(), HasSubstr("mir_input_to_present_seconds_count{client=\"client\"} 1\n"));
+    EXPECT_THAT(metrics(), HasSubstr("mir_input_to_present_seconds_sum{client=\"client\"} 0.015\n"));
+}
+
+TEST_F(InputLatencyTracker, waits_for_a_frame_that_renders_the_surface)
+{
+    press_key();
+    surface->submit_frame();
+    composite_and_post({}, 10ms);
+
+    EXPECT_THAT(metrics(), HasSubstr("mir_input_to_present_seconds_count{client=\"client\"} 0\n"));
+}
+
+TEST_F(InputLatencyTracker, stops_observing_removed_surfaces)
+{
+    ASSERT_THAT(surface->observers, SizeIs(1));
+
+    tracker.surface_removed(surface);
+
+    EXPECT_THAT(surface->observers, IsEmpty());
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/screen_capture.h"
+#include "mir/renderer/renderer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <vector>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct MockCaptureTarget : mc::CaptureTarget
+{
+    MOCK_METHOD3(write, void(geom::Rectangle const&, unsigned char const*, geom::Stride));
+    MOCK_METHOD1(captured, void(geom::Rectangles const&));
+    MOCK_METHOD0(failed, void());
+};
+
+struct ScreenCapture : Test
+{
+    geom::Rectangle const output{{0, 0}, {800, 600}};
+    geom::Rectangle const area{{100, 100}, {200, 200}};
+    std::vector<geom::Rectangle> outputs{output};
+    int frames_scheduled{0};
+    mc::ScreenCapture capture{[this] { ++frames_scheduled; }, [this] { return outputs; }};
+    std::shared_ptr<mc::ScreenCapture::Session> session{capture.open_session(area)};
+    std::shared_ptr<NiceMock<MockCaptureTarget>> const target{std::make_shared<NiceMock<MockCaptureTarget>>()};
+    mc::ScreenCapture::BufferKey const key{1};
+
+    /// Completes \a readback as a renderer would
+    void read(mir::renderer::Readback& readback)
+    {
+        for (auto const& region : readback.regions())
+        {
+            std::vector<unsigned char> pixels(region.size.width.as_int() * region.size.height.as_int() * 4);
+            readback.deliver(region, pixels.data(), geom::Stride{region.size.width.as_int() * 4});
+        }
+        readback.finished(true);
+    }
+
+    void capture_frame(geom::Rectangles const& damage, geom::Rectangle const& view_area)
+    {
+        for (auto const& readback : capture.frame(view_area, damage))
+            read(*readback);
+    }
+
+    void capture_frame(geom::Rectangles const& damage)
+    {
+        capture_frame(damage, output);
+    }
+};
+}
+
+TEST_F(ScreenCapture, is_active_while_a_session_is_open)
+{
+    EXPECT_TRUE(capture.active());
+
+    session.reset();
+
+    EXPECT_FALSE(capture.active());
+}
+
+TEST_F(ScreenCapture, capturing_schedules_a_frame)
+{
+    session->capture(key, target, false);
+
+    EXPECT_THAT(frames_scheduled, Eq(1));
+}
+
+TEST_F(ScreenCapture, first_capture_into_a_buffer_copies_all_of_the_area)
+{
+    session->capture(key, target, false);
+
+    auto const readbacks = capture.frame(output, {});
+
+    ASSERT_THAT(readbacks.size(), Eq(1u));
+    EXPECT_THAT(readbacks.front()->regions(), Eq(geom::Rectangles{area}));
+
+    geom::Rectangle const whole{{0, 0}, area.size};
+    EXPECT_CALL(*target, write(whole, _, _));
+    EXPECT_CALL(*target, captured(geom::Rectangles{whole}));
+
+    read(*readbacks.front());
+}
+
+TEST_F(ScreenCapture, recapture_without_damage_completes_at_once)
+{
+    session->capture(key, target, false);
+    capture_frame({});
+    frames_scheduled = 0;
+
+    EXPECT_CALL(*target, write(_, _, _)).Times(0);
+    EXPECT_CALL(*target, captured(geom::Rectangles{}));
+
+    session->capture(key, target, false);
+
+    EXPECT_THAT(frames_scheduled, Eq(0));
+}
+
+TEST_F(ScreenCapture, recapture_copies_only_what_was_damaged)
+{
+    session->capture(key, target, false);
+    capture_frame({});
+
+    capture_frame({geom::Rectangle{{150, 150}, {10, 10}}, geom::Rectangle{{700, 500}, {10, 10}}});
+
+    session->capture(key, target, false);
+
+    geom::Rectangle const damaged{{50, 50}, {10, 10}};
+    EXPECT_CALL(*target, write(damaged, _, _));
+    EXPECT_CALL(*target, captured(geom::Rectangles{damaged}));
+
+    capture_frame({});
+}
+
+TEST_F(ScreenCapture, waiting_for_damage_completes_on_first_damaged_frame)
+{
+    session->capture(key, target, false);
+    capture_frame({});
+
+    session->capture(key, target, true);
+
+    EXPECT_CALL(*target, captured(_)).Times(0);
+    capture_frame({});
+    capture_frame({geom::Rectangle{{700, 500}, {10, 10}}});
+    Mock::VerifyAndClearExpectations(target.get());
+
+    EXPECT_CALL(*target, captured(geom::Rectangles{geom::Rectangle{{0, 0}, {10, 10}}}));
+    capture_frame({geom::Rectangle{{100, 100}, {10, 10}}});
+}
+
+TEST_F(ScreenCapture, failed_readback_fails_capture_and_copies_all_next_time)
+{
+    session->capture(key, target, false);
+    capture_frame({});
+
+    capture_frame({geom::Rectangle{{100, 100}, {10, 10}}});
+    session->capture(key, target, false);
+
+    EXPECT_CALL(*target, failed());
+    for (auto const& readback : capture.frame(output, {}))
+        readback->finished(false);
+    Mock::VerifyAndClearExpectations(target.get());
+
+    session->capture(key, target, false);
+
+    geom::Rectangle const whole{{0, 0}, area.size};
+    EXPECT_CALL(*target, captured(geom::Rectangles{whole}));
+    capture_frame({});
+}
+
+TEST_F(ScreenCapture, areas_on_other_outputs_are_not_read)
+{
+    session->capture(key, target, false);
+
+    EXPECT_THAT(capture.frame({{800, 0}, {800, 600}}, {}), IsEmpty());
+}
+
+TEST_F(ScreenCapture, areas_on_no_output_fail_at_once)
+{
+    outputs = {geom::Rectangle{{800, 0}, {800, 600}}};
+
+    EXPECT_CALL(*target, failed());
+
+    session->capture(key, target, false);
+
+    EXPECT_THAT(frames_scheduled, Eq(0));
+}
+
+TEST_F(ScreenCapture, areas_spanning_outputs_complete_once_each_output_is_read)
+{
+    geom::Rectangle const right{{800, 0}, {800, 600}};
+    outputs.push_back(right);
+    auto const spanning = capture.open_session({{700, 100}, {200, 200}});
+
+    spanning->capture(key, target, false);
+
+    EXPECT_CALL(*target, write(geom::Rectangle{{0, 0}, {100, 200}}, _, _));
+    EXPECT_CALL(*target, captured(_)).Times(0);
+    capture_frame({});
+    Mock::VerifyAndClearExpectations(target.get());
+
+    geom::Rectangle const left_part{{0, 0}, {100, 200}};
+    geom::Rectangle const right_part{{100, 0}, {100, 200}};
+    EXPECT_CALL(*target, write(right_part, _, _));
+    EXPECT_CALL(*target, captured(geom::Rectangles{left_part, right_part}));
+    capture_frame({}, right);
+}
+
+TEST_F(ScreenCapture, waiting_for_damage_on_one_output_reads_the_others_too)
+{
+    geom::Rectangle const right{{800, 0}, {800, 600}};
+    outputs.push_back(right);
+    auto const spanning = capture.open_session({{700, 100}, {200, 200}});
+
+    spanning->capture(key, target, false);
+    capture_frame({});
+    capture_frame({}, right);
+
+    spanning->capture(key, target, true);
+    frames_scheduled = 0;
+    capture_frame({}, right);
+    capture_frame({geom::Rectangle{{700, 100}, {10, 10}}});
+
+    EXPECT_THAT(frames_scheduled, Eq(1));
+
+    EXPECT_CALL(*target, write(_, _, _)).Times(0);
+    EXPECT_CALL(*target, captured(geom::Rectangles{geom::Rectangle{{0, 0}, {10, 10}}}));
+    capture_frame({}, right);
+}
+
+TEST_F(ScreenCapture, forgotten_buffers_are_copied_whole)
+{
+    session->capture(key, target, false);
+    capture_frame({});
+    session->forget(key);
+
+    session->capture(key, target, false);
+
+    auto const readbacks = capture.frame(output, {});
+    ASSERT_THAT(readbacks.size(), Eq(1u));
+    EXPECT_THAT(readbacks.front()->regions(), Eq(geom::Rectangles{area}));
+}
+
+TEST(CopyCapturedPixels, swaps_red_and_blue_for_argb_formats)
+{
+    unsigned char const rgba[] = {1, 2, 3, 4};
+    unsigned char bgra[4] = {};
+
+    EXPECT_TRUE(mc::copy_captured_pixels({1, 1}, rgba, geom::Stride{4}, bgra, 4, mir_pixel_format_argb_8888));
+
+    EXPECT_THAT(bgra, ElementsAre(3, 2, 1, 4));
+}
+
+TEST(CopyCapturedPixels, copies_bottom_up_with_negative_stride)
+{
+    unsigned char const rows[] = {1, 1, 1, 1, 2, 2, 2, 2};
+    unsigned char flipped[8] = {};
+
+    EXPECT_TRUE(mc::copy_captured_pixels(
+        {1, 2}, rows, geom::Stride{4}, flipped + 4, -4, mir_pixel_format_abgr_8888));
+
+    EXPECT_THAT(flipped, ElementsAre(2, 2, 2, 2, 1, 1, 1, 1));
+}
+
+TEST(CopyCapturedPixels, rejects_formats_that_are_not_32_bit_rgb)
+{
+    unsigned char const pixels[4] = {};
+    unsigned char dest[4] = {};
+
+    EXPECT_FALSE(mc::copy_captured_pixels({1, 1}, pixels, geom::Stride{4}, dest, 4, mir_pixel_format_rgb_565));
+}
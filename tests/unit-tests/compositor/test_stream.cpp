@@ -241,3 +241,40 @@ TEST_F(Stream, stream_remembers_scale_when_buffer_added)
     stream.submit_buffer(buffers[0]);
     ASSERT_THAT(stream.stream_size(), Eq(initial_size / 2));
 }
+
+TEST_F(Stream, tells_resubmissions_of_a_buffer_apart)
+{
+    auto const submission_shown = [this]
+        {
+            uint64_t shown{0};
+            stream.with_most_recent_submission_do([&](mg::Buffer&, uint64_t submission) { shown = submission; });
+            return shown;
+        };
+
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    auto const first = submission_shown();
+
+    stream.submit_buffer(buffers[1]);
+    stream.lock_compositor_buffer(this);
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    auto const second = submission_shown();
+
+    EXPECT_THAT(first, Ne(0u));
+    EXPECT_THAT(second, Ne(0u));
+    EXPECT_THAT(second, Ne(first));
+}
+
+TEST_F(Stream, knows_the_latest_submission_of_a_composited_buffer)
+{
+    stream.submit_buffer(buffers[0]);
+    auto const first = stream.submission_of(stream.lock_compositor_buffer(this)->id());
+
+    stream.submit_buffer(buffers[0]);
+    auto const second = stream.submission_of(stream.lock_compositor_buffer(this)->id());
+
+    EXPECT_THAT(first, Ne(0u));
+    EXPECT_THAT(second, Ne(first));
+    EXPECT_THAT(stream.submission_of(buffers[1]->id()), Eq(0u));
+}
@@ -28,6 +28,7 @@
 #include <fcntl.h>
 
 #include <atomic>
+#include <stdexcept>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -490,3 +491,148 @@ TEST(MultiplexingDispatchableTest, automatic_removals_are_threadsafe)
     
     dispatchee->trigger();
 }
+
+TEST(MultiplexingDispatchableTest, source_removed_by_an_earlier_dispatch_in_the_same_batch_is_not_dispatched)
+{
+    md::MultiplexingDispatchable dispatcher;
+
+    // Whichever of the two is dispatched first removes the other
+    int dispatched{0};
+    std::weak_ptr<md::Dispatchable> first_watched, second_watched;
+    auto const first = std::make_shared<mt::TestDispatchable>([&]()
+        {
+            ++dispatched;
+            if (auto const other = second_watched.lock())
+                dispatcher.remove_watch(other);
+        });
+    auto const second = std::make_shared<mt::TestDispatchable>([&]()
+        {
+            ++dispatched;
+            if (auto const other = first_watched.lock())
+                dispatcher.remove_watch(other);
+        });
+    first_watched = first;
+    second_watched = second;
+
+    dispatcher.add_watch(first);
+    dispatcher.add_watch(second);
+
+    first->trigger();
+    second->trigger();
+
+    // Both are ready, so are taken in one batch
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(1));
+}
+
+TEST(MultiplexingDispatchableTest, sources_later_in_the_batch_still_fire_after_a_dispatch_throws)
+{
+    using namespace testing;
+
+    auto const throwing = std::make_shared<mt::TestDispatchable>([]()
+        {
+            throw std::runtime_error{"Dispatch failed"};
+        });
+
+    bool dispatched{false};
+    auto const later = std::make_shared<mt::TestDispatchable>([&dispatched]() { dispatched = true; });
+
+    md::MultiplexingDispatchable dispatcher{throwing, later};
+
+    // epoll reports ready sources in the order they became ready
+    throwing->trigger();
+    later->trigger();
+
+    EXPECT_THROW(dispatcher.dispatch(md::FdEvent::readable), std::runtime_error);
+
+    for (int i = 0; i != 5 && !dispatched && mt::fd_is_readable(dispatcher.watch_fd()); ++i)
+        dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_TRUE(dispatched);
+}
+
+TEST(MultiplexingDispatchableTest, concurrent_dispatchers_each_take_a_single_event)
+{
+    using namespace testing;
+
+    auto const in_first = std::make_shared<mt::Signal>();
+    auto const release_first = std::make_shared<mt::Signal>();
+    auto const first = std::make_shared<mt::TestDispatchable>([in_first, release_first]()
+        {
+            in_first->raise();
+            EXPECT_TRUE(release_first->wait_for(std::chrono::seconds{5}));
+        });
+
+    std::atomic<int> others_dispatched{0};
+    auto const second = std::make_shared<mt::TestDispatchable>([&others_dispatched]() { ++others_dispatched; });
+    auto const third = std::make_shared<mt::TestDispatchable>([&others_dispatched]() { ++others_dispatched; });
+
+    md::MultiplexingDispatchable dispatcher{first, second, third};
+
+    first->trigger();
+
+    mt::AutoJoinThread first_dispatcher{[&dispatcher]() { dispatcher.dispatch(md::FdEvent::readable); }};
+    ASSERT_TRUE(in_first->wait_for(std::chrono::seconds{5}));
+
+    second->trigger();
+    third->trigger();
+
+    // With the first thread still dispatching, this one shouldn't batch
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(others_dispatched, Eq(1));
+    EXPECT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+
+    release_first->raise();
+}
+
+TEST(MultiplexingDispatchableTest, batch_in_progress_is_handed_back_once_another_thread_dispatches)
+{
+    using namespace testing;
+
+    auto const in_first = std::make_shared<mt::Signal>();
+    auto const release_first = std::make_shared<mt::Signal>();
+    auto const first = std::make_shared<mt::TestDispatchable>([in_first, release_first]()
+        {
+            in_first->raise();
+            EXPECT_TRUE(release_first->wait_for(std::chrono::seconds{5}));
+        });
+
+    std::atomic<bool> second_dispatched{false};
+    auto const second = std::make_shared<mt::TestDispatchable>([&second_dispatched]() { second_dispatched = true; });
+
+    auto const in_third = std::make_shared<mt::Signal>();
+    auto const release_third = std::make_shared<mt::Signal>();
+    auto const third = std::make_shared<mt::TestDispatchable>([in_third, release_third]()
+        {
+            in_third->raise();
+            EXPECT_TRUE(release_third->wait_for(std::chrono::seconds{5}));
+        });
+
+    md::MultiplexingDispatchable dispatcher{first, second, third};
+
+    // The first thread takes both of these in one batch...
+    first->trigger();
+    second->trigger();
+    mt::AutoJoinThread first_dispatcher{[&dispatcher]() { dispatcher.dispatch(md::FdEvent::readable); }};
+    ASSERT_TRUE(in_first->wait_for(std::chrono::seconds{5}));
+
+    // ...and, while another thread is dispatching, hands back the rest of it
+    third->trigger();
+    mt::AutoJoinThread third_dispatcher{[&dispatcher]() { dispatcher.dispatch(md::FdEvent::readable); }};
+    ASSERT_TRUE(in_third->wait_for(std::chrono::seconds{5}));
+
+    release_first->raise();
+    first_dispatcher.stop();
+
+    EXPECT_FALSE(second_dispatched);
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_TRUE(second_dispatched);
+
+    release_third->raise();
+}
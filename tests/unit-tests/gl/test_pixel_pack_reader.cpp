@@ -0,0 +1,248 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/gl/pixel_pack_reader.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <map>
+
+namespace mgl = mir::gl;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+GLenum const pixel_pack_buffer{0x88EB};     // GL_PIXEL_PACK_BUFFER
+GLenum const timeout_expired{0x911B};       // GL_TIMEOUT_EXPIRED
+GLenum const condition_satisfied{0x911C};   // GL_CONDITION_SATISFIED
+std::uint64_t const timeout_ignored{~0ull}; // GL_TIMEOUT_IGNORED
+
+// Stand-ins for the GLES 3 entry points PixelPackReader looks up
+GLuint bound_buffer{0};
+std::map<GLuint, unsigned char> buffer_contents;
+GLuint unmappable_buffer{0};
+GLenum fence_status{timeout_expired};
+std::vector<std::uint64_t> waits;
+
+void* fake_glMapBufferRange(GLenum, GLintptr, GLsizeiptr, GLbitfield)
+{
+    if (bound_buffer == unmappable_buffer)
+        return nullptr;
+
+    return &buffer_contents[bound_buffer];
+}
+
+GLboolean fake_glUnmapBuffer(GLenum)
+{
+    return GL_TRUE;
+}
+
+void* fake_glFenceSync(GLenum, GLbitfield)
+{
+    return &fence_status;
+}
+
+GLenum fake_glClientWaitSync(void*, GLbitfield, std::uint64_t timeout)
+{
+    waits.push_back(timeout);
+    return timeout == timeout_ignored ? condition_satisfied : fence_status;
+}
+
+void fake_glDeleteSync(void*)
+{
+}
+
+struct PixelPackReader : Test
+{
+    PixelPackReader()
+    {
+        using func_ptr_t = mtd::MockEGL::generic_function_pointer_t;
+
+        ON_CALL(mock_gl, glGetString(GL_VERSION))
+            .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.0")));
+        ON_CALL(mock_gl, glGenBuffers(1, _))
+            .WillByDefault(Invoke([this](GLsizei, GLuint* buffer) { *buffer = ++buffers_generated; }));
+        ON_CALL(mock_gl, glBindBuffer(pixel_pack_buffer, _))
+            .WillByDefault(SaveArg<1>(&bound_buffer));
+        ON_CALL(mock_gl, glReadPixels(_, _, _, _, _, _, _))
+            .WillByDefault(InvokeWithoutArgs([] { buffer_contents[bound_buffer] = bound_buffer; }));
+
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glMapBufferRange")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glMapBufferRange)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glUnmapBuffer")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glUnmapBuffer)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glFenceSync")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glFenceSync)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glClientWaitSync")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glClientWaitSync)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glDeleteSync")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glDeleteSync)));
+
+        buffer_contents.clear();
+        unmappable_buffer = 0;
+        fence_status = timeout_expired;
+        waits.clear();
+    }
+
+    /// A Deliver that keeps the first byte of each rectangle read, or -1 for those not read
+    auto keep_reads() -> mgl::PixelPackReader::Deliver
+    {
+        return [this](std::vector<unsigned char const*> const& rows)
+            {
+                std::vector<int> read;
+                for (auto const rect_rows : rows)
+                    read.push_back(rect_rows ? *rect_rows : -1);
+                delivered.push_back(read);
+            };
+    }
+
+    NiceMock<mtd::MockGL> mock_gl;
+    NiceMock<mtd::MockEGL> mock_egl;
+
+    GLuint buffers_generated{0};
+    std::vector<std::vector<int>> delivered;
+
+    std::vector<geom::Rectangle> const two_rects{{{0, 0}, {4, 4}}, {{4, 0}, {2, 6}}};
+};
+}
+
+TEST_F(PixelPackReader, is_not_created_before_gles_3)
+{
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 2.0 Mesa")));
+
+    EXPECT_THAT(mgl::PixelPackReader::create(4), IsNull());
+}
+
+TEST_F(PixelPackReader, is_created_for_gl_3_2)
+{
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("3.2.0 Mesa")));
+
+    EXPECT_THAT(mgl::PixelPackReader::create(4), NotNull());
+}
+
+TEST_F(PixelPackReader, is_not_created_without_all_its_entry_points)
+{
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glClientWaitSync")))
+        .WillByDefault(Return(nullptr));
+
+    EXPECT_THAT(mgl::PixelPackReader::create(4), IsNull());
+}
+
+TEST_F(PixelPackReader, reads_each_rectangle_into_a_buffer_of_its_own)
+{
+    EXPECT_CALL(mock_gl, glBufferData(pixel_pack_buffer, 4 * 4 * 4, nullptr, _));
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, 4, 4, GL_RGBA, GL_UNSIGNED_BYTE, IsNull()));
+    EXPECT_CALL(mock_gl, glBufferData(pixel_pack_buffer, 2 * 6 * 4, nullptr, _));
+    EXPECT_CALL(mock_gl, glReadPixels(4, 0, 2, 6, GL_RGBA, GL_UNSIGNED_BYTE, IsNull()));
+
+    auto const reader = mgl::PixelPackReader::create(4);
+    reader->read(two_rects, keep_reads());
+
+    fence_status = condition_satisfied;
+    reader->collect(0);
+
+    EXPECT_THAT(delivered, ElementsAre(ElementsAre(1, 2)));
+}
+
+TEST_F(PixelPackReader, delivers_only_once_the_gpu_has_finished)
+{
+    auto const reader = mgl::PixelPackReader::create(4);
+    reader->read(two_rects, keep_reads());
+
+    EXPECT_TRUE(reader->collect(0));
+    EXPECT_TRUE(reader->reading());
+    EXPECT_THAT(delivered, IsEmpty());
+
+    fence_status = condition_satisfied;
+
+    EXPECT_FALSE(reader->collect(0));
+    EXPECT_FALSE(reader->reading());
+    EXPECT_THAT(delivered, SizeIs(1));
+}
+
+TEST_F(PixelPackReader, waits_only_for_the_first_read_collected)
+{
+    auto const reader = mgl::PixelPackReader::create(4);
+    reader->read(two_rects, keep_reads());
+    reader->read(two_rects, keep_reads());
+
+    fence_status = condition_satisfied;
+    reader->collect(1000);
+
+    EXPECT_THAT(waits, ElementsAre(1000u, 0u));
+    EXPECT_THAT(delivered, SizeIs(2));
+}
+
+TEST_F(PixelPackReader, waits_for_the_oldest_read_once_too_many_are_pending)
+{
+    auto const reader = mgl::PixelPackReader::create(1);
+    reader->read(two_rects, keep_reads());
+
+    EXPECT_THAT(delivered, IsEmpty());
+
+    reader->read(two_rects, keep_reads());
+
+    EXPECT_THAT(waits, ElementsAre(timeout_ignored));
+    EXPECT_THAT(delivered, SizeIs(1));
+    EXPECT_TRUE(reader->reading());
+}
+
+TEST_F(PixelPackReader, reuses_buffers_of_delivered_reads)
+{
+    auto const reader = mgl::PixelPackReader::create(4);
+    fence_status = condition_satisfied;
+
+    reader->read(two_rects, keep_reads());
+    reader->collect(0);
+    reader->read(two_rects, keep_reads());
+    reader->collect(0);
+
+    EXPECT_THAT(buffers_generated, Eq(2u));
+    EXPECT_THAT(delivered, SizeIs(2));
+}
+
+TEST_F(PixelPackReader, reports_rectangles_it_fails_to_map)
+{
+    auto const reader = mgl::PixelPackReader::create(4);
+    reader->read(two_rects, keep_reads());
+
+    unmappable_buffer = 2;
+    fence_status = condition_satisfied;
+    reader->collect(0);
+
+    EXPECT_THAT(delivered, ElementsAre(ElementsAre(1, -1)));
+}
+
+TEST_F(PixelPackReader, abandons_pending_reads_and_deletes_its_buffers_when_destroyed)
+{
+    auto reader = mgl::PixelPackReader::create(4);
+    reader->read(two_rects, keep_reads());
+
+    EXPECT_CALL(mock_gl, glDeleteBuffers(2, _));
+
+    reader.reset();
+
+    EXPECT_THAT(delivered, ElementsAre(ElementsAre(-1, -1)));
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/gl/recently_used_cache.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/stub_gl_buffer.h"
+#include "mir/test/doubles/stub_renderable.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace mgl = mir::gl;
+namespace mr = mir::renderer;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+std::size_t const texture_bytes{16 * 16 * 4};
+
+auto gl_buffer() -> std::shared_ptr<mtd::StubGLBuffer>
+{
+    return std::make_shared<mtd::StubGLBuffer>(
+        mg::BufferProperties{{16, 16}, mir_pixel_format_abgr_8888, mg::BufferUsage::hardware});
+}
+
+struct RecentlyUsedCache : Test
+{
+    /// Draws \a renderables as a frame
+    void frame(mgl::RecentlyUsedCache& cache, std::initializer_list<mtd::StubRenderable const*> renderables)
+    {
+        for (auto const renderable : renderables)
+            cache.load(*renderable);
+        cache.drop_unused();
+    }
+
+    NiceMock<mtd::MockGL> mock_gl;
+    mtd::StubRenderable first{gl_buffer(), {{0, 0}, {16, 16}}};
+    mtd::StubRenderable second{gl_buffer(), {{16, 0}, {16, 16}}};
+    mtd::StubRenderable third{gl_buffer(), {{32, 0}, {16, 16}}};
+};
+}
+
+TEST_F(RecentlyUsedCache, textures_drawn_again_unchanged_are_hits)
+{
+    mgl::RecentlyUsedCache cache;
+
+    frame(cache, {&first});
+    frame(cache, {&first});
+    first.set_buffer(gl_buffer());
+    frame(cache, {&first});
+
+    auto const usage = cache.usage();
+    EXPECT_THAT(usage.hits, Eq(1u));
+    EXPECT_THAT(usage.misses, Eq(2u));
+    EXPECT_THAT(usage.resident_bytes, Eq(texture_bytes));
+}
+
+TEST_F(RecentlyUsedCache, usage_counts_since_last_asked)
+{
+    mgl::RecentlyUsedCache cache;
+
+    frame(cache, {&first});
+    cache.usage();
+    frame(cache, {&first});
+
+    auto const usage = cache.usage();
+    EXPECT_THAT(usage.hits, Eq(1u));
+    EXPECT_THAT(usage.misses, Eq(0u));
+}
+
+TEST_F(RecentlyUsedCache, without_a_budget_textures_not_drawn_are_freed)
+{
+    mgl::RecentlyUsedCache cache;
+
+    frame(cache, {&first});
+    frame(cache, {});
+    frame(cache, {&first});
+
+    auto const usage = cache.usage();
+    EXPECT_THAT(usage.hits, Eq(0u));
+    EXPECT_THAT(usage.misses, Eq(2u));
+    EXPECT_THAT(usage.evictions, Eq(1u));
+}
+
+TEST_F(RecentlyUsedCache, textures_not_drawn_are_kept_within_budget)
+{
+    mgl::RecentlyUsedCache cache{{}, 2 * texture_bytes};
+
+    frame(cache, {&first, &second});
+    frame(cache, {&second});
+    frame(cache, {&first, &second});
+
+    auto const usage = cache.usage();
+    EXPECT_THAT(usage.hits, Eq(3u));
+    EXPECT_THAT(usage.misses, Eq(2u));
+    EXPECT_THAT(usage.evictions, Eq(0u));
+    EXPECT_THAT(usage.budget_bytes, Eq(2 * texture_bytes));
+}
+
+TEST_F(RecentlyUsedCache, buffers_submitted_again_while_not_drawn_are_loaded_again)
+{
+    mgl::RecentlyUsedCache cache{{}, 2 * texture_bytes};
+
+    frame(cache, {&first});
+    frame(cache, {});
+    first.resubmit();
+    frame(cache, {&first});
+
+    auto const usage = cache.usage();
+    EXPECT_THAT(usage.hits, Eq(0u));
+    EXPECT_THAT(usage.misses, Eq(2u));
+}
+
+TEST_F(RecentlyUsedCache, without_submissions_textures_not_drawn_last_frame_are_loaded_again)
+{
+    struct UnknownSubmission : mtd::StubRenderable
+    {
+        using StubRenderable::StubRenderable;
+        uint64_t submission() const override { return 0; }
+    };
+
+    mgl::RecentlyUsedCache cache{{}, 2 * texture_bytes};
+    UnknownSubmission const unknown{gl_buffer(), {{0, 0}, {16, 16}}};
+
+    frame(cache, {&unknown});
+    frame(cache, {});
+    frame(cache, {&unknown});
+    frame(cache, {&unknown});
+
+    auto const usage = cache.usage();
+    EXPECT_THAT(usage.hits, Eq(1u));
+    EXPECT_THAT(usage.misses, Eq(2u));
+}
+
+TEST_F(RecentlyUsedCache, least_recently_drawn_textures_are_evicted_first)
+{
+    mgl::RecentlyUsedCache cache{{}, 2 * texture_bytes};
+
+    frame(cache, {&first});
+    frame(cache, {&second});
+    frame(cache, {&third});
+    EXPECT_THAT(cache.usage().evictions, Eq(1u));
+
+    frame(cache, {&second});
+    EXPECT_THAT(cache.usage().hits, Eq(1u));
+    frame(cache, {&first});
+    EXPECT_THAT(cache.usage().misses, Eq(1u));
+}
+
+TEST_F(RecentlyUsedCache, textures_drawn_in_a_frame_are_kept_over_budget)
+{
+    mgl::RecentlyUsedCache cache{{}, texture_bytes};
+
+    frame(cache, {&first, &second, &third});
+
+    auto const usage = cache.usage();
+    EXPECT_THAT(usage.evictions, Eq(0u));
+    EXPECT_THAT(usage.resident_bytes, Eq(3 * texture_bytes));
+}
+
+TEST_F(RecentlyUsedCache, invalidated_textures_not_drawn_are_freed)
+{
+    mgl::RecentlyUsedCache cache{{}, 2 * texture_bytes};
+
+    frame(cache, {&first, &second});
+    cache.invalidate();
+    frame(cache, {&second});
+
+    auto const usage = cache.usage();
+    EXPECT_THAT(usage.evictions, Eq(1u));
+    EXPECT_THAT(usage.resident_bytes, Eq(texture_bytes));
+}
+
+TEST_F(RecentlyUsedCache, evicted_textures_are_no_longer_charged)
+{
+    std::size_t charged{0};
+    mgl::RecentlyUsedCache cache{
+        [&charged](mg::Renderable::ID, std::size_t bytes)
+        {
+            charged += bytes;
+            return std::shared_ptr<void>(nullptr, [&charged, bytes](void*) { charged -= bytes; });
+        },
+        texture_bytes};
+
+    frame(cache, {&first});
+    EXPECT_THAT(charged, Eq(texture_bytes));
+
+    frame(cache, {&second});
+    EXPECT_THAT(charged, Eq(texture_bytes));
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/gl/texture_atlas.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_renderable.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace mgl = mir::gl;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+auto small_buffer(geom::Size size = {16, 16}) -> std::shared_ptr<mtd::StubBuffer>
+{
+    return std::make_shared<mtd::StubBuffer>(
+        mg::BufferProperties{size, mir_pixel_format_abgr_8888, mg::BufferUsage::software});
+}
+
+struct TextureAtlas : Test
+{
+    /// Loads \a renderable once a frame for \a frames frames, returning the last load
+    auto show(mtd::StubRenderable const& renderable, int frames) -> mgl::TextureAtlas::Entry const*
+    {
+        mgl::TextureAtlas::Entry const* entry{nullptr};
+        for (auto i = 0; i != frames; ++i)
+        {
+            entry = atlas.load(renderable);
+            atlas.drop_unused();
+        }
+        return entry;
+    }
+
+    NiceMock<mtd::MockGL> mock_gl;
+    std::size_t charged{0};
+    mgl::TextureAtlas atlas{
+        [this](mg::Renderable::ID, std::size_t bytes)
+        {
+            charged += bytes;
+            return std::shared_ptr<void>(nullptr, [this, bytes](void*) { charged -= bytes; });
+        }};
+};
+}
+
+TEST_F(TextureAtlas, content_is_not_packed_until_shown_unchanged_for_a_few_frames)
+{
+    mtd::StubRenderable renderable{small_buffer(), {{0, 0}, {16, 16}}};
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_THAT(show(renderable, mgl::TextureAtlas::frames_before_packing), IsNull());
+    Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, _, _, 18, 18, GL_RGBA, GL_UNSIGNED_BYTE, NotNull()));
+    EXPECT_THAT(atlas.load(renderable), NotNull());
+    EXPECT_THAT(charged, Eq(16u * 16u * 4u));
+}
+
+TEST_F(TextureAtlas, packed_content_is_bordered_by_its_edges)
+{
+    auto const buffer = small_buffer({2, 2});
+    uint32_t const pixels[]{0xff0000ff, 0xff00ff00, 0xffff0000, 0xffffffff};
+    buffer->write(reinterpret_cast<unsigned char const*>(pixels), sizeof pixels);
+    mtd::StubRenderable renderable{buffer, {{0, 0}, {2, 2}}};
+
+    std::vector<uint32_t> uploaded;
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, 4, 4, _, _, _))
+        .WillOnce(WithArg<8>(Invoke(
+            [&](void const* texels)
+            {
+                auto const begin = static_cast<uint32_t const*>(texels);
+                uploaded.assign(begin, begin + 16);
+            })));
+
+    auto const entry = show(renderable, mgl::TextureAtlas::frames_before_packing + 1);
+
+    ASSERT_THAT(entry, NotNull());
+    EXPECT_THAT(uploaded, ElementsAre(
+        pixels[0], pixels[0], pixels[1], pixels[1],
+        pixels[0], pixels[0], pixels[1], pixels[1],
+        pixels[2], pixels[2], pixels[3], pixels[3],
+        pixels[2], pixels[2], pixels[3], pixels[3]));
+    EXPECT_THAT(entry->right - entry->left, FloatEq(2.0f / mgl::TextureAtlas::page_size));
+    EXPECT_THAT(entry->bottom - entry->top, FloatEq(2.0f / mgl::TextureAtlas::page_size));
+}
+
+TEST_F(TextureAtlas, large_content_is_not_packed)
+{
+    auto const too_big = mgl::TextureAtlas::max_content_size + 1;
+    mtd::StubRenderable renderable{small_buffer({too_big, 16}), {{0, 0}, {too_big, 16}}};
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    EXPECT_THAT(show(renderable, mgl::TextureAtlas::frames_before_packing + 1), IsNull());
+}
+
+TEST_F(TextureAtlas, new_buffers_are_packed_only_once_shown_unchanged)
+{
+    mtd::StubRenderable renderable{small_buffer(), {{0, 0}, {16, 16}}};
+    ASSERT_THAT(show(renderable, mgl::TextureAtlas::frames_before_packing + 1), NotNull());
+
+    renderable.set_buffer(small_buffer());
+
+    EXPECT_THAT(atlas.load(renderable), IsNull());
+    EXPECT_THAT(charged, Eq(0u));
+    EXPECT_THAT(show(renderable, mgl::TextureAtlas::frames_before_packing + 1), NotNull());
+}
+
+TEST_F(TextureAtlas, content_not_shown_in_a_frame_is_dropped)
+{
+    mtd::StubRenderable renderable{small_buffer(), {{0, 0}, {16, 16}}};
+    ASSERT_THAT(show(renderable, mgl::TextureAtlas::frames_before_packing + 1), NotNull());
+
+    atlas.drop_unused();
+
+    EXPECT_THAT(charged, Eq(0u));
+    EXPECT_THAT(atlas.load(renderable), IsNull());
+}
+
+TEST_F(TextureAtlas, small_content_shares_a_page)
+{
+    mtd::StubRenderable first{small_buffer(), {{0, 0}, {16, 16}}};
+    mtd::StubRenderable second{small_buffer({32, 8}), {{16, 0}, {32, 8}}};
+
+    for (auto i = 0; i != mgl::TextureAtlas::frames_before_packing; ++i)
+    {
+        atlas.load(first);
+        atlas.load(second);
+        atlas.drop_unused();
+    }
+
+    auto const first_entry = atlas.load(first);
+    auto const second_entry = atlas.load(second);
+
+    ASSERT_THAT(first_entry, NotNull());
+    ASSERT_THAT(second_entry, NotNull());
+    EXPECT_THAT(first_entry->page, Eq(second_entry->page));
+    EXPECT_TRUE(first_entry->right <= second_entry->left || second_entry->right <= first_entry->left ||
+                first_entry->bottom <= second_entry->top || second_entry->bottom <= first_entry->top);
+}
@@ -3,22 +3,31 @@
 #include "src/server/graphics/offscreen/display.h"
 #include "mir/graphics/default_display_configuration_policy.h"
 #include "mir/renderer/gl/render_target.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "src/renderers/software/renderer.h"
+#include "src/renderers/software/renderer_factory.h"
 #include "src/server/report/null_report_factory.h"
 
 #include "mir/test/doubles/mock_egl.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_renderer.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_renderable.h"
 #include "mir/test/as_render_target.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <stdexcept>
 
 namespace mg=mir::graphics;
 namespace mgo=mir::graphics::offscreen;
+namespace mrs = mir::renderer::software;
 namespace mtd=mir::test::doubles;
 namespace mr = mir::report;
 namespace mt = mir::test;
+namespace geom = mir::geometry;
 
 namespace
 {
@@ -44,6 +53,15 @@ public:
     ::testing::NiceMock<mtd::MockEGL> mock_egl;
     ::testing::NiceMock<mtd::MockGL> mock_gl;
     EGLNativeDisplayType const native_display{reinterpret_cast<EGLNativeDisplayType>(0x12345)};
+    std::vector<geom::Size> const output_sizes{{1024, 768}};
+};
+
+struct StubGLRendererFactory : mir::renderer::RendererFactory
+{
+    std::unique_ptr<mir::renderer::Renderer> create_renderer_for(mg::DisplayBuffer&) override
+    {
+        return std::make_unique<::testing::NiceMock<mtd::MockRenderer>>();
+    }
 };
 
 }
@@ -58,6 +76,7 @@ TEST_F(OffscreenDisplayTest, uses_basic_platform_egl_native_display)
 
     mgo::Display display{
         native_display,
+        output_sizes,
         std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
         mr::null_display_report()};
 }
@@ -67,6 +86,7 @@ TEST_F(OffscreenDisplayTest, orientation_normal)
     using namespace ::testing;
     mgo::Display display{
         native_display,
+        output_sizes,
         std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
         mr::null_display_report()};
 
@@ -85,6 +105,7 @@ TEST_F(OffscreenDisplayTest, never_enables_predictive_bypass)
 {
     mgo::Display display{
         native_display,
+        output_sizes,
         std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
         mr::null_display_report()};
 
@@ -120,6 +141,7 @@ TEST_F(OffscreenDisplayTest, makes_fbo_current_rendering_target)
 
     mgo::Display display{
         native_display,
+        output_sizes,
         std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
         mr::null_display_report()};
 
@@ -169,7 +191,82 @@ TEST_F(OffscreenDisplayTest, restores_previous_state_on_fbo_setup_failure)
     EXPECT_THROW({
         mgo::Display display(
             native_display,
+            output_sizes,
             std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
             mr::null_display_report());
     }, std::runtime_error);
 }
+
+TEST_F(OffscreenDisplayTest, has_a_display_buffer_for_each_requested_output)
+{
+    std::vector<geom::Size> const sizes{{640, 480}, {800, 600}, {1920, 1080}};
+
+    mgo::Display display{
+        native_display,
+        sizes,
+        std::make_shared<mg::SideBySideDisplayConfigurationPolicy>(),
+        mr::null_display_report()};
+
+    std::vector<geom::Rectangle> areas;
+    display.for_each_display_sync_group([&](mg::DisplaySyncGroup& group) {
+        group.for_each_display_buffer([&](mg::DisplayBuffer& db) {
+            areas.push_back(db.view_area());
+        });
+    });
+
+    EXPECT_THAT(areas, ::testing::UnorderedElementsAre(
+        geom::Rectangle{{0, 0}, {640, 480}},
+        geom::Rectangle{{640, 0}, {800, 600}},
+        geom::Rectangle{{1440, 0}, {1920, 1080}}));
+}
+
+TEST_F(OffscreenDisplayTest, composites_in_software_into_memory_that_can_be_mapped)
+{
+    using namespace ::testing;
+
+    geom::Size const size{8, 4};
+    mgo::Display display{
+        native_display,
+        {size},
+        std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
+        mr::null_display_report()};
+
+    // abgr_8888 red, composited as xrgb_8888
+    uint32_t const red{0xff0000ff};
+    auto const buffer = std::make_shared<mtd::StubBuffer>(
+        mg::BufferProperties{{2, 2}, mir_pixel_format_abgr_8888, mg::BufferUsage::software});
+    std::vector<uint32_t> const pixels(4, red);
+    buffer->write(reinterpret_cast<unsigned char const*>(pixels.data()), pixels.size() * 4);
+
+    mrs::RendererFactory factory{std::make_shared<StubGLRendererFactory>()};
+
+    int buffers = 0;
+    display.for_each_display_sync_group([&](mg::DisplaySyncGroup& group) {
+        group.for_each_display_buffer([&](mg::DisplayBuffer& db) {
+            ++buffers;
+            auto const renderer = factory.create_renderer_for(db);
+            ASSERT_THAT(dynamic_cast<mrs::Renderer*>(renderer.get()), NotNull());
+
+            renderer->render({std::make_shared<mtd::StubRenderable>(buffer, geom::Rectangle{{2, 1}, {2, 2}})});
+
+            auto const mappable = dynamic_cast<mrs::ReadMappableBuffer*>(db.native_display_buffer());
+            ASSERT_THAT(mappable, NotNull());
+            auto const mapping = mappable->map_readable();
+            ASSERT_THAT(mapping->format(), Eq(mir_pixel_format_xrgb_8888));
+            ASSERT_THAT(mapping->size(), Eq(size));
+
+            auto const pixel = [&](int x, int y)
+                {
+                    uint32_t value;
+                    std::memcpy(&value, mapping->data() + y * mapping->stride().as_int() + x * 4, 4);
+                    return value & 0x00ffffff;
+                };
+            EXPECT_THAT(pixel(2, 1), Eq(0xff0000u));
+            EXPECT_THAT(pixel(3, 2), Eq(0xff0000u));
+            EXPECT_THAT(pixel(1, 1), Eq(0u));
+            EXPECT_THAT(pixel(4, 2), Eq(0u));
+        });
+    });
+
+    EXPECT_THAT(buffers, Eq(1));
+}
@@ -0,0 +1,319 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_conversion.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+std::vector<MirPixelFormat> const all_formats{
+    mir_pixel_format_abgr_8888,
+    mir_pixel_format_xbgr_8888,
+    mir_pixel_format_argb_8888,
+    mir_pixel_format_xrgb_8888,
+    mir_pixel_format_bgr_888,
+    mir_pixel_format_rgb_888,
+    mir_pixel_format_rgb_565,
+    mir_pixel_format_rgba_5551,
+    mir_pixel_format_rgba_4444};
+
+std::vector<mg::PixelKernels> const all_kernels{
+    mg::PixelKernels::scalar,
+    mg::PixelKernels::sse2,
+    mg::PixelKernels::avx2,
+    mg::PixelKernels::neon};
+
+/// One opaque orange pixel: red 0xff, green 0x88, blue 0x00 (or as near as the format gets)
+std::vector<uint8_t> orange(MirPixelFormat format)
+{
+    switch (format)
+    {
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888: return {0xff, 0x88, 0x00, 0xff};
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888: return {0x00, 0x88, 0xff, 0xff};
+    case mir_pixel_format_bgr_888:   return {0x00, 0x88, 0xff};
+    case mir_pixel_format_rgb_888:   return {0xff, 0x88, 0x00};
+    case mir_pixel_format_rgb_565:   return {0x40, 0xfc};   // 0xfc40 (0x88 has no exact 6-bit green)
+    case mir_pixel_format_rgba_5551: return {0x01, 0xfc};   // 0xfc01 (nor 5-bit)
+    case mir_pixel_format_rgba_4444: return {0x0f, 0xf8};   // 0xf80f
+    default: return {};
+    }
+}
+
+/// The formats that can represent orange's green exactly
+bool represents_orange(MirPixelFormat format)
+{
+    return format != mir_pixel_format_rgb_565 && format != mir_pixel_format_rgba_5551;
+}
+
+std::vector<uint8_t> random_pixels(std::size_t bytes)
+{
+    std::mt19937 generator{bytes};
+    std::uniform_int_distribution<int> byte{0, 255};
+
+    std::vector<uint8_t> pixels(bytes);
+    for (auto& b : pixels)
+        b = byte(generator);
+    return pixels;
+}
+}
+
+TEST(PixelConversion, scalar_kernels_are_always_available)
+{
+    EXPECT_TRUE(mg::available_pixel_kernels(mg::PixelKernels::scalar));
+    EXPECT_TRUE(mg::available_pixel_kernels(mg::fastest_pixel_kernels()));
+}
+
+TEST(PixelConversion, invalid_formats_are_not_converted)
+{
+    uint32_t source{0x12345678};
+    uint32_t dest{0};
+
+    EXPECT_FALSE(mg::convert_pixels(
+        {1, 1}, mir_pixel_format_invalid, &source, 4, mir_pixel_format_abgr_8888, &dest, 4));
+    EXPECT_FALSE(mg::convert_pixels(
+        {1, 1}, mir_pixel_format_abgr_8888, &source, 4, mir_pixel_formats, &dest, 4));
+    EXPECT_THAT(dest, Eq(0u));
+}
+
+TEST(PixelConversion, converts_between_the_byte_layouts_of_every_format)
+{
+    for (auto const from : all_formats)
+    {
+        for (auto const to : all_formats)
+        {
+            if (!represents_orange(from) || !represents_orange(to))
+                continue;
+
+            auto const source = orange(from);
+            std::vector<uint8_t> dest(4);
+
+            ASSERT_TRUE(mg::convert_pixels({1, 1}, from, source.data(), 4, to, dest.data(), 4));
+
+            dest.resize(orange(to).size());
+            EXPECT_THAT(dest, Eq(orange(to))) << "from " << from << " to " << to;
+        }
+    }
+}
+
+TEST(PixelConversion, unpacks_16_bit_formats_to_full_intensity)
+{
+    auto const from_565 = orange(mir_pixel_format_rgb_565);
+    auto const from_5551 = orange(mir_pixel_format_rgba_5551);
+    std::vector<uint8_t> dest(4);
+
+    mg::convert_pixels({1, 1}, mir_pixel_format_rgb_565, from_565.data(), 2, mir_pixel_format_abgr_8888, dest.data(), 4);
+    EXPECT_THAT(dest, ElementsAre(0xff, 0x8a, 0x00, 0xff));
+
+    mg::convert_pixels({1, 1}, mir_pixel_format_rgba_5551, from_5551.data(), 2, mir_pixel_format_abgr_8888, dest.data(), 4);
+    EXPECT_THAT(dest, ElementsAre(0xff, 0x84, 0x00, 0xff));
+}
+
+TEST(PixelConversion, round_trips_through_a_wider_format)
+{
+    for (auto const format : all_formats)
+    {
+        auto const source = random_pixels(17 * 4);
+        std::vector<uint8_t> wide(17 * 4);
+        std::vector<uint8_t> dest(17 * 4);
+        auto const bytes = 17 * MIR_BYTES_PER_PIXEL(format);
+
+        mg::convert_pixels({17, 1}, format, source.data(), bytes, mir_pixel_format_abgr_8888, wide.data(), 17 * 4);
+        mg::convert_pixels({17, 1}, mir_pixel_format_abgr_8888, wide.data(), 17 * 4, format, dest.data(), bytes);
+
+        // Formats without alpha are free to write anything to their padding
+        auto const padded = format == mir_pixel_format_xbgr_8888 || format == mir_pixel_format_xrgb_8888;
+        for (auto i = 0; i != bytes; ++i)
+        {
+            if (!padded || i % 4 != 3)
+            {
+                ASSERT_THAT(dest[i], Eq(source[i])) << "format " << format << " byte " << i;
+            }
+        }
+    }
+}
+
+TEST(PixelConversion, negative_dest_stride_flips_rows)
+{
+    uint32_t const source[]{1, 2, 3, 4, 5, 6};
+    uint32_t dest[6]{};
+
+    mg::convert_pixels(
+        {2, 3}, mir_pixel_format_abgr_8888, source, 8,
+        mir_pixel_format_abgr_8888, dest + 4, -8);
+
+    EXPECT_THAT(dest, ElementsAre(5, 6, 3, 4, 1, 2));
+}
+
+TEST(PixelConversion, every_available_kernel_set_matches_scalar)
+{
+    geom::Size const size{67, 5};
+    auto const source = random_pixels(size.width.as_int() * size.height.as_int() * 4);
+
+    for (auto const kernels : all_kernels)
+    {
+        if (!mg::available_pixel_kernels(kernels))
+            continue;
+
+        for (auto const from : all_formats)
+        {
+            for (auto const to : all_formats)
+            {
+                auto const source_stride = size.width.as_int() * MIR_BYTES_PER_PIXEL(from);
+                auto const dest_stride = size.width.as_int() * MIR_BYTES_PER_PIXEL(to);
+                std::vector<uint8_t> expected(dest_stride * size.height.as_int());
+                std::vector<uint8_t> actual(expected.size());
+
+                mg::convert_pixels(
+                    mg::PixelKernels::scalar, size, from, source.data(), source_stride,
+                    to, expected.data() + expected.size() - dest_stride, -dest_stride);
+                mg::convert_pixels(
+                    kernels, size, from, source.data(), source_stride,
+                    to, actual.data() + actual.size() - dest_stride, -dest_stride);
+
+                ASSERT_THAT(actual, Eq(expected))
+                    << "kernels " << static_cast<int>(kernels) << " from " << from << " to " << to;
+            }
+        }
+    }
+}
+
+TEST(PixelConversion, fills_pixels_with_every_available_kernel_set)
+{
+    for (auto const kernels : all_kernels)
+    {
+        if (!mg::available_pixel_kernels(kernels))
+            continue;
+
+        std::vector<uint32_t> pixels(39, 0);
+
+        mg::fill_pixels(kernels, pixels.data() + 1, 37, 0xff336699);
+
+        EXPECT_THAT(pixels.front(), Eq(0u));
+        EXPECT_THAT(pixels.back(), Eq(0u));
+        EXPECT_THAT(std::vector<uint32_t>(pixels.begin() + 1, pixels.end() - 1), Each(Eq(0xff336699)));
+    }
+}
+
+TEST(PixelConversion, unavailable_kernels_throw)
+{
+    for (auto const kernels : all_kernels)
+    {
+        if (mg::available_pixel_kernels(kernels))
+            continue;
+
+        uint32_t pixel{0};
+        EXPECT_THROW(mg::fill_pixels(kernels, &pixel, 1, 0), std::logic_error);
+    }
+}
+
+TEST(PixelConversion, blends_premultiplied_pixels_scaled_by_alpha)
+{
+    // Half-transparent premultiplied red over opaque blue, at full and half alpha
+    uint32_t const red = 0x80000080;
+    uint32_t const blue = 0xffff0000;
+
+    for (auto const kernels : all_kernels)
+    {
+        if (!mg::available_pixel_kernels(kernels))
+            continue;
+
+        std::vector<uint32_t> full(19, blue);
+        std::vector<uint32_t> half(19, blue);
+        std::vector<uint32_t> const source(19, red);
+
+        mg::blend_pixels(
+            kernels, {19, 1}, mir_pixel_format_abgr_8888, source.data(), 0,
+            mir_pixel_format_abgr_8888, full.data(), 0, 0xff);
+        mg::blend_pixels(
+            kernels, {19, 1}, mir_pixel_format_abgr_8888, source.data(), 0,
+            mir_pixel_format_abgr_8888, half.data(), 0, 0x80);
+
+        EXPECT_THAT(full, Each(Eq(0xff7f0080u))) << "kernels " << static_cast<int>(kernels);
+        EXPECT_THAT(half, Each(Eq(0xffbf0040u))) << "kernels " << static_cast<int>(kernels);
+    }
+}
+
+TEST(PixelConversion, blends_formats_without_alpha_as_opaque)
+{
+    uint32_t const grey = 0x00808080;   // No alpha, but xbgr is opaque
+    std::vector<uint32_t> dest(5, 0xff000000);
+
+    mg::blend_pixels(
+        {5, 1}, mir_pixel_format_xbgr_8888, std::vector<uint32_t>(5, grey).data(), 0,
+        mir_pixel_format_argb_8888, dest.data(), 0, 0xff);
+
+    EXPECT_THAT(dest, Each(Eq(0xff808080u)));
+}
+
+TEST(PixelConversion, blends_only_32_bit_formats)
+{
+    std::vector<uint32_t> dest(1, 0);
+    std::vector<uint8_t> const source(4, 0xff);
+
+    EXPECT_FALSE(mg::blend_pixels(
+        {1, 1}, mir_pixel_format_rgb_888, source.data(), 0,
+        mir_pixel_format_abgr_8888, dest.data(), 0, 0xff));
+    EXPECT_FALSE(mg::blend_pixels(
+        {1, 1}, mir_pixel_format_abgr_8888, source.data(), 0,
+        mir_pixel_format_rgb_565, dest.data(), 0, 0xff));
+    EXPECT_THAT(dest[0], Eq(0u));
+}
+
+TEST(PixelConversion, every_available_kernel_set_blends_as_scalar)
+{
+    geom::Size const size{67, 5};
+    auto const stride = size.width.as_int() * 4;
+    auto const source = random_pixels(stride * size.height.as_int());
+    // Generated from a different size, so as to differ from the source
+    auto const background = random_pixels(stride * size.height.as_int() + 1);
+
+    for (auto const kernels : all_kernels)
+    {
+        if (!mg::available_pixel_kernels(kernels))
+            continue;
+
+        for (auto const from : {mir_pixel_format_abgr_8888, mir_pixel_format_xrgb_8888})
+        {
+            for (auto const alpha : {0x00, 0x7f, 0xff})
+            {
+                std::vector<uint8_t> expected(background.begin() + 1, background.end());
+                std::vector<uint8_t> actual(expected);
+
+                mg::blend_pixels(
+                    mg::PixelKernels::scalar, size, from, source.data(), stride,
+                    mir_pixel_format_abgr_8888, expected.data(), stride, alpha);
+                mg::blend_pixels(
+                    kernels, size, from, source.data(), stride,
+                    mir_pixel_format_abgr_8888, actual.data(), stride, alpha);
+
+                ASSERT_THAT(actual, Eq(expected))
+                    << "kernels " << static_cast<int>(kernels) << " from " << from << " alpha " << alpha;
+            }
+        }
+    }
+}
@@ -133,15 +133,48 @@ TEST_F(ShmBufferTest, has_correct_properties)
     EXPECT_EQ(pixel_format, shm_buffer.pixel_format());
 }
 
-TEST_F(ShmBufferTest, cant_upload_bgr_888)
+TEST_F(ShmBufferTest, uploads_bgr_888_converted_to_rgba)
 {
-    PlatformlessShmBuffer buf(size, mir_pixel_format_bgr_888, egl_delegate);
-    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _,
-                                      size.width.as_int(), size.height.as_int(),
-                                      0, _, _,
-                                      buf.pixel_buffer()))
-                .Times(0);
+    geom::Size const small{2, 1};
+    PlatformlessShmBuffer buf(small, mir_pixel_format_bgr_888, egl_delegate);
+    unsigned char const pixels[]{0x00, 0x88, 0xff, 0x11, 0x22, 0x33};
+    buf.write(pixels, sizeof pixels);
+
+    std::vector<unsigned char> uploaded;
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                                      small.width.as_int(), small.height.as_int(),
+                                      0, GL_RGBA, GL_UNSIGNED_BYTE, _))
+        .WillOnce(WithArg<8>(Invoke(
+            [&uploaded](void const* data)
+            {
+                auto const bytes = static_cast<unsigned char const*>(data);
+                uploaded.assign(bytes, bytes + 8);
+            })));
+
+    buf.bind();
 
+    EXPECT_THAT(uploaded, ElementsAre(0xff, 0x88, 0x00, 0xff, 0x33, 0x22, 0x11, 0xff));
+}
+
+TEST_F(ShmBufferTest, mappings_are_of_the_buffer_itself)
+{
+    EXPECT_THAT(shm_buffer.map_readable()->data(), Eq(shm_buffer.pixel_buffer()));
+    EXPECT_THAT(shm_buffer.map_writeable()->data(), Eq(shm_buffer.pixel_buffer()));
+    EXPECT_THAT(shm_buffer.map_rw()->data(), Eq(shm_buffer.pixel_buffer()));
+    EXPECT_THAT(shm_buffer.map_rw()->len(), Eq(shm_buffer.stride().as_uint32_t() * size.height.as_uint32_t()));
+}
+
+TEST_F(ShmBufferTest, writing_through_a_mapping_uploads_again)
+{
+    PlatformlessShmBuffer buf(size, mir_pixel_format_abgr_8888, egl_delegate);
+
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, _, _, 0, _, _, buf.pixel_buffer()))
+        .Times(2);
+
+    buf.bind();
+    buf.map_readable();
+    buf.bind();
+    buf.map_writeable()->data()[0] = 0xff;
     buf.bind();
 }
 
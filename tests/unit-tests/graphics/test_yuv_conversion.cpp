@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/yuv_conversion.h"
+#include "mir/graphics/program.h"
+#include "mir/graphics/program_factory.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace mg = mir::graphics;
+
+using namespace testing;
+
+namespace
+{
+std::vector<mg::YUVEncoding> const all_encodings{
+    {mg::YUVMatrix::bt601, mg::YUVRange::limited},
+    {mg::YUVMatrix::bt601, mg::YUVRange::full},
+    {mg::YUVMatrix::bt709, mg::YUVRange::limited},
+    {mg::YUVMatrix::bt709, mg::YUVRange::full},
+    {mg::YUVMatrix::bt2020, mg::YUVRange::limited},
+    {mg::YUVMatrix::bt2020, mg::YUVRange::full}};
+
+/// The RGB of 8-bit \a y, \a u and \a v in \a encoding
+auto rgb_of(mg::YUVEncoding const& encoding, int y, int u, int v) -> std::vector<float>
+{
+    auto const m = mg::yuv_to_rgb(encoding);
+    std::vector<float> rgb;
+    for (auto const& row : m)
+        rgb.push_back(row[0] * y / 255.0f + row[1] * u / 255.0f + row[2] * v / 255.0f + row[3]);
+    return rgb;
+}
+
+struct StubProgram : mg::gl::Program
+{
+};
+
+struct RecordingProgramFactory : mg::gl::ProgramFactory
+{
+    auto compile_fragment_shader(void* id, char const*, char const* fragment) -> mg::gl::Program& override
+    {
+        ids.push_back(id);
+        fragments.push_back(fragment);
+        return program;
+    }
+
+    std::vector<void*> ids;
+    std::vector<std::string> fragments;
+    StubProgram program;
+};
+}
+
+TEST(YUVConversion, black_and_white_are_black_and_white_in_every_encoding)
+{
+    for (auto const& encoding : all_encodings)
+    {
+        auto const limited = encoding.range == mg::YUVRange::limited;
+
+        EXPECT_THAT(rgb_of(encoding, limited ? 16 : 0, 128, 128), Each(FloatNear(0.0f, 0.002f)));
+        EXPECT_THAT(rgb_of(encoding, limited ? 235 : 255, 128, 128), Each(FloatNear(1.0f, 0.002f)));
+    }
+}
+
+TEST(YUVConversion, bt601_limited_range_red_is_red)
+{
+    EXPECT_THAT(
+        rgb_of({mg::YUVMatrix::bt601, mg::YUVRange::limited}, 81, 90, 240),
+        ElementsAre(FloatNear(1.0f, 0.01f), FloatNear(0.0f, 0.01f), FloatNear(0.0f, 0.01f)));
+}
+
+TEST(YUVConversion, bt709_limited_range_blue_is_blue)
+{
+    EXPECT_THAT(
+        rgb_of({mg::YUVMatrix::bt709, mg::YUVRange::limited}, 32, 240, 118),
+        ElementsAre(FloatNear(0.0f, 0.01f), FloatNear(0.0f, 0.01f), FloatNear(1.0f, 0.01f)));
+}
+
+TEST(YUVConversion, standard_definition_defaults_to_bt601_and_larger_to_bt709)
+{
+    auto const sd = mg::default_yuv_encoding({720, 576});
+    auto const hd = mg::default_yuv_encoding({1280, 720});
+
+    EXPECT_THAT(sd.matrix, Eq(mg::YUVMatrix::bt601));
+    EXPECT_THAT(hd.matrix, Eq(mg::YUVMatrix::bt709));
+    EXPECT_THAT(sd.range, Eq(mg::YUVRange::limited));
+    EXPECT_THAT(hd.range, Eq(mg::YUVRange::limited));
+}
+
+TEST(YUVConversion, each_layout_and_encoding_has_a_program_of_its_own)
+{
+    RecordingProgramFactory factory;
+
+    for (auto planes : {mg::YUVPlanes::y_u_v, mg::YUVPlanes::y_uv,
+                        mg::YUVPlanes::y_uv_luminance_alpha, mg::YUVPlanes::y_xuxv})
+    {
+        for (auto const& encoding : all_encodings)
+            mg::yuv_shader(factory, planes, encoding);
+    }
+    mg::yuv_shader(factory, mg::YUVPlanes::y_uv, {mg::YUVMatrix::bt709, mg::YUVRange::limited});
+
+    std::vector<void*> distinct{factory.ids.begin(), factory.ids.end() - 1};
+    std::sort(distinct.begin(), distinct.end());
+    EXPECT_THAT(std::unique(distinct.begin(), distinct.end()), Eq(distinct.end()));
+    EXPECT_THAT(factory.ids.back(), Eq(factory.ids[all_encodings.size() + 2]));
+}
+
+TEST(YUVConversion, shaders_sample_as_many_textures_as_there_are_planes)
+{
+    RecordingProgramFactory factory;
+    mg::YUVEncoding const encoding{mg::YUVMatrix::bt601, mg::YUVRange::limited};
+
+    mg::yuv_shader(factory, mg::YUVPlanes::y_u_v, encoding);
+    mg::yuv_shader(factory, mg::YUVPlanes::y_uv, encoding);
+
+    EXPECT_THAT(mg::plane_count(mg::YUVPlanes::y_u_v), Eq(3));
+    EXPECT_THAT(mg::plane_count(mg::YUVPlanes::y_uv), Eq(2));
+    EXPECT_THAT(factory.fragments[0], HasSubstr("uniform sampler2D tex[3];"));
+    EXPECT_THAT(factory.fragments[1], HasSubstr("uniform sampler2D tex[2];"));
+    EXPECT_THAT(factory.fragments[1], HasSubstr("vec4 sample_to_rgba(in vec2 texcoord)"));
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/input/input_recorder.h"
+#include "src/server/input/replay_input_platform.h"
+
+#include "mir/dispatch/dispatchable.h"
+#include "mir/events/event_builders.h"
+#include "mir/input/event_builder.h"
+#include "mir/input/input_device.h"
+#include "mir/input/input_device_info.h"
+#include "mir/input/pointer_settings.h"
+#include "mir/input/touchpad_settings.h"
+#include "mir/input/touchscreen_settings.h"
+#include "mir/test/event_matchers.h"
+#include "mir/test/doubles/mock_input_device_registry.h"
+#include "mir/test/doubles/mock_input_sink.h"
+#include "mir/test/fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <fstream>
+#include <stdexcept>
+
+#include <linux/input.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace mi = mir::input;
+namespace md = mir::dispatch;
+namespace mev = mir::events;
+namespace mt = mir::test;
+namespace mtd = mt::doubles;
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+/// Builds events as the server's builder does, less the cookies
+struct StubEventBuilder : mi::EventBuilder
+{
+    auto key_event(Timestamp timestamp, MirKeyboardAction action, xkb_keysym_t key_code, int scan_code)
+        -> mir::EventUPtr override
+    {
+        return mev::make_event(0, timestamp, {}, action, key_code, scan_code, mir_input_event_modifier_none);
+    }
+
+    auto pointer_event(Timestamp timestamp, MirPointerAction action, MirPointerButtons buttons,
+                       float hscroll, float vscroll, float dx, float dy) -> mir::EventUPtr override
+    {
+        return mev::make_event(0, timestamp, {}, mir_input_event_modifier_none, action, buttons,
+                               0, 0, hscroll, vscroll, dx, dy);
+    }
+
+    auto pointer_event(Timestamp timestamp, MirPointerAction action, MirPointerButtons buttons,
+                       float x, float y, float hscroll, float vscroll, float dx, float dy)
+        -> mir::EventUPtr override
+    {
+        return mev::make_event(0, timestamp, {}, mir_input_event_modifier_none, action, buttons,
+                               x, y, hscroll, vscroll, dx, dy);
+    }
+
+    auto touch_event(Timestamp timestamp, std::vector<mev::ContactState> const& contacts)
+        -> mir::EventUPtr override
+    {
+        return mev::make_event(0, timestamp, {}, mir_input_event_modifier_none, contacts);
+    }
+};
+
+struct StubInputDevice : mi::InputDevice
+{
+    explicit StubInputDevice(mi::InputDeviceInfo const& info)
+        : info{info}
+    {
+    }
+
+    void start(mi::InputSink* destination, mi::EventBuilder* event_builder) override
+    {
+        sink = destination;
+        builder = event_builder;
+    }
+
+    void stop() override
+    {
+        sink = nullptr;
+        builder = nullptr;
+    }
+
+    auto get_device_info() -> mi::InputDeviceInfo override { return info; }
+    auto get_pointer_settings() const -> mir::optional_value<mi::PointerSettings> override { return {}; }
+    void apply_settings(mi::PointerSettings const&) override {}
+    auto get_touchpad_settings() const -> mir::optional_value<mi::TouchpadSettings> override { return {}; }
+    void apply_settings(mi::TouchpadSettings const&) override {}
+    auto get_touchscreen_settings() const -> mir::optional_value<mi::TouchscreenSettings> override { return {}; }
+    void apply_settings(mi::TouchscreenSettings const&) override {}
+
+    mi::InputDeviceInfo const info;
+    mi::InputSink* sink{nullptr};
+    mi::EventBuilder* builder{nullptr};
+};
+
+struct InputRecording : Test
+{
+    InputRecording()
+    {
+        char path_template[] = "/tmp/mir-input-recording-test-XXXXXX";
+        auto const fd = mkstemp(path_template);
+        close(fd);
+        path = path_template;
+
+        ON_CALL(registry, add_device(_)).WillByDefault(Invoke(
+            [this](std::shared_ptr<mi::InputDevice> const& device)
+            {
+                device->start(&sink, &builder);
+                devices.push_back(device);
+            }));
+    }
+
+    ~InputRecording()
+    {
+        unlink(path.c_str());
+    }
+
+    void write_recording(std::string const& content)
+    {
+        std::ofstream{path} << content;
+    }
+
+    /// Runs the platform's dispatchable until it has nothing more to do
+    void replay(mi::ReplayPlatform& platform)
+    {
+        auto const dispatchable = platform.dispatchable();
+        pollfd pfd{dispatchable->watch_fd(), POLLIN, 0};
+
+        platform.start();
+        while (poll(&pfd, 1, 200) > 0)
+            dispatchable->dispatch(md::FdEvent::readable);
+    }
+
+    std::string path;
+    StubEventBuilder builder;
+    NiceMock<mtd::MockInputSink> sink;
+    NiceMock<mtd::MockInputDeviceRegistry> registry;
+    std::vector<std::shared_ptr<mi::InputDevice>> devices;
+
+    mi::InputDeviceInfo const keyboard_info{"keyboard", "keyboard-1", mi::DeviceCapability::keyboard};
+    mi::InputDeviceInfo const mouse_info{"A \"quoted\" mouse", "mouse 1", mi::DeviceCapability::pointer};
+    mi::InputDeviceInfo const touchscreen_info{"touchscreen", "touch-1", mi::DeviceCapability::touchscreen};
+};
+
+MATCHER_P(DeviceWithInfo, info, "")
+{
+    auto const actual = arg->get_device_info();
+    return actual.name == info.name &&
+           actual.unique_id == info.unique_id &&
+           actual.capabilities == info.capabilities;
+}
+}
+
+TEST_F(InputRecording, recorded_devices_are_passed_on)
+{
+    auto const device = std::make_shared<StubInputDevice>(keyboard_info);
+
+    EXPECT_CALL(registry, add_device(DeviceWithInfo(keyboard_info)));
+
+    mi::RecordingInputDeviceRegistry recording_registry{
+        mt::fake_shared(registry), std::make_shared<mi::InputRecorder>(path)};
+    recording_registry.add_device(device);
+
+    ASSERT_THAT(devices.size(), Eq(1u));
+    EXPECT_CALL(registry, remove_device(devices.front()));
+
+    recording_registry.remove_device(device);
+}
+
+TEST_F(InputRecording, replays_the_recorded_events)
+{
+    auto const keyboard = std::make_shared<StubInputDevice>(keyboard_info);
+    auto const mouse = std::make_shared<StubInputDevice>(mouse_info);
+    auto const touchscreen = std::make_shared<StubInputDevice>(touchscreen_info);
+
+    {
+        mi::RecordingInputDeviceRegistry recording_registry{
+            mt::fake_shared(registry), std::make_shared<mi::InputRecorder>(path)};
+
+        recording_registry.add_device(keyboard);
+        recording_registry.add_device(mouse);
+        recording_registry.add_device(touchscreen);
+
+        keyboard->sink->handle_input(
+            keyboard->builder->key_event(1ms, mir_keyboard_action_down, XKB_KEY_a, KEY_A));
+        mouse->sink->handle_input(
+            mouse->builder->pointer_event(2ms, mir_pointer_action_motion, 0, 0.0f, 0.0f, 3.25f, -1.5f));
+        mouse->sink->handle_input(
+            mouse->builder->pointer_event(3ms, mir_pointer_action_motion, 0, 0.0f, 2.5f, 0.0f, 0.0f));
+        touchscreen->sink->handle_input(touchscreen->builder->touch_event(4ms,
+            {{7, mir_touch_action_down, mir_touch_tooltype_finger, 100.5f, 200.25f, 0.5f, 4.0f, 3.0f, 0.0f}}));
+
+        recording_registry.remove_device(mouse);
+    }
+
+    devices.clear();
+    Mock::VerifyAndClearExpectations(&sink);
+
+    {
+        InSequence seq;
+        EXPECT_CALL(registry, add_device(DeviceWithInfo(keyboard_info)));
+        EXPECT_CALL(registry, add_device(DeviceWithInfo(mouse_info)));
+        EXPECT_CALL(registry, add_device(DeviceWithInfo(touchscreen_info)));
+        EXPECT_CALL(sink, handle_input(AllOf(mt::KeyDownEvent(), mt::KeyOfScanCode(KEY_A))));
+        EXPECT_CALL(sink, handle_input(mt::PointerEventWithDiff(3.25f, -1.5f)));
+        EXPECT_CALL(sink, handle_input(mt::PointerAxisChange(mir_pointer_axis_vscroll, 2.5f)));
+        EXPECT_CALL(sink, handle_input(mt::TouchContact(0, mir_touch_action_down, 100.5f, 200.25f)));
+        EXPECT_CALL(registry, remove_device(DeviceWithInfo(mouse_info)));
+    }
+
+    mi::ReplayPlatform platform{path, mt::fake_shared(registry), 0};
+    replay(platform);
+}
+
+TEST_F(InputRecording, replays_at_the_recorded_pace)
+{
+    write_recording(
+        "mir-input-recording 1\n"
+        "0 device 0 1 \"keyboard\" \"keyboard-1\"\n"
+        "1000000 key 0 1 97 30\n"
+        "61000000 key 0 0 97 30\n");
+
+    std::vector<std::chrono::steady_clock::time_point> received;
+    ON_CALL(sink, handle_input(_)).WillByDefault(InvokeWithoutArgs(
+        [&] { received.push_back(std::chrono::steady_clock::now()); }));
+
+    mi::ReplayPlatform platform{path, mt::fake_shared(registry), 2};
+    replay(platform);
+
+    ASSERT_THAT(received.size(), Eq(2u));
+    EXPECT_THAT(received[1] - received[0], Ge(30ms));
+}
+
+TEST_F(InputRecording, as_fast_as_possible_ignores_the_recorded_pace)
+{
+    write_recording(
+        "mir-input-recording 1\n"
+        "0 device 0 1 \"keyboard\" \"keyboard-1\"\n"
+        "1000000 key 0 1 97 30\n"
+        "10000000000 key 0 0 97 30\n");
+
+    EXPECT_CALL(sink, handle_input(_)).Times(2);
+
+    auto const start = std::chrono::steady_clock::now();
+    mi::ReplayPlatform platform{path, mt::fake_shared(registry), 0};
+    replay(platform);
+
+    EXPECT_THAT(std::chrono::steady_clock::now() - start, Lt(1s));
+}
+
+TEST_F(InputRecording, stopping_removes_the_replayed_devices)
+{
+    write_recording(
+        "mir-input-recording 1\n"
+        "0 device 0 1 \"keyboard\" \"keyboard-1\"\n");
+
+    mi::ReplayPlatform platform{path, mt::fake_shared(registry), 0};
+    replay(platform);
+
+    ASSERT_THAT(devices.size(), Eq(1u));
+    EXPECT_CALL(registry, remove_device(devices.front()));
+
+    platform.stop();
+}
+
+TEST_F(InputRecording, rejects_a_malformed_recording)
+{
+    write_recording(
+        "mir-input-recording 1\n"
+        "0 device 0 1 \"keyboard\" \"keyboard-1\"\n"
+        "1000000 key 0 one 97 30\n");
+
+    EXPECT_THROW(
+        { mi::ReplayPlatform(path, mt::fake_shared(registry), 1); },
+        std::runtime_error);
+}
+
+TEST_F(InputRecording, rejects_a_file_that_is_not_a_recording)
+{
+    write_recording("0 device 0 1 \"keyboard\" \"keyboard-1\"\n");
+
+    EXPECT_THROW(
+        { mi::ReplayPlatform(path, mt::fake_shared(registry), 1); },
+        std::runtime_error);
+}
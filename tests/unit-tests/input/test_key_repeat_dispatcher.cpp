@@ -34,6 +34,7 @@
 #include "mir/test/event_matchers.h"
 #include "mir/test/doubles/mock_input_dispatcher.h"
 #include "mir/test/doubles/mock_input_device_hub.h"
+#include "mir/test/doubles/advanceable_clock.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -106,7 +107,7 @@ struct StubDevice : public mi::Device
 struct KeyRepeatDispatcher : public testing::Test
 {
     KeyRepeatDispatcher(bool on_arale = false)
-        : dispatcher(mock_next_dispatcher, mock_alarm_factory, cookie_authority, true, repeat_time, repeat_delay, on_arale)
+        : dispatcher(mock_next_dispatcher, mock_alarm_factory, clock, cookie_authority, true, repeat_time, repeat_delay, on_arale)
     {
         ON_CALL(hub,add_observer(_)).WillByDefault(SaveArg<0>(&observer));
         dispatcher.set_input_device_hub(mt::fake_shared(hub));
@@ -121,6 +122,7 @@ struct KeyRepeatDispatcher : public testing::Test
     const MirInputDeviceId test_device = 123;
     std::shared_ptr<mtd::MockInputDispatcher> mock_next_dispatcher = std::make_shared<mtd::MockInputDispatcher>();
     std::shared_ptr<MockAlarmFactory> mock_alarm_factory = std::make_shared<MockAlarmFactory>();
+    std::shared_ptr<mtd::AdvanceableClock> clock = std::make_shared<mtd::AdvanceableClock>();
     std::shared_ptr<mir::cookie::Authority> cookie_authority = mir::cookie::Authority::create();
     std::chrono::milliseconds const repeat_time{2};
     std::chrono::milliseconds const repeat_delay{1};
@@ -199,6 +201,29 @@ TEST_F(KeyRepeatDispatcher, schedules_alarm_to_repeat_key_down)
     dispatcher.dispatch(a_key_up_event());
 }
 
+TEST_F(KeyRepeatDispatcher, timestamps_repeats_by_the_clock)
+{
+    MockAlarm *mock_alarm = new MockAlarm; // deleted by AlarmFactory
+    std::function<void()> alarm_function;
+    std::shared_ptr<MirEvent const> repeat;
+
+    EXPECT_CALL(*mock_alarm_factory, create_alarm_adapter(_)).Times(1).
+        WillOnce(DoAll(SaveArg<0>(&alarm_function), Return(mock_alarm)));
+    ON_CALL(*mock_alarm, reschedule_in(_)).WillByDefault(Return(true));
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(mt::KeyDownEvent())).Times(1);
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(mt::KeyRepeatEvent())).Times(1).
+        WillOnce(DoAll(SaveArg<0>(&repeat), Return(true)));
+
+    dispatcher.dispatch(a_key_down_event());
+    clock->advance_by(repeat_time);
+    alarm_function();
+
+    ASSERT_THAT(repeat, NotNull());
+    EXPECT_THAT(
+        mir_input_event_get_event_time(mir_event_get_input_event(repeat.get())),
+        Eq(std::chrono::nanoseconds{clock->now().time_since_epoch()}.count()));
+}
+
 TEST_F(KeyRepeatDispatcher, stops_repeat_on_device_removal)
 {
     MockAlarm *mock_alarm = new MockAlarm; // deleted by AlarmFactory
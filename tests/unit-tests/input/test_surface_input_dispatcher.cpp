@@ -27,6 +27,7 @@
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/stub_input_scene.h"
 #include "mir/test/doubles/mock_surface.h"
+#include "mir/test/doubles/advanceable_clock.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -120,13 +121,14 @@ struct StubInputScene : public mtd::StubInputScene
 struct SurfaceInputDispatcher : public testing::Test
 {
     SurfaceInputDispatcher()
-        : dispatcher(mt::fake_shared(scene))
+        : dispatcher(mt::fake_shared(scene), mt::fake_shared(clock))
     {
     }
 
     void TearDown() override { dispatcher.stop(); }
 
     StubInputScene scene;
+    mtd::AdvanceableClock clock;
     mi::SurfaceInputDispatcher dispatcher;
 };
 
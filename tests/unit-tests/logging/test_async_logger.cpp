@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace ml = mir::logging;
+using namespace testing;
+
+namespace
+{
+struct AsyncLogger : Test
+{
+    std::stringstream out;
+    std::stringstream err;
+
+    auto lines_of(std::stringstream const& stream) -> std::vector<std::string>
+    {
+        std::vector<std::string> lines;
+        std::istringstream in{stream.str()};
+        for (std::string line; std::getline(in, line);)
+            lines.push_back(line);
+        return lines;
+    }
+};
+
+/// Lets a test see when the logger flushes its stream, without calling AsyncLogger::flush()
+class SyncSignallingBuffer : public std::stringbuf
+{
+public:
+    auto wait_for_sync(std::chrono::milliseconds timeout) -> bool
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        return synced_cv.wait_for(lock, timeout, [this] { return synced; });
+    }
+
+protected:
+    int sync() override
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        synced = true;
+        synced_cv.notify_all();
+        return 0;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable synced_cv;
+    bool synced{false};
+};
+}
+
+TEST_F(AsyncLogger, writes_lines_in_console_format_once_flushed)
+{
+    ml::AsyncLogger logger{out, err, 16};
+
+    logger.log(ml::Severity::informational, "hello", "test");
+    logger.flush();
+
+    EXPECT_THAT(out.str(), HasSubstr("<information> test: hello\n"));
+    EXPECT_THAT(err.str(), Eq(""));
+}
+
+TEST_F(AsyncLogger, writes_lines_promptly_without_being_flushed)
+{
+    SyncSignallingBuffer buffer;
+    std::ostream signalling_out{&buffer};
+    {
+        ml::AsyncLogger logger{signalling_out, err, 16};
+
+        // Let the writer go idle, as it does between bursts of logging
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+        logger.log(ml::Severity::informational, "hello", "test");
+
+        // Well within the writer's idle wakeup
+        EXPECT_TRUE(buffer.wait_for_sync(std::chrono::milliseconds{50}));
+    }
+
+    EXPECT_THAT(buffer.str(), HasSubstr("<information> test: hello\n"));
+}
+
+TEST_F(AsyncLogger, errors_go_to_the_error_stream)
+{
+    ml::AsyncLogger logger{out, err, 16};
+
+    logger.log(ml::Severity::error, "oops", "test");
+    logger.flush();
+
+    EXPECT_THAT(err.str(), HasSubstr("< - ERROR - > test: oops\n"));
+    EXPECT_THAT(out.str(), Eq(""));
+}
+
+TEST_F(AsyncLogger, critical_messages_are_written_before_log_returns)
+{
+    ml::AsyncLogger logger{out, err, 16};
+
+    logger.log(ml::Severity::critical, "on fire", "test");
+
+    EXPECT_THAT(err.str(), HasSubstr("on fire"));
+}
+
+TEST_F(AsyncLogger, preserves_order_of_lines_from_a_thread)
+{
+    ml::AsyncLogger logger{out, err, 64};
+
+    for (int i = 0; i != 50; ++i)
+        logger.log(ml::Severity::informational, std::to_string(i), "test");
+    logger.flush();
+
+    auto const lines = lines_of(out);
+    ASSERT_THAT(lines.size(), Eq(50u));
+    for (int i = 0; i != 50; ++i)
+        EXPECT_THAT(lines[i], EndsWith("test: " + std::to_string(i)));
+}
+
+TEST_F(AsyncLogger, collapses_repeated_lines)
+{
+    ml::AsyncLogger logger{out, err, 64};
+
+    for (int i = 0; i != 10; ++i)
+        logger.log(ml::Severity::informational, "same again", "test");
+    logger.flush();
+
+    auto const stats = logger.stats();
+    EXPECT_THAT(stats.written + stats.suppressed, Eq(10u));
+    EXPECT_THAT(stats.suppressed, Gt(0u));
+    EXPECT_THAT(out.str(), HasSubstr("(previous message repeated"));
+}
+
+TEST_F(AsyncLogger, counts_lines_dropped_when_ring_is_full)
+{
+    int const lines_logged{10000};
+    ml::AsyncLogger logger{out, err, 2};
+
+    for (int i = 0; i != lines_logged; ++i)
+        logger.log(ml::Severity::informational, std::to_string(i), "test");
+    logger.flush();
+
+    auto const stats = logger.stats();
+    EXPECT_THAT(stats.written + stats.dropped, Eq(static_cast<uint64_t>(lines_logged)));
+    if (stats.dropped)
+    {
+        EXPECT_THAT(err.str(), HasSubstr("log lines dropped"));
+    }
+}
+
+TEST_F(AsyncLogger, writes_lines_from_many_threads)
+{
+    int const thread_count{8};
+    int const lines_per_thread{100};
+    {
+        ml::AsyncLogger logger{out, err, lines_per_thread};
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t != thread_count; ++t)
+        {
+            threads.emplace_back([&logger, t]
+                {
+                    for (int i = 0; i != lines_per_thread; ++i)
+                        logger.log(ml::Severity::informational, std::to_string(t * lines_per_thread + i), "test");
+                });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    EXPECT_THAT(lines_of(out).size(), Eq(static_cast<size_t>(thread_count * lines_per_thread)));
+}
@@ -19,10 +19,13 @@
 #include "src/server/report/logging/compositor_report.h"
 #include "mir/logging/logger.h"
 #include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/fake_shared.h"
 
 #include <gtest/gtest.h>
 #include <string>
 #include <cstdio>
+#include <algorithm>
+#include <vector>
 
 using namespace std;
 
@@ -189,3 +192,173 @@ TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 
     report.stopped();
 }
+
+TEST_F(LoggingCompositorReport, reports_frame_time_percentiles)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    // 99 smooth frames and one that takes three refresh periods
+    for (int f = 0; f < 100; ++f)
+    {
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(f == 50 ? 50000 : 16667));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+    }
+
+    auto const timing = report.frame_timing(id);
+    EXPECT_EQ(100, timing.frames);
+    EXPECT_NEAR(16667, timing.frame_time.p50.count(), 16667 * 0.04);
+    EXPECT_NEAR(16667, timing.frame_time.p90.count(), 16667 * 0.04);
+    EXPECT_EQ(50000, timing.frame_time.max.count());
+    EXPECT_EQ(50000, timing.render_time.max.count());
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, counts_missed_vblanks)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    // Long enough for a report to establish the refresh period...
+    for (int f = 0; f < 120; ++f)
+    {
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(16667));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+    }
+    EXPECT_EQ(0, report.frame_timing(id).missed_vblanks);
+
+    // ...then a frame that misses two vblanks
+    report.began_frame(id);
+    clock->advance_by(chrono::microseconds(3 * 16667));
+    report.rendered_frame(id);
+    report.finished_frame(id);
+
+    EXPECT_EQ(2, report.frame_timing(id).missed_vblanks);
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, idle_time_is_not_frame_time)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 10; ++f)
+    {
+        clock->advance_by(chrono::seconds(5));
+        report.scheduled();
+        clock->advance_by(chrono::microseconds(1000));
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(2000));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+    }
+
+    auto const timing = report.frame_timing(id);
+    EXPECT_NEAR(3000, timing.frame_time.max.count(), 3000 * 0.04);
+    EXPECT_NEAR(1000, timing.latency.max.count(), 1000 * 0.04);
+    EXPECT_EQ(0, timing.missed_vblanks);
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, reports_gpu_time_percentiles)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 100; ++f)
+    {
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(16667));
+        report.rendered_frame(id);
+        report.gpu_timed_frame(
+            id,
+            {mir::renderer::GPUTiming::Method::timer_query,
+             chrono::microseconds(f == 50 ? 12000 : 4000),
+             {}});
+        report.finished_frame(id);
+    }
+
+    auto const timing = report.frame_timing(id);
+    EXPECT_NEAR(4000, timing.gpu_time.p50.count(), 4000 * 0.04);
+    EXPECT_EQ(12000, timing.gpu_time.max.count());
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, logs_texture_cache_hit_rate)
+{
+    const void* const id = "My Screen";
+    vector<string> messages;
+
+    struct : ml::Logger
+    {
+        void log(ml::Severity, string const& message, string const&) override
+        {
+            messages->push_back(message);
+        }
+        vector<string>* messages;
+    } logger;
+    logger.messages = &messages;
+
+    mrl::CompositorReport report{mir::test::fake_shared(logger), clock};
+
+    for (int f = 0; f < 200; ++f)
+    {
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(16000));
+        report.rendered_frame(id);
+        report.texture_cache_used(id, {3, 1, 0, 4 << 20, 64 << 20});
+        report.finished_frame(id);
+    }
+
+    auto const usage = report.texture_cache_usage(id);
+    EXPECT_EQ(600u, usage.hits);
+    EXPECT_EQ(200u, usage.misses);
+    EXPECT_EQ(4u << 20, usage.resident_bytes);
+    EXPECT_TRUE(any_of(messages.begin(), messages.end(), [](string const& message)
+        {
+            return message.find("texture cache: 75.0% hits") != string::npos;
+        }));
+}
+
+TEST_F(LoggingCompositorReport, logs_percentiles)
+{
+    const void* const id = "My Screen";
+    vector<string> messages;
+
+    struct : ml::Logger
+    {
+        void log(ml::Severity, string const& message, string const&) override
+        {
+            messages->push_back(message);
+        }
+        vector<string>* messages;
+    } logger;
+    logger.messages = &messages;
+
+    mrl::CompositorReport report{mir::test::fake_shared(logger), clock};
+
+    for (int f = 0; f < 200; ++f)
+    {
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(16000));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+    }
+
+    EXPECT_TRUE(any_of(messages.begin(), messages.end(), [](string const& message)
+        {
+            return message.find("p50/p90/p99/max ms: frame 16.") != string::npos;
+        }));
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/metrics/registry.h"
+#include "src/server/report/metrics/scrape_socket.h"
+#include "src/server/report/metrics/compositor_report.h"
+#include "src/server/report/metrics/display_report.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/fd.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mrm = mir::report::metrics;
+namespace mtd = mir::test::doubles;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+auto scrape(mrm::Registry const& registry) -> std::string
+{
+    std::ostringstream out;
+    registry.write(out);
+    return out.str();
+}
+
+auto fetch(std::string const& path, std::string const& request) -> std::string
+{
+    mir::Fd const fd{socket(AF_UNIX, SOCK_STREAM, 0)};
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof addr.sun_path - 1);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+        throw std::runtime_error{"Failed to connect to " + path};
+
+    if (!request.empty() && write(fd, request.data(), request.size()) != static_cast<ssize_t>(request.size()))
+        throw std::runtime_error{"Failed to send request"};
+
+    std::string result;
+    char buffer[4096];
+    ssize_t count;
+    while ((count = read(fd, buffer, sizeof buffer)) > 0)
+        result.append(buffer, count);
+
+    return result;
+}
+
+struct MetricsReport : Test
+{
+    std::shared_ptr<mrm::Registry> const registry = std::make_shared<mrm::Registry>();
+    std::shared_ptr<mtd::AdvanceableClock> const clock = std::make_shared<mtd::AdvanceableClock>();
+};
+}
+
+TEST_F(MetricsReport, writes_counters_and_gauges_in_prometheus_format)
+{
+    registry->counter("mir_test_things_total", "Things counted", {{"kind", "a"}}).increment(3);
+    registry->gauge("mir_test_level", "Current level").set(-2);
+
+    EXPECT_THAT(scrape(*registry), Eq(
+        "# HELP mir_test_level Current level\n"
+        "# TYPE mir_test_level gauge\n"
+        "mir_test_level -2\n"
+        "# HELP mir_test_things_total Things counted\n"
+        "# TYPE mir_test_things_total counter\n"
+        "mir_test_things_total{kind=\"a\"} 3\n"));
+}
+
+TEST_F(MetricsReport, same_name_and_labels_give_the_same_metric)
+{
+    auto& first = registry->counter("mir_test_total", "Test", {{"a", "1"}});
+    auto& second = registry->counter("mir_test_total", "Test", {{"a", "1"}});
+    auto& other = registry->counter("mir_test_total", "Test", {{"a", "2"}});
+
+    EXPECT_THAT(&first, Eq(&second));
+    EXPECT_THAT(&first, Ne(&other));
+}
+
+TEST_F(MetricsReport, reusing_a_name_for_a_different_type_throws)
+{
+    registry->counter("mir_test", "Test");
+
+    EXPECT_THROW(registry->gauge("mir_test", "Test"), std::logic_error);
+}
+
+TEST_F(MetricsReport, escapes_label_values)
+{
+    registry->counter("mir_test_total", "Test", {{"name", "a \"quoted\"\\name\n"}}).increment();
+
+    EXPECT_THAT(scrape(*registry), HasSubstr("mir_test_total{name=\"a \\\"quoted\\\"\\\\name\\n\"} 1\n"));
+}
+
+TEST_F(MetricsReport, histograms_are_written_as_summaries)
+{
+    auto& histogram = registry->histogram("mir_test_seconds", "Test", {{"output", "1"}});
+    for (int i = 0; i != 100; ++i)
+        histogram.record(10ms);
+
+    auto const text = scrape(*registry);
+
+    EXPECT_THAT(text, HasSubstr("# TYPE mir_test_seconds summary\n"));
+    EXPECT_THAT(text, HasSubstr("mir_test_seconds{output=\"1\",quantile=\"0.5\"} 0.01\n"));
+    EXPECT_THAT(text, HasSubstr("mir_test_seconds_sum{output=\"1\"} 1\n"));
+    EXPECT_THAT(text, HasSubstr("mir_test_seconds_count{output=\"1\"} 100\n"));
+}
+
+TEST_F(MetricsReport, compositor_report_counts_frames_per_display)
+{
+    mrm::CompositorReport report{registry, clock};
+    int const display{0};
+
+    report.added_display(1920, 1080, 0, 0, &display);
+    for (int i = 0; i != 5; ++i)
+    {
+        report.began_frame(&display);
+        clock->advance_by(16ms);
+        report.rendered_frame(&display);
+        report.finished_frame(&display);
+    }
+    report.began_frame(&display);
+    report.finished_frame(&display);
+
+    auto const text = scrape(*registry);
+    EXPECT_THAT(text, HasSubstr("mir_compositor_frames_total{output=\"1920x1080+0+0\"} 6\n"));
+    EXPECT_THAT(text, HasSubstr("mir_compositor_bypassed_frames_total{output=\"1920x1080+0+0\"} 1\n"));
+    EXPECT_THAT(text, HasSubstr("mir_compositor_displays 1\n"));
+}
+
+TEST_F(MetricsReport, compositor_report_counts_frames_under_a_readded_display_s_new_layout)
+{
+    mrm::CompositorReport report{registry, clock};
+    int const display{0};
+
+    report.added_display(1920, 1080, 0, 0, &display);
+    report.began_frame(&display);
+    report.finished_frame(&display);
+
+    report.added_display(1280, 720, 0, 0, &display);
+    report.began_frame(&display);
+    report.finished_frame(&display);
+
+    auto const text = scrape(*registry);
+    EXPECT_THAT(text, HasSubstr("mir_compositor_frames_total{output=\"1920x1080+0+0\"} 1\n"));
+    EXPECT_THAT(text, HasSubstr("mir_compositor_frames_total{output=\"1280x720+0+0\"} 1\n"));
+}
+
+TEST_F(MetricsReport, display_report_counts_skipped_vblanks)
+{
+    mrm::DisplayReport report{registry};
+
+    mir::graphics::Frame frame;
+    for (int64_t msc : {1, 2, 3, 6, 7})
+    {
+        frame.msc = msc;
+        frame.ust = mir::time::PosixTimestamp{CLOCK_MONOTONIC, std::chrono::milliseconds{16 * msc}};
+        report.report_vsync(0, frame);
+    }
+
+    auto const text = scrape(*registry);
+    EXPECT_THAT(text, HasSubstr("mir_display_vsyncs_total{output=\"0\"} 5\n"));
+    EXPECT_THAT(text, HasSubstr("mir_display_skipped_vblanks_total{output=\"0\"} 2\n"));
+}
+
+TEST_F(MetricsReport, scrape_socket_serves_metrics)
+{
+    char dir_template[] = "/tmp/mir-metrics-test-XXXXXX";
+    ASSERT_THAT(mkdtemp(dir_template), NotNull());
+    std::string const path = std::string{dir_template} + "/metrics";
+
+    registry->counter("mir_test_total", "Test").increment(42);
+
+    {
+        mrm::ScrapeSocket socket{path, registry};
+
+        EXPECT_THAT(fetch(path, ""), Eq(scrape(*registry)));
+
+        auto const http = fetch(path, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        EXPECT_THAT(http, StartsWith("HTTP/1.0 200 OK\r\n"));
+        EXPECT_THAT(http, EndsWith("\r\n\r\n" + scrape(*registry)));
+    }
+
+    EXPECT_THAT(access(path.c_str(), F_OK), Ne(0));
+    rmdir(dir_template);
+}
+
+TEST_F(MetricsReport, scrape_socket_replaces_a_stale_socket)
+{
+    char dir_template[] = "/tmp/mir-metrics-test-XXXXXX";
+    ASSERT_THAT(mkdtemp(dir_template), NotNull());
+    std::string const path = std::string{dir_template} + "/metrics";
+
+    {
+        // A socket bound but not listened on refuses connections, as one left by a server that has gone does
+        mir::Fd const stale{socket(AF_UNIX, SOCK_STREAM, 0)};
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof addr.sun_path - 1);
+        ASSERT_THAT(bind(stale, reinterpret_cast<sockaddr*>(&addr), sizeof addr), Eq(0));
+    }
+
+    registry->counter("mir_test_total", "Test").increment(42);
+
+    {
+        mrm::ScrapeSocket socket{path, registry};
+        EXPECT_THAT(fetch(path, ""), Eq(scrape(*registry)));
+    }
+
+    rmdir(dir_template);
+}
+
+TEST_F(MetricsReport, scrape_socket_leaves_a_socket_being_served_alone)
+{
+    char dir_template[] = "/tmp/mir-metrics-test-XXXXXX";
+    ASSERT_THAT(mkdtemp(dir_template), NotNull());
+    std::string const path = std::string{dir_template} + "/metrics";
+
+    registry->counter("mir_test_total", "Test").increment(42);
+
+    {
+        mrm::ScrapeSocket socket{path, registry};
+
+        auto const other_registry = std::make_shared<mrm::Registry>();
+        EXPECT_THROW((mrm::ScrapeSocket{path, other_registry}), std::runtime_error);
+
+        EXPECT_THAT(fetch(path, ""), Eq(scrape(*registry)));
+    }
+
+    rmdir(dir_template);
+}
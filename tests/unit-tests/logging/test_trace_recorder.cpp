@@ -0,0 +1,210 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/trace/recorder.h"
+#include "src/server/report/trace/compositor_report.h"
+#include "src/server/report/trace/display_report.h"
+#include "mir/graphics/frame.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+#include <pthread.h>
+
+namespace mt = mir::trace;
+namespace mrt = mir::report::trace;
+using namespace testing;
+
+namespace
+{
+auto snapshot(mt::Recorder const& recorder) -> std::string
+{
+    std::ostringstream out;
+    recorder.write_chrome_json(out);
+    return out.str();
+}
+
+auto occurrences(std::string const& text, std::string const& pattern) -> int
+{
+    int count{0};
+    for (auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        ++count;
+    return count;
+}
+
+struct TraceRecorder : Test
+{
+    mt::Recorder recorder{64};
+
+    TraceRecorder()
+    {
+        recorder.enable();
+    }
+};
+}
+
+TEST_F(TraceRecorder, records_nothing_while_disabled)
+{
+    recorder.disable();
+
+    recorder.begin("test", "span");
+    recorder.end("test", "span");
+
+    EXPECT_THAT(snapshot(recorder), Not(HasSubstr("\"span\"")));
+}
+
+TEST_F(TraceRecorder, writes_chrome_trace_events)
+{
+    recorder.begin("test", "span");
+    recorder.instant("test", "marker", 42);
+    recorder.counter("test", "level", 7);
+    recorder.end("test", "span");
+
+    auto const trace = snapshot(recorder);
+
+    EXPECT_THAT(trace, StartsWith("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    EXPECT_THAT(trace, HasSubstr("{\"ph\":\"B\",\"cat\":\"test\",\"name\":\"span\",\"ts\":"));
+    EXPECT_THAT(trace, HasSubstr("{\"ph\":\"E\",\"cat\":\"test\",\"name\":\"span\",\"ts\":"));
+    EXPECT_THAT(trace, HasSubstr("\"name\":\"marker\""));
+    EXPECT_THAT(trace, HasSubstr("\"s\":\"t\",\"args\":{\"value\":42}"));
+    EXPECT_THAT(trace, HasSubstr("{\"ph\":\"C\",\"cat\":\"test\",\"name\":\"level\""));
+    EXPECT_THAT(trace, HasSubstr("\"args\":{\"value\":7}"));
+    EXPECT_THAT(trace, EndsWith("]}\n"));
+
+    // In the order they were recorded
+    EXPECT_THAT(trace.find("\"ph\":\"B\""), Lt(trace.find("\"ph\":\"E\"")));
+}
+
+TEST_F(TraceRecorder, names_threads)
+{
+    std::thread{[&]
+        {
+            pthread_setname_np(pthread_self(), "Test/Traced");
+            recorder.instant("test", "marker", 0);
+        }}.join();
+
+    EXPECT_THAT(snapshot(recorder), HasSubstr("\"name\":\"thread_name\""));
+    EXPECT_THAT(snapshot(recorder), HasSubstr("\"args\":{\"name\":\"Test/Traced\"}"));
+}
+
+TEST_F(TraceRecorder, keeps_the_most_recent_events_when_a_ring_fills)
+{
+    mt::Recorder small{4};
+    small.enable();
+
+    for (int i = 0; i != 10; ++i)
+        small.instant("test", "marker", i);
+
+    auto const trace = snapshot(small);
+
+    EXPECT_THAT(occurrences(trace, "\"name\":\"marker\""), Eq(4));
+    EXPECT_THAT(trace, Not(HasSubstr("{\"value\":5}")));
+    EXPECT_THAT(trace, HasSubstr("{\"value\":6}"));
+    EXPECT_THAT(trace, HasSubstr("{\"value\":9}"));
+}
+
+TEST_F(TraceRecorder, snapshots_while_threads_are_recording)
+{
+    std::atomic<bool> stop{false};
+    std::atomic<int> started{0};
+
+    std::vector<std::thread> writers;
+    for (int i = 0; i != 4; ++i)
+    {
+        writers.emplace_back([&]
+            {
+                recorder.begin("test", "span");
+                recorder.end("test", "span");
+                ++started;
+
+                while (!stop)
+                {
+                    recorder.begin("test", "span");
+                    recorder.end("test", "span");
+                }
+            });
+    }
+
+    while (started != 4)
+        std::this_thread::yield();
+
+    for (int i = 0; i != 20; ++i)
+    {
+        auto const trace = snapshot(recorder);
+        EXPECT_THAT(trace, EndsWith("]}\n"));
+        EXPECT_THAT(occurrences(trace, "\"name\":\"span\""), Le(4*64));
+    }
+
+    stop = true;
+    for (auto& writer : writers)
+        writer.join();
+
+    EXPECT_THAT(occurrences(snapshot(recorder), "\"name\":\"thread_name\""), Eq(4));
+}
+
+TEST_F(TraceRecorder, scoped_span_records_only_while_enabled)
+{
+    auto& global = mt::Recorder::instance();
+    ASSERT_FALSE(global.enabled());
+
+    {
+        MIR_TRACE_SCOPE("test", "untraced_scope");
+    }
+
+    global.enable();
+    {
+        MIR_TRACE_SCOPE("test", "traced_scope");
+    }
+    global.disable();
+
+    auto const trace = snapshot(global);
+    EXPECT_THAT(trace, Not(HasSubstr("untraced_scope")));
+    EXPECT_THAT(occurrences(trace, "\"name\":\"traced_scope\""), Eq(2));
+}
+
+TEST_F(TraceRecorder, compositor_report_records_frames_as_spans)
+{
+    mrt::CompositorReport report{recorder};
+    auto const display = reinterpret_cast<mrt::CompositorReport::SubCompositorId>(1);
+
+    report.scheduled();
+    report.began_frame(display);
+    report.rendered_frame(display);
+    report.finished_frame(display);
+
+    auto const trace = snapshot(recorder);
+
+    EXPECT_THAT(trace, HasSubstr("{\"ph\":\"i\",\"cat\":\"compositor\",\"name\":\"scheduled\""));
+    EXPECT_THAT(trace, HasSubstr("{\"ph\":\"B\",\"cat\":\"compositor\",\"name\":\"frame\""));
+    EXPECT_THAT(trace, HasSubstr("{\"ph\":\"i\",\"cat\":\"compositor\",\"name\":\"rendered_frame\""));
+    EXPECT_THAT(trace, HasSubstr("{\"ph\":\"E\",\"cat\":\"compositor\",\"name\":\"frame\""));
+}
+
+TEST_F(TraceRecorder, display_report_records_vsyncs_with_their_msc)
+{
+    mrt::DisplayReport report{recorder};
+
+    mir::graphics::Frame frame;
+    frame.msc = 1234;
+    report.report_vsync(1, frame);
+
+    EXPECT_THAT(snapshot(recorder), HasSubstr("\"name\":\"vsync\""));
+    EXPECT_THAT(snapshot(recorder), HasSubstr("\"args\":{\"value\":1234}"));
+}
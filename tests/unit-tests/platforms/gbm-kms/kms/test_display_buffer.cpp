@@ -38,6 +38,8 @@
 #include <gmock/gmock.h>
 #include <gbm.h>
 
+#include <fcntl.h>
+
 using namespace testing;
 using namespace mir;
 using namespace std;
@@ -375,6 +377,95 @@ TEST_F(MesaDisplayBufferTest, transformation_not_implemented_internally)
     EXPECT_EQ(rotate_left, db.transformation());
 }
 
+TEST_F(MesaDisplayBufferTest, clones_on_another_device_share_the_rendered_frame)
+{
+    auto const other_device_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*mock_kms_output, drm_fd()).WillByDefault(Return(3));
+    ON_CALL(*other_device_output, drm_fd()).WillByDefault(Return(4));
+    ON_CALL(*other_device_output, buffer_requires_migration(_))
+        .WillByDefault(Return(false));
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, other_device_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(mock_gbm, gbm_surface_lock_front_buffer(_))
+        .WillOnce(Return(fake_bo));
+    EXPECT_CALL(*mock_kms_output, fb_for(fake_bo))
+        .WillOnce(Return(reinterpret_cast<FBHandle*>(0x12ad)));
+    EXPECT_CALL(*other_device_output, fb_for(fake_bo))
+        .WillOnce(Return(reinterpret_cast<FBHandle*>(0x34cd)));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(reinterpret_cast<FBHandle*>(0x12ad)))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*other_device_output, schedule_page_flip_thunk(reinterpret_cast<FBHandle*>(0x34cd)))
+        .WillOnce(Return(true));
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, clones_on_a_device_that_cannot_scan_out_the_frame_share_one_copy_of_it)
+{
+    auto const foreign_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    auto const foreign_clone = std::make_shared<NiceMock<MockKMSOutput>>();
+    auto const copier_surface = mock_gbm.fake_gbm.surface;
+    auto const copied_bo = reinterpret_cast<gbm_bo*>(456);
+    auto const rendered_fb = reinterpret_cast<FBHandle*>(0x12ad);
+    auto const copied_fb = reinterpret_cast<FBHandle*>(0x34cd);
+
+    ON_CALL(*mock_kms_output, drm_fd()).WillByDefault(Return(3));
+    for (auto const& output : {foreign_output, foreign_clone})
+    {
+        ON_CALL(*output, drm_fd()).WillByDefault(Return(4));
+        ON_CALL(*output, set_crtc_thunk(_)).WillByDefault(Return(true));
+        ON_CALL(*output, schedule_page_flip_thunk(_)).WillByDefault(Return(true));
+        // Only what is copied onto their own device can be scanned out
+        ON_CALL(*output, buffer_requires_migration(_)).WillByDefault(Return(true));
+        ON_CALL(*output, buffer_requires_migration(copied_bo)).WillByDefault(Return(false));
+        ON_CALL(*output, fb_for(copied_bo)).WillByDefault(Return(copied_fb));
+    }
+    ON_CALL(mock_gbm, gbm_surface_lock_front_buffer(copier_surface))
+        .WillByDefault(Return(copied_bo));
+    ON_CALL(mock_gbm, gbm_bo_get_fd(_))
+        .WillByDefault(InvokeWithoutArgs([] { return open("/dev/null", O_RDONLY | O_CLOEXEC); }));
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, foreign_output, foreign_clone},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    // The frame is rendered once, into the display buffer's own surface...
+    EXPECT_CALL(mock_gbm, gbm_surface_lock_front_buffer(Ne(copier_surface)))
+        .WillOnce(Return(fake_bo));
+    EXPECT_CALL(*mock_kms_output, fb_for(fake_bo))
+        .WillOnce(Return(rendered_fb));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(rendered_fb))
+        .WillOnce(Return(true));
+
+    // ...and copied once for the other device, whose outputs both scan the copy out
+    EXPECT_CALL(mock_gbm, gbm_bo_get_fd(fake_bo));
+    EXPECT_CALL(mock_gl, glDrawElements(GL_TRIANGLE_STRIP, 4, _, _));
+    EXPECT_CALL(mock_gbm, gbm_surface_lock_front_buffer(copier_surface))
+        .WillOnce(Return(copied_bo));
+    EXPECT_CALL(*foreign_output, fb_for(copied_bo))
+        .WillOnce(Return(copied_fb));
+    EXPECT_CALL(*foreign_clone, fb_for(_)).Times(0);
+    EXPECT_CALL(*foreign_output, schedule_page_flip_thunk(copied_fb))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*foreign_clone, schedule_page_flip_thunk(copied_fb))
+        .WillOnce(Return(true));
+
+    db.swap_buffers();
+    db.post();
+}
+
 TEST_F(MesaDisplayBufferTest, clone_mode_first_flip_flips_but_no_wait)
 {
     // Ensure clone mode can do multiple page flips in parallel without
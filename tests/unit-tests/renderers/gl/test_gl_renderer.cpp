@@ -16,6 +16,8 @@
  * Authored by: Sam Spilsbury <sam.spilsbury@canonical.com>
  */
 
+#include <algorithm>
+#include <array>
 #include <functional>
 #include <stdexcept>
 #include <gtest/gtest.h>
@@ -23,12 +25,16 @@
 #include <mir/geometry/rectangle.h>
 #include <mir/test/fake_shared.h>
 #include <mir/test/doubles/mock_gl_buffer.h>
+#include <mir/test/doubles/stub_buffer.h>
 #include <mir/test/doubles/mock_renderable.h>
+#include <mir/test/doubles/stub_renderable.h>
 #include <mir/test/doubles/mock_buffer_stream.h>
 #include <mir/compositor/buffer_stream.h>
+#include <mir/renderer/gl/texture_source.h>
 #include <mir/test/doubles/mock_gl.h>
 #include <mir/test/doubles/mock_egl.h>
 #include <src/renderers/gl/renderer.h>
+#include <mir/gl/texture_atlas.h>
 #include <mir/test/doubles/stub_gl_display_buffer.h>
 #include <mir/test/doubles/mock_gl_display_buffer.h>
 
@@ -41,6 +47,7 @@ using testing::AnyNumber;
 using testing::AtLeast;
 using testing::DoAll;
 using testing::_;
+using testing::Mock;
 
 namespace mt=mir::test;
 namespace mtd=mir::test::doubles;
@@ -88,6 +95,75 @@ void SetUpMockProgramData(mtd::MockGL &mock_gl)
         .WillByDefault(Return(alpha_uniform_location));
 }
 
+/// A buffer that is drawn from a texture, and whose pixels the CPU can read (as the atlas does)
+struct TextureBuffer : mtd::StubBuffer, mrg::TextureSource
+{
+    TextureBuffer(mir::geometry::Size const& size, uint32_t pixel)
+        : StubBuffer{mg::BufferProperties{size, mir_pixel_format_abgr_8888, mg::BufferUsage::software}}
+    {
+        std::vector<uint32_t> const pixels(size.width.as_uint32_t() * size.height.as_uint32_t(), pixel);
+        write(reinterpret_cast<unsigned char const*>(pixels.data()), pixels.size() * sizeof pixel);
+    }
+
+    MOCK_METHOD0(gl_bind_to_texture, void());
+    MOCK_METHOD0(bind, void());
+    MOCK_METHOD0(secure_for_render, void());
+};
+
+/// The texture coordinates of the quads drawn, batched, as triangles
+struct AtlasDraws
+{
+    using Quad = std::array<GLfloat, 4>;
+
+    explicit AtlasDraws(testing::NiceMock<mtd::MockGL>& mock_gl)
+    {
+        using namespace testing;
+
+        // Texture coordinates are the attribute of 2 components
+        EXPECT_CALL(mock_gl, glVertexAttribPointer(_, 2, GL_FLOAT, GL_FALSE, _, _))
+            .WillRepeatedly(Invoke([this](GLuint, GLint, GLenum, GLboolean, GLsizei stride, void const* pointer)
+                {
+                    texcoords = static_cast<char const*>(pointer);
+                    texcoord_stride = stride;
+                }));
+        EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLE_STRIP, _, _)).Times(0);
+        EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 0, _))
+            .WillRepeatedly(Invoke([this](GLenum, GLint, GLsizei count) { record(count); }));
+    }
+
+    /// The texture coordinates (left, top, right, bottom) of \a size texels at \a x, \a y of an atlas page
+    static auto entry_at(int x, int y, int size) -> Quad
+    {
+        GLfloat const scale = 1.0f / mgl::TextureAtlas::page_size;
+        return {{x * scale, y * scale, (x + size) * scale, (y + size) * scale}};
+    }
+
+    /// For each draw, the extent of each quad's texture coordinates
+    std::vector<std::vector<Quad>> quads;
+
+private:
+    void record(GLsizei count)
+    {
+        quads.emplace_back();
+        for (auto quad = 0; quad != count / 6; ++quad)
+        {
+            Quad extent{{1.0f, 1.0f, 0.0f, 0.0f}};
+            for (auto vertex = 6 * quad; vertex != 6 * quad + 6; ++vertex)
+            {
+                auto const texcoord = reinterpret_cast<GLfloat const*>(texcoords + vertex * texcoord_stride);
+                extent[0] = std::min(extent[0], texcoord[0]);
+                extent[1] = std::min(extent[1], texcoord[1]);
+                extent[2] = std::max(extent[2], texcoord[0]);
+                extent[3] = std::max(extent[3], texcoord[1]);
+            }
+            quads.back().push_back(extent);
+        }
+    }
+
+    char const* texcoords{nullptr};
+    GLsizei texcoord_stride{0};
+};
+
 class GLRenderer :
     public testing::Test
 {
@@ -367,6 +443,189 @@ TEST_F(GLRenderer, unchanged_viewport_updates_gl_if_rotated)
     renderer.set_viewport(view_area);
 }
 
+TEST_F(GLRenderer, draws_small_unchanging_renderables_together)
+{
+    using namespace testing;
+    namespace geom = mir::geometry;
+
+    int const padded_size{16 + 2};
+    std::vector<std::shared_ptr<NiceMock<TextureBuffer>>> buffers;
+    mg::RenderableList small_renderables;
+    for (auto i = 0; i != 3; ++i)
+    {
+        buffers.push_back(std::make_shared<NiceMock<TextureBuffer>>(geom::Size{16, 16}, 0xff000001u + i));
+        small_renderables.push_back(
+            std::make_shared<mtd::StubRenderable>(buffers.back(), geom::Rectangle{{16 * i, 0}, {16, 16}}));
+    }
+
+    mrg::Renderer renderer(display_buffer);
+
+    // Until they have been shown unchanged for a while each is drawn from its own texture
+    for (auto const& buffer : buffers)
+        EXPECT_CALL(*buffer, secure_for_render()).Times(mgl::TextureAtlas::frames_before_packing);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    for (auto i = 0; i != mgl::TextureAtlas::frames_before_packing; ++i)
+        renderer.render(small_renderables);
+    for (auto const& buffer : buffers)
+        Mock::VerifyAndClearExpectations(buffer.get());
+
+    // Then their pixels are copied into the atlas, each with a border, and all drawn at once
+    std::vector<std::pair<geom::Point, uint32_t>> uploads;
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, _, _, padded_size, padded_size, GL_RGBA, GL_UNSIGNED_BYTE, _))
+        .Times(3)
+        .WillRepeatedly(Invoke([&](GLenum, GLint, GLint x, GLint y, GLsizei, GLsizei, GLenum, GLenum, void const* data)
+            {
+                uploads.emplace_back(geom::Point{x, y}, static_cast<uint32_t const*>(data)[padded_size + 1]);
+            }));
+    AtlasDraws draws{mock_gl};
+
+    for (auto const& buffer : buffers)
+        EXPECT_CALL(*buffer, secure_for_render()).Times(0);
+
+    renderer.render(small_renderables);
+
+    EXPECT_THAT(uploads, ElementsAre(
+        Pair(geom::Point{0, 0}, 0xff000001u),
+        Pair(geom::Point{padded_size, 0}, 0xff000002u),
+        Pair(geom::Point{2 * padded_size, 0}, 0xff000003u)));
+    EXPECT_THAT(draws.quads, ElementsAre(ElementsAre(
+        draws.entry_at(1, 1, 16), draws.entry_at(padded_size + 1, 1, 16), draws.entry_at(2 * padded_size + 1, 1, 16))));
+}
+
+TEST_F(GLRenderer, repacks_small_renderables_whose_buffers_change)
+{
+    using namespace testing;
+    namespace geom = mir::geometry;
+
+    int const padded_size{16 + 2};
+    std::vector<std::shared_ptr<mtd::StubRenderable>> renderables;
+    mg::RenderableList small_renderables;
+    for (auto i = 0; i != 3; ++i)
+    {
+        renderables.push_back(std::make_shared<mtd::StubRenderable>(
+            std::make_shared<NiceMock<TextureBuffer>>(geom::Size{16, 16}, 0xff000001u + i),
+            geom::Rectangle{{16 * i, 0}, {16, 16}}));
+        small_renderables.push_back(renderables.back());
+    }
+
+    mrg::Renderer renderer(display_buffer);
+    for (auto i = 0; i != mgl::TextureAtlas::frames_before_packing + 1; ++i)
+        renderer.render(small_renderables);
+
+    auto const new_buffer = std::make_shared<NiceMock<TextureBuffer>>(geom::Size{16, 16}, 0xff0000ffu);
+    renderables[1]->set_buffer(new_buffer);
+
+    // The new buffer is drawn from its own texture until it too has been shown unchanged for a while...
+    EXPECT_CALL(*new_buffer, secure_for_render()).Times(mgl::TextureAtlas::frames_before_packing);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    for (auto i = 0; i != mgl::TextureAtlas::frames_before_packing; ++i)
+        renderer.render(small_renderables);
+    Mock::VerifyAndClearExpectations(new_buffer.get());
+
+    // ...then only it is copied into the atlas, where its old content was
+    uint32_t uploaded{0};
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, padded_size, 0, padded_size, padded_size, _, _, _))
+        .WillOnce(Invoke([&](GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, void const* data)
+            {
+                uploaded = static_cast<uint32_t const*>(data)[padded_size + 1];
+            }));
+    EXPECT_CALL(*new_buffer, secure_for_render()).Times(0);
+    AtlasDraws draws{mock_gl};
+
+    renderer.render(small_renderables);
+
+    EXPECT_THAT(uploaded, Eq(0xff0000ffu));
+    EXPECT_THAT(draws.quads, ElementsAre(ElementsAre(
+        draws.entry_at(1, 1, 16), draws.entry_at(padded_size + 1, 1, 16), draws.entry_at(2 * padded_size + 1, 1, 16))));
+}
+
+TEST_F(GLRenderer, draws_unchanging_groups_of_renderables_from_a_texture)
+{
+    using namespace testing;
+    namespace geom = mir::geometry;
+
+    GLuint const group_framebuffer{42};
+    ON_CALL(mock_gl, glGetIntegerv(GL_MAX_TEXTURE_SIZE, _))
+        .WillByDefault(SetArgPointee<1>(4096));
+    ON_CALL(mock_gl, glGenFramebuffers(1, _))
+        .WillByDefault(SetArgPointee<1>(group_framebuffer));
+    ON_CALL(mock_gl, glCheckFramebufferStatus(_))
+        .WillByDefault(Return(GL_FRAMEBUFFER_COMPLETE));
+    ON_CALL(mock_display_buffer, view_area())
+        .WillByDefault(Return(geom::Rectangle{{0, 0}, {1920, 1080}}));
+
+    // Which framebuffer each draw is into: the group's, or (0) the display buffer's
+    GLuint bound{0};
+    std::vector<std::pair<GLenum, GLuint>> draws;
+    ON_CALL(mock_gl, glBindFramebuffer(GL_FRAMEBUFFER, _))
+        .WillByDefault(SaveArg<1>(&bound));
+    ON_CALL(mock_display_buffer, bind())
+        .WillByDefault(Assign(&bound, 0u));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _))
+        .WillRepeatedly(Invoke([&](GLenum mode, GLint, GLsizei) { draws.emplace_back(mode, bound); }));
+
+    std::vector<std::shared_ptr<NiceMock<TextureBuffer>>> buffers;
+    std::vector<std::shared_ptr<mtd::StubRenderable>> renderables;
+    mg::RenderableList group;
+    for (auto const& area : {geom::Rectangle{{0, 0}, {200, 200}},
+                             geom::Rectangle{{10, 10}, {50, 50}},
+                             geom::Rectangle{{60, 10}, {50, 50}},
+                             geom::Rectangle{{110, 10}, {50, 50}}})
+    {
+        buffers.push_back(std::make_shared<NiceMock<TextureBuffer>>(area.size, 0xff000000u));
+        renderables.push_back(std::make_shared<mtd::StubRenderable>(buffers.back(), area));
+        group.push_back(renderables.back());
+    }
+
+    auto const drawn_into_group = Pair(GLenum{GL_TRIANGLE_STRIP}, group_framebuffer);
+    auto const drawn_from_group = Pair(GLenum{GL_TRIANGLES}, 0u);
+
+    mrg::Renderer renderer(mock_display_buffer);
+    for (auto i = 0; i != mrg::StaticGroups::frames_before_flattening; ++i)
+        renderer.render(group);
+
+    // Each member is drawn into the group's texture once; the group is then drawn from that
+    for (auto const& buffer : buffers)
+        EXPECT_CALL(*buffer, secure_for_render()).Times(1);
+    draws.clear();
+
+    renderer.render(group);
+    renderer.render(group);
+
+    EXPECT_THAT(draws, ElementsAre(
+        drawn_into_group, drawn_into_group, drawn_into_group, drawn_into_group,
+        drawn_from_group,
+        drawn_from_group));
+    for (auto const& buffer : buffers)
+        Mock::VerifyAndClearExpectations(buffer.get());
+
+    // A new buffer in the group has it drawn renderable by renderable again...
+    auto const new_buffer = std::make_shared<NiceMock<TextureBuffer>>(geom::Size{50, 50}, 0xff0000ffu);
+    renderables[2]->set_buffer(new_buffer);
+    EXPECT_CALL(*new_buffer, bind());
+    draws.clear();
+
+    renderer.render(group);
+
+    auto const drawn_to_screen = Pair(GLenum{GL_TRIANGLE_STRIP}, 0u);
+    EXPECT_THAT(draws, ElementsAre(drawn_to_screen, drawn_to_screen, drawn_to_screen, drawn_to_screen));
+    Mock::VerifyAndClearExpectations(new_buffer.get());
+
+    // ...until it has settled, when the group is drawn into its texture afresh
+    for (auto i = 1; i != mrg::StaticGroups::frames_before_flattening; ++i)
+        renderer.render(group);
+    EXPECT_CALL(*new_buffer, secure_for_render()).Times(1);
+    draws.clear();
+
+    renderer.render(group);
+
+    EXPECT_THAT(draws, ElementsAre(
+        drawn_into_group, drawn_into_group, drawn_into_group, drawn_into_group,
+        drawn_from_group));
+}
+
 TEST_F(GLRenderer, sets_viewport_unscaled_exact)
 {
     int const screen_width = 1920;
@@ -0,0 +1,306 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/gl/gpu_timer.h"
+
+#include "mir/test/doubles/mock_egl.h"
+#include "mir/test/doubles/mock_gl.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <map>
+
+namespace mrg = mir::renderer::gl;
+namespace mtd = mir::test::doubles;
+using mir::renderer::GPUTiming;
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace
+{
+GLenum const time_elapsed{0x88BF};
+GLenum const query_result{0x8866};
+GLenum const query_result_available{0x8867};
+GLenum const gpu_disjoint{0x8FBB};
+
+std::size_t const max_pending_frames{8};
+
+/// The timer query entry points, which are only found through eglGetProcAddress()
+struct MockTimerQueries
+{
+    MockTimerQueries() { instance = this; }
+    ~MockTimerQueries() { instance = nullptr; }
+
+    MOCK_METHOD2(glGenQueries, void(GLsizei, GLuint*));
+    MOCK_METHOD2(glDeleteQueries, void(GLsizei, GLuint const*));
+    MOCK_METHOD2(glBeginQuery, void(GLenum, GLuint));
+    MOCK_METHOD1(glEndQuery, void(GLenum));
+    MOCK_METHOD3(glGetQueryObjectuiv, void(GLuint, GLenum, GLuint*));
+    MOCK_METHOD3(glGetQueryObjectui64v, void(GLuint, GLenum, std::uint64_t*));
+
+    static MockTimerQueries* instance;
+};
+
+MockTimerQueries* MockTimerQueries::instance{nullptr};
+
+void gen_queries(GLsizei n, GLuint* ids) { MockTimerQueries::instance->glGenQueries(n, ids); }
+void delete_queries(GLsizei n, GLuint const* ids) { MockTimerQueries::instance->glDeleteQueries(n, ids); }
+void begin_query(GLenum target, GLuint id) { MockTimerQueries::instance->glBeginQuery(target, id); }
+void end_query(GLenum target) { MockTimerQueries::instance->glEndQuery(target); }
+void get_query_objectuiv(GLuint id, GLenum name, GLuint* value)
+{
+    MockTimerQueries::instance->glGetQueryObjectuiv(id, name, value);
+}
+void get_query_objectui64v(GLuint id, GLenum name, std::uint64_t* value)
+{
+    MockTimerQueries::instance->glGetQueryObjectui64v(id, name, value);
+}
+
+struct GPUTimer : Test
+{
+    GPUTimer()
+    {
+        provide_timer_queries("EXT");
+        provide_timer_queries("");
+
+        ON_CALL(queries, glGenQueries(1, _))
+            .WillByDefault(Invoke([this](GLsizei, GLuint* id) { *id = ++queries_generated; }));
+        ON_CALL(queries, glGetQueryObjectuiv(_, query_result_available, _))
+            .WillByDefault(Invoke([this](GLuint, GLenum, GLuint* value)
+                {
+                    *value = results_available ? GL_TRUE : GL_FALSE;
+                }));
+        ON_CALL(queries, glGetQueryObjectui64v(_, query_result, _))
+            .WillByDefault(Invoke([this](GLuint id, GLenum, std::uint64_t* value) { *value = elapsed[id]; }));
+        ON_CALL(mock_gl, glGetIntegerv(gpu_disjoint, _))
+            .WillByDefault(Invoke([this](GLenum, GLint* value) { *value = disjoint; }));
+
+        ON_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+            .WillByDefault(Invoke([this](EGLDisplay, EGLenum, EGLint const*)
+                {
+                    return reinterpret_cast<EGLSyncKHR>(++fences_created);
+                }));
+        ON_CALL(mock_egl, eglClientWaitSyncKHR(_, _, _, _))
+            .WillByDefault(Return(EGL_TIMEOUT_EXPIRED_KHR));
+    }
+
+    void provide_timer_queries(std::string const& suffix)
+    {
+        using func_ptr_t = mtd::MockEGL::generic_function_pointer_t;
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGenQueries" + suffix)))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&gen_queries)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glDeleteQueries" + suffix)))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&delete_queries)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glBeginQuery" + suffix)))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&begin_query)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glEndQuery" + suffix)))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&end_query)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGetQueryObjectuiv" + suffix)))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&get_query_objectuiv)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGetQueryObjectui64v" + suffix)))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&get_query_objectui64v)));
+    }
+
+    void provide_gl_extensions(char const* extensions)
+    {
+        ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+            .WillByDefault(Return(reinterpret_cast<GLubyte const*>(extensions)));
+    }
+
+    void provide_fences()
+    {
+        provide_gl_extensions("GL_OES_EGL_image");
+        ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+            .WillByDefault(Return("EGL_KHR_image_base EGL_KHR_fence_sync"));
+    }
+
+    void render_frame(std::initializer_list<GPUTiming::Class> spans)
+    {
+        for (auto const c : spans)
+            timer->begin(c);
+        timer->end_frame();
+    }
+
+    NiceMock<mtd::MockEGL> mock_egl;
+    NiceMock<mtd::MockGL> mock_gl;
+    NiceMock<MockTimerQueries> queries;
+
+    GLuint queries_generated{0};
+    bool results_available{true};
+    std::map<GLuint, std::uint64_t> elapsed;
+    GLint disjoint{GL_FALSE};
+    std::uintptr_t fences_created{0};
+
+    std::unique_ptr<mrg::GPUTimer> timer;
+};
+}
+
+TEST_F(GPUTimer, times_consecutive_spans_of_a_class_with_one_query)
+{
+    provide_gl_extensions("GL_OES_EGL_image GL_EXT_disjoint_timer_query");
+    timer = mrg::GPUTimer::create();
+    ASSERT_THAT(timer, NotNull());
+
+    EXPECT_CALL(queries, glGenQueries(1, _)).Times(4);
+    {
+        InSequence seq;
+        for (GLuint query = 1; query != 5; ++query)
+        {
+            EXPECT_CALL(queries, glBeginQuery(time_elapsed, query));
+            EXPECT_CALL(queries, glEndQuery(time_elapsed));
+        }
+    }
+
+    render_frame({
+        GPUTiming::Class::clear,
+        GPUTiming::Class::opaque, GPUTiming::Class::opaque,
+        GPUTiming::Class::blended,
+        GPUTiming::Class::opaque, GPUTiming::Class::opaque});
+
+    elapsed = {{1, 100}, {2, 200}, {3, 400}, {4, 800}};
+    auto const timings = timer->completed();
+
+    ASSERT_THAT(timings.size(), Eq(1u));
+    EXPECT_THAT(timings[0].method, Eq(GPUTiming::Method::timer_query));
+    EXPECT_THAT(timings[0].frame_time, Eq(1500ns));
+    EXPECT_THAT(timings[0].time_in(GPUTiming::Class::clear), Eq(100ns));
+    EXPECT_THAT(timings[0].time_in(GPUTiming::Class::opaque), Eq(1000ns));
+    EXPECT_THAT(timings[0].time_in(GPUTiming::Class::blended), Eq(400ns));
+}
+
+TEST_F(GPUTimer, reports_frames_in_order_once_all_their_results_are_available)
+{
+    provide_gl_extensions("GL_ARB_timer_query");
+    timer = mrg::GPUTimer::create();
+    ASSERT_THAT(timer, NotNull());
+
+    render_frame({GPUTiming::Class::clear});
+    render_frame({GPUTiming::Class::clear});
+    elapsed = {{1, 10}, {2, 20}};
+
+    results_available = false;
+    EXPECT_THAT(timer->completed(), IsEmpty());
+
+    results_available = true;
+    auto const timings = timer->completed();
+    ASSERT_THAT(timings.size(), Eq(2u));
+    EXPECT_THAT(timings[0].frame_time, Eq(10ns));
+    EXPECT_THAT(timings[1].frame_time, Eq(20ns));
+
+    EXPECT_THAT(timer->completed(), IsEmpty());
+}
+
+TEST_F(GPUTimer, drops_pending_frames_when_timings_are_disjoint)
+{
+    provide_gl_extensions("GL_EXT_disjoint_timer_query");
+    timer = mrg::GPUTimer::create();
+    ASSERT_THAT(timer, NotNull());
+
+    render_frame({GPUTiming::Class::clear, GPUTiming::Class::opaque});
+    render_frame({GPUTiming::Class::clear});
+
+    disjoint = GL_TRUE;
+    EXPECT_THAT(timer->completed(), IsEmpty());
+
+    disjoint = GL_FALSE;
+    EXPECT_THAT(timer->completed(), IsEmpty());
+
+    // The dropped frames' queries are used again
+    EXPECT_CALL(queries, glGenQueries(_, _)).Times(0);
+    render_frame({GPUTiming::Class::clear, GPUTiming::Class::opaque, GPUTiming::Class::blended});
+
+    EXPECT_THAT(timer->completed().size(), Eq(1u));
+}
+
+TEST_F(GPUTimer, does_not_check_for_disjoint_timings_without_the_extension)
+{
+    provide_gl_extensions("GL_ARB_timer_query");
+    timer = mrg::GPUTimer::create();
+    ASSERT_THAT(timer, NotNull());
+
+    EXPECT_CALL(mock_gl, glGetIntegerv(gpu_disjoint, _)).Times(0);
+
+    render_frame({GPUTiming::Class::clear});
+    EXPECT_THAT(timer->completed().size(), Eq(1u));
+}
+
+TEST_F(GPUTimer, recycles_the_queries_of_frames_whose_results_never_arrive)
+{
+    provide_gl_extensions("GL_EXT_disjoint_timer_query");
+    timer = mrg::GPUTimer::create();
+    ASSERT_THAT(timer, NotNull());
+
+    results_available = false;
+    EXPECT_CALL(queries, glGenQueries(1, _)).Times(max_pending_frames + 1);
+
+    for (auto frame = 0; frame != 100; ++frame)
+    {
+        render_frame({GPUTiming::Class::clear});
+        EXPECT_THAT(timer->completed(), IsEmpty());
+    }
+
+    results_available = true;
+    EXPECT_THAT(timer->completed().size(), Eq(max_pending_frames));
+
+    EXPECT_CALL(queries, glDeleteQueries(max_pending_frames + 1, _));
+    timer.reset();
+}
+
+TEST_F(GPUTimer, times_frames_with_fences_without_timer_queries)
+{
+    provide_fences();
+    timer = mrg::GPUTimer::create();
+    ASSERT_THAT(timer, NotNull());
+
+    auto const fence = reinterpret_cast<EGLSyncKHR>(1);
+    render_frame({GPUTiming::Class::clear, GPUTiming::Class::opaque});
+    EXPECT_THAT(timer->completed(), IsEmpty());
+
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, fence, _, 0))
+        .WillOnce(Return(EGL_CONDITION_SATISFIED_KHR));
+    EXPECT_CALL(mock_egl, eglDestroySyncKHR(_, fence));
+    auto const timings = timer->completed();
+
+    ASSERT_THAT(timings.size(), Eq(1u));
+    EXPECT_THAT(timings[0].method, Eq(GPUTiming::Method::fence));
+    EXPECT_THAT(timings[0].time_in(GPUTiming::Class::opaque), Eq(0ns));
+}
+
+TEST_F(GPUTimer, destroys_the_fences_of_frames_beyond_the_pending_limit)
+{
+    provide_fences();
+    timer = mrg::GPUTimer::create();
+    ASSERT_THAT(timer, NotNull());
+
+    for (std::size_t frame = 0; frame != max_pending_frames; ++frame)
+        render_frame({GPUTiming::Class::clear});
+
+    EXPECT_CALL(mock_egl, eglDestroySyncKHR(_, reinterpret_cast<EGLSyncKHR>(1)));
+    render_frame({GPUTiming::Class::clear});
+    Mock::VerifyAndClearExpectations(&mock_egl);
+
+    EXPECT_CALL(mock_egl, eglDestroySyncKHR(_, _)).Times(max_pending_frames);
+    timer.reset();
+}
+
+TEST_F(GPUTimer, is_unavailable_without_timer_queries_or_fences)
+{
+    provide_gl_extensions("GL_OES_EGL_image");
+
+    EXPECT_THAT(mrg::GPUTimer::create(), IsNull());
+}
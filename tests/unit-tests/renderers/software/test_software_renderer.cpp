@@ -0,0 +1,387 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/software/renderer.h"
+#include "src/renderers/software/renderer_factory.h"
+#include "mir/renderer/renderer_factory.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/test/doubles/mock_display_buffer.h"
+#include "mir/test/doubles/mock_renderer.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_renderable.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+uint32_t const red{0xff0000ff};
+uint32_t const blue{0xffff0000};
+uint32_t const cleared{0};
+uint32_t const garbage{0xdeadbeef};
+uint32_t const untouched{0x01020304};
+
+/// The pixels of a display buffer, mapped as abgr_8888
+template<typename T>
+class PixelMapping : public mrs::Mapping<T>
+{
+public:
+    PixelMapping(std::vector<uint32_t>& pixels, geom::Size const& size)
+        : pixels{pixels},
+          size_{size}
+    {
+    }
+
+    MirPixelFormat format() const override { return mir_pixel_format_abgr_8888; }
+    geom::Stride stride() const override { return geom::Stride{size_.width.as_int() * 4}; }
+    geom::Size size() const override { return size_; }
+    T* data() override { return reinterpret_cast<T*>(pixels.data()); }
+    size_t len() const override { return pixels.size() * 4; }
+
+private:
+    std::vector<uint32_t>& pixels;
+    geom::Size const size_;
+};
+
+struct MappableDisplayBuffer : mtd::MockDisplayBuffer, mrs::WriteMappableBuffer
+{
+    explicit MappableDisplayBuffer(geom::Rectangle const& area)
+        : pixels(area.size.width.as_int() * area.size.height.as_int(), garbage),
+          size{area.size}
+    {
+        ON_CALL(*this, view_area()).WillByDefault(Return(area));
+    }
+
+    std::unique_ptr<mrs::Mapping<unsigned char>> map_writeable() override
+    {
+        // The content of a mapping only for writing is undefined (as of a bounce buffer)
+        std::fill(pixels.begin(), pixels.end(), garbage);
+        return std::make_unique<PixelMapping<unsigned char>>(pixels, size);
+    }
+
+    std::vector<uint32_t> pixels;
+    geom::Size const size;
+};
+
+struct RWMappableDisplayBuffer : mtd::MockDisplayBuffer, mrs::RWMappableBuffer
+{
+    explicit RWMappableDisplayBuffer(geom::Rectangle const& area)
+        : pixels(area.size.width.as_int() * area.size.height.as_int(), garbage),
+          size{area.size}
+    {
+        ON_CALL(*this, view_area()).WillByDefault(Return(area));
+    }
+
+    std::unique_ptr<mrs::Mapping<unsigned char>> map_writeable() override
+    {
+        std::fill(pixels.begin(), pixels.end(), garbage);
+        return std::make_unique<PixelMapping<unsigned char>>(pixels, size);
+    }
+
+    std::unique_ptr<mrs::Mapping<unsigned char const>> map_readable() override
+    {
+        return std::make_unique<PixelMapping<unsigned char const>>(pixels, size);
+    }
+
+    std::unique_ptr<mrs::Mapping<unsigned char>> map_rw() override
+    {
+        return std::make_unique<PixelMapping<unsigned char>>(pixels, size);
+    }
+
+    std::vector<uint32_t> pixels;
+    geom::Size const size;
+};
+
+struct CountingBuffer : mtd::StubBuffer
+{
+    using StubBuffer::StubBuffer;
+
+    void read(std::function<void(unsigned char const*)> const& do_with_pixels) override
+    {
+        ++reads;
+        StubBuffer::read(do_with_pixels);
+    }
+
+    int reads{0};
+};
+
+auto buffer_of(geom::Size const& size, uint32_t colour) -> std::shared_ptr<CountingBuffer>
+{
+    auto const buffer = std::make_shared<CountingBuffer>(
+        mg::BufferProperties{size, mir_pixel_format_abgr_8888, mg::BufferUsage::software});
+    std::vector<uint32_t> const pixels(size.width.as_int() * size.height.as_int(), colour);
+    buffer->write(reinterpret_cast<unsigned char const*>(pixels.data()), pixels.size() * 4);
+    return buffer;
+}
+
+struct TestRenderable : mtd::StubRenderable
+{
+    TestRenderable(std::shared_ptr<mg::Buffer> const& buffer, geom::Rectangle const& position)
+        : StubRenderable{buffer, position}
+    {
+    }
+
+    std::experimental::optional<geom::Rectangle> clip_area() const override { return clip; }
+    float alpha() const override { return alpha_; }
+    bool shaped() const override { return shaped_; }
+    glm::mat4 transformation() const override { return transform; }
+
+    std::experimental::optional<geom::Rectangle> clip;
+    float alpha_{1.0f};
+    bool shaped_{false};
+    glm::mat4 transform{1};
+};
+
+struct RecordingReadback : mir::renderer::Readback
+{
+    explicit RecordingReadback(geom::Rectangle const& region)
+        : region{region}
+    {
+    }
+
+    auto regions() const -> geom::Rectangles override { return geom::Rectangles{region}; }
+
+    void deliver(geom::Rectangle const&, unsigned char const* data, geom::Stride stride) override
+    {
+        for (auto y = 0; y != region.size.height.as_int(); ++y)
+        {
+            auto const row = reinterpret_cast<uint32_t const*>(data + y * stride.as_int());
+            pixels.insert(pixels.end(), row, row + region.size.width.as_int());
+        }
+    }
+
+    void finished(bool complete) override { result = complete ? 1 : 0; }
+
+    geom::Rectangle const region;
+    std::vector<uint32_t> pixels;
+    int result{-1};
+};
+
+struct StubRendererFactory : mir::renderer::RendererFactory
+{
+    std::unique_ptr<mir::renderer::Renderer> create_renderer_for(mg::DisplayBuffer&) override
+    {
+        std::unique_ptr<mir::renderer::Renderer> renderer = std::make_unique<NiceMock<mtd::MockRenderer>>();
+        created = renderer.get();
+        return renderer;
+    }
+
+    mir::renderer::Renderer* created{nullptr};
+};
+
+struct SoftwareRenderer : Test
+{
+    geom::Rectangle const view_area{{0, 0}, {8, 4}};
+    NiceMock<MappableDisplayBuffer> display_buffer{view_area};
+
+    auto pixel(int x, int y) const -> uint32_t
+    {
+        return display_buffer.pixels[y * view_area.size.width.as_int() + x];
+    }
+
+    auto renderable_of(geom::Rectangle const& position, uint32_t colour) -> std::shared_ptr<TestRenderable>
+    {
+        return std::make_shared<TestRenderable>(buffer_of(position.size, colour), position);
+    }
+};
+}
+
+TEST_F(SoftwareRenderer, composites_renderables_into_the_mapped_display_buffer)
+{
+    mrs::Renderer renderer{display_buffer, display_buffer};
+
+    renderer.render({renderable_of({{2, 1}, {2, 2}}, red)});
+
+    EXPECT_THAT(pixel(2, 1), Eq(red));
+    EXPECT_THAT(pixel(3, 2), Eq(red));
+    EXPECT_THAT(pixel(1, 1), Eq(cleared));
+    EXPECT_THAT(pixel(4, 2), Eq(cleared));
+    EXPECT_THAT(display_buffer.pixels, Not(Contains(garbage)));
+}
+
+TEST_F(SoftwareRenderer, blends_shaped_renderables_as_premultiplied_over_those_below)
+{
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const translucent = renderable_of({{0, 0}, {1, 1}}, 0x80000080);
+    translucent->shaped_ = true;
+
+    renderer.render({renderable_of(view_area, blue), translucent});
+
+    EXPECT_THAT(pixel(0, 0), Eq(0xff7f0080u));
+    EXPECT_THAT(pixel(1, 0), Eq(blue));
+}
+
+TEST_F(SoftwareRenderer, fades_unshaped_renderables_ignoring_their_alpha_channel)
+{
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const faded = renderable_of({{0, 0}, {1, 1}}, 0x000000ff);
+    faded->alpha_ = 0.5f;
+
+    renderer.render({renderable_of(view_area, blue), faded});
+
+    EXPECT_THAT(pixel(0, 0), Eq(0xff7f0080u));
+}
+
+TEST_F(SoftwareRenderer, clips_renderables_to_their_clip_area)
+{
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const clipped = renderable_of({{0, 0}, {4, 4}}, red);
+    clipped->clip = geom::Rectangle{{1, 1}, {2, 2}};
+
+    renderer.render({clipped});
+
+    EXPECT_THAT(pixel(0, 0), Eq(cleared));
+    EXPECT_THAT(pixel(1, 1), Eq(red));
+    EXPECT_THAT(pixel(2, 2), Eq(red));
+    EXPECT_THAT(pixel(3, 3), Eq(cleared));
+}
+
+TEST_F(SoftwareRenderer, redraws_and_copies_only_what_changed_into_buffers_mapped_with_their_content)
+{
+    NiceMock<RWMappableDisplayBuffer> display_buffer{view_area};
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const buffer = buffer_of(view_area.size, blue);
+    auto const background = std::make_shared<TestRenderable>(buffer, view_area);
+    auto const translucent = renderable_of({{6, 3}, {1, 1}}, 0x80000080);
+    translucent->shaped_ = true;
+
+    renderer.render({background});
+    EXPECT_THAT(display_buffer.pixels, Each(Eq(blue)));
+    std::fill(display_buffer.pixels.begin(), display_buffer.pixels.end(), untouched);
+
+    // New content in the same buffer isn't damage, so shows only where something else changed
+    std::vector<uint32_t> const white(view_area.size.width.as_int() * view_area.size.height.as_int(), 0xffffffff);
+    buffer->write(reinterpret_cast<unsigned char const*>(white.data()), white.size() * 4);
+    renderer.render({background, translucent});
+
+    EXPECT_THAT(display_buffer.pixels[3 * view_area.size.width.as_int() + 6], Eq(0xff7f7fffu));
+    EXPECT_THAT(std::count(display_buffer.pixels.begin(), display_buffer.pixels.end(), untouched),
+                Eq(static_cast<long>(display_buffer.pixels.size() - 1)));
+}
+
+TEST_F(SoftwareRenderer, copies_the_whole_frame_once_resumed)
+{
+    NiceMock<RWMappableDisplayBuffer> display_buffer{view_area};
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const background = renderable_of(view_area, blue);
+
+    renderer.render({background});
+    std::fill(display_buffer.pixels.begin(), display_buffer.pixels.end(), untouched);
+
+    // Whatever was shown meanwhile may have been drawn into the display buffer
+    renderer.suspend();
+    renderer.render({background});
+
+    EXPECT_THAT(display_buffer.pixels, Each(Eq(blue)));
+}
+
+TEST_F(SoftwareRenderer, copies_the_whole_frame_into_buffers_mapped_only_for_writing)
+{
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const background = renderable_of(view_area, blue);
+    auto const translucent = renderable_of({{6, 3}, {1, 1}}, 0x80000080);
+    translucent->shaped_ = true;
+
+    renderer.render({background});
+    renderer.render({background, translucent});
+
+    EXPECT_THAT(pixel(6, 3), Eq(0xff7f0080u));
+    EXPECT_THAT(pixel(0, 0), Eq(blue));
+    EXPECT_THAT(display_buffer.pixels, Not(Contains(garbage)));
+}
+
+TEST_F(SoftwareRenderer, does_not_read_renderables_hidden_by_opaque_ones)
+{
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const hidden = buffer_of(view_area.size, red);
+
+    renderer.render({
+        std::make_shared<TestRenderable>(hidden, view_area),
+        renderable_of(view_area, blue)});
+
+    EXPECT_THAT(hidden->reads, Eq(0));
+    EXPECT_THAT(pixel(0, 0), Eq(blue));
+}
+
+TEST_F(SoftwareRenderer, draws_frames_with_transformed_renderables_with_the_fallback)
+{
+    auto fallback = std::make_unique<NiceMock<mtd::MockRenderer>>();
+    auto& gl = *fallback;
+    mrs::Renderer renderer{display_buffer, display_buffer, std::move(fallback)};
+    auto const rotated = renderable_of({{0, 0}, {2, 2}}, red);
+    rotated->transform = glm::mat4{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    EXPECT_CALL(gl, render(_)).Times(1);
+    renderer.render({rotated});
+    Mock::VerifyAndClearExpectations(&gl);
+
+    EXPECT_CALL(gl, render(_)).Times(0);
+    renderer.render({renderable_of(view_area, blue)});
+
+    // The fallback drew the last frame, so all of this one is copied
+    EXPECT_THAT(display_buffer.pixels, Each(Eq(blue)));
+}
+
+TEST_F(SoftwareRenderer, without_a_fallback_leaves_out_what_it_cannot_draw)
+{
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const rotated = renderable_of({{0, 0}, {2, 2}}, red);
+    rotated->transform = glm::mat4{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    renderer.render({renderable_of(view_area, blue), rotated});
+
+    EXPECT_THAT(pixel(0, 0), Eq(blue));
+}
+
+TEST_F(SoftwareRenderer, reads_back_the_composited_frame)
+{
+    mrs::Renderer renderer{display_buffer, display_buffer};
+    auto const readback = std::make_shared<RecordingReadback>(geom::Rectangle{{1, 0}, {2, 1}});
+    auto const outside = std::make_shared<RecordingReadback>(geom::Rectangle{{7, 0}, {2, 1}});
+
+    renderer.read_back(readback);
+    renderer.read_back(outside);
+    renderer.render({renderable_of({{0, 0}, {2, 1}}, red)});
+
+    EXPECT_THAT(readback->result, Eq(1));
+    EXPECT_THAT(readback->pixels, ElementsAre(red, cleared));
+    EXPECT_THAT(outside->result, Eq(0));
+}
+
+TEST_F(SoftwareRenderer, factory_leaves_display_buffers_that_cannot_be_mapped_to_gl)
+{
+    auto const gl_factory = std::make_shared<StubRendererFactory>();
+    mrs::RendererFactory factory{gl_factory};
+    NiceMock<mtd::MockDisplayBuffer> unmappable;
+
+    auto const for_unmappable = factory.create_renderer_for(unmappable);
+    EXPECT_THAT(for_unmappable.get(), Eq(gl_factory->created));
+
+    gl_factory->created = nullptr;
+    auto const for_mappable = factory.create_renderer_for(display_buffer);
+    EXPECT_THAT(dynamic_cast<mrs::Renderer*>(for_mappable.get()), NotNull());
+    EXPECT_THAT(gl_factory->created, IsNull());
+}
@@ -24,9 +24,11 @@
 #include "mir/scene/session_container.h"
 #include "mir/scene/surface_creation_parameters.h"
 #include "mir/scene/surface_factory.h"
+#include "mir/scene/memory_accounting.h"
 #include "mir/graphics/display_configuration_observer.h"
 
 #include "src/server/report/null/shell_report.h"
+#include "src/server/report/null_report_factory.h"
 #include "src/include/server/mir/scene/session_event_sink.h"
 #include "src/server/scene/session_manager.h"
 #include "src/server/shell/decoration/null_manager.h"
@@ -112,7 +114,8 @@ struct MockSessionManager : ms::SessionManager
               display,
               std::make_shared<mtd::NullANRDetector>(),
               std::make_shared<mtd::StubBufferAllocator>(),
-              std::make_shared<mtd::StubObserverRegistrar<mir::graphics::DisplayConfigurationObserver>>()}
+              std::make_shared<mtd::StubObserverRegistrar<mir::graphics::DisplayConfigurationObserver>>(),
+              std::make_shared<ms::MemoryAccounting>(0, mir::report::null_scene_report())}
     {
     }
 
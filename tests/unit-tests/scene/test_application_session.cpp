@@ -24,6 +24,7 @@
 #include "mir/scene/null_session_listener.h"
 #include "mir/scene/surface_event_source.h"
 #include "mir/scene/output_properties_cache.h"
+#include "mir/scene/memory_accounting.h"
 #include "mir/client_visible_error.h"
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/mock_surface_stack.h"
@@ -41,6 +42,7 @@
 #include "mir/test/doubles/stub_buffer_allocator.h"
 #include "mir/test/doubles/stub_observer_registrar.h"
 #include "mir/graphics/display_configuration_observer.h"
+#include "src/server/report/null_report_factory.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -82,6 +84,10 @@ public:
     MOCK_METHOD2(take_snapshot_of,
                 void(std::shared_ptr<mc::BufferStream> const&,
                      ms::SnapshotCallback const&));
+    MOCK_METHOD3(take_thumbnail_of,
+                void(std::shared_ptr<mc::BufferStream> const&,
+                     geom::Size const&,
+                     ms::SnapshotCallback const&));
 };
 
 struct MockSnapshotCallback
@@ -153,7 +159,8 @@ struct ApplicationSession : public testing::Test
            null_snapshot_strategy,
            stub_session_listener,
            event_sink,
-           allocator);
+           allocator,
+           memory_accounting);
     }
     
     std::shared_ptr<ms::ApplicationSession> make_application_session(
@@ -169,7 +176,8 @@ struct ApplicationSession : public testing::Test
            null_snapshot_strategy,
            stub_session_listener,
            event_sink,
-           allocator);
+           allocator,
+           memory_accounting);
     }
 
     std::shared_ptr<ms::ApplicationSession> make_application_session(
@@ -185,7 +193,8 @@ struct ApplicationSession : public testing::Test
            null_snapshot_strategy,
            stub_session_listener,
            event_sink,
-           allocator);
+           allocator,
+           memory_accounting);
     }
     std::shared_ptr<ms::ApplicationSession> make_application_session_with_coordinator(
         std::shared_ptr<msh::SurfaceStack> const& surface_stack)
@@ -199,7 +208,8 @@ struct ApplicationSession : public testing::Test
            null_snapshot_strategy,
            stub_session_listener,
            event_sink,
-           allocator);
+           allocator,
+           memory_accounting);
     }
     
     std::shared_ptr<ms::ApplicationSession> make_application_session_with_listener(
@@ -214,7 +224,8 @@ struct ApplicationSession : public testing::Test
            null_snapshot_strategy,
            session_listener,
            event_sink,
-           allocator);
+           allocator,
+           memory_accounting);
     }
 
 
@@ -230,7 +241,8 @@ struct ApplicationSession : public testing::Test
            null_snapshot_strategy,
            stub_session_listener,
            event_sink,
-           allocator);
+           allocator,
+           memory_accounting);
     }
 
     std::shared_ptr<mtd::NullEventSink> const event_sink;
@@ -244,6 +256,8 @@ struct ApplicationSession : public testing::Test
     std::shared_ptr<mtd::StubBufferStream> const stub_buffer_stream{std::make_shared<mtd::StubBufferStream>()};
     std::shared_ptr<mtd::StubBufferAllocator> const allocator{
         std::make_shared<mtd::StubBufferAllocator>()};
+    std::shared_ptr<ms::MemoryAccounting> const memory_accounting{
+        std::make_shared<ms::MemoryAccounting>(0, mir::report::null_scene_report())};
     pid_t pid;
     std::string name;
     mg::BufferProperties properties { geom::Size{1,1}, mir_pixel_format_abgr_8888, mg::BufferUsage::hardware };
@@ -504,7 +518,8 @@ TEST_F(ApplicationSession, takes_snapshot_of_default_surface)
         snapshot_strategy,
         std::make_shared<ms::NullSessionListener>(),
         event_sink,
-        allocator);
+        allocator,
+        memory_accounting);
 
     ms::SurfaceCreationParameters params = ms::a_surface()
         .with_buffer_stream(app_session.create_buffer_stream(properties));
@@ -529,7 +544,8 @@ TEST_F(ApplicationSession, returns_null_snapshot_if_no_default_surface)
         snapshot_strategy,
         std::make_shared<ms::NullSessionListener>(),
         event_sink,
-        allocator);
+        allocator,
+        memory_accounting);
 
     EXPECT_CALL(*snapshot_strategy, take_snapshot_of(_,_)).Times(0);
     EXPECT_CALL(mock_snapshot_callback, operator_call(IsNullSnapshot()));
@@ -537,6 +553,67 @@ TEST_F(ApplicationSession, returns_null_snapshot_if_no_default_surface)
     app_session.take_snapshot(std::ref(mock_snapshot_callback));
 }
 
+TEST_F(ApplicationSession, takes_thumbnail_of_default_surface)
+{
+    using namespace ::testing;
+
+    auto mock_surface = make_mock_surface();
+    NiceMock<MockSurfaceFactory> surface_factory;
+    MockBufferStreamFactory mock_buffer_stream_factory;
+    std::shared_ptr<mc::BufferStream> const mock_stream = std::make_shared<mtd::MockBufferStream>();
+    ON_CALL(mock_buffer_stream_factory, create_buffer_stream(_)).WillByDefault(Return(mock_stream));
+    ON_CALL(surface_factory, create_surface(_, _, _)).WillByDefault(Return(mock_surface));
+    NiceMock<mtd::MockSurfaceStack> surface_stack;
+    geom::Size const max_size{128, 128};
+
+    auto const snapshot_strategy = std::make_shared<MockSnapshotStrategy>();
+
+    EXPECT_CALL(*snapshot_strategy, take_thumbnail_of(mock_stream, max_size, _));
+
+    ms::ApplicationSession app_session(
+        mt::fake_shared(surface_stack),
+        mt::fake_shared(surface_factory),
+        mt::fake_shared(mock_buffer_stream_factory),
+        pid,
+        name,
+        snapshot_strategy,
+        std::make_shared<ms::NullSessionListener>(),
+        event_sink,
+        allocator,
+        memory_accounting);
+
+    ms::SurfaceCreationParameters params = ms::a_surface()
+        .with_buffer_stream(app_session.create_buffer_stream(properties));
+    auto surface = app_session.create_surface(nullptr, params, surface_observer);
+    app_session.take_thumbnail(max_size, ms::SnapshotCallback());
+    app_session.destroy_surface(surface);
+}
+
+TEST_F(ApplicationSession, returns_null_thumbnail_if_no_default_surface)
+{
+    using namespace ::testing;
+
+    auto snapshot_strategy = std::make_shared<MockSnapshotStrategy>();
+    MockSnapshotCallback mock_snapshot_callback;
+
+    ms::ApplicationSession app_session(
+        stub_surface_stack,
+        stub_surface_factory,
+        stub_buffer_stream_factory,
+        pid,
+        name,
+        snapshot_strategy,
+        std::make_shared<ms::NullSessionListener>(),
+        event_sink,
+        allocator,
+        memory_accounting);
+
+    EXPECT_CALL(*snapshot_strategy, take_thumbnail_of(_,_,_)).Times(0);
+    EXPECT_CALL(mock_snapshot_callback, operator_call(IsNullSnapshot()));
+
+    app_session.take_thumbnail({128, 128}, std::ref(mock_snapshot_callback));
+}
+
 TEST_F(ApplicationSession, process_id)
 {
     using namespace ::testing;
@@ -552,7 +629,8 @@ TEST_F(ApplicationSession, process_id)
         null_snapshot_strategy,
         std::make_shared<ms::NullSessionListener>(),
         event_sink,
-        allocator);
+        allocator,
+        memory_accounting);
 
     EXPECT_THAT(app_session.process_id(), Eq(session_pid));
 }
@@ -721,7 +799,8 @@ struct ApplicationSessionSender : public ApplicationSession
             null_snapshot_strategy,
             stub_session_listener,
             mt::fake_shared(sender),
-            allocator)
+            allocator,
+            memory_accounting)
     {
     }
 
@@ -844,7 +923,8 @@ struct ApplicationSessionSurfaceOutput : public ApplicationSession
             null_snapshot_strategy,
             stub_session_listener,
             sender,
-            allocator)
+            allocator,
+            memory_accounting)
     {
     }
 
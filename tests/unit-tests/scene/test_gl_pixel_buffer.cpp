@@ -21,12 +21,15 @@
 
 #include "mir/test/doubles/mock_gl_buffer.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <GLES2/gl2ext.h>
 
+#include <vector>
+
 namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 namespace ms = mir::scene;
@@ -56,6 +59,9 @@ struct WrappingGLContext : public mrgl::Context
     mrgl::Context& wrapped;
 };
 
+GLint const flip_uniform{7};
+GLint const swizzle_uniform{8};
+
 class GLPixelBufferTest : public ::testing::Test
 {
 public:
@@ -66,12 +72,36 @@ public:
 
         ON_CALL(mock_buffer, size())
             .WillByDefault(Return(geom::Size{51, 71}));
+        ON_CALL(mock_gl, glGetUniformLocation(_, StrEq("flip")))
+            .WillByDefault(Return(flip_uniform));
+        ON_CALL(mock_gl, glGetUniformLocation(_, StrEq("swizzle")))
+            .WillByDefault(Return(swizzle_uniform));
+    }
+
+    /// A callback that keeps what it is given
+    auto keep_snapshot() -> ms::SnapshotCallback
+    {
+        return [this](ms::Snapshot const& snapshot)
+            {
+                ++snapshots;
+                taken = snapshot;
+                if (snapshot.pixels)
+                {
+                    auto const pixels = static_cast<uint32_t const*>(snapshot.pixels);
+                    taken_pixels.assign(
+                        pixels, pixels + snapshot.size.width.as_int() * snapshot.size.height.as_int());
+                }
+            };
     }
 
     testing::NiceMock<mtd::MockGL> mock_gl;
     testing::NiceMock<mtd::MockGLBuffer> mock_buffer;
-    MockGLContext mock_context;
+    testing::NiceMock<MockGLContext> mock_context;
     std::unique_ptr<WrappingGLContext> context;
+
+    int snapshots{0};
+    ms::Snapshot taken;
+    std::vector<uint32_t> taken_pixels;
 };
 
 ACTION(FillPixels)
@@ -86,36 +116,49 @@ ACTION(FillPixels)
     }
 }
 
-ACTION(FillPixelsRGBA)
+// Stand-ins for the GLES 3 entry points GLPixelBuffer looks up
+std::vector<uint32_t> pack_buffer_contents;
+GLenum fence_status{0x911B}; // GL_TIMEOUT_EXPIRED
+
+void* fake_glMapBufferRange(GLenum, GLintptr, GLsizeiptr, GLbitfield)
 {
-    auto const pixels = static_cast<uint32_t*>(arg6);
-    size_t const width = arg2;
-    size_t const height = arg3;
+    return pack_buffer_contents.data();
+}
 
-    for (uint32_t i = 0; i < width * height; ++i)
-    {
-        pixels[i] = ((i << 16) & 0x00ff0000) | /* Move R to new position */
-                    ((i) & 0x0000ff00) |       /* G remains at same position */
-                    ((i >> 16) & 0x000000ff) | /* Move B to new position */
-                    ((i) & 0xff000000);        /* A remains at same position */
-    }
+GLboolean fake_glUnmapBuffer(GLenum)
+{
+    return GL_TRUE;
 }
 
+void* fake_glFenceSync(GLenum, GLbitfield)
+{
+    return &fence_status;
 }
 
-TEST_F(GLPixelBufferTest, returns_empty_if_not_initialized)
+GLenum fake_glClientWaitSync(void*, GLbitfield, uint64_t)
 {
-    ms::GLPixelBuffer pixels{std::move(context)};
+    return fence_status;
+}
 
-    EXPECT_EQ(geom::Size(), pixels.size());
-    EXPECT_EQ(geom::Stride(), pixels.stride());
+void fake_glDeleteSync(void*)
+{
 }
 
-TEST_F(GLPixelBufferTest, returns_data_from_bgra_buffer_texture)
+}
+
+TEST_F(GLPixelBufferTest, does_no_gl_work_if_not_used)
+{
+    using namespace testing;
+
+    EXPECT_CALL(mock_context, make_current()).Times(0);
+    EXPECT_CALL(mock_gl, glDeleteTextures(_,_)).Times(0);
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+}
+
+TEST_F(GLPixelBufferTest, reads_buffer_drawn_the_right_way_up_as_argb)
 {
     using namespace testing;
-    GLuint const tex{10};
-    GLuint const fbo{20};
     uint32_t const width{mock_buffer.size().width.as_uint32_t()};
     uint32_t const height{mock_buffer.size().height.as_uint32_t()};
 
@@ -125,103 +168,128 @@ TEST_F(GLPixelBufferTest, returns_data_from_bgra_buffer_texture)
         /* The GL context is made current */
         EXPECT_CALL(mock_context, make_current());
 
-        /* The texture and framebuffer are prepared */
-        EXPECT_CALL(mock_gl, glGenTextures(_,_))
-            .WillOnce(SetArgPointee<1>(tex));
-        EXPECT_CALL(mock_gl, glBindTexture(_,tex));
-        EXPECT_CALL(mock_gl, glGenFramebuffers(_,_))
-            .WillOnce(SetArgPointee<1>(fbo));
-        EXPECT_CALL(mock_gl, glBindFramebuffer(_,fbo));
-
-        /* The buffer texture is read as BGRA */
+        /* The buffer's texture is drawn flipped and with red and blue swapped... */
         EXPECT_CALL(mock_buffer, gl_bind_to_texture());
-        EXPECT_CALL(mock_gl, glFramebufferTexture2D(_,_,_,tex,0));
-        EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height,
-                                          GL_BGRA_EXT, GL_UNSIGNED_BYTE, _))
+        EXPECT_CALL(mock_gl, glViewport(0, 0, width, height));
+        EXPECT_CALL(mock_gl, glUniform1f(flip_uniform, 1.0f));
+        EXPECT_CALL(mock_gl, glUniform1f(swizzle_uniform, 1.0f));
+        EXPECT_CALL(mock_gl, glDrawArrays(_, _, 4));
+
+        /* ...then read as it is */
+        EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NotNull()))
             .WillOnce(FillPixels());
 
         /* at destruction */
         EXPECT_CALL(mock_context, make_current());
-        EXPECT_CALL(mock_gl, glDeleteTextures(_,_));
-        EXPECT_CALL(mock_gl, glDeleteFramebuffers(_,_));
     }
 
     ms::GLPixelBuffer pixels{std::move(context)};
 
-    pixels.fill_from(mock_buffer);
-    auto data = pixels.as_argb_8888();
-
-    EXPECT_EQ(mock_buffer.size(), pixels.size());
-    EXPECT_EQ(geom::Stride{width * 4}, pixels.stride());
-
-    /* Check that data has been properly y-flipped */
-    EXPECT_EQ(1,
-              static_cast<uint32_t const*>(data)[width * (height - 1) + 1]);
-    EXPECT_EQ(width * (height / 2),
-              static_cast<uint32_t const*>(data)[width * (height / 2)]);
-    EXPECT_EQ(width * (height - 1),
-              static_cast<uint32_t const*>(data)[0]);
-    EXPECT_EQ(width - 1,
-              static_cast<uint32_t const*>(data)[width * height - 1]);
+    pixels.fill_from(mock_buffer, {}, keep_snapshot());
+
+    ASSERT_THAT(snapshots, Eq(1));
+    EXPECT_EQ(mock_buffer.size(), taken.size);
+    EXPECT_EQ(geom::Stride{width * 4}, taken.stride);
+    ASSERT_THAT(taken_pixels.size(), Eq(width * height));
+    EXPECT_THAT(taken_pixels[0], Eq(0u));
+    EXPECT_THAT(taken_pixels[width * height - 1], Eq(width * height - 1));
+    EXPECT_FALSE(pixels.collect(false));
 }
 
-TEST_F(GLPixelBufferTest, returns_data_from_rgba_buffer_texture)
+TEST_F(GLPixelBufferTest, scales_down_by_halves_to_fit_max_size)
 {
     using namespace testing;
-    GLuint const tex{10};
-    GLuint const fbo{20};
-    uint32_t const width{mock_buffer.size().width.as_uint32_t()};
-    uint32_t const height{mock_buffer.size().height.as_uint32_t()};
 
+    EXPECT_CALL(mock_gl, glUniform1f(swizzle_uniform, _)).Times(AnyNumber());
     {
         InSequence s;
 
-        /* The GL context is made current */
-        EXPECT_CALL(mock_context, make_current());
+        EXPECT_CALL(mock_gl, glViewport(0, 0, 26, 36));
+        EXPECT_CALL(mock_gl, glUniform1f(flip_uniform, 0.0f));
+        EXPECT_CALL(mock_gl, glDrawArrays(_, _, 4));
 
-        /* The texture and framebuffer are prepared */
-        EXPECT_CALL(mock_gl, glGenTextures(_,_))
-            .WillOnce(SetArgPointee<1>(tex));
-        EXPECT_CALL(mock_gl, glBindTexture(_,tex));
-        EXPECT_CALL(mock_gl, glGenFramebuffers(_,_))
-            .WillOnce(SetArgPointee<1>(fbo));
-        EXPECT_CALL(mock_gl, glBindFramebuffer(_,fbo));
+        EXPECT_CALL(mock_gl, glViewport(0, 0, 14, 20));
+        EXPECT_CALL(mock_gl, glUniform1f(flip_uniform, 1.0f));
+        EXPECT_CALL(mock_gl, glDrawArrays(_, _, 4));
 
-        /* Try to read the FBO as BGRA but fail */
-        EXPECT_CALL(mock_buffer, gl_bind_to_texture());
-        EXPECT_CALL(mock_gl, glFramebufferTexture2D(_,_,_,tex,0));
-        EXPECT_CALL(mock_gl, glGetError())
-            .WillOnce(Return(GL_NO_ERROR));
-        EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height,
-                                          GL_BGRA_EXT, GL_UNSIGNED_BYTE, _));
-        EXPECT_CALL(mock_gl, glGetError())
-            .WillOnce(Return(GL_INVALID_ENUM));
-        /* Read as RGBA */
-        EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height,
-                                          GL_RGBA, GL_UNSIGNED_BYTE, _))
-            .WillOnce(FillPixelsRGBA());
-
-        /* at destruction */
-        EXPECT_CALL(mock_context, make_current());
-        EXPECT_CALL(mock_gl, glDeleteTextures(_,_));
-        EXPECT_CALL(mock_gl, glDeleteFramebuffers(_,_));
+        EXPECT_CALL(mock_gl, glReadPixels(0, 0, 14, 20, GL_RGBA, GL_UNSIGNED_BYTE, _));
     }
 
     ms::GLPixelBuffer pixels{std::move(context)};
 
-    pixels.fill_from(mock_buffer);
-    auto data = pixels.as_argb_8888();
-
-    EXPECT_EQ(mock_buffer.size(), pixels.size());
-    EXPECT_EQ(geom::Stride{width * 4}, pixels.stride());
-
-    /* Check that data has been properly y-flipped and converted to argb_8888 */
-    EXPECT_EQ(1,
-              static_cast<uint32_t const*>(data)[width * (height - 1) + 1]);
-    EXPECT_EQ(width * (height / 2),
-              static_cast<uint32_t const*>(data)[width * (height / 2)]);
-    EXPECT_EQ(width * (height - 1),
-              static_cast<uint32_t const*>(data)[0]);
-    EXPECT_EQ(width - 1,
-              static_cast<uint32_t const*>(data)[width * height - 1]);
+    pixels.fill_from(mock_buffer, {20, 20}, keep_snapshot());
+
+    EXPECT_EQ((geom::Size{14, 20}), taken.size);
+    EXPECT_EQ(geom::Stride{14 * 4}, taken.stride);
+}
+
+TEST_F(GLPixelBufferTest, does_not_scale_up)
+{
+    using namespace testing;
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, 51, 71, GL_RGBA, GL_UNSIGNED_BYTE, _));
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixels.fill_from(mock_buffer, {100, 100}, keep_snapshot());
+
+    EXPECT_EQ(mock_buffer.size(), taken.size);
+}
+
+TEST_F(GLPixelBufferTest, reads_through_pixel_pack_buffer_without_waiting_for_gpu)
+{
+    using namespace testing;
+    using func_ptr_t = mtd::MockEGL::generic_function_pointer_t;
+
+    NiceMock<mtd::MockEGL> mock_egl;
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.0")));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glMapBufferRange")))
+        .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glMapBufferRange)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glUnmapBuffer")))
+        .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glUnmapBuffer)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glFenceSync")))
+        .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glFenceSync)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glClientWaitSync")))
+        .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glClientWaitSync)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glDeleteSync")))
+        .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glDeleteSync)));
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, 51, 71, GL_RGBA, GL_UNSIGNED_BYTE, IsNull()));
+
+    pack_buffer_contents.assign(51 * 71, 0xff0000ff);
+    fence_status = 0x911B; // GL_TIMEOUT_EXPIRED
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixels.fill_from(mock_buffer, {}, keep_snapshot());
+
+    EXPECT_THAT(snapshots, Eq(0));
+    EXPECT_TRUE(pixels.collect(false));
+    EXPECT_THAT(snapshots, Eq(0));
+
+    fence_status = 0x911C; // GL_CONDITION_SATISFIED
+
+    EXPECT_FALSE(pixels.collect(false));
+    ASSERT_THAT(snapshots, Eq(1));
+    EXPECT_EQ(mock_buffer.size(), taken.size);
+    EXPECT_THAT(taken_pixels, Each(Eq(0xff0000ffu)));
+}
+
+TEST_F(GLPixelBufferTest, cleans_up_in_its_context)
+{
+    using namespace testing;
+
+    {
+        ms::GLPixelBuffer pixels{std::move(context)};
+        pixels.fill_from(mock_buffer, {}, keep_snapshot());
+
+        Mock::VerifyAndClearExpectations(&mock_context);
+
+        InSequence s;
+        EXPECT_CALL(mock_context, make_current());
+        EXPECT_CALL(mock_gl, glDeleteTextures(_,_)).Times(2);
+        EXPECT_CALL(mock_gl, glDeleteFramebuffers(_,_));
+        EXPECT_CALL(mock_gl, glDeleteProgram(_));
+    }
 }
@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/scene/memory_account.h"
+#include "mir/scene/memory_accounting.h"
+#include "mir/scene/scene_report.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace ms = mir::scene;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+using Kind = ms::MemoryAccount::Kind;
+
+namespace
+{
+struct MockSceneReport : ms::SceneReport
+{
+    MOCK_METHOD2(surface_created, void(BasicSurfaceId, std::string const&));
+    MOCK_METHOD2(surface_added, void(BasicSurfaceId, std::string const&));
+    MOCK_METHOD2(surface_removed, void(BasicSurfaceId, std::string const&));
+    MOCK_METHOD2(surface_deleted, void(BasicSurfaceId, std::string const&));
+    MOCK_METHOD3(session_memory_over_limit, void(std::string const&, std::size_t, std::size_t));
+};
+
+struct MemoryAccount : Test
+{
+    std::size_t const limit{1000};
+    std::shared_ptr<NiceMock<MockSceneReport>> const report{std::make_shared<NiceMock<MockSceneReport>>()};
+    std::shared_ptr<ms::MemoryAccount> const account{
+        std::make_shared<ms::MemoryAccount>("client", 42, limit, report)};
+};
+}
+
+TEST_F(MemoryAccount, charges_by_kind_until_released)
+{
+    auto buffers = account->charge(Kind::buffers, 100);
+    auto const shm = account->charge(Kind::shm, 20);
+
+    EXPECT_THAT(account->usage().current_in(Kind::buffers), Eq(100u));
+    EXPECT_THAT(account->usage().current_in(Kind::shm), Eq(20u));
+    EXPECT_THAT(account->usage().current_in(Kind::textures), Eq(0u));
+    EXPECT_THAT(account->usage().total, Eq(120u));
+
+    buffers.reset();
+
+    EXPECT_THAT(account->usage().current_in(Kind::buffers), Eq(0u));
+    EXPECT_THAT(account->usage().total, Eq(20u));
+}
+
+TEST_F(MemoryAccount, keeps_high_water_marks)
+{
+    {
+        auto const a = account->charge(Kind::textures, 300);
+        auto const b = account->charge(Kind::textures, 200);
+    }
+    auto const c = account->charge(Kind::buffers, 100);
+
+    auto const usage = account->usage();
+    EXPECT_THAT(usage.peak_in(Kind::textures), Eq(500u));
+    EXPECT_THAT(usage.peak_in(Kind::buffers), Eq(100u));
+    EXPECT_THAT(usage.peak_total, Eq(500u));
+    EXPECT_THAT(usage.total, Eq(100u));
+}
+
+TEST_F(MemoryAccount, charged_buffer_is_the_same_buffer_and_refunds_when_released)
+{
+    auto const buffer = std::make_shared<mtd::StubBuffer>(geom::Size{10, 10});
+
+    auto charged = account->charged(buffer, Kind::buffers, 400);
+
+    EXPECT_THAT(charged.get(), Eq(buffer.get()));
+    EXPECT_THAT(account->usage().current_in(Kind::buffers), Eq(400u));
+
+    charged.reset();
+
+    EXPECT_THAT(account->usage().current_in(Kind::buffers), Eq(0u));
+}
+
+TEST_F(MemoryAccount, estimates_buffer_size_from_size_and_format)
+{
+    mtd::StubBuffer const buffer{geom::Size{10, 20}};
+
+    EXPECT_THAT(ms::MemoryAccount::estimated_size(buffer), Eq(10u * 20u * 4u));
+}
+
+TEST_F(MemoryAccount, reports_going_over_limit_once_per_excursion)
+{
+    EXPECT_CALL(*report, session_memory_over_limit("client", 1100, limit)).Times(2);
+
+    auto first = account->charge(Kind::buffers, 600);
+    auto const second = account->charge(Kind::shm, 500);
+    auto const third = account->charge(Kind::shm, 500);
+
+    // Back under the limit...
+    first.reset();
+    auto const fourth = account->charge(Kind::textures, 0);
+
+    // ...and over it again
+    {
+        auto const fifth = account->charge(Kind::textures, 100);
+    }
+}
+
+TEST_F(MemoryAccount, is_not_limited_with_zero_limit)
+{
+    auto const unlimited = std::make_shared<ms::MemoryAccount>("client", 42, 0, report);
+
+    EXPECT_CALL(*report, session_memory_over_limit(_, _, _)).Times(0);
+
+    auto const charge = unlimited->charge(Kind::buffers, 1u << 30);
+}
+
+TEST(MemoryAccounting, charges_textures_to_the_account_of_their_stream)
+{
+    ms::MemoryAccounting accounting{0, std::make_shared<NiceMock<MockSceneReport>>()};
+    int stream;
+
+    auto const account = accounting.open_account("client", 42);
+    accounting.attribute(&stream, account);
+
+    auto const charge = accounting.charge_texture(&stream, 256);
+
+    EXPECT_THAT(charge, NotNull());
+    EXPECT_THAT(account->usage().current_in(Kind::textures), Eq(256u));
+}
+
+TEST(MemoryAccounting, charges_nothing_for_forgotten_streams)
+{
+    ms::MemoryAccounting accounting{0, std::make_shared<NiceMock<MockSceneReport>>()};
+    int stream;
+
+    auto const account = accounting.open_account("client", 42);
+    accounting.attribute(&stream, account);
+    accounting.forget(&stream);
+
+    EXPECT_THAT(accounting.charge_texture(&stream, 256), IsNull());
+    EXPECT_THAT(account->usage().total, Eq(0u));
+}
+
+TEST(MemoryAccounting, lists_accounts_still_in_use)
+{
+    ms::MemoryAccounting accounting{0, std::make_shared<NiceMock<MockSceneReport>>()};
+
+    auto const kept = accounting.open_account("kept", 1);
+    accounting.open_account("closed", 2);
+
+    auto const accounts = accounting.accounts();
+
+    ASSERT_THAT(accounts.size(), Eq(1u));
+    EXPECT_THAT(accounts.front()->session_name(), Eq("kept"));
+}
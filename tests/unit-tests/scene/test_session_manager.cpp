@@ -25,6 +25,7 @@
 #include "mir/graphics/display_configuration_observer.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/scene/null_surface_observer.h"
+#include "mir/scene/memory_accounting.h"
 
 #include "src/server/scene/basic_surface.h"
 #include "src/include/server/mir/scene/session_event_sink.h"
@@ -96,7 +97,8 @@ struct SessionManagerSetup : public testing::Test
         mt::fake_shared(display),
         std::make_shared<mtd::NullANRDetector>(),
         mt::fake_shared(allocator),
-        mt::fake_shared(display_config_registrar)};
+        mt::fake_shared(display_config_registrar),
+        std::make_shared<ms::MemoryAccounting>(0, mir::report::null_scene_report())};
 };
 
 }
@@ -124,7 +126,8 @@ struct SessionManagerSessionListenerSetup : public testing::Test
         mt::fake_shared(display),
         std::make_shared<mtd::NullANRDetector>(),
         mt::fake_shared(allocator),
-        mt::fake_shared(display_config_registrar)};
+        mt::fake_shared(display_config_registrar),
+        std::make_shared<ms::MemoryAccounting>(0, mir::report::null_scene_report())};
 };
 }
 
@@ -206,7 +209,8 @@ struct SessionManagerSessionEventsSetup : public testing::Test
         mt::fake_shared(display),
         std::make_shared<mtd::NullANRDetector>(),
         mt::fake_shared(allocator),
-        mt::fake_shared(display_config_registrar)};
+        mt::fake_shared(display_config_registrar),
+        std::make_shared<ms::MemoryAccounting>(0, mir::report::null_scene_report())};
 };
 }
 
@@ -48,27 +48,62 @@ class MockPixelBuffer : public ms::PixelBuffer
 public:
     ~MockPixelBuffer() noexcept {}
 
-    MOCK_METHOD1(fill_from, void(mg::Buffer& buffer));
-    MOCK_METHOD0(as_argb_8888, void const*());
-    MOCK_CONST_METHOD0(size, geom::Size());
-    MOCK_CONST_METHOD0(stride, geom::Stride());
+    MOCK_METHOD3(fill_from, void(mg::Buffer& buffer, geom::Size const& max_size, ms::SnapshotCallback const&));
+    MOCK_METHOD1(collect, bool(bool wait));
 };
 
+ACTION_P(ReadPixels, snapshot)
+{
+    arg2(snapshot);
+}
+
 struct NamedThreadBufferStream : mtd::StubBufferStream
 {
-    void with_most_recent_buffer_do(std::function<void(mg::Buffer & )> const& fn) override
+    void with_most_recent_submission_do(std::function<void(mg::Buffer&, uint64_t)> const& fn) override
     {
 #ifndef MIR_DONT_USE_PTHREAD_GETNAME_NP
         thread_name = mt::current_thread_name();
 #endif
-        StubBufferStream::with_most_recent_buffer_do(fn);
+        StubBufferStream::with_most_recent_submission_do(fn);
     }
     std::string thread_name;
 };
 
 struct ThreadedSnapshotStrategyTest : testing::Test
 {
+    /// Takes a snapshot (or thumbnail, given \a max_size) and returns its pixels
+    auto take_snapshot(ms::ThreadedSnapshotStrategy& strategy, geom::Size const& max_size = {})
+        -> std::vector<uint32_t>
+    {
+        mt::Signal snapshot_taken;
+        std::vector<uint32_t> pixels;
+
+        auto const copy_pixels = [&](ms::Snapshot const& s)
+            {
+                snapshot = s;
+                if (s.pixels)
+                {
+                    auto const from = static_cast<uint32_t const*>(s.pixels);
+                    pixels.assign(from, from + s.stride.as_int() / 4 * s.size.height.as_int());
+                }
+                snapshot_taken.raise();
+            };
+
+        if (max_size == geom::Size{})
+            strategy.take_snapshot_of(mt::fake_shared(buffer_access), copy_pixels);
+        else
+            strategy.take_thumbnail_of(mt::fake_shared(buffer_access), max_size, copy_pixels);
+
+        EXPECT_TRUE(snapshot_taken.wait_for(std::chrono::seconds{5}));
+        return pixels;
+    }
+
     NamedThreadBufferStream buffer_access;
+    testing::NiceMock<MockPixelBuffer> pixel_buffer;
+    ms::Snapshot snapshot;
+
+    std::vector<uint32_t> const pixels{0xff000001, 0xff000002, 0xff000003, 0xff000004};
+    ms::Snapshot const pixels_read{geom::Size{2, 2}, geom::Stride{8}, pixels.data()};
 };
 
 }
@@ -77,39 +112,140 @@ TEST_F(ThreadedSnapshotStrategyTest, takes_snapshot)
 {
     using namespace testing;
 
-    void const* pixels{reinterpret_cast<void*>(0xabcd)};
-    geom::Size size{10, 11};
-    geom::Stride stride{123};
+    EXPECT_CALL(pixel_buffer, fill_from(Ref(*buffer_access.stub_compositor_buffer), Eq(geom::Size{}), _))
+        .WillOnce(ReadPixels(pixels_read));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    EXPECT_THAT(take_snapshot(strategy), Eq(pixels));
+    EXPECT_EQ(pixels_read.size, snapshot.size);
+    EXPECT_EQ(pixels_read.stride, snapshot.stride);
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, takes_thumbnail_scaled_to_fit)
+{
+    using namespace testing;
 
-    MockPixelBuffer pixel_buffer;
+    geom::Size const max_size{64, 64};
 
-    EXPECT_CALL(pixel_buffer, fill_from(Ref(*buffer_access.stub_compositor_buffer)));
-    EXPECT_CALL(pixel_buffer, as_argb_8888())
-        .WillOnce(Return(pixels));
-    EXPECT_CALL(pixel_buffer, size())
-        .WillOnce(Return(size));
-    EXPECT_CALL(pixel_buffer, stride())
-        .WillOnce(Return(stride));
+    EXPECT_CALL(pixel_buffer, fill_from(Ref(*buffer_access.stub_compositor_buffer), Eq(max_size), _))
+        .WillOnce(ReadPixels(pixels_read));
 
     ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
 
-    mt::Signal snapshot_taken;
+    EXPECT_THAT(take_snapshot(strategy, max_size), Eq(pixels));
+}
 
-    ms::Snapshot snapshot;
+TEST_F(ThreadedSnapshotStrategyTest, serves_snapshot_of_unchanged_buffer_from_cache)
+{
+    using namespace testing;
 
-    strategy.take_snapshot_of(
-        mt::fake_shared(buffer_access),
-        [&](ms::Snapshot const& s)
-        {
-            snapshot = s;
-            snapshot_taken.raise();
-        });
+    EXPECT_CALL(pixel_buffer, fill_from(_, _, _))
+        .WillOnce(ReadPixels(pixels_read));
 
-    snapshot_taken.wait_for(std::chrono::seconds{5});
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    take_snapshot(strategy);
+
+    EXPECT_THAT(take_snapshot(strategy), Eq(pixels));
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, reads_new_buffer)
+{
+    using namespace testing;
+
+    std::vector<uint32_t> const new_pixels{1, 2, 3, 4};
+
+    EXPECT_CALL(pixel_buffer, fill_from(_, _, _))
+        .WillOnce(ReadPixels(pixels_read))
+        .WillOnce(ReadPixels(ms::Snapshot{geom::Size{2, 2}, geom::Stride{8}, new_pixels.data()}));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    take_snapshot(strategy);
+    buffer_access.stub_compositor_buffer = std::make_shared<mtd::StubBuffer>(
+        std::make_shared<mir_test_framework::NativeBuffer>(mg::BufferProperties{}));
+    ++buffer_access.submission;
+
+    EXPECT_THAT(take_snapshot(strategy), Eq(new_pixels));
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, reads_buffer_submitted_again)
+{
+    using namespace testing;
+
+    std::vector<uint32_t> const new_pixels{1, 2, 3, 4};
+
+    EXPECT_CALL(pixel_buffer, fill_from(Ref(*buffer_access.stub_compositor_buffer), _, _))
+        .WillOnce(ReadPixels(pixels_read))
+        .WillOnce(ReadPixels(ms::Snapshot{geom::Size{2, 2}, geom::Stride{8}, new_pixels.data()}));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    take_snapshot(strategy);
+    // As mirclient streams do, the client has drawn in the same buffer again
+    ++buffer_access.submission;
+
+    EXPECT_THAT(take_snapshot(strategy), Eq(new_pixels));
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, does_not_cache_snapshot_of_unknown_submission)
+{
+    using namespace testing;
+
+    EXPECT_CALL(pixel_buffer, fill_from(_, _, _))
+        .Times(2)
+        .WillRepeatedly(ReadPixels(pixels_read));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+    buffer_access.submission = 0;
+
+    take_snapshot(strategy);
+
+    EXPECT_THAT(take_snapshot(strategy), Eq(pixels));
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, thumbnails_are_cached_separately)
+{
+    using namespace testing;
+
+    EXPECT_CALL(pixel_buffer, fill_from(_, Eq(geom::Size{}), _))
+        .WillOnce(ReadPixels(pixels_read));
+    EXPECT_CALL(pixel_buffer, fill_from(_, Eq(geom::Size{1, 1}), _))
+        .WillOnce(ReadPixels(ms::Snapshot{geom::Size{1, 1}, geom::Stride{4}, pixels.data()}));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    take_snapshot(strategy);
+
+    EXPECT_THAT(take_snapshot(strategy, {1, 1}), ElementsAre(pixels[0]));
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, collects_snapshots_read_asynchronously)
+{
+    using namespace testing;
+
+    ms::SnapshotCallback pending;
+    int collections{0};
+
+    EXPECT_CALL(pixel_buffer, fill_from(_, _, _))
+        .WillOnce(SaveArg<2>(&pending));
+    ON_CALL(pixel_buffer, collect(_))
+        .WillByDefault(Invoke([&](bool)
+            {
+                if (++collections < 3)
+                    return true;
+
+                if (pending)
+                    pending(pixels_read);
+                pending = nullptr;
+                return false;
+            }));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
 
-    EXPECT_EQ(size,   snapshot.size);
-    EXPECT_EQ(stride, snapshot.stride);
-    EXPECT_EQ(pixels, snapshot.pixels);
+    EXPECT_THAT(take_snapshot(strategy), Eq(pixels));
+    EXPECT_THAT(collections, Ge(3));
 }
 
 #ifndef MIR_DONT_USE_PTHREAD_GETNAME_NP
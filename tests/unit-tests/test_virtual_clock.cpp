@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/virtual_clock.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+namespace mt = mir::time;
+
+TEST(VirtualClock, only_moves_when_advanced)
+{
+    mt::VirtualClock clock;
+    auto const start = clock.now();
+
+    std::this_thread::sleep_for(1ms);
+    EXPECT_EQ(start, clock.now());
+
+    clock.advance_by(10ms);
+    EXPECT_EQ(start + 10ms, clock.now());
+
+    clock.advance_to(start + 1s);
+    EXPECT_EQ(start + 1s, clock.now());
+}
+
+TEST(VirtualClock, never_moves_backward)
+{
+    mt::VirtualClock clock;
+    auto const start = clock.now();
+
+    clock.advance_by(-1s);
+    EXPECT_EQ(start, clock.now());
+
+    clock.advance_to(start - 1s);
+    EXPECT_EQ(start, clock.now());
+}
+
+TEST(VirtualClock, no_wait_once_time_is_reached)
+{
+    mt::VirtualClock clock;
+    auto const due = clock.now() + 5s;
+
+    EXPECT_GT(clock.min_wait_until(due), mt::Duration::zero());
+
+    clock.advance_to(due);
+    EXPECT_EQ(mt::Duration::zero(), clock.min_wait_until(due));
+}
+
+TEST(VirtualClock, notifies_time_changes_until_callback_declines)
+{
+    mt::VirtualClock clock;
+    std::vector<mt::Timestamp> seen;
+
+    clock.register_time_change_callback(
+        [&](mt::Timestamp t)
+        {
+            seen.push_back(t);
+            return seen.size() < 2;
+        });
+
+    clock.advance_by(1s);
+    clock.advance_by(1s);
+    clock.advance_by(1s);
+
+    ASSERT_EQ(2u, seen.size());
+    EXPECT_EQ(clock.now() - 1s, seen.back());
+}
+
+TEST(VirtualClock, wait_until_returns_when_time_is_reached)
+{
+    mt::VirtualClock clock;
+    auto const due = clock.now() + 1h;
+
+    std::thread stepper{[&] { clock.advance_to(due); }};
+    EXPECT_TRUE(clock.wait_until(due, 60s));
+    stepper.join();
+}
+
+TEST(VirtualClock, wait_until_times_out_in_real_time)
+{
+    mt::VirtualClock clock;
+
+    EXPECT_FALSE(clock.wait_until(clock.now() + 1s, 1ms));
+}
@@ -229,3 +229,80 @@ TEST_F(BasicThreadPool, can_shrink)
     EXPECT_TRUE(task2.was_called());
     EXPECT_THAT(task2.thread_name(), Ne(expected_name));
 }
+
+TEST_F(BasicThreadPool, gives_no_tasks_to_a_thread_busy_with_one)
+{
+    using namespace testing;
+    mth::BasicThreadPool p{1};
+
+    TestTask task1;
+    task1.block_on_execution();
+    auto future1 = p.run(std::ref(task1));
+
+    // Were it queued behind the first task, this would wait for that to be unblocked
+    TestTask task2;
+    auto future2 = p.run(std::ref(task2));
+    EXPECT_THAT(future2.wait_for(std::chrono::seconds{5}), Eq(std::future_status::ready));
+
+    task1.unblock();
+    future1.wait();
+}
+
+#ifndef MIR_DONT_USE_PTHREAD_GETNAME_NP
+TEST_F(BasicThreadPool, threads_are_idle_once_their_task_has_completed)
+#else
+TEST_F(BasicThreadPool, DISABLED_threads_are_idle_once_their_task_has_completed)
+#endif
+{
+    using namespace testing;
+    mth::BasicThreadPool p{0};
+
+    // Were a thread to complete its task's future before it is idle, shrink() could keep it
+    for (auto i = 0; i != 100; ++i)
+    {
+        TestTask task1{expected_name};
+        p.run(std::ref(task1)).wait();
+        p.shrink();
+
+        TestTask task2;
+        p.run(std::ref(task2)).wait();
+        p.shrink();
+
+        ASSERT_THAT(task2.thread_name(), Ne(expected_name));
+    }
+}
+
+TEST_F(BasicThreadPool, destroys_tasks_without_holding_its_lock)
+{
+    struct UsesPool
+    {
+        UsesPool(mth::BasicThreadPool& pool, mt::Signal& destroyed)
+            : pool(pool),
+              destroyed(destroyed)
+        {
+        }
+
+        ~UsesPool()
+        {
+            pool.shrink();
+            destroyed.raise();
+        }
+
+        mth::BasicThreadPool& pool;
+        mt::Signal& destroyed;
+    };
+
+    mth::BasicThreadPool p{0};
+    mt::Signal released;
+    mt::Signal destroyed;
+
+    {
+        auto const uses_pool = std::make_shared<UsesPool>(p, destroyed);
+        p.run([uses_pool, &released] { released.wait(); });
+    }
+
+    // Now only the pool's copy of the task holds uses_pool
+    released.raise();
+
+    EXPECT_TRUE(destroyed.wait_for(std::chrono::seconds{5}));
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/shm_pool_tracker.h"
+
+#include "mir/anonymous_shm_file.h"
+#include "mir/fd.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <wayland-server-core.h>
+#include <wayland-server-protocol.h>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace mf = mir::frontend;
+
+using namespace testing;
+
+namespace
+{
+/// Speaks just enough of the Wayland wire protocol to make wl_shm buffers
+class WireClient
+{
+public:
+    explicit WireClient(mir::Fd socket)
+        : socket{std::move(socket)}
+    {
+    }
+
+    void send(uint32_t object, uint16_t opcode, std::vector<uint32_t> const& args, int fd = -1)
+    {
+        std::vector<uint32_t> message{object, static_cast<uint32_t>((8 + 4 * args.size()) << 16 | opcode)};
+        message.insert(message.end(), args.begin(), args.end());
+
+        iovec iov{message.data(), message.size() * sizeof(uint32_t)};
+        msghdr header{};
+        header.msg_iov = &iov;
+        header.msg_iovlen = 1;
+
+        char control[CMSG_SPACE(sizeof(int))]{};
+        if (fd >= 0)
+        {
+            header.msg_control = control;
+            header.msg_controllen = sizeof control;
+            auto const cmsg = CMSG_FIRSTHDR(&header);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        }
+
+        ASSERT_THAT(sendmsg(socket, &header, 0), Eq(static_cast<ssize_t>(iov.iov_len)));
+    }
+
+    /// The name of the global advertised with \a interface by the registry \a registry
+    auto global_named(uint32_t registry, char const* interface) -> uint32_t
+    {
+        std::vector<uint32_t> events(1024);
+        auto const bytes = recv(socket, events.data(), events.size() * sizeof(uint32_t), MSG_DONTWAIT);
+
+        for (auto event = events.data(); bytes > 0 && event < events.data() + bytes / sizeof(uint32_t);
+             event += (event[1] >> 16) / sizeof(uint32_t))
+        {
+            // wl_registry.global(name, interface, version)
+            if (event[0] == registry && (event[1] & 0xffff) == 0 &&
+                std::strcmp(reinterpret_cast<char const*>(event + 4), interface) == 0)
+            {
+                return event[2];
+            }
+        }
+
+        ADD_FAILURE() << "No " << interface << " global advertised";
+        return 0;
+    }
+
+    /// \a string as a wire protocol argument: its length, then the padded, nul-terminated characters
+    static auto string(char const* string) -> std::vector<uint32_t>
+    {
+        auto const length = std::strlen(string) + 1;
+        std::vector<uint32_t> arg(1 + (length + 3) / 4);
+        arg[0] = length;
+        std::memcpy(arg.data() + 1, string, length);
+        return arg;
+    }
+
+private:
+    mir::Fd const socket;
+};
+
+struct ShmPoolTrackerTest : Test
+{
+    ShmPoolTrackerTest()
+    {
+        wl_display_init_shm(display);
+        wl_display_add_shm_format(display, WL_SHM_FORMAT_NV12);
+        wl_display_add_shm_format(display, WL_SHM_FORMAT_YUV420);
+
+        int fds[2];
+        socketpair(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0, fds);
+        client = wl_client_create(display, fds[0]);
+        wire = std::make_unique<WireClient>(mir::Fd{fds[1]});
+
+        // wl_display.get_registry(registry)
+        wire->send(display_id, 1, {registry_id});
+        dispatch();
+
+        // wl_registry.bind(name, interface, version, shm)
+        auto bind = std::vector<uint32_t>{wire->global_named(registry_id, "wl_shm")};
+        auto const interface = WireClient::string("wl_shm");
+        bind.insert(bind.end(), interface.begin(), interface.end());
+        bind.insert(bind.end(), {1, shm_id});
+        wire->send(registry_id, 0, bind);
+    }
+
+    ~ShmPoolTrackerTest()
+    {
+        wl_client_destroy(client);
+        tracker.reset();
+        wl_display_destroy(display);
+    }
+
+    void dispatch()
+    {
+        wl_event_loop_dispatch(wl_display_get_event_loop(display), 0);
+        wl_display_flush_clients(display);
+    }
+
+    void create_pool(uint32_t pool, std::size_t size)
+    {
+        mir::AnonymousShmFile file{size};
+        // wl_shm.create_pool(pool, fd, size)
+        wire->send(shm_id, 0, {pool, static_cast<uint32_t>(size)}, file.fd());
+        dispatch();
+    }
+
+    auto create_buffer(uint32_t pool, uint32_t buffer, int width, int height, int stride, uint32_t format)
+        -> wl_resource*
+    {
+        // wl_shm_pool.create_buffer(buffer, offset, width, height, stride, format)
+        wire->send(
+            pool, 0,
+            {buffer, 0, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+             static_cast<uint32_t>(stride), format});
+        dispatch();
+        return wl_client_get_object(client, buffer);
+    }
+
+    uint32_t const display_id{1};
+    uint32_t const registry_id{2};
+    uint32_t const shm_id{3};
+
+    wl_display* const display{wl_display_create()};
+    std::unique_ptr<mf::ShmPoolTracker> tracker{std::make_unique<mf::ShmPoolTracker>(display)};
+    wl_client* client;
+    std::unique_ptr<WireClient> wire;
+
+    int const width{64};
+    int const height{48};
+};
+}
+
+TEST(ShmBufferExtent, covers_the_chroma_planes_following_the_luma_plane)
+{
+    EXPECT_THAT(mf::shm_buffer_extent(WL_SHM_FORMAT_XRGB8888, 64, 48, 256), Eq(256u * 48));
+    EXPECT_THAT(mf::shm_buffer_extent(WL_SHM_FORMAT_NV12, 64, 48, 64), Eq(64u * 48 + 64 * 24));
+    EXPECT_THAT(mf::shm_buffer_extent(WL_SHM_FORMAT_YUV420, 64, 48, 64), Eq(64u * 48 + 2 * 32 * 24));
+}
+
+TEST(ShmBufferExtent, of_odd_sizes_covers_the_rounded_up_chroma)
+{
+    // The last chroma row of 5 pixels is read in full, past the 4 bytes of YUV420's rounded down chroma stride
+    EXPECT_THAT(mf::shm_buffer_extent(WL_SHM_FORMAT_NV12, 9, 3, 9), Eq(9u * 3 + 8 + 10));
+    EXPECT_THAT(mf::shm_buffer_extent(WL_SHM_FORMAT_YUV420, 9, 3, 9), Eq(9u * 3 + 4 * 2 + 4 + 5));
+}
+
+TEST_F(ShmPoolTrackerTest, refuses_an_undersized_nv12_buffer)
+{
+    uint32_t const pool{4}, buffer{5};
+    // Just big enough for the luma plane, which is all libwayland checks
+    create_pool(pool, width * height);
+
+    auto const resource = create_buffer(pool, buffer, width, height, width, WL_SHM_FORMAT_NV12);
+    ASSERT_THAT(resource, NotNull());
+
+    EXPECT_FALSE(mf::shm_planes_fit(resource));
+}
+
+TEST_F(ShmPoolTrackerTest, refuses_an_undersized_yuv420_buffer)
+{
+    uint32_t const pool{4}, buffer{5};
+    create_pool(pool, width * height + width * height / 4);
+
+    auto const resource = create_buffer(pool, buffer, width, height, width, WL_SHM_FORMAT_YUV420);
+    ASSERT_THAT(resource, NotNull());
+
+    EXPECT_FALSE(mf::shm_planes_fit(resource));
+}
+
+TEST_F(ShmPoolTrackerTest, accepts_a_yuv_buffer_whose_planes_fit_its_pool)
+{
+    uint32_t const pool{4}, nv12{5}, yuv420{6};
+    create_pool(pool, width * height * 3 / 2);
+
+    EXPECT_TRUE(mf::shm_planes_fit(create_buffer(pool, nv12, width, height, width, WL_SHM_FORMAT_NV12)));
+    EXPECT_TRUE(mf::shm_planes_fit(create_buffer(pool, yuv420, width, height, width, WL_SHM_FORMAT_YUV420)));
+}
+
+TEST_F(ShmPoolTrackerTest, accepts_a_yuv_buffer_from_a_pool_resized_to_fit)
+{
+    uint32_t const pool{4}, buffer{5};
+    create_pool(pool, width * height);
+    // wl_shm_pool.resize(size)
+    wire->send(pool, 2, {static_cast<uint32_t>(width * height * 3 / 2)});
+    dispatch();
+
+    EXPECT_TRUE(mf::shm_planes_fit(create_buffer(pool, buffer, width, height, width, WL_SHM_FORMAT_NV12)));
+}
+
+TEST_F(ShmPoolTrackerTest, accepts_single_plane_buffers_libwayland_has_checked)
+{
+    uint32_t const pool{4}, buffer{5};
+    create_pool(pool, width * height * 4);
+
+    EXPECT_TRUE(mf::shm_planes_fit(create_buffer(pool, buffer, width, height, width * 4, WL_SHM_FORMAT_XRGB8888)));
+}